@@ -176,6 +176,28 @@ static void test_bptree(size_t n)
   }
 }
 
+/* Same B+tree but with a user compare function:
+   it uses the generic search within a node (for comparison purpose) */
+static inline int ulong_cmp(unsigned long a, unsigned long b) { return a < b ? -1 : a > b; }
+BPTREE_DEF(bptree_ulong_cmp, 21, unsigned long, M_OPEXTEND(M_DEFAULT_OPLIST, CMP(ulong_cmp)))
+
+static void test_bptree_cmp(size_t n)
+{
+  M_LET(tree, BPTREE_OPLIST(bptree_ulong_cmp, M_OPEXTEND(M_DEFAULT_OPLIST, CMP(ulong_cmp)))) {
+      for (size_t i = 0; i < n; i++) {
+        bptree_ulong_cmp_push(tree, rand_get());
+      }
+      rand_init();
+      unsigned int s = 0;
+      for (size_t i = 0; i < n; i++) {
+        unsigned long *p = bptree_ulong_cmp_get(tree, rand_get());
+        if (p)
+          s += *p;
+      }
+      g_result = s;
+  }
+}
+
 /********************************************************************************************/
 
 #ifdef USE_MEMPOOL
@@ -488,6 +510,91 @@ static void test_buffer(size_t n)
 
 /********************************************************************************************/
 
+BUFFER_DEF(buffer_lf_uint, unsigned int, 0, BUFFER_QUEUE|BUFFER_BLOCKING|BUFFER_LOCK_FREE)
+buffer_lf_uint_t g_buff_lf;
+
+BUFFER_DEF(buffer_lf_ull, unsigned long long, 0, BUFFER_QUEUE|BUFFER_BLOCKING|BUFFER_LOCK_FREE)
+buffer_lf_ull_t g_final_lf;
+
+static void final_lf(void *arg)
+{
+  size_t *p_n = arg;
+  size_t    n = *p_n;
+  unsigned long long j, s = 0;
+  for(int i = 0; i < n;i++) {
+    buffer_lf_ull_pop(&j, g_final_lf);
+    s += j;
+  }
+  g_result = s;
+}
+
+static void conso_lf(void *arg)
+{
+  unsigned int j;
+  size_t *p_n = arg;
+  size_t n = *p_n;
+  unsigned long long s = 0;
+  for(int i = 0; i < n;i++) {
+    buffer_lf_uint_pop(&j, g_buff_lf);
+    s += j;
+  }
+  buffer_lf_ull_push(g_final_lf, s);
+}
+
+static void prod_lf(void *arg)
+{
+  size_t *p_n = arg;
+  size_t n = *p_n;
+  size_t r = n;
+  for(unsigned int i = 0; i < n;i++) {
+    buffer_lf_uint_push(g_buff_lf, r );
+    r = r * 31421U + 6927U;
+  }
+}
+
+static void test_buffer_lf(size_t n)
+{
+  const int cpu_count   = n > SIZE_LIMIT ? 2 : get_cpu_count();
+  const int prod_count  = cpu_count/2;
+  const int conso_count = cpu_count - prod_count;
+  if (cpu_count < 2) {
+    fprintf(stderr, "WARNING: Can not measure Buffer performance.\n");
+    return;
+  }
+  n = n > SIZE_LIMIT ? n - SIZE_LIMIT : n;
+  // Init
+  buffer_lf_uint_init(g_buff_lf, 64*cpu_count);
+  buffer_lf_ull_init (g_final_lf, 64*cpu_count);
+
+  // Create thread
+  m_thread_t idx_p[prod_count];
+  m_thread_t idx_c[conso_count];
+  m_thread_t idx_final;
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_create (idx_p[i], prod_lf, &n);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_create (idx_c[i], conso_lf, &n);
+  }
+  size_t n2 = conso_count;
+  m_thread_create(idx_final, final_lf, &n2);
+
+  // Wait for jobs to be done.
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_join(idx_p[i]);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_join(idx_c[i]);
+  }
+  m_thread_join(idx_final);
+
+  // Clear & quit
+  buffer_lf_ull_clear(g_final_lf);
+  buffer_lf_uint_clear(g_buff_lf);
+}
+
+/********************************************************************************************/
+
 QUEUE_MPMC_DEF(queue_uint, unsigned int, BUFFER_QUEUE)
 queue_uint_t g_buff_mpmc;
 
@@ -743,6 +850,87 @@ static void test_queue_single_bulk(size_t n)
 
 /********************************************************************************************/
 
+static void conso_mpmc_bulk(void *arg)
+{
+  size_t *p_n = arg;
+  size_t n = *p_n;
+  unsigned long long s = 0;
+  unsigned tab[BULK_SIZE];
+  for(int i = 0; i < n;i+= BULK_SIZE) {
+    unsigned k = queue_uint_pop_bulk(BULK_SIZE, tab, g_buff_mpmc);
+    while (k != BULK_SIZE) {
+      m_thread_yield();
+      k += queue_uint_pop_bulk(BULK_SIZE-k, tab+k, g_buff_mpmc);
+    }
+    for(k = 0; k < BULK_SIZE;k++)
+      s += tab[k];
+  }
+  while (!queue_ull_push(g_final_mpmc, s));
+}
+
+static void prod_mpmc_bulk(void *arg)
+{
+  size_t *p_n = arg;
+  size_t n = *p_n;
+  if ((n % BULK_SIZE) != 0) abort();
+  size_t r = n;
+  unsigned tab[BULK_SIZE];
+  for(unsigned int i = 0; i < n;i+= BULK_SIZE) {
+    for(unsigned k = 0; k < BULK_SIZE; k++) {
+      tab[k] = r;
+      r = r * 31421U + 6927U;
+    }
+    unsigned k = queue_uint_push_bulk(g_buff_mpmc, BULK_SIZE, tab);
+    while (k != BULK_SIZE) {
+      m_thread_yield();
+      k += queue_uint_push_bulk(g_buff_mpmc, BULK_SIZE-k, tab+k);
+    }
+  }
+}
+
+static void test_queue_bulk(size_t n)
+{
+  const int cpu_count   = n > SIZE_LIMIT ? 2 : get_cpu_count();
+  const int prod_count  = cpu_count/2;
+  const int conso_count = cpu_count - prod_count;
+  if (cpu_count < 2) {
+    fprintf(stderr, "WARNING: Can not measure Queue performance.\n");
+    return;
+  }
+  n = n > SIZE_LIMIT ? n - SIZE_LIMIT : n;
+  // Init
+  queue_uint_init(g_buff_mpmc, 64*cpu_count);
+  queue_ull_init (g_final_mpmc, 64*cpu_count);
+
+  // Create thread
+  m_thread_t idx_p[prod_count];
+  m_thread_t idx_c[conso_count];
+  m_thread_t idx_final;
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_create (idx_p[i], prod_mpmc_bulk, &n);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_create (idx_c[i], conso_mpmc_bulk, &n);
+  }
+  size_t n2 = conso_count;
+  m_thread_create(idx_final, final_mpmc, &n2);
+
+  // Wait for jobs to be done.
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_join(idx_p[i]);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_join(idx_c[i]);
+  }
+  m_thread_join(idx_final);
+
+  // Clear & quit
+  queue_ull_clear(g_final_mpmc);
+  queue_uint_clear(g_buff_mpmc);
+}
+
+/********************************************************************************************/
+
 CONCURRENT_DEF(cdeque_uint, deque_uint_t, M_OPEXTEND(DEQUE_OPLIST(deque_uint, M_DEFAULT_OPLIST), PUSH(deque_uint_push_front)))
 
 DEQUE_DEF(deque_ull, unsigned long long)
@@ -1054,6 +1242,7 @@ const config_func_t table[] = {
   { 21,   "Deque", 100000000, 0, test_deque, 0},
   { 30,  "Rbtree", 1000000, 0, test_rbtree, 0},
   { 31,  "B+tree", 1000000, 0, test_bptree, 0},
+  { 32,  "B+tree(generic cmp)", 1000000, 0, test_bptree_cmp, 0},
   { 40,    "dict", 1000000, 0, test_dict, 0},
   { 41, "dictBig", 1000000, 0, test_dict_big, 0},
   { 42,"dict(OA)", 1000000, 0, test_dict_oa, 0},
@@ -1069,6 +1258,9 @@ const config_func_t table[] = {
   { 64,"Queue SPSC (P=2)",  1000000, 0, test_queue_single, 0},
   { 65,"Queue Concurrent",  1000000, 0, test_queue_concurrent, 0},
   { 66,"Queue SPSC(Bulk)",  1000000, 0, test_queue_single_bulk, 0},
+  { 67,"Queue MPMC(Bulk)",  1000000, 0, test_queue_bulk, 0},
+  { 68,"Queue MPMC(Bulk,P=2)",  SIZE_LIMIT+1000000, 0, test_queue_bulk, 0},
+  { 69,"Buffer(LockFree,P=2)",  SIZE_LIMIT+1000000, 0, test_buffer_lf, 0},
   { 70,"M_HASH",  100000000, test_hash_prepare, test_hash, test_hash_final},
   { 71,"Core Hash", 100000000, test_hash_prepare, test_core_hash, test_hash_final},
   {100,    "serial-bin STR", 10000000, bench_vector_string_init, bench_vector_string_bin_run, bench_vector_string_clear},
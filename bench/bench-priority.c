@@ -0,0 +1,117 @@
+/*
+ * M*LIB - Latency of high priority work orders under background load
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#define NDEBUG
+#define MULTI_THREAD_MEASURE
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "m-worker.h"
+
+#include "common.h"
+
+/* Measure the latency of requests (the time between the spawn of a work
+   order and the start of its execution) under background load:
+   before each request, a burst of background work orders is spawned.
+   * With the same class for both (FIFO): the request waits for the burst,
+   * With a HIGH priority request and LOW priority background work orders:
+     the request waits at most for the end of the running work orders,
+   for 1 to MAX_THREAD threads (the calling thread and MAX_THREAD-1 workers).
+   The p50, p99 and max latencies are reported in microseconds,
+   with the maximum depth of the background class. */
+
+#define MAX_THREAD 64
+#define NUM_REQ    2000
+#define BURST      64
+#define PERIOD     200
+#define TASK_WORK  5000
+
+static m_worker_t g_worker;
+static unsigned long long g_start[NUM_REQ];
+static unsigned long long g_latency[NUM_REQ];
+
+static void
+background(void *arg)
+{
+  // Some fake work
+  volatile unsigned long x = (unsigned long) (uintptr_t) arg;
+  for(unsigned i = 0; i < TASK_WORK; i++) {
+    x = x * 3 + 1;
+  }
+}
+
+static void
+request(void *arg)
+{
+  const size_t r = (size_t) (uintptr_t) arg;
+  g_latency[r] = cputime() - g_start[r];
+}
+
+static int
+cmp(const void *a, const void *b)
+{
+  const unsigned long long x = *(const unsigned long long *) a;
+  const unsigned long long y = *(const unsigned long long *) b;
+  return (x > y) - (x < y);
+}
+
+static void
+run(const char *desc, unsigned num_thread, m_worker_priority_e req, m_worker_priority_e bg)
+{
+  m_worker_init(g_worker, (int) num_thread - 1, NUM_REQ * (BURST + 1), NULL, NULL);
+  m_worker_sync_t b;
+  m_worker_start(b, g_worker);
+  size_t max_depth = 0;
+  for(size_t r = 0; r < NUM_REQ; r++) {
+    const unsigned long long t = cputime();
+    for(unsigned i = 0; i < BURST; i++) {
+      m_worker_spawn_priority(b, bg, background, (void *) (uintptr_t) i);
+    }
+    const size_t depth = m_worker_queue_depth(g_worker, bg);
+    max_depth = M_MAX(max_depth, depth);
+    g_start[r] = cputime();
+    m_worker_spawn_priority(b, req, request, (void *) (uintptr_t) r);
+    // Wait for the next request
+    while (cputime() < t + PERIOD) {
+      m_thread_yield();
+    }
+  }
+  m_worker_sync(b);
+  m_worker_clear(g_worker);
+
+  qsort(g_latency, NUM_REQ, sizeof g_latency[0], cmp);
+  printf("%20.20s with %2u threads: p50 %6llu us, p99 %6llu us, max %6llu us (depth %zu)\n",
+         desc, num_thread, g_latency[NUM_REQ / 2], g_latency[NUM_REQ * 99 / 100],
+         g_latency[NUM_REQ - 1], max_depth);
+}
+
+int main(void)
+{
+  for(unsigned n = 2; n <= MAX_THREAD; n *= 2) {
+    run("FIFO", n, M_WORKER_PRIORITY_NORMAL, M_WORKER_PRIORITY_NORMAL);
+    run("HIGH over LOW", n, M_WORKER_PRIORITY_HIGH, M_WORKER_PRIORITY_LOW);
+  }
+  return 0;
+}
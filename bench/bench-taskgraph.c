@@ -0,0 +1,140 @@
+/*
+ * M*LIB - Throughput of the workers for fine-grained work orders
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#define NDEBUG
+#define MULTI_THREAD_MEASURE
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "m-taskgraph.h"
+
+#include "common.h"
+
+/* Measure the execution of a synthetic DAG (a stencil: each task
+   of a layer depends on the 3 nearest tasks of the previous layer)
+   with a wide shape and a deep shape,
+   * using a task graph (a task is run as soon as its predecessors are done),
+   * using a synchronization point per layer (barrier between layers),
+   for 1 to MAX_THREAD threads (the calling thread and MAX_THREAD-1 workers).
+   The same graph is run several times.
+   The cost is reported in nanoseconds per task. */
+
+#define MAX_THREAD 64
+#define NUM_TASK   (64 * 1024)
+#define NUM_RUN    10
+#define TASK_WORK  200
+
+static m_worker_t g_worker;
+static atomic_ulong g_count;
+static unsigned g_width, g_depth;
+
+static void
+task(void *arg)
+{
+  // Some fake work depending on the task
+  volatile unsigned long x = (unsigned long) (uintptr_t) arg;
+  for(unsigned i = 0; i < TASK_WORK; i++) {
+    x = x * 3 + 1;
+  }
+  atomic_fetch_add_explicit(&g_count, 1, memory_order_relaxed);
+}
+
+static void
+build(m_taskgraph_t g)
+{
+  m_taskgraph_reset(g);
+  for(unsigned l = 0; l < g_depth; l++) {
+    for(unsigned i = 0; i < g_width; i++) {
+      const size_t k = m_taskgraph_add(g, task, (void *) (uintptr_t) (l * g_width + i));
+      if (l == 0) continue;
+      const size_t prev = k - g_width;
+      m_taskgraph_add_edge(g, prev, k);
+      if (i > 0) m_taskgraph_add_edge(g, prev - 1, k);
+      if (i + 1 < g_width) m_taskgraph_add_edge(g, prev + 1, k);
+    }
+  }
+}
+
+static void
+run_graph(m_taskgraph_t g)
+{
+  for(unsigned r = 0; r < NUM_RUN; r++) {
+    m_taskgraph_run(g, g_worker);
+  }
+}
+
+static void
+run_barrier(m_taskgraph_t g)
+{
+  (void) g;
+  for(unsigned r = 0; r < NUM_RUN; r++) {
+    for(unsigned l = 0; l < g_depth; l++) {
+      m_worker_sync_t b;
+      m_worker_start(b, g_worker);
+      for(unsigned i = 0; i < g_width; i++) {
+        m_worker_spawn(b, task, (void *) (uintptr_t) (l * g_width + i));
+      }
+      m_worker_sync(b);
+    }
+  }
+}
+
+static void
+run(const char *desc, unsigned num_thread, unsigned width, void (*func)(m_taskgraph_t))
+{
+  m_taskgraph_t g;
+  m_worker_init(g_worker, (int) num_thread - 1, 0, NULL, NULL);
+  g_width = width;
+  g_depth = NUM_TASK / width;
+  m_taskgraph_init(g);
+  build(g);
+  atomic_init(&g_count, 0UL);
+
+  unsigned long long start = cputime();
+  func(g);
+  unsigned long long end = cputime();
+
+  const unsigned long num_task = (unsigned long) NUM_RUN * g_width * g_depth;
+  if (atomic_load(&g_count) != num_task) {
+    fprintf(stderr, "ERROR: %lu tasks executed (expected %lu)\n",
+            atomic_load(&g_count), num_task);
+    abort();
+  }
+  m_taskgraph_clear(g);
+  m_worker_clear(g_worker);
+  printf("%20.20s with %2u threads: %8.1f ns/task\n", desc, num_thread,
+         1000.0 * (double) (end - start) / (double) num_task);
+}
+
+int main(void)
+{
+  for(unsigned n = 1; n <= MAX_THREAD; n *= 2) {
+    run("Wide DAG graph", n, 1024, run_graph);
+    run("Wide DAG barrier", n, 1024, run_barrier);
+    run("Deep DAG graph", n, 8, run_graph);
+    run("Deep DAG barrier", n, 8, run_barrier);
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * M*LIB - Stress of the variable length mempool by several threads
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#define NDEBUG
+#define MULTI_THREAD_MEASURE
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "m-c-mempool.h"
+#include "m-mutex.h"
+
+#include "common.h"
+
+/* Each thread allocates objects of variable length, gives them to
+   the next thread and frees the ones given by the previous thread
+   (cross-thread free). The cost of an operation (an allocation or a free)
+   is reported in nanoseconds per thread for 1 to MAX_THREAD threads. */
+
+#define MAX_THREAD 64
+#define BATCH      256
+#define TOTAL_OPS  (4UL * 1000 * 1000)
+
+M_ATTR_EXTENSION static _Atomic(void *) g_slot[MAX_THREAD][BATCH];
+static unsigned g_num_thread;
+static bool     g_use_vlapool;
+static m_gc_t      g_gc;
+static m_vlapool_t g_vla;
+
+static inline size_t
+obj_size(size_t i)
+{
+  return 8 + (i * 2654435761U) % 512;
+}
+
+static void
+stress(void *arg)
+{
+  const unsigned t = (unsigned) (uintptr_t) arg;
+  const unsigned next = (t + 1) % g_num_thread;
+  const size_t rounds = TOTAL_OPS / g_num_thread / BATCH;
+  m_gc_tid_t id = 0;
+
+  if (g_use_vlapool) {
+    id = m_gc_attach_thread(g_gc);
+  }
+  for(size_t k = 0; k < rounds; k++) {
+    if (g_use_vlapool) {
+      m_gc_awake(g_gc, id);
+    }
+    for(size_t i = 0; i < BATCH; i++) {
+      const size_t size = obj_size(i + k);
+      void *o = g_use_vlapool ? m_vlapool_new(g_vla, id, size) : malloc(size);
+      *(long *) o = 1;
+      // Get the object given by the previous thread & give ours to the next one
+      // (if the next thread has not taken the previous one, we free it)
+      void *f[2];
+      f[0] = atomic_exchange(&g_slot[t][i], (void *) 0);
+      f[1] = atomic_exchange(&g_slot[next][i], o);
+      for(int j = 0; j < 2; j++) {
+        if (f[j] == NULL) continue;
+        if (g_use_vlapool) {
+          m_vlapool_del(g_vla, f[j], id);
+        } else {
+          free(f[j]);
+        }
+      }
+    }
+    if (g_use_vlapool) {
+      // Let the GC reclaim the objects
+      m_gc_sleep(g_gc, id);
+    }
+  }
+  if (g_use_vlapool) {
+    m_gc_detach_thread(g_gc, id);
+  }
+}
+
+static void
+run(const char *desc, unsigned num_thread, bool use_vlapool)
+{
+  m_thread_t idx[MAX_THREAD];
+  g_num_thread  = num_thread;
+  g_use_vlapool = use_vlapool;
+  for(unsigned t = 0; t < MAX_THREAD; t++) {
+    for(size_t i = 0; i < BATCH; i++) {
+      atomic_init(&g_slot[t][i], (void *) 0);
+    }
+  }
+  if (use_vlapool) {
+    m_gc_init(g_gc, MAX_THREAD + 1);
+    m_vlapool_init(g_vla, g_gc);
+  }
+
+  unsigned long long start = cputime();
+  for(unsigned t = 0; t < num_thread; t++) {
+    m_thread_create(idx[t], stress, (void *) (uintptr_t) t);
+  }
+  for(unsigned t = 0; t < num_thread; t++) {
+    m_thread_join(idx[t]);
+  }
+  unsigned long long end = cputime();
+
+  // Free the remaining objects
+  m_gc_tid_t id = 0;
+  if (use_vlapool) {
+    id = m_gc_attach_thread(g_gc);
+    m_gc_awake(g_gc, id);
+  }
+  for(unsigned t = 0; t < num_thread; t++) {
+    for(size_t i = 0; i < BATCH; i++) {
+      void *o = atomic_load(&g_slot[t][i]);
+      if (o == NULL) continue;
+      if (use_vlapool) {
+        m_vlapool_del(g_vla, o, id);
+      } else {
+        free(o);
+      }
+    }
+  }
+  if (use_vlapool) {
+    m_gc_sleep(g_gc, id);
+    m_gc_detach_thread(g_gc, id);
+    m_vlapool_clear(g_vla);
+    m_gc_clear(g_gc);
+  }
+
+  const size_t ops = 2 * num_thread * (TOTAL_OPS / num_thread / BATCH) * BATCH;
+  printf("%20.20s with %2u threads: %8.1f ns/op\n", desc, num_thread,
+         1000.0 * (double) (end - start) * num_thread / (double) ops);
+}
+
+int main(void)
+{
+  for(unsigned n = 1; n <= MAX_THREAD; n *= 2) {
+    run("malloc & free", n, false);
+    run("M*LIB vlapool", n, true);
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * M*LIB - Throughput of the workers for fine-grained work orders
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#define NDEBUG
+#define MULTI_THREAD_MEASURE
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "m-worker.h"
+
+#include "common.h"
+
+/* Measure the throughput of the workers with fine-grained work orders
+   for 1 to MAX_THREAD threads (the calling thread and MAX_THREAD-1 workers):
+   * a recursive spawn tree (each work order spawns two sub work orders),
+   * flat spawns (a work order spawns many empty work orders before
+     waiting for them).
+   The cost is reported in nanoseconds per work order. */
+
+#define MAX_THREAD 64
+#define TREE_DEPTH 20
+#define FLAT_BATCH 128
+#define FLAT_ROUND (20000)
+
+static m_worker_t g_worker;
+static atomic_ulong g_count;
+
+static void
+tree(void *arg)
+{
+  const unsigned depth = (unsigned) (uintptr_t) arg;
+  if (depth == 0) {
+    atomic_fetch_add_explicit(&g_count, 1, memory_order_relaxed);
+    return;
+  }
+  m_worker_sync_t b;
+  m_worker_start(b, g_worker);
+  m_worker_spawn(b, tree, (void *) (uintptr_t) (depth - 1));
+  m_worker_spawn(b, tree, (void *) (uintptr_t) (depth - 1));
+  m_worker_sync(b);
+}
+
+static void
+empty(void *arg)
+{
+  atomic_fetch_add_explicit((atomic_ulong *) arg, 1, memory_order_relaxed);
+}
+
+static void
+flat(void *arg)
+{
+  const unsigned round = (unsigned) (uintptr_t) arg;
+  atomic_ulong count;
+  atomic_init(&count, 0UL);
+  for(unsigned r = 0; r < round; r++) {
+    m_worker_sync_t b;
+    m_worker_start(b, g_worker);
+    for(unsigned i = 0; i < FLAT_BATCH; i++) {
+      m_worker_spawn(b, empty, &count);
+    }
+    m_worker_sync(b);
+  }
+  atomic_fetch_add(&g_count, atomic_load(&count));
+}
+
+static void
+run(const char *desc, unsigned num_thread, void (*func)(void *), unsigned arg, unsigned long num_order)
+{
+  m_worker_init(g_worker, (int) num_thread - 1, 0, NULL, NULL);
+  atomic_init(&g_count, 0UL);
+  m_worker_sync_t b;
+  m_worker_start(b, g_worker);
+
+  unsigned long long start = cputime();
+  // Run the first work order on a worker, so that its spawns use its deque
+  m_worker_spawn(b, func, (void *) (uintptr_t) arg);
+  m_worker_sync(b);
+  unsigned long long end = cputime();
+
+  if (atomic_load(&g_count) != num_order) {
+    fprintf(stderr, "ERROR: %lu work orders executed (expected %lu)\n",
+            atomic_load(&g_count), num_order);
+    abort();
+  }
+  m_worker_clear(g_worker);
+  printf("%20.20s with %2u threads: %8.1f ns/order\n", desc, num_thread,
+         1000.0 * (double) (end - start) / (double) num_order);
+}
+
+int main(void)
+{
+  for(unsigned n = 1; n <= MAX_THREAD; n *= 2) {
+    run("Spawn tree", n, tree, TREE_DEPTH, 1UL << TREE_DEPTH);
+    run("Flat spawn", n, flat, FLAT_ROUND, (unsigned long) FLAT_ROUND * FLAT_BATCH);
+  }
+  return 0;
+}
@@ -873,6 +873,189 @@ benchmark_mempool_mix_free()
   mempool_huge_clear (h);
 }
 
+/**************************************************************************/
+/* Adding M*LIB sized mempool */
+/**************************************************************************/
+
+#include <thread>
+#include <vector>
+
+MEMPOOL_SIZED_DEF(mempool_sized)
+
+static mempool_sized_t g_sized;
+
+template<class T>
+void
+benchmark_mempool_sized()
+{
+  mempool_sized_init (g_sized);
+
+  benchmark(std::move(T() + "M*LIB sized mempool"), [=]() {
+      for (size_t i = 0; i < N * sizeof(Small) / sizeof(T); ++i) {
+        T *o = (T *) mempool_sized_alloc(g_sized, sizeof(T));
+        touch_obj(o);
+      }
+    });
+
+  mempool_sized_clear(g_sized);
+}
+
+template<class T>
+void
+benchmark_mempool_sized_free()
+{
+  mempool_sized_init (g_sized);
+
+  benchmark(std::move(T() + "M*LIB sized mempool w/ free"), [=]() {
+      for (size_t i = 0; i < N * sizeof(Small) / sizeof(T); ++i) {
+        T *o = (T *) mempool_sized_alloc(g_sized, sizeof(T));
+        touch_obj(o);
+        mempool_sized_free(g_sized, o, sizeof(T));
+      }
+    });
+
+  mempool_sized_clear(g_sized);
+}
+
+void
+benchmark_mempool_sized_mix_free()
+{
+  mempool_sized_init (g_sized);
+
+  benchmark(std::move(std::string("M*LIB sized mempool w/ free (Mix)")), [=]() {
+      for (size_t i = 0; i < N; ++i) {
+        if (__builtin_expect(!(i & 0xfff), 0)) {
+          Huge *o = (Huge *) mempool_sized_alloc (g_sized, sizeof(Huge));
+          touch_obj(o);
+          if (!(i & 1))
+            mempool_sized_free (g_sized, o, sizeof(Huge));
+        }
+        else if (__builtin_expect(!(i & 3), 0)) {
+          Big *o = (Big *) mempool_sized_alloc(g_sized, sizeof(Big));
+          touch_obj(o);
+          if (!(i & 1))
+            mempool_sized_free (g_sized, o, sizeof(Big));
+        }
+        else {
+          Small *o = (Small *) mempool_sized_alloc (g_sized, sizeof(Small));
+          touch_obj(o);
+          if (!(i & 1))
+            mempool_sized_free (g_sized, o, sizeof(Small));
+        }
+      }
+    });
+
+  // The huge objects are not owned by the mempool: they are leaked.
+  mempool_sized_clear (g_sized);
+}
+
+/* Allocation pattern of a typical server (as used to benchmark jemalloc):
+   allocate a batch of objects of different sizes, then free them
+   in a different order. */
+static const size_t BATCH = 1000;
+
+static inline size_t
+batch_size(size_t i)
+{
+  return 8 + (i * 2654435761U) % 512;
+}
+
+void
+benchmark_malloc_batch()
+{
+  benchmark(std::move(std::string("malloc & free (Batch)")), [=]() {
+      std::vector<void *> tab(BATCH);
+      for (size_t k = 0; k < N / BATCH; ++k) {
+        for (size_t i = 0; i < BATCH; ++i) {
+          tab[i] = malloc(batch_size(i + k));
+          touch_obj(tab[i]);
+        }
+        for (size_t i = 0; i < BATCH; ++i) {
+          free(tab[(i * 7) % BATCH]);
+        }
+      }
+    });
+}
+
+void
+benchmark_mempool_sized_batch()
+{
+  mempool_sized_init (g_sized);
+
+  benchmark(std::move(std::string("M*LIB sized mempool (Batch)")), [=]() {
+      std::vector<void *> tab(BATCH);
+      for (size_t k = 0; k < N / BATCH; ++k) {
+        for (size_t i = 0; i < BATCH; ++i) {
+          tab[i] = mempool_sized_alloc(g_sized, batch_size(i + k));
+          touch_obj(tab[i]);
+        }
+        for (size_t i = 0; i < BATCH; ++i) {
+          const size_t j = (i * 7) % BATCH;
+          mempool_sized_free(g_sized, tab[j], batch_size(j + k));
+        }
+      }
+    });
+
+  mempool_sized_clear(g_sized);
+}
+
+/* Same pattern executed by several threads at the same time */
+static const unsigned NUM_THREADS = 4;
+
+void
+benchmark_malloc_batch_mt()
+{
+  benchmark(std::move(std::string("malloc & free (Batch MT)")), [=]() {
+      std::vector<std::thread> th;
+      for (unsigned t = 0; t < NUM_THREADS; ++t) {
+        th.emplace_back([]() {
+            std::vector<void *> tab(BATCH);
+            for (size_t k = 0; k < N / BATCH / NUM_THREADS; ++k) {
+              for (size_t i = 0; i < BATCH; ++i) {
+                tab[i] = malloc(batch_size(i + k));
+                touch_obj(tab[i]);
+              }
+              for (size_t i = 0; i < BATCH; ++i) {
+                free(tab[(i * 7) % BATCH]);
+              }
+            }
+          });
+      }
+      for (auto &t : th)
+        t.join();
+    });
+}
+
+void
+benchmark_mempool_sized_batch_mt()
+{
+  mempool_sized_init (g_sized);
+
+  benchmark(std::move(std::string("M*LIB sized mempool (Batch MT)")), [=]() {
+      std::vector<std::thread> th;
+      for (unsigned t = 0; t < NUM_THREADS; ++t) {
+        th.emplace_back([]() {
+            std::vector<void *> tab(BATCH);
+            for (size_t k = 0; k < N / BATCH / NUM_THREADS; ++k) {
+              for (size_t i = 0; i < BATCH; ++i) {
+                tab[i] = mempool_sized_alloc(g_sized, batch_size(i + k));
+                touch_obj(tab[i]);
+              }
+              for (size_t i = 0; i < BATCH; ++i) {
+                const size_t j = (i * 7) % BATCH;
+                mempool_sized_free(g_sized, tab[j], batch_size(j + k));
+              }
+            }
+            mempool_sized_flush(g_sized);
+          });
+      }
+      for (auto &t : th)
+        t.join();
+    });
+
+  mempool_sized_clear(g_sized);
+}
+
 /*
  * ------------------------------------------------------------------------
  *	Main part of the benchmark
@@ -929,6 +1112,19 @@ main()
         benchmark_mempool_mix_free();
 	std::cout << std::endl;
 
+	benchmark_mempool_sized<Small>();
+	benchmark_mempool_sized_free<Small>();
+	benchmark_mempool_sized<Big>();
+	benchmark_mempool_sized_free<Big>();
+	benchmark_mempool_sized_mix_free();
+	std::cout << std::endl;
+
+	benchmark_malloc_batch();
+	benchmark_mempool_sized_batch();
+	benchmark_malloc_batch_mt();
+	benchmark_mempool_sized_batch_mt();
+	std::cout << std::endl;
+
 	benchmark_tfw_pool<Small>();
 	benchmark_tfw_pool_free<Small>();
 	benchmark_tfw_pool<Big>();
@@ -192,6 +192,9 @@ int main(int argc, const char *argv[])
   /* Main processing */
   scan_directories(it, str);
   consolidate_directories(directories);
+  /* Renumber the nodes in pre-order so that the walk of print_result
+     becomes a linear scan of the nodes */
+  tree_compact_preorder(directories);
   print_result(directories);
 
   /* Clear everything & quit */
@@ -127,6 +127,7 @@
   M_IF_FUNCOBJ(M_ALG0_FIND_IF_DEF_P5(name, container_t, cont_oplist, type_t, type_oplist, it_t, fo, M_C(name, _test_obj_t), M_C(name, _eq_obj_t), M_C(name, _test_obj_call), M_C(name, _eq_obj_call))) \
                                                                               \
   M_ALG0_MAP_DEF_P5(name, container_t, cont_oplist, type_t, type_oplist, it_t) \
+  M_ALG0_DEF_PARALLEL_P(name, container_t, cont_oplist, type_t, type_oplist, it_t) \
                                                                               \
   M_ALG0_ALL_OF_DEF_P5(name, container_t, cont_oplist, type_t, type_oplist, it_t, _, M_C(name, _test_cb_ct), M_APPLY) \
   M_IF_FUNCOBJ(M_ALG0_ALL_OF_DEF_P5(name, container_t, cont_oplist, type_t, type_oplist, it_t, _fo_, M_C(name, _test_obj_t), M_C(name, _test_obj_call)) ) \
@@ -805,6 +806,88 @@
   }                                                                           \
   , )                                                                         \
 
+/* Define the parallel algorithms (for_each & map_reduce) using
+   a pool of workers. They are only defined for random access
+   containers (like ARRAY) which are indexed by integers. */
+#define M_ALG0_PARALLEL_DEF_P5(name, container_t, cont_oplist, type_t, type_oplist, it_t) \
+  M_IF_METHOD(GET_KEY, cont_oplist)(                                          \
+  M_IF_METHOD(GET_SIZE, cont_oplist)(                                         \
+  M_IF_METHOD(IT_PREVIOUS, cont_oplist)(                                      \
+  M_ALG0_PARALLEL_DEF_P6(name, container_t, cont_oplist, type_t, type_oplist, it_t) \
+  , ), ), )
+
+#define M_ALG0_PARALLEL_DEF_P6(name, container_t, cont_oplist, type_t, type_oplist, it_t) \
+                                                                              \
+  /* Context shared by the workers */                                         \
+  typedef struct M_C3(m_alg0_,name,_parallel_s) {                             \
+    /* An union avoids the cast of a pointer to an array type */              \
+    union { const void *ptr; const container_t *cont; } l;                    \
+    M_C(name, _apply_cb_ct) apply;                                            \
+    M_C(name, _transform_cb_ct) map;                                          \
+    M_C(name, _transform_cb_ct) reduce;                                       \
+  } M_C3(m_alg0_,name,_parallel_ct);                                          \
+                                                                              \
+  static inline void                                                          \
+  M_C3(m_alg0_,name,_parallel_apply)(void *data, size_t begin, size_t end)    \
+  {                                                                           \
+    const M_C3(m_alg0_,name,_parallel_ct) *ctx =                              \
+      M_ASSIGN_CAST(const M_C3(m_alg0_,name,_parallel_ct) *, data);           \
+    for(size_t i = begin; i < end; i++) {                                     \
+      ctx->apply(*M_CALL_GET_KEY(cont_oplist, *ctx->l.cont, i));              \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Apply func for all elements of the container using the workers */        \
+  static inline void                                                          \
+  M_C(name, _parallel_for_each) (container_t l, M_C(name, _apply_cb_ct) func, \
+                                 m_worker_t workers)                          \
+  {                                                                           \
+    M_C3(m_alg0_,name,_parallel_ct) ctx;                                      \
+    ctx.l.ptr = l;                                                            \
+    ctx.apply = func;                                                         \
+    m_worker_parallel_for(workers, 0, M_CALL_GET_SIZE(cont_oplist, l), 0,     \
+                          M_C3(m_alg0_,name,_parallel_apply), &ctx);          \
+  }                                                                           \
+                                                                              \
+  M_IF_METHOD(INIT, type_oplist)(                                             \
+  M_IF_METHOD(SET, type_oplist)(                                              \
+  M_WORK3R_REDUCE_DEF_P3(M_C3(m_alg0_,name,_parallel_reduce), type_t, type_oplist) \
+                                                                              \
+  /* Map & reduce the elements [begin, end) in dest */                        \
+  static inline void                                                          \
+  M_C3(m_alg0_,name,_parallel_map)(type_t *dest, void *data, size_t begin, size_t end) \
+  {                                                                           \
+    const M_C3(m_alg0_,name,_parallel_ct) *ctx =                              \
+      M_ASSIGN_CAST(const M_C3(m_alg0_,name,_parallel_ct) *, data);           \
+    type_t tmp;                                                               \
+    M_CALL_INIT(type_oplist, tmp);                                            \
+    ctx->map(dest, *M_CALL_GET_KEY(cont_oplist, *ctx->l.cont, begin));        \
+    for(size_t i = begin + 1; i < end; i++) {                                 \
+      ctx->map(&tmp, *M_CALL_GET_KEY(cont_oplist, *ctx->l.cont, i));          \
+      ctx->reduce(dest, tmp);                                                 \
+    }                                                                         \
+    M_CALL_CLEAR(type_oplist, tmp);                                           \
+  }                                                                           \
+                                                                              \
+  /* Reduce all transformed elements of the container in dest                 \
+     using the workers (redFunc shall be associative) */                      \
+  static inline void                                                          \
+  M_C(name, _parallel_map_reduce) (type_t *dest, const container_t l,         \
+                                   M_C(name, _transform_cb_ct) redFunc,       \
+                                   M_C(name, _transform_cb_ct) mapFunc,       \
+                                   m_worker_t workers)                        \
+  {                                                                           \
+    M_C3(m_alg0_,name,_parallel_ct) ctx;                                      \
+    ctx.l.ptr = l;                                                            \
+    ctx.map = mapFunc;                                                        \
+    ctx.reduce = redFunc;                                                     \
+    M_C3(m_alg0_,name,_parallel_reduce)(dest, workers, 0,                     \
+                                        M_CALL_GET_SIZE(cont_oplist, l), 0,   \
+                                        M_C3(m_alg0_,name,_parallel_map),     \
+                                        redFunc, &ctx);                       \
+  }                                                                           \
+  , ), )
+
 
 /* Define ALL_OF algorithms */
 #define M_ALG0_ALL_OF_DEF_P5(name, container_t, cont_oplist, type_t, type_oplist, it_t, suffix, func_t, call) \
@@ -1216,4 +1299,14 @@
 #define ALGO_INSERT_AT M_ALGO_INSERT_AT
 #endif
 
+/* The parallel algorithms are not defined by default */
+#define M_ALG0_DEF_PARALLEL_P(...)
+
+#endif
+
+// NOTE: Define the parallel algorithms only if m-worker has been included
+#if !defined(MSTARLIB_ALGO_WORKER_H) && defined(MSTARLIB_WORKER_H)
+#define MSTARLIB_ALGO_WORKER_H
+#undef  M_ALG0_DEF_PARALLEL_P
+#define M_ALG0_DEF_PARALLEL_P M_ALG0_PARALLEL_DEF_P5
 #endif
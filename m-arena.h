@@ -0,0 +1,378 @@
+/*
+ * M*LIB - ARENA module
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_ARENA_H
+#define MSTARLIB_ARENA_H
+
+#include "m-core.h"
+
+M_BEGIN_PROTECTED_CODE
+
+/* Fast, variable size, thread unsafe region allocator (bump pointer).
+   USAGE:
+     m_arena_t arena;
+     m_arena_init(arena);
+     char *p = m_arena_alloc(arena, 100);
+     m_arena_mark_t mark = m_arena_mark(arena);
+     ...
+     m_arena_rewind(arena, mark);   // Release everything allocated after mark
+     m_arena_reset(arena);          // Release everything (keeping the memory)
+     m_arena_clear(arena);          // Give back memory to system
+   The arena can be used by the containers through the ALLOCATOR method:
+     LIST_DEF(list_uint, unsigned int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())))
+     list_uint_t l;
+     list_uint_init_allocator(l, m_arena_allocator(arena));
+   Technically, it is a list of memory chunks. The allocations are
+   performed by incrementing a pointer within the current chunk.
+   When the current chunk is full, the next chunk is used (or a
+   new bigger one is allocated from the system). Individual free
+   is only performed if the freed block is the last allocated one.
+   Chunks are never given back to the system until the arena is cleared
+   so that reset & rewind are O(1).
+*/
+
+/* Size in bytes of the first chunk of an arena.
+   Each new chunk allocated from the system is twice bigger than the previous one. */
+#ifndef M_USE_ARENA_CHUNK_SIZE
+#define M_USE_ARENA_CHUNK_SIZE (16*1024)
+#endif
+
+/* Define the type used to align the allocations of an arena. */
+typedef union m_ar3na_align_u {
+  long double ld;
+  long long   ll;
+  void        *ptr;
+  void        (*func)(void);
+} m_ar3na_align_ct;
+
+/* Alignment of all the allocations of an arena (a power of 2) */
+#define M_AR3NA_ALIGN (sizeof (m_ar3na_align_ct))
+
+/* Define a chunk of memory of an arena.
+   The data are allocated just after the header
+   (the chunk is allocated with 'size' bytes for data) */
+typedef struct m_ar3na_chunk_s {
+  struct m_ar3na_chunk_s *next;
+  size_t                 size;
+  m_ar3na_align_ct       data[1];
+} m_ar3na_chunk_ct;
+
+/* Define an arena.
+   NOTE: The arena is not trivially movable
+   (its allocator interface references it). */
+typedef struct m_arena_s {
+  char             *ptr;          // first free byte of the current chunk
+  char             *end;          // end of the current chunk
+  m_ar3na_chunk_ct *current;      // chunk in use (NULL if none)
+  m_ar3na_chunk_ct *first;        // first chunk of the list of chunks
+  size_t           chunk_size;    // size of the next chunk to allocate
+  m_allocator_t    allocator;     // allocator interface of the arena
+} m_arena_t[1];
+
+// Pointer to an arena
+typedef struct m_arena_s *m_arena_ptr;
+
+/* Define a position within an arena (see m_arena_mark) */
+typedef struct m_arena_mark_s {
+  m_ar3na_chunk_ct *chunk;
+  char             *ptr;
+} m_arena_mark_t;
+
+/* Contract of an arena */
+#define M_AR3NA_CONTRACT(a) do {                                              \
+    M_ASSERT ((a) != NULL);                                                   \
+    M_ASSERT ((const void *) (a)->allocator.state == (const void *) (a));     \
+    M_ASSERT ((a)->current != NULL || ((a)->ptr == NULL && (a)->end == NULL)); \
+    M_ASSERT ((a)->current == NULL || (a)->first != NULL);                    \
+    M_ASSERT ((a)->ptr <= (a)->end);                                          \
+  } while (0)
+
+/* Return the size rounded up to the alignment of the arena */
+#define M_AR3NA_ROUND(size)                                                   \
+  (((size) + M_AR3NA_ALIGN - 1) & ~(M_AR3NA_ALIGN - 1))
+
+/* Return the address of the data of a chunk */
+static inline char *
+m_ar3na_data(m_ar3na_chunk_ct *chunk)
+{
+  return (char *) (void *) chunk->data;
+}
+
+/* Use the given chunk as the current one */
+static inline void
+m_ar3na_set_chunk(m_arena_t arena, m_ar3na_chunk_ct *chunk)
+{
+  arena->current = chunk;
+  arena->ptr     = m_ar3na_data(chunk);
+  arena->end     = arena->ptr + chunk->size;
+}
+
+/* Slow path of the allocation: the current chunk is full.
+   Use the next chunk if it is big enough or insert a new one.
+   size is already rounded. */
+static inline void *
+m_ar3na_alloc_slow(m_arena_t arena, size_t size)
+{
+  m_ar3na_chunk_ct *next = arena->current == NULL ? arena->first : arena->current->next;
+  if (next == NULL || next->size < size) {
+    size_t alloc = M_MAX(arena->chunk_size, size);
+    const size_t header = offsetof(m_ar3na_chunk_ct, data);
+    if (M_UNLIKELY (alloc > SIZE_MAX - header)) {
+      M_MEMORY_FULL(size);
+      return NULL;
+    }
+    m_ar3na_chunk_ct *chunk = (m_ar3na_chunk_ct *) (void *) M_MEMORY_REALLOC(char, NULL, header + alloc);
+    if (M_UNLIKELY (chunk == NULL)) {
+      M_MEMORY_FULL(header + alloc);
+      return NULL;
+    }
+    chunk->size = alloc;
+    // Insert the new chunk after the current one (before the too small one)
+    chunk->next = next;
+    if (arena->current == NULL) {
+      arena->first = chunk;
+    } else {
+      arena->current->next = chunk;
+    }
+    next = chunk;
+    // Geometric growth of the chunks
+    if (arena->chunk_size <= SIZE_MAX / 2) {
+      arena->chunk_size *= 2;
+    }
+  }
+  m_ar3na_set_chunk(arena, next);
+  void *p = arena->ptr;
+  arena->ptr += size;
+  return p;
+}
+
+/* Allocate 'size' bytes from the arena (suitably aligned for any type).
+   Return NULL in case of failure */
+static inline void *
+m_arena_alloc(m_arena_t arena, size_t size)
+{
+  M_AR3NA_CONTRACT(arena);
+  if (M_UNLIKELY (size > SIZE_MAX - M_AR3NA_ALIGN)) {
+    M_MEMORY_FULL(size);
+    return NULL;
+  }
+  size = M_AR3NA_ROUND(size);
+  if (M_LIKELY ((size_t) (arena->end - arena->ptr) >= size && arena->ptr != NULL)) {
+    void *p = arena->ptr;
+    arena->ptr += size;
+    return p;
+  }
+  return m_ar3na_alloc_slow(arena, size);
+}
+
+/* Free the block 'ptr' of 'size' bytes allocated by the arena.
+   The memory is only reclaimed if it is the last allocated block */
+static inline void
+m_arena_free(m_arena_t arena, void *ptr, size_t size)
+{
+  M_AR3NA_CONTRACT(arena);
+  if (ptr != NULL && (char *) ptr + M_AR3NA_ROUND(size) == arena->ptr) {
+    arena->ptr = (char *) ptr;
+  }
+}
+
+/* Reallocate the block 'ptr' of 'old_size' bytes to 'new_size' bytes.
+   If ptr is the last allocated block, it is resized in place
+   (if the current chunk has enough room).
+   Return NULL in case of failure (the block being unchanged) */
+static inline void *
+m_arena_realloc(m_arena_t arena, void *ptr, size_t old_size, size_t new_size)
+{
+  M_AR3NA_CONTRACT(arena);
+  if (ptr == NULL) {
+    return m_arena_alloc(arena, new_size);
+  }
+  if (M_UNLIKELY (new_size > SIZE_MAX - M_AR3NA_ALIGN)) {
+    M_MEMORY_FULL(new_size);
+    return NULL;
+  }
+  char *p = (char *) ptr;
+  const size_t old_alloc = M_AR3NA_ROUND(old_size);
+  const size_t new_alloc = M_AR3NA_ROUND(new_size);
+  if (p + old_alloc == arena->ptr
+      && (size_t) (arena->end - p) >= new_alloc) {
+    // Last allocated block: resize in place
+    arena->ptr = p + new_alloc;
+    return ptr;
+  }
+  if (new_alloc <= old_alloc) {
+    return ptr;
+  }
+  void *n = m_arena_alloc(arena, new_size);
+  if (M_UNLIKELY (n == NULL)) {
+    return NULL;
+  }
+  memcpy(n, ptr, old_size);
+  return n;
+}
+
+/* Functions of the allocator interface */
+static inline void *
+m_ar3na_allocate(void *state, size_t size)
+{
+  return m_arena_alloc((struct m_arena_s *) state, size);
+}
+
+static inline void *
+m_ar3na_reallocate(void *state, void *ptr, size_t old_size, size_t new_size)
+{
+  return m_arena_realloc((struct m_arena_s *) state, ptr, old_size, new_size);
+}
+
+static inline void
+m_ar3na_deallocate(void *state, void *ptr, size_t size)
+{
+  m_arena_free((struct m_arena_s *) state, ptr, size);
+}
+
+/* Initialize the arena (constructor).
+   No memory is allocated until the first allocation */
+static inline void
+m_arena_init(m_arena_t arena)
+{
+  M_ASSERT (arena != NULL);
+  arena->ptr        = NULL;
+  arena->end        = NULL;
+  arena->current    = NULL;
+  arena->first      = NULL;
+  arena->chunk_size = M_USE_ARENA_CHUNK_SIZE;
+  arena->allocator.allocate   = m_ar3na_allocate;
+  arena->allocator.reallocate = m_ar3na_reallocate;
+  arena->allocator.deallocate = m_ar3na_deallocate;
+  arena->allocator.state      = arena;
+  M_AR3NA_CONTRACT(arena);
+}
+
+/* Clear the arena (destructor), giving back all its memory to the system.
+   All the blocks allocated by the arena are released. */
+static inline void
+m_arena_clear(m_arena_t arena)
+{
+  M_AR3NA_CONTRACT(arena);
+  m_ar3na_chunk_ct *chunk = arena->first;
+  while (chunk != NULL) {
+    m_ar3na_chunk_ct *next = chunk->next;
+    M_MEMORY_FREE(chunk);
+    chunk = next;
+  }
+  /* Clean pointers to be safer */
+  arena->first   = NULL;
+  arena->current = NULL;
+  arena->ptr     = NULL;
+  arena->end     = NULL;
+}
+
+/* Release all the blocks allocated by the arena in O(1).
+   The memory is kept by the arena for the next allocations. */
+static inline void
+m_arena_reset(m_arena_t arena)
+{
+  M_AR3NA_CONTRACT(arena);
+  if (arena->first != NULL) {
+    m_ar3na_set_chunk(arena, arena->first);
+  }
+  M_AR3NA_CONTRACT(arena);
+}
+
+/* Return the current position of the arena */
+static inline m_arena_mark_t
+m_arena_mark(const m_arena_t arena)
+{
+  M_AR3NA_CONTRACT(arena);
+  m_arena_mark_t mark;
+  mark.chunk = arena->current;
+  mark.ptr   = arena->ptr;
+  return mark;
+}
+
+/* Release in O(1) all the blocks allocated by the arena
+   since the mark was taken. The mark shall be a mark of the arena
+   taken after the last reset (or rewind to a previous mark). */
+static inline void
+m_arena_rewind(m_arena_t arena, m_arena_mark_t mark)
+{
+  M_AR3NA_CONTRACT(arena);
+  if (mark.chunk == NULL) {
+    // Mark taken before the first allocation
+    m_arena_reset(arena);
+    return;
+  }
+  M_ASSERT (mark.ptr >= m_ar3na_data(mark.chunk)
+            && mark.ptr <= m_ar3na_data(mark.chunk) + mark.chunk->size);
+  arena->current = mark.chunk;
+  arena->ptr     = mark.ptr;
+  arena->end     = m_ar3na_data(mark.chunk) + mark.chunk->size;
+  M_AR3NA_CONTRACT(arena);
+}
+
+/* Return the number of bytes reserved by the arena from the system
+   (excluding the headers of the chunks) */
+static inline size_t
+m_arena_capacity(const m_arena_t arena)
+{
+  M_AR3NA_CONTRACT(arena);
+  size_t s = 0;
+  for(const m_ar3na_chunk_ct *chunk = arena->first; chunk != NULL; chunk = chunk->next)
+    s += chunk->size;
+  return s;
+}
+
+/* Return the allocator interface of the arena
+   (to be used with the containers having the ALLOCATOR method
+   or the strings if M_USE_STRING_ALLOCATOR is 1).
+   Freeing a block through this interface doesn't reclaim any memory
+   (except for the last allocated block), so the containers
+   allocated within the arena don't need to be cleared
+   if their elements don't own memory outside of the arena. */
+static inline const m_allocator_t *
+m_arena_allocator(const m_arena_t arena)
+{
+  M_AR3NA_CONTRACT(arena);
+  return &arena->allocator;
+}
+
+M_END_PROTECTED_CODE
+
+#if M_USE_SMALL_NAME
+#define arena_t m_arena_t
+#define arena_ptr m_arena_ptr
+#define arena_mark_t m_arena_mark_t
+#define arena_init m_arena_init
+#define arena_clear m_arena_clear
+#define arena_alloc m_arena_alloc
+#define arena_realloc m_arena_realloc
+#define arena_free m_arena_free
+#define arena_reset m_arena_reset
+#define arena_mark m_arena_mark
+#define arena_rewind m_arena_rewind
+#define arena_capacity m_arena_capacity
+#define arena_allocator m_arena_allocator
+#endif
+
+#endif
@@ -173,6 +173,7 @@
     size_t size;            /* Number of elements in the array */             \
     size_t alloc;           /* Allocated size for the array base */           \
     type *ptr;              /* Pointer to the array base */                   \
+    M_ALL0CATOR_FIELD(oplist) /* Allocator (if ALLOCATOR method) */           \
   } array_t[1];                                                               \
                                                                               \
   /* Define an iterator over an array */                                      \
@@ -198,9 +199,27 @@
     v->size  = 0;                                                             \
     v->alloc = 0;                                                             \
     v->ptr   = NULL;                                                          \
+    M_IF_METHOD(ALLOCATOR, oplist)(v->allocator = M_GET_ALLOCATOR oplist;, )  \
     M_ARRA4_CONTRACT(v);                                                      \
   }                                                                           \
                                                                               \
+  M_IF_METHOD(ALLOCATOR, oplist)(                                             \
+  static inline void                                                          \
+  M_C(name, _init_allocator)(array_t v, const m_allocator_t *allocator)       \
+  {                                                                           \
+    M_ASSERT (allocator != NULL);                                             \
+    M_C(name, _init)(v);                                                      \
+    v->allocator = allocator;                                                 \
+  }                                                                           \
+                                                                              \
+  static inline const m_allocator_t *                                         \
+  M_C(name, _allocator)(const array_t v)                                      \
+  {                                                                           \
+    M_ARRA4_CONTRACT(v);                                                      \
+    return v->allocator;                                                      \
+  }                                                                           \
+  , /* No ALLOCATOR */ )                                                      \
+                                                                              \
   static inline void                                                          \
   M_C(name, _reset)(array_t v)                                                \
   {                                                                           \
@@ -216,7 +235,7 @@
   {                                                                           \
     M_ARRA4_CONTRACT(v);                                                      \
     M_C(name, _reset)(v);                                                     \
-    M_CALL_FREE(oplist, v->ptr);                                              \
+    M_CALL_FREE_CTX(oplist, v->allocator, type, v->ptr, v->alloc);            \
     /* This is so reusing the object implies an assertion failure */          \
     v->alloc = 1;                                                             \
     v->ptr = NULL;                                                            \
@@ -231,7 +250,7 @@
     if (M_UNLIKELY (d == s)) return;                                          \
     if (s->size > d->alloc) {                                                 \
       const size_t alloc = s->size;                                           \
-      type *ptr = M_CALL_REALLOC(oplist, type, d->ptr, alloc);                \
+      type *ptr = M_CALL_REALLOC_CTX(oplist, d->allocator, type, d->ptr, d->alloc, alloc); \
       if (M_UNLIKELY (ptr == NULL)) {                                         \
         M_MEMORY_FULL(sizeof (type) * alloc);                                 \
         return ;                                                              \
@@ -256,6 +275,7 @@
   {                                                                           \
     M_ASSERT (d != s);                                                        \
     M_C(name, _init)(d);                                                      \
+    M_IF_METHOD(ALLOCATOR, oplist)(d->allocator = s->allocator;, )            \
     M_C(name, _set)(d, s);                                                    \
   }                                                                           \
   , /* No SET & INIT_SET */)                                                  \
@@ -268,6 +288,7 @@
     d->size  = s->size;                                                       \
     d->alloc = s->alloc;                                                      \
     d->ptr   = s->ptr;                                                        \
+    M_IF_METHOD(ALLOCATOR, oplist)(d->allocator = s->allocator;, )            \
     /* Robustness */                                                          \
     s->alloc = 1;                                                             \
     s->ptr   = NULL;                                                          \
@@ -314,7 +335,7 @@
         return NULL;                                                          \
       }                                                                       \
       M_ASSERT (alloc > v->size);                                             \
-      type *ptr = M_CALL_REALLOC(oplist, type, v->ptr, alloc);                \
+      type *ptr = M_CALL_REALLOC_CTX(oplist, v->allocator, type, v->ptr, v->alloc, alloc);                \
       if (M_UNLIKELY (ptr == NULL) ) {                                        \
         M_MEMORY_FULL(sizeof (type) * alloc);                                 \
         return NULL;                                                          \
@@ -379,7 +400,7 @@
         return ;                                                              \
       }                                                                       \
       M_ASSERT (alloc > v->size);                                             \
-      type *ptr = M_CALL_REALLOC(oplist, type, v->ptr, alloc);                \
+      type *ptr = M_CALL_REALLOC_CTX(oplist, v->allocator, type, v->ptr, v->alloc, alloc);                \
       if (M_UNLIKELY (ptr == NULL) ) {                                        \
         M_MEMORY_FULL(sizeof (type) * alloc);                                 \
         return;                                                               \
@@ -409,7 +430,7 @@
       /* Increase size of array */                                            \
       if (size > v->alloc) {                                                  \
         size_t alloc = size ;                                                 \
-        type *ptr = M_CALL_REALLOC(oplist, type, v->ptr, alloc);              \
+        type *ptr = M_CALL_REALLOC_CTX(oplist, v->allocator, type, v->ptr, v->alloc, alloc);              \
         if (M_UNLIKELY (ptr == NULL) ) {                                      \
           M_MEMORY_FULL(sizeof (type) * alloc);                               \
           return;                                                             \
@@ -434,11 +455,11 @@
       alloc = v->size;                                                        \
     }                                                                         \
     if (M_UNLIKELY (alloc == 0)) {                                            \
-      M_CALL_FREE(oplist, v->ptr);                                            \
+      M_CALL_FREE_CTX(oplist, v->allocator, type, v->ptr, v->alloc);          \
       v->size = v->alloc = 0;                                                 \
       v->ptr = NULL;                                                          \
     } else {                                                                  \
-      type *ptr = M_CALL_REALLOC(oplist, type, v->ptr, alloc);                \
+      type *ptr = M_CALL_REALLOC_CTX(oplist, v->allocator, type, v->ptr, v->alloc, alloc);                \
       if (M_UNLIKELY (ptr == NULL) ) {                                        \
         M_MEMORY_FULL(sizeof (type) * alloc);                                 \
         return;                                                               \
@@ -465,7 +486,7 @@
           M_MEMORY_FULL(sizeof (type) * alloc);                               \
           return NULL;                                                        \
         }                                                                     \
-        type *ptr = M_CALL_REALLOC(oplist, type, v->ptr, alloc);              \
+        type *ptr = M_CALL_REALLOC_CTX(oplist, v->allocator, type, v->ptr, v->alloc, alloc);              \
         if (M_UNLIKELY (ptr == NULL) ) {                                      \
           M_MEMORY_FULL(sizeof (type) * alloc);                               \
           return NULL;                                                        \
@@ -593,7 +614,7 @@
         M_MEMORY_FULL(sizeof (type) * alloc);                                 \
         return ;                                                              \
       }                                                                       \
-      type *ptr = M_CALL_REALLOC(oplist, type, v->ptr, alloc);                \
+      type *ptr = M_CALL_REALLOC_CTX(oplist, v->allocator, type, v->ptr, v->alloc, alloc);                \
       if (M_UNLIKELY (ptr == NULL) ) {                                        \
         M_MEMORY_FULL(sizeof (type) * alloc);                                 \
         return;                                                               \
@@ -631,6 +652,7 @@
     M_SWAP(size_t, v1->size, v2->size);                                       \
     M_SWAP(size_t, v1->alloc, v2->alloc);                                     \
     M_SWAP(type *, v1->ptr, v2->ptr);                                         \
+    M_IF_METHOD(ALLOCATOR, oplist)(M_SWAP(const m_allocator_t *, v1->allocator, v2->allocator);, ) \
     M_ARRA4_CONTRACT(v1);                                                     \
     M_ARRA4_CONTRACT(v2);                                                     \
   }                                                                           \
@@ -880,13 +902,13 @@
     if (M_UNLIKELY (l->size < 2))                                             \
       return;                                                                 \
     /* NOTE: if size is <= 4, no need to perform an allocation */             \
-    type *temp = M_CALL_REALLOC(oplist, type, NULL, l->size);                 \
+    type *temp = M_CALL_REALLOC_CTX(oplist, l->allocator, type, NULL, 0, l->size); \
     if (temp == NULL) {                                                       \
       M_MEMORY_FULL(sizeof (type) * l->size);                                 \
       return ;                                                                \
     }                                                                         \
     M_C3(m_arra4_,name,_stable_sort_noalloc)(l->ptr, l->size, temp);          \
-    M_CALL_FREE(oplist, temp);                                                \
+    M_CALL_FREE_CTX(oplist, l->allocator, type, temp, l->size);               \
   }                                                                           \
   ,) /* IF SWAP & SET methods */                                              \
                                                                               \
@@ -1083,7 +1105,7 @@
     if (M_LIKELY (a2->size > 0)) {                                            \
       size_t newSize = a1->size + a2->size;                                   \
       if (newSize > a1->alloc) {                                              \
-        type *ptr = M_CALL_REALLOC(oplist, type, a1->ptr, newSize);           \
+        type *ptr = M_CALL_REALLOC_CTX(oplist, a1->allocator, type, a1->ptr, a1->alloc, newSize); \
         if (M_UNLIKELY (ptr == NULL) ) {                                      \
           M_MEMORY_FULL(sizeof (type) * newSize);                             \
         }                                                                     \
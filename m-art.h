@@ -0,0 +1,1351 @@
+/*
+ * M*LIB - Adaptive Radix Tree module
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_ART_H
+#define MSTARLIB_ART_H
+
+#include "m-core.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Define an adaptive radix tree that maps a 'key' to a 'value'
+   with its associated functions.
+   The keys are ordered by the lexicographic order of their bytes,
+   as returned by the KEY_BYTES method of the key oplist
+   (integers are encoded in big endian by default).
+   USAGE:
+   ART_DEF2(name, key_t, key_oplist, value_t, value_oplist)
+   OR
+   ART_DEF2(name, key_t, value_t)
+*/
+#define M_ART_DEF2(name, key_type, ...)                                       \
+  M_ART_DEF2_AS(name, M_C(name,_t), M_C(name,_it_t), M_C(name, _itref_t), key_type, __VA_ARGS__)
+
+
+/* Define an adaptive radix tree that maps a 'key' to a 'value'
+   as the given name name_t with its associated functions.
+   USAGE:
+   ART_DEF2_AS(name, name_t, it_t, itref_t, key_t, key_oplist, value_t, value_oplist)
+   OR
+   ART_DEF2_AS(name, name_t, it_t, itref_t, key_t, value_t)
+*/
+#define M_ART_DEF2_AS(name, name_t, it_t, itref_t, key_type, ...)             \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_4RT_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                    \
+               ((name, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), name_t, M_C(name, _leaf_ct), it_t, itref_t ), \
+                (name, key_type, __VA_ARGS__,                                                                            name_t, M_C(name, _leaf_ct), it_t, itref_t ))) \
+  M_END_PROTECTED_CODE
+
+
+/* Define the oplist of an adaptive radix tree (from ART_DEF2).
+   USAGE: ART_OPLIST2(name[, key_oplist, value_oplist]) */
+#define M_ART_OPLIST2(...)                                                    \
+  M_4RT_OPLIST2_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                \
+                   ((__VA_ARGS__, M_BASIC_OPLIST, M_BASIC_OPLIST ),           \
+                    (__VA_ARGS__ )))
+
+
+/********************************** INTERNAL ************************************/
+
+/* Type of the nodes of an adaptive radix tree */
+#define M_4RT_LEAF    0
+#define M_4RT_NODE4   1
+#define M_4RT_NODE16  2
+#define M_4RT_NODE48  3
+#define M_4RT_NODE256 4
+
+/* Number of bytes of a compressed path stored in an inner node.
+   The other bytes of a longer path are read from a leaf below the node */
+#define M_4RT_MAX_PREFIX 8
+
+/* Number of levels of the path kept by an iterator.
+   The levels of a deeper path are recomputed from the current leaf */
+#define M_4RT_MAX_STACK 32
+
+/* Common header of all nodes */
+typedef struct m_4rt_base_s {
+  uint8_t type;
+} m_4rt_base_t;
+
+/* Common header of all inner nodes.
+   A key that ends in the node (after its compressed path)
+   is stored in its leaf field, as it is lower than all its children. */
+typedef struct m_4rt_inner_s {
+  m_4rt_base_t  base;
+  uint16_t      num;                        /* Number of children */
+  uint32_t      prefix_len;                 /* Length of the compressed path */
+  unsigned char prefix[M_4RT_MAX_PREFIX];   /* First bytes of the compressed path */
+  m_4rt_base_t *leaf;                       /* Leaf of the key ending in the node */
+} m_4rt_inner_t;
+
+/* Inner node with up to 4 children (sorted keys) */
+typedef struct m_4rt_node4_s {
+  m_4rt_inner_t n;
+  unsigned char key[4];
+  m_4rt_base_t *child[4];
+} m_4rt_node4_t;
+
+/* Inner node with up to 16 children (sorted keys) */
+typedef struct m_4rt_node16_s {
+  m_4rt_inner_t n;
+  unsigned char key[16];
+  m_4rt_base_t *child[16];
+} m_4rt_node16_t;
+
+/* Inner node with up to 48 children (index of the child + 1 for each byte) */
+typedef struct m_4rt_node48_s {
+  m_4rt_inner_t n;
+  unsigned char index[256];
+  m_4rt_base_t *child[48];
+} m_4rt_node48_t;
+
+/* Inner node with up to 256 children (directly indexed by the byte) */
+typedef struct m_4rt_node256_s {
+  m_4rt_inner_t n;
+  m_4rt_base_t *child[256];
+} m_4rt_node256_t;
+
+/* Cast a node to its real type */
+#define M_4RT_CAST(type, node) M_ASSIGN_CAST(type *, (void *) (node))
+#define M_4RT_CCAST(type, node) M_ASSIGN_CAST(const type *, (const void *) (node))
+
+/* Contract of an inner node */
+#define M_4RT_NODE_CONTRACT(in) do {                                          \
+    M_ASSERT ((in) != NULL);                                                  \
+    M_ASSERT (M_4RT_NODE4 <= (in)->base.type && (in)->base.type <= M_4RT_NODE256); \
+    M_ASSERT ((in)->num + ((in)->leaf != NULL) >= 1);                         \
+    M_ASSERT ((in)->num <= m_4rt_capacity((in)->base.type));                  \
+  } while (0)
+
+/* Contract of an adaptive radix tree */
+#define M_4RT_CONTRACT(t) do {                                                \
+    M_ASSERT ((t) != NULL);                                                   \
+    M_ASSERT (((t)->root == NULL) == ((t)->size == 0));                       \
+  } while (0)
+
+static inline bool
+m_4rt_leaf_p(const m_4rt_base_t *b)
+{
+  M_ASSERT (b != NULL);
+  return b->type == M_4RT_LEAF;
+}
+
+static inline m_4rt_inner_t *
+m_4rt_inner(m_4rt_base_t *b)
+{
+  M_ASSERT (b != NULL && b->type != M_4RT_LEAF);
+  return M_4RT_CAST(m_4rt_inner_t, b);
+}
+
+/* Return the maximum number of children of a node of the given type */
+static inline unsigned
+m_4rt_capacity(unsigned type)
+{
+  return type == M_4RT_NODE4 ? 4U : type == M_4RT_NODE16 ? 16U
+    : type == M_4RT_NODE48 ? 48U : 256U;
+}
+
+/* Return the size of a node of the given type */
+static inline size_t
+m_4rt_node_size(unsigned type)
+{
+  return type == M_4RT_NODE4 ? sizeof (m_4rt_node4_t)
+    : type == M_4RT_NODE16 ? sizeof (m_4rt_node16_t)
+    : type == M_4RT_NODE48 ? sizeof (m_4rt_node48_t)
+    : sizeof (m_4rt_node256_t);
+}
+
+/* Return the index of the byte 'c' in the keys of a Node16 or -1 */
+static inline int
+m_4rt_find16(const m_4rt_node16_t *n, unsigned char c)
+{
+#if defined(__SSE2__)
+  /* Compare the byte with the 16 keys at once */
+  __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char) c),
+                               _mm_loadu_si128((const __m128i *) (const void *) n->key));
+  unsigned mask = (unsigned) _mm_movemask_epi8(cmp) & ((1U << n->n.num) - 1U);
+  return mask == 0 ? -1 : __builtin_ctz(mask);
+#else
+  for(int i = 0; i < n->n.num; i++) {
+    if (n->key[i] == c) return i;
+  }
+  return -1;
+#endif
+}
+
+/* Return a reference to the child of the byte 'c' or NULL */
+static inline m_4rt_base_t **
+m_4rt_find_child(m_4rt_inner_t *in, unsigned char c)
+{
+  switch (in->base.type) {
+  case M_4RT_NODE4: {
+    m_4rt_node4_t *n = M_4RT_CAST(m_4rt_node4_t, in);
+    for(int i = 0; i < in->num; i++) {
+      if (n->key[i] == c) return &n->child[i];
+    }
+    return NULL;
+  }
+  case M_4RT_NODE16: {
+    m_4rt_node16_t *n = M_4RT_CAST(m_4rt_node16_t, in);
+    int i = m_4rt_find16(n, c);
+    return i < 0 ? NULL : &n->child[i];
+  }
+  case M_4RT_NODE48: {
+    m_4rt_node48_t *n = M_4RT_CAST(m_4rt_node48_t, in);
+    return n->index[c] == 0 ? NULL : &n->child[n->index[c] - 1];
+  }
+  default: {
+    M_ASSERT (in->base.type == M_4RT_NODE256);
+    m_4rt_node256_t *n = M_4RT_CAST(m_4rt_node256_t, in);
+    return n->child[c] == NULL ? NULL : &n->child[c];
+  }
+  }
+}
+
+/* Return the position of the existing child of the byte 'c'.
+   The position of a child is its index for a Node4 / Node16,
+   its byte otherwise */
+static inline unsigned
+m_4rt_child_pos(const m_4rt_inner_t *in, unsigned char c)
+{
+  if (in->base.type == M_4RT_NODE4) {
+    const m_4rt_node4_t *n = M_4RT_CCAST(m_4rt_node4_t, in);
+    unsigned i = 0;
+    while (n->key[i] != c) { i++; M_ASSERT (i < in->num); }
+    return i;
+  } else if (in->base.type == M_4RT_NODE16) {
+    int i = m_4rt_find16(M_4RT_CCAST(m_4rt_node16_t, in), c);
+    M_ASSERT (i >= 0);
+    return (unsigned) i;
+  }
+  return c;
+}
+
+/* Return the first child at a position greater or equal than *pos
+   (updating *pos to its position) or NULL if there is none */
+static inline m_4rt_base_t *
+m_4rt_next_child(const m_4rt_inner_t *in, unsigned *pos)
+{
+  switch (in->base.type) {
+  case M_4RT_NODE4:
+    return *pos < in->num ? M_4RT_CCAST(m_4rt_node4_t, in)->child[*pos] : NULL;
+  case M_4RT_NODE16:
+    return *pos < in->num ? M_4RT_CCAST(m_4rt_node16_t, in)->child[*pos] : NULL;
+  case M_4RT_NODE48: {
+    const m_4rt_node48_t *n = M_4RT_CCAST(m_4rt_node48_t, in);
+    for(unsigned b = *pos; b < 256; b++) {
+      if (n->index[b] != 0) {
+        *pos = b;
+        return n->child[n->index[b] - 1];
+      }
+    }
+    return NULL;
+  }
+  default: {
+    const m_4rt_node256_t *n = M_4RT_CCAST(m_4rt_node256_t, in);
+    for(unsigned b = *pos; b < 256; b++) {
+      if (n->child[b] != NULL) {
+        *pos = b;
+        return n->child[b];
+      }
+    }
+    return NULL;
+  }
+  }
+}
+
+/* Return the first child of a byte greater than 'c' or NULL */
+static inline m_4rt_base_t *
+m_4rt_greater_child(const m_4rt_inner_t *in, unsigned char c)
+{
+  unsigned pos = 0;
+  if (in->base.type == M_4RT_NODE4) {
+    const m_4rt_node4_t *n = M_4RT_CCAST(m_4rt_node4_t, in);
+    while (pos < in->num && n->key[pos] <= c) pos++;
+  } else if (in->base.type == M_4RT_NODE16) {
+    const m_4rt_node16_t *n = M_4RT_CCAST(m_4rt_node16_t, in);
+    while (pos < in->num && n->key[pos] <= c) pos++;
+  } else {
+    pos = c + 1U;
+  }
+  return m_4rt_next_child(in, &pos);
+}
+
+/* Return the reference to the child at the given position */
+static inline m_4rt_base_t **
+m_4rt_child_ref(m_4rt_inner_t *in, unsigned pos)
+{
+  switch (in->base.type) {
+  case M_4RT_NODE4:
+    return &M_4RT_CAST(m_4rt_node4_t, in)->child[pos];
+  case M_4RT_NODE16:
+    return &M_4RT_CAST(m_4rt_node16_t, in)->child[pos];
+  case M_4RT_NODE48: {
+    m_4rt_node48_t *n = M_4RT_CAST(m_4rt_node48_t, in);
+    M_ASSERT (n->index[pos] != 0);
+    return &n->child[n->index[pos] - 1];
+  }
+  default:
+    return &M_4RT_CAST(m_4rt_node256_t, in)->child[pos];
+  }
+}
+
+/* Return true if no child can be added to the node */
+static inline bool
+m_4rt_full_p(const m_4rt_inner_t *in)
+{
+  return in->num == m_4rt_capacity(in->base.type);
+}
+
+/* Return true if the node shall be shrunk to the lower type */
+static inline bool
+m_4rt_shrink_p(const m_4rt_inner_t *in)
+{
+  return (in->base.type == M_4RT_NODE16 && in->num <= 3)
+    || (in->base.type == M_4RT_NODE48 && in->num <= 12)
+    || (in->base.type == M_4RT_NODE256 && in->num <= 36);
+}
+
+/* Add the child of the byte 'c' to a node that is not full */
+static inline void
+m_4rt_add_child(m_4rt_inner_t *in, unsigned char c, m_4rt_base_t *child)
+{
+  M_ASSERT (!m_4rt_full_p(in));
+  M_ASSERT (m_4rt_find_child(in, c) == NULL);
+  switch (in->base.type) {
+  case M_4RT_NODE4: {
+    m_4rt_node4_t *n = M_4RT_CAST(m_4rt_node4_t, in);
+    unsigned i = in->num;
+    for( ; i > 0 && n->key[i-1] > c; i--) {
+      n->key[i] = n->key[i-1];
+      n->child[i] = n->child[i-1];
+    }
+    n->key[i] = c;
+    n->child[i] = child;
+    break;
+  }
+  case M_4RT_NODE16: {
+    m_4rt_node16_t *n = M_4RT_CAST(m_4rt_node16_t, in);
+    unsigned i = in->num;
+    for( ; i > 0 && n->key[i-1] > c; i--) {
+      n->key[i] = n->key[i-1];
+      n->child[i] = n->child[i-1];
+    }
+    n->key[i] = c;
+    n->child[i] = child;
+    break;
+  }
+  case M_4RT_NODE48: {
+    m_4rt_node48_t *n = M_4RT_CAST(m_4rt_node48_t, in);
+    unsigned s = 0;
+    while (n->child[s] != NULL) s++;
+    n->child[s] = child;
+    n->index[c] = (unsigned char) (s + 1);
+    break;
+  }
+  default:
+    M_4RT_CAST(m_4rt_node256_t, in)->child[c] = child;
+    break;
+  }
+  in->num++;
+}
+
+/* Remove the child of the byte 'c' of the node */
+static inline void
+m_4rt_remove_child(m_4rt_inner_t *in, unsigned char c)
+{
+  switch (in->base.type) {
+  case M_4RT_NODE4: {
+    m_4rt_node4_t *n = M_4RT_CAST(m_4rt_node4_t, in);
+    for(unsigned i = m_4rt_child_pos(in, c); i + 1 < in->num; i++) {
+      n->key[i] = n->key[i+1];
+      n->child[i] = n->child[i+1];
+    }
+    break;
+  }
+  case M_4RT_NODE16: {
+    m_4rt_node16_t *n = M_4RT_CAST(m_4rt_node16_t, in);
+    for(unsigned i = m_4rt_child_pos(in, c); i + 1 < in->num; i++) {
+      n->key[i] = n->key[i+1];
+      n->child[i] = n->child[i+1];
+    }
+    break;
+  }
+  case M_4RT_NODE48: {
+    m_4rt_node48_t *n = M_4RT_CAST(m_4rt_node48_t, in);
+    M_ASSERT (n->index[c] != 0);
+    n->child[n->index[c] - 1] = NULL;
+    n->index[c] = 0;
+    break;
+  }
+  default:
+    M_4RT_CAST(m_4rt_node256_t, in)->child[c] = NULL;
+    break;
+  }
+  in->num--;
+}
+
+/* Initialize the empty node of the given type */
+static inline void
+m_4rt_init_node(m_4rt_inner_t *in, unsigned type)
+{
+  in->base.type = (uint8_t) type;
+  in->num = 0;
+  in->prefix_len = 0;
+  in->leaf = NULL;
+  if (type == M_4RT_NODE48) {
+    m_4rt_node48_t *n = M_4RT_CAST(m_4rt_node48_t, in);
+    memset(n->index, 0, sizeof n->index);
+    for(unsigned i = 0; i < 48; i++) n->child[i] = NULL;
+  } else if (type == M_4RT_NODE256) {
+    m_4rt_node256_t *n = M_4RT_CAST(m_4rt_node256_t, in);
+    for(unsigned i = 0; i < 256; i++) n->child[i] = NULL;
+  }
+}
+
+/* Copy the children of the node 'src' into the empty node 'dst'
+   of the next greater or lower type, and its header */
+static inline void
+m_4rt_resize_node(m_4rt_inner_t *dst, const m_4rt_inner_t *src)
+{
+  M_ASSERT (dst->num == 0 && src->num <= m_4rt_capacity(dst->base.type));
+  unsigned pos = 0;
+  m_4rt_base_t *child;
+  while ((child = m_4rt_next_child(src, &pos)) != NULL) {
+    unsigned char c;
+    if (src->base.type == M_4RT_NODE4) {
+      c = M_4RT_CCAST(m_4rt_node4_t, src)->key[pos];
+    } else if (src->base.type == M_4RT_NODE16) {
+      c = M_4RT_CCAST(m_4rt_node16_t, src)->key[pos];
+    } else {
+      c = (unsigned char) pos;
+    }
+    m_4rt_add_child(dst, c, child);
+    pos++;
+  }
+  dst->prefix_len = src->prefix_len;
+  memcpy(dst->prefix, src->prefix, M_4RT_MAX_PREFIX);
+  dst->leaf = src->leaf;
+}
+
+/* Prepend the compressed path of the node 'in' and the byte 'c'
+   to the compressed path of its only child 'sub' */
+static inline void
+m_4rt_merge_prefix(m_4rt_inner_t *sub, const m_4rt_inner_t *in, unsigned char c)
+{
+  unsigned char buffer[M_4RT_MAX_PREFIX];
+  size_t n = M_MIN(in->prefix_len, (uint32_t) M_4RT_MAX_PREFIX);
+  memcpy(buffer, in->prefix, n);
+  if (n < M_4RT_MAX_PREFIX) {
+    buffer[n++] = c;
+  }
+  if (n < M_4RT_MAX_PREFIX) {
+    size_t s = M_MIN((size_t) sub->prefix_len, M_4RT_MAX_PREFIX - n);
+    memcpy(buffer + n, sub->prefix, s);
+    n += s;
+  }
+  memcpy(sub->prefix, buffer, n);
+  sub->prefix_len += in->prefix_len + 1;
+}
+
+/* Set the compressed path of the node */
+static inline void
+m_4rt_set_prefix(m_4rt_inner_t *in, const unsigned char path[], size_t len)
+{
+  M_ASSERT (len <= UINT32_MAX);
+  in->prefix_len = (uint32_t) len;
+  memcpy(in->prefix, path, M_MIN(len, (size_t) M_4RT_MAX_PREFIX));
+}
+
+/* Return the leaf of the lowest key of the sub-tree */
+static inline m_4rt_base_t *
+m_4rt_min_leaf(m_4rt_base_t *b)
+{
+  while (b != NULL && !m_4rt_leaf_p(b)) {
+    m_4rt_inner_t *in = m_4rt_inner(b);
+    if (in->leaf != NULL) return in->leaf;
+    unsigned pos = 0;
+    b = m_4rt_next_child(in, &pos);
+  }
+  return b;
+}
+
+/* Compare the bytes of a compressed path with the bytes of a key:
+   return -1 if the path is lower, 1 if the path is greater
+   (or the key ends within the path), 0 if the key starts with the path */
+static inline int
+m_4rt_cmp_path(const unsigned char path[], size_t len,
+               const unsigned char key[], size_t klen)
+{
+  for(size_t i = 0; i < len; i++) {
+    if (i == klen) return 1;
+    if (path[i] != key[i]) return path[i] < key[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+/* Compare two keys by the lexicographic order of their bytes */
+static inline int
+m_4rt_cmp_bytes(const unsigned char a[], size_t alen,
+                const unsigned char b[], size_t blen)
+{
+  int c = memcmp(a, b, M_MIN(alen, blen));
+  return c != 0 ? c : alen < blen ? -1 : alen > blen;
+}
+
+/* Deferred evaluation */
+#define M_4RT_OPLIST2_P1(arg) M_4RT_OPLIST2_P2 arg
+
+/* Validation of the given oplists (first the key oplist, then the value oplist) */
+#define M_4RT_OPLIST2_P2(name, key_oplist, value_oplist)                      \
+  M_IF_OPLIST(key_oplist)(M_4RT_OPLIST2_P3, M_4RT_OPLIST2_FAILURE)(name, key_oplist, value_oplist)
+#define M_4RT_OPLIST2_P3(name, key_oplist, value_oplist)                      \
+  M_IF_OPLIST(value_oplist)(M_4RT_OPLIST2_P4, M_4RT_OPLIST2_FAILURE)(name, key_oplist, value_oplist)
+
+/* Prepare a clean compilation failure */
+#define M_4RT_OPLIST2_FAILURE(name, key_oplist, value_oplist)                 \
+  ((M_LIB_ERROR(ARGUMENT_OF_ART_OPLIST_IS_NOT_AN_OPLIST, name, key_oplist, value_oplist)))
+
+/* Final definition of the oplist (associative array) */
+#define M_4RT_OPLIST2_P4(name, key_oplist, value_oplist)                      \
+  (INIT(M_C(name, _init)),                                                    \
+   INIT_SET(M_C(name, _init_set)),                                            \
+   SET(M_C(name, _set)),                                                      \
+   CLEAR(M_C(name, _clear)),                                                  \
+   INIT_MOVE(M_C(name, _init_move)),                                          \
+   MOVE(M_C(name, _move)),                                                    \
+   SWAP(M_C(name, _swap)),                                                    \
+   NAME(name),                                                                \
+   TYPE(M_C(name,_ct)),                                                       \
+   SUBTYPE(M_C(name, _subtype_ct)),                                           \
+   EMPTY_P(M_C(name,_empty_p)),                                               \
+   GET_SIZE(M_C(name,_size)),                                                 \
+   IT_TYPE(M_C(name, _it_ct)),                                                \
+   IT_FIRST(M_C(name,_it)),                                                   \
+   IT_SET(M_C(name,_it_set)),                                                 \
+   IT_END(M_C(name,_it_end)),                                                 \
+   IT_END_P(M_C(name,_end_p)),                                                \
+   IT_EQUAL_P(M_C(name,_it_equal_p)),                                         \
+   IT_NEXT(M_C(name,_next)),                                                  \
+   IT_REF(M_C(name,_ref)),                                                    \
+   IT_CREF(M_C(name,_cref)),                                                  \
+   RESET(M_C(name,_reset)),                                                   \
+   KEY_TYPE(M_C(name, _key_ct)),                                              \
+   VALUE_TYPE(M_C(name, _value_ct)),                                          \
+   SET_KEY(M_C(name, _set_at)),                                               \
+   GET_KEY(M_C(name, _get)),                                                  \
+   ERASE_KEY(M_C(name, _erase)),                                              \
+   KEY_OPLIST(key_oplist),                                                    \
+   VALUE_OPLIST(value_oplist),                                                \
+   M_IF_METHOD_BOTH(EQUAL, key_oplist, value_oplist)(EQUAL(M_C(name, _equal_p)),), \
+   M_IF_METHOD(NEW, key_oplist)(NEW(M_GET_NEW key_oplist),)                   \
+   M_IF_METHOD(DEL, key_oplist)(DEL(M_GET_DEL key_oplist),)                   \
+   )
+
+/* Deferred evaluation for the adaptive radix tree definition,
+   so that all arguments are evaluated before further expansion */
+#define M_4RT_DEF_P1(arg) M_ID( M_4RT_DEF_P2 arg )
+
+/* Validate the key oplist before going further */
+#define M_4RT_DEF_P2(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+  M_IF_OPLIST(key_oplist)(M_4RT_DEF_P3, M_4RT_DEF_FAILURE)(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t)
+
+/* Validate the value oplist before going further */
+#define M_4RT_DEF_P3(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+  M_IF_OPLIST(value_oplist)(M_4RT_DEF_P4, M_4RT_DEF_FAILURE)(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t)
+
+/* Stop processing with a compilation failure */
+#define M_4RT_DEF_FAILURE(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+  M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(ART_DEF2): one of the given argument is not a valid oplist: " M_AS_STR(key_oplist) " / " M_AS_STR(value_oplist))
+
+/* Internal adaptive radix tree definition
+   - name: prefix to be used
+   - key_t: key type of the elements of the container
+   - key_oplist: oplist of the key type of the elements of the container
+   - value_t: value type of the elements of the container
+   - value_oplist: oplist of the value type of the elements of the container
+   - tree_t: alias for the type of the container
+   - leaf_t: alias for the leaf of the container (storing an element)
+   - it_t: alias for the iterator of the container
+   - itref_t: alias for the type referenced by the iterator
+ */
+#define M_4RT_DEF_P4(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+  M_4RT_DEF_TYPE(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+  M_CHECK_COMPATIBLE_OPLIST(name, 1, key_t, key_oplist)                       \
+  M_CHECK_COMPATIBLE_OPLIST(name, 2, value_t, value_oplist)                   \
+  M_4RT_DEF_CORE(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+  M_4RT_DEF_IT(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+  M_4RT_DEF_EQUAL(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t)
+
+/* Define the types of an adaptive radix tree */
+#define M_4RT_DEF_TYPE(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+                                                                              \
+  /* Type returned by the iterator */                                         \
+  typedef struct M_C(name, _pair_s) {                                         \
+    key_t   *key_ptr;                                                         \
+    value_t *value_ptr;                                                       \
+  } itref_t;                                                                  \
+                                                                              \
+  /* A leaf stores an element of the tree */                                  \
+  typedef struct M_C(name, _leaf_s) {                                         \
+    m_4rt_base_t base;                                                        \
+    key_t        key;                                                         \
+    value_t      value;                                                       \
+  } leaf_t;                                                                   \
+                                                                              \
+  /* An adaptive radix tree is a reference to its root node */                \
+  typedef struct M_C(name, _s) {                                              \
+    m_4rt_base_t *root;                                                       \
+    size_t        size;                                                       \
+  } tree_t[1];                                                                \
+  typedef struct M_C(name, _s) *M_C(name, _ptr);                              \
+  typedef const struct M_C(name, _s) *M_C(name, _srcptr);                     \
+                                                                              \
+  /* Define the Iterator: the path of inner nodes from the root to the        \
+     current leaf and the next position to visit in each of them.             \
+     The path is stored in a ring: only the last M_4RT_MAX_STACK levels       \
+     are kept, the lower ones are recomputed from the current leaf.           \
+     The next position of a level is 0 if the leaf of the node has not        \
+     been visited yet, or the position of the next child to visit + 1 */      \
+  typedef struct M_C(name, _it_s) {                                           \
+    itref_t              pair;                                                \
+    leaf_t              *leaf;     /* Current leaf (NULL if end) */           \
+    const struct M_C(name, _s) *tree;                                         \
+    unsigned             depth;    /* Number of levels of the path */         \
+    unsigned             low;      /* Lowest level kept in the ring */        \
+    unsigned             base;     /* Level of the iterated sub-tree */       \
+    m_4rt_inner_t       *node[M_4RT_MAX_STACK];                               \
+    unsigned             pos[M_4RT_MAX_STACK];                                \
+  } it_t[1];                                                                  \
+                                                                              \
+  /* Definition of the alias used by the oplists */                           \
+  typedef itref_t   M_C(name, _subtype_ct);                                   \
+  typedef key_t     M_C(name, _key_ct);                                       \
+  typedef value_t   M_C(name, _value_ct);                                     \
+  typedef tree_t    M_C(name, _ct);                                           \
+  typedef it_t      M_C(name, _it_ct);                                        \
+
+/* Define the core functions of an adaptive radix tree */
+#define M_4RT_DEF_CORE(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+                                                                              \
+  static inline leaf_t *M_C3(m_4rt_,name,_to_leaf)(m_4rt_base_t *b)           \
+  {                                                                           \
+    M_ASSERT (m_4rt_leaf_p(b));                                               \
+    return M_4RT_CAST(leaf_t, b);                                             \
+  }                                                                           \
+                                                                              \
+  /* Return the bytes of the key of the leaf */                               \
+  static inline const unsigned char *                                         \
+  M_C3(m_4rt_,name,_leaf_bytes)(unsigned char buffer[], size_t *len, m_4rt_base_t *b) \
+  {                                                                           \
+    return M_CALL_KEY_BYTES(key_oplist, buffer, len, M_C3(m_4rt_,name,_to_leaf)(b)->key); \
+  }                                                                           \
+                                                                              \
+  /* Allocate a new leaf, copy of the given key and value */                  \
+  static inline m_4rt_base_t *                                                \
+  M_C3(m_4rt_,name,_new_leaf)(key_t const key, value_t const value)           \
+  {                                                                           \
+    leaf_t *l = M_CALL_NEW(key_oplist, leaf_t);                               \
+    if (M_UNLIKELY (l == NULL)) {                                             \
+      M_MEMORY_FULL(sizeof (leaf_t));                                         \
+      M_ASSERT (0);                                                           \
+    }                                                                         \
+    l->base.type = M_4RT_LEAF;                                                \
+    M_CALL_INIT_SET(key_oplist, l->key, key);                                 \
+    M_CALL_INIT_SET(value_oplist, l->value, value);                           \
+    return &l->base;                                                          \
+  }                                                                           \
+                                                                              \
+  /* Allocate a new empty inner node of the given type */                     \
+  static inline m_4rt_inner_t *                                               \
+  M_C3(m_4rt_,name,_new_node)(unsigned type)                                  \
+  {                                                                           \
+    void *p;                                                                  \
+    switch (type) {                                                           \
+    case M_4RT_NODE4: p = M_CALL_NEW(key_oplist, m_4rt_node4_t); break;       \
+    case M_4RT_NODE16: p = M_CALL_NEW(key_oplist, m_4rt_node16_t); break;     \
+    case M_4RT_NODE48: p = M_CALL_NEW(key_oplist, m_4rt_node48_t); break;     \
+    default: p = M_CALL_NEW(key_oplist, m_4rt_node256_t); break;              \
+    }                                                                         \
+    if (M_UNLIKELY (p == NULL)) {                                             \
+      M_MEMORY_FULL(m_4rt_node_size(type));                                   \
+      M_ASSERT (0);                                                           \
+    }                                                                         \
+    m_4rt_inner_t *in = M_ASSIGN_CAST(m_4rt_inner_t *, p);                    \
+    m_4rt_init_node(in, type);                                                \
+    return in;                                                                \
+  }                                                                           \
+                                                                              \
+  /* Free an inner node (not its children) */                                 \
+  static inline void                                                          \
+  M_C3(m_4rt_,name,_del_node)(m_4rt_inner_t *in)                              \
+  {                                                                           \
+    switch (in->base.type) {                                                  \
+    case M_4RT_NODE4: M_CALL_DEL(key_oplist, M_4RT_CAST(m_4rt_node4_t, in)); break; \
+    case M_4RT_NODE16: M_CALL_DEL(key_oplist, M_4RT_CAST(m_4rt_node16_t, in)); break; \
+    case M_4RT_NODE48: M_CALL_DEL(key_oplist, M_4RT_CAST(m_4rt_node48_t, in)); break; \
+    default: M_CALL_DEL(key_oplist, M_4RT_CAST(m_4rt_node256_t, in)); break;  \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Free a sub-tree and all its elements */                                  \
+  static inline void                                                          \
+  M_C3(m_4rt_,name,_free)(m_4rt_base_t *b)                                    \
+  {                                                                           \
+    if (b == NULL) return;                                                    \
+    if (m_4rt_leaf_p(b)) {                                                    \
+      leaf_t *l = M_C3(m_4rt_,name,_to_leaf)(b);                              \
+      M_CALL_CLEAR(key_oplist, l->key);                                       \
+      M_CALL_CLEAR(value_oplist, l->value);                                   \
+      M_CALL_DEL(key_oplist, l);                                              \
+      return;                                                                 \
+    }                                                                         \
+    m_4rt_inner_t *in = m_4rt_inner(b);                                       \
+    M_C3(m_4rt_,name,_free)(in->leaf);                                        \
+    unsigned pos = 0;                                                         \
+    m_4rt_base_t *child;                                                      \
+    while ((child = m_4rt_next_child(in, &pos)) != NULL) {                    \
+      M_C3(m_4rt_,name,_free)(child);                                         \
+      pos++;                                                                  \
+    }                                                                         \
+    M_C3(m_4rt_,name,_del_node)(in);                                          \
+  }                                                                           \
+                                                                              \
+  /* Return a copy of a sub-tree */                                           \
+  static inline m_4rt_base_t *                                                \
+  M_C3(m_4rt_,name,_copy)(m_4rt_base_t *b)                                    \
+  {                                                                           \
+    if (b == NULL) return NULL;                                               \
+    if (m_4rt_leaf_p(b)) {                                                    \
+      leaf_t *l = M_C3(m_4rt_,name,_to_leaf)(b);                              \
+      return M_C3(m_4rt_,name,_new_leaf)(l->key, l->value);                   \
+    }                                                                         \
+    m_4rt_inner_t *in = m_4rt_inner(b);                                       \
+    m_4rt_inner_t *n = M_C3(m_4rt_,name,_new_node)(in->base.type);            \
+    memcpy((void *) n, (const void *) in, m_4rt_node_size(in->base.type));    \
+    n->leaf = M_C3(m_4rt_,name,_copy)(in->leaf);                              \
+    unsigned pos = 0;                                                         \
+    while (m_4rt_next_child(n, &pos) != NULL) {                               \
+      m_4rt_base_t **ref = m_4rt_child_ref(n, pos);                           \
+      *ref = M_C3(m_4rt_,name,_copy)(*ref);                                   \
+      pos++;                                                                  \
+    }                                                                         \
+    return &n->base;                                                          \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init)(tree_t tree)                                               \
+  {                                                                           \
+    tree->root = NULL;                                                        \
+    tree->size = 0;                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _reset)(tree_t tree)                                              \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    M_C3(m_4rt_,name,_free)(tree->root);                                      \
+    tree->root = NULL;                                                        \
+    tree->size = 0;                                                           \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _clear)(tree_t tree)                                              \
+  {                                                                           \
+    M_C(name, _reset)(tree);                                                  \
+    /* Clear is also invalidating the object */                               \
+    tree->root = NULL;                                                        \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init_set)(tree_t tree, const tree_t ref)                         \
+  {                                                                           \
+    M_4RT_CONTRACT(ref);                                                      \
+    M_ASSERT (tree != ref);                                                   \
+    tree->root = M_C3(m_4rt_,name,_copy)(ref->root);                          \
+    tree->size = ref->size;                                                   \
+    M_4RT_CONTRACT(tree);                                                     \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _set)(tree_t tree, const tree_t ref)                              \
+  {                                                                           \
+    if (tree == ref) return;                                                  \
+    M_C(name, _clear)(tree);                                                  \
+    M_C(name, _init_set)(tree, ref);                                          \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init_move)(tree_t tree, tree_t ref)                              \
+  {                                                                           \
+    M_4RT_CONTRACT(ref);                                                      \
+    M_ASSERT (tree != ref);                                                   \
+    tree->root = ref->root;                                                   \
+    tree->size = ref->size;                                                   \
+    /* Reset ref so that its clear is a no-op */                              \
+    ref->root = NULL;                                                         \
+    ref->size = 0;                                                            \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _move)(tree_t tree, tree_t ref)                                   \
+  {                                                                           \
+    M_ASSERT (tree != ref);                                                   \
+    M_C(name, _clear)(tree);                                                  \
+    M_C(name, _init_move)(tree, ref);                                         \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _swap)(tree_t tree1, tree_t tree2)                                \
+  {                                                                           \
+    M_4RT_CONTRACT(tree1);                                                    \
+    M_4RT_CONTRACT(tree2);                                                    \
+    M_SWAP(m_4rt_base_t *, tree1->root, tree2->root);                         \
+    M_SWAP(size_t, tree1->size, tree2->size);                                 \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _empty_p)(const tree_t tree)                                      \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    return tree->size == 0;                                                   \
+  }                                                                           \
+                                                                              \
+  static inline size_t                                                        \
+  M_C(name, _size)(const tree_t tree)                                         \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    return tree->size;                                                        \
+  }                                                                           \
+                                                                              \
+  /* Return the index in the compressed path of the node at 'depth'           \
+     of the first byte which differs from the key (or its length) */          \
+  static inline size_t                                                        \
+  M_C3(m_4rt_,name,_mismatch)(m_4rt_inner_t *in, const unsigned char kb[], size_t klen, size_t depth) \
+  {                                                                           \
+    size_t max = M_MIN((size_t) in->prefix_len, (size_t) M_4RT_MAX_PREFIX);   \
+    size_t i;                                                                 \
+    for(i = 0; i < max; i++) {                                                \
+      if (depth + i >= klen || in->prefix[i] != kb[depth + i]) return i;      \
+    }                                                                         \
+    if (in->prefix_len > M_4RT_MAX_PREFIX) {                                  \
+      /* Read the rest of the path from the key of any leaf below the node */ \
+      unsigned char buffer[M_KEY_BYTES_SIZE];                                 \
+      size_t llen;                                                            \
+      const unsigned char *lb = M_C3(m_4rt_,name,_leaf_bytes)(buffer, &llen, m_4rt_min_leaf(&in->base)); \
+      M_ASSERT (llen >= depth + in->prefix_len);                              \
+      for( ; i < in->prefix_len; i++) {                                       \
+        if (depth + i >= klen || lb[depth + i] != kb[depth + i]) return i;    \
+      }                                                                       \
+    }                                                                         \
+    return in->prefix_len;                                                    \
+  }                                                                           \
+                                                                              \
+  /* Return the leaf of the key or NULL */                                    \
+  static inline leaf_t *                                                      \
+  M_C3(m_4rt_,name,_find)(const tree_t tree, key_t const key)                 \
+  {                                                                           \
+    unsigned char kbuffer[M_KEY_BYTES_SIZE], lbuffer[M_KEY_BYTES_SIZE];       \
+    size_t klen, llen, depth = 0;                                             \
+    const unsigned char *kb = M_CALL_KEY_BYTES(key_oplist, kbuffer, &klen, key); \
+    m_4rt_base_t *b = tree->root;                                             \
+    while (b != NULL) {                                                       \
+      if (m_4rt_leaf_p(b)) {                                                  \
+        const unsigned char *lb = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, b); \
+        return llen == klen && memcmp(lb, kb, klen) == 0                      \
+          ? M_C3(m_4rt_,name,_to_leaf)(b) : NULL;                             \
+      }                                                                       \
+      m_4rt_inner_t *in = m_4rt_inner(b);                                     \
+      /* Optimistic check of the compressed path: the bytes which are         \
+         not stored in the node are checked with the key of the leaf */       \
+      if (depth + in->prefix_len > klen                                       \
+          || memcmp(in->prefix, kb + depth, M_MIN((size_t) in->prefix_len, (size_t) M_4RT_MAX_PREFIX)) != 0) \
+        return NULL;                                                          \
+      depth += in->prefix_len;                                                \
+      if (depth == klen) {                                                    \
+        b = in->leaf;                                                         \
+      } else {                                                                \
+        m_4rt_base_t **ref = m_4rt_find_child(in, kb[depth]);                 \
+        b = ref == NULL ? NULL : *ref;                                        \
+        depth++;                                                              \
+      }                                                                       \
+    }                                                                         \
+    return NULL;                                                              \
+  }                                                                           \
+                                                                              \
+  static inline value_t *                                                     \
+  M_C(name, _get)(const tree_t tree, key_t const key)                         \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    leaf_t *l = M_C3(m_4rt_,name,_find)(tree, key);                           \
+    return l == NULL ? NULL : &l->value;                                      \
+  }                                                                           \
+                                                                              \
+  static inline const value_t *                                               \
+  M_C(name, _cget)(const tree_t tree, key_t const key)                        \
+  {                                                                           \
+    return M_CONST_CAST(value_t, M_C(name, _get)(tree, key));                 \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _set_at)(tree_t tree, key_t const key, value_t const value)       \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    unsigned char kbuffer[M_KEY_BYTES_SIZE], lbuffer[M_KEY_BYTES_SIZE];       \
+    size_t klen, llen, depth = 0;                                             \
+    const unsigned char *kb = M_CALL_KEY_BYTES(key_oplist, kbuffer, &klen, key); \
+    m_4rt_base_t **ref = &tree->root;                                         \
+    while (true) {                                                            \
+      m_4rt_base_t *b = *ref;                                                 \
+      if (b == NULL) {                                                        \
+        *ref = M_C3(m_4rt_,name,_new_leaf)(key, value);                       \
+        break;                                                                \
+      }                                                                       \
+      if (m_4rt_leaf_p(b)) {                                                  \
+        const unsigned char *lb = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, b); \
+        if (llen == klen && memcmp(lb, kb, klen) == 0) {                      \
+          M_CALL_SET(value_oplist, M_C3(m_4rt_,name,_to_leaf)(b)->value, value); \
+          return;                                                             \
+        }                                                                     \
+        /* Replace the leaf by a node of the common part of both keys */      \
+        size_t i = depth;                                                     \
+        while (i < llen && i < klen && lb[i] == kb[i]) i++;                   \
+        m_4rt_inner_t *in = M_C3(m_4rt_,name,_new_node)(M_4RT_NODE4);         \
+        m_4rt_set_prefix(in, kb + depth, i - depth);                          \
+        m_4rt_base_t *n = M_C3(m_4rt_,name,_new_leaf)(key, value);            \
+        if (i == llen) in->leaf = b; else m_4rt_add_child(in, lb[i], b);      \
+        if (i == klen) in->leaf = n; else m_4rt_add_child(in, kb[i], n);      \
+        *ref = &in->base;                                                     \
+        break;                                                                \
+      }                                                                       \
+      m_4rt_inner_t *in = m_4rt_inner(b);                                     \
+      M_4RT_NODE_CONTRACT(in);                                                \
+      if (in->prefix_len > 0) {                                               \
+        size_t i = M_C3(m_4rt_,name,_mismatch)(in, kb, klen, depth);          \
+        if (i < in->prefix_len) {                                             \
+          /* Split the compressed path at the first different byte */         \
+          m_4rt_inner_t *top = M_C3(m_4rt_,name,_new_node)(M_4RT_NODE4);      \
+          m_4rt_set_prefix(top, kb + depth, i);                               \
+          size_t remain = in->prefix_len - i - 1;                             \
+          unsigned char c;                                                    \
+          if (in->prefix_len <= M_4RT_MAX_PREFIX) {                           \
+            c = in->prefix[i];                                                \
+            memmove(in->prefix, in->prefix + i + 1, remain);                  \
+          } else {                                                            \
+            const unsigned char *lb = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, m_4rt_min_leaf(b)); \
+            c = lb[depth + i];                                                \
+            memcpy(in->prefix, lb + depth + i + 1, M_MIN(remain, (size_t) M_4RT_MAX_PREFIX)); \
+          }                                                                   \
+          in->prefix_len = (uint32_t) remain;                                 \
+          m_4rt_add_child(top, c, b);                                         \
+          m_4rt_base_t *n = M_C3(m_4rt_,name,_new_leaf)(key, value);          \
+          if (depth + i == klen) top->leaf = n; else m_4rt_add_child(top, kb[depth + i], n); \
+          *ref = &top->base;                                                  \
+          break;                                                              \
+        }                                                                     \
+        depth += in->prefix_len;                                              \
+      }                                                                       \
+      if (depth == klen) {                                                    \
+        /* The key ends in this node */                                       \
+        if (in->leaf != NULL) {                                               \
+          M_CALL_SET(value_oplist, M_C3(m_4rt_,name,_to_leaf)(in->leaf)->value, value); \
+          return;                                                             \
+        }                                                                     \
+        in->leaf = M_C3(m_4rt_,name,_new_leaf)(key, value);                   \
+        break;                                                                \
+      }                                                                       \
+      m_4rt_base_t **child = m_4rt_find_child(in, kb[depth]);                 \
+      if (child != NULL) {                                                    \
+        ref = child;                                                          \
+        depth++;                                                              \
+        continue;                                                             \
+      }                                                                       \
+      if (m_4rt_full_p(in)) {                                                 \
+        /* Grow the node to the next type */                                  \
+        m_4rt_inner_t *g = M_C3(m_4rt_,name,_new_node)(in->base.type + 1U);   \
+        m_4rt_resize_node(g, in);                                             \
+        M_C3(m_4rt_,name,_del_node)(in);                                      \
+        *ref = &g->base;                                                      \
+        in = g;                                                               \
+      }                                                                       \
+      m_4rt_add_child(in, kb[depth], M_C3(m_4rt_,name,_new_leaf)(key, value)); \
+      break;                                                                  \
+    }                                                                         \
+    tree->size++;                                                             \
+    M_4RT_CONTRACT(tree);                                                     \
+  }                                                                           \
+                                                                              \
+  /* Shrink the node 'in' referenced by 'ref' after a removal */              \
+  static inline void                                                          \
+  M_C3(m_4rt_,name,_shrink)(m_4rt_base_t **ref, m_4rt_inner_t *in)            \
+  {                                                                           \
+    if (in->base.type == M_4RT_NODE4) {                                       \
+      if (in->num == 0) {                                                     \
+        /* Only the leaf of the node remains */                               \
+        M_ASSERT (in->leaf != NULL);                                          \
+        *ref = in->leaf;                                                      \
+        M_C3(m_4rt_,name,_del_node)(in);                                      \
+      } else if (in->num == 1 && in->leaf == NULL) {                          \
+        /* Merge the node with its only child (path compression) */           \
+        m_4rt_node4_t *n = M_4RT_CAST(m_4rt_node4_t, in);                     \
+        m_4rt_base_t *child = n->child[0];                                    \
+        if (!m_4rt_leaf_p(child)) {                                           \
+          m_4rt_merge_prefix(m_4rt_inner(child), in, n->key[0]);              \
+        }                                                                     \
+        *ref = child;                                                         \
+        M_C3(m_4rt_,name,_del_node)(in);                                      \
+      }                                                                       \
+    } else if (m_4rt_shrink_p(in)) {                                          \
+      m_4rt_inner_t *s = M_C3(m_4rt_,name,_new_node)(in->base.type - 1U);     \
+      m_4rt_resize_node(s, in);                                               \
+      M_C3(m_4rt_,name,_del_node)(in);                                        \
+      *ref = &s->base;                                                        \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _erase)(tree_t tree, key_t const key)                             \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    unsigned char kbuffer[M_KEY_BYTES_SIZE], lbuffer[M_KEY_BYTES_SIZE];       \
+    size_t klen, llen, depth = 0;                                             \
+    const unsigned char *kb = M_CALL_KEY_BYTES(key_oplist, kbuffer, &klen, key); \
+    m_4rt_base_t **ref = &tree->root, **pref = NULL;                          \
+    m_4rt_inner_t *parent = NULL;                                             \
+    unsigned char c = 0;                                                      \
+    while (*ref != NULL) {                                                    \
+      m_4rt_base_t *b = *ref;                                                 \
+      if (m_4rt_leaf_p(b)) {                                                  \
+        const unsigned char *lb = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, b); \
+        if (llen != klen || memcmp(lb, kb, klen) != 0)                        \
+          return false;                                                       \
+        if (parent == NULL) {                                                 \
+          tree->root = NULL;                                                  \
+        } else {                                                              \
+          if (ref == &parent->leaf) {                                         \
+            parent->leaf = NULL;                                              \
+          } else {                                                            \
+            m_4rt_remove_child(parent, c);                                    \
+          }                                                                   \
+          M_C3(m_4rt_,name,_shrink)(pref, parent);                            \
+        }                                                                     \
+        M_C3(m_4rt_,name,_free)(b);                                           \
+        tree->size--;                                                         \
+        M_4RT_CONTRACT(tree);                                                 \
+        return true;                                                          \
+      }                                                                       \
+      m_4rt_inner_t *in = m_4rt_inner(b);                                     \
+      /* Optimistic check of the compressed path (see _find) */               \
+      if (depth + in->prefix_len > klen                                       \
+          || memcmp(in->prefix, kb + depth, M_MIN((size_t) in->prefix_len, (size_t) M_4RT_MAX_PREFIX)) != 0) \
+        return false;                                                         \
+      depth += in->prefix_len;                                                \
+      pref = ref;                                                             \
+      parent = in;                                                            \
+      if (depth == klen) {                                                    \
+        ref = &in->leaf;                                                      \
+      } else {                                                                \
+        c = kb[depth];                                                        \
+        ref = m_4rt_find_child(in, c);                                        \
+        if (ref == NULL) return false;                                        \
+        depth++;                                                              \
+      }                                                                       \
+    }                                                                         \
+    return false;                                                             \
+  }                                                                           \
+                                                                              \
+  /* Return the leaf of the lowest key greater or equal than the key or NULL */ \
+  static inline m_4rt_base_t *                                                \
+  M_C3(m_4rt_,name,_lower_bound)(const tree_t tree, const unsigned char kb[], size_t klen) \
+  {                                                                           \
+    unsigned char lbuffer[M_KEY_BYTES_SIZE];                                  \
+    size_t llen, depth = 0;                                                   \
+    /* Sub-tree of the lowest keys greater than the path */                   \
+    m_4rt_base_t *b = tree->root, *greater = NULL;                            \
+    while (b != NULL) {                                                       \
+      if (m_4rt_leaf_p(b)) {                                                  \
+        const unsigned char *lb = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, b); \
+        if (m_4rt_cmp_bytes(lb, llen, kb, klen) >= 0) return b;               \
+        break;                                                                \
+      }                                                                       \
+      m_4rt_inner_t *in = m_4rt_inner(b);                                     \
+      const unsigned char *path = in->prefix;                                 \
+      if (in->prefix_len > M_4RT_MAX_PREFIX) {                                \
+        path = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, m_4rt_min_leaf(b)) + depth; \
+      }                                                                       \
+      int cmp = m_4rt_cmp_path(path, in->prefix_len, kb + depth, klen - depth); \
+      if (cmp > 0) return m_4rt_min_leaf(b);                                  \
+      if (cmp < 0) break;                                                     \
+      depth += in->prefix_len;                                                \
+      if (depth == klen) return m_4rt_min_leaf(b);                            \
+      m_4rt_base_t *g = m_4rt_greater_child(in, kb[depth]);                   \
+      if (g != NULL) greater = g;                                             \
+      m_4rt_base_t **ref = m_4rt_find_child(in, kb[depth]);                   \
+      b = ref == NULL ? NULL : *ref;                                          \
+      depth++;                                                                \
+    }                                                                         \
+    return m_4rt_min_leaf(greater);                                           \
+  }                                                                           \
+                                                                              \
+  /* Return the root of the sub-tree of the keys starting with the            \
+     given bytes (and its number of inner ancestors) or NULL */               \
+  static inline m_4rt_base_t *                                                \
+  M_C3(m_4rt_,name,_prefix_root)(const tree_t tree, const unsigned char kb[], size_t klen, unsigned *level) \
+  {                                                                           \
+    unsigned char lbuffer[M_KEY_BYTES_SIZE];                                  \
+    size_t llen, depth = 0;                                                   \
+    m_4rt_base_t *b = tree->root;                                             \
+    *level = 0;                                                               \
+    while (b != NULL) {                                                       \
+      if (m_4rt_leaf_p(b)) {                                                  \
+        const unsigned char *lb = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, b); \
+        return llen >= klen && memcmp(lb, kb, klen) == 0 ? b : NULL;          \
+      }                                                                       \
+      m_4rt_inner_t *in = m_4rt_inner(b);                                     \
+      const unsigned char *path = in->prefix;                                 \
+      if (in->prefix_len > M_4RT_MAX_PREFIX) {                                \
+        path = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, m_4rt_min_leaf(b)) + depth; \
+      }                                                                       \
+      for(size_t i = 0; i < in->prefix_len; i++) {                            \
+        if (depth + i == klen) return b;                                      \
+        if (path[i] != kb[depth + i]) return NULL;                            \
+      }                                                                       \
+      depth += in->prefix_len;                                                \
+      if (depth == klen) return b;                                            \
+      m_4rt_base_t **ref = m_4rt_find_child(in, kb[depth]);                   \
+      b = ref == NULL ? NULL : *ref;                                          \
+      depth++;                                                                \
+      (*level)++;                                                             \
+    }                                                                         \
+    return NULL;                                                              \
+  }                                                                           \
+
+/* Define the iterator functions of an adaptive radix tree */
+#define M_4RT_DEF_IT(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+                                                                              \
+  /* Set the path of the iterator to the path of the leaf                     \
+     from the root up to the level 'stop' */                                  \
+  static inline void                                                          \
+  M_C3(m_4rt_,name,_it_seek)(it_t it, m_4rt_base_t *leaf, unsigned stop)      \
+  {                                                                           \
+    unsigned char lbuffer[M_KEY_BYTES_SIZE];                                  \
+    size_t llen, depth = 0;                                                   \
+    const unsigned char *lb = M_C3(m_4rt_,name,_leaf_bytes)(lbuffer, &llen, leaf); \
+    m_4rt_base_t *b = it->tree->root;                                         \
+    unsigned level = 0;                                                       \
+    while (b != leaf && level <= stop) {                                      \
+      m_4rt_inner_t *in = m_4rt_inner(b);                                     \
+      unsigned pos;                                                           \
+      depth += in->prefix_len;                                                \
+      if (depth == llen) {                                                    \
+        /* The leaf of the node is the leaf */                                \
+        b = in->leaf;                                                         \
+        pos = 0;                                                              \
+      } else {                                                                \
+        pos = m_4rt_child_pos(in, lb[depth]) + 1;                             \
+        b = *m_4rt_find_child(in, lb[depth]);                                 \
+        depth++;                                                              \
+      }                                                                       \
+      it->node[level % M_4RT_MAX_STACK] = in;                                 \
+      it->pos[level % M_4RT_MAX_STACK] = pos + 1;                             \
+      level++;                                                                \
+    }                                                                         \
+    it->depth = level;                                                        \
+    it->low = level > M_4RT_MAX_STACK ? level - M_4RT_MAX_STACK : 0;          \
+    it->leaf = M_C3(m_4rt_,name,_to_leaf)(leaf);                              \
+  }                                                                           \
+                                                                              \
+  /* Move the iterator to the next leaf of the iterated sub-tree */           \
+  static inline void                                                          \
+  M_C3(m_4rt_,name,_it_advance)(it_t it)                                      \
+  {                                                                           \
+    while (it->depth > it->base) {                                            \
+      unsigned level = it->depth - 1;                                         \
+      if (level < it->low) {                                                  \
+        /* The level is not in the ring anymore: recompute it */              \
+        M_C3(m_4rt_,name,_it_seek)(it, &it->leaf->base, level);               \
+      }                                                                       \
+      m_4rt_inner_t *in = it->node[level % M_4RT_MAX_STACK];                  \
+      unsigned *p = &it->pos[level % M_4RT_MAX_STACK];                        \
+      if (*p == 0) {                                                          \
+        *p = 1;                                                               \
+        if (in->leaf != NULL) {                                               \
+          it->leaf = M_C3(m_4rt_,name,_to_leaf)(in->leaf);                    \
+          return;                                                             \
+        }                                                                     \
+      }                                                                       \
+      unsigned pos = *p - 1;                                                  \
+      m_4rt_base_t *child = m_4rt_next_child(in, &pos);                       \
+      if (child == NULL) {                                                    \
+        it->depth--;                                                          \
+        continue;                                                             \
+      }                                                                       \
+      *p = pos + 2;                                                           \
+      if (m_4rt_leaf_p(child)) {                                              \
+        it->leaf = M_C3(m_4rt_,name,_to_leaf)(child);                         \
+        return;                                                               \
+      }                                                                       \
+      /* Push the child in the path */                                        \
+      if (it->depth - it->low == M_4RT_MAX_STACK) it->low++;                  \
+      it->node[it->depth % M_4RT_MAX_STACK] = m_4rt_inner(child);             \
+      it->pos[it->depth % M_4RT_MAX_STACK] = 0;                               \
+      it->depth++;                                                            \
+    }                                                                         \
+    it->leaf = NULL;                                                          \
+  }                                                                           \
+                                                                              \
+  /* Set the iterator to the given leaf (or the end if NULL)                  \
+     iterating over the sub-tree at the given level */                        \
+  static inline void                                                          \
+  M_C3(m_4rt_,name,_it_init)(it_t it, const tree_t tree, m_4rt_base_t *leaf, unsigned base) \
+  {                                                                           \
+    it->tree = tree;                                                          \
+    it->depth = 0;                                                            \
+    it->low = 0;                                                              \
+    it->base = 0;                                                             \
+    it->leaf = NULL;                                                          \
+    if (leaf != NULL) {                                                       \
+      M_C3(m_4rt_,name,_it_seek)(it, leaf, UINT_MAX);                         \
+      it->base = base;                                                        \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it)(it_t it, const tree_t tree)                                  \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    M_C3(m_4rt_,name,_it_init)(it, tree, m_4rt_min_leaf(tree->root), 0);      \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it_end)(it_t it, const tree_t tree)                              \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    M_C3(m_4rt_,name,_it_init)(it, tree, NULL, 0);                            \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it_set)(it_t it, const it_t ref)                                 \
+  {                                                                           \
+    M_ASSERT (it != NULL && ref != NULL);                                     \
+    *it = *ref;                                                               \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _end_p)(const it_t it)                                            \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    return it->leaf == NULL;                                                  \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _it_equal_p)(const it_t it1, const it_t it2)                      \
+  {                                                                           \
+    M_ASSERT (it1 != NULL && it2 != NULL);                                    \
+    return it1->tree == it2->tree && it1->leaf == it2->leaf;                  \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _next)(it_t it)                                                   \
+  {                                                                           \
+    M_ASSERT (it != NULL && it->leaf != NULL);                                \
+    M_C3(m_4rt_,name,_it_advance)(it);                                        \
+  }                                                                           \
+                                                                              \
+  static inline itref_t *                                                     \
+  M_C(name, _ref)(it_t it)                                                    \
+  {                                                                           \
+    M_ASSERT (it != NULL && it->leaf != NULL);                                \
+    it->pair.key_ptr = &it->leaf->key;                                        \
+    it->pair.value_ptr = &it->leaf->value;                                    \
+    return &it->pair;                                                         \
+  }                                                                           \
+                                                                              \
+  static inline const itref_t *                                               \
+  M_C(name, _cref)(it_t it)                                                   \
+  {                                                                           \
+    return M_CONST_CAST(itref_t, M_C(name, _ref)(it));                        \
+  }                                                                           \
+                                                                              \
+  /* Set the iterator to the lowest key greater or equal than the key */      \
+  static inline void                                                          \
+  M_C(name, _it_from)(it_t it, const tree_t tree, key_t const key)            \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    unsigned char kbuffer[M_KEY_BYTES_SIZE];                                  \
+    size_t klen;                                                              \
+    const unsigned char *kb = M_CALL_KEY_BYTES(key_oplist, kbuffer, &klen, key); \
+    m_4rt_base_t *leaf = M_C3(m_4rt_,name,_lower_bound)(tree, kb, klen);      \
+    M_C3(m_4rt_,name,_it_init)(it, tree, leaf, 0);                            \
+  }                                                                           \
+                                                                              \
+  /* Set the iterator to iterate only over the keys whose bytes               \
+     start with the bytes of the given key */                                 \
+  static inline void                                                          \
+  M_C(name, _it_prefix)(it_t it, const tree_t tree, key_t const key)          \
+  {                                                                           \
+    M_4RT_CONTRACT(tree);                                                     \
+    unsigned char kbuffer[M_KEY_BYTES_SIZE];                                  \
+    size_t klen;                                                              \
+    unsigned level;                                                           \
+    const unsigned char *kb = M_CALL_KEY_BYTES(key_oplist, kbuffer, &klen, key); \
+    m_4rt_base_t *b = M_C3(m_4rt_,name,_prefix_root)(tree, kb, klen, &level); \
+    M_C3(m_4rt_,name,_it_init)(it, tree, m_4rt_min_leaf(b), level);           \
+  }                                                                           \
+
+/* Define the equal function of an adaptive radix tree if possible */
+#define M_4RT_DEF_EQUAL(name, key_t, key_oplist, value_t, value_oplist, tree_t, leaf_t, it_t, itref_t) \
+  M_IF_METHOD_BOTH(EQUAL, key_oplist, value_oplist)(                          \
+  static inline bool M_C(name,_equal_p)(const tree_t t1, const tree_t t2) {   \
+    M_4RT_CONTRACT(t1);                                                       \
+    M_4RT_CONTRACT(t2);                                                       \
+    if (t1->size != t2->size) return false;                                   \
+    it_t it1;                                                                 \
+    it_t it2;                                                                 \
+    /* Both trees have the same order: compare them in lockstep */            \
+    for(M_C(name, _it)(it1, t1), M_C(name, _it)(it2, t2);                     \
+        !M_C(name, _end_p)(it1);                                              \
+        M_C(name, _next)(it1), M_C(name, _next)(it2)) {                       \
+      if (!M_CALL_EQUAL(key_oplist, it1->leaf->key, it2->leaf->key))          \
+        return false;                                                         \
+      if (!M_CALL_EQUAL(value_oplist, it1->leaf->value, it2->leaf->value))    \
+        return false;                                                         \
+    }                                                                         \
+    return true;                                                              \
+  }                                                                           \
+  , /* NO EQUAL METHOD */ )                                                   \
+
+
+/********************************** INTERNAL ************************************/
+
+#if M_USE_SMALL_NAME
+#define ART_DEF2 M_ART_DEF2
+#define ART_DEF2_AS M_ART_DEF2_AS
+#define ART_OPLIST2 M_ART_OPLIST2
+#endif
+
+#endif
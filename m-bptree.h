@@ -48,8 +48,8 @@
 #define M_BPTREE_DEF2_AS(name, name_t, it_t, itref_t, N, key_type, ...)       \
   M_BEGIN_PROTECTED_CODE                                                      \
   M_BPTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                 \
-                 ((name, N, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 1, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ), \
-                  (name, N, key_type,                                     __VA_ARGS__,                                        1, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ))) \
+                 ((name, N, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 1, 0, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ), \
+                  (name, N, key_type,                                     __VA_ARGS__,                                        1, 0, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ))) \
   M_END_PROTECTED_CODE
 
 
@@ -66,8 +66,8 @@
 #define M_BPTREE_DEF_AS(name, name_t, it_t, N, ...)                           \
   M_BEGIN_PROTECTED_CODE                                                      \
   M_BPTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                 \
-                 ((name, N, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 0, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ), \
-                  (name, N, __VA_ARGS__,                                        __VA_ARGS__,                                        0, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ))) \
+                 ((name, N, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 0, 0, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ), \
+                  (name, N, __VA_ARGS__,                                        __VA_ARGS__,                                        0, 0, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ))) \
   M_END_PROTECTED_CODE
 
 
@@ -94,8 +94,8 @@
 #define M_BPTREE_MULTI_DEF2_AS(name, name_t, it_t, itref_t, N, key_type, ...) \
   M_BEGIN_PROTECTED_CODE                                                      \
   M_BPTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                 \
-                 ((name, N, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 1, 1, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ), \
-                  (name, N, key_type, __VA_ARGS__,                                                                            1, 1, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ))) \
+                 ((name, N, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 1, 1, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ), \
+                  (name, N, key_type, __VA_ARGS__,                                                                            1, 1, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ))) \
   M_END_PROTECTED_CODE
 
 
@@ -114,11 +114,60 @@
 #define M_BPTREE_MULTI_DEF_AS(name, name_t, it_t, N, ...)                     \
   M_BEGIN_PROTECTED_CODE                                                      \
   M_BPTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                 \
-                 ((name, N, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 0, 1, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ), \
-                  (name, N, __VA_ARGS__,                                        __VA_ARGS__,                                        0, 1, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ))) \
+                 ((name, N, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 0, 1, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ), \
+                  (name, N, __VA_ARGS__,                                        __VA_ARGS__,                                        0, 1, 0, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ))) \
   M_BEGIN_PROTECTED_CODE
 
 
+/* Define a B+tree of size 'N' that maps a 'key' to a 'value',
+   keeping the number of elements of each sub-tree in its nodes
+   (order statistic: rank, select and count of a range in O(log n)),
+   with its associated functions.
+   USAGE:
+   BPTREE_RANK_DEF2(name, N, key_t, key_oplist, value_t, value_oplist)
+   OR
+   BPTREE_RANK_DEF2(name, N, key_t, value_t)
+*/
+#define M_BPTREE_RANK_DEF2(name, N, key_type, ...)                            \
+  M_BPTREE_RANK_DEF2_AS(name, M_C(name,_t), M_C(name,_it_t), M_C(name, _itref_t), N, key_type, __VA_ARGS__)
+
+
+/* Define a B+tree of size 'N' that maps a 'key' to a 'value',
+   keeping the number of elements of each sub-tree in its nodes,
+   as the given name name_t with its associated functions.
+   USAGE:
+   BPTREE_RANK_DEF2_AS(name, name_t, it_t, itref_t, N, key_t, key_oplist, value_t, value_oplist)
+   OR
+   BPTREE_RANK_DEF2_AS(name, name_t, it_t, itref_t, N, key_t, value_t)
+*/
+#define M_BPTREE_RANK_DEF2_AS(name, name_t, it_t, itref_t, N, key_type, ...)  \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_BPTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                 \
+                 ((name, N, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 1, 0, 1, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ), \
+                  (name, N, key_type,                                     __VA_ARGS__,                                        1, 0, 1, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, itref_t ))) \
+  M_END_PROTECTED_CODE
+
+
+/* Define a B+tree of a given type, of size N,
+   keeping the number of elements of each sub-tree in its nodes,
+   with its associated functions
+   USAGE: BPTREE_RANK_DEF(name, N, type, [, oplist_of_the_type]) */
+#define M_BPTREE_RANK_DEF(name, N, ...)                                       \
+  M_BPTREE_RANK_DEF_AS(name, M_C(name,_t), M_C(name,_it_t), N, __VA_ARGS__)
+
+
+/* Define a B+tree of a given type, of size N,
+   keeping the number of elements of each sub-tree in its nodes,
+   as the given name name_t with its associated functions
+   USAGE: BPTREE_RANK_DEF_AS(name, name_t, it_t, N, type, [, oplist_of_the_type]) */
+#define M_BPTREE_RANK_DEF_AS(name, name_t, it_t, N, ...)                      \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_BPTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                 \
+                 ((name, N, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 0, 0, 1, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ), \
+                  (name, N, __VA_ARGS__,                                        __VA_ARGS__,                                        0, 0, 1, name_t, M_C(name, _node_ct), M_C(name, _pit_ct), it_t, M_C(name, _itref_ct)  ))) \
+  M_END_PROTECTED_CODE
+
+
 /* Define the oplist of a B+TREE used as a set of type (from BPTREE_DEF).
    USAGE: BPTREE_OPLIST(name [, oplist_of_the_type])
    NOTE: IT_REF is not exported so that the container appears as not modifiable
@@ -302,20 +351,28 @@
  */
 #define M_BPTR33_MAX_STACK ((int)(1 + CHAR_BIT*sizeof (size_t)))
 
+/* Test if the CMP operator of the key oplist is the one of the C basic types
+   (integer, float, pointer). In which case, the search of a key within a node
+   is performed by counting the keys lower than the searched key without
+   any branch, so that the compiler can vectorize the scan of the node. */
+#define M_BPTR33_BASIC_CMP_P(key_oplist)                                      \
+  M_OR(M_KEYWORD_P(M_CMP_BASIC, M_GET_CMP key_oplist),                        \
+       M_KEYWORD_P(M_CMP_DEFAULT, M_GET_CMP key_oplist))
+
 /* Deferred evaluation for the b+tree definition,
    so that all arguments are evaluated before further expansion */
 #define M_BPTR33_DEF_P1(arg) M_ID( M_BPTR33_DEF_P2 arg )
 
 /* Validate the key oplist before going further */
-#define M_BPTR33_DEF_P2(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, tree_t, node_t, pit_t, it_t, subtype_t) \
-  M_IF_OPLIST(key_oplist)(M_BPTR33_DEF_P3, M_BPTR33_DEF_FAILURE)(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, tree_t, node_t, pit_t, it_t, subtype_t)
+#define M_BPTR33_DEF_P2(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, isRank, tree_t, node_t, pit_t, it_t, subtype_t) \
+  M_IF_OPLIST(key_oplist)(M_BPTR33_DEF_P3, M_BPTR33_DEF_FAILURE)(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, isRank, tree_t, node_t, pit_t, it_t, subtype_t)
 
 /* Validate the value oplist before going further */
-#define M_BPTR33_DEF_P3(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, tree_t, node_t, pit_t, it_t, subtype_t) \
-  M_IF_OPLIST(value_oplist)(M_BPTR33_DEF_P4, M_BPTR33_DEF_FAILURE)(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, tree_t, node_t, pit_t, it_t, subtype_t)
+#define M_BPTR33_DEF_P3(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, isRank, tree_t, node_t, pit_t, it_t, subtype_t) \
+  M_IF_OPLIST(value_oplist)(M_BPTR33_DEF_P4, M_BPTR33_DEF_FAILURE)(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, isRank, tree_t, node_t, pit_t, it_t, subtype_t)
 
 /* Stop processing with a compilation failure */
-#define M_BPTR33_DEF_FAILURE(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, tree_t, node_t, pit_t, it_t, subtype_t) \
+#define M_BPTR33_DEF_FAILURE(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, isRank, tree_t, node_t, pit_t, it_t, subtype_t) \
   M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(BPTREE*_DEF): one of the given argument is not a valid oplist: " M_AS_STR(key_oplist) " / " M_AS_STR(value_oplist))
 
 /* Internal b+tree definition
@@ -327,13 +384,14 @@
    - value_oplist: oplist of the value type of the elements of the container
    - isMap: true if map, false if set
    - isMulti: true if multimap/multiset, false otherwise
+   - isRank: true if the nodes keep the number of elements of their sub-tree
    - tree_t: alias for the type of the container
    - it_t: alias for the iterator of the container
    - node_t: alias for internal node
    - pit_t: alias for internal parent iterator
    - subtype_t: alias for the type referenced by the iterator
  */
-#define M_BPTR33_DEF_P4(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, tree_t, node_t, pit_t, it_t, subtype_t) \
+#define M_BPTR33_DEF_P4(name, N, key_t, key_oplist, value_t, value_oplist, isMap, isMulti, isRank, tree_t, node_t, pit_t, it_t, subtype_t) \
                                                                               \
   M_IF(isMap)(                                                                \
     /* Type returned by the iterator. Due to having key and value             \
@@ -354,6 +412,7 @@
    */                                                                         \
   typedef struct M_C(name, _node_s) {                                         \
     int    num;           /* Abs=Number of keys. Sign <0 is leaf */           \
+    M_IF(isRank)(size_t count; /* Number of elements of a non-leaf sub-tree */,) \
     key_t  key[N+1];      /* We can temporary push one more key */            \
     struct M_C(name, _node_s) *next;  /* next node reference */               \
     union  M_C(name, _kind_s) {       /* either value or pointer to other nodes */ \
@@ -366,6 +425,7 @@
   typedef struct M_C(name, _s) {                                              \
     node_t root;                                                              \
     size_t size;                                                              \
+    M_ALL0CATOR_FIELD(key_oplist) /* Allocator (if ALLOCATOR method) */       \
   } tree_t[1];                                                                \
   typedef struct M_C(name, _s) *M_C(name, _ptr);                              \
   typedef const struct M_C(name, _s) *M_C(name, _srcptr);                     \
@@ -395,11 +455,13 @@
                                                                               \
   /* Allocate a new node */                                                   \
   /* TODO: Can be specialized to alloc for leaf or for non leaf */            \
-  static inline node_t M_C(name, _new_node)(void)                             \
+  /* (through the allocator of the tree if ALLOCATOR is defined) */           \
+  static inline node_t M_C(name, _new_node)(const tree_t b)                   \
   {                                                                           \
     M_STATIC_ASSERT(N >= 2, M_LIB_ILLEGAL_PARAM,                              \
           "Number of items per node shall be >= 2.");                         \
-    node_t n = M_CALL_NEW(key_oplist, struct M_C(name, _node_s));             \
+    (void) b; /* unused if no ALLOCATOR */                                    \
+    node_t n = M_CALL_NEW_CTX(key_oplist, b->allocator, struct M_C(name, _node_s)); \
     if (M_UNLIKELY (n == NULL)) {                                             \
       M_MEMORY_FULL(sizeof (node_t));                                         \
       M_ASSERT (0);                                                           \
@@ -409,13 +471,40 @@
     return n;                                                                 \
   }                                                                           \
                                                                               \
+  /* Free a node */                                                           \
+  static inline void M_C(name, _del_node)(const tree_t b, node_t n)           \
+  {                                                                           \
+    (void) b; /* unused if no ALLOCATOR */                                    \
+    M_CALL_DEL_CTX(key_oplist, b->allocator, struct M_C(name, _node_s), n);   \
+  }                                                                           \
+                                                                              \
   static inline void M_C(name, _init)(tree_t b)                               \
   {                                                                           \
-    b->root = M_C(name, _new_node)();                                         \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(b->allocator = M_GET_ALLOCATOR key_oplist;, ) \
+    b->root = M_C(name, _new_node)(b);                                        \
     b->size = 0;                                                              \
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
   }                                                                           \
                                                                               \
+  M_IF_METHOD(ALLOCATOR, key_oplist)(                                         \
+  static inline void                                                          \
+  M_C(name, _init_allocator)(tree_t b, const m_allocator_t *allocator)        \
+  {                                                                           \
+    M_ASSERT (allocator != NULL);                                             \
+    b->allocator = allocator;                                                 \
+    b->root = M_C(name, _new_node)(b);                                        \
+    b->size = 0;                                                              \
+    M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
+  }                                                                           \
+                                                                              \
+  static inline const m_allocator_t *                                         \
+  M_C(name, _allocator)(const tree_t b)                                       \
+  {                                                                           \
+    M_ASSERT (b != NULL);                                                     \
+    return b->allocator;                                                      \
+  }                                                                           \
+  , /* No ALLOCATOR */ )                                                      \
+                                                                              \
   static inline bool M_C(name, _is_leaf)(const node_t n)                      \
   {                                                                           \
     /* We consider the empty node as a leaf */                                \
@@ -432,6 +521,51 @@
     return num;                                                               \
   }                                                                           \
                                                                               \
+  M_IF(isRank)(                                                               \
+  /* Return the number of elements of the sub-tree of the node */             \
+  static inline size_t M_C(name, _get_count)(const node_t n)                  \
+  {                                                                           \
+    return M_C(name, _is_leaf)(n) ? (size_t) -n->num : n->count;              \
+  }                                                                           \
+                                                                              \
+  /* Compute the number of elements of the sub-tree of a non-leaf node */     \
+  static inline void M_C(name, _update_count)(node_t n)                       \
+  {                                                                           \
+    M_ASSERT (!M_C(name, _is_leaf)(n));                                       \
+    size_t count = 0;                                                         \
+    for(int i = 0; i <= n->num; i++) {                                        \
+      count += M_C(name, _get_count)(n->kind.node[i]);                        \
+    }                                                                         \
+    n->count = count;                                                         \
+  }                                                                           \
+  , /* No rank */)                                                            \
+                                                                              \
+  /* Return the index of the first key of the node 'n' which is greater       \
+     or equal than 'key' among its 'num' first keys (aka lower bound) */      \
+  static inline int                                                           \
+  M_C(name, _search_in_node)(const node_t n, int num, key_t const key)        \
+  {                                                                           \
+    M_ASSERT (0 <= num && num <= N);                                          \
+    int i = 0;                                                                \
+    M_IF(M_BPTR33_BASIC_CMP_P(key_oplist))(                                   \
+      /* As keys are sorted, the lower bound is the number of keys            \
+         lower than 'key'. The loop has no branch and can be vectorized */    \
+      for(int j = 0; j < num; j++) {                                          \
+        i += (n->key[j] < key);                                               \
+      }                                                                       \
+    ,                                                                         \
+      /* Linear search is usually faster than binary search for               \
+         B+TREE (due to cache effect). If a binary tree is faster for         \
+         the choosen type and size , it probably means that the               \
+         size of B+TREE is too big and should be reduced. */                  \
+      for( ; i < num; i++) {                                                  \
+        if (M_CALL_CMP(key_oplist, key, n->key[i]) <= 0)                      \
+          break;                                                              \
+      }                                                                       \
+    )                                                                         \
+    return i;                                                                 \
+  }                                                                           \
+                                                                              \
   static inline void M_C(name, _reset)(tree_t b)                              \
   {                                                                           \
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
@@ -464,7 +598,7 @@
         next = n->next;                                                       \
         if (i != 0) {                                                         \
           /* Free the node if non root */                                     \
-          M_CALL_DEL(key_oplist, n);                                          \
+          M_C(name, _del_node)(b, n);                                         \
         }                                                                     \
         n = next;                                                             \
       }                                                                       \
@@ -480,16 +614,17 @@
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
     M_C(name, _reset)(b);                                                     \
     /* Once the tree is clean, only the root remains */                       \
-    M_CALL_DEL(key_oplist, b->root);                                          \
+    M_C(name, _del_node)(b, b->root);                                         \
     b->root = NULL;                                                           \
   }                                                                           \
                                                                               \
   /* Copy recursively the node 'o' of root node 'root' */                     \
-  static inline node_t M_C(name, _copy_node)(const node_t o, const node_t root) \
+  static inline node_t M_C(name, _copy_node)(const tree_t b, const node_t o, const node_t root) \
   {                                                                           \
-    node_t n = M_C(name, _new_node)();                                        \
+    node_t n = M_C(name, _new_node)(b);                                       \
     /* Set default number of keys and type to copy */                         \
     n->num = o->num;                                                          \
+    M_IF(isRank)(n->count = o->count;,)                                       \
     /* By default it is not linked to its brother.                            \
        Only the parent of this node can do it. It is fixed by it */           \
     n->next = NULL;                                                           \
@@ -509,7 +644,7 @@
       /* Copy recursively the associated nodes if it is not a leaf */         \
       for(int i = 0; i <= num; i++) {                                         \
         M_ASSERT(o->kind.node[i] != root);                                    \
-        n->kind.node[i] = M_C(name, _copy_node)(o->kind.node[i], root);       \
+        n->kind.node[i] = M_C(name, _copy_node)(b, o->kind.node[i], root);    \
       }                                                                       \
       /* The copied nodes don't have their next field correct */              \
       /* Fix the next field for the copied nodes */                           \
@@ -535,8 +670,9 @@
   {                                                                           \
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, o);                             \
     M_ASSERT (b != NULL);                                                     \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(b->allocator = o->allocator;, )        \
     /* Just copy recursively the root node */                                 \
-    b->root = M_C(name, _copy_node)(o->root, o->root);                        \
+    b->root = M_C(name, _copy_node)(b, o->root, o->root);                     \
     b->size = o->size;                                                        \
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
   }                                                                           \
@@ -545,8 +681,12 @@
   {                                                                           \
     /* NOTE: We could reuse the already allocated nodes of 'b'.               \
        Not sure if it worth the effort */                                     \
+    if (M_UNLIKELY (b == o)) return;                                          \
     M_C(name, _clear)(b);                                                     \
-    M_C(name, _init_set)(b, o);                                               \
+    /* Keep the allocator of the tree */                                      \
+    b->root = M_C(name, _copy_node)(b, o->root, o->root);                     \
+    b->size = o->size;                                                        \
+    M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
   }                                                                           \
                                                                               \
   static inline bool M_C(name, _empty_p)(const tree_t b)                      \
@@ -570,16 +710,8 @@
     /* Go down the tree while searching for key */                            \
     while (!M_C(name, _is_leaf)(n)) {                                         \
       M_ASSERT (np <= M_BPTR33_MAX_STACK);                                    \
-      int i, hi = n->num;                                                     \
-      M_ASSERT (hi > 0);                                                      \
-      /* Linear search is usually faster than binary search for               \
-         B+TREE (due to cache effect). If a binary tree is faster for         \
-         the choosen type and size , it probably means that the               \
-         size of B+TREE is too big and should be reduced. */                  \
-      for(i = 0; i < hi; i++) {                                               \
-        if (M_CALL_CMP(key_oplist, key, n->key[i]) <= 0)                      \
-          break;                                                              \
-      }                                                                       \
+      M_ASSERT (n->num > 0);                                                  \
+      int i = M_C(name, _search_in_node)(n, n->num, key);                     \
       /* Update the Parent iterator */                                        \
       pit->parent[np++] = n;                                                  \
       /* Select the new node to go down to */                                 \
@@ -597,15 +729,12 @@
     pit_t pit;                                                                \
     /* Get the leaf node where the key can be */                              \
     node_t n = M_C(name, _search_for_leaf)(pit, b, key);                      \
-    int cmp = 0;                                                              \
     M_BPTR33_NODE_CONTRACT(N, isMulti, key_oplist, n, b->root);               \
     /* Search in the leaf for key */                                          \
-    for(int i = 0; cmp >= 0 && i < -n->num; i++) {                            \
-      cmp = M_CALL_CMP(key_oplist, key, n->key[i]);                           \
-      if (cmp == 0) {                                                         \
-        /* Return the value if MAP mode or the key if SET mode */             \
-        return M_IF(isMap)(&n->kind.value[i],&n->key[i]);                     \
-      }                                                                       \
+    int i = M_C(name, _search_in_node)(n, -n->num, key);                      \
+    if (i < -n->num && M_CALL_CMP(key_oplist, key, n->key[i]) == 0) {         \
+      /* Return the value if MAP mode or the key if SET mode */               \
+      return M_IF(isMap)(&n->kind.value[i],&n->key[i]);                       \
     }                                                                         \
     /* Key not found */                                                       \
     return NULL;                                                              \
@@ -621,24 +750,21 @@
                                         M_IF(isMap)( M_DEFERRED_COMMA value_t const value,) ) \
   {                                                                           \
     M_ASSERT (M_C(name, _is_leaf)(n));                                        \
-    int i, num = M_C(name, _get_num)(n);                                      \
+    int num = M_C(name, _get_num)(n);                                         \
     M_ASSERT (num <= N);                                                      \
     /* Search for the key in the node n (a leaf) for insertion */             \
-    for(i = 0; i < num; i++) {                                                \
-      int cmp = M_CALL_CMP(key_oplist, key, n->key[i]);                       \
-      if (cmp <= 0) {                                                         \
-        M_IF(isMulti)( /* Nothing to do : fallthrough */,                     \
-          /* Update value if keys are equal */                                \
-          if (M_UNLIKELY (cmp == 0)) {                                        \
-            M_IF(isMap)(M_CALL_SET(value_oplist, n->kind.value[i], value);,)  \
-            return -1;                                                        \
-          }                                                                   \
-        )                                                                     \
-        /* Move tables to make space for insertion */                         \
-        memmove(&n->key[i+1], &n->key[i], sizeof(key_t)*(unsigned int)(num-i)); \
-        M_IF(isMap)(memmove(&n->kind.value[i+1], &n->kind.value[i], sizeof(value_t)*(unsigned int)(num-i));,) \
-        break;                                                                \
-      }                                                                       \
+    int i = M_C(name, _search_in_node)(n, num, key);                          \
+    if (i < num) {                                                            \
+      M_IF(isMulti)( /* Nothing to do : fallthrough */,                       \
+        /* Update value if keys are equal */                                  \
+        if (M_UNLIKELY (M_CALL_CMP(key_oplist, key, n->key[i]) == 0)) {       \
+          M_IF(isMap)(M_CALL_SET(value_oplist, n->kind.value[i], value);,)    \
+          return -1;                                                          \
+        }                                                                     \
+      )                                                                       \
+      /* Move tables to make space for insertion */                           \
+      memmove(&n->key[i+1], &n->key[i], sizeof(key_t)*(unsigned int)(num-i)); \
+      M_IF(isMap)(memmove(&n->kind.value[i+1], &n->kind.value[i], sizeof(value_t)*(unsigned int)(num-i));,) \
     }                                                                         \
     /* Insert key & value if MAP mode */                                      \
     M_CALL_INIT_SET(key_oplist, n->key[i], key);                              \
@@ -688,6 +814,10 @@
       return;                                                                 \
     }                                                                         \
     b->size ++;                                                               \
+    /* All the parents of the leaf have one more element */                   \
+    M_IF(isRank)(for(int j = 0; j < pit->num; j++) {                          \
+        pit->parent[j]->count ++;                                             \
+      },)                                                                     \
     /* Most likely case: leaf can accept key */                               \
     int num = -leaf->num;                                                     \
     M_ASSERT (num > 0);                                                       \
@@ -702,7 +832,7 @@
     /* leaf is full: need to slip the leaf in two */                          \
     int nnum = (N + 1) / 2;                                                   \
     num = N + 1 - nnum;                                                       \
-    node_t nleaf = M_C(name, _new_node)();                                    \
+    node_t nleaf = M_C(name, _new_node)(b);                                   \
     /* Move half objects to the new node */                                   \
     memmove(&nleaf->key[0], &leaf->key[num], sizeof(key_t)*(unsigned int)nnum); \
     M_IF(isMap)(memmove(&nleaf->kind.value[0], &leaf->kind.value[num], sizeof(value_t)*(unsigned int)nnum);,) \
@@ -717,12 +847,13 @@
     while (true) {                                                            \
       if (pit->num == 0) {                                                    \
         /* We reach root ==> Need to increase the height of the tree.*/       \
-        node_t parent = M_C(name, _new_node)();                               \
+        node_t parent = M_C(name, _new_node)(b);                              \
         parent->num = 1;                                                      \
         /* TBC: DO_INIT_MOVE instead ? If key was in a node !*/               \
         M_CALL_INIT_SET(key_oplist, parent->key[0], *key_ptr);                \
         parent->kind.node[0] = leaf;                                          \
         parent->kind.node[1] = nleaf;                                         \
+        M_IF(isRank)(parent->count = b->size;,)                               \
         b->root = parent;                                                     \
         M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                         \
         return;                                                               \
@@ -743,7 +874,7 @@
       int nnp = N / 2;                                                        \
       int np = N - nnp;                                                       \
       M_ASSERT (nnp > 0 && np > 0 && nnp+np+1 == N+1);                        \
-      node_t nparent = M_C(name, _new_node)();                                \
+      node_t nparent = M_C(name, _new_node)(b);                               \
       /* Move half items to new node (Like a classic B-TREE)                  \
          and the median key to the grand-parent*/                             \
       memmove(&nparent->key[0], &parent->key[np+1], sizeof(key_t)*(unsigned int)nnp); \
@@ -752,6 +883,8 @@
       nparent->num = nnp;                                                     \
       nparent->next = parent->next;                                           \
       parent->next = nparent;                                                 \
+      M_IF(isRank)(M_C(name, _update_count)(parent);                          \
+                   M_C(name, _update_count)(nparent);,)                       \
       M_BPTR33_NODE_CONTRACT(N, isMulti, key_oplist, parent, b->root);        \
       M_BPTR33_NODE_CONTRACT(N, isMulti, key_oplist, nparent, b->root);       \
       /* Prepare for the next step */                                         \
@@ -784,17 +917,15 @@
   {                                                                           \
     M_ASSERT(M_C(name, _is_leaf)(n));                                         \
     const int num = M_C(name, _get_num)(n);                                   \
-    for(int i = 0; i < num; i++) {                                            \
-      const int cmp = M_CALL_CMP(key_oplist, key, n->key[i]);                 \
-      if (cmp == 0) {                                                         \
-        /* found key ==> delete it */                                         \
-        M_CALL_CLEAR(key_oplist, n->key[i]);                                  \
-        M_IF(isMap)(M_CALL_CLEAR(value_oplist, n->kind.value[i]);,)           \
-        memmove(&n->key[i], &n->key[i+1], sizeof(key_t)*(unsigned int)(num-1-i)); \
-        M_IF(isMap)(memmove(&n->kind.value[i], &n->kind.value[i+1], sizeof(value_t)*(unsigned int)(num-1-i));,) \
-        n->num -= -1; /* decrease number as num is < 0 */                     \
-        return i;                                                             \
-      }                                                                       \
+    const int i = M_C(name, _search_in_node)(n, num, key);                    \
+    if (i < num && M_CALL_CMP(key_oplist, key, n->key[i]) == 0) {             \
+      /* found key ==> delete it */                                           \
+      M_CALL_CLEAR(key_oplist, n->key[i]);                                    \
+      M_IF(isMap)(M_CALL_CLEAR(value_oplist, n->kind.value[i]);,)             \
+      memmove(&n->key[i], &n->key[i+1], sizeof(key_t)*(unsigned int)(num-1-i)); \
+      M_IF(isMap)(memmove(&n->kind.value[i], &n->kind.value[i+1], sizeof(value_t)*(unsigned int)(num-1-i));,) \
+      n->num -= -1; /* decrease number as num is < 0 */                       \
+      return i;                                                               \
     }                                                                         \
     return -1; /* Not found */                                                \
   }                                                                           \
@@ -827,6 +958,9 @@
       right->kind.node[0] = left->kind.node[num_left];                        \
       right->num = num_right + 1;                                             \
       left->num = num_left - 1;                                               \
+      M_IF(isRank)(size_t count = M_C(name, _get_count)(right->kind.node[0]); \
+                   right->count += count;                                     \
+                   left->count -= count;,)                                    \
       /* left[n-1] is move to parent[k] (clear). left[n-1] is therefore clear */ \
       memmove(&parent->key[k], &left->key[num_left-1], sizeof (key_t));       \
     }                                                                         \
@@ -863,12 +997,15 @@
       memmove (&right->kind.node[0], &right->kind.node[1], sizeof(node_t)*(unsigned int)num_right); \
       right->num = num_right - 1;                                             \
       left->num = num_left + 1;                                               \
+      M_IF(isRank)(size_t count = M_C(name, _get_count)(left->kind.node[num_left+1]); \
+                   left->count += count;                                      \
+                   right->count -= count;,)                                   \
     }                                                                         \
     M_ASSERT (right->num != 0);                                               \
     M_ASSERT (left->num != 0);                                                \
   }                                                                           \
                                                                               \
-  static inline void M_C(name, _merge_node)(node_t parent, int k, bool leaf)  \
+  static inline void M_C(name, _merge_node)(const tree_t b, node_t parent, int k, bool leaf) \
   {                                                                           \
     M_ASSERT (parent != NULL && !M_C(name, _is_leaf)(parent));                \
     M_ASSERT (0 <= k && k < M_C(name, _get_num(parent)));                     \
@@ -891,9 +1028,10 @@
       memmove(&left->kind.node[num_left+1], &right->kind.node[0], sizeof(node_t)*(unsigned int)(num_right+1)); \
       M_CALL_INIT_SET(key_oplist, left->key[num_left], parent->key[k]);       \
       left->num = num_left + 1 + num_right;                                   \
+      M_IF(isRank)(left->count += right->count;,)                             \
     }                                                                         \
     left->next = right->next;                                                 \
-    M_CALL_DEL(key_oplist, right);                                            \
+    M_C(name, _del_node)(b, right);                                           \
     /* remove k'th key from the parent */                                     \
     M_CALL_CLEAR(key_oplist, parent->key[k]);                                 \
     memmove(&parent->key[k], &parent->key[k+1], sizeof(key_t)*(unsigned int)(num_parent - k - 1)); \
@@ -926,6 +1064,10 @@
     if (k < 0) return false;                                                  \
     /* Remove one item from the B+TREE */                                     \
     b->size --;                                                               \
+    /* All the parents of the leaf have one less element */                   \
+    M_IF(isRank)(for(int j = 0; j < pit->num; j++) {                          \
+        pit->parent[j]->count --;                                             \
+      },)                                                                     \
     /* If number of keys greater than N>2 or root ==> Nothing more to do */   \
     if (M_LIKELY (M_C(name, _get_num)(leaf) >= N/2) || pit->num == 0)         \
       return true;                                                            \
@@ -953,7 +1095,7 @@
         k--;                                                                  \
       M_ASSERT(k >= 0 && k < M_C(name, _get_num)(parent));                    \
       /* Merge 'k' & 'k+1' & remove 'k' from parent */                        \
-      M_C(name, _merge_node)(parent, k, pass1);                               \
+      M_C(name, _merge_node)(b, parent, k, pass1);                            \
       /* Check if we need to continue */                                      \
       if (M_C(name, _get_num)(parent) >= N/2)                                 \
         return true;                                                          \
@@ -962,7 +1104,7 @@
         if (M_C(name, _get_num)(parent) == 0) {                               \
           /* Update root (deleted) */                                         \
           b->root = parent->kind.node[0];                                     \
-          M_CALL_DEL(key_oplist, parent);                                     \
+          M_C(name, _del_node)(b, parent);                                    \
         }                                                                     \
         return true;                                                          \
       }                                                                       \
@@ -1076,12 +1218,8 @@
     pit_t pit;                                                                \
     node_t n = M_C(name, _search_for_leaf)(pit, b, key);                      \
     it->node = n;                                                             \
-    int i;                                                                    \
     M_BPTR33_NODE_CONTRACT(N, isMulti, key_oplist, n, b->root);               \
-    for(i = 0; i < -n->num; i++) {                                            \
-      if (M_CALL_CMP(key_oplist, key, n->key[i]) <= 0)                        \
-        break;                                                                \
-    }                                                                         \
+    int i = M_C(name, _search_in_node)(n, -n->num, key);                      \
     if (i == -n->num && n->next != NULL) {                                    \
       it->node = n->next;                                                     \
       i = 0;                                                                  \
@@ -1109,6 +1247,63 @@
     return (cmp <= 0);                                                        \
   }                                                                           \
                                                                               \
+  M_IF(isRank)(                                                               \
+  /* Return the number of elements of the tree strictly lower than 'key' */   \
+  static inline size_t                                                        \
+  M_C(name, _rank)(const tree_t b, key_t const key)                           \
+  {                                                                           \
+    M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
+    size_t rank = 0;                                                          \
+    node_t n = b->root;                                                       \
+    /* Go down the tree, counting the elements of the left sub-trees */       \
+    while (!M_C(name, _is_leaf)(n)) {                                         \
+      int i = M_C(name, _search_in_node)(n, n->num, key);                     \
+      for(int j = 0; j < i; j++) {                                            \
+        rank += M_C(name, _get_count)(n->kind.node[j]);                       \
+      }                                                                       \
+      n = n->kind.node[i];                                                    \
+    }                                                                         \
+    return rank + (size_t) M_C(name, _search_in_node)(n, -n->num, key);       \
+  }                                                                           \
+                                                                              \
+  /* Set the iterator to the element of rank 'k' (starting from 0)            \
+     or to the end if there is not enough elements */                         \
+  static inline void                                                          \
+  M_C(name, _select)(it_t it, const tree_t b, size_t k)                       \
+  {                                                                           \
+    M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
+    M_ASSERT (it != NULL);                                                    \
+    if (k >= b->size) {                                                       \
+      M_C(name, _it_end)(it, b);                                              \
+      return;                                                                 \
+    }                                                                         \
+    node_t n = b->root;                                                       \
+    /* Go down the tree, skipping the sub-trees before the k-th element */    \
+    while (!M_C(name, _is_leaf)(n)) {                                         \
+      int i = 0;                                                              \
+      size_t count;                                                           \
+      while (k >= (count = M_C(name, _get_count)(n->kind.node[i]))) {         \
+        k -= count;                                                           \
+        i++;                                                                  \
+        M_ASSERT (i <= n->num);                                               \
+      }                                                                       \
+      n = n->kind.node[i];                                                    \
+    }                                                                         \
+    M_ASSERT (k < (size_t) -n->num);                                          \
+    it->node = n;                                                             \
+    it->idx  = (int) k;                                                       \
+  }                                                                           \
+                                                                              \
+  /* Return the number of elements whose key is in [lo, hi[ */                \
+  static inline size_t                                                        \
+  M_C(name, _count_range)(const tree_t b, key_t const lo, key_t const hi)     \
+  {                                                                           \
+    size_t rank_lo = M_C(name, _rank)(b, lo);                                 \
+    size_t rank_hi = M_C(name, _rank)(b, hi);                                 \
+    return rank_hi > rank_lo ? rank_hi - rank_lo : 0;                         \
+  }                                                                           \
+  , /* No rank */)                                                            \
+                                                                              \
   static inline value_t *                                                     \
   M_C(name, _min)(const tree_t b)                                             \
   {                                                                           \
@@ -1154,6 +1349,7 @@
     M_ASSERT (b != NULL && b != ref);                                         \
     b->size = ref->size;                                                      \
     b->root = ref->root;                                                      \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(b->allocator = ref->allocator;, )      \
     ref->root = NULL;                                                         \
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, b);                             \
   }                                                                           \
@@ -1176,6 +1372,7 @@
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, tree2);                         \
     M_SWAP(size_t, tree1->size, tree2->size);                                 \
     M_SWAP(node_t, tree1->root, tree2->root);                                 \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(M_SWAP(const m_allocator_t *, tree1->allocator, tree2->allocator);, ) \
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, tree1);                         \
     M_BPTR33_CONTRACT(N, isMulti, key_oplist, tree2);                         \
   }                                                                           \
@@ -1478,6 +1675,10 @@
 #define BPTREE_MULTI_DEF2_AS M_BPTREE_MULTI_DEF2_AS
 #define BPTREE_MULTI_DEF M_BPTREE_MULTI_DEF
 #define BPTREE_MULTI_DEF_AS M_BPTREE_MULTI_DEF_AS
+#define BPTREE_RANK_DEF2 M_BPTREE_RANK_DEF2
+#define BPTREE_RANK_DEF2_AS M_BPTREE_RANK_DEF2_AS
+#define BPTREE_RANK_DEF M_BPTREE_RANK_DEF
+#define BPTREE_RANK_DEF_AS M_BPTREE_RANK_DEF_AS
 #define BPTREE_OPLIST M_BPTREE_OPLIST
 #define BPTREE_OPLIST2 M_BPTREE_OPLIST2
 #endif
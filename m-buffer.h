@@ -37,7 +37,8 @@
  * - if it shall be thread safe or not (i.e. remove the mutex lock and atomic costs),
  * - if the buffer has to be init with empty elements, or if it shall init an element when it is pushed (and moved when popped),
  * - if the buffer has to overwrite the last element if the buffer is full,
- * - if the pop of an element is not complete until the call to pop_release (preventing push until this call).
+ * - if the pop of an element is not complete until the call to pop_release (preventing push until this call),
+ * - if the push and pop methods are lock-free, the waiting threads being parked only when the buffer is full or empty.
  */
 typedef enum {
   M_BUFFER_QUEUE = 0,    M_BUFFER_STACK = 1,
@@ -47,7 +48,8 @@ typedef enum {
   M_BUFFER_THREAD_SAFE = 0, M_BUFFER_THREAD_UNSAFE = 8,
   M_BUFFER_PUSH_INIT_POP_MOVE = 16,
   M_BUFFER_PUSH_OVERWRITE = 32,
-  M_BUFFER_DEFERRED_POP = 64
+  M_BUFFER_DEFERRED_POP = 64,
+  M_BUFFER_LOCK_FREE = 128
 } m_buffer_policy_e;
 
 
@@ -212,6 +214,200 @@ m_buff3r_number_dec(m_buff3r_number_ct n, unsigned int policy)
 
 /*****************************************************************************/
 
+/* Define if the threads waiting for a BUFFER_LOCK_FREE buffer are parked
+   on a futex (Linux only) or on the condition variables of the buffer.
+   The syscall function is only declared by the C library if _DEFAULT_SOURCE
+   or _GNU_SOURCE is defined, which is the default except in strict ISO mode.
+   The needed system headers are only included if futex are used. */
+#ifndef M_USE_FUTEX
+# if defined(__linux__)                                                       \
+  && (defined(_DEFAULT_SOURCE) || defined(_BSD_SOURCE) || defined(_GNU_SOURCE))
+#  define M_USE_FUTEX 1
+# else
+#  define M_USE_FUTEX 0
+# endif
+#endif
+#if M_USE_FUTEX
+# include <limits.h>
+# include <unistd.h>
+# include <linux/futex.h>
+# include <sys/syscall.h>
+#endif
+
+/* Event of a BUFFER_LOCK_FREE buffer raised when there is data
+   (or when there is room for data):
+   - key is incremented each time the event is raised
+   (it is the futex word if futex are used),
+   - waiters is the number of threads registered to wait for the event
+   since it was last raised, so that the event is only raised if there is
+   at least one waiting thread (and only once for all of them).
+*/
+typedef struct m_buff3r_event_s {
+  atomic_uint key;
+  atomic_uint waiters;
+} m_buff3r_event_ct[1];
+
+static inline void
+m_buff3r_event_init(m_buff3r_event_ct ev)
+{
+  atomic_init(&ev->key, 0U);
+  atomic_init(&ev->waiters, 0U);
+}
+
+/* Register the thread as a waiting thread and return the key to wait for.
+   The condition shall be tested again after this call and before waiting,
+   so that either the thread sees the new state of the buffer, or the other
+   thread sees it as a waiting thread and raises the event. */
+static inline unsigned int
+m_buff3r_event_prepare(m_buff3r_event_ct ev)
+{
+  const unsigned int key = atomic_load(&ev->key);
+  atomic_fetch_add(&ev->waiters, 1U);
+  return key;
+}
+
+/* Wait for the event to be raised after the key has been read.
+   The wake-up may be spurious.
+   A registered thread which doesn't wait finally is not unregistered:
+   it will only cause a useless raise of the event. */
+static inline void
+m_buff3r_event_wait(m_buff3r_event_ct ev, unsigned int key, m_mutex_t m, m_cond_t c)
+{
+#if M_USE_FUTEX
+  (void) m;
+  (void) c;
+  void *addr = &ev->key;
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, key, NULL, NULL, 0);
+#else
+  m_mutex_lock(m);
+  while (atomic_load(&ev->key) == key) {
+    m_cond_wait(c, m);
+  }
+  m_mutex_unlock(m);
+#endif
+}
+
+/* Raise the event if there is at least one registered thread,
+   waking up all the registered threads.
+   The update of the buffer and the test of the registered threads
+   shall be sequentially consistent, like the registration and the test
+   of the buffer by the waiting thread, so that a thread cannot miss both. */
+static inline void
+m_buff3r_event_raise(m_buff3r_event_ct ev, m_mutex_t m, m_cond_t c)
+{
+  if (M_LIKELY (atomic_load(&ev->waiters) == 0))
+    return;
+  /* Only one thread raises the event for all the registered threads */
+  if (atomic_exchange(&ev->waiters, 0U) == 0)
+    return;
+#if M_USE_FUTEX
+  (void) m;
+  (void) c;
+  atomic_fetch_add(&ev->key, 1U);
+  void *addr = &ev->key;
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+  m_mutex_lock(m);
+  atomic_fetch_add(&ev->key, 1U);
+  m_cond_broadcast(c);
+  m_mutex_unlock(m);
+#endif
+}
+
+/* State of a BUFFER_LOCK_FREE buffer.
+   It is not a field of the buffer, so that the other buffers don't pay for it:
+   it is stored in extra elements allocated after the elements of the buffer,
+   aligned on a cache line, and followed by the sequence numbers of the elements
+   (See M_BUFF3R_LF_EXTRA). */
+typedef struct m_buff3r_lf_s {
+  atomic_ullong     ticketPush; /* Next production ticket */
+  m_buff3r_event_ct eventData;  /* Raised when there is data */
+  M_CACHELINE_ALIGN(align1, atomic_ullong, m_buff3r_event_ct);
+  atomic_ullong     ticketPop;  /* Next consumption ticket */
+  m_buff3r_event_ct eventRoom;  /* Raised when there is room */
+  M_CACHELINE_ALIGN(align2, atomic_ullong, m_buff3r_event_ct);
+} m_buff3r_lf_ct;
+
+/* Number of extra elements of type 'el_type' needed to store the state
+   of a buffer of 'size' elements (0 if the buffer is not lock-free) */
+#define M_BUFF3R_LF_EXTRA(policy, el_type, size)                              \
+  (M_BUFF3R_POLICY_P(policy, M_BUFFER_LOCK_FREE)                              \
+   ? (M_ALIGN_FOR_CACHELINE_EXCLUSION - 1 + sizeof(m_buff3r_lf_ct)            \
+      + (size) * sizeof(atomic_uint) + sizeof(el_type) - 1) / sizeof(el_type) \
+   : 0)
+
+/* Return the state of a BUFFER_LOCK_FREE buffer
+   given the end of its elements */
+static inline m_buff3r_lf_ct *
+m_buff3r_lf_get(const void *end)
+{
+  const uintptr_t mask = M_ALIGN_FOR_CACHELINE_EXCLUSION - 1;
+  return (m_buff3r_lf_ct *) (((uintptr_t) end + mask) & ~mask);
+}
+
+/* Return the sequence numbers of the elements of a BUFFER_LOCK_FREE buffer */
+static inline atomic_uint *
+m_buff3r_lf_seq(m_buff3r_lf_ct *lf)
+{
+  return (atomic_uint *) (void *) (lf + 1);
+}
+
+/* Claim the next ticket of a BUFFER_LOCK_FREE buffer:
+   - ticket is the production (or consumption) ticket counter,
+   - seq is the array of the sequence numbers of the elements,
+   - offset is 0 for a production (and 1 for a consumption).
+   The element of the ticket 't' is at index 't % size'.
+   Its sequence number is '2*t' if it is free for the production of 't',
+   '2*t+1' once 't' has been produced (ready for its consumption) and
+   '2*(t+size)' once 't' has been consummed (free for the next production).
+   The factor 2 distinguishes the two last states even if size is 1
+   (like QUEUE_MPMC_DEF).
+   Only the lower bits of the tickets are stored in the sequence numbers.
+   The claimed ticket and the index of its element are returned
+   in '*p' and '*pi'.
+   Return false if the buffer is full (or empty) or if the element
+   is still in use by a thread which has claimed it. */
+static inline bool
+m_buff3r_lf_claim(atomic_ullong *ticket, atomic_uint seq[], size_t size,
+                  unsigned int offset, unsigned long long *p, size_t *pi)
+{
+  unsigned long long t = atomic_load_explicit(ticket, memory_order_relaxed);
+  while (true) {
+    const size_t i = (size_t) (M_POWEROF2_P(size) ? (t & (size - 1)) : (t % size));
+    const unsigned int s = atomic_load(&seq[i]);
+    const unsigned int diff = s - (2U * (unsigned int) t + offset);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(ticket, &t, t+1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        *p = t;
+        *pi = i;
+        return true;
+      }
+      /* t has been updated with the current ticket */
+    } else if (diff > UINT_MAX / 2) {
+      /* The element is still used by the previous round */
+      return false;
+    } else {
+      /* Another thread has already claimed this ticket */
+      t = atomic_load_explicit(ticket, memory_order_relaxed);
+    }
+  }
+}
+
+/* Return the number of elements of a BUFFER_LOCK_FREE buffer.
+   As both tickets cannot be read atomically, it is an approximation.
+   As the consumption ticket is read first, it cannot underflow. */
+static inline size_t
+m_buff3r_lf_size(m_buff3r_lf_ct *lf, size_t size)
+{
+  const unsigned long long c = atomic_load_explicit(&lf->ticketPop, memory_order_relaxed);
+  const unsigned long long p = atomic_load_explicit(&lf->ticketPush, memory_order_acquire);
+  return (size_t) M_MIN(p - c, (unsigned long long) size);
+}
+
+/*****************************************************************************/
+
 /* Test if the size is only run-time or build time */
 #define M_BUFF3R_IF_CTE_SIZE(m_size)  M_IF(M_BOOL(m_size))
 
@@ -278,7 +474,8 @@ m_buff3r_number_dec(m_buff3r_number_ct n, unsigned int policy)
     /* number[1] := [OPTION] Number of elements being deferred in the buffer */ \
     m_buff3r_number_ct number[1 + M_BUFF3R_POLICY_P(policy, M_BUFFER_DEFERRED_POP)]; \
     /* If fixed size, array of elements, otherwise pointer to element */      \
-    M_C(name, _el_ct)  M_BUFF3R_IF_CTE_SIZE(m_size)(data[m_size], *data);     \
+    /* [LOCK_FREE] followed by the state of the buffer */                     \
+    M_C(name, _el_ct)  M_BUFF3R_IF_CTE_SIZE(m_size)(data[m_size + M_BUFF3R_LF_EXTRA(policy, M_C(name, _el_ct), m_size)], *data); \
   } buffer_t[1];                                                              \
                                                                               \
   typedef struct M_C(name, _s) *M_C(name, _ptr);                              \
@@ -291,6 +488,13 @@ m_buff3r_number_dec(m_buff3r_number_ct n, unsigned int policy)
                                                                               \
   M_CHECK_COMPATIBLE_OPLIST(name, 1, type, oplist)                            \
                                                                               \
+/* [LOCK_FREE] Return the state of the buffer, stored after its elements */   \
+static inline m_buff3r_lf_ct *                                                \
+M_C3(m_buff3r_,name,_lf)(M_C(name, _srcptr) v)                                \
+{                                                                             \
+  return m_buff3r_lf_get(&v->data[M_BUFF3R_SIZE(m_size)]);                    \
+}                                                                             \
+                                                                              \
 static inline void                                                            \
 M_C(name, _init)(buffer_t v, size_t size)                                     \
 {                                                                             \
@@ -307,15 +511,31 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
     m_cond_init(v->there_is_room_for_data);                                   \
   } else {                                                                    \
     M_ASSERT(M_BUFF3R_POLICY_P((policy), M_BUFFER_UNBLOCKING));               \
+  }                                                                           \
+  if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE)) {                      \
+    M_ASSERT(((policy) & (M_BUFFER_STACK|M_BUFFER_THREAD_UNSAFE|M_BUFFER_PUSH_OVERWRITE|M_BUFFER_DEFERRED_POP)) == 0); \
+    M_ASSERT(0 < size && size <= UINT_MAX/4);                                 \
   }                                                                           \
                                                                               \
   M_BUFF3R_IF_CTE_SIZE(m_size)( /* Statically allocated */ ,                  \
-    v->data = M_CALL_REALLOC(oplist, M_C(name, _el_ct), NULL, M_BUFF3R_SIZE(m_size)); \
+    const size_t alloc = size + M_BUFF3R_LF_EXTRA(policy, M_C(name, _el_ct), size); \
+    v->data = M_CALL_REALLOC(oplist, M_C(name, _el_ct), NULL, alloc);         \
     if (v->data == NULL) {                                                    \
-      M_MEMORY_FULL (M_BUFF3R_SIZE(m_size)*sizeof(M_C(name, _el_ct)));        \
+      M_MEMORY_FULL (alloc*sizeof(M_C(name, _el_ct)));                        \
       return;                                                                 \
     }                                                                         \
   )                                                                           \
+  if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE)) {                      \
+    m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                         \
+    atomic_init(&lf->ticketPush, 0ULL);                                       \
+    atomic_init(&lf->ticketPop, 0ULL);                                        \
+    m_buff3r_event_init(lf->eventData);                                       \
+    m_buff3r_event_init(lf->eventRoom);                                       \
+    atomic_uint *seq = m_buff3r_lf_seq(lf);                                   \
+    for(size_t i = 0; i < size; i++) {                                        \
+      atomic_init(&seq[i], 2U * (unsigned int) i);                            \
+    }                                                                         \
+  }                                                                           \
   if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_PUSH_INIT_POP_MOVE)) {            \
     for(size_t i = 0; i < size; i++) {                                        \
       M_CALL_INIT(oplist, v->data[i].x);                                      \
@@ -340,6 +560,12 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
      for(size_t i = 0; i < M_BUFF3R_SIZE(m_size); i++) {                      \
        M_CALL_CLEAR(oplist, v->data[i].x);                                    \
      }                                                                        \
+   } else if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE)) {              \
+     m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                        \
+     const unsigned long long p = atomic_load(&lf->ticketPush);               \
+     for(unsigned long long t = atomic_load(&lf->ticketPop); t != p; t++) {   \
+       M_CALL_CLEAR(oplist, v->data[t % M_BUFF3R_SIZE(m_size)].x);            \
+     }                                                                        \
    } else {                                                                   \
      size_t i = M_BUFF3R_POLICY_P((policy), M_BUFFER_STACK) ? 0 : v->idx_cons; \
      while (i != v->idx_prod) {                                               \
@@ -353,6 +579,15 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
    m_buff3r_number_store (v->number[0], 0U, policy);                          \
    if (M_BUFF3R_POLICY_P(policy, M_BUFFER_DEFERRED_POP))                      \
      m_buff3r_number_store(v->number[1], 0U, policy);                         \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE)) {                     \
+     m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                        \
+     atomic_uint *seq = m_buff3r_lf_seq(lf);                                  \
+     atomic_store(&lf->ticketPush, 0ULL);                                     \
+     atomic_store(&lf->ticketPop, 0ULL);                                      \
+     for(size_t i = 0; i < M_BUFF3R_SIZE(m_size); i++) {                      \
+       atomic_store(&seq[i], 2U * (unsigned int) i);                          \
+     }                                                                        \
+   }                                                                          \
    M_BUFF3R_CONTRACT(v,m_size);                                               \
  }                                                                            \
                                                                               \
@@ -378,6 +613,21 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
  M_C(name, _reset)(buffer_t v)                                                \
  {                                                                            \
    M_BUFF3R_CONTRACT(v,m_size);                                               \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE)) {                     \
+     /* Consumme all the elements like concurrent pop would do */             \
+     m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                        \
+     atomic_uint *seq = m_buff3r_lf_seq(lf);                                  \
+     unsigned long long t;                                                    \
+     size_t i;                                                                \
+     while (m_buff3r_lf_claim(&lf->ticketPop, seq, M_BUFF3R_SIZE(m_size), 1, &t, &i)) { \
+       if (M_BUFF3R_POLICY_P((policy), M_BUFFER_PUSH_INIT_POP_MOVE)) {        \
+         M_CALL_CLEAR(oplist, v->data[i].x);                                  \
+       }                                                                      \
+       atomic_store(&seq[i], (unsigned int) (2*(t + M_BUFF3R_SIZE(m_size)))); \
+     }                                                                        \
+     m_buff3r_event_raise(lf->eventRoom, v->mutexPush, v->there_is_room_for_data); \
+     return;                                                                  \
+   }                                                                          \
    if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_THREAD_UNSAFE)) {                \
      m_mutex_lock(v->mutexPush);                                              \
      m_mutex_lock(v->mutexPop);                                               \
@@ -403,6 +653,21 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
    M_C(name,_reset)(v);                                                       \
  }                                                                            \
                                                                               \
+ /* [LOCK_FREE] Copy the tickets & the sequence numbers (not thread safe) */  \
+ static inline void                                                           \
+ M_C3(m_buff3r_,name,_lf_set_tickets)(buffer_t dest, buffer_t v)              \
+ {                                                                            \
+   m_buff3r_lf_ct *dlf = M_C3(m_buff3r_,name,_lf)(dest);                      \
+   m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                          \
+   atomic_uint *dseq = m_buff3r_lf_seq(dlf);                                  \
+   atomic_uint *seq = m_buff3r_lf_seq(lf);                                    \
+   atomic_store(&dlf->ticketPush, atomic_load(&lf->ticketPush));              \
+   atomic_store(&dlf->ticketPop, atomic_load(&lf->ticketPop));                \
+   for(size_t i = 0; i < M_BUFF3R_SIZE(m_size); i++) {                        \
+     atomic_store(&dseq[i], atomic_load(&seq[i]));                            \
+   }                                                                          \
+ }                                                                            \
+                                                                              \
  static inline void                                                           \
  M_C(name, _init_set)(buffer_t dest, const buffer_t src)                      \
  {                                                                            \
@@ -423,6 +688,13 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
      for(size_t i = 0; i < M_BUFF3R_SIZE(m_size); i++) {                      \
        M_CALL_INIT_SET(oplist, dest->data[i].x, v->data[i].x);                \
      }                                                                        \
+   } else if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE)) {              \
+     m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                        \
+     const unsigned long long p = atomic_load(&lf->ticketPush);               \
+     for(unsigned long long t = atomic_load(&lf->ticketPop); t != p; t++) {   \
+       const size_t i = (size_t) (t % M_BUFF3R_SIZE(m_size));                 \
+       M_CALL_INIT_SET(oplist, dest->data[i].x, v->data[i].x);                \
+     }                                                                        \
    } else {                                                                   \
      size_t i = M_BUFF3R_POLICY_P((policy), M_BUFFER_STACK) ? 0 : v->idx_cons; \
      while (i != v->idx_prod) {                                               \
@@ -438,6 +710,8 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
    m_buff3r_number_set (dest->number[0], v->number[0], policy);               \
    if (M_BUFF3R_POLICY_P(policy, M_BUFFER_DEFERRED_POP))                      \
      m_buff3r_number_set(dest->number[1], v->number[1], policy);              \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE))                       \
+     M_C3(m_buff3r_,name,_lf_set_tickets)(dest, v);                           \
                                                                               \
    if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_THREAD_UNSAFE)) {                \
      m_mutex_unlock(v->mutexPop);                                             \
@@ -481,6 +755,13 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
      for(size_t i = 0; i < M_BUFF3R_SIZE(m_size); i++) {                      \
        M_CALL_INIT_SET(oplist, dest->data[i].x, v->data[i].x);                \
      }                                                                        \
+   } else if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE)) {              \
+     m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                        \
+     const unsigned long long p = atomic_load(&lf->ticketPush);               \
+     for(unsigned long long t = atomic_load(&lf->ticketPop); t != p; t++) {   \
+       const size_t i = (size_t) (t % M_BUFF3R_SIZE(m_size));                 \
+       M_CALL_INIT_SET(oplist, dest->data[i].x, v->data[i].x);                \
+     }                                                                        \
    } else {                                                                   \
      size_t i = M_BUFF3R_POLICY_P((policy), M_BUFFER_STACK) ? 0 : v->idx_cons; \
      while (i != v->idx_prod) {                                               \
@@ -496,6 +777,8 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
    m_buff3r_number_set (dest->number[0], v->number[0], policy);               \
    if (M_BUFF3R_POLICY_P(policy, M_BUFFER_DEFERRED_POP))                      \
      m_buff3r_number_set(dest->number[1], v->number[1], policy);              \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE))                       \
+     M_C3(m_buff3r_,name,_lf_set_tickets)(dest, v);                           \
                                                                               \
    if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_THREAD_UNSAFE)) {                \
      /* It may be false, but it is not wrong! */                              \
@@ -525,7 +808,9 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
       we considered the queue as empty when the number of                     \
       deferred pop has reached 0, not the number of items in the              \
       buffer is 0. */                                                         \
-   if (M_BUFF3R_POLICY_P(policy, M_BUFFER_DEFERRED_POP))                      \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE))                       \
+     return m_buff3r_lf_size(M_C3(m_buff3r_,name,_lf)(v), M_BUFF3R_SIZE(m_size)) == 0; \
+   else if (M_BUFF3R_POLICY_P(policy, M_BUFFER_DEFERRED_POP))                 \
      return m_buff3r_number_load (v->number[1], policy) == 0;                 \
    else                                                                       \
      return m_buff3r_number_load (v->number[0], policy) == 0;                 \
@@ -535,6 +820,9 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
  M_C(name, _full_p)(buffer_t v)                                               \
  {                                                                            \
    M_BUFF3R_CONTRACT(v,m_size);                                               \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE))                       \
+     return m_buff3r_lf_size(M_C3(m_buff3r_,name,_lf)(v), M_BUFF3R_SIZE(m_size)) \
+       == M_BUFF3R_SIZE(m_size);                                              \
    return m_buff3r_number_load (v->number[0], policy)                         \
      == M_BUFF3R_SIZE(m_size);                                                \
  }                                                                            \
@@ -543,13 +831,91 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
  M_C(name, _size)(buffer_t v)                                                 \
  {                                                                            \
    M_BUFF3R_CONTRACT(v,m_size);                                               \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE))                       \
+     return m_buff3r_lf_size(M_C3(m_buff3r_,name,_lf)(v), M_BUFF3R_SIZE(m_size)); \
    return m_buff3r_number_load (v->number[0], policy);                        \
  }                                                                            \
                                                                               \
+ /* [LOCK_FREE] Try to push the data without any lock */                      \
+ static inline bool                                                           \
+ M_C3(m_buff3r_,name,_lf_try_push)(buffer_t v, type const data)               \
+ {                                                                            \
+   m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                          \
+   atomic_uint *seq = m_buff3r_lf_seq(lf);                                    \
+   unsigned long long t;                                                      \
+   size_t i;                                                                  \
+   if (!m_buff3r_lf_claim(&lf->ticketPush, seq, M_BUFF3R_SIZE(m_size), 0, &t, &i)) \
+     return false;                                                            \
+   if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_PUSH_INIT_POP_MOVE)) {           \
+     M_CALL_SET(oplist, v->data[i].x, data);                                  \
+   } else {                                                                   \
+     M_CALL_INIT_SET(oplist, v->data[i].x, data);                             \
+   }                                                                          \
+   /* From this point, consummer may read the data in the table */            \
+   atomic_store(&seq[i], (unsigned int) (2*t + 1));                           \
+   m_buff3r_event_raise(lf->eventData, v->mutexPop, v->there_is_data);        \
+   return true;                                                               \
+ }                                                                            \
+                                                                              \
+ /* [LOCK_FREE] Push the data, waiting for some room if needed */             \
+ static inline bool                                                           \
+ M_C3(m_buff3r_,name,_lf_push)(buffer_t v, type const data, bool blocking)    \
+ {                                                                            \
+   m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                          \
+   while (!M_C3(m_buff3r_,name,_lf_try_push)(v, data)) {                      \
+     if (!blocking)                                                           \
+       return false;                                                          \
+     const unsigned int key = m_buff3r_event_prepare(lf->eventRoom);          \
+     if (M_C3(m_buff3r_,name,_lf_try_push)(v, data))                          \
+       break;                                                                 \
+     m_buff3r_event_wait(lf->eventRoom, key, v->mutexPush, v->there_is_room_for_data); \
+   }                                                                          \
+   return true;                                                               \
+ }                                                                            \
+                                                                              \
+ /* [LOCK_FREE] Try to pop a data without any lock */                         \
+ static inline bool                                                           \
+ M_C3(m_buff3r_,name,_lf_try_pop)(type *data, buffer_t v)                     \
+ {                                                                            \
+   m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                          \
+   atomic_uint *seq = m_buff3r_lf_seq(lf);                                    \
+   unsigned long long t;                                                      \
+   size_t i;                                                                  \
+   if (!m_buff3r_lf_claim(&lf->ticketPop, seq, M_BUFF3R_SIZE(m_size), 1, &t, &i)) \
+     return false;                                                            \
+   if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_PUSH_INIT_POP_MOVE)) {           \
+     M_CALL_SET(oplist, *data, v->data[i].x);                                 \
+   } else {                                                                   \
+     M_DO_INIT_MOVE (oplist, *data, v->data[i].x);                            \
+   }                                                                          \
+   /* Space may be reused by a producer thread from this point */             \
+   atomic_store(&seq[i], (unsigned int) (2*(t + M_BUFF3R_SIZE(m_size))));     \
+   m_buff3r_event_raise(lf->eventRoom, v->mutexPush, v->there_is_room_for_data); \
+   return true;                                                               \
+ }                                                                            \
+                                                                              \
+ /* [LOCK_FREE] Pop a data, waiting for some data if needed */                \
+ static inline bool                                                           \
+ M_C3(m_buff3r_,name,_lf_pop)(type *data, buffer_t v, bool blocking)          \
+ {                                                                            \
+   m_buff3r_lf_ct *lf = M_C3(m_buff3r_,name,_lf)(v);                          \
+   while (!M_C3(m_buff3r_,name,_lf_try_pop)(data, v)) {                       \
+     if (!blocking)                                                           \
+       return false;                                                          \
+     const unsigned int key = m_buff3r_event_prepare(lf->eventData);          \
+     if (M_C3(m_buff3r_,name,_lf_try_pop)(data, v))                           \
+       break;                                                                 \
+     m_buff3r_event_wait(lf->eventData, key, v->mutexPop, v->there_is_data);  \
+   }                                                                          \
+   return true;                                                               \
+ }                                                                            \
+                                                                              \
  static inline bool                                                           \
  M_C(name, _push_blocking)(buffer_t v, type const data, bool blocking)        \
  {                                                                            \
    M_BUFF3R_CONTRACT(v,m_size);                                               \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE))                       \
+     return M_C3(m_buff3r_,name,_lf_push)(v, data, blocking);                 \
                                                                               \
    /* Producer Mutex lock (mutex lock performs an acquire memory barrier) */  \
    if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_THREAD_UNSAFE)) {                \
@@ -631,6 +997,8 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
  {                                                                            \
    M_BUFF3R_CONTRACT(v,m_size);                                               \
    M_ASSERT (data != NULL);                                                   \
+   if (M_BUFF3R_POLICY_P((policy), M_BUFFER_LOCK_FREE))                       \
+     return M_C3(m_buff3r_,name,_lf_pop)(data, v, blocking);                  \
                                                                               \
    /* Consummer lock (mutex lock performs an acquire memory barrier) */       \
    if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_THREAD_UNSAFE)) {                \
@@ -877,6 +1245,91 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
     return true;                                                              \
   }                                                                           \
                                                                               \
+  static inline unsigned                                                      \
+  M_C(name, _push_bulk)(buffer_t table, unsigned int n, type const x[])       \
+  {                                                                           \
+    M_QU3UE_MPMC_CONTRACT(table);                                             \
+    M_ASSERT (x != NULL || n == 0);                                           \
+    M_ASSERT (n <= table->size);                                              \
+    unsigned int idx = atomic_load_explicit(&table->ProdIdx,                  \
+                                            memory_order_relaxed);            \
+    /* Count the consecutive free elements from the production index.         \
+       An element stays free until a producer claims it, so they are          \
+       still free once the whole range is claimed by the CAS below. */        \
+    unsigned int max = 0;                                                     \
+    while (max < n) {                                                         \
+      const unsigned int i = (idx + max) & (table->size -1);                  \
+      const unsigned int seq = atomic_load_explicit(&table->Tab[i].seq,       \
+                                                    memory_order_acquire);    \
+      if (2*(idx + max - table->size) + 1 != seq)                             \
+        break;                                                                \
+      max++;                                                                  \
+    }                                                                         \
+    if (M_UNLIKELY (max == 0)) {                                              \
+      /* Buffer full (or unlikely preemption). Can not push */                \
+      return 0;                                                               \
+    }                                                                         \
+    /* Claim the whole range of elements with only one atomic operation */    \
+    if (M_UNLIKELY (!atomic_compare_exchange_strong_explicit(&table->ProdIdx, \
+           &idx, idx+max, memory_order_relaxed, memory_order_relaxed))) {     \
+      /* Thread has been preempted by another one. */                         \
+      return 0;                                                               \
+    }                                                                         \
+    for(unsigned int k = 0; k < max; k++) {                                   \
+      const unsigned int i = (idx + k) & (table->size -1);                    \
+      if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_PUSH_INIT_POP_MOVE)) {        \
+        M_CALL_SET(oplist, table->Tab[i].x, x[k]);                            \
+      } else {                                                                \
+        M_CALL_INIT_SET(oplist, table->Tab[i].x, x[k]);                       \
+      }                                                                       \
+      /* Finish transaction of this element so that consummers can            \
+         get it without waiting for the end of the range */                   \
+      atomic_store_explicit(&table->Tab[i].seq, 2*(idx+k), memory_order_release); \
+    }                                                                         \
+    M_QU3UE_MPMC_CONTRACT(table);                                             \
+    return max;                                                               \
+  }                                                                           \
+                                                                              \
+  static inline unsigned                                                      \
+  M_C(name, _pop_bulk)(unsigned int n, type ptr[], buffer_t table)            \
+  {                                                                           \
+    M_QU3UE_MPMC_CONTRACT(table);                                             \
+    M_ASSERT (ptr != NULL || n == 0);                                         \
+    M_ASSERT (n <= table->size);                                              \
+    unsigned int iC = atomic_load_explicit(&table->ConsoIdx,                  \
+                                           memory_order_relaxed);             \
+    /* Count the consecutive produced elements from the consumption index */  \
+    unsigned int max = 0;                                                     \
+    while (max < n) {                                                         \
+      const unsigned int i = (iC + max) & (table->size -1);                   \
+      const unsigned int seq = atomic_load_explicit(&table->Tab[i].seq,       \
+                                                    memory_order_acquire);    \
+      if (seq != 2 * (iC + max))                                              \
+        break;                                                                \
+      max++;                                                                  \
+    }                                                                         \
+    if (max == 0) {                                                           \
+      /* Nothing in buffer to consumme (or unlikely preemption) */            \
+      return 0;                                                               \
+    }                                                                         \
+    if (M_UNLIKELY (!atomic_compare_exchange_strong_explicit(&table->ConsoIdx, \
+             &iC, iC+max, memory_order_relaxed, memory_order_relaxed))) {     \
+      /* Thread has been preempted by another one */                          \
+      return 0;                                                               \
+    }                                                                         \
+    for(unsigned int k = 0; k < max; k++) {                                   \
+      const unsigned int i = (iC + k) & (table->size -1);                     \
+      if (!M_BUFF3R_POLICY_P((policy), M_BUFFER_PUSH_INIT_POP_MOVE)) {        \
+        M_CALL_SET(oplist, ptr[k], table->Tab[i].x);                          \
+      } else {                                                                \
+        M_DO_INIT_MOVE (oplist, ptr[k], table->Tab[i].x);                     \
+      }                                                                       \
+      atomic_store_explicit(&table->Tab[i].seq, 2*(iC+k) + 1, memory_order_release); \
+    }                                                                         \
+    M_QU3UE_MPMC_CONTRACT(table);                                             \
+    return max;                                                               \
+  }                                                                           \
+                                                                              \
   static inline void                                                          \
   M_C(name, _init)(buffer_t buffer, size_t size)                              \
   {                                                                           \
@@ -1309,6 +1762,7 @@ M_C(name, _init)(buffer_t v, size_t size)                                     \
 #define BUFFER_PUSH_INIT_POP_MOVE M_BUFFER_PUSH_INIT_POP_MOVE
 #define BUFFER_PUSH_OVERWRITE M_BUFFER_PUSH_OVERWRITE
 #define BUFFER_DEFERRED_POP M_BUFFER_DEFERRED_POP
+#define BUFFER_LOCK_FREE M_BUFFER_LOCK_FREE
 
 #endif
 
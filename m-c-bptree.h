@@ -0,0 +1,709 @@
+/*
+ * M*LIB - Concurrent B+TREE module
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_CONCURRENT_BPTREE_H
+#define MSTARLIB_CONCURRENT_BPTREE_H
+
+#include "m-core.h"
+#include "m-atomic.h"
+#include "m-c-mempool.h"
+
+/* Define a concurrent B+tree of size 'N' that maps a 'key' to a 'value'
+   with its associated functions.
+   Readers don't take any lock and don't write to the shared memory:
+   they validate what they have read against the version of each node
+   (Optimistic Lock Coupling). Writers only lock the nodes they modify.
+   The key & value types shall be trivially copyable: they are copied with
+   a raw assignment and may be read by a reader while a writer modifies them.
+   Removed nodes are reclaimed through the given garbage collector (m_gc_t).
+   USAGE:
+   C_BPTREE_DEF2(name, N, key_t, key_oplist, value_t, value_oplist)
+   OR
+   C_BPTREE_DEF2(name, N, key_t, value_t)
+*/
+#define M_C_BPTREE_DEF2(name, N, key_type, ...)                               \
+  M_C_BPTREE_DEF2_AS(name, M_C(name,_t), M_C(name,_it_t), M_C(name,_itref_t), N, key_type, __VA_ARGS__)
+
+
+/* Define a concurrent B+tree of size 'N' that maps a 'key' to a 'value'
+   as the given name name_t with its associated functions.
+   USAGE:
+   C_BPTREE_DEF2_AS(name, name_t, it_t, itref_t, N, key_t, key_oplist, value_t, value_oplist)
+   OR
+   C_BPTREE_DEF2_AS(name, name_t, it_t, itref_t, N, key_t, value_t)
+*/
+#define M_C_BPTREE_DEF2_AS(name, name_t, it_t, itref_t, N, key_type, ...)     \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_CBPTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                \
+                   ((name, N, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), name_t, M_C(name, _node_t), it_t, itref_t ), \
+                    (name, N, key_type, __VA_ARGS__,                                                                            name_t, M_C(name, _node_t), it_t, itref_t ))) \
+  M_END_PROTECTED_CODE
+
+
+/*****************************************************************************/
+/******************************** INTERNAL ***********************************/
+/*****************************************************************************/
+
+/* Version lock of a node used by the Optimistic Lock Coupling:
+   - bit 0: the node is obsolete (it has been removed from the tree),
+   - bit 1: the node is locked by a writer,
+   - other bits: version of the node, incremented by each write unlock. */
+#define M_CBPTR33_OBSOLETE 1UL
+#define M_CBPTR33_LOCKED   2UL
+
+/* Number of nodes allocated at a time by the node pool of a tree */
+#define M_CBPTR33_NODE_PER_GROUP 64
+
+/* Read the version of a node.
+   Return false if the node is locked or obsolete (the operation shall restart) */
+static inline bool
+m_cbptr33_read_lock(atomic_ulong *lock, unsigned long *version)
+{
+  unsigned long v = atomic_load_explicit(lock, memory_order_acquire);
+  *version = v;
+  return (v & (M_CBPTR33_LOCKED | M_CBPTR33_OBSOLETE)) == 0;
+}
+
+/* Check that the node has not been modified since its version was read,
+   so that everything read from the node in between is consistent */
+static inline bool
+m_cbptr33_read_check(atomic_ulong *lock, unsigned long version)
+{
+  atomic_thread_fence(memory_order_acquire);
+  return atomic_load_explicit(lock, memory_order_relaxed) == version;
+}
+
+/* Lock the node for writing if it has not been modified since its
+   version was read. Return false otherwise (the operation shall restart) */
+static inline bool
+m_cbptr33_upgrade_lock(atomic_ulong *lock, unsigned long version)
+{
+  bool b = atomic_compare_exchange_strong_explicit(lock, &version,
+                                                   version + M_CBPTR33_LOCKED,
+                                                   memory_order_acquire,
+                                                   memory_order_relaxed);
+  /* The modifications of the node shall not be visible before the lock */
+  atomic_thread_fence(memory_order_release);
+  return b;
+}
+
+/* Unlock the node and increment its version */
+static inline void
+m_cbptr33_write_unlock(atomic_ulong *lock)
+{
+  atomic_fetch_add_explicit(lock, M_CBPTR33_LOCKED, memory_order_release);
+}
+
+/* Unlock the node, increment its version and mark it as obsolete */
+static inline void
+m_cbptr33_write_unlock_obsolete(atomic_ulong *lock)
+{
+  atomic_fetch_add_explicit(lock, M_CBPTR33_LOCKED | M_CBPTR33_OBSOLETE, memory_order_release);
+}
+
+/* Deferred evaluation for the concurrent b+tree definition,
+   so that all arguments are evaluated before further expansion */
+#define M_CBPTR33_DEF_P1(arg) M_ID( M_CBPTR33_DEF_P2 arg )
+
+/* Validate the key oplist before going further */
+#define M_CBPTR33_DEF_P2(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t) \
+  M_IF_OPLIST(key_oplist)(M_CBPTR33_DEF_P3, M_CBPTR33_DEF_FAILURE)(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t)
+
+/* Validate the value oplist before going further */
+#define M_CBPTR33_DEF_P3(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t) \
+  M_IF_OPLIST(value_oplist)(M_CBPTR33_DEF_P4, M_CBPTR33_DEF_FAILURE)(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t)
+
+/* Stop processing with a compilation failure */
+#define M_CBPTR33_DEF_FAILURE(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t) \
+  M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(C_BPTREE_DEF2): one of the given argument is not a valid oplist: " M_AS_STR(key_oplist) " / " M_AS_STR(value_oplist))
+
+/* Internal concurrent b+tree definition
+   - name: prefix to be used
+   - N: size of the node
+   - key_t: key type of the elements of the container
+   - key_oplist: oplist of the key type of the elements of the container
+   - value_t: value type of the elements of the container
+   - value_oplist: oplist of the value type of the elements of the container
+   - tree_t: alias for the type of the container
+   - node_t: alias for internal node
+   - it_t: alias for the iterator of the container
+   - itref_t: alias for the type referenced by the iterator
+ */
+#define M_CBPTR33_DEF_P4(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t) \
+                                                                              \
+  /* Define a Node of a concurrent B+TREE.                                    \
+   * A node is split before being full (when going down the tree)             \
+   * so that the split never needs to go up the tree.                         \
+   * Child 'i' of an inner node has all its keys in ]key[i-1], key[i]].       \
+   */                                                                         \
+  typedef struct M_C(name, _node_s) {                                         \
+    atomic_ulong version; /* Version lock of the node (see above) */          \
+    atomic_int   num;     /* Number of keys */                                \
+    bool         leaf;    /* Constant during the life time of the node */     \
+    key_t        key[N];                                                      \
+    union  M_C(name, _kind_s) {       /* either value or pointer to other nodes */ \
+      value_t                    value[N];                                    \
+      struct M_C(name, _node_s) *node[N+1];                                   \
+    } kind;                                                                   \
+  } *node_t;                                                                  \
+                                                                              \
+  /* Pool of nodes attached to the garbage collector */                       \
+  M_C_MEMPOOL_DEF(M_C(name, _mempool), struct M_C(name, _node_s))             \
+                                                                              \
+  /* A concurrent B+TREE is a pointer to the root node */                     \
+  typedef struct M_C(name, _s) {                                              \
+    M_ATTR_EXTENSION _Atomic(node_t) root;                                    \
+    atomic_size_t                    size;                                    \
+    struct m_gc_s                   *gc_mem;                                  \
+    M_C(name, _mempool_t)            mempool;                                 \
+  } tree_t[1];                                                                \
+  typedef struct M_C(name, _s) *M_C(name, _ptr);                              \
+  typedef const struct M_C(name, _s) *M_C(name, _srcptr);                     \
+                                                                              \
+  /* Type returned by the iterator (pointers to a copy of the element) */     \
+  typedef struct M_C(name, _itref_s) {                                        \
+    const key_t   *key_ptr;                                                   \
+    const value_t *value_ptr;                                                 \
+  } itref_t;                                                                  \
+                                                                              \
+  /* Define the Iterator. As no lock is kept, it copies the elements          \
+     of the current leaf. */                                                  \
+  typedef struct M_C(name, _it_s) {                                           \
+    struct M_C(name, _s) *tree;                                               \
+    m_gc_tid_t id;                                                            \
+    int        idx;                                                           \
+    int        num;                                                           \
+    bool       last;     /* Copied leaf was the last one */                   \
+    itref_t    ref;                                                           \
+    key_t      key[N];                                                        \
+    value_t    value[N];                                                      \
+  } it_t[1];                                                                  \
+                                                                              \
+  /* Definition of the alias used by the oplists */                           \
+  typedef key_t     M_C(name, _key_ct);                                       \
+  typedef value_t   M_C(name, _value_ct);                                     \
+  typedef tree_t    M_C(name, _ct);                                           \
+  typedef it_t      M_C(name, _it_ct);                                        \
+                                                                              \
+  M_CHECK_COMPATIBLE_OPLIST(name, 1, key_t, key_oplist)                       \
+  M_CHECK_COMPATIBLE_OPLIST(name, 2, value_t, value_oplist)                   \
+                                                                              \
+  /* Allocate a new node from the node pool */                                \
+  static inline node_t                                                        \
+  M_C(name, _new_node)(tree_t b, bool leaf, m_gc_tid_t id)                    \
+  {                                                                           \
+    M_STATIC_ASSERT(N >= 3, M_LIB_ILLEGAL_PARAM,                              \
+                    "Number of items per node shall be >= 3.");               \
+    node_t n = M_C(name, _mempool_new)(b->mempool, id);                       \
+    atomic_init(&n->version, 0UL);                                            \
+    atomic_init(&n->num, 0);                                                  \
+    n->leaf = leaf;                                                           \
+    return n;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Retire a node removed from the tree.                                     \
+     It remains readable until all threads have gone to sleep. */             \
+  static inline void                                                          \
+  M_C(name, _retire_node)(tree_t b, node_t n, m_gc_tid_t id)                  \
+  {                                                                           \
+    M_C(name, _mempool_del)(b->mempool, n, id);                               \
+  }                                                                           \
+                                                                              \
+  static inline int                                                           \
+  M_C(name, _get_num)(node_t n)                                               \
+  {                                                                           \
+    int num = atomic_load_explicit(&n->num, memory_order_relaxed);            \
+    M_ASSERT (0 <= num && num <= N);                                          \
+    return num;                                                               \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _set_num)(node_t n, int num)                                      \
+  {                                                                           \
+    M_ASSERT (0 <= num && num <= N);                                          \
+    atomic_store_explicit(&n->num, num, memory_order_relaxed);                \
+  }                                                                           \
+                                                                              \
+  /* Return the index of the first key of the node >= key (or > key          \
+     if exclusive). The keys may be concurrently modified: the result         \
+     is only meaningful if the version of the node is validated after. */     \
+  static inline int                                                           \
+  M_C(name, _search_in_node)(node_t n, int num, key_t const key, bool exclusive) \
+  {                                                                           \
+    int i;                                                                    \
+    for(i = 0; i < num; i++) {                                                \
+      int cmp = M_CALL_CMP(key_oplist, key, n->key[i]);                       \
+      if (cmp < 0 || (cmp == 0 && !exclusive))                                \
+        break;                                                                \
+    }                                                                         \
+    return i;                                                                 \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init)(tree_t b, m_gc_t gc_mem)                                   \
+  {                                                                           \
+    M_ASSERT (b != NULL && gc_mem != NULL);                                   \
+    M_C(name, _mempool_init)(b->mempool, gc_mem, M_CBPTR33_NODE_PER_GROUP, 1); \
+    b->gc_mem = gc_mem;                                                       \
+    /* The tree is not shared yet: any thread data of the pool can be used */ \
+    atomic_init(&b->root, M_C(name, _new_node)(b, true, 0));                  \
+    atomic_init(&b->size, (size_t) 0);                                        \
+  }                                                                           \
+                                                                              \
+  /* Give back the node and all its children to the node pool */              \
+  static inline void                                                          \
+  M_C(name, _clear_node)(tree_t b, node_t n)                                  \
+  {                                                                           \
+    if (!n->leaf) {                                                           \
+      const int num = M_C(name, _get_num)(n);                                 \
+      for(int i = 0; i <= num; i++) {                                         \
+        M_C(name, _clear_node)(b, n->kind.node[i]);                           \
+      }                                                                       \
+    }                                                                         \
+    M_C(name, _mempool_release)(b->mempool, n, 0);                            \
+  }                                                                           \
+                                                                              \
+  /* Clear the tree. No thread shall use the tree anymore                     \
+     and all threads shall be asleep. As for the mempool, the garbage         \
+     collector shall not be used anymore except to be cleared. */             \
+  static inline void                                                          \
+  M_C(name, _clear)(tree_t b)                                                 \
+  {                                                                           \
+    M_ASSERT (b != NULL && b->gc_mem != NULL);                                \
+    M_C(name, _clear_node)(b, atomic_load(&b->root));                         \
+    M_C(name, _mempool_clear)(b->mempool);                                    \
+    atomic_store(&b->root, (node_t) NULL);                                    \
+    b->gc_mem = NULL;                                                         \
+  }                                                                           \
+                                                                              \
+  /* Return the number of elements. It is only an estimation                  \
+     if the tree is concurrently modified. */                                 \
+  static inline size_t                                                        \
+  M_C(name, _size)(const tree_t b)                                            \
+  {                                                                           \
+    M_ASSERT (b != NULL);                                                     \
+    return atomic_load(&b->size);                                             \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _empty_p)(const tree_t b)                                         \
+  {                                                                           \
+    return M_C(name, _size)(b) == 0;                                          \
+  }                                                                           \
+                                                                              \
+  /* Read the root node and its version.                                      \
+     Return NULL if the operation shall restart */                            \
+  static inline node_t                                                        \
+  M_C(name, _read_root)(const tree_t b, unsigned long *version)               \
+  {                                                                           \
+    node_t n = atomic_load_explicit(&b->root, memory_order_acquire);          \
+    if (!m_cbptr33_read_lock(&n->version, version))                           \
+      return NULL;                                                            \
+    /* The root may have been split before its version was read */            \
+    if (n != atomic_load_explicit(&b->root, memory_order_acquire))            \
+      return NULL;                                                            \
+    return n;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Wait a little before restarting an operation */                          \
+  static inline void                                                          \
+  M_C(name, _backoff)(const tree_t b, m_gc_tid_t id)                          \
+  {                                                                           \
+    m_core_backoff_wait(b->gc_mem->thread_data[id].bkoff);                    \
+  }                                                                           \
+                                                                              \
+  /* Search for the key and copy its associated value in *value.              \
+     Return true if found, false otherwise (*value is then unchanged).        \
+     The thread 'id' shall be awake. */                                       \
+  static inline bool                                                          \
+  M_C(name, _get_copy)(value_t *value, const tree_t b, key_t const key, m_gc_tid_t id) \
+  {                                                                           \
+    M_ASSERT (b != NULL && value != NULL);                                    \
+    M_ASSERT (id < b->gc_mem->max_thread);                                    \
+    m_core_backoff_reset(b->gc_mem->thread_data[id].bkoff);                   \
+    while (true) {                                                            \
+      unsigned long v;                                                        \
+      node_t n = M_C(name, _read_root)(b, &v);                                \
+      if (M_UNLIKELY (n == NULL)) goto restart;                               \
+      while (!n->leaf) {                                                      \
+        int i = M_C(name, _search_in_node)(n, M_C(name, _get_num)(n), key, false); \
+        node_t child = n->kind.node[i];                                       \
+        if (!m_cbptr33_read_check(&n->version, v)) goto restart;              \
+        n = child;                                                            \
+        if (!m_cbptr33_read_lock(&n->version, &v)) goto restart;              \
+      }                                                                       \
+      {                                                                       \
+        const int num = M_C(name, _get_num)(n);                               \
+        const int i = M_C(name, _search_in_node)(n, num, key, false);         \
+        const bool found = i < num && M_CALL_CMP(key_oplist, key, n->key[i]) == 0; \
+        value_t tmp;                                                          \
+        if (found) tmp = n->kind.value[i];                                    \
+        if (!m_cbptr33_read_check(&n->version, v)) goto restart;              \
+        if (found) *value = tmp;                                              \
+        return found;                                                         \
+      }                                                                       \
+    restart:                                                                  \
+      M_C(name, _backoff)(b, id);                                             \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Split the locked full node 'n' in two. Return the new right node         \
+     and set in *sep the key separating both nodes */                         \
+  static inline node_t                                                        \
+  M_C(name, _split_node)(tree_t b, node_t n, key_t *sep, m_gc_tid_t id)       \
+  {                                                                           \
+    M_ASSERT (M_C(name, _get_num)(n) == N);                                   \
+    node_t r = M_C(name, _new_node)(b, n->leaf, id);                          \
+    if (n->leaf) {                                                            \
+      const int l = (N+1)/2;                                                  \
+      memcpy(&r->key[0], &n->key[l], sizeof(key_t) * (size_t) (N-l));         \
+      memcpy(&r->kind.value[0], &n->kind.value[l], sizeof(value_t) * (size_t) (N-l)); \
+      M_C(name, _set_num)(r, N-l);                                            \
+      M_C(name, _set_num)(n, l);                                              \
+      *sep = n->key[l-1];                                                     \
+    } else {                                                                  \
+      const int l = N/2;                                                      \
+      memcpy(&r->key[0], &n->key[l+1], sizeof(key_t) * (size_t) (N-1-l));    \
+      memcpy(&r->kind.node[0], &n->kind.node[l+1], sizeof(node_t) * (size_t) (N-l)); \
+      M_C(name, _set_num)(r, N-1-l);                                          \
+      M_C(name, _set_num)(n, l);                                              \
+      *sep = n->key[l];                                                       \
+    }                                                                         \
+    return r;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Insert in the locked non full inner node 'parent' the new node 'right'   \
+     after its child 'left' with the separator key 'sep' */                   \
+  static inline void                                                          \
+  M_C(name, _insert_child)(node_t parent, key_t const sep, node_t left, node_t right) \
+  {                                                                           \
+    const int num = M_C(name, _get_num)(parent);                              \
+    M_ASSERT (!parent->leaf && num < N);                                      \
+    int i = 0;                                                                \
+    while (parent->kind.node[i] != left) {                                    \
+      i++;                                                                    \
+      M_ASSERT (i <= num);                                                    \
+    }                                                                         \
+    memmove(&parent->key[i+1], &parent->key[i], sizeof(key_t) * (size_t) (num-i)); \
+    memmove(&parent->kind.node[i+2], &parent->kind.node[i+1], sizeof(node_t) * (size_t) (num-i)); \
+    parent->key[i] = sep;                                                     \
+    parent->kind.node[i+1] = right;                                           \
+    M_C(name, _set_num)(parent, num+1);                                       \
+  }                                                                           \
+                                                                              \
+  /* Split the full node 'n' locked for version 'v'.                          \
+     'parent' (or NULL if 'n' is the root) is locked for version 'pv'.        \
+     The operation shall restart afterwards. */                               \
+  static inline void                                                          \
+  M_C(name, _split)(tree_t b, node_t parent, unsigned long pv, node_t n, unsigned long v, m_gc_tid_t id) \
+  {                                                                           \
+    if (parent != NULL && !m_cbptr33_upgrade_lock(&parent->version, pv))      \
+      return;                                                                 \
+    if (!m_cbptr33_upgrade_lock(&n->version, v)) {                            \
+      if (parent != NULL) m_cbptr33_write_unlock(&parent->version);           \
+      return;                                                                 \
+    }                                                                         \
+    if (parent == NULL && n != atomic_load(&b->root)) {                       \
+      /* The root has been changed in the meantime */                         \
+      m_cbptr33_write_unlock(&n->version);                                    \
+      return;                                                                 \
+    }                                                                         \
+    key_t sep;                                                                \
+    node_t right = M_C(name, _split_node)(b, n, &sep, id);                    \
+    if (parent != NULL) {                                                     \
+      M_C(name, _insert_child)(parent, sep, n, right);                        \
+    } else {                                                                  \
+      node_t root = M_C(name, _new_node)(b, false, id);                       \
+      root->key[0] = sep;                                                     \
+      root->kind.node[0] = n;                                                 \
+      root->kind.node[1] = right;                                             \
+      M_C(name, _set_num)(root, 1);                                           \
+      atomic_store_explicit(&b->root, root, memory_order_release);            \
+    }                                                                         \
+    m_cbptr33_write_unlock(&n->version);                                      \
+    if (parent != NULL) m_cbptr33_write_unlock(&parent->version);             \
+  }                                                                           \
+                                                                              \
+  /* Set the value associated to the key (inserting it if needed).           \
+     The thread 'id' shall be awake. */                                       \
+  static inline void                                                          \
+  M_C(name, _set_at)(tree_t b, key_t const key, value_t const value, m_gc_tid_t id) \
+  {                                                                           \
+    M_ASSERT (b != NULL);                                                     \
+    M_ASSERT (id < b->gc_mem->max_thread);                                    \
+    m_core_backoff_reset(b->gc_mem->thread_data[id].bkoff);                   \
+    while (true) {                                                            \
+      unsigned long v, pv = 0;                                                \
+      node_t parent = NULL;                                                   \
+      node_t n = M_C(name, _read_root)(b, &v);                                \
+      if (M_UNLIKELY (n == NULL)) goto restart;                               \
+      while (true) {                                                          \
+        const int num = M_C(name, _get_num)(n);                               \
+        if (num == N) {                                                       \
+          /* Eager split of a full node, so that the parent never overflows */ \
+          M_C(name, _split)(b, parent, pv, n, v, id);                         \
+          goto restart;                                                       \
+        }                                                                     \
+        if (n->leaf) break;                                                   \
+        if (parent != NULL && !m_cbptr33_read_check(&parent->version, pv))    \
+          goto restart;                                                       \
+        parent = n;                                                           \
+        pv = v;                                                               \
+        int i = M_C(name, _search_in_node)(n, num, key, false);               \
+        n = n->kind.node[i];                                                  \
+        if (!m_cbptr33_read_check(&parent->version, pv)) goto restart;        \
+        if (!m_cbptr33_read_lock(&n->version, &v)) goto restart;              \
+      }                                                                       \
+      if (!m_cbptr33_upgrade_lock(&n->version, v)) goto restart;              \
+      if (parent != NULL && !m_cbptr33_read_check(&parent->version, pv)) {    \
+        m_cbptr33_write_unlock(&n->version);                                  \
+        goto restart;                                                         \
+      }                                                                       \
+      {                                                                       \
+        const int num = M_C(name, _get_num)(n);                               \
+        const int i = M_C(name, _search_in_node)(n, num, key, false);         \
+        if (i < num && M_CALL_CMP(key_oplist, key, n->key[i]) == 0) {        \
+          n->kind.value[i] = value;                                           \
+        } else {                                                              \
+          memmove(&n->key[i+1], &n->key[i], sizeof(key_t) * (size_t) (num-i)); \
+          memmove(&n->kind.value[i+1], &n->kind.value[i], sizeof(value_t) * (size_t) (num-i)); \
+          n->key[i] = key;                                                    \
+          n->kind.value[i] = value;                                           \
+          M_C(name, _set_num)(n, num+1);                                      \
+          atomic_fetch_add(&b->size, (size_t) 1);                             \
+        }                                                                     \
+        m_cbptr33_write_unlock(&n->version);                                  \
+        return;                                                               \
+      }                                                                       \
+    restart:                                                                  \
+      M_C(name, _backoff)(b, id);                                             \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Erase the key from the tree.                                             \
+     Return true if it was present, false otherwise.                          \
+     An empty leaf is removed from its parent (nodes are not merged).         \
+     The thread 'id' shall be awake. */                                       \
+  static inline bool                                                          \
+  M_C(name, _erase)(tree_t b, key_t const key, m_gc_tid_t id)                 \
+  {                                                                           \
+    M_ASSERT (b != NULL);                                                     \
+    M_ASSERT (id < b->gc_mem->max_thread);                                    \
+    m_core_backoff_reset(b->gc_mem->thread_data[id].bkoff);                   \
+    while (true) {                                                            \
+      unsigned long v, pv = 0;                                                \
+      node_t parent = NULL;                                                   \
+      int pidx = 0, pnum = 0;                                                 \
+      node_t n = M_C(name, _read_root)(b, &v);                                \
+      if (M_UNLIKELY (n == NULL)) goto restart;                               \
+      while (!n->leaf) {                                                      \
+        if (parent != NULL && !m_cbptr33_read_check(&parent->version, pv))    \
+          goto restart;                                                       \
+        parent = n;                                                           \
+        pv = v;                                                               \
+        pnum = M_C(name, _get_num)(n);                                        \
+        pidx = M_C(name, _search_in_node)(n, pnum, key, false);               \
+        n = n->kind.node[pidx];                                               \
+        if (!m_cbptr33_read_check(&parent->version, pv)) goto restart;        \
+        if (!m_cbptr33_read_lock(&n->version, &v)) goto restart;              \
+      }                                                                       \
+      {                                                                       \
+        const int num = M_C(name, _get_num)(n);                               \
+        const int i = M_C(name, _search_in_node)(n, num, key, false);         \
+        const bool found = i < num && M_CALL_CMP(key_oplist, key, n->key[i]) == 0; \
+        if (!found) {                                                         \
+          if (!m_cbptr33_read_check(&n->version, v)) goto restart;            \
+          return false;                                                       \
+        }                                                                     \
+        if (num == 1 && parent != NULL && pnum > 0) {                         \
+          /* The leaf becomes empty: remove it from its parent */             \
+          if (!m_cbptr33_upgrade_lock(&parent->version, pv)) goto restart;    \
+          if (!m_cbptr33_upgrade_lock(&n->version, v)) {                      \
+            m_cbptr33_write_unlock(&parent->version);                         \
+            goto restart;                                                     \
+          }                                                                   \
+          /* Remove the child and one of its separators */                    \
+          const int k = pidx < pnum ? pidx : pnum - 1;                        \
+          memmove(&parent->key[k], &parent->key[k+1], sizeof(key_t) * (size_t) (pnum-k-1)); \
+          memmove(&parent->kind.node[pidx], &parent->kind.node[pidx+1], sizeof(node_t) * (size_t) (pnum-pidx)); \
+          M_C(name, _set_num)(parent, pnum-1);                                \
+          m_cbptr33_write_unlock_obsolete(&n->version);                       \
+          M_C(name, _retire_node)(b, n, id);                                  \
+          if (pnum == 1 && parent == atomic_load(&b->root)) {                 \
+            /* The root has only one child: this child becomes the root */    \
+            atomic_store_explicit(&b->root, parent->kind.node[0], memory_order_release); \
+            m_cbptr33_write_unlock_obsolete(&parent->version);                \
+            M_C(name, _retire_node)(b, parent, id);                           \
+          } else {                                                            \
+            m_cbptr33_write_unlock(&parent->version);                         \
+          }                                                                   \
+        } else {                                                              \
+          if (!m_cbptr33_upgrade_lock(&n->version, v)) goto restart;          \
+          memmove(&n->key[i], &n->key[i+1], sizeof(key_t) * (size_t) (num-i-1)); \
+          memmove(&n->kind.value[i], &n->kind.value[i+1], sizeof(value_t) * (size_t) (num-i-1)); \
+          M_C(name, _set_num)(n, num-1);                                      \
+          m_cbptr33_write_unlock(&n->version);                                \
+        }                                                                     \
+        atomic_fetch_sub(&b->size, (size_t) 1);                               \
+        return true;                                                          \
+      }                                                                       \
+    restart:                                                                  \
+      M_C(name, _backoff)(b, id);                                             \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Copy in the iterator the elements of the leaf containing the first       \
+     key >= *key (or > *key if exclusive, or the first key if key is NULL).   \
+     When this leaf has no such element, go on with the next leaf             \
+     (using the separator key of the parent). */                              \
+  static inline void                                                          \
+  M_C(name, _it_fill)(it_t it, const key_t *key, bool exclusive)              \
+  {                                                                           \
+    const struct M_C(name, _s) *b = it->tree;                                 \
+    key_t fence, from;                                                        \
+    memset(&fence, 0, sizeof (key_t));                                        \
+    m_core_backoff_reset(b->gc_mem->thread_data[it->id].bkoff);               \
+    while (true) {                                                            \
+      unsigned long v;                                                        \
+      bool has_fence = false;                                                 \
+      node_t n = M_C(name, _read_root)(b, &v);                                \
+      if (M_UNLIKELY (n == NULL)) goto restart;                               \
+      while (!n->leaf) {                                                      \
+        const int num = M_C(name, _get_num)(n);                               \
+        const int i = key == NULL ? 0 : M_C(name, _search_in_node)(n, num, *key, exclusive);\
+        /* Only read an initialized key (an inner node may have no key) */    \
+        key_t f = fence;                                                      \
+        if (i < num) f = n->key[i];                                           \
+        node_t child = n->kind.node[i];                                       \
+        if (!m_cbptr33_read_check(&n->version, v)) goto restart;              \
+        if (i < num) {                                                        \
+          /* Upper bound of the keys of the child (the deepest is the tightest) */\
+          fence = f;                                                          \
+          has_fence = true;                                                   \
+        }                                                                     \
+        n = child;                                                            \
+        if (!m_cbptr33_read_lock(&n->version, &v)) goto restart;              \
+      }                                                                       \
+      {                                                                       \
+        const int num = M_C(name, _get_num)(n);                               \
+        const int i = key == NULL ? 0 : M_C(name, _search_in_node)(n, num, *key, exclusive);\
+        memcpy(&it->key[0], &n->key[i], sizeof(key_t) * (size_t) (num-i));    \
+        memcpy(&it->value[0], &n->kind.value[i], sizeof(value_t) * (size_t) (num-i));\
+        if (!m_cbptr33_read_check(&n->version, v)) goto restart;              \
+        it->idx  = 0;                                                         \
+        it->num  = num - i;                                                   \
+        it->last = !has_fence;                                                \
+        if (it->num > 0 || !has_fence)                                        \
+          return;                                                             \
+        /* Nothing found in this leaf: continue after its upper bound */      \
+        from = fence;                                                         \
+        key = &from;                                                          \
+        exclusive = true;                                                     \
+        continue;                                                             \
+      }                                                                       \
+    restart:                                                                  \
+      M_C(name, _backoff)(b, it->id);                                         \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Set the iterator to the first element whose key is >= key.               \
+     The iterator doesn't lock the tree: it sees the modifications done       \
+     concurrently on the leaves it has not reached yet.                       \
+     The thread 'id' shall be awake while the iterator is used. */            \
+  static inline void                                                          \
+  M_C(name, _it_from)(it_t it, tree_t b, key_t const key, m_gc_tid_t id)      \
+  {                                                                           \
+    M_ASSERT (it != NULL && b != NULL);                                       \
+    M_ASSERT (id < b->gc_mem->max_thread);                                    \
+    it->tree = b;                                                             \
+    it->id   = id;                                                            \
+    M_C(name, _it_fill)(it, &key, false);                                     \
+  }                                                                           \
+                                                                              \
+  /* Set the iterator to the first element of the tree */                     \
+  static inline void                                                          \
+  M_C(name, _it)(it_t it, tree_t b, m_gc_tid_t id)                            \
+  {                                                                           \
+    M_ASSERT (it != NULL && b != NULL);                                       \
+    M_ASSERT (id < b->gc_mem->max_thread);                                    \
+    it->tree = b;                                                             \
+    it->id   = id;                                                            \
+    M_C(name, _it_fill)(it, NULL, false);                                     \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _end_p)(const it_t it)                                            \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    return it->idx >= it->num;                                                \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _next)(it_t it)                                                   \
+  {                                                                           \
+    M_ASSERT (it != NULL && it->idx < it->num);                               \
+    it->idx ++;                                                               \
+    if (it->idx == it->num && !it->last) {                                    \
+      /* Continue with the next leaf, after the last seen key */              \
+      key_t last = it->key[it->num-1];                                        \
+      M_C(name, _it_fill)(it, &last, true);                                   \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline const itref_t *                                               \
+  M_C(name, _cref)(it_t it)                                                   \
+  {                                                                           \
+    M_ASSERT (it != NULL && it->idx < it->num);                               \
+    it->ref.key_ptr   = &it->key[it->idx];                                    \
+    it->ref.value_ptr = &it->value[it->idx];                                  \
+    return &it->ref;                                                          \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _it_until_p)(const it_t it, key_t const key)                      \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    if (it->idx >= it->num) return true;                                      \
+    int cmp = M_CALL_CMP(key_oplist, it->key[it->idx], key);                  \
+    return (cmp >= 0);                                                        \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _it_while_p)(const it_t it, key_t const key)                      \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    if (it->idx >= it->num) return false;                                     \
+    int cmp = M_CALL_CMP(key_oplist, it->key[it->idx], key);                  \
+    return (cmp <= 0);                                                        \
+  }                                                                           \
+
+
+/********************************** INTERNAL *********************************/
+
+#if M_USE_SMALL_NAME
+#define C_BPTREE_DEF2 M_C_BPTREE_DEF2
+#define C_BPTREE_DEF2_AS M_C_BPTREE_DEF2_AS
+#endif
+
+#endif
@@ -391,7 +391,12 @@ M_BEGIN_PROTECTED_CODE
   typedef struct M_C(name, _lfmp_thread_s) {                                  \
     M_C(name, _slist_ct)  free;                                               \
     M_C(name, _slist_ct)  to_be_reclaimed;                                    \
-    M_CACHELINE_ALIGN(align1, M_C(name, _slist_ct), M_C(name, _slist_ct));    \
+    /* Number of allocated & deleted nodes by the thread                      \
+       (only written by the thread, read by the statistics) */                \
+    atomic_size_t         new_count;                                          \
+    atomic_size_t         del_count;                                          \
+    M_CACHELINE_ALIGN(align1, M_C(name, _slist_ct), M_C(name, _slist_ct),     \
+                      atomic_size_t, atomic_size_t);                          \
   } M_C(name, _lfmp_thread_ct);                                               \
                                                                               \
   static inline void                                                          \
@@ -399,6 +404,8 @@ M_BEGIN_PROTECTED_CODE
   {                                                                           \
     M_C(name, _slist_init)(t->free);                                          \
     M_C(name, _slist_init)(t->to_be_reclaimed);                               \
+    atomic_init(&t->new_count, (size_t) 0);                                   \
+    atomic_init(&t->del_count, (size_t) 0);                                   \
   }                                                                           \
                                                                               \
   static inline void                                                          \
@@ -420,8 +427,49 @@ M_BEGIN_PROTECTED_CODE
     M_C(name, _lflist_ct)      empty;                                         \
     m_cmemp00l_list_ct       mempool_node;                                    \
     struct m_gc_s            *gc_mem;                                         \
+    /* Counters of the mempool (nodes requested to the system, highest        \
+       value of it & number of groups in the free list) */                    \
+    atomic_size_t            allocated;                                       \
+    atomic_size_t            peak;                                            \
+    atomic_size_t            free_groups;                                     \
+    atomic_size_t            trim_threshold;                                  \
   } M_C(name, _t)[1];                                                         \
                                                                               \
+  /* Account for 'n' new nodes requested to the system */                     \
+  static inline void                                                          \
+  M_C3(m_cmemp00l_,name,_count_alloc)(struct M_C(name, _s) *mem, size_t n)    \
+  {                                                                           \
+    size_t a = atomic_fetch_add(&mem->allocated, n) + n;                      \
+    size_t p = atomic_load_explicit(&mem->peak, memory_order_relaxed);        \
+    while (p < a && !atomic_compare_exchange_weak_explicit(&mem->peak, &p, a, \
+                                                           memory_order_relaxed, \
+                                                           memory_order_relaxed)) { } \
+  }                                                                           \
+                                                                              \
+  /* Give back to the system the nodes of the groups of the free list         \
+     until there are at most 'keep' groups in it.                             \
+     Return the number of nodes given back to the system */                   \
+  static inline size_t                                                        \
+  M_C3(m_cmemp00l_,name,_trim_to)(struct M_C(name, _s) *mem, m_gc_tid_t id, size_t keep) \
+  {                                                                           \
+    size_t released = 0;                                                      \
+    while (atomic_load(&mem->free_groups) > keep) {                           \
+      M_C(name, _lf_node_t) *node;                                            \
+      node = M_C(name, _lflist_pop)(mem->free, mem->gc_mem->thread_data[id].bkoff); \
+      if (node == NULL) break;                                                \
+      atomic_fetch_sub(&mem->free_groups, (size_t) 1);                        \
+      while (!M_C(name, _slist_empty_p)(node->list)) {                        \
+        M_C(name, _slist_node_ct) *snode = M_C(name, _slist_pop)(node->list); \
+        M_MEMORY_DEL(snode);                                                  \
+        released ++;                                                          \
+      }                                                                       \
+      /* Push back the empty group */                                         \
+      M_C(name, _lflist_push)(mem->empty, node, mem->gc_mem->thread_data[id].bkoff); \
+    }                                                                         \
+    atomic_fetch_sub(&mem->allocated, released);                              \
+    return released;                                                          \
+  }                                                                           \
+                                                                              \
   /* Garbage collect of the nodes of the mempool on sleep */                  \
   static inline void                                                          \
   M_C3(m_cmemp00l_,name,_gc_on_sleep)(m_gc_t gc_mem, m_cmemp00l_list_ct *data, \
@@ -455,6 +503,15 @@ M_BEGIN_PROTECTED_CODE
                                        min_ticket, gc_mem->thread_data[id].bkoff); \
       if (node == NULL) break;                                                \
       M_C(name, _lflist_push)(mempool->free, node, gc_mem->thread_data[id].bkoff); \
+      atomic_fetch_add(&mempool->free_groups, (size_t) 1);                    \
+    }                                                                         \
+                                                                              \
+    /* Give back the free groups above the high-water mark to the system */   \
+    const size_t threshold = atomic_load_explicit(&mempool->trim_threshold,   \
+                                                  memory_order_relaxed);      \
+    if (M_UNLIKELY (threshold != 0)) {                                        \
+      const size_t group_size = mempool->initial * sizeof(M_C(name, _slist_node_ct)); \
+      M_C3(m_cmemp00l_,name,_trim_to)(mempool, id, threshold / group_size);   \
     }                                                                         \
   }                                                                           \
                                                                               \
@@ -474,6 +531,12 @@ M_BEGIN_PROTECTED_CODE
     }                                                                         \
     /* Preallocate some group of nodes for the mempool */                     \
     mem->initial = M_MAX(M_CMEMP00L_MIN_NODE_PER_GROUP, init_node_count);     \
+    atomic_init(&mem->allocated, (size_t) 0);                                 \
+    atomic_init(&mem->peak, (size_t) 0);                                      \
+    atomic_init(&mem->free_groups, (size_t) (init_group_count > 0 ? init_group_count - 1 : 0)); \
+    atomic_init(&mem->trim_threshold, (size_t) 0);                            \
+    M_C3(m_cmemp00l_,name,_count_alloc)(mem, (size_t) init_node_count         \
+                                        * (init_group_count > 0 ? init_group_count + 1 : 2)); \
     M_C(name, _lflist_init)(mem->free, M_C(name, _alloc_node)(init_node_count)); \
     M_C(name, _lflist_init)(mem->to_be_reclaimed, M_C(name, _alloc_node)(init_node_count)); \
     M_C(name, _lflist_init)(mem->empty, M_C(name, _alloc_node)(0));           \
@@ -515,6 +578,11 @@ M_BEGIN_PROTECTED_CODE
       /* Fast & likely path where we access the thread pool of nodes */       \
       if (M_LIKELY(!M_C(name, _slist_empty_p)(mem->thread_data[id].free))) {  \
         snode = M_C(name, _slist_pop)(mem->thread_data[id].free);             \
+        /* Only this thread updates its counter: no atomic RMW is needed */   \
+        atomic_store_explicit(&mem->thread_data[id].new_count,                \
+                              atomic_load_explicit(&mem->thread_data[id].new_count, \
+                                                   memory_order_relaxed) + 1, \
+                              memory_order_relaxed);                          \
         return &snode->data;                                                  \
       }                                                                       \
       /* Request a group node to the freelist of groups */                    \
@@ -525,6 +593,9 @@ M_BEGIN_PROTECTED_CODE
         node = M_C(name, _alloc_node)(mem->initial);                          \
         M_ASSERT(node != NULL);                                               \
         M_ASSERT(!M_C(name, _slist_empty_p)(node->list));                     \
+        M_C3(m_cmemp00l_,name,_count_alloc)(mem, mem->initial);               \
+      } else {                                                                \
+        atomic_fetch_sub(&mem->free_groups, (size_t) 1);                      \
       }                                                                       \
       M_C(name, _slist_move)(mem->thread_data[id].free, node->list);          \
       /* Push back the empty group */                                         \
@@ -540,6 +611,73 @@ M_BEGIN_PROTECTED_CODE
     M_ASSERT( d != NULL);                                                     \
     snode = M_TYPE_FROM_FIELD(M_C(name, _slist_node_ct), d, type_t, data);    \
     M_C(name, _slist_push)(mem->thread_data[id].to_be_reclaimed, snode);      \
+    atomic_store_explicit(&mem->thread_data[id].del_count,                    \
+                          atomic_load_explicit(&mem->thread_data[id].del_count, \
+                                               memory_order_relaxed) + 1,     \
+                          memory_order_relaxed);                              \
+  }                                                                           \
+                                                                              \
+  /* Give back immediately a node to the free nodes of the thread 'id',       \
+     without waiting for a garbage collection: no thread shall be able        \
+     to read it anymore (for example when clearing a whole structure) */      \
+  static inline void                                                          \
+  M_C(name, _release)(M_C(name, _t) mem, type_t *d, m_gc_tid_t id)            \
+  {                                                                           \
+    M_C(name, _slist_node_ct) *snode;                                         \
+    M_ASSERT( d != NULL);                                                     \
+    snode = M_TYPE_FROM_FIELD(M_C(name, _slist_node_ct), d, type_t, data);    \
+    M_C(name, _slist_push)(mem->thread_data[id].free, snode);                 \
+    atomic_store_explicit(&mem->thread_data[id].del_count,                    \
+                          atomic_load_explicit(&mem->thread_data[id].del_count, \
+                                               memory_order_relaxed) + 1,     \
+                          memory_order_relaxed);                              \
+  }                                                                           \
+                                                                              \
+  /* Give back to the system the free nodes of the calling thread and         \
+     the nodes of the free groups of the mempool (except the last one         \
+     which is the dummy node of the queue). The thread shall be awake.        \
+     Return the number of bytes given back to the system */                   \
+  static inline size_t                                                        \
+  M_C(name, _trim)(M_C(name, _t) mem, m_gc_tid_t id)                          \
+  {                                                                           \
+    size_t released = 0;                                                      \
+    while (!M_C(name, _slist_empty_p)(mem->thread_data[id].free)) {           \
+      M_C(name, _slist_node_ct) *snode = M_C(name, _slist_pop)(mem->thread_data[id].free); \
+      M_MEMORY_DEL(snode);                                                    \
+      released ++;                                                            \
+    }                                                                         \
+    atomic_fetch_sub(&mem->allocated, released);                              \
+    released += M_C3(m_cmemp00l_,name,_trim_to)(mem, id, 0);                  \
+    return released * sizeof(M_C(name, _slist_node_ct));                      \
+  }                                                                           \
+                                                                              \
+  /* Set the high-water mark (in bytes) of the free groups of nodes:          \
+     on garbage collection, the free groups above it are given back           \
+     to the system (0 disables it) */                                         \
+  static inline void                                                          \
+  M_C(name, _set_trim_threshold)(M_C(name, _t) mem, size_t threshold)         \
+  {                                                                           \
+    atomic_store(&mem->trim_threshold, threshold);                            \
+  }                                                                           \
+                                                                              \
+  /* Return the memory footprint of the mempool.                              \
+     The counters are updated concurrently by the threads:                    \
+     the result is only an approximation if some threads are awake. */        \
+  static inline m_mempool_stats_t                                             \
+  M_C(name, _stats)(M_C(name, _t) mem)                                        \
+  {                                                                           \
+    m_mempool_stats_t stats;                                                  \
+    size_t new_count = 0, del_count = 0;                                      \
+    for(unsigned i = 0; i < mem->gc_mem->max_thread; i++) {                   \
+      del_count += atomic_load(&mem->thread_data[i].del_count);               \
+      new_count += atomic_load(&mem->thread_data[i].new_count);               \
+    }                                                                         \
+    const size_t in_use = new_count > del_count ? new_count - del_count : 0;  \
+    stats.allocated = atomic_load(&mem->allocated) * sizeof(M_C(name, _slist_node_ct)); \
+    stats.in_use    = M_MIN(in_use * sizeof(type_t), stats.allocated);        \
+    stats.free      = stats.allocated - stats.in_use;                         \
+    stats.peak      = atomic_load(&mem->peak) * sizeof(M_C(name, _slist_node_ct)); \
+    return stats;                                                             \
   }                                                                           \
 
 
@@ -681,19 +819,85 @@ m_gc_sleep(m_gc_t gc_mem, m_gc_tid_t id)
 /*                                                                     */
 /***********************************************************************/
 
-M_CMEMP00L_DEF_SINGLY_LIST(m_vlapool, char)
-M_CMEMP00L_DEF_LF_QUEUE(m_vlapool, char)
-M_CMEMP00L_DEF_SYSTEM_ALLOC(m_vlapool, char)
+/* The Variable Length Array mempool segregates the objects by size classes:
+   16 to 64 bytes by step of 16, then 2 classes per power of 2 up to 4096.
+   Bigger objects are directly allocated by the system.
+   Each thread owns a magazine of free objects per size class (a singly list)
+   that only it can access.
+   The deleted objects are logically deleted (their data remain readable
+   until the future GC). Once their grace period is finished, they are
+   moved by the thread that performs the GC into its own magazines,
+   whatever the thread that has allocated them (cross-thread free).
+   When a magazine is too big, half of it is pushed as a group into the
+   Lock Free Queue of free groups of the size class, from which the threads
+   whose magazine is empty can get a full group of objects.
+   A group of nodes popped from a queue of free groups goes through the
+   Lock Free Queue of groups to be reclaimed before being reused,
+   to avoid the ABA problem (see above). */
+
+/* User shall be able to customize the number of objects of a group
+   exchanged between a magazine and the free queue of a size class */
+#ifndef M_USE_VLAPOOL_MAGAZINE_SIZE
+#define M_USE_VLAPOOL_MAGAZINE_SIZE 32
+#endif
+
+#define M_VLAPOOL_MAX_SIZE 4096
+#define M_VLAPOOL_NUM_CLASS 16
+
+/* Header of an object of the VLA mempool: its size class
+   (M_VLAPOOL_NUM_CLASS for the objects allocated by the system) */
+typedef struct m_vlapool_header_s {
+  size_t size_class;
+} m_vlapool_header_ct;
+
+M_CMEMP00L_DEF_SINGLY_LIST(m_vlapool, m_vlapool_header_ct)
+M_CMEMP00L_DEF_LF_QUEUE(m_vlapool, m_vlapool_header_ct)
+M_CMEMP00L_DEF_SYSTEM_ALLOC(m_vlapool, m_vlapool_header_ct)
+
+/* Return the size class of an object of 'size' bytes */
+static inline unsigned int
+m_cmemp00l_vlapool_class(size_t size)
+{
+  if (size <= 64) {
+    return size == 0 ? 0 : (unsigned int) ((size - 1) / 16);
+  }
+  if (size > M_VLAPOOL_MAX_SIZE) {
+    return M_VLAPOOL_NUM_CLASS;
+  }
+  // 2 classes per power of 2: b is the highest bit of size-1 (6 <= b < 12)
+  const uint32_t s = (uint32_t) (size - 1);
+  const unsigned int b = 31 - m_core_clz32(s);
+  M_ASSERT (b >= 6 && b < 12);
+  return 2 * b - 8 + ((s >> (b - 1)) & 1);
+}
+
+/* Return the size of the objects of the given size class */
+static inline size_t
+m_cmemp00l_vlapool_class_size(unsigned int c)
+{
+  M_ASSERT (c < M_VLAPOOL_NUM_CLASS);
+  if (c < 4) {
+    return 16 * (size_t) (c + 1);
+  }
+  const unsigned int b = 6 + (c - 4) / 2;
+  return ((size_t) 1 << b) + ((c - 4) % 2 + 1) * ((size_t) 1 << (b - 1));
+}
 
 typedef struct m_vlapool_lfmp_thread_s {
   m_vlapool_slist_ct  to_be_reclaimed;
-  M_CACHELINE_ALIGN(align1, m_vlapool_slist_ct);
+  m_vlapool_slist_ct  magazine[M_VLAPOOL_NUM_CLASS];
+  unsigned int        count[M_VLAPOOL_NUM_CLASS];
+  char                align1[M_ALIGN_FOR_CACHELINE_EXCLUSION];
 } m_vlapool_lfmp_thread_ct;
 
 static inline void
 m_vlapool_lfmp_thread_init(m_vlapool_lfmp_thread_ct *t)
 {
   m_vlapool_slist_init(t->to_be_reclaimed);
+  for(unsigned i = 0; i < M_VLAPOOL_NUM_CLASS; i++) {
+    m_vlapool_slist_init(t->magazine[i]);
+    t->count[i] = 0;
+  }
 }
 
 static inline void
@@ -701,16 +905,66 @@ m_vlapool_lfmp_thread_clear(m_vlapool_lfmp_thread_ct *t)
 {
   M_ASSERT(m_vlapool_slist_empty_p(t->to_be_reclaimed));
   m_vlapool_slist_clear(t->to_be_reclaimed);
+  for(unsigned i = 0; i < M_VLAPOOL_NUM_CLASS; i++) {
+    m_vlapool_slist_clear(t->magazine[i]);
+    t->count[i] = 0;
+  }
 }
 
 typedef struct m_vlapool_s {
   m_vlapool_lflist_ct        to_be_reclaimed;
   m_vlapool_lflist_ct        empty;
+  m_vlapool_lflist_ct        free[M_VLAPOOL_NUM_CLASS];
   m_vlapool_lfmp_thread_ct  *thread_data;
   m_cmemp00l_list_ct      mvla_node;
   struct m_gc_s             *gc_mem;
 } m_vlapool_t[1];
 
+/* Get an empty group of nodes */
+static inline m_vlapool_lf_node_t *
+m_cmemp00l_vlapool_empty_group(struct m_vlapool_s *vlapool, m_gc_tid_t id)
+{
+  m_vlapool_lf_node_t *node;
+  node = m_vlapool_lflist_pop(vlapool->empty, vlapool->gc_mem->thread_data[id].bkoff);
+  if (M_UNLIKELY (node == NULL)) {
+    /* Fail to get an empty group of node.
+       Alloc a new one from the system */
+    node = m_vlapool_alloc_node(0);
+    M_ASSERT(node != NULL);
+  }
+  M_ASSERT(m_vlapool_slist_empty_p(node->list));
+  return node;
+}
+
+/* Move a reclaimed node into the magazine of its size class
+   (or give it back to the system if it has been allocated by the system) */
+static inline void
+m_cmemp00l_vlapool_recycle(struct m_vlapool_s *vlapool, m_gc_tid_t id,
+                           m_vlapool_slist_node_ct *snode)
+{
+  const size_t c = snode->data.size_class;
+  if (M_UNLIKELY (c >= M_VLAPOOL_NUM_CLASS)) {
+    M_MEMORY_FREE(snode);
+    return;
+  }
+  m_vlapool_lfmp_thread_ct *t = &vlapool->thread_data[id];
+  m_vlapool_slist_push(t->magazine[c], snode);
+  t->count[c] ++;
+  if (M_UNLIKELY (t->count[c] >= 2 * M_USE_VLAPOOL_MAGAZINE_SIZE)) {
+    /* Too many free nodes in the magazine.
+       Share a group of them with the other threads */
+    m_vlapool_lf_node_t *node = m_cmemp00l_vlapool_empty_group(vlapool, id);
+    for(unsigned i = 0; i < M_USE_VLAPOOL_MAGAZINE_SIZE; i++) {
+      m_vlapool_slist_push(node->list, m_vlapool_slist_pop(t->magazine[c]));
+    }
+    t->count[c] -= M_USE_VLAPOOL_MAGAZINE_SIZE;
+    // The counter of the group is its number of nodes
+    atomic_store_explicit(&node->cpt, (m_gc_ticket_ct) M_USE_VLAPOOL_MAGAZINE_SIZE,
+                          memory_order_relaxed);
+    m_vlapool_lflist_push(vlapool->free[c], node, vlapool->gc_mem->thread_data[id].bkoff);
+  }
+}
+
 /* Garbage collect of the nodes of the vla mempool on sleep */
 static inline void
 m_cmemp00l_vlapool_on_sleep(m_gc_t gc_mem, m_cmemp00l_list_ct *data,
@@ -722,16 +976,7 @@ m_cmemp00l_vlapool_on_sleep(m_gc_t gc_mem, m_cmemp00l_list_ct *data,
 
   /* Move the local nodes of the vlapool to be reclaimed to the thread into the global pool */
   if (!m_vlapool_slist_empty_p(vlapool->thread_data[id].to_be_reclaimed)) {
-    m_vlapool_lf_node_t *node;
-    /* Get a new empty group of nodes */
-    node = m_vlapool_lflist_pop(vlapool->empty, gc_mem->thread_data[id].bkoff);
-    if (M_UNLIKELY (node == NULL)) {
-      /* Fail to get an empty group of node.
-         Alloc a new one from the system */
-      node = m_vlapool_alloc_node(0);
-      M_ASSERT(node != NULL);
-    }
-    M_ASSERT(m_vlapool_slist_empty_p(node->list));
+    m_vlapool_lf_node_t *node = m_cmemp00l_vlapool_empty_group(vlapool, id);
     m_vlapool_slist_move(node->list, vlapool->thread_data[id].to_be_reclaimed);
     atomic_store_explicit(&node->cpt, ticket, memory_order_relaxed);
     m_vlapool_lflist_push(vlapool->to_be_reclaimed, node, gc_mem->thread_data[id].bkoff);
@@ -743,10 +988,11 @@ m_cmemp00l_vlapool_on_sleep(m_gc_t gc_mem, m_cmemp00l_list_ct *data,
     node = m_vlapool_lflist_pop_if(vlapool->to_be_reclaimed,
                                    min_ticket, gc_mem->thread_data[id].bkoff);
     if (node == NULL) break;
-    // No reuse of VLA nodes. Free physically the node back to the system
-    m_vlapool_slist_clear(node->list);
+    // Reuse the nodes through the magazines of the thread
+    while (!m_vlapool_slist_empty_p(node->list)) {
+      m_cmemp00l_vlapool_recycle(vlapool, id, m_vlapool_slist_pop(node->list));
+    }
     // Add back the empty group of nodes
-    m_vlapool_slist_init(node->list);
     m_vlapool_lflist_push(vlapool->empty, node, gc_mem->thread_data[id].bkoff);
   }
 }
@@ -769,6 +1015,9 @@ m_vlapool_init(m_vlapool_t mem, m_gc_t gc_mem)
   /* Initialize the lists */
   m_vlapool_lflist_init(mem->to_be_reclaimed, m_vlapool_alloc_node(0));
   m_vlapool_lflist_init(mem->empty, m_vlapool_alloc_node(0));
+  for(unsigned i = 0; i < M_VLAPOOL_NUM_CLASS; i++) {
+    m_vlapool_lflist_init(mem->free[i], m_vlapool_alloc_node(0));
+  }
 
   /* Register the mempool in the GC */
   mem->mvla_node.gc_on_sleep = m_cmemp00l_vlapool_on_sleep;
@@ -787,6 +1036,9 @@ m_vlapool_clear(m_vlapool_t mem)
   M_MEMORY_FREE(mem->thread_data);
   mem->thread_data = NULL;
   m_vlapool_lflist_clear(mem->empty);
+  for(unsigned i = 0; i < M_VLAPOOL_NUM_CLASS; i++) {
+    m_vlapool_lflist_clear(mem->free[i]);
+  }
   M_ASSERT(m_vlapool_lflist_empty_p(mem->to_be_reclaimed));
   m_vlapool_lflist_clear(mem->to_be_reclaimed);
   /* TODO: Unregister from the GC? */
@@ -799,16 +1051,44 @@ m_vlapool_new(m_vlapool_t mem, m_gc_tid_t id, size_t size)
   M_ASSERT(id < mem->gc_mem->max_thread);
   M_ASSERT( atomic_load(&mem->gc_mem->thread_data[id].ticket) != ULONG_MAX);
 
-  // Nothing to do with theses parameters yet
-  (void) mem;
-  (void) id;
-
-  // Ensure the size is big enough to also represent a node
-  size += offsetof(struct m_vlapool_slist_node_s, data);
+  m_vlapool_slist_node_ct *snode;
+  const unsigned int c = m_cmemp00l_vlapool_class(size);
+  if (M_LIKELY (c < M_VLAPOOL_NUM_CLASS)) {
+    m_vlapool_lfmp_thread_ct *t = &mem->thread_data[id];
+    /* Fast & likely path where we access the magazine of the thread */
+    if (M_UNLIKELY (m_vlapool_slist_empty_p(t->magazine[c]))) {
+      /* Request a group of nodes to the free queue of the size class */
+      m_vlapool_lf_node_t *node;
+      node = m_vlapool_lflist_pop(mem->free[c], mem->gc_mem->thread_data[id].bkoff);
+      if (node != NULL) {
+        m_vlapool_slist_move(t->magazine[c], node->list);
+        t->count[c] = (unsigned int) atomic_load_explicit(&node->cpt, memory_order_relaxed);
+        /* The group shall not be reused before the end of the grace period
+           of the threads currently awaken: push it in the queue of the
+           groups to be reclaimed with the current ticket */
+        atomic_store_explicit(&node->cpt, atomic_load(&mem->gc_mem->ticket),
+                              memory_order_relaxed);
+        m_vlapool_lflist_push(mem->to_be_reclaimed, node, mem->gc_mem->thread_data[id].bkoff);
+      }
+    }
+    if (M_LIKELY (!m_vlapool_slist_empty_p(t->magazine[c]))) {
+      snode = m_vlapool_slist_pop(t->magazine[c]);
+      t->count[c] --;
+      M_ASSERT (snode->data.size_class == c);
+      return M_ASSIGN_CAST(void *, snode + 1);
+    }
+    size = m_cmemp00l_vlapool_class_size(c);
+  }
 
-  // Simply wrap around a system call to get the memory
-  char *ptr = M_MEMORY_REALLOC(char, NULL, size);
-  return (ptr == NULL) ? NULL : M_ASSIGN_CAST(void *, ptr + offsetof(struct m_vlapool_slist_node_s, data));
+  // Request a new node to the system. Non Lock Free path
+  char *ptr = M_MEMORY_REALLOC(char, NULL, sizeof (m_vlapool_slist_node_ct) + size);
+  if (M_UNLIKELY (ptr == NULL)) {
+    M_MEMORY_FULL(sizeof (m_vlapool_slist_node_ct) + size);
+    return NULL;
+  }
+  snode = M_ASSIGN_CAST(m_vlapool_slist_node_ct *, M_ASSIGN_CAST(void *, ptr));
+  snode->data.size_class = c;
+  return M_ASSIGN_CAST(void *, snode + 1);
 }
 
 static inline void
@@ -820,12 +1100,380 @@ m_vlapool_del(m_vlapool_t mem, void *d, m_gc_tid_t id)
   M_ASSERT(d != NULL);
 
   // Get back the pointer to a struct m_vlapool_slist_node_s.
-  d = M_ASSIGN_CAST(void *, M_ASSIGN_CAST(char *, d) - offsetof(struct m_vlapool_slist_node_s, data));
-  m_vlapool_slist_node_ct *snode = M_ASSIGN_CAST(m_vlapool_slist_node_ct *, d);
+  m_vlapool_slist_node_ct *snode = M_ASSIGN_CAST(m_vlapool_slist_node_ct *, d) - 1;
+  M_ASSERT(snode->data.size_class <= M_VLAPOOL_NUM_CLASS);
   // Push the logicaly free memory into the list of the nodes to be reclaimed.
   m_vlapool_slist_push(mem->thread_data[id].to_be_reclaimed, snode);
 }
 
+/***********************************************************************/
+/*                                                                     */
+/*                  Epoch Based Reclamation of objects                 */
+/*                                                                     */
+/***********************************************************************/
+
+/* Destructor of a retired object */
+typedef void (*m_ebr_destructor_t)(void *);
+
+/* A retired object with its destructor */
+typedef struct m_ebr_retired_s {
+  void              *ptr;
+  m_ebr_destructor_t destructor;
+} m_ebr_retired_ct;
+
+/* A batch of objects retired by a thread during the same awake period.
+   They are all reclaimed at the same time, once the ticket of the batch
+   is older than the ones of all the awake threads. */
+typedef struct m_ebr_batch_s {
+  struct m_ebr_batch_s *next;
+  m_gc_ticket_ct        ticket;
+  size_t                size;
+  size_t                alloc;
+  m_ebr_retired_ct     *tab;
+} m_ebr_batch_ct;
+
+/* Per thread retire lists: the batch being filled
+   and the FIFO of the batches waiting for the end of their grace period */
+typedef struct m_ebr_thread_s {
+  m_ebr_batch_ct *current;
+  m_ebr_batch_ct *head;
+  m_ebr_batch_ct *tail;
+  M_CACHELINE_ALIGN(align1, m_ebr_batch_ct *, m_ebr_batch_ct *, m_ebr_batch_ct *);
+} m_ebr_thread_ct;
+
+typedef struct m_ebr_s {
+  m_ebr_thread_ct      *thread_data;
+  m_cmemp00l_list_ct    ebr_node;
+  struct m_gc_s        *gc_mem;
+} m_ebr_t[1];
+
+/* Call the destructors of the objects of the batch and free it */
+static inline void
+m_cmemp00l_ebr_batch_reclaim(m_ebr_batch_ct *batch)
+{
+  for(size_t i = 0; i < batch->size; i++) {
+    batch->tab[i].destructor(batch->tab[i].ptr);
+  }
+  M_MEMORY_FREE(batch->tab);
+  M_MEMORY_DEL(batch);
+}
+
+/* Garbage collect of the retired objects on sleep */
+static inline void
+m_cmemp00l_ebr_on_sleep(m_gc_t gc_mem, m_cmemp00l_list_ct *data,
+                        m_gc_tid_t id, m_gc_ticket_ct ticket, m_gc_ticket_ct min_ticket)
+{
+  (void) gc_mem;
+  /* Get back the EBR from the node */
+  struct m_ebr_s *ebr =
+    M_TYPE_FROM_FIELD(struct m_ebr_s, data, m_cmemp00l_list_ct, ebr_node);
+  m_ebr_thread_ct *t = &ebr->thread_data[id];
+
+  /* Close the batch of the objects retired during this awake period */
+  m_ebr_batch_ct *batch = t->current;
+  if (batch != NULL) {
+    batch->ticket = ticket;
+    batch->next   = NULL;
+    if (t->tail == NULL) {
+      t->head = batch;
+    } else {
+      t->tail->next = batch;
+    }
+    t->tail = batch;
+    t->current = NULL;
+  }
+
+  /* Reclaim the batches whose grace period is finished */
+  while (t->head != NULL && t->head->ticket < min_ticket) {
+    batch = t->head;
+    t->head = batch->next;
+    if (t->head == NULL) {
+      t->tail = NULL;
+    }
+    m_cmemp00l_ebr_batch_reclaim(batch);
+  }
+}
+
+/* Initialize the EBR 'ebr' and register it in the garbage collector 'gc_mem'.
+   No thread shall be awake. */
+static inline void
+m_ebr_init(m_ebr_t ebr, m_gc_t gc_mem)
+{
+  const size_t max_thread = gc_mem->max_thread;
+  ebr->thread_data = M_MEMORY_REALLOC(m_ebr_thread_ct, NULL, max_thread);
+  if (ebr->thread_data == NULL) {
+    M_MEMORY_FULL(max_thread * sizeof(m_ebr_thread_ct));
+    return;
+  }
+  for(unsigned i = 0; i < max_thread; i++) {
+    ebr->thread_data[i].current = NULL;
+    ebr->thread_data[i].head    = NULL;
+    ebr->thread_data[i].tail    = NULL;
+  }
+  /* Register the EBR in the GC */
+  ebr->ebr_node.gc_on_sleep = m_cmemp00l_ebr_on_sleep;
+  ebr->ebr_node.next = gc_mem->mempool_list;
+  gc_mem->mempool_list = &ebr->ebr_node;
+  ebr->gc_mem = gc_mem;
+}
+
+/* Reclaim all the retired objects, unregister the EBR from the garbage
+   collector and clear it. No thread shall be awake. */
+static inline void
+m_ebr_clear(m_ebr_t ebr)
+{
+  const unsigned max_thread = ebr->gc_mem->max_thread;
+  for(unsigned i = 0; i < max_thread; i++) {
+    m_ebr_thread_ct *t = &ebr->thread_data[i];
+    M_ASSERT(atomic_load(&ebr->gc_mem->thread_data[i].ticket) == ULONG_MAX);
+    while (t->head != NULL) {
+      m_ebr_batch_ct *next = t->head->next;
+      m_cmemp00l_ebr_batch_reclaim(t->head);
+      t->head = next;
+    }
+    if (t->current != NULL) {
+      m_cmemp00l_ebr_batch_reclaim(t->current);
+    }
+  }
+  M_MEMORY_FREE(ebr->thread_data);
+  ebr->thread_data = NULL;
+  /* Unregister the EBR from the GC */
+  m_cmemp00l_list_ct **it = &ebr->gc_mem->mempool_list;
+  while (*it != &ebr->ebr_node) {
+    M_ASSERT(*it != NULL);
+    it = &(*it)->next;
+  }
+  *it = ebr->ebr_node.next;
+  ebr->gc_mem = NULL;
+}
+
+/* Retire the object 'ptr' which has been removed from a concurrent structure
+   by the awake thread 'id': 'destructor' is called on it once all the threads
+   that were awake at this time have gone to sleep. */
+static inline void
+m_ebr_retire(m_ebr_t ebr, m_gc_tid_t id, void *ptr, m_ebr_destructor_t destructor)
+{
+  M_ASSERT(ebr != NULL && ebr->gc_mem != NULL);
+  M_ASSERT(id < ebr->gc_mem->max_thread);
+  M_ASSERT(atomic_load(&ebr->gc_mem->thread_data[id].ticket) != ULONG_MAX);
+  M_ASSERT(destructor != NULL);
+
+  m_ebr_thread_ct *t = &ebr->thread_data[id];
+  m_ebr_batch_ct *batch = t->current;
+  if (M_UNLIKELY (batch == NULL)) {
+    batch = M_MEMORY_ALLOC(m_ebr_batch_ct);
+    if (M_UNLIKELY (batch == NULL)) {
+      M_MEMORY_FULL(sizeof(m_ebr_batch_ct));
+      return;
+    }
+    batch->size  = 0;
+    batch->alloc = 0;
+    batch->tab   = NULL;
+    t->current = batch;
+  }
+  if (M_UNLIKELY (batch->size >= batch->alloc)) {
+    const size_t alloc = M_MAX((size_t) 16, 2 * batch->alloc);
+    m_ebr_retired_ct *tab = M_MEMORY_REALLOC(m_ebr_retired_ct, batch->tab, alloc);
+    if (M_UNLIKELY (tab == NULL)) {
+      M_MEMORY_FULL(alloc * sizeof(m_ebr_retired_ct));
+      return;
+    }
+    batch->tab   = tab;
+    batch->alloc = alloc;
+  }
+  batch->tab[batch->size].ptr        = ptr;
+  batch->tab[batch->size].destructor = destructor;
+  batch->size ++;
+}
+
+
+/***********************************************************************/
+/*                                                                     */
+/*                 Hazard pointers reclamation of objects              */
+/*                                                                     */
+/***********************************************************************/
+
+/* Per thread list of retired objects */
+typedef struct m_hazard_thread_s {
+  m_ebr_retired_ct *tab;
+  size_t            size;
+  size_t            alloc;
+  M_CACHELINE_ALIGN(align1, m_ebr_retired_ct *, size_t, size_t);
+} m_hazard_thread_ct;
+
+/* Hazard pointers domain:
+   each thread has 'num_slots' hazard pointers that only it can write.
+   The retired objects of a thread are scanned once their number reaches
+   the threshold, and the ones that are not protected by any hazard pointer
+   are reclaimed: the number of pending objects is bounded. */
+typedef struct m_hazard_s {
+  unsigned            max_thread;
+  unsigned            num_slots;
+  size_t              threshold;
+  atomic_uintptr_t   *slots;
+  m_hazard_thread_ct *thread_data;
+  m_genint_t          thread_alloc;
+} m_hazard_t[1];
+
+/* Compare two addresses (for qsort & bsearch) */
+static inline int
+m_cmemp00l_cmp_uintptr(const void *a, const void *b)
+{
+  const uintptr_t pa = *(const uintptr_t *) a;
+  const uintptr_t pb = *(const uintptr_t *) b;
+  return (pa > pb) - (pa < pb);
+}
+
+static inline void
+m_hazard_init(m_hazard_t h, size_t max_thread, unsigned num_slots)
+{
+  M_ASSERT(h != NULL);
+  M_ASSERT(max_thread > 0 && max_thread < INT_MAX && num_slots > 0);
+  const size_t n = max_thread * num_slots;
+  h->slots = M_MEMORY_REALLOC(atomic_uintptr_t, NULL, n);
+  h->thread_data = M_MEMORY_REALLOC(m_hazard_thread_ct, NULL, max_thread);
+  if (h->slots == NULL || h->thread_data == NULL) {
+    M_MEMORY_FULL(n * sizeof(atomic_uintptr_t) + max_thread * sizeof(m_hazard_thread_ct));
+    return;
+  }
+  for(size_t i = 0; i < n; i++) {
+    atomic_init(&h->slots[i], (uintptr_t) 0);
+  }
+  for(size_t i = 0; i < max_thread; i++) {
+    h->thread_data[i].tab   = NULL;
+    h->thread_data[i].size  = 0;
+    h->thread_data[i].alloc = 0;
+  }
+  m_genint_init(h->thread_alloc, (unsigned int) max_thread);
+  h->max_thread = (unsigned int) max_thread;
+  h->num_slots  = num_slots;
+  h->threshold  = M_MAX(2 * n, (size_t) 16);
+}
+
+/* Reclaim all the retired objects and clear the domain.
+   No thread shall be attached. */
+static inline void
+m_hazard_clear(m_hazard_t h)
+{
+  for(unsigned i = 0; i < h->max_thread; i++) {
+    m_hazard_thread_ct *t = &h->thread_data[i];
+    for(size_t j = 0; j < t->size; j++) {
+      t->tab[j].destructor(t->tab[j].ptr);
+    }
+    M_MEMORY_FREE(t->tab);
+  }
+  M_MEMORY_FREE(h->thread_data);
+  M_MEMORY_FREE(h->slots);
+  h->thread_data = NULL;
+  h->slots = NULL;
+  m_genint_clear(h->thread_alloc);
+}
+
+static inline m_gc_tid_t
+m_hazard_attach_thread(m_hazard_t h)
+{
+  M_ASSERT(h != NULL && h->max_thread > 0);
+  unsigned id = m_genint_pop(h->thread_alloc);
+  return M_ASSIGN_CAST(m_gc_tid_t, id);
+}
+
+/* Protect the object 'ptr' with the hazard pointer 'slot' of the thread 'id'.
+   The caller shall check that 'ptr' is still reachable after this call
+   (by reading again the shared variable it was loaded from)
+   before dereferencing it. */
+static inline void
+m_hazard_set(m_hazard_t h, m_gc_tid_t id, unsigned slot, const void *ptr)
+{
+  M_ASSERT(id < h->max_thread && slot < h->num_slots);
+  atomic_store(&h->slots[id * h->num_slots + slot], (uintptr_t) ptr);
+}
+
+/* Release the protection of the hazard pointer 'slot' of the thread 'id' */
+static inline void
+m_hazard_reset(m_hazard_t h, m_gc_tid_t id, unsigned slot)
+{
+  M_ASSERT(id < h->max_thread && slot < h->num_slots);
+  atomic_store_explicit(&h->slots[id * h->num_slots + slot], (uintptr_t) 0,
+                        memory_order_release);
+}
+
+/* Reclaim the retired objects of the thread 'id'
+   that are not protected by any hazard pointer */
+static inline void
+m_hazard_scan(m_hazard_t h, m_gc_tid_t id)
+{
+  M_ASSERT(id < h->max_thread);
+  m_hazard_thread_ct *t = &h->thread_data[id];
+  const size_t n = (size_t) h->max_thread * h->num_slots;
+  uintptr_t *protected_tab = M_MEMORY_REALLOC(uintptr_t, NULL, n);
+  if (M_UNLIKELY (protected_tab == NULL)) {
+    /* Reclamation is delayed until the next scan */
+    return;
+  }
+  /* Get a snapshot of all the hazard pointers */
+  size_t num = 0;
+  for(size_t i = 0; i < n; i++) {
+    uintptr_t p = atomic_load(&h->slots[i]);
+    if (p != 0) {
+      protected_tab[num++] = p;
+    }
+  }
+  qsort(protected_tab, num, sizeof(uintptr_t), m_cmemp00l_cmp_uintptr);
+  /* Reclaim the objects that are not in the snapshot */
+  size_t j = 0;
+  for(size_t i = 0; i < t->size; i++) {
+    const uintptr_t p = (uintptr_t) t->tab[i].ptr;
+    if (num > 0 && bsearch(&p, protected_tab, num, sizeof(uintptr_t), m_cmemp00l_cmp_uintptr) != NULL) {
+      t->tab[j++] = t->tab[i];
+    } else {
+      t->tab[i].destructor(t->tab[i].ptr);
+    }
+  }
+  t->size = j;
+  M_MEMORY_FREE(protected_tab);
+}
+
+/* Retire the object 'ptr' which has been removed from a concurrent structure
+   by the thread 'id': 'destructor' is called on it once it is no longer
+   protected by any hazard pointer. */
+static inline void
+m_hazard_retire(m_hazard_t h, m_gc_tid_t id, void *ptr, m_ebr_destructor_t destructor)
+{
+  M_ASSERT(id < h->max_thread);
+  M_ASSERT(destructor != NULL);
+  m_hazard_thread_ct *t = &h->thread_data[id];
+  if (M_UNLIKELY (t->size >= t->alloc)) {
+    const size_t alloc = M_MAX((size_t) 16, 2 * t->alloc);
+    m_ebr_retired_ct *tab = M_MEMORY_REALLOC(m_ebr_retired_ct, t->tab, alloc);
+    if (M_UNLIKELY (tab == NULL)) {
+      M_MEMORY_FULL(alloc * sizeof(m_ebr_retired_ct));
+      return;
+    }
+    t->tab   = tab;
+    t->alloc = alloc;
+  }
+  t->tab[t->size].ptr        = ptr;
+  t->tab[t->size].destructor = destructor;
+  t->size ++;
+  if (M_UNLIKELY (t->size >= h->threshold)) {
+    m_hazard_scan(h, id);
+  }
+}
+
+/* Detach the thread 'id': its hazard pointers are released
+   and its retired objects are scanned. The objects still protected
+   are reclaimed by the next thread using this id or by m_hazard_clear. */
+static inline void
+m_hazard_detach_thread(m_hazard_t h, m_gc_tid_t id)
+{
+  M_ASSERT(id < h->max_thread);
+  for(unsigned i = 0; i < h->num_slots; i++) {
+    m_hazard_reset(h, id, i);
+  }
+  m_hazard_scan(h, id);
+  m_genint_push(h->thread_alloc, id);
+}
+
 M_END_PROTECTED_CODE
 
 #if M_USE_SMALL_NAME
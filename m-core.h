@@ -294,6 +294,107 @@ M_BEGIN_PROTECTED_CODE
   } while (0)
 #endif
 
+/* Define the interface of a stateful allocator.
+ * The containers whose oplist has the ALLOCATOR method store a pointer
+ * to such an interface and perform all their allocations through it:
+ * void *allocate(state, size): Return a new block of 'size' bytes
+ *    suitably aligned for any object, or NULL in case of failure.
+ * void *reallocate(state, ptr, old_size, new_size): Reallocate the block
+ *    'ptr' of 'old_size' bytes to 'new_size' bytes and return it
+ *    ('ptr' is NULL if 'old_size' is 0). It returns NULL in case of
+ *    failure in which case the original block is not modified.
+ * void deallocate(state, ptr, size): Free the block 'ptr' of 'size' bytes
+ *    ('ptr' may be NULL).
+ * 'state' is the context given to all these functions.
+ */
+typedef struct m_allocator_s {
+  void *(*allocate)(void *state, size_t size);
+  void *(*reallocate)(void *state, void *ptr, size_t old_size, size_t new_size);
+  void (*deallocate)(void *state, void *ptr, size_t size);
+  void *state;
+} m_allocator_t;
+
+static inline void *
+m_core_allocator_allocate(void *state, size_t size)
+{
+  (void) state;
+  return M_MEMORY_REALLOC(char, NULL, size);
+}
+
+static inline void *
+m_core_allocator_reallocate(void *state, void *ptr, size_t old_size, size_t new_size)
+{
+  (void) state;
+  (void) old_size;
+  return M_MEMORY_REALLOC(char, ptr, new_size);
+}
+
+static inline void
+m_core_allocator_deallocate(void *state, void *ptr, size_t size)
+{
+  (void) state;
+  (void) size;
+  M_MEMORY_FREE(ptr);
+}
+
+/* Return the stateless allocator using the M_MEMORY_REALLOC and
+   M_MEMORY_FREE macros (the default value of the ALLOCATOR method) */
+static inline const m_allocator_t *
+m_core_allocator_default(void)
+{
+  static const m_allocator_t allocator = {
+    m_core_allocator_allocate, m_core_allocator_reallocate,
+    m_core_allocator_deallocate, NULL
+  };
+  return &allocator;
+}
+
+/* Allocate, reallocate or free the memory of a container:
+ * if the oplist has the ALLOCATOR method, it uses the allocator 'a'
+ * stored in the container, otherwise it uses the NEW, DEL, REALLOC & FREE
+ * methods of the oplist (and neither 'a' nor the sizes are evaluated).
+ * M_CALL_DEL_CTX & M_CALL_FREE_CTX need the type (and the number of objects)
+ * of the freed block as the allocator may need its size.
+ */
+#define M_CALL_NEW_CTX(oplist, a, type)                                       \
+  M_IF_METHOD(ALLOCATOR, oplist)(M_ALL0CATOR_NEW(a, type),                    \
+                                 M_CALL_NEW(oplist, type))
+#define M_CALL_DEL_CTX(oplist, a, type, ptr)                                  \
+  M_IF_METHOD(ALLOCATOR, oplist)(M_ALL0CATOR_FREE(a, type, ptr, 1),           \
+                                 M_CALL_DEL(oplist, ptr))
+#define M_CALL_REALLOC_CTX(oplist, a, type, ptr, old_n, n)                    \
+  M_IF_METHOD(ALLOCATOR, oplist)(M_ALL0CATOR_REALLOC(a, type, ptr, old_n, n), \
+                                 M_CALL_REALLOC(oplist, type, ptr, n))
+#define M_CALL_FREE_CTX(oplist, a, type, ptr, n)                              \
+  M_IF_METHOD(ALLOCATOR, oplist)(M_ALL0CATOR_FREE(a, type, ptr, n),           \
+                                 M_CALL_FREE(oplist, ptr))
+
+#define M_ALL0CATOR_NEW(a, type)                                              \
+  ((type *) (a)->allocate((a)->state, sizeof (type)))
+#define M_ALL0CATOR_REALLOC(a, type, ptr, old_n, n)                           \
+  (M_UNLIKELY ((n) > SIZE_MAX / sizeof (type)) ? NULL                         \
+   : (type *) (a)->reallocate((a)->state, (ptr), (old_n) * sizeof (type),     \
+                              (n) * sizeof (type)))
+#define M_ALL0CATOR_FREE(a, type, ptr, n)                                     \
+  (a)->deallocate((a)->state, (ptr), (n) * sizeof (type))
+
+/* Declare the field storing the allocator of a container
+   (only if the oplist has the ALLOCATOR method) */
+#define M_ALL0CATOR_FIELD(oplist)                                             \
+  M_IF_METHOD(ALLOCATOR, oplist)(const m_allocator_t *allocator;, )
+
+/* Memory footprint of a mempool (in bytes):
+   - allocated: memory requested to the system,
+   - in_use: memory of the objects currently allocated by the user,
+   - free: memory kept by the mempool for future allocations,
+   - peak: highest value of allocated since the initialization. */
+typedef struct m_mempool_stats_s {
+  size_t allocated;
+  size_t in_use;
+  size_t free;
+  size_t peak;
+} m_mempool_stats_t;
+
 
 /************************************************************/
 /*********************  ERROR handling **********************/
@@ -1333,6 +1434,8 @@ M_BEGIN_PROTECTED_CODE
 #define M_PATTERN_queue_queue ,
 #define M_PATTERN_QUEUE_QUEUE ,
 #define M_PATTERN_INIT_WITH_INIT_WITH ,
+#define M_PATTERN_M_CMP_BASIC_M_CMP_BASIC ,
+#define M_PATTERN_M_CMP_DEFAULT_M_CMP_DEFAULT ,
 #define M_PATTERN____ ,
 
 
@@ -2835,6 +2938,76 @@ static inline size_t m_core_cstr_hash(const char str[])
 #define M_HASH_DEFAULT(a)       M_HASH_POD_DEFAULT(a)
 #endif
 
+/* Size of the buffer given to the KEY_BYTES method */
+#define M_KEY_BYTES_SIZE 16
+
+/* Encode the 'size' lower bytes of an integer in big endian in 'buffer'
+   (flipping its sign bit if it is signed) so that the lexicographic order
+   of the bytes is the order of the integers. Return the buffer. */
+static inline const unsigned char *
+m_core_key_bytes(unsigned char buffer[], size_t *len,
+                 unsigned long long key, size_t size, bool is_signed)
+{
+  M_ASSERT (size <= sizeof key && size <= M_KEY_BYTES_SIZE);
+  for(size_t i = size; i-- > 0; ) {
+    buffer[i] = (unsigned char) key;
+    key >>= CHAR_BIT;
+  }
+  if (is_signed) {
+    buffer[0] ^= 1U << (CHAR_BIT - 1);
+  }
+  *len = size;
+  return buffer;
+}
+
+/* Encode a double in 8 bytes so that the lexicographic order of the bytes
+   is the numerical order: the sign bit of a positive number is flipped,
+   all the bits of a negative number are flipped.
+   -0.0 is encoded as 0.0. The order of the NaN is unspecified.
+   This assumes an IEEE 754 binary64 double. Return the buffer. */
+static inline const unsigned char *
+m_core_key_bytes_double(unsigned char buffer[], size_t *len, double key)
+{
+  uint64_t u;
+  M_STATIC_ASSERT(sizeof (double) == sizeof (uint64_t),
+                  M_LIB_NOT_A_BASIC_TYPE,
+                  "double is not an IEEE 754 binary64 number.");
+  key = key == 0 ? 0.0 : key;
+  memcpy(&u, &key, sizeof u);
+  u = (u >> 63) ? ~u : u ^ (UINT64_C(1) << 63);
+  return m_core_key_bytes(buffer, len, u, sizeof u, false);
+}
+
+/* Encode a float in 4 bytes with the same order preserving encoding */
+static inline const unsigned char *
+m_core_key_bytes_float(unsigned char buffer[], size_t *len, float key)
+{
+  uint32_t u;
+  M_STATIC_ASSERT(sizeof (float) == sizeof (uint32_t),
+                  M_LIB_NOT_A_BASIC_TYPE,
+                  "float is not an IEEE 754 binary32 number.");
+  key = key == 0 ? 0.0f : key;
+  memcpy(&u, &key, sizeof u);
+  u = (u >> 31) ? ~u : u ^ (UINT32_C(1) << 31);
+  return m_core_key_bytes(buffer, len, u, sizeof u, false);
+}
+
+/* Define default KEY_BYTES method for the integer types.
+   Types smaller than int are promoted (and encoded) as int.
+   Any other type (floating point, pointer, structure) is rejected
+   at compile time by the unevaluated integer only operator '%':
+   such keys need an explicit KEY_BYTES method. */
+#define M_KEY_BYTES_DEFAULT(buffer, len, key)                                 \
+  ((void) sizeof ((key) % 1),                                                 \
+   m_core_key_bytes((buffer), (len), (unsigned long long) (key),              \
+                    sizeof ((key) + 0), (0 * (key) - 1) < (0 * (key))))
+
+/* Define the KEY_BYTES methods of the floating point types */
+#define M_KEY_BYTES_FLOAT(buffer, len, key)                                   \
+  m_core_key_bytes_float((buffer), (len), (key))
+#define M_KEY_BYTES_DOUBLE(buffer, len, key)                                  \
+  m_core_key_bytes_double((buffer), (len), (key))
+
 
 
 /************************************************************/
@@ -2858,6 +3031,7 @@ static inline size_t m_core_cstr_hash(const char str[])
 #define M_FREE_FREE(a)           ,a,
 #define M_MEMPOOL_MEMPOOL(a)     ,a,
 #define M_MEMPOOL_LINKAGE_MEMPOOL_LINKAGE(a)     ,a,
+#define M_ALLOCATOR_ALLOCATOR(a) ,a,
 #define M_HASH_HASH(a)           ,a,
 #define M_EQUAL_EQUAL(a)         ,a,
 #define M_CMP_CMP(a)             ,a,
@@ -2916,6 +3090,7 @@ static inline size_t m_core_cstr_hash(const char str[])
 #define M_LIMITS_LIMITS(a)       ,a,
 #define M_PROPERTIES_PROPERTIES(a) ,a,
 #define M_EMPLACE_TYPE_EMPLACE_TYPE(a) ,a,
+#define M_KEY_BYTES_KEY_BYTES(a) ,a,
 
 // Properties only
 #define M_LET_AS_INIT_WITH_LET_AS_INIT_WITH(a) ,a,
@@ -2943,6 +3118,7 @@ static inline size_t m_core_cstr_hash(const char str[])
 #define M_GET_FREE(...)      M_GET_METHOD(FREE,        M_FREE_DEFAULT,     __VA_ARGS__)
 #define M_GET_MEMPOOL(...)   M_GET_METHOD(MEMPOOL,     M_NO_DEFAULT,       __VA_ARGS__)
 #define M_GET_MEMPOOL_LINKAGE(...)   M_GET_METHOD(MEMPOOL_LINKAGE, ,       __VA_ARGS__)
+#define M_GET_ALLOCATOR(...) M_GET_METHOD(ALLOCATOR,   m_core_allocator_default(), __VA_ARGS__)
 #define M_GET_HASH(...)      M_GET_METHOD(HASH,        M_NO_DEFAULT,       __VA_ARGS__)
 #define M_GET_EQUAL(...)     M_GET_METHOD(EQUAL,       M_EQUAL_DEFAULT,    __VA_ARGS__)
 #define M_GET_CMP(...)       M_GET_METHOD(CMP,         M_CMP_DEFAULT,      __VA_ARGS__)
@@ -3001,6 +3177,7 @@ static inline size_t m_core_cstr_hash(const char str[])
 #define M_GET_LIMITS(...)    M_GET_METHOD(LIMITS,      M_LIMITS_DEFAULT,   __VA_ARGS__)
 #define M_GET_PROPERTIES(...) M_GET_METHOD(PROPERTIES, (),                 __VA_ARGS__)
 #define M_GET_EMPLACE_TYPE(...) M_GET_METHOD(EMPLACE_TYPE, M_NO_DEFAULT,   __VA_ARGS__)
+#define M_GET_KEY_BYTES(...) M_GET_METHOD(KEY_BYTES,   M_KEY_BYTES_DEFAULT, __VA_ARGS__)
 
 // Calling method with support of defined transformation API
 // operators that are not methods are commented
@@ -3069,6 +3246,7 @@ static inline size_t m_core_cstr_hash(const char str[])
 #define M_CALL_INC_ALLOC(oplist, ...) M_APPLY_API(M_GET_INC_ALLOC oplist, oplist, __VA_ARGS__)
 #define M_CALL_OOR_SET(oplist, ...) M_APPLY_API(M_GET_OOR_SET oplist, oplist, __VA_ARGS__)
 #define M_CALL_OOR_EQUAL(oplist, ...) M_APPLY_API(M_GET_OOR_EQUAL oplist, oplist, __VA_ARGS__)
+#define M_CALL_KEY_BYTES(oplist, ...) M_APPLY_API(M_GET_KEY_BYTES oplist, oplist, __VA_ARGS__)
 //#define M_CALL_LIMITS(oplist, ...) M_APPLY_API(M_GET_LIMITS oplist, oplist, __VA_ARGS__)
 //#define M_CALL_PROPERTIES(oplist, ...) M_APPLY_API(M_GET_PROPERTIES oplist, oplist, __VA_ARGS__)
 //#define M_CALL_EMPLACE_TYPE(oplist, ...) M_APPLY_API(M_GET_EMPLACE_TYPE oplist, oplist, __VA_ARGS__)
@@ -3725,8 +3903,8 @@ m_core_parse2_enum (const char str[], const char **endptr)
 #define M_OPL_int() M_BASIC_OPLIST
 #define M_OPL_unsigned() M_BASIC_OPLIST
 #define M_OPL_long() M_BASIC_OPLIST
-#define M_OPL_float() M_BASIC_OPLIST
-#define M_OPL_double() M_BASIC_OPLIST
+#define M_OPL_float() M_OPEXTEND(M_BASIC_OPLIST, KEY_BYTES(M_KEY_BYTES_FLOAT))
+#define M_OPL_double() M_OPEXTEND(M_BASIC_OPLIST, KEY_BYTES(M_KEY_BYTES_DOUBLE))
 
 
 /************************************************************/
@@ -106,6 +106,7 @@
   typedef struct M_C(name, _node_s) {                                         \
     ILIST_INTERFACE(M_C(name, _node_list), struct M_C(name, _node_s));        \
     size_t size;                                                              \
+    M_IF_METHOD(ALLOCATOR, oplist)(size_t alloc; /* Allocated size */, )      \
     type  data[M_MIN_FLEX_ARRAY_SIZE];                                        \
   } node_t;                                                                   \
                                                                               \
@@ -114,8 +115,11 @@
      automatically with the intrusive list used for storing the nodes:        \
      so we register as a DEL operator the FREE operator of the oplist.        \
      The interfaces are compatible.                                           \
+     If the oplist has the ALLOCATOR method, the allocator needs the deque    \
+     and the size of the node, so the nodes are deleted by the deque itself.  \
   */                                                                          \
-  ILIST_DEF(M_C(name, _node_list), node_t, (DEL(M_GET_FREE oplist)) )         \
+  ILIST_DEF(M_C(name, _node_list), node_t,                                    \
+            (M_IF_METHOD(ALLOCATOR, oplist)(, DEL(M_GET_FREE oplist))) )      \
                                                                               \
   /* Define an internal iterator */                                           \
   typedef struct M_C(name, _it2_s) {                                          \
@@ -136,6 +140,7 @@
     M_C(name, _it2_ct)      back;                                             \
     size_t                  default_size;                                     \
     size_t                  count;                                            \
+    M_ALL0CATOR_FIELD(oplist)                                                 \
   } deque_t[1];                                                               \
                                                                               \
   /* Define pointer alias */                                                  \
@@ -168,14 +173,15 @@
     }                                                                         \
     /* Alloc a new node with dynamic size */                                  \
     node_t*n = (node_t*) (void*)                                              \
-      M_CALL_REALLOC(oplist, char, NULL,                                      \
-                     sizeof(node_t) + def * sizeof(type) );                   \
+      M_CALL_REALLOC_CTX(oplist, d->allocator, char, NULL, 0,                 \
+                         sizeof(node_t) + def * sizeof(type) );               \
     if (n==NULL) {                                                            \
       M_MEMORY_FULL(sizeof(node_t)+def * sizeof(type));                       \
       return NULL;                                                            \
     }                                                                         \
     /* Initialize the node */                                                 \
     n->size = def;                                                            \
+    M_IF_METHOD(ALLOCATOR, oplist)(n->alloc = def;, )                         \
     M_C(name, _node_list_init_field)(n);                                      \
     /* Increase the next bucket allocation */                                 \
     /* Do not increase it too much if there are few items */                  \
@@ -185,8 +191,18 @@
     return n;                                                                 \
   }                                                                           \
                                                                               \
+  /* Free a node of a deque (already unlinked) */                             \
   static inline void                                                          \
-  M_C(name, _init)(deque_t d)                                                 \
+  M_C3(m_d3qu3_,name,_del_node)(deque_t d, node_t *n)                         \
+  {                                                                           \
+    (void) d; /* unused if no ALLOCATOR */                                    \
+    M_CALL_FREE_CTX(oplist, d->allocator, char, n,                            \
+                    sizeof(node_t) + n->alloc * sizeof(type));                \
+  }                                                                           \
+                                                                              \
+  /* Initialize the deque with its first node (allocator already set) */      \
+  static inline void                                                          \
+  M_C3(m_d3qu3_,name,_init)(deque_t d)                                        \
   {                                                                           \
     M_C(name, _node_list_init)(d->list);                                      \
     d->default_size = M_USE_DEQUE_DEFAULT_SIZE;                               \
@@ -202,6 +218,30 @@
   }                                                                           \
                                                                               \
   static inline void                                                          \
+  M_C(name, _init)(deque_t d)                                                 \
+  {                                                                           \
+    M_IF_METHOD(ALLOCATOR, oplist)(d->allocator = M_GET_ALLOCATOR oplist;, )  \
+    M_C3(m_d3qu3_,name,_init)(d);                                             \
+  }                                                                           \
+                                                                              \
+  M_IF_METHOD(ALLOCATOR, oplist)(                                             \
+  static inline void                                                          \
+  M_C(name, _init_allocator)(deque_t d, const m_allocator_t *allocator)       \
+  {                                                                           \
+    M_ASSERT (allocator != NULL);                                             \
+    d->allocator = allocator;                                                 \
+    M_C3(m_d3qu3_,name,_init)(d);                                             \
+  }                                                                           \
+                                                                              \
+  static inline const m_allocator_t *                                         \
+  M_C(name, _allocator)(const deque_t d)                                      \
+  {                                                                           \
+    M_ASSERT (d != NULL);                                                     \
+    return d->allocator;                                                      \
+  }                                                                           \
+  , /* No ALLOCATOR */ )                                                      \
+                                                                              \
+  static inline void                                                          \
   M_C(name, _reset)(deque_t d)                                                \
   {                                                                           \
     M_D3QU3_CONTRACT(d);                                                      \
@@ -232,6 +272,11 @@
     M_D3QU3_CONTRACT(d);                                                      \
     M_C(name, _reset)(d);                                                     \
     /* We have registered the delete operator to clear all objects */         \
+    M_IF_METHOD(ALLOCATOR, oplist)(                                           \
+      while (!M_C(name, _node_list_empty_p)(d->list)) {                       \
+        M_C3(m_d3qu3_,name,_del_node)(d, M_C(name, _node_list_pop_back)(d->list)); \
+      }                                                                       \
+    , )                                                                       \
     M_C(name, _node_list_clear)(d->list);                                     \
     /* It is safer to clean some variables */                                 \
     d->front->node  = NULL;                                                   \
@@ -711,7 +756,7 @@
         /* Node deletion */                                                   \
         M_ASSERT(d->count > 1);                                               \
         M_C(name, _node_list_unlink)(n);                                      \
-        M_CALL_FREE(oplist, n);                                               \
+        M_C3(m_d3qu3_,name,_del_node)(d, n);                                  \
       } else {                                                                \
         memmove(&n->data[it->index], &n->data[it->index+1],                   \
                 sizeof(type) * (it->node->size - it->index - 1));             \
@@ -726,8 +771,9 @@
     M_D3QU3_CONTRACT(d);                                                      \
   }                                                                           \
                                                                               \
+  /* Initialize 'd' as a copy of 'src' (allocator of 'd' already set) */      \
   static inline void                                                          \
-  M_C(name, _init_set)(deque_t d, const deque_t src)                          \
+  M_C3(m_d3qu3_,name,_init_copy)(deque_t d, const deque_t src)                \
   {                                                                           \
     M_D3QU3_CONTRACT(src);                                                    \
     M_ASSERT (d != NULL);                                                     \
@@ -754,13 +800,21 @@
   }                                                                           \
                                                                               \
   static inline void                                                          \
+  M_C(name, _init_set)(deque_t d, const deque_t src)                          \
+  {                                                                           \
+    M_ASSERT (d != NULL && src != NULL);                                      \
+    M_IF_METHOD(ALLOCATOR, oplist)(d->allocator = src->allocator;, )          \
+    M_C3(m_d3qu3_,name,_init_copy)(d, src);                                   \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
   M_C(name, _set)(deque_t d, deque_t const src)                               \
   {                                                                           \
     if (M_UNLIKELY (src == d))                                                \
       return;                                                                 \
     /* TODO: Reuse memory of d! */                                            \
     M_C(name, _clear)(d);                                                     \
-    M_C(name, _init_set)(d, src);                                             \
+    M_C3(m_d3qu3_,name,_init_copy)(d, src);                                   \
   }                                                                           \
                                                                               \
   static inline void                                                          \
@@ -775,6 +829,7 @@
     d->back->index  = src->back->index;                                       \
     d->default_size = src->default_size;                                      \
     d->count        = src->count;                                             \
+    M_IF_METHOD(ALLOCATOR, oplist)(d->allocator = src->allocator;, )          \
     memset(src, 0, sizeof(deque_t));                                          \
     M_D3QU3_CONTRACT(d);                                                      \
   }                                                                           \
@@ -801,6 +856,7 @@
     M_SWAP(size_t, d->back->index, e->back->index);                           \
     M_SWAP(size_t, d->default_size, e->default_size);                         \
     M_SWAP(size_t, d->count, e->count);                                       \
+    M_IF_METHOD(ALLOCATOR, oplist)(M_SWAP(const m_allocator_t *, d->allocator, e->allocator);, ) \
     M_D3QU3_CONTRACT(d);                                                      \
     M_D3QU3_CONTRACT(e);                                                      \
   }                                                                           \
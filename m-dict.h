@@ -180,6 +180,12 @@
 
 /********************************** INTERNAL ************************************/
 
+/* Extend the oplist with the ALLOCATOR method of the key oplist (if any)
+   so that the buckets of a chained dictionary use the same allocator */
+#define M_D1CT_ALLOCATOR_OPLIST(key_oplist, oplist)                           \
+  M_IF_METHOD(ALLOCATOR, key_oplist)(                                         \
+    M_OPEXTEND(oplist, ALLOCATOR(M_GET_ALLOCATOR key_oplist)), oplist)
+
 /* Define a dictionary from the key key_type to the value value_type.
    It is defined as an array of singly linked list (each list
    representing a bucket of items with the same hash value modulo the
@@ -296,12 +302,12 @@
    LIST_DEF(M_C(name, _list_pair), pair_type,                                 \
       M_OPEXTEND(pair_oplist, MEMPOOL(M_GET_MEMPOOL key_oplist), MEMPOOL_LINKAGE(M_GET_MEMPOOL_LINKAGE key_oplist))) \
    ,                                                                          \
-   LIST_DEF(M_C(name, _list_pair), pair_type, pair_oplist)                    \
+   LIST_DEF(M_C(name, _list_pair), pair_type, M_D1CT_ALLOCATOR_OPLIST(key_oplist, pair_oplist)) \
   )                                                                           \
                                                                               \
   /* Define the array of list of buckets    */                                \
   ARRAY_DEF(M_C(name, _array_list_pair), M_C(name, _list_pair_ct),            \
-            LIST_OPLIST(M_C(name, _list_pair), pair_oplist))                  \
+            M_D1CT_ALLOCATOR_OPLIST(key_oplist, LIST_OPLIST(M_C(name, _list_pair), pair_oplist))) \
                                                                               \
   /* Define chained dict type */                                              \
   typedef struct M_C(name, _s) {                                              \
@@ -332,6 +338,24 @@
   typedef value_type M_C(name, _value_ct);                                    \
   typedef dict_it_t M_C(name, _it_ct);                                        \
                                                                               \
+  /* Make the buckets [from, size) of the table use the allocator of the      \
+     table (they are empty and were initialized with the default one) */      \
+  static inline void                                                          \
+  M_C3(m_d1ct_,name,_fix_allocator)(dict_t map, size_t from)                  \
+  {                                                                           \
+    M_IF_METHOD(MEMPOOL, key_oplist)((void) map; (void) from;,                \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(                                       \
+      const m_allocator_t *a = M_C(name, _array_list_pair_allocator)(map->table); \
+      size_t size = M_C(name, _array_list_pair_size)(map->table);             \
+      for(size_t i = from; i < size; i++) {                                   \
+        M_C(name, _list_pair_ct) *list =                                      \
+          M_C(name, _array_list_pair_get)(map->table, i);                     \
+        M_ASSERT (M_C(name, _list_pair_empty_p)(*list));                      \
+        M_C(name, _list_pair_init_allocator)(*list, a);                       \
+      }                                                                       \
+    , (void) map; (void) from;) )                                             \
+  }                                                                           \
+                                                                              \
   static inline void                                                          \
   M_C(name, _init)(dict_t map)                                                \
   {                                                                           \
@@ -344,6 +368,28 @@
     M_D1CT_CONTRACT(name, map);                                               \
   }                                                                           \
                                                                               \
+  M_IF_METHOD(ALLOCATOR, key_oplist)(                                         \
+  static inline void                                                          \
+  M_C(name, _init_allocator)(dict_t map, const m_allocator_t *allocator)      \
+  {                                                                           \
+    M_ASSERT (map != NULL && allocator != NULL);                              \
+    map->count = 0;                                                           \
+    M_C(name, _array_list_pair_init_allocator)(map->table, allocator);        \
+    M_C(name, _array_list_pair_resize)(map->table, M_D1CT_INITIAL_SIZE);      \
+    M_C3(m_d1ct_,name,_fix_allocator)(map, 0);                                \
+    map->lower_limit = M_D1CT_LOWER_BOUND(M_D1CT_INITIAL_SIZE);               \
+    map->upper_limit = M_D1CT_UPPER_BOUND(M_D1CT_INITIAL_SIZE);               \
+    M_D1CT_CONTRACT(name, map);                                               \
+  }                                                                           \
+                                                                              \
+  static inline const m_allocator_t *                                         \
+  M_C(name, _allocator)(const dict_t map)                                     \
+  {                                                                           \
+    M_D1CT_CONTRACT(name, map);                                               \
+    return M_C(name, _array_list_pair_allocator)(map->table);                 \
+  }                                                                           \
+  , /* No ALLOCATOR */ )                                                      \
+                                                                              \
   static inline void                                                          \
   M_C(name, _init_set)(dict_t map, const dict_t org)                          \
   {                                                                           \
@@ -364,7 +410,20 @@
     map->count = org->count;                                                  \
     map->lower_limit = org->lower_limit;                                      \
     map->upper_limit = org->upper_limit;                                      \
-    M_C(name, _array_list_pair_set)(map->table, org->table);                  \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(                                       \
+      /* The buckets of map shall keep the allocator of map */                \
+      if (M_UNLIKELY (map == org)) return;                                    \
+      size_t size = M_C(name, _array_list_pair_size)(org->table);             \
+      M_C(name, _array_list_pair_reset)(map->table);                          \
+      M_C(name, _array_list_pair_resize)(map->table, size);                   \
+      M_C3(m_d1ct_,name,_fix_allocator)(map, 0);                              \
+      for(size_t i = 0; i < size; i++) {                                      \
+        M_C(name, _list_pair_set)(*M_C(name, _array_list_pair_get)(map->table, i), \
+                                  *M_C(name, _array_list_pair_cget)(org->table, i)); \
+      }                                                                       \
+    ,                                                                         \
+      M_C(name, _array_list_pair_set)(map->table, org->table);                \
+    )                                                                         \
     M_D1CT_CONTRACT(name, map);                                               \
   }                                                                           \
                                                                               \
@@ -415,6 +474,7 @@
   {                                                                           \
     M_C(name, _array_list_pair_reset)(map->table);                            \
     M_C(name, _array_list_pair_resize)(map->table, M_D1CT_INITIAL_SIZE);      \
+    M_C3(m_d1ct_,name,_fix_allocator)(map, 0);                                \
     map->lower_limit = M_D1CT_LOWER_BOUND(M_D1CT_INITIAL_SIZE);               \
     map->upper_limit = M_D1CT_UPPER_BOUND(M_D1CT_INITIAL_SIZE);               \
     map->count = 0;                                                           \
@@ -459,6 +519,7 @@
     M_ASSERT (old_size > 1 && new_size > 1);                                  \
     /* Resize the table of the dictionnary */                                 \
     M_C(name, _array_list_pair_resize)(map->table, new_size);                 \
+    M_C3(m_d1ct_,name,_fix_allocator)(map, old_size);                         \
     /* Move the items to the new upper part */                                \
     for(size_t i = 0; i < old_size; i++) {                                    \
       M_C(name, _list_pair_ct) *list =                                        \
@@ -1277,6 +1338,7 @@ enum m_d1ct_oa_element_e {
     size_t mask, count, count_delete;                                         \
     size_t upper_limit, lower_limit;                                          \
     struct M_C(name, _pair_s) *data;                                          \
+    M_ALL0CATOR_FIELD(key_oplist) /* Allocator (if ALLOCATOR method) */       \
   } dict_t[1];                                                                \
   typedef struct M_C(name, _s) *M_C(name, _ptr);                              \
   typedef const struct M_C(name, _s) *M_C(name, _srcptr);                     \
@@ -1301,15 +1363,16 @@ enum m_d1ct_oa_element_e {
     dict->lower_limit = (size <= M_D1CT_INITIAL_SIZE) ? 0 : (size_t) ((double) size * coeff_down) ; \
   }                                                                           \
                                                                               \
+  /* Initialize the table (the allocator, if any, is already set) */          \
   static inline void                                                          \
-  M_C(name, _init)(dict_t dict)                                               \
+  M_C3(m_d1ct_,name,_init_table)(dict_t dict)                                 \
   {                                                                           \
     M_ASSERT(0 <= (coeff_down) && (coeff_down)*2 < (coeff_up) && (coeff_up) < 1); \
     dict->mask = M_D1CT_INITIAL_SIZE-1;                                       \
     dict->count = 0;                                                          \
     dict->count_delete = 0;                                                   \
     M_C3(m_d1ct_,name,_update_limit)(dict, M_D1CT_INITIAL_SIZE);              \
-    dict->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_ct), NULL, M_D1CT_INITIAL_SIZE); \
+    dict->data = M_CALL_REALLOC_CTX(key_oplist, dict->allocator, M_C(name, _pair_ct), NULL, 0, M_D1CT_INITIAL_SIZE); \
     if (dict->data == NULL) {                                                 \
       M_MEMORY_FULL(sizeof (M_C(name, _pair_ct)) * M_D1CT_INITIAL_SIZE);      \
       return ;                                                                \
@@ -1323,6 +1386,30 @@ enum m_d1ct_oa_element_e {
   }                                                                           \
                                                                               \
   static inline void                                                          \
+  M_C(name, _init)(dict_t dict)                                               \
+  {                                                                           \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(dict->allocator = M_GET_ALLOCATOR key_oplist;, ) \
+    M_C3(m_d1ct_,name,_init_table)(dict);                                     \
+  }                                                                           \
+                                                                              \
+  M_IF_METHOD(ALLOCATOR, key_oplist)(                                         \
+  static inline void                                                          \
+  M_C(name, _init_allocator)(dict_t dict, const m_allocator_t *allocator)     \
+  {                                                                           \
+    M_ASSERT (allocator != NULL);                                             \
+    dict->allocator = allocator;                                              \
+    M_C3(m_d1ct_,name,_init_table)(dict);                                     \
+  }                                                                           \
+                                                                              \
+  static inline const m_allocator_t *                                         \
+  M_C(name, _allocator)(const dict_t dict)                                    \
+  {                                                                           \
+    M_D1CT_OA_CONTRACT(dict);                                                 \
+    return dict->allocator;                                                   \
+  }                                                                           \
+  , /* No ALLOCATOR */ )                                                      \
+                                                                              \
+  static inline void                                                          \
   M_C(name, _clear)(dict_t dict)                                              \
   {                                                                           \
     M_D1CT_OA_CONTRACT(dict);                                                 \
@@ -1333,7 +1420,7 @@ enum m_d1ct_oa_element_e {
         M_CALL_CLEAR(value_oplist, dict->data[i].value);                      \
       }                                                                       \
     }                                                                         \
-    M_CALL_FREE(key_oplist, dict->data);                                      \
+    M_CALL_FREE_CTX(key_oplist, dict->allocator, M_C(name, _pair_ct), dict->data, dict->mask+1); \
     /* Not really needed, but safer */                                        \
     dict->mask = 0;                                                           \
     dict->data = NULL;                                                        \
@@ -1404,7 +1491,7 @@ enum m_d1ct_oa_element_e {
     M_C(name, _pair_ct) *data = h->data;                                      \
     /* resize can be called just to delete the items */                       \
     if (newSize > oldSize) {                                                  \
-      data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_ct), data, newSize);  \
+      data = M_CALL_REALLOC_CTX(key_oplist, h->allocator, M_C(name, _pair_ct), data, oldSize, newSize); \
       if (M_UNLIKELY (data == NULL) ) {                                       \
         M_MEMORY_FULL(sizeof (M_C(name, _pair_ct)) * newSize);                \
         return ;                                                              \
@@ -1665,7 +1752,7 @@ enum m_d1ct_oa_element_e {
     if (newSize != oldSize) {                                                 \
       h->mask = newSize-1;                                                    \
       M_C3(m_d1ct_,name,_update_limit)(h, newSize);                           \
-      h->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_ct), data, newSize); \
+      h->data = M_CALL_REALLOC_CTX(key_oplist, h->allocator, M_C(name, _pair_ct), data, oldSize, newSize); \
       M_ASSERT (h->data != NULL);                                             \
     }                                                                         \
     M_IF_DEBUG (M_ASSERT (M_C3(m_d1ct_,name,_control_after_resize)(h));)      \
@@ -1709,8 +1796,9 @@ enum m_d1ct_oa_element_e {
     return true;                                                              \
   }                                                                           \
                                                                               \
+  /* Copy the table of org into map (the allocator of map is already set) */  \
   static inline void                                                          \
-  M_C(name, _init_set)(dict_t map, const dict_t org)                          \
+  M_C3(m_d1ct_,name,_init_copy)(dict_t map, const dict_t org)                 \
   {                                                                           \
     M_D1CT_OA_CONTRACT(org);                                                  \
     M_ASSERT (map != org);                                                    \
@@ -1719,7 +1807,7 @@ enum m_d1ct_oa_element_e {
     map->count_delete = org->count_delete;                                    \
     map->upper_limit  = org->upper_limit;                                     \
     map->lower_limit  = org->lower_limit;                                     \
-    map->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_ct), NULL, map->mask+1); \
+    map->data = M_CALL_REALLOC_CTX(key_oplist, map->allocator, M_C(name, _pair_ct), NULL, 0, map->mask+1); \
     if (map->data == NULL) {                                                  \
       M_MEMORY_FULL(sizeof (M_C(name, _pair_ct)) * (map->mask+1));            \
       return ;                                                                \
@@ -1738,13 +1826,21 @@ enum m_d1ct_oa_element_e {
   }                                                                           \
                                                                               \
   static inline void                                                          \
+  M_C(name, _init_set)(dict_t map, const dict_t org)                          \
+  {                                                                           \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(map->allocator = org->allocator;, )    \
+    M_C3(m_d1ct_,name,_init_copy)(map, org);                                  \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
   M_C(name, _set)(dict_t map, const dict_t org)                               \
   {                                                                           \
     M_D1CT_OA_CONTRACT(map);                                                  \
     M_D1CT_OA_CONTRACT(org);                                                  \
     if (M_LIKELY (map != org)) {                                              \
+      /* map keeps its own allocator */                                       \
       M_C(name, _clear)(map);                                                 \
-      M_C(name, _init_set)(map, org);                                         \
+      M_C3(m_d1ct_,name,_init_copy)(map, org);                                \
     }                                                                         \
     M_D1CT_OA_CONTRACT(map);                                                  \
   }                                                                           \
@@ -1760,6 +1856,7 @@ enum m_d1ct_oa_element_e {
     map->upper_limit  = org->upper_limit;                                     \
     map->lower_limit  = org->lower_limit;                                     \
     map->data         = org->data;                                            \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(map->allocator = org->allocator;, )    \
     /* Mark org as cleared (safety) */                                        \
     org->mask         = 0;                                                    \
     org->data         = NULL;                                                 \
@@ -1789,6 +1886,7 @@ enum m_d1ct_oa_element_e {
     M_SWAP (size_t, d1->upper_limit,  d2->upper_limit);                       \
     M_SWAP (size_t, d1->lower_limit,  d2->lower_limit);                       \
     M_SWAP (M_C(name, _pair_ct) *, d1->data, d2->data);                       \
+    M_IF_METHOD(ALLOCATOR, key_oplist)(M_SWAP(const m_allocator_t *, d1->allocator, d2->allocator);, ) \
     M_D1CT_OA_CONTRACT(d1);                                                   \
     M_D1CT_OA_CONTRACT(d2);                                                   \
   }                                                                           \
@@ -1806,10 +1904,10 @@ enum m_d1ct_oa_element_e {
     }                                                                         \
     d->count = 0;                                                             \
     d->count_delete = 0;                                                      \
+    d->data = M_CALL_REALLOC_CTX(key_oplist, d->allocator, M_C(name, _pair_ct), \
+                                 d->data, d->mask+1, M_D1CT_INITIAL_SIZE);    \
     d->mask = M_D1CT_INITIAL_SIZE-1;                                          \
     M_C3(m_d1ct_,name,_update_limit)(d, M_D1CT_INITIAL_SIZE);                 \
-    d->data = M_CALL_REALLOC(key_oplist, M_C(name, _pair_ct),                 \
-                             d->data, M_D1CT_INITIAL_SIZE);                   \
     M_ASSERT(d->data != NULL);                                                \
     for(size_t i = 0; i <= d->mask; i++) {                                    \
       M_CALL_OOR_SET(key_oplist, d->data[i].key, M_D1CT_OA_EMPTY);            \
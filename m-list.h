@@ -158,26 +158,55 @@
 #define M_L1ST_DEF_FAILURE(name, type, oplist, list_t, it_t)                  \
   M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(LIST_DEF): the given argument is not a valid oplist: " #oplist)
 
-/* Define allocation functions. If MEMPOOL, we need to define it */
+/* Define the functions handling the allocator of a list
+   (only if the oplist has the ALLOCATOR method) */
+#define M_L1ST_ALLOCATOR_DEF(name, oplist, list_t)                            \
+  M_IF_METHOD(ALLOCATOR, oplist)(                                             \
+  static inline void                                                          \
+  M_C(name, _init_allocator)(list_t v, const m_allocator_t *allocator)        \
+  {                                                                           \
+    M_ASSERT (allocator != NULL);                                             \
+    M_C(name, _init)(v);                                                      \
+    v->allocator = allocator;                                                 \
+  }                                                                           \
+                                                                              \
+  static inline const m_allocator_t *                                         \
+  M_C(name, _allocator)(const list_t v)                                       \
+  {                                                                           \
+    M_ASSERT (v != NULL);                                                     \
+    return v->allocator;                                                      \
+  }                                                                           \
+  , /* No ALLOCATOR */ )
+
+/* Define allocation functions. If MEMPOOL, we need to define it.
+   Otherwise use the allocator stored in the list if ALLOCATOR is defined */
 #define M_L1ST_MEMPOOL_DEF(name, type, oplist, list_t, list_it_t)             \
   M_IF_METHOD(MEMPOOL, oplist)(                                               \
                                                                               \
     MEMPOOL_DEF(M_C(name, _mempool), struct M_C(name, _s))                    \
     M_GET_MEMPOOL_LINKAGE oplist M_C(name, _mempool_t) M_GET_MEMPOOL oplist;  \
-    static inline struct M_C(name, _s) *M_C3(m_l1st_,name,_new)(void) {       \
+    static inline struct M_C(name, _s) *                                      \
+    M_C3(m_l1st_,name,_new)(const list_t v) {                                 \
+      (void) v; /* unused */                                                  \
       return M_C(name, _mempool_alloc)(M_GET_MEMPOOL oplist);                 \
     }                                                                         \
-    static inline void M_C3(m_l1st_,name,_del)(struct M_C(name, _s) *ptr) {   \
+    static inline void                                                        \
+    M_C3(m_l1st_,name,_del)(const list_t v, struct M_C(name, _s) *ptr) {      \
+      (void) v; /* unused */                                                  \
       M_C(name, _mempool_free)(M_GET_MEMPOOL oplist, ptr);                    \
     }                                                                         \
                                                                               \
     , /* No mempool allocation */                                             \
                                                                               \
-    static inline struct M_C(name, _s) *M_C3(m_l1st_,name,_new)(void) {       \
-      return M_CALL_NEW(oplist, struct M_C(name, _s));                        \
+    static inline struct M_C(name, _s) *                                      \
+    M_C3(m_l1st_,name,_new)(const list_t v) {                                 \
+      (void) v; /* unused if no ALLOCATOR */                                  \
+      return M_CALL_NEW_CTX(oplist, v->allocator, struct M_C(name, _s));      \
     }                                                                         \
-    static inline void M_C3(m_l1st_,name,_del)(struct M_C(name, _s) *ptr) {   \
-      M_CALL_DEL(oplist, ptr);                                                \
+    static inline void                                                        \
+    M_C3(m_l1st_,name,_del)(const list_t v, struct M_C(name, _s) *ptr) {      \
+      (void) v; /* unused if no ALLOCATOR */                                  \
+      M_CALL_DEL_CTX(oplist, v->allocator, struct M_C(name, _s), ptr);        \
     }                                                                         \
     )                                                                         \
 
@@ -192,11 +221,20 @@
  */
 #define M_L1ST_DEF_P3(name, type, oplist, list_t, it_t)                       \
                                                                               \
-  /* Define the node of a list, and the list as a pointer to a node */        \
-  typedef struct M_C(name, _s) {                                              \
+  /* Define the node of a list, and the list as a pointer to a node           \
+     (and to its allocator if the oplist has the ALLOCATOR method) */         \
+  struct M_C(name, _s) {                                                      \
     struct M_C(name, _s) *next;  /* Next node or NULL if final node */        \
     type data;                   /* The data itself */                        \
-  } *list_t[1];                                                               \
+  };                                                                          \
+  M_IF_METHOD(ALLOCATOR, oplist)(                                             \
+  typedef struct M_C(name, _head_s) {                                         \
+    struct M_C(name, _s) *head;                                               \
+    const m_allocator_t *allocator;                                           \
+  } list_t[1];                                                                \
+  ,                                                                           \
+  typedef struct M_C(name, _s) *list_t[1];                                    \
+  )                                                                           \
                                                                               \
   /* Define an iterator of a list */                                          \
   typedef struct M_C(name, _it_s) {                                           \
@@ -224,6 +262,15 @@
     M_ASSERT (v != NULL);                                                     \
   } while (0)
 
+/* Access to the pointer to the first node of a list */
+#define M_L1ST_HEAD(oplist, v)                                                \
+  M_IF_METHOD(ALLOCATOR, oplist)(((v)->head), (*(v)))
+
+/* Check that two lists use the same allocator
+   (needed to move nodes from one list to the other) */
+#define M_L1ST_SAME_ALLOCATOR(oplist, v1, v2)                                 \
+  M_IF_METHOD(ALLOCATOR, oplist)(M_ASSERT((v1)->allocator == (v2)->allocator);, )
+
 
 /* Internal list function definition
    - name: prefix to be used
@@ -238,19 +285,22 @@
   M_C(name, _init)(list_t v)                                                  \
   {                                                                           \
     M_ASSERT (v != NULL);                                                     \
-    *v = NULL;                                                                \
+    M_L1ST_HEAD(oplist, v) = NULL;                                            \
+    M_IF_METHOD(ALLOCATOR, oplist)(v->allocator = M_GET_ALLOCATOR oplist;, )  \
   }                                                                           \
                                                                               \
+  M_L1ST_ALLOCATOR_DEF(name, oplist, list_t)                                  \
+                                                                              \
   static inline void                                                          \
   M_C(name, _reset)(list_t v)                                                 \
   {                                                                           \
     M_L1ST_CONTRACT(v);                                                       \
-    struct M_C(name, _s) *it = *v;                                            \
-    *v = NULL;                                                                \
+    struct M_C(name, _s) *it = M_L1ST_HEAD(oplist, v);                        \
+    M_L1ST_HEAD(oplist, v) = NULL;                                            \
     while (it != NULL) {                                                      \
       struct M_C(name, _s) *next = it->next;                                  \
       M_CALL_CLEAR(oplist, it->data);                                         \
-      M_C3(m_l1st_,name,_del)(it);                                            \
+      M_C3(m_l1st_,name,_del)(v, it);                                         \
       it = next;                                                              \
     }                                                                         \
     M_L1ST_CONTRACT(v);                                                       \
@@ -266,8 +316,8 @@
   M_C(name, _back)(const list_t v)                                            \
   {                                                                           \
     M_L1ST_CONTRACT(v);                                                       \
-    M_ASSERT(*v != NULL);                                                     \
-    return &((*v)->data);                                                     \
+    M_ASSERT(M_L1ST_HEAD(oplist, v) != NULL);                                 \
+    return &(M_L1ST_HEAD(oplist, v)->data);                                   \
   }                                                                           \
                                                                               \
   static inline type *                                                        \
@@ -275,14 +325,14 @@
   {                                                                           \
     M_L1ST_CONTRACT(v);                                                       \
     struct M_C(name, _s) *next;                                               \
-    next = M_C3(m_l1st_,name,_new)();                                         \
+    next = M_C3(m_l1st_,name,_new)(v);                                        \
     if (M_UNLIKELY (next == NULL)) {                                          \
       M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                           \
       return NULL;                                                            \
     }                                                                         \
     type *ret = &next->data;                                                  \
-    next->next = *v;                                                          \
-    *v = next;                                                                \
+    next->next = M_L1ST_HEAD(oplist, v);                                      \
+    M_L1ST_HEAD(oplist, v) = next;                                            \
     M_L1ST_CONTRACT(v);                                                       \
     return ret;                                                               \
   }                                                                           \
@@ -312,15 +362,15 @@
   M_C(name, _pop_back)(type *data, list_t v)                                  \
   {                                                                           \
     M_L1ST_CONTRACT(v);                                                       \
-    M_ASSERT(*v != NULL);                                                     \
+    M_ASSERT(M_L1ST_HEAD(oplist, v) != NULL);                                 \
     if (data != NULL) {                                                       \
-      M_DO_MOVE (oplist, *data, (*v)->data);                                  \
+      M_DO_MOVE (oplist, *data, M_L1ST_HEAD(oplist, v)->data);                \
     } else {                                                                  \
-      M_CALL_CLEAR(oplist, (*v)->data);                                       \
+      M_CALL_CLEAR(oplist, M_L1ST_HEAD(oplist, v)->data);                     \
     }                                                                         \
-    struct M_C(name, _s) *tofree = *v;                                        \
-    *v = (*v)->next;                                                          \
-    M_C3(m_l1st_,name,_del)(tofree);                                          \
+    struct M_C(name, _s) *tofree = M_L1ST_HEAD(oplist, v);                    \
+    M_L1ST_HEAD(oplist, v) = M_L1ST_HEAD(oplist, v)->next;                    \
+    M_C3(m_l1st_,name,_del)(v, tofree);                                       \
     M_L1ST_CONTRACT(v);                                                       \
   }                                                                           \
                                                                               \
@@ -338,11 +388,11 @@
   M_C(name, _pop_move)(type *data, list_t v)                                  \
   {                                                                           \
     M_L1ST_CONTRACT(v);                                                       \
-    M_ASSERT(*v != NULL && data != NULL);                                     \
-    M_DO_INIT_MOVE (oplist, *data, (*v)->data);                               \
-    struct M_C(name, _s) *tofree = *v;                                        \
-    *v = (*v)->next;                                                          \
-    M_C3(m_l1st_,name,_del)(tofree);                                          \
+    M_ASSERT(M_L1ST_HEAD(oplist, v) != NULL && data != NULL);                 \
+    M_DO_INIT_MOVE (oplist, *data, M_L1ST_HEAD(oplist, v)->data);             \
+    struct M_C(name, _s) *tofree = M_L1ST_HEAD(oplist, v);                    \
+    M_L1ST_HEAD(oplist, v) = M_L1ST_HEAD(oplist, v)->next;                    \
+    M_C3(m_l1st_,name,_del)(v, tofree);                                       \
     M_L1ST_CONTRACT(v);                                                       \
   }                                                                           \
                                                                               \
@@ -350,7 +400,7 @@
   M_C(name, _empty_p)(const list_t v)                                         \
   {                                                                           \
     M_L1ST_CONTRACT(v);                                                       \
-    return *v == NULL;                                                        \
+    return M_L1ST_HEAD(oplist, v) == NULL;                                    \
   }                                                                           \
                                                                               \
   static inline void                                                          \
@@ -358,7 +408,8 @@
   {                                                                           \
     M_L1ST_CONTRACT(l);                                                       \
     M_L1ST_CONTRACT(v);                                                       \
-    M_SWAP(struct M_C(name, _s) *, *l, *v);                                   \
+    M_SWAP(struct M_C(name, _s) *, M_L1ST_HEAD(oplist, l), M_L1ST_HEAD(oplist, v)); \
+    M_IF_METHOD(ALLOCATOR, oplist)(M_SWAP(const m_allocator_t *, l->allocator, v->allocator);, ) \
     M_L1ST_CONTRACT(l);                                                       \
     M_L1ST_CONTRACT(v);                                                       \
   }                                                                           \
@@ -368,7 +419,7 @@
   {                                                                           \
     M_L1ST_CONTRACT(v);                                                       \
     M_ASSERT (it != NULL);                                                    \
-    it->current = *v;                                                         \
+    it->current = M_L1ST_HEAD(oplist, v);                                     \
     it->previous = NULL;                                                      \
   }                                                                           \
                                                                               \
@@ -438,7 +489,7 @@
   {                                                                           \
     M_L1ST_CONTRACT(list);                                                    \
     size_t size = 0;                                                          \
-    struct M_C(name, _s) *it = *list;                                         \
+    struct M_C(name, _s) *it = M_L1ST_HEAD(oplist, list);                     \
     while (it != NULL) {                                                      \
       size ++;                                                                \
       it = it->next;                                                          \
@@ -451,7 +502,7 @@
   {                                                                           \
     M_L1ST_CONTRACT(list);                                                    \
     M_ASSERT (itsub != NULL);                                                 \
-    struct M_C(name, _s) *it = *list;                                         \
+    struct M_C(name, _s) *it = M_L1ST_HEAD(oplist, list);                     \
     while (it != NULL) {                                                      \
       if (it == itsub->current) return true;                                  \
       it = it->next;                                                          \
@@ -464,7 +515,7 @@
   M_C(name, _get)(const list_t list, size_t i)                                \
   {                                                                           \
     M_L1ST_CONTRACT(list);                                                    \
-    struct M_C(name, _s) *it = *list;                                         \
+    struct M_C(name, _s) *it = M_L1ST_HEAD(oplist, list);                     \
     /* FIXME: How to avoid the double iteration over the list? */             \
     size_t len = M_C(name,_size)(list);                                       \
     M_ASSERT_INDEX (i, len);                                                  \
@@ -490,7 +541,7 @@
     M_L1ST_CONTRACT(list);                                                    \
     M_ASSERT (insertion_point != NULL);                                       \
     M_ASSERT(M_C(name, _sublist_p)(list, insertion_point));                   \
-    struct M_C(name, _s) *next = M_C3(m_l1st_,name,_new)();                   \
+    struct M_C(name, _s) *next = M_C3(m_l1st_,name,_new)(list);               \
     if (M_UNLIKELY (next == NULL)) {                                          \
       M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                           \
       return;                                                                 \
@@ -498,8 +549,8 @@
     M_CALL_INIT_SET(oplist, next->data, x);                                   \
     struct M_C(name, _s) *current = insertion_point->current;                 \
     if (M_UNLIKELY (current == NULL)) {                                       \
-      next->next = *list;                                                     \
-      *list = next;                                                           \
+      next->next = M_L1ST_HEAD(oplist, list);                                 \
+      M_L1ST_HEAD(oplist, list) = next;                                       \
     } else {                                                                  \
       next->next = current->next;                                             \
       current->next = next;                                                   \
@@ -518,26 +569,27 @@
     M_ASSERT(M_C(name, _sublist_p)(list, removing_point));                    \
     struct M_C(name, _s) *next = removing_point->current->next;               \
     if (M_UNLIKELY (removing_point->previous == NULL)) {                      \
-      *list = next;                                                           \
+      M_L1ST_HEAD(oplist, list) = next;                                       \
     } else {                                                                  \
       removing_point->previous->next = next;                                  \
     }                                                                         \
     M_CALL_CLEAR(oplist, removing_point->current->data);                      \
-    M_C3(m_l1st_,name,_del) (removing_point->current);                        \
+    M_C3(m_l1st_,name,_del) (list, removing_point->current);                  \
     removing_point->current = next;                                           \
     M_L1ST_CONTRACT(list);                                                    \
   }                                                                           \
                                                                               \
+  /* Copy the nodes of 'org' into the empty list 'list' */                    \
   static inline void                                                          \
-  M_C(name, _init_set)(list_t list, const list_t org)                         \
+  M_C3(m_l1st_,name,_copy)(list_t list, const list_t org)                     \
   {                                                                           \
     M_L1ST_CONTRACT(org);                                                     \
     struct M_C(name, _s) *next, *it_org;                                      \
     struct M_C(name, _s) **update_list;                                       \
-    update_list = list;                                                       \
-    it_org = *org;                                                            \
+    update_list = &M_L1ST_HEAD(oplist, list);                                 \
+    it_org = M_L1ST_HEAD(oplist, org);                                        \
     while (it_org != NULL) {                                                  \
-      next = M_C3(m_l1st_,name,_new)();                                       \
+      next = M_C3(m_l1st_,name,_new)(list);                                   \
       *update_list = next;                                                    \
       if (M_UNLIKELY (next == NULL)) {                                        \
         M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                         \
@@ -553,11 +605,19 @@
   }                                                                           \
                                                                               \
   static inline void                                                          \
+  M_C(name, _init_set)(list_t list, const list_t org)                         \
+  {                                                                           \
+    M_IF_METHOD(ALLOCATOR, oplist)(list->allocator = org->allocator;, )       \
+    M_C3(m_l1st_,name,_copy)(list, org);                                      \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
   M_C(name, _set)(list_t list, const list_t org)                              \
   {                                                                           \
     if (M_UNLIKELY (list == org)) return;                                     \
-    M_C(name, _clear)(list);                                                  \
-    M_C(name, _init_set)(list, org);                                          \
+    /* Keep the allocator of the destination */                               \
+    M_C(name, _reset)(list);                                                  \
+    M_C3(m_l1st_,name,_copy)(list, org);                                      \
   }                                                                           \
                                                                               \
   static inline void                                                          \
@@ -565,8 +625,9 @@
   {                                                                           \
     M_L1ST_CONTRACT(org);                                                     \
     M_ASSERT (list != NULL && list != org);                                   \
-    *list = *org;                                                             \
-    *org = NULL;  /* safer */                                                 \
+    M_IF_METHOD(ALLOCATOR, oplist)(list->allocator = org->allocator;, )       \
+    M_L1ST_HEAD(oplist, list) = M_L1ST_HEAD(oplist, org);                     \
+    M_L1ST_HEAD(oplist, org) = NULL;  /* safer */                             \
   }                                                                           \
                                                                               \
   static inline void                                                          \
@@ -585,11 +646,12 @@
     M_ASSERT (it != NULL);                                                    \
     M_ASSERT (it->current != NULL);                                           \
     M_ASSERT (M_C(name, _sublist_p)(ov, it));                                 \
+    M_L1ST_SAME_ALLOCATOR(oplist, nv, ov);                                    \
     /* Remove the item 'it' from the list 'ov' */                             \
     struct M_C(name, _s) *current = it->current;                              \
     struct M_C(name, _s) *next    = current->next;                            \
     if (it->previous == NULL) {                                               \
-      *ov = next;                                                             \
+      M_L1ST_HEAD(oplist, ov) = next;                                         \
     } else {                                                                  \
       it->previous->next = next;                                              \
     }                                                                         \
@@ -597,8 +659,8 @@
     /* it->previous doesn't need to be updated */                             \
     it->current = next;                                                       \
     /* Push back extracted 'current' in the list 'nv' */                      \
-    current->next = *nv;                                                      \
-    *nv = current;                                                            \
+    current->next = M_L1ST_HEAD(oplist, nv);                                  \
+    M_L1ST_HEAD(oplist, nv) = current;                                        \
   }                                                                           \
                                                                               \
   static inline void                                                          \
@@ -611,11 +673,12 @@
     M_ASSERT (opos != NULL);                                                  \
     M_ASSERT (M_C(name, _sublist_p)(nlist, npos));                            \
     M_ASSERT (M_C(name, _sublist_p)(olist, opos));                            \
+    M_L1ST_SAME_ALLOCATOR(oplist, nlist, olist);                              \
     /* Remove the item 'opos' from the list 'olist' */                        \
     struct M_C(name, _s) *current = opos->current;                            \
     struct M_C(name, _s) *next    = current->next;                            \
     if (opos->previous == NULL) {                                             \
-      *olist = next;                                                          \
+      M_L1ST_HEAD(oplist, olist) = next;                                      \
     } else {                                                                  \
       opos->previous->next = next;                                            \
     }                                                                         \
@@ -624,8 +687,8 @@
     /* Insert 'current' into 'nlist' just after 'npos' */                     \
     struct M_C(name, _s) *previous = npos->current;                           \
     if (M_UNLIKELY (previous == NULL)) {                                      \
-      current->next = *nlist;                                                 \
-      *nlist = current;                                                       \
+      current->next = M_L1ST_HEAD(oplist, nlist);                             \
+      M_L1ST_HEAD(oplist, nlist) = current;                                   \
     } else {                                                                  \
       current->next = previous->next;                                         \
       previous->next = current;                                               \
@@ -643,28 +706,29 @@
     M_L1ST_CONTRACT(list1);                                                   \
     M_L1ST_CONTRACT(list2);                                                   \
     M_ASSERT (list1 != list2);                                                \
-    struct M_C(name, _s) **update_list = list1;                               \
-    struct M_C(name, _s) *it = *list1;                                        \
+    M_L1ST_SAME_ALLOCATOR(oplist, list1, list2);                              \
+    struct M_C(name, _s) **update_list = &M_L1ST_HEAD(oplist, list1);         \
+    struct M_C(name, _s) *it = M_L1ST_HEAD(oplist, list1);                    \
     while (it != NULL) {                                                      \
       update_list = &it->next;                                                \
       it = it->next;                                                          \
     }                                                                         \
-    *update_list = *list2;                                                    \
-    *list2 = NULL;                                                            \
+    *update_list = M_L1ST_HEAD(oplist, list2);                                \
+    M_L1ST_HEAD(oplist, list2) = NULL;                                        \
   }                                                                           \
                                                                               \
   static inline void                                                          \
   M_C(name, _reverse)(list_t list)                                            \
   {                                                                           \
     M_L1ST_CONTRACT(list);                                                    \
-    struct M_C(name, _s) *previous = NULL, *it = *list, *next;                \
+    struct M_C(name, _s) *previous = NULL, *it = M_L1ST_HEAD(oplist, list), *next; \
     while (it != NULL) {                                                      \
       next = it->next;                                                        \
       it->next = previous;                                                    \
       previous = it;                                                          \
       it = next;                                                              \
     }                                                                         \
-    *list = previous;                                                         \
+    M_L1ST_HEAD(oplist, list) = previous;                                     \
   }                                                                           \
                                                                               \
   M_EMPLACE_QUEUE_DEF(name, list_t, M_C(name, _emplace_back), oplist, M_L1ST_EMPLACE_DEF)
@@ -946,6 +1010,7 @@
   typedef struct M_C(name, _head_s)  {                                        \
     struct M_C(name,_s) *front; /* Pointer to the front node or NULL */       \
     struct M_C(name,_s) *back;  /* Pointer to the back node or NULL */        \
+    M_ALL0CATOR_FIELD(oplist)   /* Allocator (if ALLOCATOR method) */         \
   } list_t[1];                                                                \
                                                                               \
   /* Define the iterator over a dual push singly linked list */               \
@@ -990,9 +1055,12 @@
     M_ASSERT( v != NULL);                                                     \
     v->front = NULL;                                                          \
     v->back = NULL;                                                           \
+    M_IF_METHOD(ALLOCATOR, oplist)(v->allocator = M_GET_ALLOCATOR oplist;, )  \
     M_L1ST_DUAL_PUSH_CONTRACT(v);                                             \
   }                                                                           \
                                                                               \
+  M_L1ST_ALLOCATOR_DEF(name, oplist, list_t)                                  \
+                                                                              \
   static inline void                                                          \
   M_C(name, _reset)(list_t v)                                                 \
   {                                                                           \
@@ -1001,7 +1069,7 @@
     while (it != NULL) {                                                      \
       struct M_C(name, _s) *next = it->next;                                  \
       M_CALL_CLEAR(oplist, it->data);                                         \
-      M_C3(m_l1st_,name,_del)(it);                                            \
+      M_C3(m_l1st_,name,_del)(v, it);                                         \
       it = next;                                                              \
     }                                                                         \
     v->front = NULL;                                                          \
@@ -1027,7 +1095,7 @@
   M_C(name, _push_back_raw)(list_t v)                                         \
   {                                                                           \
     M_L1ST_DUAL_PUSH_CONTRACT(v);                                             \
-    struct M_C(name, _s) *next = M_C3(m_l1st_,name,_new)();                   \
+    struct M_C(name, _s) *next = M_C3(m_l1st_,name,_new)(v);                  \
     if (M_UNLIKELY (next == NULL)) {                                          \
       M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                           \
       return NULL;                                                            \
@@ -1100,7 +1168,7 @@
       M_CALL_CLEAR(oplist, tofree->data);                                     \
     }                                                                         \
     v->back = tofree->next;                                                   \
-    M_C3(m_l1st_,name,_del)(tofree);                                          \
+    M_C3(m_l1st_,name,_del)(v, tofree);                                       \
     /* Update front too if the list became empty */                           \
     /* This C code shall generate branchless code */                          \
     struct M_C(name, _s) *front = v->front;                                   \
@@ -1118,7 +1186,7 @@
     struct M_C(name, _s) *tofree = v->back;                                   \
     M_DO_INIT_MOVE (oplist, *data, tofree->data);                             \
     v->back = tofree->next;                                                   \
-    M_C3(m_l1st_,name,_del)(tofree);                                          \
+    M_C3(m_l1st_,name,_del)(v, tofree);                                       \
     /* Update front too if the list became empty */                           \
     /* This C code shall generate branchless code */                          \
     struct M_C(name, _s) *front = v->front;                                   \
@@ -1139,7 +1207,7 @@
   M_C(name, _push_front_raw)(list_t v)                                        \
   {                                                                           \
     M_L1ST_DUAL_PUSH_CONTRACT(v);                                             \
-    struct M_C(name, _s) *next = M_C3(m_l1st_,name,_new)();                   \
+    struct M_C(name, _s) *next = M_C3(m_l1st_,name,_new)(v);                  \
     if (M_UNLIKELY (next == NULL)) {                                          \
       M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                           \
       return NULL;                                                            \
@@ -1202,6 +1270,7 @@
     M_L1ST_DUAL_PUSH_CONTRACT(v);                                             \
     M_SWAP(struct M_C(name, _s) *, l->front, v->front);                       \
     M_SWAP(struct M_C(name, _s) *, l->back, v->back);                         \
+    M_IF_METHOD(ALLOCATOR, oplist)(M_SWAP(const m_allocator_t *, l->allocator, v->allocator);, ) \
   }                                                                           \
                                                                               \
   static inline void                                                          \
@@ -1293,7 +1362,7 @@
   {                                                                           \
     M_L1ST_DUAL_PUSH_CONTRACT(list);                                          \
     M_ASSERT (insertion_point != NULL);                                       \
-    struct M_C(name, _s) *next = M_C3(m_l1st_,name,_new)();                   \
+    struct M_C(name, _s) *next = M_C3(m_l1st_,name,_new)(list);               \
     if (M_UNLIKELY (next == NULL)) {                                          \
       M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                           \
       return;                                                                 \
@@ -1335,7 +1404,7 @@
     list->front = front;                                                      \
     /* Remove node */                                                         \
     M_CALL_CLEAR(oplist, removing_point->current->data);                      \
-    M_C3(m_l1st_,name,_del) (removing_point->current);                        \
+    M_C3(m_l1st_,name,_del) (list, removing_point->current);                  \
     removing_point->current = next;                                           \
   }                                                                           \
                                                                               \
@@ -1352,7 +1421,7 @@
     update_list = &list->back;                                                \
     it_org = org->back;                                                       \
     while (it_org != NULL) {                                                  \
-      next = M_C3(m_l1st_,name,_new)();                                       \
+      next = M_C3(m_l1st_,name,_new)(list);                                   \
       *update_list = next;                                                    \
       if (M_UNLIKELY (next == NULL)) {                                        \
         M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                         \
@@ -1371,6 +1440,7 @@
   {                                                                           \
     M_ASSERT (list != org);                                                   \
     M_C(name, _init)(list);                                                   \
+    M_IF_METHOD(ALLOCATOR, oplist)(list->allocator = org->allocator;, )       \
     M_C(name, _set)(list, org);                                               \
   }                                                                           \
                                                                               \
@@ -1380,6 +1450,7 @@
     M_ASSERT (list != org);                                                   \
     list->back  = org->back;                                                  \
     list->front = org->front;                                                 \
+    M_IF_METHOD(ALLOCATOR, oplist)(list->allocator = org->allocator;, )       \
     org->back = NULL;                                                         \
     org->front = NULL;                                                        \
   }                                                                           \
@@ -1397,6 +1468,7 @@
     M_L1ST_DUAL_PUSH_CONTRACT(list1);                                         \
     M_L1ST_DUAL_PUSH_CONTRACT(list2);                                         \
     M_ASSERT (it->current != NULL);                                           \
+    M_L1ST_SAME_ALLOCATOR(oplist, list1, list2);                              \
     /* First remove the item 'it' from the list 'list2' */                    \
     struct M_C(name, _s) *current = it->current;                              \
     struct M_C(name, _s) *next = current->next;                               \
@@ -1430,6 +1502,7 @@
     M_L1ST_DUAL_PUSH_CONTRACT(nlist);                                         \
     M_L1ST_DUAL_PUSH_CONTRACT(olist);                                         \
     M_ASSERT (npos != NULL && opos != NULL);                                  \
+    M_L1ST_SAME_ALLOCATOR(oplist, nlist, olist);                              \
     /* First remove the item 'opos' from the list 'olist' */                  \
     struct M_C(name, _s) *current = opos->current;                            \
     struct M_C(name, _s) *next    = current->next;                            \
@@ -1475,6 +1548,7 @@
     M_L1ST_DUAL_PUSH_CONTRACT(list1);                                         \
     M_L1ST_DUAL_PUSH_CONTRACT(list2);                                         \
     M_ASSERT (list1 != list2);                                                \
+    M_L1ST_SAME_ALLOCATOR(oplist, list1, list2);                              \
     if (M_LIKELY (list1->front != NULL)) {                                    \
       list1->front->next = list2->back;                                       \
       list1->front = list2->front;                                            \
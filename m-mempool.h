@@ -26,6 +26,7 @@
 #define MSTARLIB_MEMPOOL_H
 
 #include "m-core.h"
+#include "m-mutex.h"
 
 /* Fast, fixed size, thread unsafe allocator based on memory regions.
    No oplist is needed.
@@ -59,6 +60,38 @@
   M_END_PROTECTED_CODE
 
 
+/* Fast, variable size, thread safe allocator of small objects.
+   It uses size classes, a cache per thread for each size class
+   and a global depot shared by all threads protected by a mutex.
+   The objects are moved between the caches and the depot
+   by batches so that the mutex is rarely taken.
+   USAGE:
+     MEMPOOL_SIZED_DEF(name)
+   Example:
+     MEMPOOL_SIZED_DEF(spool)
+     spool_t pool;
+     ...
+     spool_init(pool);
+     char *ptr = spool_alloc(pool, 100);
+     spool_free(pool, ptr, 100);   // The size of the object is needed
+     spool_flush(pool);            // Give back the cache of the thread
+     spool_clear(pool);            // Give back memory to system
+   The cache of a terminating thread is given back to the depot.
+*/
+#define M_MEMPOOL_SIZED_DEF(name)                                             \
+  M_MEMPOOL_SIZED_DEF_AS(name, M_C(name,_t))
+
+
+/* Fast, variable size, thread safe allocator of small objects.
+   USAGE:
+     MEMPOOL_SIZED_DEF_AS(name, name_t)
+*/
+#define M_MEMPOOL_SIZED_DEF_AS(name, name_t)                                  \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_M3MPOOL_SIZED_DEF_P2(name, name_t )                                       \
+  M_END_PROTECTED_CODE
+
+
 /* User shall be able to cutomize the size of the region segment and/or
    the minimun number of elements.
    The default is the number of elements that fits in 16KB, or 256
@@ -91,10 +124,15 @@
                                                                               \
   /* Define a mempool.                                                        \
     It is a pointer to the first free object within the segments              \
-    and the segments themselves           */                                  \
+    and the segments themselves, with the counters of the mempool   */        \
   typedef struct M_C(name, _s) {                                              \
     M_C(name,_union_ct)   *free_list;                                         \
     M_C(name,_segment_ct) *current_segment;                                   \
+    size_t                 in_use;                                            \
+    size_t                 segments;                                          \
+    size_t                 peak_segments;                                     \
+    size_t                 trim_threshold;                                    \
+    size_t                 trim_next;                                         \
   } name_t[1];                                                                \
                                                                               \
   static inline void                                                          \
@@ -108,6 +146,11 @@
     }                                                                         \
     mem->current_segment->next = NULL;                                        \
     mem->current_segment->count = 0;                                          \
+    mem->in_use = 0;                                                          \
+    mem->segments = 1;                                                        \
+    mem->peak_segments = 1;                                                   \
+    mem->trim_threshold = 0;                                                  \
+    mem->trim_next = 0;                                                       \
     M_M3MPOOL_CONTRACT(mem, type);                                            \
   }                                                                           \
                                                                               \
@@ -132,6 +175,7 @@
     M_M3MPOOL_CONTRACT(mem, type);                                            \
     /* Test if one object is in the free list */                              \
     M_C(name,_union_ct) *ret = mem->free_list;                                \
+    mem->in_use ++;                                                           \
     if (ret != NULL) {                                                        \
       /* Yes, so return it, and pop it from the free list */                  \
       mem->free_list = ret->next;                                             \
@@ -146,11 +190,14 @@
       M_C(name,_segment_ct) *new_segment = M_MEMORY_ALLOC (M_C(name,_segment_ct)); \
       if (M_UNLIKELY (new_segment == NULL)) {                                 \
         M_MEMORY_FULL(sizeof (M_C(name,_segment_ct)));                        \
+        mem->in_use --;                                                       \
         return NULL;                                                          \
       }                                                                       \
       new_segment->next = segment;                                            \
       new_segment->count = 0;                                                 \
       mem->current_segment = new_segment;                                     \
+      mem->segments ++;                                                       \
+      mem->peak_segments = M_MAX(mem->peak_segments, mem->segments);          \
       segment = new_segment;                                                  \
       count = 0;                                                              \
     }                                                                         \
@@ -161,6 +208,92 @@
     return &ret->t;                                                           \
   }                                                                           \
                                                                               \
+  /* Give back to the system the segments whose objects are all free.         \
+     The current segment is kept (but reset if it is fully free).             \
+     Return the number of bytes given back to the system. */                  \
+  static inline size_t                                                        \
+  M_C(name,_trim)(name_t mem)                                                 \
+  {                                                                           \
+    M_M3MPOOL_CONTRACT(mem, type);                                            \
+    const size_t n = mem->segments;                                           \
+    if (mem->free_list == NULL) {                                             \
+      return 0;                                                               \
+    }                                                                         \
+    void **tab = M_MEMORY_REALLOC(void *, NULL, n);                           \
+    size_t *count = M_MEMORY_REALLOC(size_t, NULL, n);                        \
+    if (M_UNLIKELY (tab == NULL || count == NULL)) {                          \
+      /* Trimming is only an optimization: give up */                         \
+      M_MEMORY_FREE(tab);                                                     \
+      M_MEMORY_FREE(count);                                                   \
+      return 0;                                                               \
+    }                                                                         \
+    /* Sort the segments by address */                                        \
+    size_t i = 0;                                                             \
+    for(M_C(name,_segment_ct) *s = mem->current_segment; s != NULL; s = s->next) { \
+      tab[i++] = (void *) s;                                                  \
+    }                                                                         \
+    M_ASSERT (i == n);                                                        \
+    m_m3mpool_sort_ptr(tab, n);                                               \
+    /* Count the free objects of each segment */                              \
+    memset(count, 0, n * sizeof (size_t));                                    \
+    for(M_C(name,_union_ct) *it = mem->free_list; it != NULL; it = it->next) { \
+      count[m_m3mpool_find_ptr(tab, n, it)] ++;                               \
+    }                                                                         \
+    /* Mark the fully free segments */                                        \
+    for(i = 0; i < n; i++) {                                                  \
+      const M_C(name,_segment_ct) *s = (const M_C(name,_segment_ct) *) tab[i]; \
+      count[i] = (count[i] == s->count) ? SIZE_MAX : 0;                       \
+    }                                                                         \
+    /* Remove their objects from the free list */                             \
+    M_C(name,_union_ct) **prev = &mem->free_list;                             \
+    while (*prev != NULL) {                                                   \
+      M_C(name,_union_ct) *it = *prev;                                        \
+      if (count[m_m3mpool_find_ptr(tab, n, it)] == SIZE_MAX) {                \
+        *prev = it->next;                                                     \
+      } else {                                                                \
+        prev = &it->next;                                                     \
+      }                                                                       \
+    }                                                                         \
+    /* Give back the segments to the system, except the current one */        \
+    M_C(name,_segment_ct) *current = mem->current_segment;                    \
+    if (count[m_m3mpool_find_ptr(tab, n, current)] == SIZE_MAX) {             \
+      current->count = 0;                                                     \
+    }                                                                         \
+    size_t released = 0;                                                      \
+    M_C(name,_segment_ct) **prev_s = &current->next;                          \
+    while (*prev_s != NULL) {                                                 \
+      M_C(name,_segment_ct) *s = *prev_s;                                     \
+      if (count[m_m3mpool_find_ptr(tab, n, s)] == SIZE_MAX) {                 \
+        *prev_s = s->next;                                                    \
+        M_MEMORY_DEL(s);                                                      \
+        released ++;                                                          \
+      } else {                                                                \
+        prev_s = &s->next;                                                    \
+      }                                                                       \
+    }                                                                         \
+    mem->segments -= released;                                                \
+    M_MEMORY_FREE(tab);                                                       \
+    M_MEMORY_FREE(count);                                                     \
+    M_M3MPOOL_CONTRACT(mem, type);                                            \
+    return released * sizeof (M_C(name,_segment_ct));                         \
+  }                                                                           \
+                                                                              \
+  /* Trim the mempool if the free memory is above the threshold.              \
+     The next trim is only performed once 'threshold' more bytes              \
+     have been freed, so that its cost is amortized. */                       \
+  static inline void                                                          \
+  M_C3(m_m3mpool_,name,_auto_trim)(name_t mem)                                \
+  {                                                                           \
+    const size_t free_bytes = mem->segments * sizeof (M_C(name,_segment_ct))  \
+      - mem->in_use * sizeof (type);                                          \
+    if (free_bytes > mem->trim_next) {                                        \
+      M_C(name,_trim)(mem);                                                   \
+      const size_t new_free = mem->segments * sizeof (M_C(name,_segment_ct))  \
+        - mem->in_use * sizeof (type);                                        \
+      mem->trim_next = M_MAX(new_free, mem->trim_threshold) + mem->trim_threshold; \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
   static inline void                                                          \
   M_C(name,_free)(name_t mem, type *ptr)                                      \
   {                                                                           \
@@ -171,9 +304,34 @@
     /* Add the object back in the free list */                                \
     ret->next = mem->free_list;                                               \
     mem->free_list = ret;                                                     \
+    M_ASSERT (mem->in_use > 0);                                               \
+    mem->in_use --;                                                           \
     /* NOTE: the objects are NOT given back to the system until the mempool   \
-    is fully cleared */                                                       \
+    is trimmed or fully cleared */                                            \
+    if (M_UNLIKELY (mem->trim_threshold != 0)) {                              \
+      M_C3(m_m3mpool_,name,_auto_trim)(mem);                                  \
+    }                                                                         \
+    M_M3MPOOL_CONTRACT(mem, type);                                            \
+  }                                                                           \
+                                                                              \
+  static inline m_mempool_stats_t                                             \
+  M_C(name,_stats)(const name_t mem)                                          \
+  {                                                                           \
+    M_M3MPOOL_CONTRACT(mem, type);                                            \
+    m_mempool_stats_t stats;                                                  \
+    stats.allocated = mem->segments * sizeof (M_C(name,_segment_ct));         \
+    stats.in_use    = mem->in_use * sizeof (type);                            \
+    stats.free      = stats.allocated - stats.in_use;                         \
+    stats.peak      = mem->peak_segments * sizeof (M_C(name,_segment_ct));    \
+    return stats;                                                             \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name,_set_trim_threshold)(name_t mem, size_t threshold)                 \
+  {                                                                           \
     M_M3MPOOL_CONTRACT(mem, type);                                            \
+    mem->trim_threshold = threshold;                                          \
+    mem->trim_next = threshold;                                               \
   }                                                                           \
 
 /* MEMPOOL contract. We only control the current segment. */
@@ -181,12 +339,556 @@
     M_ASSERT((mempool) != NULL);                                              \
     M_ASSERT((mempool)->current_segment != NULL);                             \
     M_ASSERT((mempool)->current_segment->count <= M_USE_MEMPOOL_MAX_PER_SEGMENT(type)); \
+    M_ASSERT((mempool)->segments >= 1 && (mempool)->segments <= (mempool)->peak_segments); \
+    M_ASSERT((mempool)->in_use <= (mempool)->segments * M_USE_MEMPOOL_MAX_PER_SEGMENT(type)); \
   } while (0)
 
+/* Compare two pointers by address (for qsort) */
+static inline int
+m_m3mpool_cmp_ptr(const void *a, const void *b)
+{
+  const uintptr_t pa = (uintptr_t) *(void * const *) a;
+  const uintptr_t pb = (uintptr_t) *(void * const *) b;
+  return (pa > pb) - (pa < pb);
+}
+
+/* Sort the table of segments 'tab' of size 'n' by address */
+static inline void
+m_m3mpool_sort_ptr(void **tab, size_t n)
+{
+  qsort(tab, n, sizeof (void *), m_m3mpool_cmp_ptr);
+}
+
+/* Return the index of the segment containing 'ptr' in the table of
+   segments 'tab' sorted by address: it is the last segment whose
+   address is lower or equal to 'ptr' */
+static inline size_t
+m_m3mpool_find_ptr(void * const *tab, size_t n, const void *ptr)
+{
+  M_ASSERT (n > 0 && (uintptr_t) tab[0] <= (uintptr_t) ptr);
+  size_t lo = 0, hi = n;
+  while (hi - lo > 1) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if ((uintptr_t) tab[mid] <= (uintptr_t) ptr) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+
+/* User shall be able to customize the size of the regions of the
+   sized mempool, and the size in bytes of a batch of objects
+   exchanged between a thread cache and the depot. */
+#ifndef M_USE_MEMPOOL_SIZED_SLAB_SIZE
+#define M_USE_MEMPOOL_SIZED_SLAB_SIZE (64*1024)
+#endif
+#ifndef M_USE_MEMPOOL_SIZED_BATCH_SIZE
+#define M_USE_MEMPOOL_SIZED_BATCH_SIZE 4096
+#endif
+
+/* Size classes of the sized mempool:
+   16 to 128 by step of 16, then 4 classes per power of 2 up to 1024.
+   Bigger objects are directly allocated by M_MEMORY_REALLOC. */
+#define M_MEMPOOL_SIZED_MAX_SIZE 1024
+#define M_M3MPOOL_SIZED_NUM_CLASS 20
+
+/* A free object of the sized mempool.
+   'next' links the objects of a list.
+   'next_batch' links the batches within the depot (only for the first
+   object of a batch) */
+typedef struct m_m3mpool_sized_node_s {
+  struct m_m3mpool_sized_node_s *next;
+  struct m_m3mpool_sized_node_s *next_batch;
+} m_m3mpool_sized_node_ct;
+
+/* A region of memory of the sized mempool */
+typedef struct m_m3mpool_sized_slab_s {
+  struct m_m3mpool_sized_slab_s *next;
+  size_t                        size;
+} m_m3mpool_sized_slab_ct;
+
+/* The depot of a size class:
+   a stack of full batches, a list of loose objects
+   and the region of a slab not yet distributed */
+typedef struct m_m3mpool_sized_depot_s {
+  m_m3mpool_sized_node_ct *batches;
+  m_m3mpool_sized_node_ct *loose;
+  char                    *ptr, *end;
+} m_m3mpool_sized_depot_ct;
+
+/* The cache of a thread for a pool: a list of free objects per size class.
+   It is linked in the list of the caches of its pool (so that it is shared
+   by all the translation units), and in the list of the caches created
+   by its thread from a translation unit (which frees them when the thread
+   terminates). Once its pool is cleared, it can be reused for another pool */
+typedef struct m_m3mpool_sized_cache_s {
+  struct m_m3mpool_sized_s       *pool;        // NULL once the pool is cleared
+  struct m_m3mpool_sized_cache_s *next;        // Next cache of the pool
+  struct m_m3mpool_sized_cache_s *thread_next; // Next cache of the thread
+  m_thread_id_t                   tid;         // Thread owning the cache
+  m_m3mpool_sized_node_ct *list[M_M3MPOOL_SIZED_NUM_CLASS];
+  unsigned int             count[M_M3MPOOL_SIZED_NUM_CLASS];
+} m_m3mpool_sized_cache_ct;
+
+/* A sized mempool */
+typedef struct m_m3mpool_sized_s {
+  m_mutex_t                lock;
+  m_m3mpool_sized_slab_ct  *slabs;
+  m_m3mpool_sized_depot_ct depot[M_M3MPOOL_SIZED_NUM_CLASS];
+  m_m3mpool_sized_cache_ct *caches;
+  m_allocator_t            allocator;
+} m_m3mpool_sized_ct;
+
+/* The key whose value is the list of the caches created by the current
+   thread from this translation unit, and the last cache used by the
+   current thread in this translation unit (fast path).
+   As a header only library, they are local to each translation unit. */
+static m_once_t m_m3mpool_sized_once = M_ONCE_INIT_VALUE;
+static m_thread_key_t m_m3mpool_sized_key;
+static M_THREAD_ATTR m_m3mpool_sized_cache_ct *m_m3mpool_sized_last;
+
+/* Return the size class of an object of 'size' bytes (size <= M_MEMPOOL_SIZED_MAX_SIZE) */
+static inline unsigned int
+m_m3mpool_sized_class(size_t size)
+{
+  M_ASSERT (size <= M_MEMPOOL_SIZED_MAX_SIZE);
+  if (size <= 128) {
+    return size == 0 ? 0 : (unsigned int) ((size - 1) / 16);
+  }
+  // 4 classes per power of 2: b is the highest bit of size-1 (7 <= b < 10)
+  const uint32_t s = (uint32_t) (size - 1);
+  const unsigned int b = 31 - m_core_clz32(s);
+  M_ASSERT (b >= 7 && b < 10);
+  return 4 * b - 20 + ((s >> (b - 2)) & 3);
+}
+
+/* Return the size of the objects of the given size class */
+static inline size_t
+m_m3mpool_sized_class_size(unsigned int c)
+{
+  M_ASSERT (c < M_M3MPOOL_SIZED_NUM_CLASS);
+  if (c < 8) {
+    return 16 * (size_t) (c + 1);
+  }
+  const unsigned int b = 7 + (c - 8) / 4;
+  return ((size_t) 1 << b) + ((c - 8) % 4 + 1) * ((size_t) 1 << (b - 2));
+}
+
+/* Return the number of objects of a batch of the given size class */
+static inline unsigned int
+m_m3mpool_sized_batch(unsigned int c)
+{
+  const size_t n = M_USE_MEMPOOL_SIZED_BATCH_SIZE / m_m3mpool_sized_class_size(c);
+  return (unsigned int) M_MAX(M_MIN(n, 64), 4);
+}
+
+/* Get a new batch of objects from the depot for the given size class.
+   The depot shall be locked. */
+static inline m_m3mpool_sized_node_ct *
+m_m3mpool_sized_depot_get(m_m3mpool_sized_ct *pool, unsigned int c, unsigned int *count)
+{
+  m_m3mpool_sized_depot_ct *depot = &pool->depot[c];
+  const unsigned int batch = m_m3mpool_sized_batch(c);
+  // Full batch available?
+  m_m3mpool_sized_node_ct *ret = depot->batches;
+  if (ret != NULL) {
+    depot->batches = ret->next_batch;
+    *count = batch;
+    return ret;
+  }
+  // Loose objects available?
+  ret = depot->loose;
+  if (ret != NULL) {
+    m_m3mpool_sized_node_ct *last = ret;
+    unsigned int n = 1;
+    while (n < batch && last->next != NULL) {
+      last = last->next;
+      n++;
+    }
+    depot->loose = last->next;
+    last->next = NULL;
+    *count = n;
+    return ret;
+  }
+  // Carve a new batch from the region of the size class
+  const size_t size = m_m3mpool_sized_class_size(c);
+  if (M_UNLIKELY (depot->ptr == NULL || (size_t) (depot->end - depot->ptr) < size * batch)) {
+    const size_t alloc = M_MAX(M_USE_MEMPOOL_SIZED_SLAB_SIZE, size * batch + size);
+    m_m3mpool_sized_slab_ct *slab = (m_m3mpool_sized_slab_ct *) (void *) M_MEMORY_REALLOC(char, NULL, alloc);
+    if (M_UNLIKELY (slab == NULL)) {
+      M_MEMORY_FULL(alloc);
+      return NULL;
+    }
+    slab->next = pool->slabs;
+    slab->size = alloc;
+    pool->slabs = slab;
+    // The header of the slab takes the place of the first object
+    depot->ptr = (char *) (void *) slab + size;
+    depot->end = (char *) (void *) slab + alloc;
+  }
+  ret = (m_m3mpool_sized_node_ct *) (void *) depot->ptr;
+  m_m3mpool_sized_node_ct *node = ret;
+  for(unsigned int i = 1; i < batch; i++) {
+    node->next = (m_m3mpool_sized_node_ct *) (void *) ((char *) (void *) node + size);
+    node = node->next;
+  }
+  node->next = NULL;
+  depot->ptr += size * batch;
+  *count = batch;
+  return ret;
+}
+
+/* Slow path of the allocation: refill the cache from the depot */
+static inline void *
+m_m3mpool_sized_refill(m_m3mpool_sized_ct *pool, m_m3mpool_sized_cache_ct *cache, unsigned int c)
+{
+  M_ASSERT (cache->list[c] == NULL && cache->pool == pool);
+  unsigned int count = 0;
+  m_mutex_lock(pool->lock);
+  m_m3mpool_sized_node_ct *list = m_m3mpool_sized_depot_get(pool, c, &count);
+  m_mutex_unlock(pool->lock);
+  if (M_UNLIKELY (list == NULL)) {
+    return NULL;
+  }
+  cache->list[c]  = list->next;
+  cache->count[c] = count - 1;
+  return list;
+}
+
+/* Give back a full batch of the cache to the depot */
+static inline void
+m_m3mpool_sized_release(m_m3mpool_sized_ct *pool, m_m3mpool_sized_cache_ct *cache, unsigned int c)
+{
+  const unsigned int batch = m_m3mpool_sized_batch(c);
+  M_ASSERT (cache->count[c] >= batch);
+  m_m3mpool_sized_node_ct *first = cache->list[c];
+  m_m3mpool_sized_node_ct *last = first;
+  for(unsigned int i = 1; i < batch; i++) {
+    last = last->next;
+  }
+  cache->list[c] = last->next;
+  cache->count[c] -= batch;
+  last->next = NULL;
+  m_mutex_lock(pool->lock);
+  first->next_batch = pool->depot[c].batches;
+  pool->depot[c].batches = first;
+  m_mutex_unlock(pool->lock);
+}
+
+/* Give back all the objects of the cache to the depot */
+static inline void
+m_m3mpool_sized_flush(m_m3mpool_sized_ct *pool, m_m3mpool_sized_cache_ct *cache)
+{
+  M_ASSERT (cache->pool == pool);
+  for(unsigned int c = 0; c < M_M3MPOOL_SIZED_NUM_CLASS; c++) {
+    const unsigned int batch = m_m3mpool_sized_batch(c);
+    while (cache->count[c] >= batch) {
+      m_m3mpool_sized_release(pool, cache, c);
+    }
+    m_m3mpool_sized_node_ct *first = cache->list[c];
+    if (first != NULL) {
+      m_m3mpool_sized_node_ct *last = first;
+      while (last->next != NULL) {
+        last = last->next;
+      }
+      m_mutex_lock(pool->lock);
+      last->next = pool->depot[c].loose;
+      pool->depot[c].loose = first;
+      m_mutex_unlock(pool->lock);
+      cache->list[c] = NULL;
+      cache->count[c] = 0;
+    }
+  }
+}
+
+/* Destructor of the caches created by a terminating thread from this
+   translation unit: give back their objects to the depots and free them */
+static inline void
+m_m3mpool_sized_thread_exit(void *arg)
+{
+  m_m3mpool_sized_cache_ct *cache = (m_m3mpool_sized_cache_ct *) arg;
+  while (cache != NULL) {
+    m_m3mpool_sized_cache_ct *next = cache->thread_next;
+    m_m3mpool_sized_ct *pool = cache->pool;
+    if (pool != NULL) {
+      m_m3mpool_sized_flush(pool, cache);
+      m_mutex_lock(pool->lock);
+      m_m3mpool_sized_cache_ct **p = &pool->caches;
+      while (*p != cache) {
+        p = &(*p)->next;
+      }
+      *p = cache->next;
+      m_mutex_unlock(pool->lock);
+    }
+    M_MEMORY_FREE(cache);
+    cache = next;
+  }
+}
+
+static inline void
+m_m3mpool_sized_key_init(void)
+{
+  m_thread_key_init(m_m3mpool_sized_key, m_m3mpool_sized_thread_exit);
+}
+
+/* Slow path of the access to the cache of the current thread for the pool:
+   search it in the caches of the thread, then in the caches of the pool
+   (it may have been created from another translation unit), and create it
+   if 'create' is true. Return NULL if there is none. */
+static inline m_m3mpool_sized_cache_ct *
+m_m3mpool_sized_find_cache(m_m3mpool_sized_ct *pool, bool create)
+{
+  m_once_call(m_m3mpool_sized_once, m_m3mpool_sized_key_init);
+  m_m3mpool_sized_cache_ct *first =
+    (m_m3mpool_sized_cache_ct *) m_thread_key_get(m_m3mpool_sized_key);
+  m_m3mpool_sized_cache_ct *cache, *orphan = NULL;
+  for(cache = first; cache != NULL; cache = cache->thread_next) {
+    if (cache->pool == pool) {
+      m_m3mpool_sized_last = cache;
+      return cache;
+    }
+    if (cache->pool == NULL) {
+      orphan = cache;
+    }
+  }
+  const m_thread_id_t tid = m_thread_self_id();
+  m_mutex_lock(pool->lock);
+  for(cache = pool->caches; cache != NULL; cache = cache->next) {
+    if (m_thread_id_equal_p(cache->tid, tid)) {
+      break;
+    }
+  }
+  m_mutex_unlock(pool->lock);
+  if (cache == NULL) {
+    if (!create) {
+      return NULL;
+    }
+    // Reuse the cache of a cleared pool, or create a new one
+    cache = orphan;
+    if (cache == NULL) {
+      cache = (m_m3mpool_sized_cache_ct *) (void *)
+        M_MEMORY_REALLOC(char, NULL, sizeof (m_m3mpool_sized_cache_ct));
+      if (M_UNLIKELY (cache == NULL)) {
+        M_MEMORY_FULL(sizeof (m_m3mpool_sized_cache_ct));
+        return NULL;
+      }
+      cache->thread_next = first;
+      m_thread_key_set(m_m3mpool_sized_key, cache);
+    }
+    memset(cache->list, 0, sizeof cache->list);
+    memset(cache->count, 0, sizeof cache->count);
+    cache->pool = pool;
+    cache->tid = tid;
+    m_mutex_lock(pool->lock);
+    cache->next = pool->caches;
+    pool->caches = cache;
+    m_mutex_unlock(pool->lock);
+  }
+  m_m3mpool_sized_last = cache;
+  return cache;
+}
+
+/* Return the cache of the current thread for the pool
+   (NULL if it cannot be created) */
+static inline m_m3mpool_sized_cache_ct *
+m_m3mpool_sized_cache(m_m3mpool_sized_ct *pool)
+{
+  m_m3mpool_sized_cache_ct *cache = m_m3mpool_sized_last;
+  if (M_LIKELY (cache != NULL && cache->pool == pool)) {
+    return cache;
+  }
+  return m_m3mpool_sized_find_cache(pool, true);
+}
+
+static inline void
+m_m3mpool_sized_init(m_m3mpool_sized_ct *pool)
+{
+  m_mutex_init(pool->lock);
+  pool->slabs = NULL;
+  for(unsigned int c = 0; c < M_M3MPOOL_SIZED_NUM_CLASS; c++) {
+    pool->depot[c].batches = NULL;
+    pool->depot[c].loose   = NULL;
+    pool->depot[c].ptr     = NULL;
+    pool->depot[c].end     = NULL;
+  }
+  pool->caches = NULL;
+}
+
+/* Clear the pool. The caches of the threads are emptied: they are freed
+   when their thread terminates (or reused for another pool) */
+static inline void
+m_m3mpool_sized_clear(m_m3mpool_sized_ct *pool)
+{
+  m_m3mpool_sized_cache_ct *cache = pool->caches;
+  while (cache != NULL) {
+    cache->pool = NULL;
+    memset(cache->list, 0, sizeof cache->list);
+    memset(cache->count, 0, sizeof cache->count);
+    cache = cache->next;
+  }
+  pool->caches = NULL;
+  m_m3mpool_sized_slab_ct *slab = pool->slabs;
+  while (slab != NULL) {
+    m_m3mpool_sized_slab_ct *next = slab->next;
+    M_MEMORY_FREE(slab);
+    slab = next;
+  }
+  pool->slabs = NULL;
+  m_mutex_clear(pool->lock);
+}
+
+static inline void *
+m_m3mpool_sized_alloc(m_m3mpool_sized_ct *pool, size_t size)
+{
+  if (M_UNLIKELY (size > M_MEMPOOL_SIZED_MAX_SIZE)) {
+    return M_MEMORY_REALLOC(char, NULL, size);
+  }
+  m_m3mpool_sized_cache_ct *cache = m_m3mpool_sized_cache(pool);
+  if (M_UNLIKELY (cache == NULL)) {
+    return NULL;
+  }
+  const unsigned int c = m_m3mpool_sized_class(size);
+  m_m3mpool_sized_node_ct *ret = cache->list[c];
+  if (M_LIKELY (ret != NULL)) {
+    cache->list[c] = ret->next;
+    cache->count[c]--;
+    return ret;
+  }
+  return m_m3mpool_sized_refill(pool, cache, c);
+}
+
+static inline void
+m_m3mpool_sized_free(m_m3mpool_sized_ct *pool, void *ptr, size_t size)
+{
+  if (M_UNLIKELY (ptr == NULL)) {
+    return;
+  }
+  if (M_UNLIKELY (size > M_MEMPOOL_SIZED_MAX_SIZE)) {
+    M_MEMORY_FREE(ptr);
+    return;
+  }
+  const unsigned int c = m_m3mpool_sized_class(size);
+  m_m3mpool_sized_node_ct *node = (m_m3mpool_sized_node_ct *) ptr;
+  m_m3mpool_sized_cache_ct *cache = m_m3mpool_sized_cache(pool);
+  if (M_UNLIKELY (cache == NULL)) {
+    // No cache for the thread: give back the object to the depot
+    m_mutex_lock(pool->lock);
+    node->next = pool->depot[c].loose;
+    pool->depot[c].loose = node;
+    m_mutex_unlock(pool->lock);
+    return;
+  }
+  node->next = cache->list[c];
+  cache->list[c] = node;
+  // Give back a batch to the depot if the cache has too many objects
+  if (M_UNLIKELY (++cache->count[c] >= 2 * m_m3mpool_sized_batch(c))) {
+    m_m3mpool_sized_release(pool, cache, c);
+  }
+}
+
+static inline void *
+m_m3mpool_sized_realloc(m_m3mpool_sized_ct *pool, void *ptr, size_t old_size, size_t new_size)
+{
+  if (ptr == NULL) {
+    return m_m3mpool_sized_alloc(pool, new_size);
+  }
+  if (old_size > M_MEMPOOL_SIZED_MAX_SIZE && new_size > M_MEMPOOL_SIZED_MAX_SIZE) {
+    return M_MEMORY_REALLOC(char, (char *) ptr, new_size);
+  }
+  if (old_size <= M_MEMPOOL_SIZED_MAX_SIZE && new_size <= M_MEMPOOL_SIZED_MAX_SIZE
+      && m_m3mpool_sized_class(old_size) == m_m3mpool_sized_class(new_size)) {
+    return ptr;
+  }
+  void *n = m_m3mpool_sized_alloc(pool, new_size);
+  if (M_UNLIKELY (n == NULL)) {
+    return NULL;
+  }
+  memcpy(n, ptr, M_MIN(old_size, new_size));
+  m_m3mpool_sized_free(pool, ptr, old_size);
+  return n;
+}
+
+#define M_M3MPOOL_SIZED_DEF_P2(name, name_t)                                  \
+                                                                              \
+  typedef m_m3mpool_sized_ct name_t[1];                                       \
+                                                                              \
+  static inline void *                                                        \
+  M_C(name,_alloc)(name_t mem, size_t size)                                   \
+  {                                                                           \
+    return m_m3mpool_sized_alloc(mem, size);                                  \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name,_free)(name_t mem, void *ptr, size_t size)                         \
+  {                                                                           \
+    m_m3mpool_sized_free(mem, ptr, size);                                     \
+  }                                                                           \
+                                                                              \
+  static inline void *                                                        \
+  M_C(name,_realloc)(name_t mem, void *ptr, size_t old_size, size_t new_size) \
+  {                                                                           \
+    return m_m3mpool_sized_realloc(mem, ptr, old_size, new_size);             \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name,_flush)(name_t mem)                                                \
+  {                                                                           \
+    m_m3mpool_sized_cache_ct *cache = m_m3mpool_sized_find_cache(mem, false); \
+    if (cache != NULL) {                                                      \
+      m_m3mpool_sized_flush(mem, cache);                                      \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Functions of the allocator interface */                                  \
+  static inline void *                                                        \
+  M_C3(m_m3mpool_,name,_allocate)(void *state, size_t size)                   \
+  {                                                                           \
+    return M_C(name,_alloc)((m_m3mpool_sized_ct *) state, size);              \
+  }                                                                           \
+                                                                              \
+  static inline void *                                                        \
+  M_C3(m_m3mpool_,name,_reallocate)(void *state, void *ptr, size_t old_size, size_t new_size) \
+  {                                                                           \
+    return M_C(name,_realloc)((m_m3mpool_sized_ct *) state, ptr, old_size, new_size); \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C3(m_m3mpool_,name,_deallocate)(void *state, void *ptr, size_t size)      \
+  {                                                                           \
+    M_C(name,_free)((m_m3mpool_sized_ct *) state, ptr, size);                 \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name,_init)(name_t mem)                                                 \
+  {                                                                           \
+    m_m3mpool_sized_init(mem);                                                \
+    mem->allocator.allocate   = M_C3(m_m3mpool_,name,_allocate);              \
+    mem->allocator.reallocate = M_C3(m_m3mpool_,name,_reallocate);            \
+    mem->allocator.deallocate = M_C3(m_m3mpool_,name,_deallocate);            \
+    mem->allocator.state      = mem;                                          \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name,_clear)(name_t mem)                                                \
+  {                                                                           \
+    m_m3mpool_sized_clear(mem);                                               \
+  }                                                                           \
+                                                                              \
+  static inline const m_allocator_t *                                         \
+  M_C(name,_allocator)(name_t mem)                                            \
+  {                                                                           \
+    return &mem->allocator;                                                   \
+  }                                                                           \
+
 
 #if M_USE_SMALL_NAME
 #define MEMPOOL_DEF M_MEMPOOL_DEF
 #define MEMPOOL_DEF_AS M_MEMPOOL_DEF_AS
+#define MEMPOOL_SIZED_DEF M_MEMPOOL_SIZED_DEF
+#define MEMPOOL_SIZED_DEF_AS M_MEMPOOL_SIZED_DEF_AS
 #endif
 
 #endif
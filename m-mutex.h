@@ -57,6 +57,9 @@ typedef cnd_t                  m_cond_t[1];
 /* Define a thread type based on C11 definition */
 typedef thrd_t                 m_thread_t[1];
 
+/* Define a thread identifier type based on C11 definition */
+typedef thrd_t                 m_thread_id_t;
+
 /* Initialize the mutex (constructor) */
 static inline void m_mutex_init(m_mutex_t m)
 {
@@ -134,6 +137,18 @@ static inline void m_thread_join(m_thread_t t)
   (void) rc;
 }
 
+/* Return the identifier of the current thread */
+static inline m_thread_id_t m_thread_self_id(void)
+{
+  return thrd_current();
+}
+
+/* Test if both thread identifiers are the same */
+static inline bool m_thread_id_equal_p(m_thread_id_t a, m_thread_id_t b)
+{
+  return thrd_equal(a, b) != 0;
+}
+
 /* The thread has nothing meaningfull to do.
    Inform the OS to let other threads be scheduled */
 static inline void m_thread_yield(void)
@@ -164,6 +179,37 @@ static inline void m_once_call(m_once_t o, void (*func)(void))
   call_once(o,func);
 }
 
+/* Define a key of thread specific storage based on C11 definition */
+typedef tss_t                  m_thread_key_t[1];
+
+/* Initialize the key (constructor). When a thread terminates,
+   the destructor is called with its value if it is not NULL */
+static inline void m_thread_key_init(m_thread_key_t k, void (*destructor)(void*))
+{
+  int rc = tss_create(k, destructor);
+  // Abort program in case of initialization failure
+  M_ASSERT_INIT (rc == thrd_success, "thread key");
+}
+
+/* Clear the key (destructor). The destructors are not called */
+static inline void m_thread_key_clear(m_thread_key_t k)
+{
+  tss_delete(*k);
+}
+
+/* Return the value of the key for the current thread (NULL if not set) */
+static inline void *m_thread_key_get(m_thread_key_t k)
+{
+  return tss_get(*k);
+}
+
+/* Set the value of the key for the current thread */
+static inline void m_thread_key_set(m_thread_key_t k, void *value)
+{
+  int rc = tss_set(*k, value);
+  M_ASSERT_INIT (rc == thrd_success, "thread key");
+}
+
 // Attribute to use to allocate a global variable to a thread.
 #define M_THREAD_ATTR _Thread_local
 
@@ -216,6 +262,9 @@ M_BEGIN_PROTECTED_CODE
 /* Define a thread type based on WINDOWS definition */
 typedef HANDLE                 m_thread_t[1];
 
+/* Define a thread identifier type based on WINDOWS definition */
+typedef DWORD                  m_thread_id_t;
+
 /* Define a mutex type based on WINDOWS definition */
 typedef CRITICAL_SECTION       m_mutex_t[1];
 
@@ -292,6 +341,18 @@ static inline void m_thread_join(m_thread_t t)
   CloseHandle(*t);
 }
 
+/* Return the identifier of the current thread */
+static inline m_thread_id_t m_thread_self_id(void)
+{
+  return GetCurrentThreadId();
+}
+
+/* Test if both thread identifiers are the same */
+static inline bool m_thread_id_equal_p(m_thread_id_t a, m_thread_id_t b)
+{
+  return a == b;
+}
+
 /* The thread has nothing meaningfull to do.
    Inform the OS to let other threads be scheduled */
 static inline void m_thread_yield(void)
@@ -331,6 +392,37 @@ static inline void m_once_call(m_once_t o, void (*func)(void))
   InitOnceExecuteOnce(o, m_once_callback, (void*)(intptr_t)func, NULL);
 }
 
+/* Define a key of thread specific storage based on WINDOWS definition */
+typedef DWORD                  m_thread_key_t[1];
+
+/* Initialize the key (constructor). When a thread terminates,
+   the destructor is called with its value if it is not NULL */
+static inline void m_thread_key_init(m_thread_key_t k, void (*destructor)(void*))
+{
+  *k = FlsAlloc((PFLS_CALLBACK_FUNCTION) (uintptr_t) destructor);
+  M_ASSERT_INIT (*k != FLS_OUT_OF_INDEXES, "thread key");
+}
+
+/* Clear the key (destructor).
+   NOTE: The destructors are called for the values still set */
+static inline void m_thread_key_clear(m_thread_key_t k)
+{
+  FlsFree(*k);
+}
+
+/* Return the value of the key for the current thread (NULL if not set) */
+static inline void *m_thread_key_get(m_thread_key_t k)
+{
+  return FlsGetValue(*k);
+}
+
+/* Set the value of the key for the current thread */
+static inline void m_thread_key_set(m_thread_key_t k, void *value)
+{
+  BOOL rc = FlsSetValue(*k, value);
+  M_ASSERT_INIT (rc != 0, "thread key");
+}
+
 #if defined(_MSC_VER)
 // Attribute to use to allocate a global variable to a thread (MSVC def).
 # define M_THREAD_ATTR __declspec( thread )
@@ -367,6 +459,9 @@ typedef pthread_cond_t         m_cond_t[1];
 /* Define a thread type based on PTHREAD definition */
 typedef pthread_t              m_thread_t[1];
 
+/* Define a thread identifier type based on PTHREAD definition */
+typedef pthread_t              m_thread_id_t;
+
 /* Initialize the mutex (constructor) */
 static inline void m_mutex_init(m_mutex_t m)
 {
@@ -451,6 +546,18 @@ static inline void m_thread_join(m_thread_t t)
   M_ASSERT (_rc == 0);
 }
 
+/* Return the identifier of the current thread */
+static inline m_thread_id_t m_thread_self_id(void)
+{
+  return pthread_self();
+}
+
+/* Test if both thread identifiers are the same */
+static inline bool m_thread_id_equal_p(m_thread_id_t a, m_thread_id_t b)
+{
+  return pthread_equal(a, b) != 0;
+}
+
 /* The thread has nothing meaningfull to do.
    Inform the OS to let other threads be scheduled */
 static inline void m_thread_yield(void)
@@ -480,6 +587,37 @@ static inline void m_once_call(m_once_t o, void (*func)(void))
   pthread_once(o,func);
 }
 
+/* Define a key of thread specific storage based on PTHREAD definition */
+typedef pthread_key_t          m_thread_key_t[1];
+
+/* Initialize the key (constructor). When a thread terminates,
+   the destructor is called with its value if it is not NULL */
+static inline void m_thread_key_init(m_thread_key_t k, void (*destructor)(void*))
+{
+  int _rc = pthread_key_create(k, destructor);
+  // Abort program in case of initialization failure
+  M_ASSERT_INIT (_rc == 0, "thread key");
+}
+
+/* Clear the key (destructor). The destructors are not called */
+static inline void m_thread_key_clear(m_thread_key_t k)
+{
+  pthread_key_delete(*k);
+}
+
+/* Return the value of the key for the current thread (NULL if not set) */
+static inline void *m_thread_key_get(m_thread_key_t k)
+{
+  return pthread_getspecific(*k);
+}
+
+/* Set the value of the key for the current thread */
+static inline void m_thread_key_set(m_thread_key_t k, void *value)
+{
+  int _rc = pthread_setspecific(*k, value);
+  M_ASSERT_INIT (_rc == 0, "thread key");
+}
+
 #define M_THREAD_ATTR __thread
 
 M_END_PROTECTED_CODE
@@ -0,0 +1,809 @@
+/*
+ * M*LIB - Persistent B+TREE module
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_PERSISTENT_BPTREE_H
+#define MSTARLIB_PERSISTENT_BPTREE_H
+
+#include "m-core.h"
+#include "m-atomic.h"
+
+/* Define a persistent B+tree of size 'N' that maps a 'key' to a 'value'
+   with its associated functions.
+   The nodes are reference counted and shared between the trees:
+   a snapshot of a tree (or a copy) is done in O(1) and a modification
+   of a tree only copies the nodes of the modified path (copy-on-write).
+   USAGE:
+   P_BPTREE_DEF2(name, N, key_t, key_oplist, value_t, value_oplist)
+   OR
+   P_BPTREE_DEF2(name, N, key_t, value_t)
+*/
+#define M_P_BPTREE_DEF2(name, N, key_type, ...)                               \
+  M_P_BPTREE_DEF2_AS(name, M_C(name,_t), M_C(name,_it_t), M_C(name, _itref_t), N, key_type, __VA_ARGS__)
+
+
+/* Define a persistent B+tree of size 'N' that maps a 'key' to a 'value'
+   as the given name name_t with its associated functions.
+   USAGE:
+   P_BPTREE_DEF2_AS(name, name_t, it_t, itref_t, N, key_t, key_oplist, value_t, value_oplist)
+   OR
+   P_BPTREE_DEF2_AS(name, name_t, it_t, itref_t, N, key_t, value_t)
+*/
+#define M_P_BPTREE_DEF2_AS(name, name_t, it_t, itref_t, N, key_type, ...)     \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_PBPTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                \
+                   ((name, N, key_type, M_GLOBAL_OPLIST_OR_DEF(key_type)(), __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), name_t, M_C(name, _node_ct), it_t, itref_t ), \
+                    (name, N, key_type, __VA_ARGS__,                                                                            name_t, M_C(name, _node_ct), it_t, itref_t ))) \
+  M_END_PROTECTED_CODE
+
+
+/* Define the oplist of a persistent B+TREE (from P_BPTREE_DEF2).
+   USAGE: P_BPTREE_OPLIST2(name[, key_oplist, value_oplist])
+   NOTE: IT_REF is not exported as the elements may be shared. */
+#define M_P_BPTREE_OPLIST2(...)                                               \
+  M_PBPTR33_OPLIST2_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                            \
+                      ((__VA_ARGS__, M_BASIC_OPLIST, M_BASIC_OPLIST ),        \
+                       (__VA_ARGS__ )))
+
+
+/********************************** INTERNAL ************************************/
+
+/* Deferred evaluation */
+#define M_PBPTR33_OPLIST2_P1(arg) M_PBPTR33_OPLIST2_P2 arg
+
+/* Validation of the given oplists (first the key oplist, then the value oplist) */
+#define M_PBPTR33_OPLIST2_P2(name, key_oplist, value_oplist)                  \
+  M_IF_OPLIST(key_oplist)(M_PBPTR33_OPLIST2_P3, M_PBPTR33_OPLIST2_FAILURE)(name, key_oplist, value_oplist)
+#define M_PBPTR33_OPLIST2_P3(name, key_oplist, value_oplist)                  \
+  M_IF_OPLIST(value_oplist)(M_PBPTR33_OPLIST2_P4, M_PBPTR33_OPLIST2_FAILURE)(name, key_oplist, value_oplist)
+
+/* Prepare a clean compilation failure */
+#define M_PBPTR33_OPLIST2_FAILURE(name, key_oplist, value_oplist)             \
+  ((M_LIB_ERROR(ARGUMENT_OF_P_BPTREE_OPLIST_IS_NOT_AN_OPLIST, name, key_oplist, value_oplist)))
+
+/* Final definition of the oplist (associative array) */
+#define M_PBPTR33_OPLIST2_P4(name, key_oplist, value_oplist)                  \
+  (INIT(M_C(name, _init)),                                                    \
+   INIT_SET(M_C(name, _init_set)),                                            \
+   SET(M_C(name, _set)),                                                      \
+   CLEAR(M_C(name, _clear)),                                                  \
+   INIT_MOVE(M_C(name, _init_move)),                                          \
+   MOVE(M_C(name, _move)),                                                    \
+   SWAP(M_C(name, _swap)),                                                    \
+   NAME(name),                                                                \
+   TYPE(M_C(name,_ct)),                                                       \
+   SUBTYPE(M_C(name, _subtype_ct)),                                           \
+   EMPTY_P(M_C(name,_empty_p)),                                               \
+   GET_SIZE(M_C(name,_size)),                                                 \
+   IT_TYPE(M_C(name, _it_ct)),                                                \
+   IT_FIRST(M_C(name,_it)),                                                   \
+   IT_SET(M_C(name,_it_set)),                                                 \
+   IT_END(M_C(name,_it_end)),                                                 \
+   IT_END_P(M_C(name,_end_p)),                                                \
+   IT_EQUAL_P(M_C(name,_it_equal_p)),                                         \
+   IT_NEXT(M_C(name,_next)),                                                  \
+   IT_CREF(M_C(name,_cref)),                                                  \
+   RESET(M_C(name,_reset)),                                                   \
+   KEY_TYPE(M_C(name, _key_ct)),                                              \
+   VALUE_TYPE(M_C(name, _value_ct)),                                          \
+   SET_KEY(M_C(name, _set_at)),                                               \
+   GET_KEY(M_C(name, _get)),                                                  \
+   ERASE_KEY(M_C(name, _erase)),                                              \
+   KEY_OPLIST(key_oplist),                                                    \
+   VALUE_OPLIST(value_oplist),                                                \
+   M_IF_METHOD_BOTH(EQUAL, key_oplist, value_oplist)(EQUAL(M_C(name, _equal_p)),), \
+   M_IF_METHOD(NEW, key_oplist)(NEW(M_GET_NEW key_oplist),)                   \
+   M_IF_METHOD(DEL, key_oplist)(DEL(M_GET_DEL key_oplist),)                   \
+   )
+
+/* Max depth of any persistent B+tree (see M_BPTR33_MAX_STACK) */
+#define M_PBPTR33_MAX_STACK ((int)(1 + CHAR_BIT*sizeof (size_t)))
+
+/* Contract of a node of a persistent B+TREE of size N */
+#define M_PBPTR33_NODE_CONTRACT(N, n) do {                                    \
+    M_ASSERT ((n) != NULL);                                                   \
+    M_ASSERT (atomic_load(&(n)->cpt) >= 1);                                   \
+    M_ASSERT (0 <= (n)->num && (n)->num <= N);                                \
+  } while (0)
+
+/* Contract of a persistent B+TREE */
+#define M_PBPTR33_CONTRACT(N, b) do {                                         \
+    M_ASSERT ((b) != NULL);                                                   \
+    M_ASSERT (((b)->root == NULL) == ((b)->size == 0));                       \
+    if ((b)->root != NULL) M_PBPTR33_NODE_CONTRACT(N, (b)->root);             \
+  } while (0)
+
+/* Deferred evaluation for the persistent b+tree definition,
+   so that all arguments are evaluated before further expansion */
+#define M_PBPTR33_DEF_P1(arg) M_ID( M_PBPTR33_DEF_P2 arg )
+
+/* Validate the key oplist before going further */
+#define M_PBPTR33_DEF_P2(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t) \
+  M_IF_OPLIST(key_oplist)(M_PBPTR33_DEF_P3, M_PBPTR33_DEF_FAILURE)(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t)
+
+/* Validate the value oplist before going further */
+#define M_PBPTR33_DEF_P3(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t) \
+  M_IF_OPLIST(value_oplist)(M_PBPTR33_DEF_P4, M_PBPTR33_DEF_FAILURE)(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t)
+
+/* Stop processing with a compilation failure */
+#define M_PBPTR33_DEF_FAILURE(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t) \
+  M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(P_BPTREE_DEF2): one of the given argument is not a valid oplist: " M_AS_STR(key_oplist) " / " M_AS_STR(value_oplist))
+
+/* Internal persistent b+tree definition
+   - name: prefix to be used
+   - N: size of the node
+   - key_t: key type of the elements of the container
+   - key_oplist: oplist of the key type of the elements of the container
+   - value_t: value type of the elements of the container
+   - value_oplist: oplist of the value type of the elements of the container
+   - tree_t: alias for the type of the container
+   - node_t: alias for internal node
+   - it_t: alias for the iterator of the container
+   - itref_t: alias for the type referenced by the iterator
+ */
+#define M_PBPTR33_DEF_P4(name, N, key_t, key_oplist, value_t, value_oplist, tree_t, node_t, it_t, itref_t) \
+                                                                              \
+  /* Type returned by the iterator: pointers to the shared objects,           \
+     which shall not be modified */                                           \
+  typedef struct M_C(name, _pair_s) {                                         \
+    const key_t   *key_ptr;                                                   \
+    const value_t *value_ptr;                                                 \
+  } itref_t;                                                                  \
+                                                                              \
+  /* Define a Node of a persistent B+TREE.                                    \
+   * A node can be shared by several trees: it can only be modified           \
+   * if it is referenced only once (otherwise it is copied before).           \
+   * There is no link between the leaves, as a leaf can be shared by          \
+   * different trees. It allocates one more element than needed so            \
+   * that the code can push one more element in the node and then             \
+   * split the node.                                                          \
+   */                                                                         \
+  typedef struct M_C(name, _node_s) {                                         \
+    atomic_uint cpt;      /* Number of references (parent nodes or trees) */  \
+    int         num;      /* Number of keys */                                \
+    bool        leaf;                                                         \
+    key_t       key[N+1];                                                     \
+    union  M_C(name, _kind_s) {       /* either value or pointer to other nodes */ \
+      value_t                    value[N+1];                                  \
+      struct M_C(name, _node_s) *node[N+2];                                   \
+    } kind;                                                                   \
+  } *node_t;                                                                  \
+                                                                              \
+  /* A persistent B+TREE is a reference to its root node */                   \
+  typedef struct M_C(name, _s) {                                              \
+    node_t root;                                                              \
+    size_t size;                                                              \
+  } tree_t[1];                                                                \
+  typedef struct M_C(name, _s) *M_C(name, _ptr);                              \
+  typedef const struct M_C(name, _s) *M_C(name, _srcptr);                     \
+                                                                              \
+  /* Define the Iterator: the path from the root to the current leaf */       \
+  typedef struct M_C(name, _it_s) {                                           \
+    itref_t pair;                                                             \
+    int     depth;        /* Index of the leaf in the path (<0 if end) */     \
+    node_t  node[M_PBPTR33_MAX_STACK];                                        \
+    int     idx[M_PBPTR33_MAX_STACK];                                         \
+  } it_t[1];                                                                  \
+                                                                              \
+  /* Definition of the alias used by the oplists */                           \
+  typedef itref_t   M_C(name, _subtype_ct);                                   \
+  typedef key_t     M_C(name, _key_ct);                                       \
+  typedef value_t   M_C(name, _value_ct);                                     \
+  typedef tree_t    M_C(name, _ct);                                           \
+  typedef it_t      M_C(name, _it_ct);                                        \
+                                                                              \
+  M_CHECK_COMPATIBLE_OPLIST(name, 1, key_t, key_oplist)                       \
+  M_CHECK_COMPATIBLE_OPLIST(name, 2, value_t, value_oplist)                   \
+                                                                              \
+  /* Allocate a new node referenced once */                                   \
+  static inline node_t M_C(name, _new_node)(bool leaf)                        \
+  {                                                                           \
+    M_STATIC_ASSERT(N >= 3, M_LIB_ILLEGAL_PARAM,                              \
+          "Number of items per node shall be >= 3.");                         \
+    node_t n = M_CALL_NEW(key_oplist, struct M_C(name, _node_s));             \
+    if (M_UNLIKELY (n == NULL)) {                                             \
+      M_MEMORY_FULL(sizeof (struct M_C(name, _node_s)));                      \
+      M_ASSERT (0);                                                           \
+    }                                                                         \
+    atomic_init(&n->cpt, 1U);                                                 \
+    n->num  = 0;                                                              \
+    n->leaf = leaf;                                                           \
+    return n;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Add a reference to the node */                                           \
+  static inline void M_C(name, _acquire_node)(node_t n)                       \
+  {                                                                           \
+    atomic_fetch_add_explicit(&n->cpt, 1U, memory_order_relaxed);             \
+  }                                                                           \
+                                                                              \
+  /* Remove a reference to the node, freeing it (and releasing its            \
+     children) if it was the last one */                                      \
+  static inline void M_C(name, _release_node)(node_t n)                       \
+  {                                                                           \
+    M_PBPTR33_NODE_CONTRACT(N, n);                                            \
+    if (atomic_fetch_sub_explicit(&n->cpt, 1U, memory_order_acq_rel) != 1)    \
+      return;                                                                 \
+    for(int i = 0; i < n->num; i++) {                                         \
+      M_CALL_CLEAR(key_oplist, n->key[i]);                                    \
+      if (n->leaf) {                                                          \
+        M_CALL_CLEAR(value_oplist, n->kind.value[i]);                         \
+      }                                                                       \
+    }                                                                         \
+    if (!n->leaf) {                                                           \
+      for(int i = 0; i <= n->num; i++) {                                      \
+        M_C(name, _release_node)(n->kind.node[i]);                            \
+      }                                                                       \
+    }                                                                         \
+    M_CALL_DEL(key_oplist, n);                                                \
+  }                                                                           \
+                                                                              \
+  /* Ensure that the node referenced by '*slot' is only referenced there,     \
+     copying it if needed, so that it can be modified. Return the node. */    \
+  static inline node_t M_C(name, _unshare)(node_t *slot)                      \
+  {                                                                           \
+    node_t o = *slot;                                                         \
+    M_PBPTR33_NODE_CONTRACT(N, o);                                            \
+    if (atomic_load_explicit(&o->cpt, memory_order_acquire) == 1)             \
+      return o;                                                               \
+    node_t n = M_C(name, _new_node)(o->leaf);                                 \
+    for(int i = 0; i < o->num; i++) {                                         \
+      M_CALL_INIT_SET(key_oplist, n->key[i], o->key[i]);                      \
+      if (o->leaf) {                                                          \
+        M_CALL_INIT_SET(value_oplist, n->kind.value[i], o->kind.value[i]);    \
+      }                                                                       \
+    }                                                                         \
+    if (!o->leaf) {                                                           \
+      for(int i = 0; i <= o->num; i++) {                                      \
+        n->kind.node[i] = o->kind.node[i];                                    \
+        M_C(name, _acquire_node)(n->kind.node[i]);                            \
+      }                                                                       \
+    }                                                                         \
+    n->num = o->num;                                                          \
+    M_C(name, _release_node)(o);                                              \
+    *slot = n;                                                                \
+    return n;                                                                 \
+  }                                                                           \
+                                                                              \
+  static inline void M_C(name, _init)(tree_t b)                               \
+  {                                                                           \
+    M_ASSERT (b != NULL);                                                     \
+    b->root = NULL;                                                           \
+    b->size = 0;                                                              \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+  }                                                                           \
+                                                                              \
+  static inline void M_C(name, _clear)(tree_t b)                              \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    if (b->root != NULL) {                                                    \
+      M_C(name, _release_node)(b->root);                                      \
+    }                                                                         \
+    /* Clear the tree to avoid using a freed node */                          \
+    b->root = NULL;                                                           \
+    b->size = 0;                                                              \
+  }                                                                           \
+                                                                              \
+  static inline void M_C(name, _reset)(tree_t b)                              \
+  {                                                                           \
+    M_C(name, _clear)(b);                                                     \
+  }                                                                           \
+                                                                              \
+  /* Initialize 'b' as a copy of 'o' in O(1): all nodes are shared */         \
+  static inline void M_C(name, _init_set)(tree_t b, const tree_t o)           \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, o);                                                 \
+    M_ASSERT (b != NULL);                                                     \
+    b->root = o->root;                                                        \
+    b->size = o->size;                                                        \
+    if (b->root != NULL) {                                                    \
+      M_C(name, _acquire_node)(b->root);                                      \
+    }                                                                         \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+  }                                                                           \
+                                                                              \
+  /* Initialize 'b' as a snapshot of the current version of 'o' in O(1) */    \
+  static inline void M_C(name, _snapshot)(tree_t b, const tree_t o)           \
+  {                                                                           \
+    M_C(name, _init_set)(b, o);                                               \
+  }                                                                           \
+                                                                              \
+  static inline void M_C(name, _set)(tree_t b, const tree_t o)                \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    M_PBPTR33_CONTRACT(N, o);                                                 \
+    if (M_UNLIKELY (b == o)) return;                                          \
+    node_t old = b->root;                                                     \
+    M_C(name, _init_set)(b, o);                                               \
+    if (old != NULL) {                                                        \
+      M_C(name, _release_node)(old);                                          \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline void M_C(name, _init_move)(tree_t b, tree_t ref)              \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, ref);                                               \
+    M_ASSERT (b != NULL && b != ref);                                         \
+    b->root = ref->root;                                                      \
+    b->size = ref->size;                                                      \
+    ref->root = NULL;                                                         \
+    ref->size = 0;                                                            \
+  }                                                                           \
+                                                                              \
+  static inline void M_C(name, _move)(tree_t b, tree_t ref)                   \
+  {                                                                           \
+    M_ASSERT (b != ref);                                                      \
+    M_C(name, _clear)(b);                                                     \
+    M_C(name, _init_move)(b, ref);                                            \
+  }                                                                           \
+                                                                              \
+  static inline void M_C(name, _swap)(tree_t tree1, tree_t tree2)             \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, tree1);                                             \
+    M_PBPTR33_CONTRACT(N, tree2);                                             \
+    M_SWAP(node_t, tree1->root, tree2->root);                                 \
+    M_SWAP(size_t, tree1->size, tree2->size);                                 \
+  }                                                                           \
+                                                                              \
+  static inline bool M_C(name, _empty_p)(const tree_t b)                      \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    return b->size == 0;                                                      \
+  }                                                                           \
+                                                                              \
+  static inline size_t M_C(name, _size)(const tree_t b)                       \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    return b->size;                                                           \
+  }                                                                           \
+                                                                              \
+  /* Return the index of the first key of the node >= key */                  \
+  static inline int                                                           \
+  M_C(name, _search_in_node)(const node_t n, key_t const key)                 \
+  {                                                                           \
+    int i;                                                                    \
+    for(i = 0; i < n->num; i++) {                                             \
+      if (M_CALL_CMP(key_oplist, key, n->key[i]) <= 0)                        \
+        break;                                                                \
+    }                                                                         \
+    return i;                                                                 \
+  }                                                                           \
+                                                                              \
+  static inline value_t const *                                               \
+  M_C(name, _cget)(const tree_t b, key_t const key)                           \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    node_t n = b->root;                                                       \
+    if (n == NULL) return NULL;                                               \
+    while (!n->leaf) {                                                        \
+      n = n->kind.node[M_C(name, _search_in_node)(n, key)];                   \
+    }                                                                         \
+    int i = M_C(name, _search_in_node)(n, key);                               \
+    if (i < n->num && M_CALL_CMP(key_oplist, key, n->key[i]) == 0)            \
+      return M_CONST_CAST(value_t, &n->kind.value[i]);                        \
+    return NULL;                                                              \
+  }                                                                           \
+                                                                              \
+  /* Unshare the path from the root to the leaf which may contain key,        \
+     recording the parents and the index of the child in each parent.         \
+     Return the leaf. The tree shall not be empty. */                         \
+  static inline node_t                                                        \
+  M_C(name, _unshare_path)(tree_t b, key_t const key, node_t *parent, int *idx, int *depth) \
+  {                                                                           \
+    int d = 0;                                                                \
+    node_t n = M_C(name, _unshare)(&b->root);                                 \
+    while (!n->leaf) {                                                        \
+      M_ASSERT (d < M_PBPTR33_MAX_STACK);                                     \
+      int i = M_C(name, _search_in_node)(n, key);                             \
+      parent[d] = n;                                                          \
+      idx[d] = i;                                                             \
+      d++;                                                                    \
+      n = M_C(name, _unshare)(&n->kind.node[i]);                              \
+    }                                                                         \
+    *depth = d;                                                               \
+    return n;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Return a modifiable pointer to the value associated to key               \
+     (or NULL if not found). The nodes of the path to this value              \
+     are copied first if they are shared with another tree. */                \
+  static inline value_t *                                                     \
+  M_C(name, _get)(tree_t b, key_t const key)                                  \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    if (M_C(name, _cget)(b, key) == NULL) return NULL;                        \
+    node_t parent[M_PBPTR33_MAX_STACK];                                       \
+    int idx[M_PBPTR33_MAX_STACK];                                             \
+    int d;                                                                    \
+    node_t n = M_C(name, _unshare_path)(b, key, parent, idx, &d);             \
+    int i = M_C(name, _search_in_node)(n, key);                               \
+    M_ASSERT (i < n->num);                                                    \
+    return &n->kind.value[i];                                                 \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _set_at)(tree_t b, key_t const key, value_t const value)          \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    if (b->root == NULL) {                                                    \
+      b->root = M_C(name, _new_node)(true);                                   \
+    }                                                                         \
+    node_t parent[M_PBPTR33_MAX_STACK];                                       \
+    int idx[M_PBPTR33_MAX_STACK];                                             \
+    int d;                                                                    \
+    node_t n = M_C(name, _unshare_path)(b, key, parent, idx, &d);             \
+    int i = M_C(name, _search_in_node)(n, key);                               \
+    if (i < n->num && M_CALL_CMP(key_oplist, key, n->key[i]) == 0) {         \
+      M_CALL_SET(value_oplist, n->kind.value[i], value);                      \
+      return;                                                                 \
+    }                                                                         \
+    memmove(&n->key[i+1], &n->key[i], sizeof(key_t) * (size_t) (n->num-i));  \
+    memmove(&n->kind.value[i+1], &n->kind.value[i], sizeof(value_t) * (size_t) (n->num-i)); \
+    M_CALL_INIT_SET(key_oplist, n->key[i], key);                              \
+    M_CALL_INIT_SET(value_oplist, n->kind.value[i], value);                   \
+    n->num++;                                                                 \
+    b->size++;                                                                \
+    /* Split the nodes of the path which overflow */                          \
+    while (n->num > N) {                                                      \
+      node_t r = M_C(name, _new_node)(n->leaf);                               \
+      node_t p;                                                               \
+      int j;                                                                  \
+      if (d == 0) {                                                           \
+        /* Create a new root */                                               \
+        p = M_C(name, _new_node)(false);                                      \
+        p->kind.node[0] = n;                                                  \
+        b->root = p;                                                          \
+        j = 0;                                                                \
+      } else {                                                                \
+        d--;                                                                  \
+        p = parent[d];                                                        \
+        j = idx[d];                                                           \
+      }                                                                       \
+      M_ASSERT (p->kind.node[j] == n);                                        \
+      /* Make room in the parent for the separator & the new right node */    \
+      memmove(&p->key[j+1], &p->key[j], sizeof(key_t) * (size_t) (p->num-j)); \
+      memmove(&p->kind.node[j+2], &p->kind.node[j+1], sizeof(node_t) * (size_t) (p->num-j)); \
+      p->kind.node[j+1] = r;                                                  \
+      p->num++;                                                               \
+      const int l = (N+1)/2;                                                  \
+      if (n->leaf) {                                                          \
+        /* The separator is a copy of the last key of the left node */        \
+        memcpy(&r->key[0], &n->key[l], sizeof(key_t) * (size_t) (N+1-l));     \
+        memcpy(&r->kind.value[0], &n->kind.value[l], sizeof(value_t) * (size_t) (N+1-l)); \
+        r->num = N+1-l;                                                       \
+        n->num = l;                                                           \
+        M_CALL_INIT_SET(key_oplist, p->key[j], n->key[l-1]);                  \
+      } else {                                                                \
+        /* The middle key is moved up to the parent */                        \
+        memcpy(&r->key[0], &n->key[l+1], sizeof(key_t) * (size_t) (N-l));     \
+        memcpy(&r->kind.node[0], &n->kind.node[l+1], sizeof(node_t) * (size_t) (N+1-l)); \
+        r->num = N-l;                                                         \
+        n->num = l;                                                           \
+        memcpy(&p->key[j], &n->key[l], sizeof(key_t));                        \
+      }                                                                       \
+      n = p;                                                                  \
+    }                                                                         \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+  }                                                                           \
+                                                                              \
+  /* Fix the underflow of the child 'j' of the node 'p' by merging it         \
+     with one of its siblings or by taking an element from it.                \
+     'p' and its child 'j' are not shared. */                                 \
+  static inline void                                                          \
+  M_C(name, _fix_underflow)(node_t p, int j)                                  \
+  {                                                                           \
+    M_ASSERT (!p->leaf && p->num >= 1);                                       \
+    /* Work with the child 'k' and its right sibling */                       \
+    const int k = (j < p->num) ? j : j - 1;                                   \
+    node_t l = M_C(name, _unshare)(&p->kind.node[k]);                         \
+    node_t r = M_C(name, _unshare)(&p->kind.node[k+1]);                       \
+    if (l->leaf) {                                                            \
+      if (l->num + r->num <= N) {                                             \
+        /* Merge the right leaf into the left one */                          \
+        memcpy(&l->key[l->num], &r->key[0], sizeof(key_t) * (size_t) r->num); \
+        memcpy(&l->kind.value[l->num], &r->kind.value[0], sizeof(value_t) * (size_t) r->num); \
+        l->num += r->num;                                                     \
+        M_CALL_CLEAR(key_oplist, p->key[k]);                                  \
+        goto remove_right;                                                    \
+      } else if (l->num < r->num) {                                           \
+        /* Move the first element of the right leaf to the left one */        \
+        memcpy(&l->key[l->num], &r->key[0], sizeof(key_t));                   \
+        memcpy(&l->kind.value[l->num], &r->kind.value[0], sizeof(value_t));   \
+        l->num++;                                                             \
+        r->num--;                                                             \
+        memmove(&r->key[0], &r->key[1], sizeof(key_t) * (size_t) r->num);     \
+        memmove(&r->kind.value[0], &r->kind.value[1], sizeof(value_t) * (size_t) r->num); \
+      } else {                                                                \
+        /* Move the last element of the left leaf to the right one */         \
+        memmove(&r->key[1], &r->key[0], sizeof(key_t) * (size_t) r->num);     \
+        memmove(&r->kind.value[1], &r->kind.value[0], sizeof(value_t) * (size_t) r->num); \
+        l->num--;                                                             \
+        memcpy(&r->key[0], &l->key[l->num], sizeof(key_t));                   \
+        memcpy(&r->kind.value[0], &l->kind.value[l->num], sizeof(value_t));   \
+        r->num++;                                                             \
+      }                                                                       \
+      /* Update the separator */                                              \
+      M_CALL_SET(key_oplist, p->key[k], l->key[l->num-1]);                    \
+      return;                                                                 \
+    }                                                                         \
+    if (l->num + r->num + 1 <= N) {                                           \
+      /* Merge the separator & the right node into the left one */            \
+      memcpy(&l->key[l->num], &p->key[k], sizeof(key_t));                     \
+      memcpy(&l->key[l->num+1], &r->key[0], sizeof(key_t) * (size_t) r->num); \
+      memcpy(&l->kind.node[l->num+1], &r->kind.node[0], sizeof(node_t) * (size_t) (r->num+1)); \
+      l->num += r->num + 1;                                                   \
+      goto remove_right;                                                      \
+    } else if (l->num < r->num) {                                             \
+      /* Rotate left through the separator */                                 \
+      memcpy(&l->key[l->num], &p->key[k], sizeof(key_t));                     \
+      l->kind.node[l->num+1] = r->kind.node[0];                               \
+      l->num++;                                                               \
+      memcpy(&p->key[k], &r->key[0], sizeof(key_t));                          \
+      r->num--;                                                               \
+      memmove(&r->key[0], &r->key[1], sizeof(key_t) * (size_t) r->num);       \
+      memmove(&r->kind.node[0], &r->kind.node[1], sizeof(node_t) * (size_t) (r->num+1)); \
+    } else {                                                                  \
+      /* Rotate right through the separator */                                \
+      memmove(&r->key[1], &r->key[0], sizeof(key_t) * (size_t) r->num);       \
+      memmove(&r->kind.node[1], &r->kind.node[0], sizeof(node_t) * (size_t) (r->num+1)); \
+      memcpy(&r->key[0], &p->key[k], sizeof(key_t));                          \
+      r->kind.node[0] = l->kind.node[l->num];                                 \
+      r->num++;                                                               \
+      l->num--;                                                               \
+      memcpy(&p->key[k], &l->key[l->num], sizeof(key_t));                     \
+    }                                                                         \
+    return;                                                                   \
+  remove_right:                                                               \
+    /* The separator 'k' has already been cleared or moved */                 \
+    memmove(&p->key[k], &p->key[k+1], sizeof(key_t) * (size_t) (p->num-k-1)); \
+    memmove(&p->kind.node[k+1], &p->kind.node[k+2], sizeof(node_t) * (size_t) (p->num-k-1)); \
+    p->num--;                                                                 \
+    /* The elements of the right node have been moved: only free it */        \
+    M_CALL_DEL(key_oplist, r);                                                \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _erase)(tree_t b, key_t const key)                                \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    /* Don't copy the path if the key is not present */                       \
+    if (M_C(name, _cget)(b, key) == NULL) return false;                       \
+    node_t parent[M_PBPTR33_MAX_STACK];                                       \
+    int idx[M_PBPTR33_MAX_STACK];                                             \
+    int d;                                                                    \
+    node_t n = M_C(name, _unshare_path)(b, key, parent, idx, &d);             \
+    int i = M_C(name, _search_in_node)(n, key);                               \
+    M_ASSERT (i < n->num);                                                    \
+    M_CALL_CLEAR(key_oplist, n->key[i]);                                      \
+    M_CALL_CLEAR(value_oplist, n->kind.value[i]);                             \
+    memmove(&n->key[i], &n->key[i+1], sizeof(key_t) * (size_t) (n->num-i-1)); \
+    memmove(&n->kind.value[i], &n->kind.value[i+1], sizeof(value_t) * (size_t) (n->num-i-1)); \
+    n->num--;                                                                 \
+    b->size--;                                                                \
+    /* Rebalance the nodes of the path which underflow */                     \
+    while (d > 0 && n->num < (n->leaf ? N/2 : (N-1)/2)) {                     \
+      d--;                                                                    \
+      M_C(name, _fix_underflow)(parent[d], idx[d]);                           \
+      n = parent[d];                                                          \
+    }                                                                         \
+    n = b->root;                                                              \
+    if (n->num == 0) {                                                        \
+      /* The root is not shared as it is in the unshared path */              \
+      if (n->leaf) {                                                          \
+        b->root = NULL;                                                       \
+      } else {                                                                \
+        b->root = n->kind.node[0];                                            \
+      }                                                                       \
+      M_CALL_DEL(key_oplist, n);                                              \
+    }                                                                         \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    return true;                                                              \
+  }                                                                           \
+                                                                              \
+  /* Go down to the first leaf of the child of the node at the given depth */ \
+  static inline void                                                          \
+  M_C(name, _it_down)(it_t it, int d)                                         \
+  {                                                                           \
+    node_t n = it->node[d];                                                   \
+    while (!n->leaf) {                                                        \
+      n = n->kind.node[it->idx[d]];                                           \
+      d++;                                                                    \
+      M_ASSERT (d < M_PBPTR33_MAX_STACK);                                     \
+      it->node[d] = n;                                                        \
+      it->idx[d]  = 0;                                                        \
+    }                                                                         \
+    it->depth = d;                                                            \
+  }                                                                           \
+                                                                              \
+  /* Move the iterator to the first element of the next leaf */               \
+  static inline void                                                          \
+  M_C(name, _it_next_leaf)(it_t it)                                           \
+  {                                                                           \
+    int d = it->depth;                                                        \
+    while (d > 0) {                                                           \
+      d--;                                                                    \
+      if (it->idx[d] < it->node[d]->num) {                                    \
+        it->idx[d]++;                                                         \
+        M_C(name, _it_down)(it, d);                                           \
+        return;                                                               \
+      }                                                                       \
+    }                                                                         \
+    it->depth = -1;                                                           \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it)(it_t it, const tree_t b)                                     \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    M_ASSERT (it != NULL);                                                    \
+    if (b->root == NULL) {                                                    \
+      it->depth = -1;                                                         \
+      return;                                                                 \
+    }                                                                         \
+    it->node[0] = b->root;                                                    \
+    it->idx[0]  = 0;                                                          \
+    M_C(name, _it_down)(it, 0);                                               \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it_end)(it_t it, const tree_t b)                                 \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    M_ASSERT (it != NULL);                                                    \
+    it->depth = -1;                                                           \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it_set)(it_t itd, const it_t its)                                \
+  {                                                                           \
+    M_ASSERT (itd != NULL && its != NULL);                                    \
+    itd->depth = its->depth;                                                  \
+    for(int d = 0; d <= its->depth; d++) {                                    \
+      itd->node[d] = its->node[d];                                            \
+      itd->idx[d]  = its->idx[d];                                             \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _end_p)(const it_t it)                                            \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    return it->depth < 0;                                                     \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _it_equal_p)(const it_t it1, const it_t it2)                      \
+  {                                                                           \
+    M_ASSERT (it1 != NULL && it2 != NULL);                                    \
+    if (it1->depth < 0 || it2->depth < 0)                                     \
+      return it1->depth < 0 && it2->depth < 0;                                \
+    return it1->node[it1->depth] == it2->node[it2->depth]                     \
+      && it1->idx[it1->depth] == it2->idx[it2->depth];                        \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _next)(it_t it)                                                   \
+  {                                                                           \
+    M_ASSERT (it != NULL && it->depth >= 0);                                  \
+    const int d = it->depth;                                                  \
+    it->idx[d]++;                                                             \
+    if (it->idx[d] >= it->node[d]->num) {                                     \
+      M_C(name, _it_next_leaf)(it);                                           \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline itref_t const *                                               \
+  M_C(name, _cref)(it_t it)                                                   \
+  {                                                                           \
+    M_ASSERT (it != NULL && it->depth >= 0);                                  \
+    const node_t n = it->node[it->depth];                                     \
+    const int i = it->idx[it->depth];                                         \
+    M_ASSERT (n->leaf && i < n->num);                                         \
+    it->pair.key_ptr   = M_CONST_CAST(key_t, &n->key[i]);                     \
+    it->pair.value_ptr = M_CONST_CAST(value_t, &n->kind.value[i]);            \
+    return &it->pair;                                                         \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it_from)(it_t it, const tree_t b, key_t const key)               \
+  {                                                                           \
+    M_PBPTR33_CONTRACT(N, b);                                                 \
+    M_ASSERT (it != NULL);                                                    \
+    node_t n = b->root;                                                       \
+    if (n == NULL) {                                                          \
+      it->depth = -1;                                                         \
+      return;                                                                 \
+    }                                                                         \
+    int d = 0;                                                                \
+    while (true) {                                                            \
+      int i = M_C(name, _search_in_node)(n, key);                             \
+      it->node[d] = n;                                                        \
+      it->idx[d]  = i;                                                        \
+      if (n->leaf) break;                                                     \
+      n = n->kind.node[i];                                                    \
+      d++;                                                                    \
+      M_ASSERT (d < M_PBPTR33_MAX_STACK);                                     \
+    }                                                                         \
+    it->depth = d;                                                            \
+    if (it->idx[d] >= n->num) {                                               \
+      M_C(name, _it_next_leaf)(it);                                           \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _it_until_p)(const it_t it, key_t const key)                      \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    if (it->depth < 0) return true;                                           \
+    const node_t n = it->node[it->depth];                                     \
+    int cmp = M_CALL_CMP(key_oplist, n->key[it->idx[it->depth]], key);        \
+    return (cmp >= 0);                                                        \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _it_while_p)(const it_t it, key_t const key)                      \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    if (it->depth < 0) return false;                                          \
+    const node_t n = it->node[it->depth];                                     \
+    int cmp = M_CALL_CMP(key_oplist, n->key[it->idx[it->depth]], key);        \
+    return (cmp <= 0);                                                        \
+  }                                                                           \
+                                                                              \
+  M_IF_METHOD_BOTH(EQUAL, key_oplist, value_oplist)(                          \
+  static inline bool M_C(name,_equal_p)(const tree_t t1, const tree_t t2) {   \
+    M_PBPTR33_CONTRACT(N, t1);                                                \
+    M_PBPTR33_CONTRACT(N, t2);                                                \
+    if (t1->size != t2->size) return false;                                   \
+    /* Two versions sharing the same root are equal */                        \
+    if (t1->root == t2->root) return true;                                    \
+    it_t it1;                                                                 \
+    it_t it2;                                                                 \
+    M_C(name, _it)(it1, t1);                                                  \
+    M_C(name, _it)(it2, t2);                                                  \
+    while (!M_C(name, _end_p)(it1)                                            \
+           && !M_C(name, _end_p)(it2)) {                                      \
+      const itref_t *ref1 = M_C(name, _cref)(it1);                            \
+      const itref_t *ref2 = M_C(name, _cref)(it2);                            \
+      if (!M_CALL_EQUAL(key_oplist, *ref1->key_ptr, *ref2->key_ptr))          \
+        return false;                                                         \
+      if (!M_CALL_EQUAL(value_oplist, *ref1->value_ptr, *ref2->value_ptr))    \
+        return false;                                                         \
+      M_C(name, _next)(it1);                                                  \
+      M_C(name, _next)(it2);                                                  \
+    }                                                                         \
+    return M_C(name, _end_p)(it1)                                             \
+      && M_C(name, _end_p)(it2);                                              \
+  }                                                                           \
+  , /* NO EQUAL METHOD */ )                                                   \
+
+
+/********************************** INTERNAL ************************************/
+
+#if M_USE_SMALL_NAME
+#define P_BPTREE_DEF2 M_P_BPTREE_DEF2
+#define P_BPTREE_DEF2_AS M_P_BPTREE_DEF2_AS
+#define P_BPTREE_OPLIST2 M_P_BPTREE_OPLIST2
+#endif
+
+#endif
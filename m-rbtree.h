@@ -39,8 +39,28 @@
 #define M_RBTREE_DEF_AS(name, name_t, it_t, ...)                              \
   M_BEGIN_PROTECTED_CODE                                                      \
   M_RBTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                 \
-              ((name, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), name_t, M_C(name, _node_ct), it_t ), \
-               (name, __VA_ARGS__,                                        name_t, M_C(name, _node_ct), it_t ))) \
+              ((name, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 0, name_t, M_C(name, _node_ct), it_t ), \
+               (name, __VA_ARGS__,                                        0, name_t, M_C(name, _node_ct), it_t ))) \
+  M_END_PROTECTED_CODE
+
+
+/* Define a Red/Black binary tree of a given type,
+   keeping the number of elements of each sub-tree in its nodes
+   (order statistic: rank, select and count of a range in O(log n)).
+   USAGE: RBTREE_RANK_DEF(name, type [, oplist_of_the_type]) */
+#define M_RBTREE_RANK_DEF(name, ...)                                          \
+  M_RBTREE_RANK_DEF_AS(name, M_C(name,_t), M_C(name,_it_t), __VA_ARGS__)
+
+
+/* Define a Red/Black binary tree of a given type,
+   keeping the number of elements of each sub-tree in its nodes,
+   as the name name_t and the iterator it_t.
+   USAGE: RBTREE_RANK_DEF_AS(name, name_t, it_t, type [, oplist_of_the_type]) */
+#define M_RBTREE_RANK_DEF_AS(name, name_t, it_t, ...)                         \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_RBTR33_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                 \
+              ((name, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), 1, name_t, M_C(name, _node_ct), it_t ), \
+               (name, __VA_ARGS__,                                        1, name_t, M_C(name, _node_ct), it_t ))) \
   M_END_PROTECTED_CODE
 
 
@@ -121,6 +141,11 @@
  */
 #define M_RBTR33_MAX_STACK (2*CHAR_BIT*sizeof (size_t))
 
+/* Max number of levels of a parallel bulk operation split by the calling thread
+   and minimum black height of the sub-trees to split them further */
+#define M_RBTR33_PARALLEL_MAX_DEPTH  6
+#define M_RBTR33_PARALLEL_MIN_HEIGHT 8
+
 /* Encapsulation of the color of the nodes. */
 #define M_RBTR33_SET_RED(x)   ((x)->color =  M_RBTR33_RED)
 #define M_RBTR33_SET_BLACK(x) ((x)->color =  M_RBTR33_BLACK)
@@ -137,6 +162,17 @@ typedef enum {
   M_RBTR33_BLACK = 0, M_RBTR33_RED
 } m_rbtr33_color_e;
 
+// Kind of bulk operation between two Red/Black trees
+typedef enum {
+  M_RBTR33_UNION, M_RBTR33_INTERSECT, M_RBTR33_DIFFERENCE
+} m_rbtr33_setop_e;
+
+// State of a sub-operation of a parallel bulk operation
+typedef enum {
+  M_RBTR33_SETOP_NONE, M_RBTR33_SETOP_TODO,
+  M_RBTR33_SETOP_SPLIT, M_RBTR33_SETOP_DONE
+} m_rbtr33_setop_state_e;
+
 // General contact of a Read/Black tree
 #define M_RBTR33_CONTRACT(tree) do {                                          \
     M_ASSERT ((tree) != NULL);                                                \
@@ -153,17 +189,21 @@ typedef enum {
                && ((node)->child[1] == NULL || M_RBTR33_IS_BLACK(node->child[1])))); \
   } while (0)
 
+// Check that both trees use the same allocator (needed to move their nodes)
+#define M_RBTR33_SAME_ALLOCATOR(oplist, t1, t2)                               \
+  M_IF_METHOD(ALLOCATOR, oplist)(M_ASSERT ((t1)->allocator == (t2)->allocator), (void) 0)
+
 
 /* Deferred evaluation for the rbtree definition,
    so that all arguments are evaluated before further expansion */
 #define M_RBTR33_DEF_P1(arg) M_ID( M_RBTR33_DEF_P2 arg )
 
 /* Validate the oplist before going further */
-#define M_RBTR33_DEF_P2(name, type, oplist, tree_t, node_t, it_t)             \
-  M_IF_OPLIST(oplist)(M_RBTR33_DEF_P3, M_RBTR33_DEF_FAILURE)(name, type, oplist, tree_t, node_t, it_t)
+#define M_RBTR33_DEF_P2(name, type, oplist, isRank, tree_t, node_t, it_t)     \
+  M_IF_OPLIST(oplist)(M_RBTR33_DEF_P3, M_RBTR33_DEF_FAILURE)(name, type, oplist, isRank, tree_t, node_t, it_t)
 
 /* Stop processing with a compilation failure */
-#define M_RBTR33_DEF_FAILURE(name, type, oplist, tree_t, note_t, it_t)        \
+#define M_RBTR33_DEF_FAILURE(name, type, oplist, isRank, tree_t, note_t, it_t) \
   M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(RBTREE_DEF): the given argument is not a valid oplist: " #oplist)
 
 /* Internal rbtree definition
@@ -174,7 +214,7 @@ typedef enum {
    - it_t: alias for the iterator of the container
    - node_t: alias for the node of an element of the container
  */
-#define M_RBTR33_DEF_P3(name, type, oplist, tree_t, node_t, it_t)             \
+#define M_RBTR33_DEF_P3(name, type, oplist, isRank, tree_t, node_t, it_t)     \
                                                                               \
   /* Node of Red/Black tree.                                                  \
      Each node has up to two child, a color (Red or black)                    \
@@ -183,12 +223,14 @@ typedef enum {
     struct M_C(name, _node_s) *child[2];                                      \
     type data;                                                                \
     m_rbtr33_color_e color;                                                   \
+    M_IF(isRank)(size_t count; /* Number of elements of the sub-tree */,)     \
   } node_t;                                                                   \
                                                                               \
   /* Define the Red/Black tree */                                             \
   typedef struct M_C(name, _s) {                                              \
     size_t size;    /* Number of elements in the tree */                      \
     node_t *node;   /* Root node of the tree */                               \
+    M_ALL0CATOR_FIELD(oplist) /* Allocator (if ALLOCATOR method) */           \
   } tree_t[1];                                                                \
   typedef struct M_C(name, _s) *M_C(name, _ptr);                              \
   typedef const struct M_C(name, _s) *M_C(name, _srcptr);                     \
@@ -213,32 +255,54 @@ typedef enum {
     /* Definition of the global variable used to reference this pool */       \
     M_GET_MEMPOOL_LINKAGE oplist M_C(name, _mempool_t) M_GET_MEMPOOL oplist;  \
     /* Allocator function */                                                  \
-    static inline node_t *M_C3(m_rbtr33_,name,_new)(void) {                   \
+    static inline node_t *M_C3(m_rbtr33_,name,_new)(const tree_t tree) {      \
+      (void) tree; /* unused */                                               \
       return M_C(name, _mempool_alloc)(M_GET_MEMPOOL oplist);                 \
     }                                                                         \
     /* Deallocator function */                                                \
-    static inline void M_C3(m_rbtr33_,name,_del)(node_t *ptr) {               \
+    static inline void M_C3(m_rbtr33_,name,_del)(const tree_t tree, node_t *ptr) { \
+      (void) tree; /* unused */                                               \
       M_C(name, _mempool_free)(M_GET_MEMPOOL oplist, ptr);                    \
     }                                                                         \
                                                                               \
     , /* No mempool allocation */                                             \
     /* Callic allocator function (common case) */                             \
-    static inline node_t *M_C3(m_rbtr33_,name,_new)(void) {                   \
-      return M_CALL_NEW(oplist, node_t);                                      \
+    /* (through the allocator of the tree if ALLOCATOR is defined) */         \
+    static inline node_t *M_C3(m_rbtr33_,name,_new)(const tree_t tree) {      \
+      (void) tree; /* unused if no ALLOCATOR */                               \
+      return M_CALL_NEW_CTX(oplist, tree->allocator, node_t);                 \
     }                                                                         \
     /* Callic deallocator function (common case) */                           \
-    static inline void M_C3(m_rbtr33_,name,_del)(node_t *ptr) {               \
-      M_CALL_DEL(oplist, ptr);                                                \
+    static inline void M_C3(m_rbtr33_,name,_del)(const tree_t tree, node_t *ptr) { \
+      (void) tree; /* unused if no ALLOCATOR */                               \
+      M_CALL_DEL_CTX(oplist, tree->allocator, node_t, ptr);                   \
     }                                                                 )       \
                                                                               \
   /* Check if the given oplist is compatible with the given type */           \
   M_CHECK_COMPATIBLE_OPLIST(name, 1, type, oplist)                            \
                                                                               \
   /* Generate all functions */                                                \
-  M_RBTR33_DEF_P4(name, type, oplist, tree_t, node_t, it_t)
+  M_RBTR33_DEF_P4(name, type, oplist, isRank, tree_t, node_t, it_t)
 
 
-#define M_RBTR33_DEF_P4(name, type, oplist, tree_t, node_t, it_t)             \
+#define M_RBTR33_DEF_P4(name, type, oplist, isRank, tree_t, node_t, it_t)     \
+                                                                              \
+  M_IF(isRank)(                                                               \
+  /* Return the number of elements of the sub-tree of the node (or 0) */      \
+  static inline size_t                                                        \
+  M_C3(m_rbtr33_,name,_get_count)(const node_t *n)                            \
+  {                                                                           \
+    return (n == NULL) ? 0 : n->count;                                        \
+  }                                                                           \
+                                                                              \
+  /* Compute the number of elements of the sub-tree of the node */            \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_update_count)(node_t *n)                               \
+  {                                                                           \
+    n->count = 1 + M_C3(m_rbtr33_,name,_get_count)(n->child[0])               \
+      + M_C3(m_rbtr33_,name,_get_count)(n->child[1]);                         \
+  }                                                                           \
+  , /* No rank */)                                                            \
                                                                               \
   static inline void                                                          \
   M_C(name, _init)(tree_t tree)                                               \
@@ -246,9 +310,27 @@ typedef enum {
     M_ASSERT (tree != NULL);                                                  \
     tree->size = 0;                                                           \
     tree->node = NULL;                                                        \
+    M_IF_METHOD(ALLOCATOR, oplist)(tree->allocator = M_GET_ALLOCATOR oplist;, ) \
     M_RBTR33_CONTRACT(tree);                                                  \
   }                                                                           \
                                                                               \
+  M_IF_METHOD(ALLOCATOR, oplist)(                                             \
+  static inline void                                                          \
+  M_C(name, _init_allocator)(tree_t tree, const m_allocator_t *allocator)     \
+  {                                                                           \
+    M_ASSERT (allocator != NULL);                                             \
+    M_C(name, _init)(tree);                                                   \
+    tree->allocator = allocator;                                              \
+  }                                                                           \
+                                                                              \
+  static inline const m_allocator_t *                                         \
+  M_C(name, _allocator)(const tree_t tree)                                    \
+  {                                                                           \
+    M_ASSERT (tree != NULL);                                                  \
+    return tree->allocator;                                                   \
+  }                                                                           \
+  , /* No ALLOCATOR */ )                                                      \
+                                                                              \
   static inline void                                                          \
   M_C(name, _reset)(tree_t tree)                                              \
   {                                                                           \
@@ -284,7 +366,7 @@ typedef enum {
       M_ASSERT (n == stack[cpt - 1]);                                         \
       /* Clear the bottom left node */                                        \
       M_CALL_CLEAR(oplist, n->data);                                          \
-      M_C3(m_rbtr33_,name,_del) (n);                                          \
+      M_C3(m_rbtr33_,name,_del)(tree, n);                                     \
       M_ASSERT((stack[cpt-1] = NULL) == NULL);                                \
       /* Go up to the parent */                                               \
       cpt--;                                                                  \
@@ -311,7 +393,7 @@ typedef enum {
     node_t *n = tree->node;                                                   \
     /* If there is no root node, create a new node */                         \
     if (n == NULL) {                                                          \
-      n = M_C3(m_rbtr33_,name,_new)();                                        \
+      n = M_C3(m_rbtr33_,name,_new)(tree);                                    \
       if (M_UNLIKELY (n == NULL)) {                                           \
         M_MEMORY_FULL(sizeof (node_t));                                       \
         return;                                                               \
@@ -320,6 +402,7 @@ typedef enum {
       M_CALL_INIT_SET(oplist, n->data, data);                                 \
       /* Mark the root node as black */                                       \
       n->child[0] = n->child[1] = NULL;                                       \
+      M_IF(isRank)(n->count = 1;,)                                            \
       M_RBTR33_SET_BLACK (n);                                                 \
       tree->node = n;                                                         \
       M_ASSERT(tree->size == 0);                                              \
@@ -352,7 +435,7 @@ typedef enum {
       return;                                                                 \
     }                                                                         \
     /* Create new node to store the data */                                   \
-    n = M_C3(m_rbtr33_,name,_new)();                                          \
+    n = M_C3(m_rbtr33_,name,_new)(tree);                                      \
     if (M_UNLIKELY (n == NULL) ) {                                            \
       M_MEMORY_FULL (sizeof (node_t));                                        \
       return;                                                                 \
@@ -360,12 +443,17 @@ typedef enum {
     /* Copy the data and mark the node as red */                              \
     M_CALL_INIT_SET(oplist, n->data, data);                                   \
     n->child[0] = n->child[1] = NULL;                                         \
+    M_IF(isRank)(n->count = 1;,)                                              \
     M_RBTR33_SET_RED (n);                                                     \
     /* Add it in the iterator */                                              \
     M_ASSERT (tab[cpt] == NULL);                                              \
     tab[cpt] = n;                                                             \
     /* Add it in the tree */                                                  \
     tree->size ++;                                                            \
+    /* All the parents of the node have one more element */                   \
+    M_IF(isRank)(for(unsigned int k = 0; k < cpt; k++) {                      \
+        tab[k]->count ++;                                                     \
+      },)                                                                     \
     M_ASSERT(tab[cpt-1]->child[0+which[cpt-1]] == NULL);                      \
     tab[cpt-1]->child[0+which[cpt-1]] = n;                                    \
     /* Fix the tree to still respect the red/back properties */               \
@@ -400,6 +488,8 @@ typedef enum {
       pp->child[i] = p->child[j];                                             \
       p->child[i] = x;                                                        \
       p->child[j] = pp;                                                       \
+      M_IF(isRank)(M_C3(m_rbtr33_,name,_update_count)(pp);                    \
+                   M_C3(m_rbtr33_,name,_update_count)(p);,)                   \
       M_RBTR33_SET_BLACK(p);                                                  \
       M_RBTR33_SET_RED(pp);                                                   \
     } else {                                                                  \
@@ -411,6 +501,9 @@ typedef enum {
       p->child[j]  = x->child[i];                                             \
       x->child[i]  = p;                                                       \
       x->child[j]  = pp;                                                      \
+      M_IF(isRank)(M_C3(m_rbtr33_,name,_update_count)(p);                     \
+                   M_C3(m_rbtr33_,name,_update_count)(pp);                    \
+                   M_C3(m_rbtr33_,name,_update_count)(x);,)                   \
       M_RBTR33_SET_BLACK(x);                                                  \
       M_RBTR33_SET_RED(p);                                                    \
       M_RBTR33_SET_RED(pp);                                                   \
@@ -614,6 +707,64 @@ typedef enum {
     return (cmp <= 0);                                                        \
   }                                                                           \
                                                                               \
+  M_IF(isRank)(                                                               \
+  /* Return the number of elements of the tree strictly lower than 'data' */  \
+  static inline size_t                                                        \
+  M_C(name, _rank)(const tree_t tree, type const data)                        \
+  {                                                                           \
+    M_RBTR33_CONTRACT (tree);                                                 \
+    size_t rank = 0;                                                          \
+    node_t *n = tree->node;                                                   \
+    /* Go down the tree, counting the elements on the left */                 \
+    while (n != NULL) {                                                       \
+      M_RBTR33_CONTRACT_NODE (n);                                             \
+      int cmp = M_CALL_CMP(oplist, n->data, data);                            \
+      if (cmp < 0) {                                                          \
+        rank += 1 + M_C3(m_rbtr33_,name,_get_count)(n->child[0]);             \
+      }                                                                       \
+      n = n->child[cmp < 0];                                                  \
+    }                                                                         \
+    return rank;                                                              \
+  }                                                                           \
+                                                                              \
+  /* Set the iterator to the element of rank 'k' (starting from 0)            \
+     or to the end if there is not enough elements */                         \
+  static inline void                                                          \
+  M_C(name, _select)(it_t it, const tree_t tree, size_t k)                    \
+  {                                                                           \
+    M_RBTR33_CONTRACT (tree);                                                 \
+    M_ASSERT (it != NULL);                                                    \
+    unsigned int cpt = 0;                                                     \
+    node_t *n = tree->node;                                                   \
+    if (k < tree->size) {                                                     \
+      /* Go down the tree and fill in the iterator */                         \
+      while (true) {                                                          \
+        M_ASSERT (n != NULL && cpt < M_RBTR33_MAX_STACK);                     \
+        size_t left = M_C3(m_rbtr33_,name,_get_count)(n->child[0]);           \
+        it->stack[cpt] = n;                                                   \
+        if (k == left) {                                                      \
+          it->which[cpt++] = 0;                                               \
+          break;                                                              \
+        }                                                                     \
+        int child = (k > left);                                               \
+        it->which[cpt++] = (int8_t) child;                                    \
+        if (child) k -= left + 1;                                             \
+        n = n->child[child];                                                  \
+      }                                                                       \
+    }                                                                         \
+    it->cpt = cpt;                                                            \
+  }                                                                           \
+                                                                              \
+  /* Return the number of elements in [lo, hi[ */                             \
+  static inline size_t                                                        \
+  M_C(name, _count_range)(const tree_t tree, type const lo, type const hi)    \
+  {                                                                           \
+    size_t rank_lo = M_C(name, _rank)(tree, lo);                              \
+    size_t rank_hi = M_C(name, _rank)(tree, hi);                              \
+    return rank_hi > rank_lo ? rank_hi - rank_lo : 0;                         \
+  }                                                                           \
+  , /* No rank */)                                                            \
+                                                                              \
   static inline type *                                                        \
   M_C(name, _min)(const tree_t tree)                                          \
   {                                                                           \
@@ -679,17 +830,18 @@ typedef enum {
                                                                               \
   /* Create a copy of the given node (recursively) */                         \
   static inline node_t *                                                      \
-  M_C3(m_rbtr33_,name,_copy_node)(const node_t *o)                            \
+  M_C3(m_rbtr33_,name,_copy_node)(const tree_t tree, const node_t *o)         \
   {                                                                           \
     if (o == NULL) return NULL;                                               \
-    node_t *n = M_C3(m_rbtr33_,name,_new)();                                  \
+    node_t *n = M_C3(m_rbtr33_,name,_new)(tree);                              \
     if (M_UNLIKELY (n == NULL) ) {                                            \
       M_MEMORY_FULL (sizeof (node_t));                                        \
       return NULL;                                                            \
     }                                                                         \
     M_CALL_INIT_SET(oplist, n->data, o->data);                                \
-    n->child[0] = M_C3(m_rbtr33_,name,_copy_node)(o->child[0]);               \
-    n->child[1] = M_C3(m_rbtr33_,name,_copy_node)(o->child[1]);               \
+    M_IF(isRank)(n->count = o->count;,)                                       \
+    n->child[0] = M_C3(m_rbtr33_,name,_copy_node)(tree, o->child[0]);         \
+    n->child[1] = M_C3(m_rbtr33_,name,_copy_node)(tree, o->child[1]);         \
     M_RBTR33_COPY_COLOR (n, o);                                               \
     return n;                                                                 \
   }                                                                           \
@@ -699,9 +851,10 @@ typedef enum {
   {                                                                           \
     M_RBTR33_CONTRACT (ref);                                                  \
     M_ASSERT (tree != NULL && tree != ref);                                   \
+    M_IF_METHOD(ALLOCATOR, oplist)(tree->allocator = ref->allocator;, )       \
     tree->size = ref->size;                                                   \
     /* Copy the root node recursively */                                      \
-    tree->node = M_C3(m_rbtr33_,name,_copy_node)(ref->node);                  \
+    tree->node = M_C3(m_rbtr33_,name,_copy_node)(tree, ref->node);            \
     M_RBTR33_CONTRACT (tree);                                                 \
   }                                                                           \
                                                                               \
@@ -712,7 +865,10 @@ typedef enum {
     M_RBTR33_CONTRACT (ref);                                                  \
     if (tree == ref) return;                                                  \
     M_C(name,_clear)(tree);                                                   \
-    M_C(name,_init_set)(tree, ref);                                           \
+    /* Keep the allocator of the tree */                                      \
+    tree->size = ref->size;                                                   \
+    tree->node = M_C3(m_rbtr33_,name,_copy_node)(tree, ref->node);            \
+    M_RBTR33_CONTRACT (tree);                                                 \
   }                                                                           \
                                                                               \
   static inline void                                                          \
@@ -722,6 +878,7 @@ typedef enum {
     M_ASSERT (tree != NULL && tree != ref);                                   \
     tree->size = ref->size;                                                   \
     tree->node = ref->node;                                                   \
+    M_IF_METHOD(ALLOCATOR, oplist)(tree->allocator = ref->allocator;, )       \
     ref->node = NULL;                                                         \
     ref->size = 0;                                                            \
     M_RBTR33_CONTRACT (tree);                                                 \
@@ -745,6 +902,7 @@ typedef enum {
     M_RBTR33_CONTRACT (tree2);                                                \
     M_SWAP(size_t, tree1->size, tree2->size);                                 \
     M_SWAP(node_t *, tree1->node, tree2->node);                               \
+    M_IF_METHOD(ALLOCATOR, oplist)(M_SWAP(const m_allocator_t *, tree1->allocator, tree2->allocator);, ) \
     M_RBTR33_CONTRACT (tree1);                                                \
     M_RBTR33_CONTRACT (tree2);                                                \
   }                                                                           \
@@ -781,6 +939,8 @@ typedef enum {
     /* Fix grandparent with new parent */                                     \
     M_ASSERT(ppp->child[0] == pp || ppp->child[1] == pp);                     \
     ppp->child[(ppp->child[0] != pp)] = p;                                    \
+    M_IF(isRank)(M_C3(m_rbtr33_,name,_update_count)(pp);                      \
+                 M_C3(m_rbtr33_,name,_update_count)(p);,)                     \
     return p;                                                                 \
   }                                                                           \
                                                                               \
@@ -875,6 +1035,10 @@ typedef enum {
       tab[cpt_n-1]->child[which[cpt_n-1]] = u;                                \
       /* in all cases, this node shall be set to black */                     \
     }                                                                         \
+    /* All the nodes above the removed one have one less element */           \
+    M_IF(isRank)(for(unsigned int k = cpt; k-- > 1; ) {                       \
+        M_C3(m_rbtr33_,name,_update_count)(tab[k]);                           \
+      },)                                                                     \
                                                                               \
     /* Rebalance from child to root */                                        \
     if (v_color == M_RBTR33_BLACK                                             \
@@ -949,7 +1113,7 @@ typedef enum {
       M_DO_MOVE(oplist, *data_ptr, n->data);                                  \
     else                                                                      \
       M_CALL_CLEAR(oplist, n->data);                                          \
-    M_C3(m_rbtr33_,name,_del) (n);                                            \
+    M_C3(m_rbtr33_,name,_del)(tree, n);                                       \
     tree->size --;                                                            \
     M_RBTR33_CONTRACT (tree);                                                 \
     return true;                                                              \
@@ -969,6 +1133,8 @@ typedef enum {
     M_CALL_CLEAR(oplist, data);                                               \
   }                                                                           \
                                                                               \
+  M_RBTR33_DEF_BULK(name, type, oplist, isRank, tree_t, node_t, it_t)         \
+                                                                              \
   M_IF_METHOD(EQUAL, oplist)(                                                 \
   static inline bool M_C(name,_equal_p)(const tree_t t1, const tree_t t2) {   \
     M_RBTR33_CONTRACT(t1);                                                    \
@@ -1164,7 +1330,560 @@ typedef enum {
   }                                                                           \
   , /* no in_serial */ )                                                      \
                                                                               \
-  M_EMPLACE_QUEUE_DEF(name, tree_t, M_C(name, _emplace), oplist, M_RBTR33_EMPLACE_DEF)
+  M_EMPLACE_QUEUE_DEF(name, tree_t, M_C(name, _emplace), oplist, M_RBTR33_EMPLACE_DEF) \
+                                                                              \
+  /* A memory pool cannot be shared by several threads,                       \
+     nor a stateful allocator (which may not be thread safe) */               \
+  M_IF(M_OR(M_TEST_METHOD_P(MEMPOOL, oplist), M_TEST_METHOD_P(ALLOCATOR, oplist))) \
+  (M_EAT, M_RBTR33_DEF_PARALLEL_P)                                            \
+  (name, type, oplist, isRank, tree_t, node_t, it_t)
+
+
+/* Definition of the split / join based bulk operations.
+   They work on sub-trees given with their black height (the number of
+   black nodes of any path from the root of the sub-tree to a leaf)
+   so that it is never recomputed. The root of a sub-tree may be red.
+   The nodes are moved from one tree to the other: they are never
+   reallocated nor copied. */
+#define M_RBTR33_DEF_BULK(name, type, oplist, isRank, tree_t, node_t, it_t)   \
+                                                                              \
+  /* Compute the number of elements of the node if needed */                  \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_recount)(node_t *n)                                    \
+  {                                                                           \
+    M_IF(isRank)(M_C3(m_rbtr33_,name,_update_count)(n);, (void) n;)           \
+  }                                                                           \
+                                                                              \
+  /* Return the black height of the sub-tree */                               \
+  static inline unsigned int                                                  \
+  M_C3(m_rbtr33_,name,_black_height)(const node_t *n)                         \
+  {                                                                           \
+    unsigned int h = 0;                                                       \
+    for( ; n != NULL; n = n->child[0])                                        \
+      h += M_RBTR33_IS_BLACK(n) ? 1U : 0U;                                    \
+    return h;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Return the black height of the childs of the node of black height h */   \
+  static inline unsigned int                                                  \
+  M_C3(m_rbtr33_,name,_child_height)(const node_t *n, unsigned int h)         \
+  {                                                                           \
+    M_ASSERT (n != NULL);                                                     \
+    M_ASSERT (h >= (M_RBTR33_IS_BLACK(n) ? 1U : 0U));                         \
+    return h - (M_RBTR33_IS_BLACK(n) ? 1U : 0U);                              \
+  }                                                                           \
+                                                                              \
+  /* Clear and free all the nodes of the sub-tree */                          \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_free_node)(const tree_t tree, node_t *n)               \
+  {                                                                           \
+    while (n != NULL) {                                                       \
+      node_t *next = n->child[1];                                             \
+      M_C3(m_rbtr33_,name,_free_node)(tree, n->child[0]);                     \
+      M_CALL_CLEAR(oplist, n->data);                                          \
+      M_C3(m_rbtr33_,name,_del)(tree, n);                                     \
+      n = next;                                                               \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Join the sub-tree 'b' of black height 'hb' with the sub-tree 's' of      \
+     lower black height 'hs' through the node 'k', going down the 'side'      \
+     spine of 'b' (1 if 'b' is on the left of 's', 0 otherwise).              \
+     The returned root may be red with a red child: it is up to the caller    \
+     to fix it */                                                             \
+  static inline node_t *                                                      \
+  M_C3(m_rbtr33_,name,_join_side)(node_t *b, unsigned int hb, node_t *k,      \
+                                  node_t *s, unsigned int hs, int side)       \
+  {                                                                           \
+    if (M_C3(m_rbtr33_,name,_black_p)(b) && hb == hs) {                       \
+      /* Same black height: 'k' becomes the red parent of both sub-trees */   \
+      k->child[1-side] = b;                                                   \
+      k->child[side]   = s;                                                   \
+      M_RBTR33_SET_RED(k);                                                    \
+      M_C3(m_rbtr33_,name,_recount)(k);                                       \
+      return k;                                                               \
+    }                                                                         \
+    M_ASSERT (b != NULL && hb >= hs);                                         \
+    node_t *c = M_C3(m_rbtr33_,name,_join_side)(b->child[side],               \
+                   M_C3(m_rbtr33_,name,_child_height)(b, hb), k, s, hs, side); \
+    b->child[side] = c;                                                       \
+    if (M_RBTR33_IS_BLACK(b) && M_RBTR33_IS_RED(c)                            \
+        && !M_C3(m_rbtr33_,name,_black_p)(c->child[side])) {                  \
+      /* Two red nodes in a row: rotate them around 'b' */                    \
+      M_RBTR33_SET_BLACK(c->child[side]);                                     \
+      b->child[side] = c->child[1-side];                                      \
+      c->child[1-side] = b;                                                   \
+      M_C3(m_rbtr33_,name,_recount)(b);                                       \
+      M_C3(m_rbtr33_,name,_recount)(c);                                       \
+      return c;                                                               \
+    }                                                                         \
+    M_C3(m_rbtr33_,name,_recount)(b);                                         \
+    return b;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Join the sub-trees 'l' and 'r' of black height 'hl' and 'hr'             \
+     through the node 'k' so that all elements of 'l' < 'k' < all             \
+     elements of 'r'. Return the new sub-tree (with a black root)             \
+     and its black height in 'h' */                                           \
+  static inline node_t *                                                      \
+  M_C3(m_rbtr33_,name,_join_node)(node_t *l, unsigned int hl, node_t *k,      \
+                                  node_t *r, unsigned int hr, unsigned int *h) \
+  {                                                                           \
+    node_t *t;                                                                \
+    M_ASSERT (k != NULL && h != NULL);                                        \
+    if (l != NULL && M_RBTR33_IS_RED(l)) {                                    \
+      M_RBTR33_SET_BLACK(l);                                                  \
+      hl++;                                                                   \
+    }                                                                         \
+    if (r != NULL && M_RBTR33_IS_RED(r)) {                                    \
+      M_RBTR33_SET_BLACK(r);                                                  \
+      hr++;                                                                   \
+    }                                                                         \
+    if (hl >= hr) {                                                           \
+      t = M_C3(m_rbtr33_,name,_join_side)(l, hl, k, r, hr, 1);                \
+    } else {                                                                  \
+      t = M_C3(m_rbtr33_,name,_join_side)(r, hr, k, l, hl, 0);                \
+    }                                                                         \
+    *h = M_MAX(hl, hr);                                                       \
+    if (M_RBTR33_IS_RED(t)) {                                                 \
+      M_RBTR33_SET_BLACK(t);                                                  \
+      (*h)++;                                                                 \
+    }                                                                         \
+    return t;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Remove the greatest node of the non empty sub-tree 'n' of black          \
+     height 'hn' and return it in 'last'. Return the remaining sub-tree       \
+     and its black height in 'h' */                                           \
+  static inline node_t *                                                      \
+  M_C3(m_rbtr33_,name,_split_last)(node_t *n, unsigned int hn,                \
+                                   node_t **last, unsigned int *h)            \
+  {                                                                           \
+    unsigned int hc = M_C3(m_rbtr33_,name,_child_height)(n, hn);              \
+    if (n->child[1] == NULL) {                                                \
+      *last = n;                                                              \
+      *h = hc;                                                                \
+      return n->child[0];                                                     \
+    }                                                                         \
+    unsigned int hr;                                                          \
+    node_t *r = M_C3(m_rbtr33_,name,_split_last)(n->child[1], hc, last, &hr); \
+    return M_C3(m_rbtr33_,name,_join_node)(n->child[0], hc, n, r, hr, h);     \
+  }                                                                           \
+                                                                              \
+  /* Join the sub-trees 'l' and 'r' (all elements of 'l' < all elements       \
+     of 'r') without any middle node */                                       \
+  static inline node_t *                                                      \
+  M_C3(m_rbtr33_,name,_join2)(node_t *l, unsigned int hl,                     \
+                              node_t *r, unsigned int hr, unsigned int *h)    \
+  {                                                                           \
+    if (l == NULL) {                                                          \
+      *h = hr;                                                                \
+      return r;                                                               \
+    }                                                                         \
+    node_t *k;                                                                \
+    l = M_C3(m_rbtr33_,name,_split_last)(l, hl, &k, &hl);                     \
+    return M_C3(m_rbtr33_,name,_join_node)(l, hl, k, r, hr, h);               \
+  }                                                                           \
+                                                                              \
+  /* Split the sub-tree 'n' of black height 'hn' into the sub-tree 'l'        \
+     of the elements lower than 'key' and the sub-tree 'r' of the elements    \
+     greater than 'key'. Return the node equal to 'key' or NULL */            \
+  static inline node_t *                                                      \
+  M_C3(m_rbtr33_,name,_split_node)(node_t *n, unsigned int hn, type const key, \
+                                   node_t **l, unsigned int *hl,              \
+                                   node_t **r, unsigned int *hr)              \
+  {                                                                           \
+    if (n == NULL) {                                                          \
+      *l = *r = NULL;                                                         \
+      *hl = *hr = 0;                                                          \
+      return NULL;                                                            \
+    }                                                                         \
+    M_RBTR33_CONTRACT_NODE (n);                                               \
+    unsigned int hc = M_C3(m_rbtr33_,name,_child_height)(n, hn);              \
+    unsigned int hsub;                                                        \
+    node_t *found, *sub;                                                      \
+    int cmp = M_CALL_CMP(oplist, n->data, key);                               \
+    if (cmp == 0) {                                                           \
+      *l = n->child[0];                                                       \
+      *hl = hc;                                                               \
+      *r = n->child[1];                                                       \
+      *hr = hc;                                                               \
+      return n;                                                               \
+    } else if (cmp > 0) {                                                     \
+      found = M_C3(m_rbtr33_,name,_split_node)(n->child[0], hc, key, l, hl, &sub, &hsub); \
+      *r = M_C3(m_rbtr33_,name,_join_node)(sub, hsub, n, n->child[1], hc, hr); \
+    } else {                                                                  \
+      found = M_C3(m_rbtr33_,name,_split_node)(n->child[1], hc, key, &sub, &hsub, r, hr); \
+      *l = M_C3(m_rbtr33_,name,_join_node)(n->child[0], hc, n, sub, hsub, hl); \
+    }                                                                         \
+    return found;                                                             \
+  }                                                                           \
+                                                                              \
+  /* Return the number of elements of the tree 'l' knowing that the trees     \
+     'l' and 'r' have 'total' elements together (only used without the rank   \
+     augmentation). Both trees are scanned in lockstep so that the cost is    \
+     linear in the size of the smallest one */                                \
+  static inline size_t                                                        \
+  M_C3(m_rbtr33_,name,_count_left)(node_t *l, node_t *r, size_t total)        \
+  {                                                                           \
+    tree_t tl, tr;                                                            \
+    it_t il, ir;                                                              \
+    size_t n = 0;                                                             \
+    tl->node = l;                                                             \
+    tl->size = total;                                                         \
+    tr->node = r;                                                             \
+    tr->size = total;                                                         \
+    for(M_C(name, _it)(il, tl), M_C(name, _it)(ir, tr);                       \
+        !M_C(name, _end_p)(il) && !M_C(name, _end_p)(ir);                     \
+        M_C(name, _next)(il), M_C(name, _next)(ir)) {                         \
+      n++;                                                                    \
+    }                                                                         \
+    return M_C(name, _end_p)(il) ? n : total - n;                             \
+  }                                                                           \
+                                                                              \
+  /* Split 'tree' into the elements lower than 'key' (moved into 'left')      \
+     and the other ones (moved into 'right'). 'tree' is emptied.              \
+     The split is in O(log n), but without the rank augmentation              \
+     the size of 'left' is counted by a scan of the trees, which is linear:   \
+     O(min(size(left), size(right))) */                                       \
+  static inline void                                                          \
+  M_C(name, _split)(tree_t tree, type const key, tree_t left, tree_t right)   \
+  {                                                                           \
+    M_RBTR33_CONTRACT (tree);                                                 \
+    M_ASSERT (tree != left && tree != right && left != right);                \
+    M_RBTR33_SAME_ALLOCATOR (oplist, tree, left);                             \
+    M_RBTR33_SAME_ALLOCATOR (oplist, tree, right);                            \
+    M_C(name, _reset)(left);                                                  \
+    M_C(name, _reset)(right);                                                 \
+    node_t *l, *r;                                                            \
+    unsigned int hl, hr;                                                      \
+    node_t *found = M_C3(m_rbtr33_,name,_split_node)(tree->node,              \
+                       M_C3(m_rbtr33_,name,_black_height)(tree->node),        \
+                       key, &l, &hl, &r, &hr);                                \
+    if (found != NULL) {                                                      \
+      /* The element equal to the key is the minimum of the right part */     \
+      r = M_C3(m_rbtr33_,name,_join_node)(NULL, 0, found, r, hr, &hr);        \
+    }                                                                         \
+    M_C3(m_rbtr33_,name,_set_black)(l);                                       \
+    M_C3(m_rbtr33_,name,_set_black)(r);                                       \
+    left->node  = l;                                                          \
+    right->node = r;                                                          \
+    left->size  = M_IF(isRank)(M_C3(m_rbtr33_,name,_get_count)(l),            \
+                               M_C3(m_rbtr33_,name,_count_left)(l, r, tree->size)); \
+    right->size = tree->size - left->size;                                    \
+    tree->node  = NULL;                                                       \
+    tree->size  = 0;                                                          \
+    M_RBTR33_CONTRACT (left);                                                 \
+    M_RBTR33_CONTRACT (right);                                                \
+  }                                                                           \
+                                                                              \
+  /* Join the trees 'left' and 'right' with the element 'key' into 'left'.    \
+     All elements of 'left' shall be lower than 'key' and all elements        \
+     of 'right' shall be greater than 'key'. 'right' is emptied */            \
+  static inline void                                                          \
+  M_C(name, _join)(tree_t left, type const key, tree_t right)                 \
+  {                                                                           \
+    M_RBTR33_CONTRACT (left);                                                 \
+    M_RBTR33_CONTRACT (right);                                                \
+    M_ASSERT (left != right);                                                 \
+    M_RBTR33_SAME_ALLOCATOR (oplist, left, right);                            \
+    M_ASSERT (left->node == NULL                                              \
+              || M_CALL_CMP(oplist, *M_C(name, _max)(left), key) < 0);        \
+    M_ASSERT (right->node == NULL                                             \
+              || M_CALL_CMP(oplist, *M_C(name, _min)(right), key) > 0);       \
+    node_t *k = M_C3(m_rbtr33_,name,_new)(left);                              \
+    if (M_UNLIKELY (k == NULL)) {                                             \
+      M_MEMORY_FULL(sizeof (node_t));                                         \
+      return;                                                                 \
+    }                                                                         \
+    M_CALL_INIT_SET(oplist, k->data, key);                                    \
+    unsigned int h;                                                           \
+    left->node = M_C3(m_rbtr33_,name,_join_node)(left->node,                  \
+                    M_C3(m_rbtr33_,name,_black_height)(left->node), k,        \
+                    right->node, M_C3(m_rbtr33_,name,_black_height)(right->node), &h); \
+    left->size += right->size + 1;                                            \
+    right->node = NULL;                                                       \
+    right->size = 0;                                                          \
+    M_RBTR33_CONTRACT (left);                                                 \
+  }                                                                           \
+                                                                              \
+  /* Bulk operation between the sub-tree 'a' of the destination               \
+     and the sub-tree 'b' of the source */                                    \
+  typedef struct M_C3(m_rbtr33_,name,_setop_s) {                              \
+    node_t *a, *b;                 /* Input sub-trees */                      \
+    unsigned int ha, hb;           /* Their black heights */                  \
+    node_t *r;                     /* Result sub-tree */                      \
+    unsigned int hr;               /* Its black height */                     \
+    size_t count;                  /* Number of elements common to both */    \
+    node_t *pivot, *found;         /* Exposed node and its equal node */      \
+    m_rbtr33_setop_e op;           /* Operation to perform */                 \
+    m_rbtr33_setop_state_e state;  /* State of the parallel operation */      \
+    const struct M_C(name, _s) *tree; /* Destination tree (allocator) */      \
+  } M_C3(m_rbtr33_,name,_setop_ct);                                           \
+                                                                              \
+  /* If one of the sub-trees is empty, compute the operation and return false. \
+     Otherwise expose the root of one sub-tree, split the other one with it,  \
+     fill in both sub-operations and return true */                           \
+  static inline bool                                                          \
+  M_C3(m_rbtr33_,name,_setop_expose)(M_C3(m_rbtr33_,name,_setop_ct) *t,       \
+                                     M_C3(m_rbtr33_,name,_setop_ct) *left,    \
+                                     M_C3(m_rbtr33_,name,_setop_ct) *right)   \
+  {                                                                           \
+    t->count = 0;                                                             \
+    if (t->a == NULL || t->b == NULL) {                                       \
+      if (t->op == M_RBTR33_UNION && t->a == NULL) {                          \
+        t->r  = t->b;                                                         \
+        t->hr = t->hb;                                                        \
+      } else if (t->op == M_RBTR33_INTERSECT) {                               \
+        M_C3(m_rbtr33_,name,_free_node)(t->tree, t->a);                       \
+        M_C3(m_rbtr33_,name,_free_node)(t->tree, t->b);                       \
+        t->r  = NULL;                                                         \
+        t->hr = 0;                                                            \
+      } else {                                                                \
+        M_C3(m_rbtr33_,name,_free_node)(t->tree, t->b);                       \
+        t->r  = t->a;                                                         \
+        t->hr = t->ha;                                                        \
+      }                                                                       \
+      return false;                                                           \
+    }                                                                         \
+    /* The intersection keeps the nodes of the destination,                   \
+       the other operations keep the nodes of the source */                   \
+    const bool pivot_a = (t->op == M_RBTR33_INTERSECT);                       \
+    node_t *p = pivot_a ? t->a : t->b;                                        \
+    unsigned int hp = M_C3(m_rbtr33_,name,_child_height)(p, pivot_a ? t->ha : t->hb); \
+    node_t *l, *r;                                                            \
+    unsigned int hl, hr;                                                      \
+    t->pivot = p;                                                             \
+    t->found = M_C3(m_rbtr33_,name,_split_node)(pivot_a ? t->b : t->a,        \
+                                                pivot_a ? t->hb : t->ha,      \
+                                                p->data, &l, &hl, &r, &hr);   \
+    left->op = right->op = t->op;                                             \
+    left->tree = right->tree = t->tree;                                       \
+    if (pivot_a) {                                                            \
+      left->a  = p->child[0];                                                 \
+      left->ha = hp;                                                          \
+      left->b  = l;                                                           \
+      left->hb = hl;                                                          \
+      right->a  = p->child[1];                                                \
+      right->ha = hp;                                                         \
+      right->b  = r;                                                          \
+      right->hb = hr;                                                         \
+    } else {                                                                  \
+      left->a  = l;                                                           \
+      left->ha = hl;                                                          \
+      left->b  = p->child[0];                                                 \
+      left->hb = hp;                                                          \
+      right->a  = r;                                                          \
+      right->ha = hr;                                                         \
+      right->b  = p->child[1];                                                \
+      right->hb = hp;                                                         \
+    }                                                                         \
+    return true;                                                              \
+  }                                                                           \
+                                                                              \
+  /* Join the results of both sub-operations with the exposed node */         \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_setop_combine)(M_C3(m_rbtr33_,name,_setop_ct) *t,      \
+                                      const M_C3(m_rbtr33_,name,_setop_ct) *left, \
+                                      const M_C3(m_rbtr33_,name,_setop_ct) *right) \
+  {                                                                           \
+    node_t *p = t->pivot, *f = t->found;                                      \
+    t->count = left->count + right->count + (f != NULL);                      \
+    if (f != NULL) {                                                          \
+      /* The equal node of the split sub-tree is always removed */            \
+      M_CALL_CLEAR(oplist, f->data);                                          \
+      M_C3(m_rbtr33_,name,_del)(t->tree, f);                                  \
+    }                                                                         \
+    if (t->op == M_RBTR33_UNION || (t->op == M_RBTR33_INTERSECT && f != NULL)) { \
+      t->r = M_C3(m_rbtr33_,name,_join_node)(left->r, left->hr, p,            \
+                                             right->r, right->hr, &t->hr);    \
+    } else {                                                                  \
+      M_CALL_CLEAR(oplist, p->data);                                          \
+      M_C3(m_rbtr33_,name,_del)(t->tree, p);                                  \
+      t->r = M_C3(m_rbtr33_,name,_join2)(left->r, left->hr,                   \
+                                         right->r, right->hr, &t->hr);        \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Perform sequentially the bulk operation */                               \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_setop)(M_C3(m_rbtr33_,name,_setop_ct) *t)              \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop_ct) left, right;                               \
+    if (M_C3(m_rbtr33_,name,_setop_expose)(t, &left, &right)) {               \
+      M_C3(m_rbtr33_,name,_setop)(&left);                                     \
+      M_C3(m_rbtr33_,name,_setop)(&right);                                    \
+      M_C3(m_rbtr33_,name,_setop_combine)(t, &left, &right);                  \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Initialize the bulk operation between 'dst' and 'src' */                 \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_setop_init)(M_C3(m_rbtr33_,name,_setop_ct) *t,         \
+                                   m_rbtr33_setop_e op, tree_t dst, tree_t src) \
+  {                                                                           \
+    M_RBTR33_CONTRACT (dst);                                                  \
+    M_RBTR33_CONTRACT (src);                                                  \
+    M_ASSERT (dst != src);                                                    \
+    M_RBTR33_SAME_ALLOCATOR (oplist, dst, src);                               \
+    t->op = op;                                                               \
+    t->tree = dst;                                                            \
+    t->a  = dst->node;                                                        \
+    t->ha = M_C3(m_rbtr33_,name,_black_height)(dst->node);                    \
+    t->b  = src->node;                                                        \
+    t->hb = M_C3(m_rbtr33_,name,_black_height)(src->node);                    \
+  }                                                                           \
+                                                                              \
+  /* Set the result of the bulk operation in 'dst' and empty 'src' */         \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_setop_done)(M_C3(m_rbtr33_,name,_setop_ct) *t,         \
+                                   tree_t dst, tree_t src)                    \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_set_black)(t->r);                                    \
+    dst->node = t->r;                                                         \
+    if (t->op == M_RBTR33_UNION) {                                            \
+      dst->size = dst->size + src->size - t->count;                           \
+    } else if (t->op == M_RBTR33_INTERSECT) {                                 \
+      dst->size = t->count;                                                   \
+    } else {                                                                  \
+      dst->size -= t->count;                                                  \
+    }                                                                         \
+    src->node = NULL;                                                         \
+    src->size = 0;                                                            \
+    M_IF(isRank)(M_ASSERT (dst->size == M_C3(m_rbtr33_,name,_get_count)(dst->node));,) \
+    M_RBTR33_CONTRACT (dst);                                                  \
+  }                                                                           \
+                                                                              \
+  /* Move into 'dst' all the elements of 'src'                                \
+     (the elements of 'src' replace the equal ones of 'dst') */               \
+  static inline void                                                          \
+  M_C(name, _union)(tree_t dst, tree_t src)                                   \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop_ct) t;                                         \
+    M_C3(m_rbtr33_,name,_setop_init)(&t, M_RBTR33_UNION, dst, src);           \
+    M_C3(m_rbtr33_,name,_setop)(&t);                                          \
+    M_C3(m_rbtr33_,name,_setop_done)(&t, dst, src);                           \
+  }                                                                           \
+                                                                              \
+  /* Keep in 'dst' only the elements present in 'src'. 'src' is emptied */    \
+  static inline void                                                          \
+  M_C(name, _intersect)(tree_t dst, tree_t src)                               \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop_ct) t;                                         \
+    M_C3(m_rbtr33_,name,_setop_init)(&t, M_RBTR33_INTERSECT, dst, src);       \
+    M_C3(m_rbtr33_,name,_setop)(&t);                                          \
+    M_C3(m_rbtr33_,name,_setop_done)(&t, dst, src);                           \
+  }                                                                           \
+                                                                              \
+  /* Remove from 'dst' the elements present in 'src'. 'src' is emptied */     \
+  static inline void                                                          \
+  M_C(name, _difference)(tree_t dst, tree_t src)                              \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop_ct) t;                                         \
+    M_C3(m_rbtr33_,name,_setop_init)(&t, M_RBTR33_DIFFERENCE, dst, src);      \
+    M_C3(m_rbtr33_,name,_setop)(&t);                                          \
+    M_C3(m_rbtr33_,name,_setop_done)(&t, dst, src);                           \
+  }
+
+
+/* Definition of the parallel variants of the bulk operations
+   (only if m-worker.h is included, see below) */
+#define M_RBTR33_DEF_PARALLEL(name, type, oplist, isRank, tree_t, node_t, it_t) \
+                                                                              \
+  /* Entry point of a sub-operation performed by a worker */                  \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_setop_task)(void *arg)                                 \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop)(M_ASSIGN_CAST(M_C3(m_rbtr33_,name,_setop_ct) *, arg)); \
+  }                                                                           \
+                                                                              \
+  /* Perform the bulk operation using the given workers.                      \
+     The calling thread splits the first levels of the operation              \
+     and dispatches the independent sub-operations to the workers             \
+     before joining back their results. The sub-operations themselves         \
+     are sequential: only the calling thread waits for the workers */         \
+  static inline void                                                          \
+  M_C3(m_rbtr33_,name,_setop_parallel)(M_C3(m_rbtr33_,name,_setop_ct) *t,     \
+                                       m_worker_t workers)                    \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop_ct) tab[(2U << M_RBTR33_PARALLEL_MAX_DEPTH) - 1]; \
+    m_worker_sync_t block;                                                    \
+    (void) workers; /* Unused if M_USE_WORKER is 0 */                         \
+    /* Get enough sub-operations to feed all the workers */                   \
+    unsigned int depth = 0;                                                   \
+    const unsigned int num_worker = (unsigned int) m_worker_count(workers);   \
+    while (depth < M_RBTR33_PARALLEL_MAX_DEPTH && (1U << depth) < 2 * num_worker) { \
+      depth++;                                                                \
+    }                                                                         \
+    const unsigned int num_inner = (1U << depth) - 1;                         \
+    const unsigned int num = (2U << depth) - 1;                               \
+    tab[0] = *t;                                                              \
+    tab[0].state = M_RBTR33_SETOP_TODO;                                       \
+    for(unsigned int i = 1; i < num; i++) {                                   \
+      tab[i].state = M_RBTR33_SETOP_NONE;                                     \
+    }                                                                         \
+    /* Split the operation in the calling thread (parents before childs) */   \
+    m_worker_start(block, workers);                                           \
+    for(unsigned int i = 0; i < num; i++) {                                   \
+      if (tab[i].state != M_RBTR33_SETOP_TODO) {                              \
+        continue;                                                             \
+      }                                                                       \
+      if (i < num_inner                                                       \
+          && M_MIN(tab[i].ha, tab[i].hb) >= M_RBTR33_PARALLEL_MIN_HEIGHT) {   \
+        if (M_C3(m_rbtr33_,name,_setop_expose)(&tab[i], &tab[2*i+1], &tab[2*i+2])) { \
+          tab[i].state = M_RBTR33_SETOP_SPLIT;                                \
+          tab[2*i+1].state = tab[2*i+2].state = M_RBTR33_SETOP_TODO;          \
+        } else {                                                              \
+          tab[i].state = M_RBTR33_SETOP_DONE;                                 \
+        }                                                                     \
+      } else {                                                                \
+        tab[i].state = M_RBTR33_SETOP_DONE;                                   \
+        m_worker_spawn(block, M_C3(m_rbtr33_,name,_setop_task), &tab[i]);     \
+      }                                                                       \
+    }                                                                         \
+    m_worker_sync(block);                                                     \
+    /* Join back the results (childs before parents) */                       \
+    for(unsigned int i = num_inner; i-- > 0; ) {                              \
+      if (tab[i].state == M_RBTR33_SETOP_SPLIT) {                             \
+        M_C3(m_rbtr33_,name,_setop_combine)(&tab[i], &tab[2*i+1], &tab[2*i+2]); \
+      }                                                                       \
+    }                                                                         \
+    *t = tab[0];                                                              \
+  }                                                                           \
+                                                                              \
+  /* Same as _union, using the workers for large trees */                     \
+  static inline void                                                          \
+  M_C(name, _parallel_union)(tree_t dst, tree_t src, m_worker_t workers)      \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop_ct) t;                                         \
+    M_C3(m_rbtr33_,name,_setop_init)(&t, M_RBTR33_UNION, dst, src);           \
+    M_C3(m_rbtr33_,name,_setop_parallel)(&t, workers);                        \
+    M_C3(m_rbtr33_,name,_setop_done)(&t, dst, src);                           \
+  }                                                                           \
+                                                                              \
+  /* Same as _intersect, using the workers for large trees */                 \
+  static inline void                                                          \
+  M_C(name, _parallel_intersect)(tree_t dst, tree_t src, m_worker_t workers)  \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop_ct) t;                                         \
+    M_C3(m_rbtr33_,name,_setop_init)(&t, M_RBTR33_INTERSECT, dst, src);       \
+    M_C3(m_rbtr33_,name,_setop_parallel)(&t, workers);                        \
+    M_C3(m_rbtr33_,name,_setop_done)(&t, dst, src);                           \
+  }                                                                           \
+                                                                              \
+  /* Same as _difference, using the workers for large trees */                \
+  static inline void                                                          \
+  M_C(name, _parallel_difference)(tree_t dst, tree_t src, m_worker_t workers) \
+  {                                                                           \
+    M_C3(m_rbtr33_,name,_setop_ct) t;                                         \
+    M_C3(m_rbtr33_,name,_setop_init)(&t, M_RBTR33_DIFFERENCE, dst, src);      \
+    M_C3(m_rbtr33_,name,_setop_parallel)(&t, workers);                        \
+    M_C3(m_rbtr33_,name,_setop_done)(&t, dst, src);                           \
+  }
+
+
+/* The parallel bulk operations are not defined by default */
+#define M_RBTR33_DEF_PARALLEL_P(...)
 
 
 /* Definition of the emplace_back function for RB TREE
@@ -1188,7 +1907,16 @@ typedef enum {
 #if M_USE_SMALL_NAME
 #define RBTREE_DEF M_RBTREE_DEF
 #define RBTREE_DEF_AS M_RBTREE_DEF_AS
+#define RBTREE_RANK_DEF M_RBTREE_RANK_DEF
+#define RBTREE_RANK_DEF_AS M_RBTREE_RANK_DEF_AS
 #define RBTREE_OPLIST M_RBTREE_OPLIST
 #endif
 
 #endif
+
+// NOTE: Define the parallel bulk operations only if m-worker has been included
+#if !defined(MSTARLIB_RBTREE_WORKER_H) && defined(MSTARLIB_WORKER_H)
+#define MSTARLIB_RBTREE_WORKER_H
+#undef  M_RBTR33_DEF_PARALLEL_P
+#define M_RBTR33_DEF_PARALLEL_P M_RBTR33_DEF_PARALLEL
+#endif
@@ -82,6 +82,13 @@ typedef enum {
 #define M_USE_FAST_STRING_CONV 1
 #endif
 
+// By default, the dynamic strings use the global M_MEMORY_REALLOC
+// and M_MEMORY_FREE macros. If M_USE_STRING_ALLOCATOR is 1, each string
+// stores a pointer to its allocator (see m_allocator_t).
+#ifndef M_USE_STRING_ALLOCATOR
+#define M_USE_STRING_ALLOCATOR 0
+#endif
+
 /* Index returned in case of error instead of the position within the string */
 #define M_STRING_FAILURE ((size_t)-1)
 
@@ -89,6 +96,9 @@ typedef enum {
 typedef struct m_string_s {
   m_str1ng_union_ct u;
   char *ptr;
+#if M_USE_STRING_ALLOCATOR
+  const m_allocator_t *allocator;
+#endif
 } m_string_t[1];
 
 // Pointer to a Dynamic string
@@ -124,6 +134,18 @@ typedef struct m_string_it_s {
    m_string_: public methods
 */
 
+/* Internal macros to reallocate or free the heap buffer of a string
+   (alloc is the current number of allocated chars of the buffer) */
+#if M_USE_STRING_ALLOCATOR
+#define M_STR1NG_REALLOC(v, alloc, n)                                         \
+  M_ALL0CATOR_REALLOC((v)->allocator, char, (v)->ptr, alloc, n)
+#define M_STR1NG_FREE(v)                                                      \
+  M_ALL0CATOR_FREE((v)->allocator, char, (v)->ptr, (v)->u.heap.alloc)
+#else
+#define M_STR1NG_REALLOC(v, alloc, n) M_MEMORY_REALLOC (char, (v)->ptr, n)
+#define M_STR1NG_FREE(v) M_MEMORY_FREE((v)->ptr)
+#endif
+
 /* Internal method to test if the string is stack based or heap based
    We test if the ptr field points to the heap allocated buffer or not.
    This is not particularly efficient from a memory point of view
@@ -207,8 +229,31 @@ m_string_init(m_string_t s)
   s->ptr = NULL;
   s->u.stack.buffer[0] = 0;
   m_str1ng_set_size(s, 0);
+#if M_USE_STRING_ALLOCATOR
+  s->allocator = m_core_allocator_default();
+#endif
+  M_STR1NG_CONTRACT(s);
+}
+
+#if M_USE_STRING_ALLOCATOR
+/* Initialize the dynamic string (constructor) with the given allocator
+  and make it empty */
+static inline void
+m_string_init_allocator(m_string_t s, const m_allocator_t *allocator)
+{
+  M_ASSERT (allocator != NULL);
+  m_string_init(s);
+  s->allocator = allocator;
+}
+
+/* Return the allocator used by the string */
+static inline const m_allocator_t *
+m_string_allocator(const m_string_t s)
+{
   M_STR1NG_CONTRACT(s);
+  return s->allocator;
 }
+#endif
 
 /* Clear the Dynamic string (destructor) */
 static inline void
@@ -216,7 +261,7 @@ m_string_clear(m_string_t v)
 {
   M_STR1NG_CONTRACT(v);
   if (!m_str1ng_stack_p(v)) {    
-    M_MEMORY_FREE(v->ptr);
+    M_STR1NG_FREE(v);
     v->ptr   = NULL;
   }
   /* This is not needed but is safer to make
@@ -231,15 +276,17 @@ static inline m_string_ptr m_str1ng_init_ref(m_string_t v) { m_string_init(v); r
 /* Clear the Dynamic string (destructor)
   and return a heap pointer to the string.
   The ownership of the data is transfered back to the caller
-  and the returned pointer has to be released by M_MEMORY_FREE. */
+  and the returned pointer has to be released by M_MEMORY_FREE
+  (if M_USE_STRING_ALLOCATOR is 1, it is always a copy of the string). */
 static inline char *
 m_string_clear_get_cstr(m_string_t v)
 {
   M_STR1NG_CONTRACT(v);
   char *p = v->ptr;
-  if (m_str1ng_stack_p(v)) {
-    // The string was stack allocated.
-    p = v->u.stack.buffer;
+  // The buffer of the string can be returned only if it comes from M_MEMORY_REALLOC
+  const bool need_copy = M_USE_STRING_ALLOCATOR || m_str1ng_stack_p(v);
+  if (need_copy) {
+    p = m_str1ng_get_cstr(v);
     // Need to allocate a heap string to return the copy.
     size_t alloc = m_string_size(v)+1;
     char *ptr = M_MEMORY_REALLOC (char, NULL, alloc);
@@ -250,6 +297,9 @@ m_string_clear_get_cstr(m_string_t v)
     M_ASSERT(ptr != NULL && p != NULL);
     memcpy(ptr, p, alloc);
     p = ptr;
+    if (!m_str1ng_stack_p(v)) {
+      M_STR1NG_FREE(v);
+    }
   }
   v->ptr = NULL;
   v->u.stack.buffer[sizeof (m_str1ng_heap_ct) - 1] = CHAR_MAX;
@@ -319,7 +369,7 @@ m_str1ng_fit2size (m_string_t v, size_t size_alloc)
       abort();
       return NULL;
     }
-    char *ptr = M_MEMORY_REALLOC (char, v->ptr, alloc);
+    char *ptr = M_STR1NG_REALLOC (v, m_str1ng_stack_p(v) ? 0 : old_alloc, alloc);
     if (M_UNLIKELY (ptr == NULL)) {
       M_MEMORY_FULL(sizeof (char) * alloc);
       // NOTE: Return is currently broken.
@@ -364,7 +414,7 @@ m_string_reserve(m_string_t v, size_t alloc)
       /* Transform Heap Allocate to Stack Allocate */
       char *ptr = &v->u.stack.buffer[0];
       memcpy(ptr, v->ptr, size+1);
-      M_MEMORY_FREE(v->ptr);
+      M_STR1NG_FREE(v);
       v->ptr = NULL;
       m_str1ng_set_size(v, size);
     } else {
@@ -375,7 +425,7 @@ m_string_reserve(m_string_t v, size_t alloc)
     // Need to allocate in heap space
     // If the string is stack allocated, v->ptr is NULL
     // and it will therefore perform the initial allocation
-    char *ptr = M_MEMORY_REALLOC (char, v->ptr, alloc);
+    char *ptr = M_STR1NG_REALLOC (v, m_str1ng_stack_p(v) ? 0 : v->u.heap.alloc, alloc);
     if (M_UNLIKELY (ptr == NULL) ) {
       M_MEMORY_FULL(sizeof (char) * alloc);
       return;
@@ -459,6 +509,9 @@ static inline void
 m_string_init_set(m_string_t v1, const m_string_t v2)
 {
   m_string_init(v1);
+#if M_USE_STRING_ALLOCATOR
+  v1->allocator = v2->allocator;
+#endif
   m_string_set(v1,v2);
 }
 
@@ -495,6 +548,9 @@ m_string_swap(m_string_t v1, m_string_t v2)
   M_SWAP (size_t, v1->u.heap.size,  v2->u.heap.size);
   M_SWAP (size_t, v1->u.heap.alloc, v2->u.heap.alloc);
   M_SWAP (char *, v1->ptr,   v2->ptr);
+#if M_USE_STRING_ALLOCATOR
+  M_SWAP (const m_allocator_t *, v1->allocator, v2->allocator);
+#endif
   M_STR1NG_CONTRACT (v1);
   M_STR1NG_CONTRACT (v2);
 }
@@ -1314,6 +1370,17 @@ m_string_hash(const m_string_t v)
   return m_core_hash(m_string_get_cstr(v), m_string_size(v));
 }
 
+/* Return the bytes of the string (its characters) and their number,
+   ordered as the string (KEY_BYTES method). The buffer is not used */
+static inline const unsigned char *
+m_string_key_bytes(unsigned char buffer[], size_t *len, const m_string_t v)
+{
+  M_STR1NG_CONTRACT (v);
+  (void) buffer;
+  *len = m_string_size(v);
+  return (const unsigned char *) m_string_get_cstr(v);
+}
+
 // Return true if c is a character from charac
 static bool
 m_str1ng_strim_char(char c, const char charac[])
@@ -1922,8 +1989,13 @@ namespace m_lib {
 #endif
 
 /* NOTE: Use GCC extension (OBSOLETE) */
+#if M_USE_STRING_ALLOCATOR
+#define M_STRING_DECL_INIT(v)                                                 \
+  m_string_t v __attribute__((cleanup(m_str1ng_clear2))) = {{ 0, 0, NULL, m_core_allocator_default()}}
+#else
 #define M_STRING_DECL_INIT(v)                                                 \
   m_string_t v __attribute__((cleanup(m_str1ng_clear2))) = {{ 0, 0, NULL}}
+#endif
 
 /* NOTE: Use GCC extension (OBSOLETE) */
 #define M_STRING_DECL_INIT_PRINTF(v, format, ...)                             \
@@ -1944,7 +2016,8 @@ namespace m_lib {
    OUT_STR(m_string_out_str), IN_STR(m_string_in_str),                        \
    OUT_SERIAL(m_string_out_serial), IN_SERIAL(m_string_in_serial),            \
    EXT_ALGO(M_STR1NG_SPLIT),                                                  \
-   OOR_EQUAL(m_string_oor_equal_p), OOR_SET(m_string_oor_set)                 \
+   OOR_EQUAL(m_string_oor_equal_p), OOR_SET(m_string_oor_set),               \
+   KEY_BYTES(m_string_key_bytes)                                              \
    ,SUBTYPE(m_string_unicode_t)                                               \
    ,IT_TYPE(m_string_it_t)                                                    \
    ,IT_FIRST(m_string_it)                                                     \
@@ -2522,6 +2595,8 @@ namespace m_lib {
 #define string_capacity m_string_capacity
 #define string_get_cstr m_string_get_cstr
 #define string_init m_string_init
+#define string_init_allocator m_string_init_allocator
+#define string_allocator m_string_allocator
 #define string_clear m_string_clear
 #define string_clear_get_str m_string_clear_get_cstr
 #define string_reset m_string_reset
@@ -2575,6 +2650,7 @@ namespace m_lib {
 #define string_end_with_str_p m_string_end_with_str_p
 #define string_end_with_string_p m_string_end_with_string_p
 #define string_hash m_string_hash
+#define string_key_bytes m_string_key_bytes
 #define string_strim m_string_strim
 #define string_oor_equal_p m_string_oor_equal_p
 #define string_oor_set m_string_oor_set
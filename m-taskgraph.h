@@ -0,0 +1,358 @@
+/*
+ * M*LIB - TASKGRAPH module
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_TASKGRAPH_H
+#define MSTARLIB_TASKGRAPH_H
+
+#include "m-core.h"
+#include "m-atomic.h"
+#include "m-worker.h"
+
+M_BEGIN_PROTECTED_CODE
+
+/* Reusable graph of tasks (Directed Acyclic Graph) executed by a pool of workers.
+   USAGE:
+     m_taskgraph_t g;
+     m_taskgraph_init(g);
+     size_t a = m_taskgraph_add(g, func_a, data_a);
+     size_t b = m_taskgraph_add(g, func_b, data_b);
+     m_taskgraph_add_edge(g, a, b);     // b runs after a
+     m_taskgraph_run(g, worker);        // Can be run many times
+     m_taskgraph_clear(g);
+   Each task has a counter of its predecessors not terminated yet.
+   When a task terminates, it decrements the counter of all its successors
+   and the ones reaching zero are ready: one of them is executed by the same
+   thread and the others are spawned to the pool of workers.
+   The successors of all tasks are compiled in a compact array (sorted
+   by task) with a topological order the first time the graph is run
+   after a modification, so that running the graph again doesn't
+   perform any allocation (it only resets the counters).
+*/
+
+/* Define a task of a graph */
+typedef struct m_taskgr4ph_node_s {
+  atomic_size_t pending;               // Number of predecessors not terminated
+  size_t num_pred;                     // Number of predecessors
+  size_t first_succ;                   // Index of the first successor in 'succ'
+  size_t num_succ;                     // Number of successors
+  void (*func)(void *);                // Function of the task
+  void *data;                          // Data of the function
+  struct m_taskgraph_s *graph;         // Graph of the task
+} m_taskgr4ph_node_ct;
+
+/* Define an edge of a graph */
+typedef struct m_taskgr4ph_edge_s {
+  size_t from, to;
+} m_taskgr4ph_edge_ct;
+
+/* Define a graph of tasks */
+typedef struct m_taskgraph_s {
+  m_taskgr4ph_node_ct *node;           // Array of the tasks
+  size_t num_node, alloc_node;
+  m_taskgr4ph_edge_ct *edge;           // Array of the edges (as added)
+  size_t num_edge, alloc_edge;
+  size_t *succ;                        // Successors of the tasks (alloc_edge entries)
+  size_t *order;                       // Topological order (alloc_node entries)
+  size_t num_root;                     // Number of tasks without predecessor
+  bool   compiled;                     // Are succ & order up to date?
+  m_worker_sync_t block;               // Synchronization point of a run
+} m_taskgraph_t[1];
+
+// Pointer to a graph of tasks
+typedef struct m_taskgraph_s *m_taskgraph_ptr;
+
+/* Contract of a graph */
+#define M_TASKGR4PH_CONTRACT(g) do {                                          \
+    M_ASSERT ((g) != NULL);                                                   \
+    M_ASSERT ((g)->num_node <= (g)->alloc_node);                              \
+    M_ASSERT ((g)->num_edge <= (g)->alloc_edge);                              \
+    M_ASSERT ((g)->num_node == 0 || ((g)->node != NULL && (g)->order != NULL)); \
+    M_ASSERT ((g)->num_edge == 0 || ((g)->edge != NULL && (g)->succ != NULL)); \
+  } while (0)
+
+/* Initialize an empty graph of tasks */
+static inline void
+m_taskgraph_init(m_taskgraph_t g)
+{
+  M_ASSERT (g != NULL);
+  g->node = NULL;
+  g->num_node = g->alloc_node = 0;
+  g->edge = NULL;
+  g->num_edge = g->alloc_edge = 0;
+  g->succ = NULL;
+  g->order = NULL;
+  g->num_root = 0;
+  g->compiled = false;
+  M_TASKGR4PH_CONTRACT(g);
+}
+
+/* Clear a graph of tasks */
+static inline void
+m_taskgraph_clear(m_taskgraph_t g)
+{
+  M_TASKGR4PH_CONTRACT(g);
+  M_MEMORY_FREE(g->node);
+  M_MEMORY_FREE(g->edge);
+  M_MEMORY_FREE(g->succ);
+  M_MEMORY_FREE(g->order);
+  g->node = NULL;
+  g->edge = NULL;
+  g->succ = NULL;
+  g->order = NULL;
+  g->num_node = g->alloc_node = 0;
+  g->num_edge = g->alloc_edge = 0;
+  g->num_root = 0;
+  g->compiled = false;
+}
+
+/* Remove all the tasks and edges of the graph (keeping its memory) */
+static inline void
+m_taskgraph_reset(m_taskgraph_t g)
+{
+  M_TASKGR4PH_CONTRACT(g);
+  g->num_node = 0;
+  g->num_edge = 0;
+  g->num_root = 0;
+  g->compiled = false;
+}
+
+/* Return the number of tasks of the graph */
+static inline size_t
+m_taskgraph_size(const m_taskgraph_t g)
+{
+  M_TASKGR4PH_CONTRACT(g);
+  return g->num_node;
+}
+
+/* Add a task to the graph executing func(data).
+   Return the index of the task (or SIZE_MAX in case of failure) */
+static inline size_t
+m_taskgraph_add(m_taskgraph_t g, void (*func)(void *), void *data)
+{
+  M_TASKGR4PH_CONTRACT(g);
+  M_ASSERT (func != NULL);
+  if (M_UNLIKELY (g->num_node == g->alloc_node)) {
+    size_t alloc = M_MAX((size_t) 16, 2 * g->alloc_node);
+    if (M_UNLIKELY (alloc <= g->alloc_node || alloc > SIZE_MAX / sizeof (m_taskgr4ph_node_ct))) {
+      M_MEMORY_FULL(SIZE_MAX);
+      return SIZE_MAX;
+    }
+    m_taskgr4ph_node_ct *node = M_MEMORY_REALLOC(m_taskgr4ph_node_ct, g->node, alloc);
+    if (M_UNLIKELY (node == NULL)) {
+      M_MEMORY_FULL(sizeof (m_taskgr4ph_node_ct) * alloc);
+      return SIZE_MAX;
+    }
+    g->node = node;
+    size_t *order = M_MEMORY_REALLOC(size_t, g->order, alloc);
+    if (M_UNLIKELY (order == NULL)) {
+      M_MEMORY_FULL(sizeof (size_t) * alloc);
+      return SIZE_MAX;
+    }
+    g->order = order;
+    g->alloc_node = alloc;
+  }
+  const size_t i = g->num_node++;
+  m_taskgr4ph_node_ct *n = &g->node[i];
+  n->func = func;
+  n->data = data;
+  n->num_pred = 0;
+  n->first_succ = 0;
+  n->num_succ = 0;
+  g->compiled = false;
+  return i;
+}
+
+/* Add an edge to the graph: the task 'to' is executed only once
+   the task 'from' is terminated */
+static inline void
+m_taskgraph_add_edge(m_taskgraph_t g, size_t from, size_t to)
+{
+  M_TASKGR4PH_CONTRACT(g);
+  M_ASSERT (from < g->num_node && to < g->num_node && from != to);
+  if (M_UNLIKELY (g->num_edge == g->alloc_edge)) {
+    size_t alloc = M_MAX((size_t) 16, 2 * g->alloc_edge);
+    if (M_UNLIKELY (alloc <= g->alloc_edge || alloc > SIZE_MAX / sizeof (m_taskgr4ph_edge_ct))) {
+      M_MEMORY_FULL(SIZE_MAX);
+      return;
+    }
+    m_taskgr4ph_edge_ct *edge = M_MEMORY_REALLOC(m_taskgr4ph_edge_ct, g->edge, alloc);
+    if (M_UNLIKELY (edge == NULL)) {
+      M_MEMORY_FULL(sizeof (m_taskgr4ph_edge_ct) * alloc);
+      return;
+    }
+    g->edge = edge;
+    size_t *succ = M_MEMORY_REALLOC(size_t, g->succ, alloc);
+    if (M_UNLIKELY (succ == NULL)) {
+      M_MEMORY_FULL(sizeof (size_t) * alloc);
+      return;
+    }
+    g->succ = succ;
+    g->alloc_edge = alloc;
+  }
+  g->edge[g->num_edge].from = from;
+  g->edge[g->num_edge].to   = to;
+  g->num_edge++;
+  g->compiled = false;
+}
+
+/* Compile the edges of the graph into the arrays of successors
+   of the tasks, and compute a topological order of the tasks
+   (the tasks without predecessor being first).
+   No allocation is performed (the arrays are allocated on insertion). */
+static inline void
+m_taskgr4ph_compile(m_taskgraph_t g)
+{
+  const size_t n = g->num_node;
+  m_taskgr4ph_node_ct *node = g->node;
+  // Count the successors & predecessors of each task
+  for(size_t i = 0; i < n; i++) {
+    node[i].num_pred = 0;
+    node[i].num_succ = 0;
+    node[i].graph = g;
+  }
+  for(size_t e = 0; e < g->num_edge; e++) {
+    node[g->edge[e].from].num_succ++;
+    node[g->edge[e].to].num_pred++;
+  }
+  // Compute the index of the first successor of each task
+  size_t first = 0;
+  for(size_t i = 0; i < n; i++) {
+    node[i].first_succ = first;
+    first += node[i].num_succ;
+    node[i].num_succ = 0;
+  }
+  M_ASSERT (first == g->num_edge);
+  for(size_t e = 0; e < g->num_edge; e++) {
+    m_taskgr4ph_node_ct *from = &node[g->edge[e].from];
+    g->succ[from->first_succ + from->num_succ++] = g->edge[e].to;
+  }
+  // Topological sort of the tasks (Kahn's algorithm)
+  // using the array of the order as the queue of the ready tasks
+  size_t tail = 0;
+  for(size_t i = 0; i < n; i++) {
+    atomic_store_explicit(&node[i].pending, node[i].num_pred, memory_order_relaxed);
+    if (node[i].num_pred == 0) {
+      g->order[tail++] = i;
+    }
+  }
+  g->num_root = tail;
+  for(size_t head = 0; head < tail; head++) {
+    const m_taskgr4ph_node_ct *t = &node[g->order[head]];
+    for(size_t s = t->first_succ; s < t->first_succ + t->num_succ; s++) {
+      const size_t j = g->succ[s];
+      const size_t p = atomic_load_explicit(&node[j].pending, memory_order_relaxed);
+      atomic_store_explicit(&node[j].pending, p - 1, memory_order_relaxed);
+      if (p == 1) {
+        g->order[tail++] = j;
+      }
+    }
+  }
+  // If the graph has a cycle, the tasks of the cycle are never executed
+  M_ASSERT (tail == n);
+  g->compiled = true;
+}
+
+/* Execute a task and then its successors which become ready.
+   One ready successor is executed by the same thread (so that a chain
+   of tasks is executed without spawning anything),
+   the other ones are spawned to the workers. */
+static inline void
+m_taskgr4ph_exec(void *arg)
+{
+  m_taskgr4ph_node_ct *node = M_ASSIGN_CAST(m_taskgr4ph_node_ct *, arg);
+  struct m_taskgraph_s *g = node->graph;
+  while (true) {
+    node->func(node->data);
+    m_taskgr4ph_node_ct *next = NULL;
+    const size_t *succ = &g->succ[node->first_succ];
+    for(size_t i = 0; i < node->num_succ; i++) {
+      m_taskgr4ph_node_ct *s = &g->node[succ[i]];
+      // Acquire the effects of the other predecessors & release ours
+      if (atomic_fetch_sub_explicit(&s->pending, 1, memory_order_acq_rel) == 1) {
+        if (next != NULL) {
+          m_worker_spawn(g->block, m_taskgr4ph_exec, next);
+        }
+        next = s;
+      }
+    }
+    if (next == NULL) {
+      return;
+    }
+    node = next;
+  }
+}
+
+/* Execute all the tasks of the graph using the pool of workers,
+   respecting the edges of the graph, and wait for their termination.
+   The graph shall be acyclic. The same graph cannot be run concurrently,
+   nor be modified while it is run. */
+static inline void
+m_taskgraph_run(m_taskgraph_t g, m_worker_t workers)
+{
+  M_TASKGR4PH_CONTRACT(g);
+  if (M_UNLIKELY (!g->compiled)) {
+    m_taskgr4ph_compile(g);
+  }
+  const size_t n = g->num_node;
+  if (n == 0) {
+    return;
+  }
+  m_taskgr4ph_node_ct *node = g->node;
+  if (m_worker_count(workers) == 1) {
+    // No worker: execute the tasks in the topological order
+    for(size_t i = 0; i < n; i++) {
+      const m_taskgr4ph_node_ct *t = &node[g->order[i]];
+      t->func(t->data);
+    }
+    return;
+  }
+  // Reset the counters of the predecessors
+  for(size_t i = 0; i < n; i++) {
+    atomic_store_explicit(&node[i].pending, node[i].num_pred, memory_order_relaxed);
+  }
+  // Spawn the tasks without predecessor (executing the last one)
+  m_worker_start(g->block, workers);
+  M_ASSERT (g->num_root > 0);
+  for(size_t i = 0; i < g->num_root - 1; i++) {
+    m_worker_spawn(g->block, m_taskgr4ph_exec, &node[g->order[i]]);
+  }
+  m_taskgr4ph_exec(&node[g->order[g->num_root - 1]]);
+  m_worker_sync(g->block);
+}
+
+M_END_PROTECTED_CODE
+
+#if M_USE_SMALL_NAME
+#define taskgraph_t m_taskgraph_t
+#define taskgraph_ptr m_taskgraph_ptr
+#define taskgraph_init m_taskgraph_init
+#define taskgraph_clear m_taskgraph_clear
+#define taskgraph_reset m_taskgraph_reset
+#define taskgraph_size m_taskgraph_size
+#define taskgraph_add m_taskgraph_add
+#define taskgraph_add_edge m_taskgraph_add_edge
+#define taskgraph_run m_taskgraph_run
+#endif
+
+#endif
@@ -75,6 +75,7 @@
     M_ASSERT( (tree)->free_index < 0 || (tree)->tab[(tree)->free_index].parent == M_TR33_NO_NODE); \
     M_ASSERT( (tree)->root_index < 0 || (tree)->tab[(tree)->root_index].parent == M_TR33_ROOT_NODE); \
     M_ASSERT( (tree)->root_index != M_TR33_NO_NODE || (tree)->size == 0);     \
+    M_ASSERT( !(tree)->compact || (tree)->size == 0 || (tree)->root_index == 0); \
 } while (0)
 
 # define M_TR33_IT_CONTRACT(it, valid) do {                                   \
@@ -120,6 +121,14 @@ typedef int32_t m_tr33_index_t;
 #define M_TR33_ROOT_NODE (-2)
 #define M_TR33_NO_NODE (-1)
 
+/* Number of nodes allocated for the array of a tree (including tab[-1]) */
+#define M_TR33_ALLOCATED(tree) ((tree)->tab == NULL ? 0 : (size_t) (tree)->capacity + 1)
+
+/* Max number of tasks of a parallel reduce or visit split by the calling thread
+   and minimum estimated number of nodes of a sub-tree to dispatch it to a worker */
+#define M_TR33_PARALLEL_MAX_TASK 64
+#define M_TR33_PARALLEL_GRAIN    1024
+
 /* Internal definition:
    - name: prefix to be used
    - type: type of the elements of the tree
@@ -160,7 +169,10 @@ typedef int32_t m_tr33_index_t;
        + root_index is the index of the "first" root in the tree.             \
        + free_index is the list of free nodes in the array 'tab'.             \
        + allow_realloc is a bool encoded as true=0 and false=INT32_MAX        \
+       + compact is true if the nodes are stored in pre-order from index 0    \
+         (see _compact_preorder). It is reset by any change of the layout.    \
        + tab is a pointer to the allocated nodes.                             \
+       + allocator is the allocator of the array (if ALLOCATOR method).       \
     */                                                                        \
     typedef struct M_C(name, _s) {                                            \
         m_tr33_index_t       size;                                            \
@@ -168,7 +180,9 @@ typedef int32_t m_tr33_index_t;
         m_tr33_index_t       root_index;                                      \
         m_tr33_index_t       free_index;                                      \
         uint32_t             allow_realloc;                                   \
+        bool                 compact;                                         \
         M_C(name, _node_ct) *tab;                                             \
+        M_ALL0CATOR_FIELD(oplist)                                             \
     } tree_t[1];                                                              \
                                                                               \
     /* Define an iterator that references a node.                             \
@@ -186,9 +200,15 @@ typedef int32_t m_tr33_index_t;
         m_tr33_index_t        index;                                          \
     } it_t;                                                                   \
                                                                               \
+    /* Define the callbacks of the reduce and visit functions */              \
+    typedef void (*M_C(name, _leaf_cb_ct))(type *);                           \
+    typedef void (*M_C(name, _combine_cb_ct))(type *, const type *);          \
+    typedef void (*M_C(name, _visit_cb_ct))(type *, const type *);            \
+                                                                              \
     M_TR33_DEF_P4_CORE(name, type, oplist, tree_t, it_t)                      \
     M_TR33_DEF_P4_CLASSIC(name, type, oplist, tree_t, it_t)                   \
-    M_TR33_DEF_P4_IO(name, type, oplist, tree_t, it_t)
+    M_TR33_DEF_P4_IO(name, type, oplist, tree_t, it_t)                        \
+    M_TR33_DEF_PARALLEL_P(name, type, oplist, tree_t, it_t)
 
 /* Define the core & unique methods of a tree */
 #define M_TR33_DEF_P4_CORE(name, type, oplist, tree_t, it_t)                  \
@@ -200,10 +220,27 @@ typedef int32_t m_tr33_index_t;
         tree->root_index = M_TR33_NO_NODE;                                    \
         tree->free_index = M_TR33_NO_NODE;                                    \
         tree->allow_realloc = 0;                                              \
+        tree->compact = true;                                                 \
         tree->tab = NULL;                                                     \
+        M_IF_METHOD(ALLOCATOR, oplist)(tree->allocator = M_GET_ALLOCATOR oplist;, ) \
         M_TR33_CONTRACT(tree);                                                \
     }                                                                         \
                                                                               \
+    M_IF_METHOD(ALLOCATOR, oplist)(                                           \
+    static inline void                                                        \
+    M_C(name, _init_allocator)(tree_t tree, const m_allocator_t *allocator) { \
+        M_ASSERT (allocator != NULL);                                         \
+        M_C(name, _init)(tree);                                               \
+        tree->allocator = allocator;                                          \
+    }                                                                         \
+                                                                              \
+    static inline const m_allocator_t *                                       \
+    M_C(name, _allocator)(const tree_t tree) {                                \
+        M_ASSERT (tree != NULL);                                              \
+        return tree->allocator;                                               \
+    }                                                                         \
+    , /* No ALLOCATOR */ )                                                    \
+                                                                              \
     static inline void                                                        \
     M_C(name, _reset)(tree_t tree) {                                          \
         M_TR33_CONTRACT(tree);                                                \
@@ -226,6 +263,7 @@ typedef int32_t m_tr33_index_t;
             tree->free_index = free_index;                                    \
             tree->size = 0;                                                   \
             tree->root_index = M_TR33_NO_NODE;                                \
+            tree->compact = true;                                             \
         }                                                                     \
         M_TR33_CONTRACT(tree);                                                \
     }                                                                         \
@@ -233,8 +271,9 @@ typedef int32_t m_tr33_index_t;
     static inline void                                                        \
     M_C(name, _clear)(tree_t tree) {                                          \
         M_C(name, _reset)(tree);                                              \
-        struct M_C(name,_node_s)*ptr = tree->tab == NULL ? NULL : tree->tab-1;\
-        M_CALL_FREE(oplist, ptr);                                             \
+        struct M_C(name,_node_s)*ptr = tree->tab == NULL ? NULL : tree->tab-1; \
+        M_CALL_FREE_CTX(oplist, tree->allocator, struct M_C(name, _node_s), ptr, \
+                        M_TR33_ALLOCATED(tree));                              \
         /* This is so reusing the object implies an assertion failure */      \
         tree->size = 1;                                                       \
         tree->tab = NULL;                                                     \
@@ -257,7 +296,8 @@ typedef int32_t m_tr33_index_t;
            as M_TR33_NO_NODE is -1. This enables avoiding testing for         \
            M_TR33_NO_NODE in some cases, performing branchless code. */       \
         struct M_C(name,_node_s)*ptr = tree->tab == NULL ? NULL : tree->tab-1;\
-        ptr = M_CALL_REALLOC(oplist, struct M_C(name, _node_s), ptr, alloc+1);\
+        ptr = M_CALL_REALLOC_CTX(oplist, tree->allocator, struct M_C(name, _node_s), \
+                                 ptr, M_TR33_ALLOCATED(tree), alloc+1);       \
         if (M_UNLIKELY (ptr == NULL) ) {                                      \
             M_MEMORY_FULL(sizeof (struct M_C(name, _node_s)) * alloc);        \
             return;                                                           \
@@ -311,7 +351,8 @@ typedef int32_t m_tr33_index_t;
             as M_TR33_NO_NODE is -1. This enables avoiding testing for        \
             M_TR33_NO_NODE in some cases, performing branchless code. */      \
             struct M_C(name,_node_s)*ptr = tree->tab == NULL ? NULL : tree->tab-1; \
-            ptr = M_CALL_REALLOC(oplist, struct M_C(name, _node_s), ptr, alloc+1); \
+            ptr = M_CALL_REALLOC_CTX(oplist, tree->allocator, struct M_C(name, _node_s), \
+                                     ptr, M_TR33_ALLOCATED(tree), alloc+1);   \
             if (M_UNLIKELY (ptr == NULL) ) {                                  \
                 M_MEMORY_FULL(sizeof (struct M_C(name, _node_s)) * alloc);    \
                 return M_TR33_NO_NODE;                                        \
@@ -336,6 +377,8 @@ typedef int32_t m_tr33_index_t;
         /* Pop an element in the list of free nodes */                        \
         tree->free_index = tree->tab[ret].child;                              \
         tree->size ++;                                                        \
+        /* The new node breaks the pre-order layout */                        \
+        tree->compact = false;                                                \
         return ret;                                                           \
     }                                                                         \
                                                                               \
@@ -347,6 +390,7 @@ typedef int32_t m_tr33_index_t;
         tree->tab[i].child  = tree->free_index;                               \
         tree->size --;                                                        \
         tree->free_index = i;                                                 \
+        tree->compact = false;                                                \
     }                                                                         \
                                                                               \
     static inline it_t                                                        \
@@ -788,6 +832,12 @@ typedef int32_t m_tr33_index_t;
     static inline void                                                        \
     M_C(name, _next)(it_t *it) {                                              \
         M_TR33_IT_CONTRACT(*it, true);                                        \
+        if (it->tree->compact) {                                              \
+            /* Pre-order layout: the next node is the next one of the array */ \
+            m_tr33_index_t i = it->index + 1;                                 \
+            it->index = i < it->tree->size ? i : M_TR33_NO_NODE;              \
+            return;                                                           \
+        }                                                                     \
         /* First go down, if impossible go right */                           \
         if (M_C(name, _it_down)(it) || M_C(name, _it_right)(it)) {            \
             return;                                                           \
@@ -803,6 +853,22 @@ typedef int32_t m_tr33_index_t;
         M_TR33_IT_CONTRACT(*it, false);                                       \
     }                                                                         \
                                                                               \
+    /* Move to the next node in pre-order which is not in the sub-tree        \
+       of the current node (skipping its children) */                         \
+    static inline void                                                        \
+    M_C(name, _next_skip)(it_t *it) {                                         \
+        M_TR33_IT_CONTRACT(*it, true);                                        \
+        /* Go right, if impossible move up and then right until possible */   \
+        do {                                                                  \
+            if (M_C(name, _it_right)(it)) {                                   \
+                return;                                                       \
+            }                                                                 \
+        } while (M_C(name, _it_up)(it));                                      \
+        /* Reach end of tree */                                               \
+        it->index = M_TR33_NO_NODE;                                           \
+        M_TR33_IT_CONTRACT(*it, false);                                       \
+    }                                                                         \
+                                                                              \
     /* Scan all nodes, first the children then the parent */                  \
     /* post-order walk */                                                     \
     static inline it_t                                                        \
@@ -859,14 +925,25 @@ typedef int32_t m_tr33_index_t;
         M_TR33_IT_CONTRACT(*it, true);                                        \
         M_TR33_IT_CONTRACT(it_ref, true);                                     \
         M_ASSERT(it->tree == it_ref.tree);                                    \
-        /* First go down, if impossible go right */                           \
+        if (it->tree->compact) {                                              \
+            /* Pre-order layout: the sub-tree of it_ref is the range of nodes \
+               following it_ref. The next node is out of this range if its   \
+               parent is before it_ref (a strict ancestor of it_ref) */       \
+            m_tr33_index_t i = it->index + 1;                                 \
+            it->index = i < it->tree->size && it->tree->tab[i].parent >= it_ref.index \
+                ? i : M_TR33_NO_NODE;                                         \
+            return;                                                           \
+        }                                                                     \
+        /* First go down, if impossible go right, or move up and then right   \
+           until possible, without leaving the sub-tree of it_ref */          \
         if (M_C(name, _it_down)(it)) { return; }                              \
-        if (M_C(name, _it_right)(it)) { return;}                              \
-        /* If impossible to go right, move up and then right for the all section */ \
-        while (M_C(name, _it_up)(it) && it->index != it_ref.index) {          \
+        while (it->index != it_ref.index) {                                   \
             if (M_C(name, _it_right)(it)) {                                   \
                 return;                                                       \
             }                                                                 \
+            bool b = M_C(name, _it_up)(it);                                   \
+            M_ASSERT(b);                                                      \
+            (void) b;                                                         \
         }                                                                     \
         /* Reach end of section */                                            \
         it->index = M_TR33_NO_NODE;                                           \
@@ -957,6 +1034,7 @@ typedef int32_t m_tr33_index_t;
         M_TR33_IT_CONTRACT(it1, true);                                        \
         M_TR33_IT_CONTRACT(it2, true);                                        \
         if (M_UNLIKELY(it1.index == it2.index)) { return; }                   \
+        it1.tree->compact = false;                                            \
         /* Read all references before modifying anything */                   \
         m_tr33_index_t tmp1_l = it1.tree->tab[it1.index].left;                \
         m_tr33_index_t tmp2_l = it2.tree->tab[it2.index].left;                \
@@ -1041,6 +1119,7 @@ typedef int32_t m_tr33_index_t;
         /* Move the node it2 and its child down the node *it1 */              \
         /* Both belongs to the same tree */                                   \
         const m_tr33_index_t i = it2.index;                                   \
+        it1.tree->compact = false;                                            \
         /* Unlink it2 except its child */                                     \
         const m_tr33_index_t parent = it1.tree->tab[i].parent;                \
         if (parent >= 0 && it1.tree->tab[parent].child == i) {                \
@@ -1063,6 +1142,166 @@ typedef int32_t m_tr33_index_t;
         M_TR33_IT_CONTRACT(it2, true);                                        \
     }                                                                         \
                                                                               \
+    /* Renumber the nodes of the tree in pre-order into a new array,          \
+       so that a pre-order walk is a linear scan of the array and             \
+       the nodes of a sub-tree are stored in a contiguous range.              \
+       All iterators of the tree are invalidated. */                          \
+    static inline void                                                        \
+    M_C(name, _compact_preorder)(tree_t tree) {                               \
+        M_TR33_CONTRACT(tree);                                                \
+        if (tree->compact || tree->size == 0) {                               \
+            tree->compact = true;                                             \
+            return;                                                           \
+        }                                                                     \
+        size_t alloc = (size_t) tree->capacity;                               \
+        struct M_C(name,_node_s) *ptr =                                       \
+            M_CALL_REALLOC_CTX(oplist, tree->allocator, struct M_C(name, _node_s), \
+                               NULL, 0, alloc+1);                             \
+        if (M_UNLIKELY (ptr == NULL) ) {                                      \
+            M_MEMORY_FULL(sizeof (struct M_C(name, _node_s)) * alloc);        \
+            return;                                                           \
+        }                                                                     \
+        /* Skip the first term to keep it as empty & unused */                \
+        ptr++;                                                                \
+        struct M_C(name,_node_s) *tab = tree->tab;                            \
+        /* Walk the old array in pre-order ('o') while filling the new one ('n'). \
+           The parents of the new nodes are used to move up in the new array */ \
+        m_tr33_index_t o = tree->root_index, n = 0, num = 1;                  \
+        ptr[0].parent = M_TR33_ROOT_NODE;                                     \
+        ptr[0].left   = M_TR33_NO_NODE;                                       \
+        ptr[0].right  = M_TR33_NO_NODE;                                       \
+        ptr[0].child  = M_TR33_NO_NODE;                                       \
+        M_DO_INIT_MOVE(oplist, ptr[0].data, tab[o].data);                     \
+        while (true) {                                                        \
+            m_tr33_index_t next = tab[o].child;                               \
+            if (next >= 0) {                                                  \
+                /* Go down: the first child follows its parent */             \
+                ptr[n].child    = num;                                        \
+                ptr[num].parent = n;                                          \
+                ptr[num].left   = M_TR33_NO_NODE;                             \
+            } else {                                                          \
+                /* Go right, if impossible move up and then right */          \
+                while (o >= 0 && tab[o].right < 0) {                          \
+                    o = tab[o].parent;                                        \
+                    n = ptr[n].parent;                                        \
+                }                                                             \
+                if (o < 0) {                                                  \
+                    break;                                                    \
+                }                                                             \
+                next = tab[o].right;                                          \
+                ptr[n].right    = num;                                        \
+                ptr[num].parent = ptr[n].parent;                              \
+                ptr[num].left   = n;                                          \
+            }                                                                 \
+            ptr[num].right = M_TR33_NO_NODE;                                  \
+            ptr[num].child = M_TR33_NO_NODE;                                  \
+            M_DO_INIT_MOVE(oplist, ptr[num].data, tab[next].data);            \
+            o = next;                                                         \
+            n = num++;                                                        \
+        }                                                                     \
+        M_ASSERT(num == tree->size);                                          \
+        /* Construct the list of free nodes after the used nodes */           \
+        for(size_t i = (size_t) num; i < alloc; i++) {                        \
+            ptr[i].parent = M_TR33_NO_NODE;                                   \
+            ptr[i].left   = M_TR33_NO_NODE;                                   \
+            ptr[i].right  = M_TR33_NO_NODE;                                   \
+            ptr[i].child  = (m_tr33_index_t) i + 1;                           \
+        }                                                                     \
+        ptr[alloc-1].child = M_TR33_NO_NODE;                                  \
+        tree->free_index = num < tree->capacity ? num : M_TR33_NO_NODE;       \
+        tree->root_index = 0;                                                 \
+        tree->compact = true;                                                 \
+        M_CALL_FREE_CTX(oplist, tree->allocator, struct M_C(name, _node_s),   \
+                        tab-1, alloc+1);                                      \
+        tree->tab = ptr;                                                      \
+        M_TR33_CONTRACT(tree);                                                \
+    }                                                                         \
+                                                                              \
+    /* Test if the nodes are stored in pre-order (read-only fast path) */     \
+    static inline bool                                                        \
+    M_C(name, _compact_p)(const tree_t tree) {                                \
+        M_TR33_CONTRACT(tree);                                                \
+        return tree->compact;                                                 \
+    }                                                                         \
+                                                                              \
+    /* Reduce the sub-tree of 'index' in post-order (see _reduce_postorder),  \
+       without combining it into its parent */                                \
+    static inline void                                                        \
+    M_C3(m_tr33_,name,_reduce_sub)(struct M_C(name, _node_s) *tab,            \
+                                   m_tr33_index_t index,                      \
+                                   M_C(name, _leaf_cb_ct) leaf,               \
+                                   M_C(name, _combine_cb_ct) combine) {       \
+        m_tr33_index_t i = index;                                             \
+        if (leaf != NULL) leaf(&tab[i].data);                                 \
+        while (true) {                                                        \
+            /* Go down to the first leaf */                                   \
+            while (tab[i].child >= 0) {                                       \
+                i = tab[i].child;                                             \
+                if (leaf != NULL) leaf(&tab[i].data);                         \
+            }                                                                 \
+            /* The node is reduced: combine it, then go right or up */        \
+            while (true) {                                                    \
+                if (i == index) return;                                       \
+                m_tr33_index_t p = tab[i].parent;                             \
+                combine(&tab[p].data, M_CONST_CAST(type, &tab[i].data));      \
+                if (tab[i].right >= 0) {                                      \
+                    i = tab[i].right;                                         \
+                    if (leaf != NULL) leaf(&tab[i].data);                     \
+                    break;                                                    \
+                }                                                             \
+                i = p;                                                        \
+            }                                                                 \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    /* Visit the sub-tree of 'index' in pre-order (see _visit_preorder) */    \
+    static inline void                                                        \
+    M_C3(m_tr33_,name,_visit_sub)(struct M_C(name, _node_s) *tab,             \
+                                  m_tr33_index_t index,                       \
+                                  M_C(name, _visit_cb_ct) visit) {            \
+        m_tr33_index_t i = index;                                             \
+        while (true) {                                                        \
+            m_tr33_index_t p = tab[i].parent;                                 \
+            visit(&tab[i].data, p >= 0 ? M_CONST_CAST(type, &tab[p].data) : NULL); \
+            if (tab[i].child >= 0) {                                          \
+                i = tab[i].child;                                             \
+                continue;                                                     \
+            }                                                                 \
+            while (i != index && tab[i].right < 0) {                          \
+                i = tab[i].parent;                                            \
+            }                                                                 \
+            if (i == index) return;                                           \
+            i = tab[i].right;                                                 \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    /* Reduce the tree bottom-up: for each node, 'leaf' (if not NULL)         \
+       is called on the node, then the node is combined by 'combine'          \
+       into its parent once all its children have been combined into it.      \
+       The callbacks shall not modify the structure of the tree. */           \
+    static inline void                                                        \
+    M_C(name, _reduce_postorder)(tree_t tree, M_C(name, _leaf_cb_ct) leaf,    \
+                                 M_C(name, _combine_cb_ct) combine) {         \
+        M_TR33_CONTRACT(tree);                                                \
+        M_ASSERT(combine != NULL);                                            \
+        if (tree->size > 0) {                                                 \
+            M_C3(m_tr33_,name,_reduce_sub)(tree->tab, tree->root_index, leaf, combine); \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    /* Visit the tree top-down: 'visit' is called on each node                \
+       with the data of its parent (or NULL for the root),                    \
+       after the parent has been visited.                                     \
+       The callback shall not modify the structure of the tree. */            \
+    static inline void                                                        \
+    M_C(name, _visit_preorder)(tree_t tree, M_C(name, _visit_cb_ct) visit) {  \
+        M_TR33_CONTRACT(tree);                                                \
+        M_ASSERT(visit != NULL);                                              \
+        if (tree->size > 0) {                                                 \
+            M_C3(m_tr33_,name,_visit_sub)(tree->tab, tree->root_index, visit); \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
     M_IF_METHOD(CMP,oplist)(                                                  \
     static inline void                                                        \
     M_C(name, _sort_child)(it_t it0) {                                        \
@@ -1092,19 +1331,23 @@ typedef int32_t m_tr33_index_t;
 
 /* Define the classic missing methods of a tree */
 #define M_TR33_DEF_P4_CLASSIC(name, type, oplist, tree_t, it_t)               \
+    /* Copy the tree 'ref' into the uninitialized 'tree'                      \
+       (except its allocator which is already set) */                         \
     static inline void                                                        \
-    M_C(name, _init_set)(tree_t tree, const tree_t ref) {                     \
+    M_C3(m_tr33_, name, _copy)(tree_t tree, const tree_t ref) {               \
         tree->size = ref->size;                                               \
         tree->capacity = ref->capacity;                                       \
         tree->root_index = ref->root_index;                                   \
         tree->free_index = ref->free_index;                                   \
         tree->allow_realloc = ref->allow_realloc;                             \
+        tree->compact = ref->compact;                                         \
         size_t alloc = (size_t) ref->capacity;                                \
         if (ref->tab == NULL) {                                               \
             tree->tab = NULL;                                                 \
         } else {                                                              \
             struct M_C(name, _node_s) *ptr =                                  \
-                M_CALL_REALLOC(oplist, struct M_C(name, _node_s), NULL, alloc+1); \
+                M_CALL_REALLOC_CTX(oplist, tree->allocator, struct M_C(name, _node_s), \
+                                   NULL, 0, alloc+1);                         \
             if (M_UNLIKELY (ptr == NULL) ) {                                  \
                 M_MEMORY_FULL(sizeof(struct M_C(name, _node_s)) * alloc);     \
                 return;                                                       \
@@ -1126,10 +1369,18 @@ typedef int32_t m_tr33_index_t;
     }                                                                         \
                                                                               \
     static inline void                                                        \
+    M_C(name, _init_set)(tree_t tree, const tree_t ref) {                     \
+        M_IF_METHOD(ALLOCATOR, oplist)(tree->allocator = ref->allocator;, )   \
+        M_C3(m_tr33_, name, _copy)(tree, ref);                                \
+    }                                                                         \
+                                                                              \
+    static inline void                                                        \
     M_C(name, _set)(tree_t tree, const tree_t ref) {                          \
         /* No optimum, but good enought for present time */                   \
+        if (M_UNLIKELY (tree == ref)) return;                                 \
         M_C(name, _clear)(tree);                                              \
-        M_C(name, _init_set)(tree, ref);                                      \
+        /* Keep the allocator of the tree */                                  \
+        M_C3(m_tr33_, name, _copy)(tree, ref);                                \
     }                                                                         \
                                                                               \
     static inline void                                                        \
@@ -1139,7 +1390,9 @@ typedef int32_t m_tr33_index_t;
         tree->root_index = ref->root_index;                                   \
         tree->free_index = ref->free_index;                                   \
         tree->allow_realloc = ref->allow_realloc;                             \
+        tree->compact = ref->compact;                                         \
         tree->tab = ref->tab;                                                 \
+        M_IF_METHOD(ALLOCATOR, oplist)(tree->allocator = ref->allocator;, )   \
         /* This is so reusing the object implies an assertion failure */      \
         ref->size = 1;                                                        \
         ref->tab = NULL;                                                      \
@@ -1160,7 +1413,9 @@ typedef int32_t m_tr33_index_t;
         M_SWAP(m_tr33_index_t, tree1->root_index, tree2->root_index);         \
         M_SWAP(m_tr33_index_t, tree1->free_index, tree2->free_index);         \
         M_SWAP(unsigned, tree1->allow_realloc, tree2->allow_realloc);         \
+        M_SWAP(bool, tree1->compact, tree2->compact);                         \
         M_SWAP(M_C(name, _node_ct) *, tree1->tab, tree2->tab);                \
+        M_IF_METHOD(ALLOCATOR, oplist)(M_SWAP(const m_allocator_t *, tree1->allocator, tree2->allocator);, ) \
         M_TR33_CONTRACT(tree1);                                               \
         M_TR33_CONTRACT(tree2);                                               \
     }                                                                         \
@@ -1459,6 +1714,162 @@ exit:                                                                         \
 }                                                                             \
 , /* No IN_STR */ )                                                           \
 
+/* Definition of the parallel reduce and visit of a tree
+   (only if m-worker.h is included, see below) */
+#define M_TR33_DEF_PARALLEL(name, type, oplist, tree_t, it_t)                 \
+                                                                              \
+    /* A parallel task: 'num' consecutive sibling sub-trees starting at 'first', \
+       or a node handled by the calling thread if 'split' is true */          \
+    typedef struct M_C3(m_tr33_,name,_task_s) {                               \
+        struct M_C(name, _node_s) *tab;                                       \
+        m_tr33_index_t             first;                                     \
+        m_tr33_index_t             num;                                       \
+        size_t                     weight; /* Estimated number of nodes */    \
+        bool                       split;                                     \
+        M_C(name, _leaf_cb_ct)     leaf;                                      \
+        M_C(name, _combine_cb_ct)  combine;                                   \
+        M_C(name, _visit_cb_ct)    visit;                                     \
+    } M_C3(m_tr33_,name,_task_ct);                                            \
+                                                                              \
+    /* Entry point of a task performed by a worker */                         \
+    static inline void                                                        \
+    M_C3(m_tr33_,name,_parallel_task)(void *arg) {                            \
+        M_C3(m_tr33_,name,_task_ct) *t = M_ASSIGN_CAST(M_C3(m_tr33_,name,_task_ct) *, arg); \
+        m_tr33_index_t i = t->first;                                          \
+        for(m_tr33_index_t n = 0; n < t->num; n++) {                          \
+            if (t->visit != NULL) {                                           \
+                M_C3(m_tr33_,name,_visit_sub)(t->tab, i, t->visit);           \
+            } else {                                                          \
+                M_C3(m_tr33_,name,_reduce_sub)(t->tab, i, t->leaf, t->combine); \
+            }                                                                 \
+            i = t->tab[i].right;                                              \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    /* Perform the reduce (if combine is not NULL) or the visit of the tree.  \
+       The calling thread handles the first levels of the tree and            \
+       dispatches the sub-trees below them as tasks to the workers.           \
+       A task owns all the nodes of its sub-trees, and the calling thread     \
+       combines the results of the tasks once they are all done:              \
+       no lock is needed. */                                                  \
+    static inline void                                                        \
+    M_C3(m_tr33_,name,_parallel_run)(tree_t tree, m_worker_t workers,         \
+                                     M_C(name, _leaf_cb_ct) leaf,             \
+                                     M_C(name, _combine_cb_ct) combine,       \
+                                     M_C(name, _visit_cb_ct) visit) {         \
+        M_C3(m_tr33_,name,_task_ct) tab[M_TR33_PARALLEL_MAX_TASK];            \
+        m_worker_sync_t block;                                                \
+        (void) workers; /* Unused if M_USE_WORKER is 0 */                     \
+        if (tree->size == 0) return;                                          \
+        struct M_C(name, _node_s) *node = tree->tab;                          \
+        /* Get enough tasks to feed all the workers */                        \
+        const size_t target = M_MIN(4 * (size_t) m_worker_count(workers),     \
+                                    (size_t) M_TR33_PARALLEL_MAX_TASK);       \
+        size_t num = 1;                                                       \
+        tab[0].tab     = node;                                                \
+        tab[0].first   = tree->root_index;                                    \
+        tab[0].num     = 1;                                                   \
+        tab[0].weight  = (size_t) tree->size;                                 \
+        tab[0].split   = false;                                               \
+        tab[0].leaf    = leaf;                                                \
+        tab[0].combine = combine;                                             \
+        tab[0].visit   = visit;                                               \
+        /* Split the first levels in the calling thread (parents before childs) */ \
+        for(size_t k = 0; k < num; k++) {                                     \
+            const m_tr33_index_t i = tab[k].first;                            \
+            if (tab[k].num != 1 || num >= target || node[i].child < 0         \
+                || tab[k].weight < 2 * M_TR33_PARALLEL_GRAIN) {               \
+                continue;                                                     \
+            }                                                                 \
+            tab[k].split = true;                                              \
+            if (visit != NULL) {                                              \
+                const m_tr33_index_t p = node[i].parent;                      \
+                visit(&node[i].data, p >= 0 ? M_CONST_CAST(type, &node[p].data) : NULL); \
+            } else if (leaf != NULL) {                                        \
+                leaf(&node[i].data);                                          \
+            }                                                                 \
+            /* Dispatch the children in 'm' runs of consecutive siblings */   \
+            size_t c = 0;                                                     \
+            for(m_tr33_index_t j = node[i].child; j >= 0; j = node[j].right) { \
+                c++;                                                          \
+            }                                                                 \
+            const size_t m = M_MIN(c, target - num);                          \
+            m_tr33_index_t j = node[i].child;                                 \
+            for(size_t r = 0; r < m; r++, num++) {                            \
+                const size_t cnt = c / m + (r < c % m);                       \
+                tab[num] = tab[k];                                            \
+                tab[num].split = false;                                       \
+                tab[num].first = j;                                           \
+                tab[num].num   = (m_tr33_index_t) cnt;                        \
+                m_tr33_index_t last = j;                                      \
+                for(size_t n = 0; n < cnt; n++) {                             \
+                    last = j;                                                 \
+                    j = node[j].right;                                        \
+                }                                                             \
+                if (tree->compact) {                                          \
+                    /* The sub-trees of the run are stored contiguously */    \
+                    while (last >= 0 && node[last].right < 0) {               \
+                        last = node[last].parent;                             \
+                    }                                                         \
+                    const m_tr33_index_t end = last < 0 ? tree->size : node[last].right; \
+                    tab[num].weight = (size_t) (end - tab[num].first);        \
+                } else {                                                      \
+                    tab[num].weight = tab[k].weight / c * cnt;                \
+                }                                                             \
+            }                                                                 \
+        }                                                                     \
+        /* Dispatch the large tasks to the workers,                           \
+           and perform the small ones in the calling thread */                \
+        m_worker_start(block, workers);                                       \
+        for(size_t k = 1; k < num; k++) {                                     \
+            if (!tab[k].split && tab[k].weight >= M_TR33_PARALLEL_GRAIN) {    \
+                m_worker_spawn(block, M_C3(m_tr33_,name,_parallel_task), &tab[k]); \
+            }                                                                 \
+        }                                                                     \
+        for(size_t k = 0; k < num; k++) {                                     \
+            if (!tab[k].split && (k == 0 || tab[k].weight < M_TR33_PARALLEL_GRAIN)) { \
+                M_C3(m_tr33_,name,_parallel_task)(&tab[k]);                   \
+            }                                                                 \
+        }                                                                     \
+        m_worker_sync(block);                                                 \
+        if (combine == NULL) return;                                          \
+        /* Combine the split nodes (childs before parents) */                 \
+        for(size_t k = num; k-- > 0; ) {                                      \
+            if (tab[k].split) {                                               \
+                const m_tr33_index_t i = tab[k].first;                        \
+                for(m_tr33_index_t j = node[i].child; j >= 0; j = node[j].right) { \
+                    combine(&node[i].data, M_CONST_CAST(type, &node[j].data));    \
+                }                                                             \
+            }                                                                 \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    /* Same as _reduce_postorder, using the workers for large trees.          \
+       The callbacks are called concurrently on different sub-trees */        \
+    static inline void                                                        \
+    M_C(name, _parallel_reduce_postorder)(tree_t tree, m_worker_t workers,    \
+                                          M_C(name, _leaf_cb_ct) leaf,        \
+                                          M_C(name, _combine_cb_ct) combine) { \
+        M_TR33_CONTRACT(tree);                                                \
+        M_ASSERT(combine != NULL);                                            \
+        M_C3(m_tr33_,name,_parallel_run)(tree, workers, leaf, combine, NULL); \
+        M_TR33_CONTRACT(tree);                                                \
+    }                                                                         \
+                                                                              \
+    /* Same as _visit_preorder, using the workers for large trees.            \
+       The callback is called concurrently on different sub-trees */          \
+    static inline void                                                        \
+    M_C(name, _parallel_visit_preorder)(tree_t tree, m_worker_t workers,      \
+                                        M_C(name, _visit_cb_ct) visit) {      \
+        M_TR33_CONTRACT(tree);                                                \
+        M_ASSERT(visit != NULL);                                              \
+        M_C3(m_tr33_,name,_parallel_run)(tree, workers, NULL, NULL, visit);   \
+        M_TR33_CONTRACT(tree);                                                \
+    }
+
+/* The parallel reduce and visit are not defined by default */
+#define M_TR33_DEF_PARALLEL_P(...)
+
 // TODO: 
 // * emplace insertion
 // * Allocate one more "spare" member in the array (alloc is capacity+1),
@@ -1472,3 +1883,10 @@ exit:                                                                         \
 #endif
 
 #endif
+
+// NOTE: Define the parallel reduce and visit only if m-worker has been included
+#if !defined(MSTARLIB_TREE_WORKER_H) && defined(MSTARLIB_WORKER_H)
+#define MSTARLIB_TREE_WORKER_H
+#undef  M_TR33_DEF_PARALLEL_P
+#define M_TR33_DEF_PARALLEL_P M_TR33_DEF_PARALLEL
+#endif
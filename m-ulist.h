@@ -0,0 +1,887 @@
+/*
+ * M*LIB - UNROLLED LIST module
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef MSTARLIB_ULIST_H
+#define MSTARLIB_ULIST_H
+
+#include "m-list.h"
+
+/* Define an unrolled list of a given type.
+   It has the same interface and semantics as a dual push list,
+   but several elements are stored in each node.
+   USAGE: ULIST_DEF(name, type [, oplist_of_the_type]) */
+#define M_ULIST_DEF(name, ...)                                                \
+  M_ULIST_DEF_AS(name, M_C(name, _t), M_C(name, _it_t), __VA_ARGS__)
+
+
+/* Define an unrolled list of a given type
+   as the provided type name_t with the iterator named it_t
+   USAGE: ULIST_DEF_AS(name, name_t, it_t, type [, oplist_of_the_type]) */
+#define M_ULIST_DEF_AS(name, name_t, it_t, ...)                               \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_UL1ST_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                                  \
+                ((name, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)(), name_t, it_t ), \
+                 (name, __VA_ARGS__,                                        name_t, it_t ))) \
+  M_END_PROTECTED_CODE
+
+
+/* Define the oplist of an unrolled list of the given type.
+   USAGE: ULIST_OPLIST(name [, oplist_of_the_type]) */
+#define M_ULIST_OPLIST(...)                                                   \
+  M_UL1ST_OPLIST_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                               \
+                   ((__VA_ARGS__, M_BASIC_OPLIST ),                           \
+                    (__VA_ARGS__ )))
+
+/* Define an init value to init global variables of type unrolled list.
+  USAGE:
+    list_t global_variable = ULIST_INIT_VALUE();
+ */
+#define M_ULIST_INIT_VALUE()                                                  \
+  { { NULL, NULL, 0 } }
+
+/* Size in bytes of the elements stored in a node of an unrolled list
+   (at least 4 elements are stored in a node) */
+#ifndef M_USE_ULIST_NODE_SIZE
+#define M_USE_ULIST_NODE_SIZE 256
+#endif
+
+
+/********************************** INTERNAL ************************************/
+
+/* Number of elements stored in a node */
+#define M_UL1ST_NUM(type)                                                     \
+  (M_USE_ULIST_NODE_SIZE / sizeof (type) < 4 ? (size_t) 4                    \
+   : (size_t) (M_USE_ULIST_NODE_SIZE / sizeof (type)))
+
+/* Deferred evaluation for the oplist definition,
+   so that all arguments are evaluated before further expansion */
+#define M_UL1ST_OPLIST_P1(arg) M_UL1ST_OPLIST_P2 arg
+
+/* Validation of the given oplist */
+#define M_UL1ST_OPLIST_P2(name, oplist)                                       \
+  M_IF_OPLIST(oplist)(M_UL1ST_OPLIST_P3, M_UL1ST_OPLIST_FAILURE)(name, oplist)
+
+/* Prepare a clean compilation failure */
+#define M_UL1ST_OPLIST_FAILURE(name, oplist)                                  \
+  ((M_LIB_ERROR(ARGUMENT_OF_ULIST_OPLIST_IS_NOT_AN_OPLIST, name, oplist)))
+
+/* OPLIST definition of an unrolled list (same as a list) */
+#define M_UL1ST_OPLIST_P3(name, oplist)                                       \
+  (INIT(M_C(name, _init)),                                                    \
+   INIT_SET(M_C(name, _init_set)),                                            \
+   INIT_WITH(API_1(M_INIT_WITH_VAI)),                                         \
+   SET(M_C(name, _set)),                                                      \
+   CLEAR(M_C(name, _clear)),                                                  \
+   MOVE(M_C(name, _move)),                                                    \
+   INIT_MOVE(M_C(name, _init_move)),                                          \
+   SWAP(M_C(name, _swap)),                                                    \
+   NAME(name),                                                                \
+   TYPE(M_C(name,_ct)),                                                       \
+   SUBTYPE(M_C(name,_subtype_ct)),                                            \
+   EMPTY_P(M_C(name,_empty_p)),                                               \
+   GET_SIZE(M_C(name,_size)),                                                 \
+   IT_TYPE(M_C(name, _it_ct)),                                                \
+   IT_FIRST(M_C(name,_it)),                                                   \
+   IT_END(M_C(name,_it_end)),                                                 \
+   IT_SET(M_C(name,_it_set)),                                                 \
+   IT_END_P(M_C(name,_end_p)),                                                \
+   IT_EQUAL_P(M_C(name,_it_equal_p)),                                         \
+   IT_LAST_P(M_C(name,_last_p)),                                              \
+   IT_NEXT(M_C(name,_next)),                                                  \
+   IT_REF(M_C(name,_ref)),                                                    \
+   IT_CREF(M_C(name,_cref)),                                                  \
+   IT_INSERT(M_C(name, _insert)),                                             \
+   IT_REMOVE(M_C(name,_remove)),                                              \
+   RESET(M_C(name,_reset)),                                                   \
+   PUSH(M_C(name,_push_back)),                                                \
+   POP(M_C(name,_pop_back)),                                                  \
+   PUSH_MOVE(M_C(name,_push_move)),                                           \
+   POP_MOVE(M_C(name,_pop_move))                                              \
+   ,SPLICE_BACK(M_C(name,_splice_back))                                       \
+   ,SPLICE_AT(M_C(name,_splice_at))                                           \
+   ,REVERSE(M_C(name,_reverse))                                               \
+   ,OPLIST(oplist)                                                            \
+   ,M_IF_METHOD(GET_STR, oplist)(GET_STR(M_C(name, _get_str)),)               \
+   ,M_IF_METHOD(OUT_STR, oplist)(OUT_STR(M_C(name, _out_str)),)               \
+   ,M_IF_METHOD(PARSE_STR, oplist)(PARSE_STR(M_C(name, _parse_str)),)         \
+   ,M_IF_METHOD(IN_STR, oplist)(IN_STR(M_C(name, _in_str)),)                  \
+   ,M_IF_METHOD(OUT_SERIAL, oplist)(OUT_SERIAL(M_C(name, _out_serial)),)      \
+   ,M_IF_METHOD(IN_SERIAL, oplist)(IN_SERIAL(M_C(name, _in_serial)),)         \
+   ,M_IF_METHOD(EQUAL, oplist)(EQUAL(M_C(name, _equal_p)),)                   \
+   ,M_IF_METHOD(HASH, oplist)(HASH(M_C(name, _hash)),)                        \
+   ,M_IF_METHOD(NEW, oplist)(NEW(M_GET_NEW oplist),)                          \
+   ,M_IF_METHOD(REALLOC, oplist)(REALLOC(M_GET_REALLOC oplist),)              \
+   ,M_IF_METHOD(DEL, oplist)(DEL(M_GET_DEL oplist),)                          \
+   )
+
+/* Deferred evaluation for the unrolled list definition,
+   so that all arguments are evaluated before further expansion */
+#define M_UL1ST_DEF_P1(arg) M_ID( M_UL1ST_DEF_P2 arg )
+
+/* Validate the oplist before going further */
+#define M_UL1ST_DEF_P2(name, type, oplist, list_t, it_t)                      \
+  M_IF_OPLIST(oplist)(M_UL1ST_DEF_P3, M_UL1ST_DEF_FAILURE)(name, type, oplist, list_t, it_t)
+
+/* Stop processing with a compilation failure */
+#define M_UL1ST_DEF_FAILURE(name, type, oplist, list_t, it_t)                 \
+  M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(ULIST_DEF): the given argument is not a valid oplist: " #oplist)
+
+/* Internal unrolled list definition
+   - name: prefix to be used
+   - type: type of the elements of the list
+   - oplist: oplist of the type of the elements of the container
+   - list_t: alias for M_C(name, _t) [ type of the container ]
+   - it_t: alias for M_C(name, _it_t) [ iterator of the container ]
+ */
+#define M_UL1ST_DEF_P3(name, type, oplist, list_t, it_t)                      \
+                                                                              \
+  /* Node of an unrolled list.                                                \
+     The elements of the node are stored in data[first .. first+num[          \
+     in the order of iteration. A node of the list is never empty. */         \
+  struct M_C(name, _s) {                                                      \
+    struct M_C(name, _s) *next;  /* Next node (toward the front) or NULL */   \
+    struct M_C(name, _s) *prev;  /* Previous node (toward the back) or NULL */ \
+    size_t first;                /* Index of the first element in data */     \
+    size_t num;                  /* Number of elements in data */             \
+    type data[M_UL1ST_NUM(type)];                                             \
+  };                                                                          \
+                                                                              \
+  /* Unrolled list.                                                           \
+     Support Push Back / Push Front / Pop Back / Pop Front in O(1).           \
+     The iteration starts from the back node, like a dual push list. */       \
+  typedef struct M_C(name, _head_s)  {                                        \
+    struct M_C(name,_s) *back;  /* Pointer to the back node or NULL */        \
+    struct M_C(name,_s) *front; /* Pointer to the front node or NULL */       \
+    size_t size;                /* Number of elements in the list */          \
+    M_ALL0CATOR_FIELD(oplist)   /* Allocator (if ALLOCATOR method) */         \
+  } list_t[1];                                                                \
+                                                                              \
+  /* Define the iterator over an unrolled list:                               \
+     the node and the index of the element in its data,                       \
+     or a NULL node for the end of the list */                                \
+  typedef struct M_C(name, _it_s) {                                           \
+    struct M_C(name, _s) *node;                                               \
+    size_t                index;                                              \
+  } it_t[1];                                                                  \
+                                                                              \
+  /* Definition of the synonyms of the type */                                \
+  typedef struct M_C(name, _head_s) *M_C(name, _ptr);                         \
+  typedef const struct M_C(name, _head_s) *M_C(name, _srcptr);                \
+  typedef list_t M_C(name, _ct);                                              \
+  typedef it_t M_C(name, _it_ct);                                             \
+  typedef type M_C(name, _subtype_ct);                                        \
+                                                                              \
+  M_CHECK_COMPATIBLE_OPLIST(name, 1, type, oplist)                            \
+                                                                              \
+  M_L1ST_MEMPOOL_DEF(name, type, oplist, list_t, it_t)                        \
+  M_UL1ST_DEF_P4(name, type, oplist, list_t, it_t)                            \
+  M_L1ST_ITBASE_DEF(name, type, oplist, list_t, it_t)                         \
+
+
+/* Define the internal contract of an unrolled list */
+#define M_UL1ST_CONTRACT(l) do {                                              \
+    M_ASSERT (l != NULL);                                                     \
+    M_ASSERT ( (l->back == NULL) == (l->front == NULL) );                     \
+    M_ASSERT ( (l->back == NULL) == (l->size == 0) );                         \
+    M_ASSERT ( l->back == NULL || (l->back->prev == NULL && l->front->next == NULL) ); \
+  } while (0)
+
+/* Internal unrolled list definition
+   - name: prefix to be used
+   - type: type of the elements of the list
+   - oplist: oplist of the type of the elements of the container
+   - list_t: alias for type of the container
+   - it_t: alias for iterator of the container
+ */
+#define M_UL1ST_DEF_P4(name, type, oplist, list_t, it_t)                      \
+                                                                              \
+  /* Allocate a new node and link it after 'prev' (at the back if NULL) */    \
+  static inline struct M_C(name, _s) *                                        \
+  M_C3(m_ul1st_,name,_new_node)(list_t v, struct M_C(name, _s) *prev)         \
+  {                                                                           \
+    struct M_C(name, _s) *n = M_C3(m_l1st_,name,_new)(v);                     \
+    if (M_UNLIKELY (n == NULL)) {                                             \
+      M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                           \
+      return NULL;                                                            \
+    }                                                                         \
+    n->prev = prev;                                                           \
+    n->next = prev == NULL ? v->back : prev->next;                            \
+    if (n->next != NULL) {                                                    \
+      n->next->prev = n;                                                      \
+    } else {                                                                  \
+      v->front = n;                                                           \
+    }                                                                         \
+    if (prev != NULL) {                                                       \
+      prev->next = n;                                                         \
+    } else {                                                                  \
+      v->back = n;                                                            \
+    }                                                                         \
+    n->first = 0;                                                             \
+    n->num = 0;                                                               \
+    return n;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Unlink the node 'n' from the list and free it */                         \
+  static inline void                                                          \
+  M_C3(m_ul1st_,name,_del_node)(list_t v, struct M_C(name, _s) *n)            \
+  {                                                                           \
+    if (n->prev != NULL) {                                                    \
+      n->prev->next = n->next;                                                \
+    } else {                                                                  \
+      v->back = n->next;                                                      \
+    }                                                                         \
+    if (n->next != NULL) {                                                    \
+      n->next->prev = n->prev;                                                \
+    } else {                                                                  \
+      v->front = n->prev;                                                     \
+    }                                                                         \
+    M_C3(m_l1st_,name,_del)(v, n);                                            \
+  }                                                                           \
+                                                                              \
+  /* Move the elements of the node 'b' after the elements of the node 'a'     \
+     (b = a->next) and free 'b'. The elements of 'a' are not moved,           \
+     so that 'a' shall have enough room after its last element.               \
+     The iterator is updated */                                               \
+  static inline void                                                          \
+  M_C3(m_ul1st_,name,_merge)(list_t v, struct M_C(name, _s) *a, it_t it)      \
+  {                                                                           \
+    struct M_C(name, _s) *b = a->next;                                        \
+    M_ASSERT (b != NULL && a->first + a->num + b->num <= M_UL1ST_NUM(type));  \
+    if (it->node == b) {                                                      \
+      it->node = a;                                                           \
+      it->index = it->index - b->first + a->first + a->num;                   \
+    }                                                                         \
+    memcpy(&a->data[a->first + a->num], &b->data[b->first], b->num * sizeof (type)); \
+    a->num += b->num;                                                         \
+    M_C3(m_ul1st_,name,_del_node)(v, b);                                      \
+  }                                                                           \
+                                                                              \
+  /* Make the iterator point to the next node if it reached                   \
+     the end of its node */                                                   \
+  static inline void                                                          \
+  M_C3(m_ul1st_,name,_it_fix)(it_t it)                                        \
+  {                                                                           \
+    struct M_C(name, _s) *n = it->node;                                       \
+    if (n != NULL && it->index == n->first + n->num) {                        \
+      n = n->next;                                                            \
+      it->node = n;                                                           \
+      it->index = n == NULL ? 0 : n->first;                                   \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Remove the slot of the element referenced by 'it', which shall have      \
+     already been cleared or moved. 'it' is updated to the next element.      \
+     An underfull node absorbs its next node if it can.                       \
+     The elements before 'it' are never moved, so that the iterators          \
+     referencing them remain valid (needed by the generic algorithms). */     \
+  static inline void                                                          \
+  M_C3(m_ul1st_,name,_remove_raw)(list_t v, it_t it)                          \
+  {                                                                           \
+    struct M_C(name, _s) *n = it->node;                                       \
+    M_ASSERT (n != NULL && it->index >= n->first && it->index < n->first + n->num); \
+    const size_t pos = it->index;                                             \
+    const size_t left  = pos - n->first;                                      \
+    const size_t right = n->first + n->num - pos - 1;                         \
+    if (left == 0) {                                                          \
+      n->first++;                                                             \
+      it->index = pos + 1;                                                    \
+    } else {                                                                  \
+      memmove(&n->data[pos], &n->data[pos+1], right * sizeof (type));         \
+    }                                                                         \
+    n->num--;                                                                 \
+    v->size--;                                                                \
+    if (n->num == 0) {                                                        \
+      struct M_C(name, _s) *next = n->next;                                   \
+      M_C3(m_ul1st_,name,_del_node)(v, n);                                    \
+      it->node = next;                                                        \
+      it->index = next == NULL ? 0 : next->first;                             \
+      return;                                                                 \
+    }                                                                         \
+    if (n->num < M_UL1ST_NUM(type) / 4 && n->next != NULL                     \
+        && n->num + n->next->num <= M_UL1ST_NUM(type) / 2                     \
+        && n->first + n->num + n->next->num <= M_UL1ST_NUM(type)) {           \
+      M_C3(m_ul1st_,name,_merge)(v, n, it);                                   \
+    }                                                                         \
+    M_C3(m_ul1st_,name,_it_fix)(it);                                          \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init)(list_t v)                                                  \
+  {                                                                           \
+    M_ASSERT( v != NULL);                                                     \
+    v->back = NULL;                                                           \
+    v->front = NULL;                                                          \
+    v->size = 0;                                                              \
+    M_IF_METHOD(ALLOCATOR, oplist)(v->allocator = M_GET_ALLOCATOR oplist;, )  \
+    M_UL1ST_CONTRACT(v);                                                      \
+  }                                                                           \
+                                                                              \
+  M_L1ST_ALLOCATOR_DEF(name, oplist, list_t)                                  \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _reset)(list_t v)                                                 \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    struct M_C(name, _s) *it = v->back;                                       \
+    while (it != NULL) {                                                      \
+      struct M_C(name, _s) *next = it->next;                                  \
+      for(size_t i = it->first; i < it->first + it->num; i++) {               \
+        M_CALL_CLEAR(oplist, it->data[i]);                                    \
+      }                                                                       \
+      M_C3(m_l1st_,name,_del)(v, it);                                         \
+      it = next;                                                              \
+    }                                                                         \
+    v->back = NULL;                                                           \
+    v->front = NULL;                                                          \
+    v->size = 0;                                                              \
+    M_UL1ST_CONTRACT(v);                                                      \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _clear)(list_t v)                                                 \
+  {                                                                           \
+    M_C(name, _reset)(v);                                                     \
+  }                                                                           \
+                                                                              \
+  static inline type *                                                        \
+  M_C(name, _back)(const list_t v)                                            \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    M_ASSERT (v->back != NULL);                                               \
+    return &(v->back->data[v->back->first]);                                  \
+  }                                                                           \
+                                                                              \
+  static inline type *                                                        \
+  M_C(name, _front)(const list_t v)                                           \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    M_ASSERT (v->front != NULL);                                              \
+    return &(v->front->data[v->front->first + v->front->num - 1]);            \
+  }                                                                           \
+                                                                              \
+  static inline type *                                                        \
+  M_C(name, _push_back_raw)(list_t v)                                         \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    struct M_C(name, _s) *n = v->back;                                        \
+    if (M_UNLIKELY (n == NULL || n->first == 0)) {                            \
+      if (n != NULL && n->num < M_UL1ST_NUM(type)) {                          \
+        /* Move the elements at the end of the node */                        \
+        const size_t first = M_UL1ST_NUM(type) - n->num;                      \
+        memmove(&n->data[first], &n->data[0], n->num * sizeof (type));        \
+        n->first = first;                                                     \
+      } else {                                                                \
+        n = M_C3(m_ul1st_,name,_new_node)(v, NULL);                           \
+        if (M_UNLIKELY (n == NULL)) return NULL;                              \
+        n->first = M_UL1ST_NUM(type);                                         \
+      }                                                                       \
+    }                                                                         \
+    n->first--;                                                               \
+    n->num++;                                                                 \
+    v->size++;                                                                \
+    M_UL1ST_CONTRACT(v);                                                      \
+    return &n->data[n->first];                                                \
+  }                                                                           \
+                                                                              \
+  /* Internal, for INIT_WITH */                                               \
+  static inline type *                                                        \
+  M_C(name, _push_raw)(list_t d)                                              \
+  {                                                                           \
+    return M_C(name, _push_back_raw)(d);                                      \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _push_back)(list_t v, type const x)                               \
+  {                                                                           \
+    type *data = M_C(name, _push_back_raw)(v);                                \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return;                                                                 \
+    M_CALL_INIT_SET(oplist, *data, x);                                        \
+  }                                                                           \
+                                                                              \
+  M_IF_METHOD(INIT, oplist)(                                                  \
+  static inline type *                                                        \
+  M_C(name, _push_back_new)(list_t v)                                         \
+  {                                                                           \
+    type *data = M_C(name, _push_back_raw)(v);                                \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return NULL;                                                            \
+    M_CALL_INIT(oplist, *data);                                               \
+    return data;                                                              \
+  }                                                                           \
+  , /* No INIT */ )                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _push_back_move)(list_t v, type *x)                               \
+  {                                                                           \
+    M_ASSERT (x != NULL);                                                     \
+    type *data = M_C(name, _push_back_raw)(v);                                \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return;                                                                 \
+    M_DO_INIT_MOVE (oplist, *data, *x);                                       \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _push_move)(list_t v, type *x)                                    \
+  {                                                                           \
+    M_C(name, _push_back_move)(v, x);                                         \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _pop_back)(type *data, list_t v)                                  \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    M_ASSERT (v->back != NULL);                                               \
+    struct M_C(name, _s) *n = v->back;                                        \
+    if (data != NULL) {                                                       \
+      M_DO_MOVE(oplist, *data, n->data[n->first]);                            \
+    } else {                                                                  \
+      M_CALL_CLEAR(oplist, n->data[n->first]);                                \
+    }                                                                         \
+    n->first++;                                                               \
+    n->num--;                                                                 \
+    v->size--;                                                                \
+    if (n->num == 0) {                                                        \
+      M_C3(m_ul1st_,name,_del_node)(v, n);                                    \
+    }                                                                         \
+    M_UL1ST_CONTRACT(v);                                                      \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _pop_move)(type *data, list_t v)                                  \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    M_ASSERT (v->back != NULL);                                               \
+    M_ASSERT (data != NULL);                                                  \
+    struct M_C(name, _s) *n = v->back;                                        \
+    M_DO_INIT_MOVE (oplist, *data, n->data[n->first]);                        \
+    n->first++;                                                               \
+    n->num--;                                                                 \
+    v->size--;                                                                \
+    if (n->num == 0) {                                                        \
+      M_C3(m_ul1st_,name,_del_node)(v, n);                                    \
+    }                                                                         \
+    M_UL1ST_CONTRACT(v);                                                      \
+  }                                                                           \
+                                                                              \
+  static inline type *                                                        \
+  M_C(name, _push_front_raw)(list_t v)                                        \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    struct M_C(name, _s) *n = v->front;                                       \
+    if (M_UNLIKELY (n == NULL || n->first + n->num == M_UL1ST_NUM(type))) {   \
+      if (n != NULL && n->num < M_UL1ST_NUM(type)) {                          \
+        /* Move the elements at the beginning of the node */                  \
+        memmove(&n->data[0], &n->data[n->first], n->num * sizeof (type));     \
+        n->first = 0;                                                         \
+      } else {                                                                \
+        n = M_C3(m_ul1st_,name,_new_node)(v, v->front);                       \
+        if (M_UNLIKELY (n == NULL)) return NULL;                              \
+      }                                                                       \
+    }                                                                         \
+    type *ret = &n->data[n->first + n->num];                                  \
+    n->num++;                                                                 \
+    v->size++;                                                                \
+    M_UL1ST_CONTRACT(v);                                                      \
+    return ret;                                                               \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _push_front)(list_t v, type const x)                              \
+  {                                                                           \
+    type *data = M_C(name, _push_front_raw)(v);                               \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return;                                                                 \
+    M_CALL_INIT_SET(oplist, *data, x);                                        \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _push_front_move)(list_t v, type *x)                              \
+  {                                                                           \
+    M_ASSERT (x != NULL);                                                     \
+    type *data = M_C(name, _push_front_raw)(v);                               \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return;                                                                 \
+    M_DO_INIT_MOVE (oplist, *data, *x);                                       \
+  }                                                                           \
+                                                                              \
+  M_IF_METHOD(INIT, oplist)(                                                  \
+  static inline type *                                                        \
+  M_C(name, _push_front_new)(list_t v)                                        \
+  {                                                                           \
+    type *data = M_C(name, _push_front_raw)(v);                               \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return NULL;                                                            \
+    M_CALL_INIT(oplist, *data);                                               \
+    return data;                                                              \
+  }                                                                           \
+  , /* No INIT */)                                                            \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _pop_front)(type *data, list_t v)                                 \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    M_ASSERT (v->front != NULL);                                              \
+    struct M_C(name, _s) *n = v->front;                                       \
+    const size_t i = n->first + n->num - 1;                                   \
+    if (data != NULL) {                                                       \
+      M_DO_MOVE(oplist, *data, n->data[i]);                                   \
+    } else {                                                                  \
+      M_CALL_CLEAR(oplist, n->data[i]);                                       \
+    }                                                                         \
+    n->num--;                                                                 \
+    v->size--;                                                                \
+    if (n->num == 0) {                                                        \
+      M_C3(m_ul1st_,name,_del_node)(v, n);                                    \
+    }                                                                         \
+    M_UL1ST_CONTRACT(v);                                                      \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _empty_p)(const list_t v)                                         \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    return v->back == NULL;                                                   \
+  }                                                                           \
+                                                                              \
+  static inline size_t                                                        \
+  M_C(name, _size)(const list_t v)                                            \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    return v->size;                                                           \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _swap)(list_t l, list_t v)                                        \
+  {                                                                           \
+    M_UL1ST_CONTRACT(l);                                                      \
+    M_UL1ST_CONTRACT(v);                                                      \
+    M_SWAP(struct M_C(name, _s) *, l->front, v->front);                       \
+    M_SWAP(struct M_C(name, _s) *, l->back, v->back);                         \
+    M_SWAP(size_t, l->size, v->size);                                         \
+    M_IF_METHOD(ALLOCATOR, oplist)(M_SWAP(const m_allocator_t *, l->allocator, v->allocator);, ) \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it)(it_t it, const list_t v)                                     \
+  {                                                                           \
+    M_UL1ST_CONTRACT(v);                                                      \
+    M_ASSERT (it != NULL);                                                    \
+    it->node  = v->back;                                                      \
+    it->index = v->back == NULL ? 0 : v->back->first;                         \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it_set)(it_t it1, const it_t it2)                                \
+  {                                                                           \
+    M_ASSERT (it1 != NULL && it2 != NULL);                                    \
+    it1->node  = it2->node;                                                   \
+    it1->index = it2->index;                                                  \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _it_end)(it_t it1, const list_t v)                                \
+  {                                                                           \
+    M_ASSERT (it1 != NULL);                                                   \
+    M_UL1ST_CONTRACT(v);                                                      \
+    (void)v; /* unused */                                                     \
+    it1->node  = NULL;                                                        \
+    it1->index = 0;                                                           \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _end_p)(const it_t it)                                            \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    return it->node == NULL;                                                  \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _last_p)(const it_t it)                                           \
+  {                                                                           \
+    M_ASSERT (it != NULL);                                                    \
+    return it->node == NULL                                                   \
+      || (it->node->next == NULL                                              \
+          && it->index + 1 == it->node->first + it->node->num);               \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _next)(it_t it)                                                   \
+  {                                                                           \
+    M_ASSERT(it != NULL && it->node != NULL);                                 \
+    it->index++;                                                              \
+    M_C3(m_ul1st_,name,_it_fix)(it);                                          \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _it_equal_p)(const it_t it1, const it_t it2)                      \
+  {                                                                           \
+    M_ASSERT(it1 != NULL && it2 != NULL);                                     \
+    return it1->node == it2->node && it1->index == it2->index;                \
+  }                                                                           \
+                                                                              \
+  static inline type *                                                        \
+  M_C(name, _ref)(const it_t it)                                              \
+  {                                                                           \
+    M_ASSERT(it != NULL && it->node != NULL);                                 \
+    M_ASSERT(it->index - it->node->first < it->node->num);                    \
+    return &(it->node->data[it->index]);                                      \
+  }                                                                           \
+                                                                              \
+  static inline type const *                                                  \
+  M_C(name, _cref)(const it_t it)                                             \
+  {                                                                           \
+    return M_CONST_CAST(type, M_C(name, _ref)(it));                           \
+  }                                                                           \
+                                                                              \
+  /* Reserve the slot of a new element after the element referenced           \
+     by 'it' (or at the back of the list if 'it' is the end),                 \
+     and update 'it' to reference it.                                         \
+     The following elements of the node are shifted if there is some room,    \
+     otherwise the elements up to the insertion point are moved into a new    \
+     node, so that the following elements don't move. */                      \
+  static inline type *                                                        \
+  M_C3(m_ul1st_,name,_insert_raw)(list_t v, it_t it)                          \
+  {                                                                           \
+    struct M_C(name, _s) *n = it->node;                                       \
+    if (n == NULL) {                                                          \
+      n = v->back;                                                            \
+      if (n != NULL && n->first == 0 && n->num < M_UL1ST_NUM(type)) {         \
+        /* Shift by one only, unlike push_back which recenters the node,      \
+           so that the other iterators on this node remain usable */          \
+        memmove(&n->data[1], &n->data[0], n->num * sizeof (type));            \
+        n->first = 1;                                                         \
+      }                                                                       \
+      type *ret = M_C(name, _push_back_raw)(v);                               \
+      M_C(name, _it)(it, v);                                                  \
+      return ret;                                                             \
+    }                                                                         \
+    const size_t pos   = it->index;                                           \
+    const size_t end   = n->first + n->num;                                   \
+    const size_t left  = pos + 1 - n->first;                                  \
+    const size_t right = end - pos - 1;                                       \
+    size_t i;                                                                 \
+    if (end < M_UL1ST_NUM(type) && (right <= left || n->first == 0)) {        \
+      memmove(&n->data[pos+2], &n->data[pos+1], right * sizeof (type));       \
+      i = pos + 1;                                                            \
+    } else if (n->first > 0) {                                                \
+      memmove(&n->data[n->first-1], &n->data[n->first], left * sizeof (type)); \
+      n->first--;                                                             \
+      i = pos;                                                                \
+    } else if (right == 0) {                                                  \
+      /* Full node: insert at the beginning of the next node or in a new one */ \
+      if (n->next != NULL && n->next->first > 0) {                            \
+        n = n->next;                                                          \
+      } else {                                                                \
+        n = M_C3(m_ul1st_,name,_new_node)(v, n);                              \
+        if (M_UNLIKELY (n == NULL)) return NULL;                              \
+        n->first = M_UL1ST_NUM(type);                                         \
+      }                                                                       \
+      i = --n->first;                                                         \
+    } else {                                                                  \
+      /* Full node: split it */                                               \
+      struct M_C(name, _s) *p = M_C3(m_ul1st_,name,_new_node)(v, n->prev);    \
+      if (M_UNLIKELY (p == NULL)) return NULL;                                \
+      memcpy(&p->data[0], &n->data[0], left * sizeof (type));                 \
+      p->num = left;                                                          \
+      n->first = left;                                                        \
+      n->num -= left;                                                         \
+      n = p;                                                                  \
+      i = left;                                                               \
+    }                                                                         \
+    n->num++;                                                                 \
+    v->size++;                                                                \
+    it->node = n;                                                             \
+    it->index = i;                                                            \
+    return &n->data[i];                                                       \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _insert)(list_t list, it_t insertion_point,                       \
+                     type const x)                                            \
+  {                                                                           \
+    M_UL1ST_CONTRACT(list);                                                   \
+    M_ASSERT (insertion_point != NULL);                                       \
+    type *data = M_C3(m_ul1st_,name,_insert_raw)(list, insertion_point);      \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return;                                                                 \
+    M_CALL_INIT_SET(oplist, *data, x);                                        \
+    M_UL1ST_CONTRACT(list);                                                   \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _remove)(list_t list, it_t removing_point)                        \
+  {                                                                           \
+    M_UL1ST_CONTRACT(list);                                                   \
+    M_ASSERT (removing_point != NULL);                                        \
+    M_CALL_CLEAR(oplist, *M_C(name, _ref)(removing_point));                   \
+    M_C3(m_ul1st_,name,_remove_raw)(list, removing_point);                    \
+    M_UL1ST_CONTRACT(list);                                                   \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _set)(list_t list, const list_t org)                              \
+  {                                                                           \
+    M_UL1ST_CONTRACT(list);                                                   \
+    M_UL1ST_CONTRACT(org);                                                    \
+    if (M_UNLIKELY (list == org)) return;                                     \
+    M_C(name, _reset)(list);                                                  \
+    for(struct M_C(name, _s) *n = org->back; n != NULL; n = n->next) {        \
+      for(size_t i = n->first; i < n->first + n->num; i++) {                  \
+        type *data = M_C(name, _push_front_raw)(list);                        \
+        if (M_UNLIKELY (data == NULL))                                        \
+          return;                                                             \
+        M_CALL_INIT_SET(oplist, *data, n->data[i]);                           \
+      }                                                                       \
+    }                                                                         \
+    M_UL1ST_CONTRACT(list);                                                   \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init_set)(list_t list, const list_t org)                         \
+  {                                                                           \
+    M_ASSERT (list != org);                                                   \
+    M_C(name, _init)(list);                                                   \
+    M_IF_METHOD(ALLOCATOR, oplist)(list->allocator = org->allocator;, )       \
+    M_C(name, _set)(list, org);                                               \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init_move)(list_t list, list_t org)                              \
+  {                                                                           \
+    M_ASSERT (list != org);                                                   \
+    list->back  = org->back;                                                  \
+    list->front = org->front;                                                 \
+    list->size  = org->size;                                                  \
+    M_IF_METHOD(ALLOCATOR, oplist)(list->allocator = org->allocator;, )       \
+    org->back  = NULL;                                                        \
+    org->front = NULL;                                                        \
+    org->size  = 0;                                                           \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _move)(list_t list, list_t org)                                   \
+  {                                                                           \
+    M_C(name, _clear)(list);                                                  \
+    M_C(name, _init_move)(list, org);                                         \
+  }                                                                           \
+                                                                              \
+  /* Move the element referenced by 'it' from 'list2' to the back of 'list1'. \
+     'it' is updated to the next element of 'list2' */                        \
+  static inline void                                                          \
+  M_C(name, _splice_back)(list_t list1, list_t list2, it_t it)                \
+  {                                                                           \
+    M_UL1ST_CONTRACT(list1);                                                  \
+    M_UL1ST_CONTRACT(list2);                                                  \
+    M_ASSERT (it->node != NULL);                                              \
+    type tmp;                                                                 \
+    memcpy(&tmp, M_C(name, _ref)(it), sizeof (type));                         \
+    M_C3(m_ul1st_,name,_remove_raw)(list2, it);                               \
+    type *data = M_C(name, _push_back_raw)(list1);                            \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return;                                                                 \
+    memcpy(data, &tmp, sizeof (type));                                        \
+    M_UL1ST_CONTRACT(list1);                                                  \
+    M_UL1ST_CONTRACT(list2);                                                  \
+  }                                                                           \
+                                                                              \
+  /* Move the element referenced by 'opos' from 'olist' after 'npos'          \
+     in 'nlist'. 'opos' is updated to the next element of 'olist'             \
+     and 'npos' to the moved element */                                       \
+  static inline void                                                          \
+  M_C(name, _splice_at)(list_t nlist, it_t npos,                              \
+                        list_t olist, it_t opos)                              \
+  {                                                                           \
+    M_UL1ST_CONTRACT(nlist);                                                  \
+    M_UL1ST_CONTRACT(olist);                                                  \
+    M_ASSERT (npos != NULL && opos != NULL && opos->node != NULL);            \
+    type tmp;                                                                 \
+    memcpy(&tmp, M_C(name, _ref)(opos), sizeof (type));                       \
+    M_C3(m_ul1st_,name,_remove_raw)(olist, opos);                             \
+    type *data = M_C3(m_ul1st_,name,_insert_raw)(nlist, npos);                \
+    if (M_UNLIKELY (data == NULL))                                            \
+      return;                                                                 \
+    memcpy(data, &tmp, sizeof (type));                                        \
+    M_UL1ST_CONTRACT(nlist);                                                  \
+    M_UL1ST_CONTRACT(olist);                                                  \
+  }                                                                           \
+                                                                              \
+  /* Move all the elements of 'list2' after the ones of 'list1' in O(1) */    \
+  static inline void                                                          \
+  M_C(name, _splice)(list_t list1, list_t list2)                              \
+  {                                                                           \
+    M_UL1ST_CONTRACT(list1);                                                  \
+    M_UL1ST_CONTRACT(list2);                                                  \
+    M_ASSERT (list1 != list2);                                                \
+    M_L1ST_SAME_ALLOCATOR(oplist, list1, list2);                              \
+    if (M_UNLIKELY (list2->back == NULL)) return;                             \
+    if (M_LIKELY (list1->front != NULL)) {                                    \
+      list1->front->next = list2->back;                                       \
+      list2->back->prev  = list1->front;                                      \
+    } else {                                                                  \
+      /* list1 is empty */                                                    \
+      list1->back = list2->back;                                              \
+    }                                                                         \
+    list1->front = list2->front;                                              \
+    list1->size += list2->size;                                               \
+    list2->back  = NULL;                                                      \
+    list2->front = NULL;                                                      \
+    list2->size  = 0;                                                         \
+    M_UL1ST_CONTRACT(list1);                                                  \
+    M_UL1ST_CONTRACT(list2);                                                  \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _reverse)(list_t list)                                            \
+  {                                                                           \
+    M_UL1ST_CONTRACT(list);                                                   \
+    struct M_C(name, _s) *it = list->back;                                    \
+    while (it != NULL) {                                                      \
+      struct M_C(name, _s) *next = it->next;                                  \
+      /* Reverse the elements within the node */                              \
+      for(size_t i = it->first, j = it->first + it->num - 1; i < j; i++, j--) { \
+        type tmp;                                                             \
+        memcpy(&tmp, &it->data[i], sizeof (type));                            \
+        memcpy(&it->data[i], &it->data[j], sizeof (type));                    \
+        memcpy(&it->data[j], &tmp, sizeof (type));                            \
+      }                                                                       \
+      it->next = it->prev;                                                    \
+      it->prev = next;                                                        \
+      it = next;                                                              \
+    }                                                                         \
+    M_SWAP(struct M_C(name, _s) *, list->back, list->front);                  \
+    M_UL1ST_CONTRACT(list);                                                   \
+  }                                                                           \
+                                                                              \
+  M_EMPLACE_QUEUE_DEF(name, list_t, M_C(name, _emplace_back), oplist, M_L1ST_EMPLACE_BACK_DEF) \
+  M_EMPLACE_QUEUE_DEF(name, list_t, M_C(name, _emplace_front), oplist, M_L1ST_EMPLACE_FRONT_DEF) \
+
+#if M_USE_SMALL_NAME
+#define ULIST_DEF M_ULIST_DEF
+#define ULIST_DEF_AS M_ULIST_DEF_AS
+#define ULIST_OPLIST M_ULIST_OPLIST
+#define ULIST_INIT_VALUE M_ULIST_INIT_VALUE
+#endif
+
+#endif
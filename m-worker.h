@@ -33,11 +33,103 @@
 # define M_USE_WORKER 1
 #endif
 
+#include "m-core.h"
+#include "m-atomic.h"
+
+/* Define the policies of placement of the workers on the CPU.
+   The CPU of a NUMA node are consecutive in the order of the CPU. */
+typedef enum m_worker_affinity_e {
+  M_WORKER_AFFINITY_NONE,         // The system places the workers
+  M_WORKER_AFFINITY_COMPACT,      // Worker i is bound to the i-th CPU
+  M_WORKER_AFFINITY_SCATTER,      // Workers are bound to the NUMA nodes in round robin
+  M_WORKER_AFFINITY_CPU_LIST,     // Worker i is bound to the CPU cpu[i % num_cpu]
+  M_WORKER_AFFINITY_NODE          // Workers are split in pools bound to the CPU of a NUMA node
+} m_worker_affinity_e;
+
+/* Define the affinity of the workers of a pool (See m_worker_init) */
+typedef struct m_worker_affinity_s {
+  m_worker_affinity_e policy;
+  size_t num_cpu;                 // Number of CPU of the list (CPU_LIST only)
+  const unsigned int *cpu;        // List of the CPU (CPU_LIST only)
+} m_worker_affinity_t;
+
+/* Define the priority classes of the work orders */
+typedef enum m_worker_priority_e {
+  M_WORKER_PRIORITY_HIGH,         // Latency sensitive work orders
+  M_WORKER_PRIORITY_NORMAL,       // Default class (work orders of m_worker_spawn)
+  M_WORKER_PRIORITY_LOW           // Background work orders
+} m_worker_priority_e;
+
+/* Deadline of the work orders without deadline */
+#define M_WORKER_NO_DEADLINE UINT64_MAX
+
+/* The User Code can define M_USE_WORKER_STATS to 1 to enable
+   the statistics of the pools of workers (See m_worker_stats).
+   Otherwise, they are not computed and are always null. */
+#ifndef M_USE_WORKER_STATS
+# define M_USE_WORKER_STATS 0
+#endif
+
+/* Number of buckets of the histograms of durations of the statistics:
+   the bucket i counts the durations in [2^i, 2^(i+1)[ nanoseconds
+   (the first one counts also the null durations, the last one all the
+   longer durations) */
+#define M_WORKER_STATS_BUCKETS 40
+
+/* Definition of the statistics of a pool of workers
+   (the durations are in nanoseconds) */
+typedef struct m_worker_stats_s {
+  unsigned long long spawned;     // Work orders handed over to the workers
+  unsigned long long executed;    // Work orders executed from a queue
+  unsigned long long inlined;     // Work orders executed by their spawner (no worker available)
+  unsigned long long stolen;      // Work orders stolen from the deque of another worker
+  unsigned long long sync_wait;   // Total duration of the waits in m_worker_sync
+  unsigned long long queue_wait[M_WORKER_STATS_BUCKETS]; // Histogram of the waits in queue
+  unsigned long long run_time[M_WORKER_STATS_BUCKETS];   // Histogram of the executions
+} m_worker_stats_t;
+
+/* Definition of the statistics of a thread of a pool of workers */
+typedef struct m_worker_thread_stats_s {
+  unsigned long long executed;    // Work orders executed from a queue
+  unsigned long long stolen;      // Work orders stolen from another worker
+  unsigned long long busy;        // Duration of the execution of the work orders
+  unsigned long long idle;        // Duration of the waits for a work order
+} m_worker_thread_stats_t;
+
+/* Definition of a continuation of a future:
+   the work order spawned once the future is ready */
+typedef struct m_work3r_cont_s {
+  struct m_work3r_cont_s *next;   // Next continuation of the same future
+  void (*func)(void *);           // Function spawned with the continuation as argument
+  void *owner;                    // Future computed by the continuation
+  size_t index;                   // Index of the ready future in the sources of 'owner'
+} m_work3r_cont_ct;
+
+/* Definition of the generic part of a future */
+typedef struct m_work3r_future_s {
+  atomic_int cpt;                 // Number of references to the future
+  atomic_int num_wait;            // Number of threads sleeping until it is ready
+  atomic_uintptr_t cont;          // List of continuations, or M_WORK3R_FUTURE_READY
+  struct m_worker_s *worker;      // Pool of workers running the continuations
+  void (*del)(void *);            // Destructor of the future
+} m_work3r_future_ct;
+
+/* Value of the list of continuations once the future is ready
+   (a continuation cannot be at this address) */
+#define M_WORK3R_FUTURE_READY ((uintptr_t) 1)
+
+/* Test if the future is ready */
+static inline bool
+m_work3r_future_ready_p(m_work3r_future_ct *f)
+{
+  return atomic_load_explicit(&f->cont, memory_order_acquire) == M_WORK3R_FUTURE_READY;
+}
+
 
 #if M_USE_WORKER
 
-#include "m-atomic.h"
 #include "m-buffer.h"
+#include "m-prioqueue.h"
 #include "m-mutex.h"
 
 /* Include needed system header for detection of how many core on the system */
@@ -52,6 +144,38 @@
 #else
 # include <unistd.h>
 #endif
+#if defined(__linux__)
+# include <sched.h>
+#endif
+#if M_USE_WORKER_STATS && !defined(_WIN32)
+# include <time.h>
+# include <sys/time.h>
+#endif
+
+/* Define if the workers can be bound to CPU.
+   It is supported on Windows and on Linux (where sched_setaffinity is
+   only declared if _GNU_SOURCE is defined before including any header).
+   Otherwise, the affinity policies only define the NUMA nodes of the workers. */
+#ifndef M_USE_WORKER_AFFINITY
+# if defined(_WIN32) || (defined(__linux__) && defined(CPU_SET))
+#  define M_USE_WORKER_AFFINITY 1
+# else
+#  define M_USE_WORKER_AFFINITY 0
+# endif
+#endif
+
+/* Maximum number of CPU & NUMA nodes handled by the affinity policies */
+#ifndef M_USE_WORKER_MAX_CPU
+# define M_USE_WORKER_MAX_CPU 1024
+#endif
+#ifndef M_USE_WORKER_MAX_NODE
+# define M_USE_WORKER_MAX_NODE 64
+#endif
+
+/* Format of the path of the list of the CPU of a NUMA node (Linux only) */
+#ifndef M_USE_WORKER_NODE_CPULIST
+# define M_USE_WORKER_NODE_CPULIST "/sys/devices/system/node/node%u/cpulist"
+#endif
 
 /* Support for CLANG block since CLANG doesn't support nested function.
    M-WORKER uses its 'blocks' extension instead, but it is not compatible
@@ -106,8 +230,55 @@ typedef struct m_work3r_order_s {
 #if M_USE_WORKER_CPP_FUNCTION
   std::function<void(void*)> function; // The work order function (for C++)
 #endif
+#if M_USE_WORKER_STATS
+  unsigned long long time;        // Time of the spawn of the work order
+#endif
 } m_work3r_order_ct;
 
+#if M_USE_WORKER_STATS
+/* Return the current time in nanoseconds (for the statistics) */
+static inline unsigned long long
+m_work3r_clock(void)
+{
+#if defined(_WIN32)
+  LARGE_INTEGER freq, val;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&val);
+  return (unsigned long long) ((double) val.QuadPart * 1e9 / (double) freq.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (unsigned long long) tv.tv_sec * 1000000000ULL + (unsigned long long) tv.tv_usec * 1000ULL;
+#endif
+}
+
+/* Definition of the statistics of a thread of the pool
+   (updated by the thread only, except the slot of the threads
+   which are not workers) */
+typedef struct m_work3r_stats_s {
+  atomic_ullong spawned;
+  atomic_ullong executed;
+  atomic_ullong inlined;
+  atomic_ullong stolen;
+  atomic_ullong sync_wait;
+  atomic_ullong busy;
+  atomic_ullong idle;
+  atomic_ullong queue_wait[M_WORKER_STATS_BUCKETS];
+  atomic_ullong run_time[M_WORKER_STATS_BUCKETS];
+} m_work3r_stats_ct;
+#endif
+
+/* MACRO to complete the initialization of an order with its time of spawn */
+#if M_USE_WORKER_STATS
+# define M_WORK3R_TIME_ORDER(t) , (t)
+#else
+# define M_WORK3R_TIME_ORDER(t)
+#endif
+
 /* Define the macros needed to initialize an order.
  * * MACRO to be used to send an empty order to stop the thread
  * * MACRO to complete the not-used fields
@@ -136,18 +307,118 @@ typedef struct m_work3r_order_s {
 # define M_WORK3R_OPLIST M_POD_OPLIST
 #endif
 
-/* Definition of a worker (implemented by a thread) */
+/* Size of the work-stealing deque of each worker (shall be a power of 2).
+   A worker which has more pending work orders in its deque than this size
+   executes the extra work orders itself */
+#ifndef M_USE_WORKER_DEQUE_SIZE
+# define M_USE_WORKER_DEQUE_SIZE 256
+#endif
+#if (M_USE_WORKER_DEQUE_SIZE & (M_USE_WORKER_DEQUE_SIZE - 1)) != 0
+# error M_USE_WORKER_DEQUE_SIZE shall be a power of 2.
+#endif
+
+/* Number of active waits an idle worker performs
+   before going to sleep (with increasing duration) */
+#ifndef M_USE_WORKER_SPIN
+# define M_USE_WORKER_SPIN 10
+#endif
+
+/* Starvation protection of the priority classes:
+   a worker serves first the LOW priority class, or the NORMAL one,
+   once every M_USE_WORKER_PRIORITY_AGING work orders */
+#ifndef M_USE_WORKER_PRIORITY_AGING
+# define M_USE_WORKER_PRIORITY_AGING 16
+#endif
+
+/* Definition of a cell of the work-stealing deque of a worker */
+typedef struct m_work3r_cell_s {
+  atomic_size_t seq;              // Index of the deque that can be pushed in the cell
+  m_work3r_order_ct order;        // The work order
+} m_work3r_cell_ct;
+
+/* Definition of a worker (implemented by a thread)
+   Each worker owns a Chase-Lev deque of work orders:
+   it pushes & pops at the bottom (LIFO) and the other workers steal
+   from the top (FIFO). 'bottom' and 'top' are on different cache lines
+   so that the owner doesn't share a cache line with the thieves in the
+   common case. */
 typedef struct m_work3r_thread_s {
+  atomic_size_t bottom;           // Next index to push (written by the owner only)
+  m_work3r_cell_ct *cell;         // Table of the cells of the deque
+  struct m_worker_s *pool;        // Pool of the worker
+  unsigned int index;             // Index of the worker in the pool
+  unsigned int seed;              // Seed for the selection of the victims of steal
+  unsigned int tick;              // Number of requests of work orders (for the aging)
+  M_CACHELINE_ALIGN(align1, atomic_size_t, m_work3r_cell_ct *, struct m_worker_s *, unsigned int, unsigned int, unsigned int);
+  atomic_size_t top;              // Next index to steal (CAS by owner & thieves)
   m_thread_t id;
+  unsigned int node;              // NUMA node of the worker
+  int cpu;                        // CPU of the worker (or -1 for all CPU of its node)
+  m_thread_id_t tid;              // Identifier of the worker thread (once registered)
+  atomic_bool registered;         // The worker thread has set its identifier
+  M_CACHELINE_ALIGN(align2, atomic_size_t, m_thread_t, unsigned int, int, m_thread_id_t, atomic_bool);
 } m_work3r_thread_ct;
 
-/* Definition of the queue that will record the work orders */
+/* Definition of the topology of the system:
+   the CPU sorted by NUMA node */
+typedef struct m_work3r_topology_s {
+  unsigned int num_cpu;
+  unsigned int num_node;
+  unsigned int first[M_USE_WORKER_MAX_NODE + 1]; // Index of the first CPU of each node
+  unsigned int cpu[M_USE_WORKER_MAX_CPU];
+} m_work3r_topology_ct;
+
+/* Definition of the queue that will record the work orders
+   spawned by threads which are not workers of the pool */
 BUFFER_DEF(m_work3r_queue, m_work3r_order_ct, 0,
-           BUFFER_QUEUE|BUFFER_UNBLOCKING_PUSH|BUFFER_BLOCKING_POP|BUFFER_THREAD_SAFE|BUFFER_DEFERRED_POP, M_WORK3R_OPLIST)
+           BUFFER_QUEUE|BUFFER_UNBLOCKING|BUFFER_THREAD_SAFE, M_WORK3R_OPLIST)
+
+/* Definition of a work order of the HIGH or LOW priority class */
+typedef struct m_work3r_porder_s {
+  uint64_t deadline;              // Deadline of the work order
+  uint64_t seq;                   // Arrival number of the work order in its class
+  struct m_worker_sync_s *block;  // Reference to the shared Synchronization block
+  void * data;                    // The work order data
+  void (*func) (void *data);      // The work order function
+#if M_USE_WORKER_STATS
+  unsigned long long time;        // Time of the spawn of the work order
+#endif
+} m_work3r_porder_ct;
+
+/* Order the work orders by deadline, then by arrival */
+static inline int
+m_work3r_porder_cmp(const m_work3r_porder_ct *x, const m_work3r_porder_ct *y)
+{
+  if (x->deadline != y->deadline) {
+    return x->deadline < y->deadline ? -1 : 1;
+  }
+  return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+#define M_WORK3R_PORDER_OPLIST                                                \
+  M_OPEXTEND(M_POD_OPLIST, CMP(API_6(m_work3r_porder_cmp)))
+
+/* Definition of the queue of the work orders of a priority class,
+   ordered by deadline (FIFO for the work orders without deadline) */
+M_PRIOQUEUE_DEF(m_work3r_pqueue, m_work3r_porder_ct, M_WORK3R_PORDER_OPLIST)
+
+/* Definition of a priority class (HIGH or LOW) of a pool */
+typedef struct m_work3r_class_s {
+  m_mutex_t lock;                 // Lock of the queue
+  m_work3r_pqueue_t queue;        // The pending work orders of the class
+  uint64_t seq;                   // Number of work orders pushed in the class
+  atomic_size_t depth;            // Number of pending work orders (gauge)
+} m_work3r_class_ct;
+
+/* Definition of the synchronization point for workers */
+typedef struct m_worker_sync_s {
+  atomic_int num_pending;               // Number of spawned work orders not terminated yet
+  struct m_worker_s *worker;            // Reference to the pool of workers
+} m_worker_sync_t[1];
 
 /* Definition the global pool of workers */
 typedef struct m_worker_s {
-  /* The work order queue */
+  /* The work order queue (for the threads which are not workers) */
   m_work3r_queue_t queue_g;
 
   /* The table of available workers */
@@ -156,6 +427,18 @@ typedef struct m_worker_s {
   /* Number of workers in the table */
   unsigned int numWorker_g;
 
+  /* Number of NUMA nodes of the workers */
+  unsigned int numNode_g;
+
+  /* The work order queues targeting a node (NULL if only one node) */
+  m_work3r_queue_t *node_queue;
+
+  /* Number of workers of each node (NULL if only one node) */
+  unsigned int *node_worker;
+
+  /* Topology of the system (NULL if the workers are not bound) */
+  m_work3r_topology_ct *topology;
+
   /* The global reset function */
   void (*resetFunc_g)(void);
 
@@ -164,15 +447,86 @@ typedef struct m_worker_s {
 
   m_mutex_t lock;
   m_cond_t  a_thread_ends;        // EVENT: A worker has ended
+  m_cond_t  work_available;       // EVENT: A work order is available
+  atomic_int num_idle;            // Number of workers waiting for work_available
+  atomic_bool running;            // The workers shall continue to run
+
+  /* The synchronization point of the continuations of the futures */
+  m_worker_sync_t async_g;
+
+  /* The work orders of the HIGH & LOW priority classes */
+  m_work3r_class_ct high_g;
+  m_work3r_class_ct low_g;
+
+#if M_USE_WORKER_STATS
+  /* The statistics of each worker, then of the other threads */
+  m_work3r_stats_ct *stats;
+#endif
 
 } m_worker_t[1];
 
-/* Definition of the synchronization point for workers */
-typedef struct m_worker_sync_s {
-  atomic_int num_spawn;                 // Number of spawned workers accord this synchronization point
-  atomic_int num_terminated_spawn;      // Number of terminated spawned workers
-  struct m_worker_s *worker;            // Reference to the pool of workers
-} m_worker_sync_t[1];
+/* The worker structure of the current thread (or NULL if it is not known).
+   As a header only library, this variable is local to each translation
+   unit: it is set by the main loop of the workers, and in the other
+   translation units by the first lookup of the thread in the pool. */
+static M_THREAD_ATTR m_work3r_thread_ct *m_work3r_self;
+
+/* The last pool the current thread is known not to be a worker of
+   (in this translation unit). A thread never becomes a worker after
+   its creation, so this remains valid even if the pool is recreated. */
+static M_THREAD_ATTR const struct m_worker_s *m_work3r_self_not;
+
+/* Return the worker structure of the current thread if it is a worker
+   of the pool 'g', or NULL otherwise.
+   If it is not known in this translation unit, the thread is looked up
+   by its identifier in the table of the workers of the pool. */
+static inline m_work3r_thread_ct *
+m_work3r_get_self(const struct m_worker_s *g)
+{
+  m_work3r_thread_ct *self = m_work3r_self;
+  if (M_LIKELY (self != NULL)) {
+    return self->pool == g ? self : NULL;
+  }
+  if (m_work3r_self_not == g) {
+    return NULL;
+  }
+  const m_thread_id_t tid = m_thread_self_id();
+  for(unsigned int i = 0; i < g->numWorker_g; i++) {
+    m_work3r_thread_ct *w = &g->worker[i];
+    if (atomic_load_explicit(&w->registered, memory_order_acquire)
+        && m_thread_id_equal_p(w->tid, tid)) {
+      m_work3r_self = w;
+      return w;
+    }
+  }
+  m_work3r_self_not = g;
+  return NULL;
+}
+
+#if M_USE_WORKER_STATS
+/* Return the statistics of the current thread in the pool 'g' */
+static inline m_work3r_stats_ct *
+m_work3r_stats(struct m_worker_s *g)
+{
+  const m_work3r_thread_ct *self = m_work3r_get_self(g);
+  return &g->stats[self != NULL ? self->index : g->numWorker_g];
+}
+
+/* Add 'value' to the counter 'field' of the statistics of the current thread */
+# define M_WORK3R_STATS_ADD(g, field, value)                                  \
+  atomic_fetch_add_explicit(&m_work3r_stats(g)->field, (value), memory_order_relaxed)
+
+/* Add the duration 'd' to the histogram 'h' */
+static inline void
+m_work3r_stats_hist(atomic_ullong h[], unsigned long long d)
+{
+  unsigned int i = d < 2 ? 0 : 63 - m_core_clz64(d);
+  i = M_MIN(i, M_WORKER_STATS_BUCKETS - 1);
+  atomic_fetch_add_explicit(&h[i], 1ULL, memory_order_relaxed);
+}
+#else
+# define M_WORK3R_STATS_ADD(g, field, value) ((void) 0)
+#endif
 
 /* Return the number of CPU of the system */
 static inline int
@@ -198,6 +552,114 @@ m_work3r_get_cpu_count(void)
 #endif
 }
 
+/* Get the topology of the system: the list of CPU of each NUMA node.
+   If it cannot be read, there is only one node with all the CPU. */
+static inline void
+m_work3r_get_topology(m_work3r_topology_ct *topo)
+{
+  topo->num_cpu = 0;
+  topo->num_node = 0;
+#if defined(__linux__) && M_USE_STDIO
+  for(unsigned int node = 0; node < M_USE_WORKER_MAX_NODE; node++) {
+    char path[sizeof M_USE_WORKER_NODE_CPULIST + 16];
+    sprintf(path, M_USE_WORKER_NODE_CPULIST, node);
+    // The nodes are not always numbered consecutively
+    FILE *f = fopen(path, "r");
+    if (f == NULL) continue;
+    topo->first[topo->num_node] = topo->num_cpu;
+    // Read a list of CPU like "0-3,8-11"
+    unsigned int a, b;
+    while (fscanf(f, "%u", &a) == 1) {
+      int c = fgetc(f);
+      b = a;
+      if (c == '-') {
+        if (fscanf(f, "%u", &b) != 1) break;
+        c = fgetc(f);
+      }
+      for( ; a <= b && topo->num_cpu < M_USE_WORKER_MAX_CPU; a++) {
+        topo->cpu[topo->num_cpu++] = a;
+      }
+      if (c != ',') break;
+    }
+    fclose(f);
+    if (topo->num_cpu != topo->first[topo->num_node]) {
+      topo->num_node++;
+    }
+  }
+#endif
+  if (topo->num_node == 0) {
+    const int n = m_work3r_get_cpu_count();
+    topo->first[0] = 0;
+    topo->num_cpu = (unsigned int) M_MIN(M_MAX(n, 1), M_USE_WORKER_MAX_CPU);
+    for(unsigned int i = 0; i < topo->num_cpu; i++) {
+      topo->cpu[i] = i;
+    }
+    topo->num_node = 1;
+  }
+  topo->first[topo->num_node] = topo->num_cpu;
+}
+
+/* Return the NUMA node of the CPU of index 'i' in the topology */
+static inline unsigned int
+m_work3r_topology_node(const m_work3r_topology_ct *topo, unsigned int i)
+{
+  unsigned int node = 0;
+  while (i >= topo->first[node + 1]) {
+    node++;
+  }
+  return node;
+}
+
+/* Bind the current thread to the CPU of the worker 'self'
+   (its CPU, or all the CPU of its NUMA node).
+   It is only an hint: the binding may be refused by the system. */
+static inline void
+m_work3r_bind(const m_work3r_thread_ct *self)
+{
+#if M_USE_WORKER_AFFINITY
+  const m_work3r_topology_ct *topo = self->pool->topology;
+  if (topo == NULL) {
+    return;
+  }
+  unsigned int first = 0, last = 0;
+  if (self->cpu < 0) {
+    first = topo->first[self->node];
+    last  = topo->first[self->node + 1];
+  }
+# if defined(_WIN32)
+  DWORD_PTR mask = 0;
+  const unsigned int bits = sizeof mask * CHAR_BIT;
+  if (self->cpu >= 0 && (unsigned int) self->cpu < bits) {
+    mask = (DWORD_PTR) 1 << self->cpu;
+  }
+  for(unsigned int i = first; i < last; i++) {
+    if (topo->cpu[i] < bits) {
+      mask |= (DWORD_PTR) 1 << topo->cpu[i];
+    }
+  }
+  if (mask != 0) {
+    SetThreadAffinityMask(GetCurrentThread(), mask);
+  }
+# else
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (self->cpu >= 0 && self->cpu < CPU_SETSIZE) {
+    CPU_SET((size_t) self->cpu, &set);
+  }
+  for(unsigned int i = first; i < last; i++) {
+    if (topo->cpu[i] < CPU_SETSIZE) {
+      CPU_SET(topo->cpu[i], &set);
+    }
+  }
+  if (CPU_COUNT(&set) != 0) {
+    (void) sched_setaffinity(0, sizeof set, &set);
+  }
+# endif
+#else
+  (void) self;
+#endif
+}
+
 // (INTERNAL) Debug support for workers
 #if 1
 #define M_WORK3R_DEBUG(...) (void) 0
@@ -205,12 +667,228 @@ m_work3r_get_cpu_count(void)
 #define M_WORK3R_DEBUG(...) printf(__VA_ARGS__)
 #endif
 
+/* Push the work order at the bottom of the deque of the worker.
+   Only the owner of the deque can push.
+   Return false if the deque is full */
+static inline bool
+m_work3r_deque_push(m_work3r_thread_ct *self, const m_work3r_order_ct *w)
+{
+  const size_t b = atomic_load_explicit(&self->bottom, memory_order_relaxed);
+  m_work3r_cell_ct *c = &self->cell[b & (M_USE_WORKER_DEQUE_SIZE - 1)];
+  /* The cell is free only if the work order stored M_USE_WORKER_DEQUE_SIZE
+     indexes before has been fully read (this also detects a full deque) */
+  if (M_UNLIKELY (atomic_load_explicit(&c->seq, memory_order_acquire) != b)) {
+    return false;
+  }
+  M_CALL_SET(M_WORK3R_OPLIST, c->order, *w);
+  atomic_store_explicit(&self->bottom, b + 1, memory_order_release);
+  return true;
+}
+
+/* Pop the last pushed work order from the deque of the worker.
+   Only the owner of the deque can pop.
+   Return false if the deque is empty */
+static inline bool
+m_work3r_deque_pop(m_work3r_order_ct *w, m_work3r_thread_ct *self)
+{
+  const size_t b = atomic_load_explicit(&self->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&self->bottom, b, memory_order_release);
+  // The reservation of the bottom shall be visible before reading top
+  atomic_thread_fence(memory_order_seq_cst);
+  size_t t = atomic_load_explicit(&self->top, memory_order_relaxed);
+  if (M_UNLIKELY ((ptrdiff_t) (b - t) < 0)) {
+    // Empty deque. Restore it
+    atomic_store_explicit(&self->bottom, b + 1, memory_order_release);
+    return false;
+  }
+  m_work3r_cell_ct *c = &self->cell[b & (M_USE_WORKER_DEQUE_SIZE - 1)];
+  if (M_LIKELY (b != t)) {
+    // More than one work order: no thief can reach this one
+    M_CALL_SET(M_WORK3R_OPLIST, *w, c->order);
+    return true;
+  }
+  // Last work order of the deque: race against the thieves for it
+  const bool success =
+    atomic_compare_exchange_strong_explicit(&self->top, &t, t + 1,
+                                            memory_order_seq_cst,
+                                            memory_order_relaxed);
+  atomic_store_explicit(&self->bottom, b + 1, memory_order_release);
+  if (!success) {
+    return false;
+  }
+  M_CALL_SET(M_WORK3R_OPLIST, *w, c->order);
+  atomic_store_explicit(&c->seq, b + M_USE_WORKER_DEQUE_SIZE, memory_order_release);
+  return true;
+}
+
+/* Steal the first pushed work order from the deque of the worker 'victim'.
+   Return false if the deque is empty or if another thread wins the race */
+static inline bool
+m_work3r_deque_steal(m_work3r_order_ct *w, m_work3r_thread_ct *victim)
+{
+  size_t t = atomic_load_explicit(&victim->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  const size_t b = atomic_load_explicit(&victim->bottom, memory_order_acquire);
+  if ((ptrdiff_t) (b - t) <= 0) {
+    return false;
+  }
+  if (!atomic_compare_exchange_strong_explicit(&victim->top, &t, t + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed)) {
+    return false;
+  }
+  // The cell is reserved: read it and release it for the owner
+  m_work3r_cell_ct *c = &victim->cell[t & (M_USE_WORKER_DEQUE_SIZE - 1)];
+  M_CALL_SET(M_WORK3R_OPLIST, *w, c->order);
+  atomic_store_explicit(&c->seq, t + M_USE_WORKER_DEQUE_SIZE, memory_order_release);
+  return true;
+}
+
+/* Test if a work order may be available for the idle worker 'self' */
+static inline bool
+m_work3r_work_available_p(struct m_worker_s *g, const m_work3r_thread_ct *self)
+{
+  if (!m_work3r_queue_empty_p(g->queue_g)
+      || atomic_load(&g->high_g.depth) != 0
+      || atomic_load(&g->low_g.depth) != 0) {
+    return true;
+  }
+  if (g->node_queue != NULL && !m_work3r_queue_empty_p(g->node_queue[self->node])) {
+    return true;
+  }
+  for(unsigned int i = 0; i < g->numWorker_g; i++) {
+    const size_t t = atomic_load(&g->worker[i].top);
+    const size_t b = atomic_load(&g->worker[i].bottom);
+    if ((ptrdiff_t) (b - t) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Get a work order of the pool 'g' for the thread 'self'
+   (the worker of the pool run by the thread, or NULL if none):
+   from its own deque, then from the queue of its NUMA node,
+   then from the global queue, then by stealing it from other workers
+   (starting from a random one selected with 'seed',
+   and from the workers of the same node first) */
+static inline bool
+m_work3r_get_normal_order(m_work3r_order_ct *w, struct m_worker_s *g, m_work3r_thread_ct *self, unsigned int *seed)
+{
+  if (self != NULL && m_work3r_deque_pop(w, self)) {
+    return true;
+  }
+  if (self != NULL && g->node_queue != NULL
+      && !m_work3r_queue_empty_p(g->node_queue[self->node])
+      && m_work3r_queue_pop(w, g->node_queue[self->node])) {
+    return true;
+  }
+  if (!m_work3r_queue_empty_p(g->queue_g)
+      && m_work3r_queue_pop(w, g->queue_g)) {
+    return true;
+  }
+  const unsigned int n = g->numWorker_g;
+  if (n == 0) {
+    return false;
+  }
+  *seed = *seed * 1103515245U + 12345U;
+  const unsigned int start = (*seed >> 16) % n;
+  // Only one pass if the nodes are not taken into account
+  const int num_pass = (self != NULL && g->numNode_g > 1) ? 2 : 1;
+  for(int pass = 0; pass < num_pass; pass++) {
+    unsigned int victim = start;
+    for(unsigned int i = 0; i < n; i++) {
+      m_work3r_thread_ct *v = &g->worker[victim];
+      if (v != self
+          && (num_pass == 1 || (pass == 0) == (v->node == self->node))
+          && m_work3r_deque_steal(w, v)) {
+        M_WORK3R_STATS_ADD(g, stolen, 1ULL);
+        return true;
+      }
+      victim = (victim + 1 == n) ? 0 : victim + 1;
+    }
+  }
+  return false;
+}
+
+/* Initialize a priority class */
+static inline void
+m_work3r_class_init(m_work3r_class_ct *c)
+{
+  m_mutex_init(c->lock);
+  m_work3r_pqueue_init(c->queue);
+  c->seq = 0;
+  atomic_init(&c->depth, (size_t) 0);
+}
+
+/* Clear a priority class */
+static inline void
+m_work3r_class_clear(m_work3r_class_ct *c)
+{
+  M_ASSERT (m_work3r_pqueue_empty_p(c->queue));
+  m_work3r_pqueue_clear(c->queue);
+  m_mutex_clear(c->lock);
+}
+
+/* Get the work order of the priority class 'c' with the earliest deadline */
+static inline bool
+m_work3r_class_pop(m_work3r_order_ct *w, m_work3r_class_ct *c)
+{
+  // Fast case: the class is empty
+  if (atomic_load_explicit(&c->depth, memory_order_relaxed) == 0) {
+    return false;
+  }
+  bool ret = false;
+  m_mutex_lock(c->lock);
+  if (!m_work3r_pqueue_empty_p(c->queue)) {
+    m_work3r_porder_ct p;
+    m_work3r_pqueue_pop(&p, c->queue);
+    atomic_fetch_sub(&c->depth, 1);
+    const m_work3r_order_ct o = {  p.block, p.data, p.func M_WORK3R_EXTRA_ORDER M_WORK3R_TIME_ORDER(p.time) };
+    M_CALL_SET(M_WORK3R_OPLIST, *w, o);
+    ret = true;
+  }
+  m_mutex_unlock(c->lock);
+  return ret;
+}
+
+/* Get a work order for the current thread:
+   the HIGH priority class is served first, then the NORMAL one
+   (See m_work3r_get_normal_order), and at last the LOW priority class.
+   For starvation protection, a worker serves first the LOW priority class
+   once every M_USE_WORKER_PRIORITY_AGING requests, and the NORMAL one
+   the next time, so that each class gets a minimum share of the workers. */
+static inline bool
+m_work3r_get_order(m_work3r_order_ct *w, struct m_worker_s *g, m_work3r_thread_ct *self, unsigned int *seed)
+{
+  M_ASSERT (self == NULL || self->pool == g);
+  if (self != NULL) {
+    const unsigned int tick = ++self->tick % (2 * M_USE_WORKER_PRIORITY_AGING);
+    if (tick == 0 && m_work3r_class_pop(w, &g->low_g)) {
+      return true;
+    }
+    if (tick == M_USE_WORKER_PRIORITY_AGING
+        && m_work3r_get_normal_order(w, g, self, seed)) {
+      return true;
+    }
+  }
+  return m_work3r_class_pop(w, &g->high_g)
+    || m_work3r_get_normal_order(w, g, self, seed)
+    || m_work3r_class_pop(w, &g->low_g);
+}
+
 /* Execute the registered work order **synchronously** */
 static inline void
 m_work3r_exec(m_work3r_order_ct *w)
 {
   M_ASSERT (w!= NULL && w->block != NULL);
+  /* Read the pool before running the work order:
+     the synchronization point may be destroyed as soon as it is signaled */
+  struct m_worker_s *g = w->block->worker;
   M_WORK3R_DEBUG ("Starting thread with data %p\n", w->data);
+#if M_USE_WORKER_STATS
+  const unsigned long long start = m_work3r_clock();
+#endif
 #if M_USE_WORKER_CLANG_BLOCK
   M_WORK3R_DEBUG ("Running %s f=%p b=%p\n", (w->func == NULL) ? "Blocks" : "Function", w->func, w->blockFunc);
   if (w->func == NULL)
@@ -224,8 +902,21 @@ m_work3r_exec(m_work3r_order_ct *w)
     else
 #endif
       w->func(w->data);
-  /* Increment the number of terminated work order for the synchronous point */
-  atomic_fetch_add (&w->block->num_terminated_spawn, 1);
+#if M_USE_WORKER_STATS
+  const unsigned long long end = m_work3r_clock();
+  m_work3r_stats_ct *stats = m_work3r_stats(g);
+  atomic_fetch_add_explicit(&stats->executed, 1ULL, memory_order_relaxed);
+  atomic_fetch_add_explicit(&stats->busy, end - start, memory_order_relaxed);
+  m_work3r_stats_hist(stats->queue_wait, start - M_MIN(start, w->time));
+  m_work3r_stats_hist(stats->run_time, end - start);
+#endif
+  /* Decrement the number of pending work orders of the synchronous point.
+     If it was the last one, signal it to the waiting thread. */
+  if (atomic_fetch_sub (&w->block->num_pending, 1) == 1) {
+    m_mutex_lock(g->lock);
+    m_cond_broadcast(g->a_thread_ends);
+    m_mutex_unlock(g->lock);
+  }
 }
 
 
@@ -234,45 +925,182 @@ static inline void
 m_work3r_thread(void *arg)
 {
   // Get back the given argument
-  struct m_worker_s *g = M_ASSIGN_CAST(struct m_worker_s *, arg);
+  m_work3r_thread_ct *self = M_ASSIGN_CAST(m_work3r_thread_ct *, arg);
+  struct m_worker_s *g = self->pool;
+  m_core_backoff_ct bkoff;
+  unsigned int spin = 0;
+#if M_USE_WORKER_STATS
+  unsigned long long idle_start = m_work3r_clock();
+#endif
+  m_work3r_self = self;
+  // Register the thread so that it can be found from other translation units
+  self->tid = m_thread_self_id();
+  atomic_store_explicit(&self->registered, true, memory_order_release);
+  m_work3r_bind(self);
+  m_core_backoff_init(bkoff);
+  // If needed, reset the global state of the worker
+  if (g->resetFunc_g != NULL) {
+    g->resetFunc_g();
+  }
   while (true) {
     m_work3r_order_ct w;
-    // If needed, reset the global state of the worker
-    if (g->resetFunc_g != NULL) {
-      g->resetFunc_g();
-    }
-    // Waiting for data
-    M_WORK3R_DEBUG ("Waiting for data (queue: %lu / %lu)\n", m_work3r_queue_size(g->queue_g), m_work3r_queue_capacity(g->queue_g));
-    m_work3r_queue_pop(&w, g->queue_g);
-    // We received a work order 
-    // Note: that the work order is still present in the queue
-    // preventing further work order to be pushed in the queue until it finishes doing the work
-    // If a stop request is received, terminate the thread 
-    if (w.block == NULL) break;
-    // Execute the work order
-    m_work3r_exec(&w);
-    // Consumme fully the work order in the queue
-    m_work3r_queue_pop_release(g->queue_g);
-    // Signal that a worker has finished.
+    // Get a work order and execute it
+    if (m_work3r_get_order(&w, g, self, &self->seed)) {
+#if M_USE_WORKER_STATS
+      if (idle_start != 0) {
+        M_WORK3R_STATS_ADD(g, idle, m_work3r_clock() - idle_start);
+        idle_start = 0;
+      }
+#endif
+      m_work3r_exec(&w);
+      m_core_backoff_reset(bkoff);
+      spin = 0;
+      // If needed, reset the global state of the worker
+      if (g->resetFunc_g != NULL) {
+        g->resetFunc_g();
+      }
+      continue;
+    }
+#if M_USE_WORKER_STATS
+    if (idle_start == 0) {
+      idle_start = m_work3r_clock();
+    }
+#endif
+    // Perform an active wait first, as a work order is likely to come soon
+    if (spin < M_USE_WORKER_SPIN) {
+      spin++;
+      m_core_backoff_wait(bkoff);
+      continue;
+    }
+    m_core_backoff_reset(bkoff);
+    spin = 0;
+    // No work order is available: wait for one
+    // (or for the termination of the pool)
+    M_WORK3R_DEBUG ("Waiting for data\n");
     m_mutex_lock(g->lock);
-    m_cond_broadcast(g->a_thread_ends);
+    atomic_fetch_add(&g->num_idle, 1);
+    // The registration as idle shall be visible before checking for work
+    atomic_thread_fence(memory_order_seq_cst);
+    while (atomic_load(&g->running) && !m_work3r_work_available_p(g, self)) {
+      m_cond_wait(g->work_available, g->lock);
+    }
+    atomic_fetch_sub(&g->num_idle, 1);
+    const bool running = atomic_load(&g->running);
     m_mutex_unlock(g->lock);
+    // If a stop request is received, terminate the thread
+    if (!running) break;
+  }
+#if M_USE_WORKER_STATS
+  if (idle_start != 0) {
+    M_WORK3R_STATS_ADD(g, idle, m_work3r_clock() - idle_start);
   }
+#endif
+  m_work3r_self = NULL;
+  atomic_store_explicit(&self->registered, false, memory_order_relaxed);
   // If needed, clear global state of the thread
   if (g->clearFunc_g != NULL) {
     g->clearFunc_g();
   }
 }
 
+/* Place the workers of the pool on the CPU & NUMA nodes
+   according to the affinity policy */
+static inline bool
+m_work3r_place(struct m_worker_s *g, const m_worker_affinity_t *affinity)
+{
+  const unsigned int n = g->numWorker_g;
+  for(unsigned int i = 0; i < n; i++) {
+    g->worker[i].node = 0;
+    g->worker[i].cpu = -1;
+  }
+  g->numNode_g = 1;
+  g->topology = NULL;
+  if (affinity == NULL || affinity->policy == M_WORKER_AFFINITY_NONE) {
+    return true;
+  }
+  m_work3r_topology_ct *topo = M_MEMORY_ALLOC(m_work3r_topology_ct);
+  if (M_UNLIKELY (topo == NULL)) {
+    M_MEMORY_FULL(sizeof (m_work3r_topology_ct));
+    return false;
+  }
+  m_work3r_get_topology(topo);
+  g->topology = topo;
+  g->numNode_g = topo->num_node;
+  for(unsigned int i = 0; i < n; i++) {
+    m_work3r_thread_ct *self = &g->worker[i];
+    unsigned int k;
+    switch (affinity->policy) {
+    case M_WORKER_AFFINITY_COMPACT:
+      k = i % topo->num_cpu;
+      self->node = m_work3r_topology_node(topo, k);
+      self->cpu = (int) topo->cpu[k];
+      break;
+    case M_WORKER_AFFINITY_SCATTER:
+      self->node = i % topo->num_node;
+      k = topo->first[self->node + 1] - topo->first[self->node];
+      self->cpu = (int) topo->cpu[topo->first[self->node] + (i / topo->num_node) % k];
+      break;
+    case M_WORKER_AFFINITY_CPU_LIST:
+      M_ASSERT (affinity->num_cpu > 0 && affinity->cpu != NULL);
+      self->cpu = (int) affinity->cpu[i % affinity->num_cpu];
+      // Search for the node of the CPU (0 if unknown)
+      for(k = 0; k < topo->num_cpu; k++) {
+        if (topo->cpu[k] == (unsigned int) self->cpu) {
+          self->node = m_work3r_topology_node(topo, k);
+          break;
+        }
+      }
+      break;
+    case M_WORKER_AFFINITY_NODE:
+      // Split the workers in consecutive groups of the same size
+      self->node = (unsigned int) (((unsigned long long) i * topo->num_node) / n);
+      break;
+    case M_WORKER_AFFINITY_NONE:
+    default:
+      M_ASSERT(false);
+      break;
+    }
+  }
+  return true;
+}
+
+/* Create the queues of the work orders targeting a NUMA node
+   (if there is more than one node) */
+static inline bool
+m_work3r_node_init(struct m_worker_s *g, size_t size)
+{
+  g->node_queue = NULL;
+  g->node_worker = NULL;
+  if (g->numNode_g <= 1) {
+    return true;
+  }
+  const size_t num = g->numNode_g;
+  g->node_worker = M_MEMORY_REALLOC(unsigned int, NULL, num);
+  g->node_queue = M_MEMORY_REALLOC(m_work3r_queue_t, NULL, num);
+  if (M_UNLIKELY (g->node_worker == NULL || g->node_queue == NULL)) {
+    M_MEMORY_FULL(sizeof (m_work3r_queue_t) * num);
+    return false;
+  }
+  for(size_t i = 0; i < num; i++) {
+    g->node_worker[i] = 0;
+    m_work3r_queue_init(g->node_queue[i], size);
+  }
+  for(unsigned int i = 0; i < g->numWorker_g; i++) {
+    g->node_worker[g->worker[i].node]++;
+  }
+  return true;
+}
+
 /* Initialization of the worker module (constructor)
    Input:
    @numWorker: number of worker to create (0=autodetect, -1=2*autodetect)
    @extraQueue: number of extra work order we can get if all workers are full
    @resetFunc: function to reset the state of a worker between work orders (or NULL if none)
    @clearFunc: function to clear the state of a worker before terminaning (or NULL if none)
+   @affinity: placement of the workers on the CPU (or NULL if none)
 */
 static inline void
-m_worker_init(m_worker_t g, int numWorker, unsigned int extraQueue, void (*resetFunc)(void), void (*clearFunc)(void))
+m_worker_init(m_worker_t g, int numWorker, unsigned int extraQueue, void (*resetFunc)(void), void (*clearFunc)(void), const m_worker_affinity_t *affinity)
 {
   M_ASSERT (numWorker >= -1);
   // Auto compute number of workers if the argument is 0
@@ -288,16 +1116,67 @@ m_worker_init(m_worker_t g, int numWorker, unsigned int extraQueue, void (*reset
     M_MEMORY_FULL(sizeof (m_work3r_thread_ct) * numWorker_st);
     return;
   }
+  for(size_t i = 0; i < numWorker_st; i++) {
+    m_work3r_thread_ct *self = &g->worker[i];
+    self->cell = M_MEMORY_REALLOC(m_work3r_cell_ct, NULL, M_USE_WORKER_DEQUE_SIZE);
+    if (self->cell == NULL) {
+      M_MEMORY_FULL(sizeof (m_work3r_cell_ct) * M_USE_WORKER_DEQUE_SIZE);
+      return;
+    }
+    for(size_t j = 0; j < M_USE_WORKER_DEQUE_SIZE; j++) {
+      atomic_init(&self->cell[j].seq, j);
+      M_CALL_INIT(M_WORK3R_OPLIST, self->cell[j].order);
+    }
+    atomic_init(&self->bottom, (size_t) 0);
+    atomic_init(&self->top, (size_t) 0);
+    self->pool = g;
+    self->index = (unsigned int) i;
+    self->seed = (unsigned int) i + 1;
+    self->tick = 0;
+    atomic_init(&self->registered, false);
+  }
   m_work3r_queue_init(g->queue_g, numWorker_st + extraQueue);
   g->numWorker_g = (unsigned int) numWorker_st;
+#if M_USE_WORKER_STATS
+  g->stats = M_MEMORY_REALLOC(m_work3r_stats_ct, NULL, numWorker_st + 1);
+  if (g->stats == NULL) {
+    M_MEMORY_FULL(sizeof (m_work3r_stats_ct) * (numWorker_st + 1));
+    return;
+  }
+  for(size_t i = 0; i <= numWorker_st; i++) {
+    m_work3r_stats_ct *s = &g->stats[i];
+    atomic_init(&s->spawned, 0ULL);
+    atomic_init(&s->executed, 0ULL);
+    atomic_init(&s->inlined, 0ULL);
+    atomic_init(&s->stolen, 0ULL);
+    atomic_init(&s->sync_wait, 0ULL);
+    atomic_init(&s->busy, 0ULL);
+    atomic_init(&s->idle, 0ULL);
+    for(unsigned int j = 0; j < M_WORKER_STATS_BUCKETS; j++) {
+      atomic_init(&s->queue_wait[j], 0ULL);
+      atomic_init(&s->run_time[j], 0ULL);
+    }
+  }
+#endif
+  if (!m_work3r_place(g, affinity)
+      || !m_work3r_node_init(g, numWorker_st + extraQueue)) {
+    return;
+  }
   g->resetFunc_g = resetFunc;
   g->clearFunc_g = clearFunc;
   m_mutex_init(g->lock);
   m_cond_init(g->a_thread_ends);
-  
+  m_cond_init(g->work_available);
+  atomic_init(&g->num_idle, 0);
+  atomic_init(&g->running, true);
+  atomic_init(&g->async_g->num_pending, 0);
+  g->async_g->worker = g;
+  m_work3r_class_init(&g->high_g);
+  m_work3r_class_init(&g->low_g);
+
   // Create & start the workers
   for(size_t i = 0; i < numWorker_st; i++) {
-    m_thread_create(g->worker[i].id, m_work3r_thread, M_ASSIGN_CAST(void*, g));
+    m_thread_create(g->worker[i].id, m_work3r_thread, M_ASSIGN_CAST(void*, &g->worker[i]));
   }
 }
 /* Initialization of the worker module (constructor)
@@ -307,43 +1186,56 @@ m_worker_init(m_worker_t g, int numWorker, unsigned int extraQueue, void (*reset
    @extraQueue: number of extra work order we can get if all workers are full
    @resetFunc: function to reset the state of a worker between work orders (optional)
    @clearFunc: function to clear the state of a worker before terminaning (optional)
+   @affinity: placement of the workers on the CPU (optional)
 */
-#define m_worker_init(...) m_worker_init(M_DEFAULT_ARGS(5, (0, 0, NULL, NULL), __VA_ARGS__))
-
-/* Clear of the worker module (destructor) */
-static inline void
-m_worker_clear(m_worker_t g)
-{
-  M_ASSERT (m_work3r_queue_empty_p (g->queue_g));
-  // Push the terminate order on the queue
-  for(unsigned int i = 0; i < g->numWorker_g; i++) {
-    m_work3r_order_ct w = M_WORK3R_EMPTY_ORDER;
-    // Normaly all worker threads shall be waiting at this
-    // stage, so all push won't block as the queue is empty.
-    // But for robustness, let's wait.
-    m_work3r_queue_push_blocking (g->queue_g, w, true);
-  }
-  // Wait for thread terminanison
-  for(unsigned int i = 0; i < g->numWorker_g; i++) {
-    m_thread_join(g->worker[i].id);
-  }
-  // Clear memory
-  M_MEMORY_FREE(g->worker);
-  m_mutex_clear(g->lock);
-  m_cond_clear(g->a_thread_ends);
-  m_work3r_queue_clear(g->queue_g);
-}
+#define m_worker_init(...) m_worker_init(M_DEFAULT_ARGS(6, (0, 0, NULL, NULL, NULL), __VA_ARGS__))
 
 /* Start a new collaboration between workers of pool 'g'
    by defining the synchronization point 'block' */
 static inline void
 m_worker_start(m_worker_sync_t block, m_worker_t g)
 {
-  atomic_init (&block->num_spawn, 0);
-  atomic_init (&block->num_terminated_spawn, 0);
+  atomic_init (&block->num_pending, 0);
   block->worker = g;
 }
 
+/* Hand over the work order to the workers of the pool.
+   A worker of the pool pushes it on its own deque.
+   Another thread pushes it in the global queue.
+   Return false if it cannot (the caller shall execute the work order) */
+static inline bool
+m_work3r_push(m_worker_sync_t block, const m_work3r_order_ct *w)
+{
+  struct m_worker_s *g = block->worker;
+  m_work3r_thread_ct *self = m_work3r_get_self(g);
+  bool pushed;
+  if (self != NULL) {
+    // Register the work order before any worker can execute it
+    atomic_fetch_add (&block->num_pending, 1);
+    pushed = m_work3r_deque_push(self, w);
+  } else {
+    if (g->numWorker_g == 0 || m_work3r_queue_full_p(g->queue_g)) {
+      return false;
+    }
+    atomic_fetch_add (&block->num_pending, 1);
+    pushed = m_work3r_queue_push (g->queue_g, *w);
+  }
+  if (M_UNLIKELY (!pushed)) {
+    atomic_fetch_sub (&block->num_pending, 1);
+    return false;
+  }
+  M_WORK3R_STATS_ADD(g, spawned, 1ULL);
+  // Wake up an idle worker if there is any.
+  // The push shall be visible before reading the number of idle workers
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&g->num_idle, memory_order_relaxed) != 0) {
+    m_mutex_lock(g->lock);
+    m_cond_signal(g->work_available);
+    m_mutex_unlock(g->lock);
+  }
+  return true;
+}
+
 /* Spawn the given work order to workers if possible,
    or do it ourself if no worker is available.
    The synchronization point is defined a 'block'
@@ -352,32 +1244,116 @@ m_worker_start(m_worker_sync_t block, m_worker_t g)
 static inline void
 m_worker_spawn(m_worker_sync_t block, void (*func)(void *data), void *data)
 {
-  const m_work3r_order_ct w = {  block, data, func M_WORK3R_EXTRA_ORDER };
-  if (M_UNLIKELY (!m_work3r_queue_full_p(block->worker->queue_g))
-      && m_work3r_queue_push (block->worker->queue_g, w) == true) {
-    M_WORK3R_DEBUG ("Sending data to thread: %p (block: %d / %d)\n", data, block->num_spawn, block->num_terminated_spawn);
-    atomic_fetch_add (&block->num_spawn, 1);
+  const m_work3r_order_ct w = {  block, data, func M_WORK3R_EXTRA_ORDER M_WORK3R_TIME_ORDER(m_work3r_clock()) };
+  if (m_work3r_push(block, &w)) {
+    M_WORK3R_DEBUG ("Sending data to thread: %p (block: %d)\n", data, atomic_load(&block->num_pending));
     return;
   }
   M_WORK3R_DEBUG ("Running data ourself: %p\n", data);
+  M_WORK3R_STATS_ADD(block->worker, inlined, 1ULL);
   /* No worker available. Call the function ourself */
   (*func) (data);
 }
 
+/* Spawn the given work order to the workers of the NUMA node 'node'
+   if possible (See m_worker_spawn otherwise) */
+static inline void
+m_worker_spawn_node(m_worker_sync_t block, unsigned int node, void (*func)(void *data), void *data)
+{
+  struct m_worker_s *g = block->worker;
+  if (g->node_queue != NULL && node < g->numNode_g && g->node_worker[node] != 0
+      && !m_work3r_queue_full_p(g->node_queue[node])) {
+    const m_work3r_order_ct w = {  block, data, func M_WORK3R_EXTRA_ORDER M_WORK3R_TIME_ORDER(m_work3r_clock()) };
+    atomic_fetch_add (&block->num_pending, 1);
+    if (m_work3r_queue_push (g->node_queue[node], w)) {
+      M_WORK3R_STATS_ADD(g, spawned, 1ULL);
+      // Wake up all idle workers as only the ones of the node can execute it
+      atomic_thread_fence(memory_order_seq_cst);
+      if (atomic_load_explicit(&g->num_idle, memory_order_relaxed) != 0) {
+        m_mutex_lock(g->lock);
+        m_cond_broadcast(g->work_available);
+        m_mutex_unlock(g->lock);
+      }
+      return;
+    }
+    atomic_fetch_sub (&block->num_pending, 1);
+  }
+  m_worker_spawn(block, func, data);
+}
+
+/* Spawn the given work order to workers in the priority class 'priority'
+   (See m_worker_spawn otherwise).
+   The work orders of the HIGH & LOW priority classes are ordered
+   by 'deadline', then by arrival. */
+static inline void
+m_worker_spawn_priority(m_worker_sync_t block, m_worker_priority_e priority,
+                        void (*func)(void *data), void *data, uint64_t deadline)
+{
+  struct m_worker_s *g = block->worker;
+  if (priority == M_WORKER_PRIORITY_NORMAL || g->numWorker_g == 0) {
+    m_worker_spawn(block, func, data);
+    return;
+  }
+  M_ASSERT (priority == M_WORKER_PRIORITY_HIGH || priority == M_WORKER_PRIORITY_LOW);
+  m_work3r_class_ct *c = priority == M_WORKER_PRIORITY_HIGH ? &g->high_g : &g->low_g;
+  m_work3r_porder_ct p = { deadline, 0, block, data, func M_WORK3R_TIME_ORDER(m_work3r_clock()) };
+  // Register the work order before any worker can execute it
+  atomic_fetch_add (&block->num_pending, 1);
+  m_mutex_lock(c->lock);
+  p.seq = c->seq++;
+  m_work3r_pqueue_push(c->queue, p);
+  atomic_fetch_add(&c->depth, 1);
+  m_mutex_unlock(c->lock);
+  M_WORK3R_STATS_ADD(g, spawned, 1ULL);
+  // Wake up an idle worker if there is any (See m_work3r_push)
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&g->num_idle, memory_order_relaxed) != 0) {
+    m_mutex_lock(g->lock);
+    m_cond_signal(g->work_available);
+    m_mutex_unlock(g->lock);
+  }
+}
+/* Provide default values for the arguments: no deadline */
+#define m_worker_spawn_priority(...)                                          \
+  m_worker_spawn_priority(M_DEFAULT_ARGS(5, (M_WORKER_NO_DEADLINE), __VA_ARGS__))
+
+/* Return the number of pending work orders of the priority class 'priority'
+   (an instant gauge: it may be outdated as soon as it is returned) */
+static inline size_t
+m_worker_queue_depth(m_worker_t g, m_worker_priority_e priority)
+{
+  if (priority == M_WORKER_PRIORITY_HIGH) {
+    return atomic_load(&g->high_g.depth);
+  }
+  if (priority == M_WORKER_PRIORITY_LOW) {
+    return atomic_load(&g->low_g.depth);
+  }
+  M_ASSERT (priority == M_WORKER_PRIORITY_NORMAL);
+  size_t depth = m_work3r_queue_size(g->queue_g);
+  for(unsigned int i = 0; i < g->numNode_g && g->node_queue != NULL; i++) {
+    depth += m_work3r_queue_size(g->node_queue[i]);
+  }
+  for(unsigned int i = 0; i < g->numWorker_g; i++) {
+    const size_t t = atomic_load(&g->worker[i].top);
+    const size_t b = atomic_load(&g->worker[i].bottom);
+    depth += (ptrdiff_t) (b - t) > 0 ? b - t : 0;
+  }
+  return depth;
+}
+
 #if M_USE_WORKER_CLANG_BLOCK
 /* Spawn or not the given work order to workers,
    or do it ourself if no worker is available */
 static inline void
 m_work3r_spawn_block(m_worker_sync_t block, void (^func)(void *data), void *data)
 {
-  const m_work3r_order_ct w = {  block, data, NULL, func };
-  if (M_UNLIKELY (!m_work3r_queue_full_p(block->worker->queue_g))
-      && m_work3r_queue_push (block->worker->queue_g, w) == true) {
-    M_WORK3R_DEBUG ("Sending data to thread as block: %p (block: %d / %d)\n", data, block->num_spawn, block->num_terminated_spawn);
-    atomic_fetch_add (&block->num_spawn, 1);
+  const m_work3r_order_ct w = {  block, data, NULL, func M_WORK3R_TIME_ORDER(m_work3r_clock()) };
+  if (m_work3r_push(block, &w)) {
+    M_WORK3R_DEBUG ("Sending data to thread as block: %p (block: %d)\n", data, atomic_load(&block->num_pending));
     return;
   }
   M_WORK3R_DEBUG ("Running data ourself as block: %p\n", data);
+  M_WORK3R_STATS_ADD(block->worker, inlined, 1ULL);
   /* No worker available. Call the function ourself */
   func (data);
 }
@@ -389,14 +1365,13 @@ m_work3r_spawn_block(m_worker_sync_t block, void (^func)(void *data), void *data
 static inline void
 m_work3r_spawn_function(m_worker_sync_t block, std::function<void(void *data)> func, void *data)
 {
-  const m_work3r_order_ct w = {  block, data, NULL, func };
-  if (M_UNLIKELY (!m_work3r_queue_full_p(block->worker->queue_g))
-      && m_work3r_queue_push (block->worker->queue_g, w) == true) {
-    M_WORK3R_DEBUG ("Sending data to thread as block: %p (block: %d / %d)\n", data, block->num_spawn, block->num_terminated_spawn);
-    atomic_fetch_add (&block->num_spawn, 1);
+  const m_work3r_order_ct w = {  block, data, NULL, func M_WORK3R_TIME_ORDER(m_work3r_clock()) };
+  if (m_work3r_push(block, &w)) {
+    M_WORK3R_DEBUG ("Sending data to thread as block: %p (block: %d)\n", data, atomic_load(&block->num_pending));
     return;
   }
   M_WORK3R_DEBUG ("Running data ourself as block: %p\n", data);
+  M_WORK3R_STATS_ADD(block->worker, inlined, 1ULL);
   /* No worker available. Call the function ourself */
   func (data);
 }
@@ -406,10 +1381,9 @@ m_work3r_spawn_function(m_worker_sync_t block, std::function<void(void *data)> f
 static inline bool
 m_worker_sync_p(m_worker_sync_t block)
 {
-  /* If the number of spawns is greated than the number
-     of terminated spawns, some spawns are still working.
-     So wait for terminaison */
-  return (atomic_load(&block->num_spawn) == atomic_load (&block->num_terminated_spawn));
+  /* If some spawned work orders are still pending,
+     some spawns are still working. So wait for terminaison */
+  return atomic_load(&block->num_pending) == 0;
 }
 
 /* Wait for all work orders of the given synchronization point to be finished */
@@ -419,12 +1393,47 @@ m_worker_sync(m_worker_sync_t block)
   M_WORK3R_DEBUG ("Waiting for thread terminasion.\n");
   // Fast case: all workers have finished
   if (m_worker_sync_p(block)) return;
-  // Slow case: perform a locked wait to put this thread to waiting state
-  m_mutex_lock(block->worker->lock);
+  struct m_worker_s *g = block->worker;
+#if M_USE_WORKER_STATS
+  const unsigned long long start = m_work3r_clock();
+#endif
+  // A worker of another pool cannot use its deque for this pool
+  m_work3r_thread_ct *self = m_work3r_get_self(g);
+  unsigned int local_seed = (unsigned int) ((uintptr_t) block >> 4);
+  unsigned int *seed = self == NULL ? &local_seed : &self->seed;
+  m_core_backoff_ct bkoff;
+  unsigned int spin = 0;
+  m_core_backoff_init(bkoff);
+  // Help the workers instead of waiting: execute pending work orders
+  // until the synchronization point is reached.
+  // The work orders of 'block' which are not started yet are preferred:
+  // they are the last pushed ones of our own deque if we are a worker,
+  // or in the global queue otherwise. Then, steal other work orders.
   while (!m_worker_sync_p(block)) {
-    m_cond_wait(block->worker->a_thread_ends, block->worker->lock);
+    m_work3r_order_ct w;
+    if (m_work3r_get_order(&w, g, self, seed)) {
+      m_work3r_exec(&w);
+      m_core_backoff_reset(bkoff);
+      spin = 0;
+      continue;
+    }
+    // Nothing to do: our work orders are executed by other threads
+    if (spin < M_USE_WORKER_SPIN) {
+      spin++;
+      m_core_backoff_wait(bkoff);
+      continue;
+    }
+    m_core_backoff_reset(bkoff);
+    spin = 0;
+    // Slow case: perform a locked wait to put this thread to waiting state
+    // until a synchronization point is reached, then try again to help
+    m_mutex_lock(g->lock);
+    if (!m_worker_sync_p(block)) {
+      m_cond_wait(g->a_thread_ends, g->lock);
+    }
+    m_mutex_unlock(g->lock);
   }
-  m_mutex_unlock(block->worker->lock);
+  M_WORK3R_STATS_ADD(g, sync_wait, m_work3r_clock() - start);
 }
 
 /* Flush any work order in the queue ourself if some remains.*/
@@ -432,12 +1441,128 @@ static inline void
 m_worker_flush(m_worker_t g)
 {
   m_work3r_order_ct w;
-  while (m_work3r_queue_pop_blocking (&w, g->queue_g, false) == true) {
+  m_work3r_thread_ct *self = m_work3r_get_self(g);
+  if (self != NULL) {
+    while (m_work3r_deque_pop(&w, self) == true) {
+      m_work3r_exec(&w);
+    }
+  }
+  while (m_work3r_queue_pop (&w, g->queue_g) == true) {
     m_work3r_exec(&w);
-    m_work3r_queue_pop_release(g->queue_g);
+  }
+  while (m_work3r_class_pop(&w, &g->high_g) || m_work3r_class_pop(&w, &g->low_g)) {
+    m_work3r_exec(&w);
+  }
+}
+
+
+/* Clear of the worker module (destructor) */
+static inline void
+m_worker_clear(m_worker_t g)
+{
+  // Wait for the termination of the continuations of the futures
+  m_worker_sync(g->async_g);
+  M_ASSERT (m_work3r_queue_empty_p (g->queue_g));
+  // Request the termination of the workers
+  m_mutex_lock(g->lock);
+  atomic_store(&g->running, false);
+  m_cond_broadcast(g->work_available);
+  m_mutex_unlock(g->lock);
+  // Wait for thread terminanison
+  for(unsigned int i = 0; i < g->numWorker_g; i++) {
+    m_thread_join(g->worker[i].id);
+  }
+  // Clear memory
+  for(unsigned int i = 0; i < g->numWorker_g; i++) {
+    for(size_t j = 0; j < M_USE_WORKER_DEQUE_SIZE; j++) {
+      M_CALL_CLEAR(M_WORK3R_OPLIST, g->worker[i].cell[j].order);
+    }
+    M_MEMORY_FREE(g->worker[i].cell);
+  }
+  M_MEMORY_FREE(g->worker);
+  if (g->node_queue != NULL) {
+    for(unsigned int i = 0; i < g->numNode_g; i++) {
+      M_ASSERT (m_work3r_queue_empty_p (g->node_queue[i]));
+      m_work3r_queue_clear(g->node_queue[i]);
+    }
+    M_MEMORY_FREE(g->node_queue);
+    M_MEMORY_FREE(g->node_worker);
+  }
+  M_MEMORY_DEL(g->topology);
+  m_work3r_class_clear(&g->high_g);
+  m_work3r_class_clear(&g->low_g);
+#if M_USE_WORKER_STATS
+  M_MEMORY_FREE(g->stats);
+#endif
+  m_mutex_clear(g->lock);
+  m_cond_clear(g->a_thread_ends);
+  m_cond_clear(g->work_available);
+  m_work3r_queue_clear(g->queue_g);
+}
+
+/* Spawn the continuation of a future to the workers of the pool 'g'
+   (in the synchronization point of the pool, so that the pool waits for
+   its termination before being cleared) */
+static inline void
+m_work3r_async(struct m_worker_s *g, void (*func)(void *data), void *data)
+{
+  m_worker_spawn(g->async_g, func, data);
+}
+
+/* Wake up the threads sleeping until the future is ready
+   (called once it is ready) */
+static inline void
+m_work3r_future_wake(m_work3r_future_ct *f)
+{
+  // The store of the ready state and this load are sequentially consistent:
+  // either we see the waiting thread, or it sees the ready future.
+  if (atomic_load(&f->num_wait) != 0) {
+    struct m_worker_s *g = f->worker;
+    m_mutex_lock(g->lock);
+    m_cond_broadcast(g->a_thread_ends);
+    m_mutex_unlock(g->lock);
   }
 }
 
+/* Wait for the future to be ready, executing pending work orders
+   of its pool meanwhile (See m_worker_sync) */
+static inline void
+m_work3r_future_wait(m_work3r_future_ct *f)
+{
+  if (m_work3r_future_ready_p(f)) return;
+  struct m_worker_s *g = f->worker;
+  m_work3r_thread_ct *self = m_work3r_get_self(g);
+  unsigned int local_seed = (unsigned int) ((uintptr_t) f >> 4);
+  unsigned int *seed = self == NULL ? &local_seed : &self->seed;
+  m_core_backoff_ct bkoff;
+  unsigned int spin = 0;
+  m_core_backoff_init(bkoff);
+  while (!m_work3r_future_ready_p(f)) {
+    m_work3r_order_ct w;
+    if (m_work3r_get_order(&w, g, self, seed)) {
+      m_work3r_exec(&w);
+      m_core_backoff_reset(bkoff);
+      spin = 0;
+      continue;
+    }
+    if (spin < M_USE_WORKER_SPIN) {
+      spin++;
+      m_core_backoff_wait(bkoff);
+      continue;
+    }
+    m_core_backoff_reset(bkoff);
+    spin = 0;
+    // Slow case: sleep until a future is ready or a synchronization
+    // point is reached, then try again to help
+    m_mutex_lock(g->lock);
+    atomic_fetch_add(&f->num_wait, 1);
+    if (atomic_load(&f->cont) != M_WORK3R_FUTURE_READY) {
+      m_cond_wait(g->a_thread_ends, g->lock);
+    }
+    atomic_fetch_sub(&f->num_wait, 1);
+    m_mutex_unlock(g->lock);
+  }
+}
 
 /* Return the number of workers */
 static inline size_t
@@ -446,6 +1571,274 @@ m_worker_count(m_worker_t g)
   return g->numWorker_g + 1;
 }
 
+/* Return the number of NUMA nodes of the workers of the pool
+   (1 if the workers are not placed by an affinity policy) */
+static inline unsigned int
+m_worker_node_count(m_worker_t g)
+{
+  return g->numNode_g;
+}
+
+/* Return the NUMA node of the current thread if it is a worker of the pool,
+   or -1 otherwise */
+static inline int
+m_worker_current_node(m_worker_t g)
+{
+  const m_work3r_thread_ct *self = m_work3r_get_self(g);
+  return self != NULL ? (int) self->node : -1;
+}
+
+/* Get in 's' a snapshot of the statistics of the pool of workers 'g'
+   (null statistics if they are disabled).
+   The counters are read without stopping the workers: the snapshot is
+   cheap, but not an atomic view of the pool. */
+static inline void
+m_worker_stats(m_worker_stats_t *s, m_worker_t g)
+{
+  M_ASSERT (s != NULL);
+  memset(s, 0, sizeof *s);
+#if M_USE_WORKER_STATS
+  for(unsigned int i = 0; i <= g->numWorker_g; i++) {
+    m_work3r_stats_ct *t = &g->stats[i];
+    s->spawned += atomic_load_explicit(&t->spawned, memory_order_relaxed);
+    s->executed += atomic_load_explicit(&t->executed, memory_order_relaxed);
+    s->inlined += atomic_load_explicit(&t->inlined, memory_order_relaxed);
+    s->stolen += atomic_load_explicit(&t->stolen, memory_order_relaxed);
+    s->sync_wait += atomic_load_explicit(&t->sync_wait, memory_order_relaxed);
+    for(unsigned int j = 0; j < M_WORKER_STATS_BUCKETS; j++) {
+      s->queue_wait[j] += atomic_load_explicit(&t->queue_wait[j], memory_order_relaxed);
+      s->run_time[j] += atomic_load_explicit(&t->run_time[j], memory_order_relaxed);
+    }
+  }
+#else
+  (void) g;
+#endif
+}
+
+/* Get in 's' a snapshot of the statistics of the thread 'index' of the pool
+   of workers 'g': a worker if index < m_worker_count(g) - 1,
+   otherwise all the threads which are not workers of the pool */
+static inline void
+m_worker_stats_thread(m_worker_thread_stats_t *s, m_worker_t g, size_t index)
+{
+  M_ASSERT (s != NULL && index < m_worker_count(g));
+  memset(s, 0, sizeof *s);
+#if M_USE_WORKER_STATS
+  m_work3r_stats_ct *t = &g->stats[index];
+  s->executed = atomic_load_explicit(&t->executed, memory_order_relaxed);
+  s->stolen = atomic_load_explicit(&t->stolen, memory_order_relaxed);
+  s->busy = atomic_load_explicit(&t->busy, memory_order_relaxed);
+  s->idle = atomic_load_explicit(&t->idle, memory_order_relaxed);
+#else
+  (void) g;
+  (void) index;
+#endif
+}
+
+/* Return the index of the current thread in the pool of workers 'g'
+   (the number of workers if the thread is not a worker of the pool) */
+static inline unsigned int
+m_work3r_self_index(struct m_worker_s *g)
+{
+  const m_work3r_thread_ct *self = m_work3r_get_self(g);
+  return self != NULL ? self->index : g->numWorker_g;
+}
+
+/* Definition of a parallel loop */
+typedef struct m_work3r_loop_s {
+  struct m_worker_s *worker;                         // Pool of workers
+  size_t grain;                                      // Size of a chunk
+  void (*func)(void *data, size_t begin, size_t end);// Function of a chunk
+  void *data;                                        // Data of the function
+} m_work3r_loop_ct;
+
+/* Definition of a sub-range of a parallel loop */
+typedef struct m_work3r_range_s {
+  const m_work3r_loop_ct *loop;
+  size_t begin, end;
+} m_work3r_range_ct;
+
+/* Test if the current thread shall split its range of the parallel loop
+   so that other threads can work on it (lazy binary splitting):
+   only when the previously split range of a worker has been stolen
+   (its deque is empty), or while the global queue can accept it
+   for a thread which is not a worker. */
+static inline bool
+m_work3r_split_p(struct m_worker_s *g)
+{
+  m_work3r_thread_ct *self = m_work3r_get_self(g);
+  if (self != NULL) {
+    const size_t t = atomic_load_explicit(&self->top, memory_order_relaxed);
+    const size_t b = atomic_load_explicit(&self->bottom, memory_order_relaxed);
+    return (ptrdiff_t) (b - t) <= 0;
+  }
+  return g->numWorker_g != 0 && !m_work3r_queue_full_p(g->queue_g);
+}
+
+/* Execute a sub-range of a parallel loop.
+   It is processed by chunks from its beginning, and its second half
+   is split as a new work order each time the thread is hungry. */
+static inline void
+m_work3r_loop_task(void *arg)
+{
+  const m_work3r_range_ct *r = M_ASSIGN_CAST(const m_work3r_range_ct *, arg);
+  const m_work3r_loop_ct *loop = r->loop;
+  size_t begin = r->begin, end = r->end;
+  // Each split halves the range: no more split than the number of bits
+  m_work3r_range_ct split[sizeof (size_t) * CHAR_BIT];
+  unsigned int num_split = 0;
+  m_worker_sync_t block;
+  m_worker_start(block, loop->worker);
+  while (end - begin > loop->grain) {
+    if (m_work3r_split_p(loop->worker)) {
+      M_ASSERT (num_split < sizeof split / sizeof split[0]);
+      const size_t middle = begin + (end - begin) / 2;
+      split[num_split].loop = loop;
+      split[num_split].begin = middle;
+      split[num_split].end = end;
+      m_worker_spawn(block, m_work3r_loop_task, &split[num_split]);
+      num_split++;
+      end = middle;
+    } else {
+      loop->func(loop->data, begin, begin + loop->grain);
+      begin += loop->grain;
+    }
+  }
+  loop->func(loop->data, begin, end);
+  m_worker_sync(block);
+}
+
+/* Execute func(data, i, j) for the consecutive chunks [i, j) which cover
+   the range [begin, end), using the pool of workers 'g'.
+   A chunk has at least 'grain' elements (except the last ones),
+   or a grain is automatically computed if 'grain' is 0.
+   The function returns once all chunks are executed. */
+static inline void
+m_worker_parallel_for(m_worker_t g, size_t begin, size_t end, size_t grain,
+                      void (*func)(void *data, size_t begin, size_t end), void *data)
+{
+  M_ASSERT (begin <= end && func != NULL);
+  if (begin == end) return;
+  if (grain == 0) {
+    // Target 8 chunks per thread
+    grain = M_MAX((size_t) 1, (end - begin) / (8 * m_worker_count(g)));
+  }
+  const m_work3r_loop_ct loop = { g, grain, func, data };
+  m_work3r_range_ct range = { &loop, begin, end };
+  m_work3r_loop_task(&range);
+}
+
+/* Define the parallel reduction function 'name' of the type 'type'
+   (with its oplist) using a pool of workers.
+   USAGE: M_WORKER_PARALLEL_REDUCE_DEF(name, type [, oplist]) */
+#define M_WORKER_PARALLEL_REDUCE_DEF(name, ...)                               \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_WORK3R_REDUCE_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                          \
+                         ((name, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)() ), \
+                          (name, __VA_ARGS__ )))                              \
+  M_END_PROTECTED_CODE
+
+/* Deferred evaluation for the definition,
+   so that all arguments are evaluated before further expansion */
+#define M_WORK3R_REDUCE_DEF_P1(arg) M_ID( M_WORK3R_REDUCE_DEF_P2 arg )
+
+/* Validate the oplist before going further */
+#define M_WORK3R_REDUCE_DEF_P2(name, type, oplist)                            \
+  M_IF_OPLIST(oplist)(M_WORK3R_REDUCE_DEF_P3, M_WORK3R_REDUCE_DEF_FAILURE)(name, type, oplist)
+
+/* Stop processing with a compilation failure */
+#define M_WORK3R_REDUCE_DEF_FAILURE(name, type, oplist)                       \
+  M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(M_WORKER_PARALLEL_REDUCE_DEF): the given argument is not a valid oplist: " #oplist)
+
+/* Define the parallel reduction.
+   Each thread reduces the chunks it executes in its own partial result
+   (on its own cache line). The partial results are reduced at the end. */
+#define M_WORK3R_REDUCE_DEF_P3(name, type, oplist)                            \
+  M_CHECK_COMPATIBLE_OPLIST(name, 1, type, oplist)                            \
+                                                                              \
+  typedef struct M_C3(m_work3r_,name,_partial_s) {                            \
+    type value;                                                               \
+    bool valid;                                                               \
+    M_CACHELINE_ALIGN(align, type, bool);                                     \
+  } M_C3(m_work3r_,name,_partial_ct);                                         \
+                                                                              \
+  typedef struct M_C3(m_work3r_,name,_ctx_s) {                                \
+    M_C3(m_work3r_,name,_partial_ct) *partial;                                \
+    struct m_worker_s *worker;                                                \
+    void (*map)(type *, void *, size_t, size_t);                              \
+    void (*reduce)(type *, type const);                                       \
+    void *data;                                                               \
+    /* Lock of the partial result shared by the threads not workers */       \
+    m_mutex_t lock;                                                           \
+  } M_C3(m_work3r_,name,_ctx_ct);                                             \
+                                                                              \
+  static inline void                                                          \
+  M_C3(m_work3r_,name,_chunk)(void *arg, size_t begin, size_t end)            \
+  {                                                                           \
+    M_C3(m_work3r_,name,_ctx_ct) *ctx =                                       \
+      M_ASSIGN_CAST(M_C3(m_work3r_,name,_ctx_ct) *, arg);                     \
+    const unsigned int i = m_work3r_self_index(ctx->worker);                  \
+    const bool shared = (i == ctx->worker->numWorker_g);                      \
+    M_C3(m_work3r_,name,_partial_ct) *p = &ctx->partial[i];                   \
+    type tmp;                                                                 \
+    M_CALL_INIT(oplist, tmp);                                                 \
+    ctx->map(&tmp, ctx->data, begin, end);                                    \
+    if (shared) {                                                             \
+      m_mutex_lock(ctx->lock);                                                \
+    }                                                                         \
+    if (p->valid) {                                                           \
+      ctx->reduce(&p->value, tmp);                                            \
+      M_CALL_CLEAR(oplist, tmp);                                              \
+    } else {                                                                  \
+      M_DO_INIT_MOVE(oplist, p->value, tmp);                                  \
+      p->valid = true;                                                        \
+    }                                                                         \
+    if (shared) {                                                             \
+      m_mutex_unlock(ctx->lock);                                              \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  name(type *dest, m_worker_t workers, size_t begin, size_t end, size_t grain, \
+       void (*map)(type *, void *, size_t, size_t),                           \
+       void (*reduce)(type *, type const), void *data)                        \
+  {                                                                           \
+    M_ASSERT (dest != NULL && map != NULL && reduce != NULL);                 \
+    const size_t n = m_worker_count(workers);                                 \
+    M_C3(m_work3r_,name,_ctx_ct) ctx;                                         \
+    ctx.partial = M_MEMORY_REALLOC(M_C3(m_work3r_,name,_partial_ct), NULL, n); \
+    if (M_UNLIKELY (ctx.partial == NULL)) {                                   \
+      M_MEMORY_FULL(sizeof (M_C3(m_work3r_,name,_partial_ct)) * n);           \
+      return;                                                                 \
+    }                                                                         \
+    for(size_t i = 0; i < n; i++) {                                           \
+      ctx.partial[i].valid = false;                                           \
+    }                                                                         \
+    ctx.worker = workers;                                                     \
+    ctx.map = map;                                                            \
+    ctx.reduce = reduce;                                                      \
+    ctx.data = data;                                                          \
+    m_mutex_init(ctx.lock);                                                   \
+    m_worker_parallel_for(workers, begin, end, grain,                         \
+                          M_C3(m_work3r_,name,_chunk), &ctx);                 \
+    m_mutex_clear(ctx.lock);                                                  \
+    /* Reduce the partial results of the threads */                          \
+    bool init_done = false;                                                   \
+    for(size_t i = 0; i < n; i++) {                                           \
+      if (!ctx.partial[i].valid) {                                            \
+        continue;                                                             \
+      }                                                                       \
+      if (init_done) {                                                        \
+        reduce(dest, ctx.partial[i].value);                                   \
+      } else {                                                                \
+        M_CALL_SET(oplist, *dest, ctx.partial[i].value);                      \
+        init_done = true;                                                     \
+      }                                                                       \
+      M_CALL_CLEAR(oplist, ctx.partial[i].value);                             \
+    }                                                                         \
+    M_MEMORY_FREE(ctx.partial);                                               \
+  }
+
 /* Spawn the 'core' block computation into another thread if
    a worker thread is available. Compute it in the current thread otherwise.
    'block' shall be the initialised synchronised block for all threads.
@@ -534,6 +1927,8 @@ M_END_PROTECTED_CODE
 
 /*   Define empty types and empty functions to not use any worker */
 
+#include "m-core.h"
+
 typedef struct m_worker_block_s {
   int x;
 } m_worker_sync_t[1];
@@ -542,19 +1937,450 @@ typedef struct m_worker_s {
   int x;
 } m_worker_t[1];
 
-#define m_worker_init(g, numWorker, extraQueue, resetFunc) do { (void) g; } while (0)
+#define m_worker_init(...) do { (void) M_RET_ARG1(__VA_ARGS__); } while (0)
 #define m_worker_clear(g) do { (void) g; } while (0)
 #define m_worker_start(b, w) do { (void) b; } while (0)
 #define m_worker_spawn(b, f, d) do { f(d); } while (0)
+#define m_worker_spawn_node(b, n, f, d) do { (void) (n); f(d); } while (0)
+#define m_worker_spawn_priority(b, p, f, ...)                                 \
+  do { (void) (p); f(M_RET_ARG1(__VA_ARGS__, )); } while (0)
+#define m_worker_queue_depth(w, p) ((void) (p), (size_t) 0)
+#define m_worker_stats(s, w) ((void) (w), (void) memset((s), 0, sizeof (m_worker_stats_t)))
+#define m_worker_stats_thread(s, w, i)                                        \
+  ((void) (w), (void) (i), (void) memset((s), 0, sizeof (m_worker_thread_stats_t)))
+#define m_worker_node_count(w) 1U
+#define m_worker_current_node(w) (-1)
 #define m_worker_sync_p(b) true
 #define m_worker_sync(b) do { (void) b; } while (0)
 #define m_worker_count(w) 1
 #define m_worker_flush(w) do { (void) w; } while (0)
 #define M_WORKER_SPAWN(b, i, c, o) do { c } while (0)
+#define m_worker_parallel_for(w, b, e, g, f, d)                               \
+  do { (void) (w); (void) (g); if ((b) < (e)) (f)((d), (b), (e)); } while (0)
+
+#define M_WORKER_PARALLEL_REDUCE_DEF(name, ...)                               \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_WORK3R_REDUCE_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                          \
+                         ((name, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)() ), \
+                          (name, __VA_ARGS__ )))                              \
+  M_END_PROTECTED_CODE
+#define M_WORK3R_REDUCE_DEF_P1(arg) M_ID( M_WORK3R_REDUCE_DEF_P2 arg )
+#define M_WORK3R_REDUCE_DEF_P2(name, type, oplist)                            \
+  M_IF_OPLIST(oplist)(M_WORK3R_REDUCE_DEF_P3, M_WORK3R_REDUCE_DEF_FAILURE)(name, type, oplist)
+#define M_WORK3R_REDUCE_DEF_FAILURE(name, type, oplist)                       \
+  M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(M_WORKER_PARALLEL_REDUCE_DEF): the given argument is not a valid oplist: " #oplist)
+/* Without worker, the whole range is a single chunk */
+#define M_WORK3R_REDUCE_DEF_P3(name, type, oplist)                            \
+  M_CHECK_COMPATIBLE_OPLIST(name, 1, type, oplist)                            \
+  static inline void                                                          \
+  name(type *dest, m_worker_t workers, size_t begin, size_t end, size_t grain, \
+       void (*map)(type *, void *, size_t, size_t),                           \
+       void (*reduce)(type *, type const), void *data)                        \
+  {                                                                           \
+    M_ASSERT (dest != NULL && map != NULL && reduce != NULL);                 \
+    (void) workers;                                                           \
+    (void) grain;                                                             \
+    (void) reduce;                                                            \
+    if (begin < end) {                                                        \
+      map(dest, data, begin, end);                                            \
+    }                                                                         \
+  }
+
+/* Without worker, the continuations of the futures are run immediately:
+   a future is always ready once it has been defined */
+static inline void
+m_work3r_async(struct m_worker_s *g, void (*func)(void *data), void *data)
+{
+  (void) g;
+  func(data);
+}
+
+static inline void
+m_work3r_future_wake(m_work3r_future_ct *f)
+{
+  (void) f;
+}
+
+static inline void
+m_work3r_future_wait(m_work3r_future_ct *f)
+{
+  M_ASSERT (m_work3r_future_ready_p(f));
+  (void) f;
+}
 
 #endif /* M_USE_WORKER */
 
 
+M_BEGIN_PROTECTED_CODE
+
+/* Initialize the generic part of a future (with one reference) */
+static inline void
+m_work3r_future_init(m_work3r_future_ct *f, struct m_worker_s *g, void (*del)(void *))
+{
+  atomic_init(&f->cpt, 1);
+  atomic_init(&f->num_wait, 0);
+  atomic_init(&f->cont, (uintptr_t) 0);
+  f->worker = g;
+  f->del = del;
+}
+
+/* Acquire a reference to the future */
+static inline void
+m_work3r_future_ref(m_work3r_future_ct *f)
+{
+  atomic_fetch_add(&f->cpt, 1);
+}
+
+/* Release a reference to the future, and destroy it if it was the last one */
+static inline void
+m_work3r_future_unref(m_work3r_future_ct *f)
+{
+  if (atomic_fetch_sub(&f->cpt, 1) == 1) {
+    f->del(f);
+  }
+}
+
+/* Register the continuation 'c' of the future 'f':
+   it is spawned once the future is ready (now if it is already ready) */
+static inline void
+m_work3r_future_then(m_work3r_future_ct *f, m_work3r_cont_ct *c)
+{
+  uintptr_t head = atomic_load(&f->cont);
+  do {
+    if (head == M_WORK3R_FUTURE_READY) {
+      m_work3r_async(f->worker, c->func, c);
+      return;
+    }
+    c->next = (m_work3r_cont_ct *) head;
+  } while (!atomic_compare_exchange_weak(&f->cont, &head, (uintptr_t) c));
+}
+
+/* Set the future 'f' as ready (its value is computed)
+   and spawn its registered continuations */
+static inline void
+m_work3r_future_set_ready(m_work3r_future_ct *f)
+{
+  uintptr_t head = atomic_exchange(&f->cont, M_WORK3R_FUTURE_READY);
+  M_ASSERT (head != M_WORK3R_FUTURE_READY);
+  m_work3r_future_wake(f);
+  m_work3r_cont_ct *c = (m_work3r_cont_ct *) head;
+  while (c != NULL) {
+    // The continuation may be freed as soon as it is spawned
+    m_work3r_cont_ct *next = c->next;
+    m_work3r_async(f->worker, c->func, c);
+    c = next;
+  }
+}
+
+M_END_PROTECTED_CODE
+
+/* Define a future named 'name' of a value of type 'type':
+   a shared handle to a value computed asynchronously by the workers.
+   USAGE: M_WORKER_FUTURE_DEF(name, type [, oplist]) */
+#define M_WORKER_FUTURE_DEF(name, ...)                                        \
+  M_BEGIN_PROTECTED_CODE                                                      \
+  M_WORK3R_FUTURE_DEF_P1(M_IF_NARGS_EQ1(__VA_ARGS__)                          \
+                         ((name, __VA_ARGS__, M_GLOBAL_OPLIST_OR_DEF(__VA_ARGS__)() ), \
+                          (name, __VA_ARGS__ )))                              \
+  M_END_PROTECTED_CODE
+
+/* Deferred evaluation */
+#define M_WORK3R_FUTURE_DEF_P1(arg) M_ID( M_WORK3R_FUTURE_DEF_P2 arg )
+
+/* Validate the oplist before going further */
+#define M_WORK3R_FUTURE_DEF_P2(name, type, oplist)                            \
+  M_IF_OPLIST(oplist)(M_WORK3R_FUTURE_DEF_P3, M_WORK3R_FUTURE_DEF_FAILURE)(name, type, oplist)
+
+/* Stop processing with a compilation failure */
+#define M_WORK3R_FUTURE_DEF_FAILURE(name, type, oplist)                       \
+  M_STATIC_FAILURE(M_LIB_NOT_AN_OPLIST, "(M_WORKER_FUTURE_DEF): the given argument is not a valid oplist: " #oplist)
+
+/* Define the future.
+   The value of a future is computed either by a function spawned to the
+   workers (_spawn_async), or by a continuation of other futures (_then,
+   _when_all, _when_any) spawned once these futures are ready: no thread
+   waits for the sources of a future.
+   Each registered continuation owns a reference to the future it computes
+   and to its source future, released once it has been executed. */
+#define M_WORK3R_FUTURE_DEF_P3(name, type, oplist)                            \
+  M_CHECK_COMPATIBLE_OPLIST(name, 1, type, oplist)                            \
+                                                                              \
+  typedef struct M_C(name, _s) {                                              \
+    m_work3r_future_ct base;            /* Shall be the first field */        \
+    type value;                                                               \
+    /* Computation of the value */                                            \
+    void (*async)(type *, void *);                                            \
+    void (*map)(type *, type const, void *);                                  \
+    void (*reduce)(type *, type const);                                       \
+    void *data;                                                               \
+    /* Sources of the value and their continuations */                        \
+    size_t num_src;                                                           \
+    atomic_size_t remaining;            /* Sources not ready yet */           \
+    struct M_C(name, _s) **src;                                               \
+    m_work3r_cont_ct *cont;                                                   \
+    struct M_C(name, _s) *src1;         /* Storage for one source */          \
+    m_work3r_cont_ct cont1;                                                   \
+  } *M_C(name, _t)[1];                                                        \
+                                                                              \
+  static inline void                                                          \
+  M_C3(m_work3r_, name, _del)(void *arg)                                      \
+  {                                                                           \
+    struct M_C(name, _s) *f = M_ASSIGN_CAST(struct M_C(name, _s) *, arg);     \
+    M_CALL_CLEAR(oplist, f->value);                                           \
+    if (f->src != &f->src1) {                                                 \
+      M_MEMORY_FREE(f->src);                                                  \
+      M_MEMORY_FREE(f->cont);                                                 \
+    }                                                                         \
+    M_MEMORY_DEL(f);                                                          \
+  }                                                                           \
+                                                                              \
+  /* Create a new future computed from 'num_src' source futures */            \
+  static inline struct M_C(name, _s) *                                        \
+  M_C3(m_work3r_, name, _new)(struct m_worker_s *g, size_t num_src)           \
+  {                                                                           \
+    struct M_C(name, _s) *f = M_MEMORY_ALLOC(struct M_C(name, _s));           \
+    if (M_UNLIKELY (f == NULL)) {                                             \
+      M_MEMORY_FULL(sizeof (struct M_C(name, _s)));                           \
+      return NULL;                                                            \
+    }                                                                         \
+    f->src = &f->src1;                                                        \
+    f->cont = &f->cont1;                                                      \
+    if (num_src > 1) {                                                        \
+      f->src = M_MEMORY_REALLOC(struct M_C(name, _s) *, NULL, num_src);       \
+      f->cont = M_MEMORY_REALLOC(m_work3r_cont_ct, NULL, num_src);            \
+      if (M_UNLIKELY (f->src == NULL || f->cont == NULL)) {                   \
+        /* Free what has been allocated */                                    \
+        if (f->src != NULL) {                                                 \
+          M_MEMORY_FREE(f->src);                                              \
+        }                                                                     \
+        if (f->cont != NULL) {                                                \
+          M_MEMORY_FREE(f->cont);                                             \
+        }                                                                     \
+        M_MEMORY_DEL(f);                                                      \
+        M_MEMORY_FULL(sizeof (m_work3r_cont_ct) * num_src);                   \
+        return NULL;                                                          \
+      }                                                                       \
+    }                                                                         \
+    m_work3r_future_init(&f->base, g, M_C3(m_work3r_, name, _del));           \
+    M_CALL_INIT(oplist, f->value);                                            \
+    f->async = NULL;                                                          \
+    f->map = NULL;                                                            \
+    f->reduce = NULL;                                                         \
+    f->data = NULL;                                                           \
+    f->num_src = num_src;                                                     \
+    atomic_init(&f->remaining, num_src);                                      \
+    return f;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Register the continuation 'func' of 'f' on all its sources */            \
+  static inline void                                                          \
+  M_C3(m_work3r_, name, _register)(struct M_C(name, _s) *f,                   \
+                                   struct M_C(name, _s) *const *src,          \
+                                   void (*func)(void *))                      \
+  {                                                                           \
+    const size_t n = f->num_src;                                              \
+    /* All the continuations shall be defined before the first one runs */    \
+    for(size_t i = 0; i < n; i++) {                                           \
+      M_ASSERT (src[i] != NULL);                                              \
+      f->src[i] = src[i];                                                     \
+      m_work3r_future_ref(&src[i]->base);                                     \
+      m_work3r_future_ref(&f->base);                                          \
+      f->cont[i].next = NULL;                                                 \
+      f->cont[i].func = func;                                                 \
+      f->cont[i].owner = f;                                                   \
+      f->cont[i].index = i;                                                   \
+    }                                                                         \
+    for(size_t i = 0; i < n; i++) {                                           \
+      m_work3r_future_then(&f->src[i]->base, &f->cont[i]);                    \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  /* Reference the new future 'f' by the handle 'fut' */                      \
+  static inline void                                                          \
+  M_C3(m_work3r_, name, _reset)(M_C(name, _t) fut, struct M_C(name, _s) *f)   \
+  {                                                                           \
+    if (*fut != NULL) {                                                       \
+      m_work3r_future_unref(&(*fut)->base);                                   \
+    }                                                                         \
+    *fut = f;                                                                 \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C3(m_work3r_, name, _async_task)(void *arg)                               \
+  {                                                                           \
+    struct M_C(name, _s) *f = M_ASSIGN_CAST(struct M_C(name, _s) *, arg);     \
+    f->async(&f->value, f->data);                                             \
+    m_work3r_future_set_ready(&f->base);                                      \
+    m_work3r_future_unref(&f->base);                                          \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C3(m_work3r_, name, _then_task)(void *arg)                                \
+  {                                                                           \
+    m_work3r_cont_ct *c = M_ASSIGN_CAST(m_work3r_cont_ct *, arg);             \
+    struct M_C(name, _s) *f = M_ASSIGN_CAST(struct M_C(name, _s) *, c->owner); \
+    struct M_C(name, _s) *s = f->src[0];                                      \
+    f->map(&f->value, s->value, f->data);                                     \
+    m_work3r_future_set_ready(&f->base);                                      \
+    m_work3r_future_unref(&s->base);                                          \
+    m_work3r_future_unref(&f->base);                                          \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C3(m_work3r_, name, _all_task)(void *arg)                                 \
+  {                                                                           \
+    m_work3r_cont_ct *c = M_ASSIGN_CAST(m_work3r_cont_ct *, arg);             \
+    struct M_C(name, _s) *f = M_ASSIGN_CAST(struct M_C(name, _s) *, c->owner); \
+    /* Only the continuation of the last ready source computes the value */   \
+    if (atomic_fetch_sub(&f->remaining, 1) == 1) {                            \
+      const size_t n = f->num_src;                                            \
+      if (f->reduce != NULL) {                                                \
+        M_CALL_SET(oplist, f->value, f->src[0]->value);                       \
+        for(size_t i = 1; i < n; i++) {                                       \
+          f->reduce(&f->value, f->src[i]->value);                             \
+        }                                                                     \
+      }                                                                       \
+      m_work3r_future_set_ready(&f->base);                                    \
+      for(size_t i = 0; i < n; i++) {                                         \
+        m_work3r_future_unref(&f->src[i]->base);                              \
+      }                                                                       \
+    }                                                                         \
+    m_work3r_future_unref(&f->base);                                          \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C3(m_work3r_, name, _any_task)(void *arg)                                 \
+  {                                                                           \
+    m_work3r_cont_ct *c = M_ASSIGN_CAST(m_work3r_cont_ct *, arg);             \
+    struct M_C(name, _s) *f = M_ASSIGN_CAST(struct M_C(name, _s) *, c->owner); \
+    struct M_C(name, _s) *s = f->src[c->index];                               \
+    /* Only the continuation of the first ready source sets the value */      \
+    if (atomic_exchange(&f->remaining, 0) != 0) {                             \
+      M_CALL_SET(oplist, f->value, s->value);                                 \
+      m_work3r_future_set_ready(&f->base);                                    \
+    }                                                                         \
+    m_work3r_future_unref(&s->base);                                          \
+    m_work3r_future_unref(&f->base);                                          \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init)(M_C(name, _t) fut)                                         \
+  {                                                                           \
+    *fut = NULL;                                                              \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _init_set)(M_C(name, _t) fut, const M_C(name, _t) src)            \
+  {                                                                           \
+    *fut = *src;                                                              \
+    if (*fut != NULL) {                                                       \
+      m_work3r_future_ref(&(*fut)->base);                                     \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _set)(M_C(name, _t) fut, const M_C(name, _t) src)                 \
+  {                                                                           \
+    if (*src != NULL) {                                                       \
+      m_work3r_future_ref(&(*src)->base);                                     \
+    }                                                                         \
+    M_C3(m_work3r_, name, _reset)(fut, *src);                                 \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _clear)(M_C(name, _t) fut)                                        \
+  {                                                                           \
+    M_C3(m_work3r_, name, _reset)(fut, NULL);                                 \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _spawn_async)(M_C(name, _t) fut, m_worker_t workers,              \
+                          void (*func)(type *, void *), void *data)           \
+  {                                                                           \
+    M_ASSERT (func != NULL);                                                  \
+    struct M_C(name, _s) *f = M_C3(m_work3r_, name, _new)(workers, 0);        \
+    if (M_UNLIKELY (f == NULL)) {                                             \
+      return;                                                                 \
+    }                                                                         \
+    f->async = func;                                                          \
+    f->data = data;                                                           \
+    /* Reference owned by the spawned work order */                           \
+    m_work3r_future_ref(&f->base);                                            \
+    M_C3(m_work3r_, name, _reset)(fut, f);                                    \
+    m_work3r_async(workers, M_C3(m_work3r_, name, _async_task), f);           \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _then)(M_C(name, _t) dst, const M_C(name, _t) src,                \
+                   void (*func)(type *, type const, void *), void *data)      \
+  {                                                                           \
+    M_ASSERT (*src != NULL && func != NULL);                                  \
+    struct M_C(name, _s) *f = M_C3(m_work3r_, name, _new)((*src)->base.worker, 1); \
+    if (M_UNLIKELY (f == NULL)) {                                             \
+      return;                                                                 \
+    }                                                                         \
+    f->map = func;                                                            \
+    f->data = data;                                                           \
+    M_C3(m_work3r_, name, _register)(f, src, M_C3(m_work3r_, name, _then_task)); \
+    M_C3(m_work3r_, name, _reset)(dst, f);                                    \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _when_all)(M_C(name, _t) dst, size_t n, M_C(name, _t) *src,       \
+                       void (*reduce)(type *, type const))                    \
+  {                                                                           \
+    M_ASSERT (n > 0 && src != NULL && *src[0] != NULL);                       \
+    struct M_C(name, _s) *f = M_C3(m_work3r_, name, _new)((*src[0])->base.worker, n); \
+    if (M_UNLIKELY (f == NULL)) {                                             \
+      return;                                                                 \
+    }                                                                         \
+    f->reduce = reduce;                                                       \
+    /* Gather the sources before the handle 'dst' (maybe a source) is reset */ \
+    for(size_t i = 0; i < n; i++) {                                           \
+      f->src[i] = *src[i];                                                    \
+    }                                                                         \
+    M_C3(m_work3r_, name, _register)(f, f->src, M_C3(m_work3r_, name, _all_task)); \
+    M_C3(m_work3r_, name, _reset)(dst, f);                                    \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _when_any)(M_C(name, _t) dst, size_t n, M_C(name, _t) *src)       \
+  {                                                                           \
+    M_ASSERT (n > 0 && src != NULL && *src[0] != NULL);                       \
+    struct M_C(name, _s) *f = M_C3(m_work3r_, name, _new)((*src[0])->base.worker, n); \
+    if (M_UNLIKELY (f == NULL)) {                                             \
+      return;                                                                 \
+    }                                                                         \
+    for(size_t i = 0; i < n; i++) {                                           \
+      f->src[i] = *src[i];                                                    \
+    }                                                                         \
+    M_C3(m_work3r_, name, _register)(f, f->src, M_C3(m_work3r_, name, _any_task)); \
+    M_C3(m_work3r_, name, _reset)(dst, f);                                    \
+  }                                                                           \
+                                                                              \
+  static inline bool                                                          \
+  M_C(name, _ready_p)(const M_C(name, _t) fut)                                \
+  {                                                                           \
+    M_ASSERT (*fut != NULL);                                                  \
+    return m_work3r_future_ready_p(&(*fut)->base);                            \
+  }                                                                           \
+                                                                              \
+  static inline void                                                          \
+  M_C(name, _wait)(const M_C(name, _t) fut)                                   \
+  {                                                                           \
+    M_ASSERT (*fut != NULL);                                                  \
+    m_work3r_future_wait(&(*fut)->base);                                      \
+  }                                                                           \
+                                                                              \
+  static inline type *                                                        \
+  M_C(name, _get)(const M_C(name, _t) fut)                                    \
+  {                                                                           \
+    M_C(name, _wait)(fut);                                                    \
+    return &(*fut)->value;                                                    \
+  }
+
+
+
 #if M_USE_SMALL_NAME
 #define worker_t      m_worker_t
 #define worker_sync_t m_worker_sync_t
@@ -566,7 +2392,30 @@ typedef struct m_worker_s {
 #define worker_sync   m_worker_sync
 #define worker_count  m_worker_count
 #define worker_flush  m_worker_flush
+#define worker_spawn_node m_worker_spawn_node
+#define worker_node_count m_worker_node_count
+#define worker_current_node m_worker_current_node
+#define worker_spawn_priority m_worker_spawn_priority
+#define worker_queue_depth m_worker_queue_depth
+#define worker_stats m_worker_stats
+#define worker_stats_thread m_worker_stats_thread
+#define worker_stats_t m_worker_stats_t
+#define worker_thread_stats_t m_worker_thread_stats_t
+#define worker_priority_e m_worker_priority_e
+#define WORKER_PRIORITY_HIGH M_WORKER_PRIORITY_HIGH
+#define WORKER_PRIORITY_NORMAL M_WORKER_PRIORITY_NORMAL
+#define WORKER_PRIORITY_LOW M_WORKER_PRIORITY_LOW
+#define WORKER_NO_DEADLINE M_WORKER_NO_DEADLINE
+#define worker_affinity_t m_worker_affinity_t
+#define WORKER_AFFINITY_NONE M_WORKER_AFFINITY_NONE
+#define WORKER_AFFINITY_COMPACT M_WORKER_AFFINITY_COMPACT
+#define WORKER_AFFINITY_SCATTER M_WORKER_AFFINITY_SCATTER
+#define WORKER_AFFINITY_CPU_LIST M_WORKER_AFFINITY_CPU_LIST
+#define WORKER_AFFINITY_NODE M_WORKER_AFFINITY_NODE
 #define WORKER_SPAWN  M_WORKER_SPAWN
+#define worker_parallel_for m_worker_parallel_for
+#define WORKER_PARALLEL_REDUCE_DEF M_WORKER_PARALLEL_REDUCE_DEF
+#define WORKER_FUTURE_DEF M_WORKER_FUTURE_DEF
 #endif
 
 #endif
@@ -27,6 +27,8 @@
 #include "m-deque.h"
 #include "m-dict.h"
 #include "m-tuple.h"
+#include "m-atomic.h"
+#include "m-worker.h"
 #include "m-algo.h"
 
 #include "test-obj.h"
@@ -95,6 +97,21 @@ static void func_reduce(int *d, int n)
   *d += n;
 }
 
+static atomic_int g_pcount;
+
+static void g_pf(int n)
+{
+  assert (g_min <= n && n <= g_max);
+  atomic_fetch_add(&g_pcount, 1);
+}
+
+static void func_pmap(int *d, int n)
+{
+  assert (g_min <= n && n <= g_max);
+  atomic_fetch_add(&g_pcount, 1);
+  *d = n * n;
+}
+
 static bool func_test_42(int d)
 {
   return d == 42;
@@ -715,6 +732,36 @@ FUNC_OBJ_INS_DEF(fol_cmp, algo_list_fo_cmp_obj,
   }  
 }
 
+static void test_parallel(void)
+{
+  worker_t w;
+  worker_init(w, 3, 0, NULL);
+  M_LET(l, array_int_t) {
+    for(int i = 0; i < 10000; i++)
+      array_int_push_back(l, i % 100);
+    g_min = 0;
+    g_max = 99;
+    atomic_init(&g_pcount, 0);
+    algo_array_parallel_for_each(l, g_pf, w);
+    assert(atomic_load(&g_pcount) == 10000);
+
+    int n = -1;
+    atomic_init(&g_pcount, 0);
+    algo_array_parallel_map_reduce(&n, l, func_reduce, func_pmap, w);
+    assert(atomic_load(&g_pcount) == 10000);
+    assert(n == 100 * 328350);
+
+    // Nothing is done on an empty container
+    array_int_reset(l);
+    n = -1;
+    algo_array_parallel_for_each(l, g_pf, w);
+    algo_array_parallel_map_reduce(&n, l, func_reduce, func_pmap, w);
+    assert(atomic_load(&g_pcount) == 10000);
+    assert(n == -1);
+  }
+  worker_clear(w);
+}
+
 int main(void)
 {
   test_list();
@@ -724,5 +771,6 @@ int main(void)
   test_insert();
   test_string_utf8();
   test_fo();
+  test_parallel();
   exit(0);
 }
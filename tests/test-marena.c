@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#define M_USE_STRING_ALLOCATOR 1
+#include "m-arena.h"
+#include "m-list.h"
+#include "m-rbtree.h"
+#include "m-dict.h"
+#include "m-string.h"
+
+#define ACTX_OPLIST M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default()))
+
+LIST_DEF(list_uint, unsigned int, ACTX_OPLIST)
+RBTREE_DEF(rbtree_uint, unsigned int, ACTX_OPLIST)
+DICT_DEF2(dict_uint, unsigned int, ACTX_OPLIST, unsigned int, M_BASIC_OPLIST)
+
+static void test_alloc(void)
+{
+  m_arena_t a;
+  m_arena_init(a);
+  assert(m_arena_capacity(a) == 0);
+  m_arena_mark_t m0 = m_arena_mark(a);
+
+  char *p1 = (char *) m_arena_alloc(a, 1);
+  char *p2 = (char *) m_arena_alloc(a, 3);
+  assert(p1 != NULL && p2 != NULL);
+  assert(((uintptr_t) p1 % M_AR3NA_ALIGN) == 0);
+  assert(((uintptr_t) p2 % M_AR3NA_ALIGN) == 0);
+  assert(p2 > p1);
+  assert(m_arena_capacity(a) == M_USE_ARENA_CHUNK_SIZE);
+  memset(p2, 'a', 3);
+
+  /* Growing the last block is performed in place */
+  char *p3 = (char *) m_arena_realloc(a, p2, 3, 100);
+  assert(p3 == p2);
+  assert(p3[0] == 'a' && p3[2] == 'a');
+  /* Shrinking or growing within the alignment is performed in place */
+  assert(m_arena_realloc(a, p1, 1, M_AR3NA_ALIGN) == p1);
+  /* Not the last block: it is moved */
+  char *p4 = (char *) m_arena_realloc(a, p1, 1, 100);
+  assert(p4 != p1 && p4 > p3);
+  /* Freeing the last block reclaims it */
+  m_arena_free(a, p4, 100);
+  assert(m_arena_alloc(a, 10) == p4);
+
+  /* Rewind to a mark */
+  m_arena_mark_t m1 = m_arena_mark(a);
+  char *p5 = (char *) m_arena_alloc(a, 1000);
+  for(int i = 0; i < 100; i++)
+    assert(m_arena_alloc(a, 1000) != NULL);
+  size_t cap = m_arena_capacity(a);
+  assert(cap > M_USE_ARENA_CHUNK_SIZE);
+  m_arena_rewind(a, m1);
+  assert(m_arena_alloc(a, 1000) == p5);
+  /* The chunks are reused */
+  for(int i = 0; i < 100; i++)
+    assert(m_arena_alloc(a, 1000) != NULL);
+  assert(m_arena_capacity(a) == cap);
+
+  /* A block bigger than a chunk */
+  char *big = (char *) m_arena_alloc(a, 10 * M_USE_ARENA_CHUNK_SIZE);
+  assert(big != NULL);
+  memset(big, 0, 10 * M_USE_ARENA_CHUNK_SIZE);
+
+  /* Reset and rewind to the initial mark release everything */
+  m_arena_reset(a);
+  assert(m_arena_alloc(a, 1) == p1);
+  m_arena_rewind(a, m0);
+  assert(m_arena_alloc(a, 1) == p1);
+  m_arena_clear(a);
+}
+
+static void test_containers(void)
+{
+  m_arena_t a;
+  m_arena_init(a);
+  const m_allocator_t *alloc = m_arena_allocator(a);
+
+  for(unsigned k = 0; k < 10; k++) {
+    m_arena_mark_t mark = m_arena_mark(a);
+    list_uint_t l;
+    rbtree_uint_t t;
+    dict_uint_t d;
+    string_t s;
+    list_uint_init_allocator(l, alloc);
+    rbtree_uint_init_allocator(t, alloc);
+    dict_uint_init_allocator(d, alloc);
+    string_init_allocator(s, alloc);
+    for(unsigned i = 0; i < 1000; i++) {
+      list_uint_push_back(l, i);
+      rbtree_uint_push(t, i * k);
+      dict_uint_set_at(d, i, i + k);
+      string_cat_printf(s, "%u", i);
+    }
+    assert(list_uint_size(l) == 1000);
+    assert(rbtree_uint_size(t) == (k == 0 ? 1 : 1000));
+    assert(dict_uint_size(d) == 1000);
+    assert(*dict_uint_get(d, 999) == 999 + k);
+    assert(string_start_with_str_p(s, "0123456789"));
+    /* No need to clear the containers: everything is released at once */
+    m_arena_rewind(a, mark);
+  }
+  size_t cap = m_arena_capacity(a);
+
+  /* The containers can still be cleared normally before a reset */
+  list_uint_t l;
+  list_uint_init_allocator(l, alloc);
+  for(unsigned i = 0; i < 1000; i++)
+    list_uint_push_back(l, i);
+  list_uint_clear(l);
+  m_arena_reset(a);
+  assert(m_arena_capacity(a) == cap);
+  m_arena_clear(a);
+}
+
+int main(void)
+{
+  test_alloc();
+  test_containers();
+  exit(0);
+}
@@ -44,6 +44,9 @@ ARRAY_DEF_AS(array_double, ArrayDouble, ArrayDoubleIt, double)
 
 ArrayDouble g_array = ARRAY_INIT_VALUE();
 
+// Array using a stateful allocator
+ARRAY_DEF(array_actx, unsigned int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())))
+
 static void test_uint(void)
 {
   array_uint_t v;
@@ -444,6 +447,39 @@ static void test_double(void)
   array_double_clear(g_array);
 }
 
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  array_actx_t a1, a2, a3;
+  array_actx_init_allocator(a1, &alloc->interface);
+  array_actx_init(a2);
+  assert(array_actx_allocator(a1) == &alloc->interface);
+  assert(array_actx_allocator(a2) == m_core_allocator_default());
+  for(unsigned i = 0; i < 1000; i++)
+    array_actx_push_back(a1, 1000 - i);
+  assert(alloc->blocks == 1);
+  assert(alloc->bytes == array_actx_capacity(a1) * sizeof (unsigned));
+  array_actx_special_stable_sort(a1);
+  assert(alloc->blocks == 1);
+  array_actx_init_set(a3, a1);
+  assert(array_actx_allocator(a3) == &alloc->interface);
+  assert(alloc->blocks == 2);
+  array_actx_push_back(a2, 17);
+  array_actx_swap(a2, a3);
+  assert(array_actx_allocator(a2) == &alloc->interface);
+  assert(array_actx_allocator(a3) == m_core_allocator_default());
+  array_actx_reserve(a1, 0);
+  assert(alloc->blocks == 2);
+  array_actx_reset(a1);
+  array_actx_reserve(a1, 0);
+  assert(alloc->blocks == 1);
+  array_actx_clear(a3);
+  array_actx_move(a1, a2);
+  array_actx_clear(a1);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
 // Test support of M*LIB for C++ class
 #if defined(__cplusplus)
 
@@ -532,6 +568,7 @@ int main(void)
   test_d();
   test_str();
   test_double();
+  test_allocator();
   test_cplusplus();
   exit(0);
 }
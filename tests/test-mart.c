@@ -0,0 +1,330 @@
+/*
+ * M*LIB - Test for Adaptive Radix Tree
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "test-obj.h"
+#include "m-art.h"
+#include "m-bptree.h"
+#include "m-string.h"
+
+ART_DEF2(art_int, int, M_BASIC_OPLIST, int, M_BASIC_OPLIST)
+BPTREE_DEF2(ref_int, 5, int, M_BASIC_OPLIST, int, M_BASIC_OPLIST)
+
+ART_DEF2(art_u64, uint64_t, M_BASIC_OPLIST, int, M_BASIC_OPLIST)
+
+ART_DEF2(art_d, double, M_OPL_double(), int, M_BASIC_OPLIST)
+
+ART_DEF2(art_str, string_t, STRING_OPLIST, int, M_BASIC_OPLIST)
+#define M_OPL_art_str_t() ART_OPLIST2(art_str, STRING_OPLIST, M_BASIC_OPLIST)
+BPTREE_DEF2(ref_str, 5, string_t, STRING_OPLIST, int, M_BASIC_OPLIST)
+
+/* Compare the radix tree with a reference tree */
+static void check_int(art_int_t t, ref_int_t r)
+{
+  assert(art_int_size(t) == ref_int_size(r));
+  art_int_it_t it;
+  ref_int_it_t it2;
+  for(art_int_it(it, t), ref_int_it(it2, r);
+      !art_int_end_p(it);
+      art_int_next(it), ref_int_next(it2)) {
+    assert(!ref_int_end_p(it2));
+    assert(*art_int_cref(it)->key_ptr == *ref_int_cref(it2)->key_ptr);
+    assert(*art_int_cref(it)->value_ptr == *ref_int_cref(it2)->value_ptr);
+  }
+  assert(ref_int_end_p(it2));
+}
+
+static void check_str(art_str_t t, ref_str_t r)
+{
+  assert(art_str_size(t) == ref_str_size(r));
+  art_str_it_t it;
+  ref_str_it_t it2;
+  for(art_str_it(it, t), ref_str_it(it2, r);
+      !art_str_end_p(it);
+      art_str_next(it), ref_str_next(it2)) {
+    assert(!ref_str_end_p(it2));
+    assert(string_equal_p(*art_str_cref(it)->key_ptr, *ref_str_cref(it2)->key_ptr));
+    assert(*art_str_cref(it)->value_ptr == *ref_str_cref(it2)->value_ptr);
+  }
+  assert(ref_str_end_p(it2));
+}
+
+static void test_int(void)
+{
+  art_int_t tree;
+  ref_int_t ref;
+  art_int_init(tree);
+  ref_int_init(ref);
+
+  assert(art_int_empty_p(tree));
+  art_int_it_t it;
+  art_int_it(it, tree);
+  assert(art_int_end_p(it));
+  art_int_it_from(it, tree, 10);
+  assert(art_int_end_p(it));
+  assert(art_int_get(tree, 10) == NULL);
+  assert(!art_int_erase(tree, 10));
+
+  /* Random keys (negative ones are ordered before positive ones) */
+  for(int i = 0; i < 20000; i++) {
+    int k = rand() % 4000 - 2000;
+    if (rand() % 3 != 0) {
+      art_int_set_at(tree, k, i);
+      ref_int_set_at(ref, k, i);
+    } else {
+      bool b = art_int_erase(tree, k);
+      assert(b == ref_int_erase(ref, k));
+    }
+  }
+  check_int(tree, ref);
+  for(int k = -2010; k < 2010; k++) {
+    int *p = ref_int_get(ref, k);
+    const int *q = art_int_cget(tree, k);
+    assert((p == NULL) == (q == NULL));
+    if (p != NULL) assert(*p == *q);
+    /* Lower bound */
+    ref_int_it_t it2;
+    art_int_it_from(it, tree, k);
+    ref_int_it_from(it2, ref, k);
+    assert(art_int_end_p(it) == ref_int_end_p(it2));
+    if (!art_int_end_p(it))
+      assert(*art_int_cref(it)->key_ptr == *ref_int_cref(it2)->key_ptr);
+  }
+  ref_int_it_t it2;
+  ref_int_it(it2, ref);
+  art_int_it_from(it, tree, INT_MIN);
+  assert(*art_int_cref(it)->key_ptr == *ref_int_cref(it2)->key_ptr);
+  art_int_it_from(it, tree, INT_MAX);
+  assert(art_int_end_p(it));
+
+  /* Dense keys grow the nodes up to Node256, then removing them
+     shrinks the nodes down to Node4 */
+  art_int_reset(tree);
+  ref_int_reset(ref);
+  for(int k = 0; k < 100000; k++) {
+    art_int_set_at(tree, k * 7, k);
+    ref_int_set_at(ref, k * 7, k);
+  }
+  check_int(tree, ref);
+  for(int k = 0; k < 100000; k++) {
+    if (k % 97 != 0) {
+      assert(art_int_erase(tree, k * 7));
+      ref_int_erase(ref, k * 7);
+    }
+  }
+  check_int(tree, ref);
+
+  /* Copy, move and equal */
+  art_int_t tree2;
+  art_int_init_set(tree2, tree);
+  assert(art_int_equal_p(tree, tree2));
+  *art_int_get(tree2, 0) = -1;
+  assert(!art_int_equal_p(tree, tree2));
+  art_int_set(tree2, tree);
+  assert(art_int_equal_p(tree, tree2));
+  art_int_erase(tree2, 0);
+  assert(!art_int_equal_p(tree, tree2));
+  art_int_swap(tree, tree2);
+  assert(art_int_size(tree2) == art_int_size(tree) + 1);
+  art_int_move(tree, tree2);
+  check_int(tree, ref);
+  art_int_init_move(tree2, tree);
+  check_int(tree2, ref);
+  art_int_it_t it1;
+  art_int_it(it, tree2);
+  art_int_it_set(it1, it);
+  assert(art_int_it_equal_p(it, it1));
+  art_int_next(it1);
+  assert(!art_int_it_equal_p(it, it1));
+  art_int_it_end(it1, tree2);
+  assert(art_int_end_p(it1));
+  assert(!art_int_it_equal_p(it, it1));
+  *art_int_ref(it)->value_ptr = 17;
+  assert(*art_int_get(tree2, 0) == 17);
+
+  art_int_clear(tree2);
+  ref_int_clear(ref);
+}
+
+static void test_u64(void)
+{
+  M_LET(tree, M_ART_OPLIST2(art_u64)) {
+    const uint64_t keys[] = { 0, 1, 255, 256, 65535, 65536, 1ULL << 32,
+                              (1ULL << 32) + 1, 1ULL << 63, UINT64_MAX };
+    for(int i = 9; i >= 0; i--)
+      art_u64_set_at(tree, keys[i], i);
+    int i = 0;
+    for M_EACH(item, tree, M_ART_OPLIST2(art_u64)) {
+      assert(*item->key_ptr == keys[i]);
+      assert(*item->value_ptr == i);
+      i++;
+    }
+    assert(i == 10);
+    /* Prefix iteration over the keys whose 7 higher bytes are 0 */
+    art_u64_it_t it;
+    uint64_t k = 0;
+    art_u64_it_prefix(it, tree, k);
+    assert(*art_u64_cref(it)->key_ptr == 0);
+    art_u64_next(it);
+    assert(art_u64_end_p(it));
+  }
+}
+
+static void test_double(void)
+{
+  M_LET(tree, M_ART_OPLIST2(art_d)) {
+    const double keys[] = { -1e300, -3.7, -0.5, -1e-300, 0.0, 1e-300,
+                            0.25, 3.2, 3.7, 1e300 };
+    for(int i = 9; i >= 0; i--)
+      art_d_set_at(tree, keys[i], i);
+    assert(art_d_size(tree) == 10);
+    int i = 0;
+    for M_EACH(item, tree, M_ART_OPLIST2(art_d)) {
+      assert(*item->key_ptr == keys[i]);
+      assert(*item->value_ptr == i);
+      i++;
+    }
+    assert(i == 10);
+    assert(*art_d_get(tree, 3.2) == 7);
+    assert(art_d_get(tree, 3.3) == NULL);
+    /* -0.0 is the same key as 0.0 */
+    assert(*art_d_get(tree, -0.0) == 4);
+    art_d_set_at(tree, -0.0, 11);
+    assert(art_d_size(tree) == 10);
+    assert(*art_d_get(tree, 0.0) == 11);
+  }
+}
+
+static void test_string(void)
+{
+  M_LET(key, STRING_OPLIST)
+  M_LET(tree, art_str_t)
+  M_LET(ref, BPTREE_OPLIST2(ref_str, STRING_OPLIST, M_BASIC_OPLIST)) {
+    /* Keys with long common paths */
+    for(int i = 0; i < 5000; i++) {
+      int n = rand() % 1000;
+      string_printf(key, "http://www.example.com/path/to/%d/%s", n % 10,
+                    n % 3 ? "index.html" : "");
+      string_cat_printf(key, "%d", n);
+      if (rand() % 4 != 0) {
+        art_str_set_at(tree, key, i);
+        ref_str_set_at(ref, key, i);
+      } else {
+        assert(art_str_erase(tree, key) == ref_str_erase(ref, key));
+      }
+    }
+    check_str(tree, ref);
+
+    /* Lower bound */
+    art_str_it_t it;
+    ref_str_it_t it2;
+    const char *const bounds[] = { "", "a", "http://", "http://www.example.com/path/to/4/",
+                                   "http://www.example.com/path/to/4/index.html5",
+                                   "http://www.example.com/path/to/9/z", "z" };
+    for(size_t i = 0; i < sizeof bounds / sizeof bounds[0]; i++) {
+      string_set_str(key, bounds[i]);
+      art_str_it_from(it, tree, key);
+      ref_str_it_from(it2, ref, key);
+      while (!ref_str_end_p(it2)) {
+        assert(!art_str_end_p(it));
+        assert(string_equal_p(*art_str_cref(it)->key_ptr, *ref_str_cref(it2)->key_ptr));
+        art_str_next(it);
+        ref_str_next(it2);
+      }
+      assert(art_str_end_p(it));
+    }
+
+    /* Prefix iteration */
+    const char *const prefix[] = { "", "h", "http://www.example.com/path/to/3",
+                                   "http://www.example.com/path/to/3/index.html1",
+                                   "http://www.example.com/path/to/3/4", "http://www.Example", "x" };
+    for(size_t i = 0; i < sizeof prefix / sizeof prefix[0]; i++) {
+      size_t n = 0;
+      string_set_str(key, prefix[i]);
+      for(ref_str_it(it2, ref); !ref_str_end_p(it2); ref_str_next(it2)) {
+        n += string_start_with_string_p(*ref_str_cref(it2)->key_ptr, key);
+      }
+      string_t *last = NULL;
+      for(art_str_it_prefix(it, tree, key); !art_str_end_p(it); art_str_next(it)) {
+        string_t *k = art_str_cref(it)->key_ptr;
+        assert(string_start_with_string_p(*k, key));
+        assert(last == NULL || string_cmp(*last, *k) < 0);
+        last = k;
+        n--;
+      }
+      assert(n == 0);
+    }
+
+    /* Keys which are prefixes of each other build a path deeper than
+       the stack of the iterator */
+    art_str_reset(tree);
+    ref_str_reset(ref);
+    string_reset(key);
+    for(int i = 0; i < 200; i++) {
+      art_str_set_at(tree, key, i);
+      ref_str_set_at(ref, key, i);
+      string_push_back(key, (char) ('a' + i % 3));
+      if (i % 5 == 0) {
+        string_t other;
+        string_init_set(other, key);
+        string_push_back(other, 'z');
+        art_str_set_at(tree, other, -i);
+        ref_str_set_at(ref, other, -i);
+        string_clear(other);
+      }
+    }
+    check_str(tree, ref);
+    string_set_str(key, "abcab");
+    art_str_it_prefix(it, tree, key);
+    size_t n = 0;
+    for( ; !art_str_end_p(it); art_str_next(it)) n++;
+    assert(n == art_str_size(tree) - 6);
+    string_set_str(key, "abcabcabcz");
+    art_str_it_from(it, tree, key);
+    ref_str_it_from(it2, ref, key);
+    assert(string_equal_p(*art_str_cref(it)->key_ptr, *ref_str_cref(it2)->key_ptr));
+    /* Removing the keys compresses the path again */
+    string_reset(key);
+    for(int i = 0; i < 200; i++) {
+      if (i % 2 == 0) {
+        assert(art_str_erase(tree, key));
+        ref_str_erase(ref, key);
+      }
+      string_push_back(key, (char) ('a' + i % 3));
+    }
+    check_str(tree, ref);
+    string_set_str(key, "abca");
+    assert(art_str_get(tree, key) == NULL);
+    string_set_str(key, "abc");
+    assert(*art_str_get(tree, key) == 3);
+  }
+}
+
+int main(void)
+{
+  test_int();
+  test_u64();
+  test_double();
+  test_string();
+  exit(0);
+}
@@ -50,6 +50,15 @@ BPTREE_MULTI_DEF2_AS(MultiMapDouble, MultiMapDouble, MultiMapDoubleIt, MultiMapD
 BPTREE_MULTI_DEF_AS(MultiSetDouble, MultiSetDouble, MultiSetDoubleIt, 9, double)
 #define M_OPL_MultiSetDouble() BPTREE_OPLIST(MultiSetDouble, M_BASIC_OPLIST)
 
+/* Same key type, but with a user compare function (no branchless search) */
+static inline int int_cmp(int a, int b) { return a < b ? -1 : a > b; }
+BPTREE_DEF2(btree_cmp, 17, int, M_OPEXTEND(M_BASIC_OPLIST, CMP(int_cmp)), int, M_BASIC_OPLIST)
+
+BPTREE_DEF(btree_actx, 4, int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())))
+
+BPTREE_RANK_DEF2(btree_rank, 3, int, int)
+BPTREE_RANK_DEF(btree_rankset, 4, string_t, STRING_OPLIST)
+
 static void test1(void)
 {
   btree_t b;
@@ -641,6 +650,153 @@ static void test_double(void)
   }
 }
 
+static void test_search_in_node(void)
+{
+  btree_int_t b1;
+  btree_cmp_t b2;
+  btree_int_init(b1);
+  btree_cmp_init(b2);
+  /* Both search methods shall give the same result */
+  unsigned int r = 17;
+  for(int i = 0; i < 10000; i++) {
+    int k = (int) (r % 1000) - 500;
+    r = r * 31421U + 6927U;
+    if (r & 0x1000) {
+      btree_int_set_at(b1, k, i);
+      btree_cmp_set_at(b2, k, i);
+    } else {
+      bool b = btree_int_erase(b1, k);
+      assert (b == btree_cmp_erase(b2, k));
+    }
+    assert (btree_int_size(b1) == btree_cmp_size(b2));
+  }
+  for(int k = -510; k < 510; k++) {
+    int *p1 = btree_int_get(b1, k);
+    int *p2 = btree_cmp_get(b2, k);
+    assert ((p1 == NULL) == (p2 == NULL));
+    if (p1 != NULL) {
+      assert (*p1 == *p2);
+    }
+    btree_int_it_t it1;
+    btree_cmp_it_t it2;
+    btree_int_it_from(it1, b1, k);
+    btree_cmp_it_from(it2, b2, k);
+    assert (btree_int_end_p(it1) == btree_cmp_end_p(it2));
+    if (!btree_int_end_p(it1)) {
+      assert (*btree_int_cref(it1)->key_ptr == *btree_cmp_cref(it2)->key_ptr);
+    }
+  }
+  btree_int_clear(b1);
+  btree_cmp_clear(b2);
+}
+
+static void test_rank(void)
+{
+  btree_rank_t b;
+  bool present[1000] = { false };
+  btree_rank_init(b);
+  btree_rank_it_t it;
+  assert (btree_rank_rank(b, 10) == 0);
+  btree_rank_select(it, b, 0);
+  assert (btree_rank_end_p(it));
+  unsigned int r = 41;
+  for(int i = 0; i < 20000; i++) {
+    int k = (int) (r % 1000);
+    r = r * 31421U + 6927U;
+    if ((r & 0x3000) != 0) {
+      btree_rank_set_at(b, k, 2*k);
+      present[k] = true;
+    } else {
+      assert (btree_rank_erase(b, k) == present[k]);
+      present[k] = false;
+    }
+    if ((i % 1000) != 0) continue;
+    /* Check the order statistics against the reference */
+    size_t rank = 0;
+    for(int j = 0; j < 1000; j++) {
+      assert (btree_rank_rank(b, j) == rank);
+      if (present[j]) {
+        btree_rank_select(it, b, rank);
+        assert (!btree_rank_end_p(it));
+        assert (*btree_rank_cref(it)->key_ptr == j);
+        assert (*btree_rank_cref(it)->value_ptr == 2*j);
+        rank++;
+      }
+    }
+    assert (rank == btree_rank_size(b));
+    btree_rank_select(it, b, rank);
+    assert (btree_rank_end_p(it));
+    size_t count = 0;
+    for(int j = 100; j < 900; j++) count += present[j];
+    assert (btree_rank_count_range(b, 100, 900) == count);
+    assert (btree_rank_count_range(b, 900, 100) == 0);
+  }
+  /* The counts are also copied */
+  btree_rank_t b2;
+  btree_rank_init_set(b2, b);
+  btree_rank_select(it, b2, btree_rank_size(b2) / 2);
+  int k = *btree_rank_cref(it)->key_ptr;
+  assert (btree_rank_rank(b2, k) == btree_rank_size(b2) / 2);
+  /* Iterate from a selected element */
+  size_t n = 0;
+  for( ; !btree_rank_end_p(it); btree_rank_next(it)) n++;
+  assert (n == btree_rank_size(b2) - btree_rank_size(b2) / 2);
+  btree_rank_clear(b2);
+  for(k = 0; k < 1000; k++) {
+    btree_rank_erase(b, k);
+    assert (btree_rank_count_range(b, 0, 1000) == btree_rank_size(b));
+  }
+  assert (btree_rank_empty_p(b));
+  btree_rank_clear(b);
+
+  M_LET(s, key, string_t)
+  M_LET(set, BPTREE_OPLIST(btree_rankset, STRING_OPLIST)) {
+    for(int i = 0; i < 100; i++) {
+      string_printf(s, "%03d", i);
+      btree_rankset_push(set, s);
+    }
+    string_set_str(key, "050");
+    assert (btree_rankset_rank(set, key) == 50);
+    string_set_str(s, "060");
+    assert (btree_rankset_count_range(set, key, s) == 10);
+    btree_rankset_it_t it2;
+    btree_rankset_select(it2, set, 10);
+    assert (string_equal_str_p(*btree_rankset_cref(it2), "010"));
+  }
+}
+
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  btree_actx_t b1, b2, b3;
+  btree_actx_init_allocator(b1, &alloc->interface);
+  btree_actx_init(b2);
+  assert(btree_actx_allocator(b1) == &alloc->interface);
+  assert(btree_actx_allocator(b2) == m_core_allocator_default());
+  assert(alloc->blocks == 1);
+  for(int i = 0; i < 1000; i++)
+    btree_actx_push(b1, i);
+  size_t blocks = alloc->blocks;
+  assert(blocks > 250);
+  assert(alloc->bytes == blocks * sizeof (struct btree_actx_node_s));
+  btree_actx_set(b2, b1);
+  assert(btree_actx_allocator(b2) == m_core_allocator_default());
+  assert(alloc->blocks == blocks);
+  btree_actx_init_set(b3, b1);
+  assert(btree_actx_allocator(b3) == &alloc->interface);
+  assert(alloc->blocks > blocks);
+  for(int i = 0; i < 1000; i += 2)
+    btree_actx_erase(b1, i);
+  assert(alloc->blocks < 2 * blocks);
+  btree_actx_swap(b1, b2);
+  assert(btree_actx_allocator(b1) == m_core_allocator_default());
+  btree_actx_move(b3, b2);
+  btree_actx_clear(b3);
+  btree_actx_clear(b1);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
 int main(void)
 {
   test1();
@@ -654,5 +810,8 @@ int main(void)
   test_multimap();
   test_multiset();
   test_double();
+  test_search_in_node();
+  test_rank();
+  test_allocator();
   exit(0);
 }
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Test the BUFFER_LOCK_FREE policy with its waiting threads parked
+   on a futex. The tests are built in strict ISO mode, where the syscall
+   function is not declared, so that test-mbuffer only covers the fallback
+   on the condition variables. */
+#if defined(__linux__)
+# ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE
+# endif
+# define M_USE_FUTEX 1
+#endif
+
+#include "m-buffer.h"
+
+#include "test-obj.h"
+
+BUFFER_DEF(buffer_lf, unsigned int, 10, BUFFER_QUEUE|BUFFER_LOCK_FREE)
+BUFFER_DEF(buffer_lf1, unsigned int, 1, BUFFER_QUEUE|BUFFER_LOCK_FREE)
+BUFFER_DEF(buffer_lfz, testobj_t, 0, BUFFER_QUEUE|BUFFER_LOCK_FREE|BUFFER_PUSH_INIT_POP_MOVE, TESTOBJ_OPLIST)
+
+#define MAX_TEST_THREAD  32
+#define MAX_COUNT 1024
+
+static unsigned int g_count[MAX_TEST_THREAD][MAX_COUNT];
+static buffer_lf_t g_buff;
+static buffer_lf1_t g_ping, g_pong;
+static buffer_lfz_t g_buffz;
+static atomic_bool g_done;
+
+static void conso(void *arg)
+{
+  unsigned int j;
+  uintptr_t thread_id = (uintptr_t) arg;
+  assert(thread_id < MAX_TEST_THREAD);
+  for(int i = 0; i < MAX_COUNT;i++) {
+    buffer_lf_pop(&j, g_buff);
+    assert (j < MAX_COUNT);
+    g_count[thread_id][j] ++;
+  }
+}
+
+static void prod(void *arg)
+{
+  assert (arg == NULL);
+  for(unsigned int i = 0; i < MAX_COUNT;i++)
+    buffer_lf_push(g_buff, i);
+}
+
+static void test_threads(void)
+{
+  m_thread_t idx_p[MAX_TEST_THREAD];
+  m_thread_t idx_c[MAX_TEST_THREAD];
+
+  memset(g_count, 0, sizeof g_count);
+  buffer_lf_init(g_buff, 10);
+  // Most of the threads are parked on the futex as the buffer is small
+  for(int i = 0; i < MAX_TEST_THREAD; i++) {
+    m_thread_create (idx_c[i], conso, (void*)(uintptr_t) i);
+    m_thread_create (idx_p[i], prod, NULL);
+  }
+  for(int i = 0; i < MAX_TEST_THREAD;i++) {
+    m_thread_join(idx_p[i]);
+    m_thread_join(idx_c[i]);
+  }
+  for(int i = 1 ; i < MAX_TEST_THREAD; i++) {
+    for(int j = 0 ; j < MAX_COUNT; j++) {
+      g_count[0][j] += g_count[i][j];
+    }
+  }
+  for(int j = 0 ; j < MAX_COUNT; j++) {
+    assert(g_count[0][j] == MAX_TEST_THREAD);
+  }
+  assert (buffer_lf_empty_p(g_buff));
+  buffer_lf_clear(g_buff);
+}
+
+static void pong(void *arg)
+{
+  unsigned int j;
+  assert (arg == NULL);
+  for(unsigned int i = 0; i < 10*MAX_COUNT;i++) {
+    buffer_lf1_pop(&j, g_ping);
+    assert (j == i);
+    buffer_lf1_push(g_pong, j + 1);
+  }
+}
+
+static void test_ping_pong(void)
+{
+  m_thread_t idx;
+  unsigned int j;
+
+  // Each push wakes up the other thread parked on an empty buffer of size 1
+  buffer_lf1_init(g_ping, 1);
+  buffer_lf1_init(g_pong, 1);
+  m_thread_create (idx, pong, NULL);
+  for(unsigned int i = 0; i < 10*MAX_COUNT;i++) {
+    buffer_lf1_push(g_ping, i);
+    buffer_lf1_pop(&j, g_pong);
+    assert (j == i + 1);
+  }
+  m_thread_join(idx);
+  assert (buffer_lf1_empty_p(g_ping));
+  assert (buffer_lf1_empty_p(g_pong));
+  buffer_lf1_clear(g_ping);
+  buffer_lf1_clear(g_pong);
+}
+
+static void fill(void *arg)
+{
+  testobj_t z;
+  assert (arg == NULL);
+  testobj_init(z);
+  for(unsigned int i = 0; i < 2*MAX_COUNT;i++) {
+    testobj_set_ui(z, i);
+    buffer_lfz_push(g_buffz, z);
+  }
+  testobj_clear(z);
+  atomic_store(&g_done, true);
+}
+
+static void test_reset(void)
+{
+  m_thread_t idx;
+
+  // The producer parked on a full buffer is waken up by reset
+  atomic_init(&g_done, false);
+  buffer_lfz_init(g_buffz, 4);
+  m_thread_create (idx, fill, NULL);
+  while (!atomic_load(&g_done)) {
+    if (buffer_lfz_full_p(g_buffz)) {
+      buffer_lfz_reset(g_buffz);
+    } else {
+      m_thread_yield();
+    }
+  }
+  m_thread_join(idx);
+  assert (buffer_lfz_size(g_buffz) <= 4);
+  buffer_lfz_reset(g_buffz);
+  assert (buffer_lfz_empty_p(g_buffz));
+  buffer_lfz_clear(g_buffz);
+}
+
+int main(void)
+{
+  test_threads();
+  test_ping_pong();
+  test_reset();
+  exit(0);
+}
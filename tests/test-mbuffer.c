@@ -53,6 +53,11 @@ QUEUE_SPSC_DEF_AS(BufferDouble3, BufferDouble3, double, BUFFER_QUEUE)
 #define M_OPL_BufferDouble2() BUFFER_OPLIST(BufferDouble2, M_BASIC_OPLIST)
 #define M_OPL_BufferDouble3() BUFFER_OPLIST(BufferDouble3, M_BASIC_OPLIST)
 
+// Define lock-free buffers
+BUFFER_DEF(buffer_lf, unsigned int, 10, BUFFER_QUEUE|BUFFER_LOCK_FREE)
+BUFFER_DEF(buffer_lfn, unsigned int, 0, BUFFER_QUEUE|BUFFER_UNBLOCKING|BUFFER_LOCK_FREE)
+BUFFER_DEF(buffer_lfz, testobj_t, 0, BUFFER_QUEUE|BUFFER_UNBLOCKING|BUFFER_LOCK_FREE|BUFFER_PUSH_INIT_POP_MOVE, TESTOBJ_OPLIST)
+
 // Define buffer with ENUM oplist (with API_1 usage)
 typedef enum { OK, KO } state_t;
 #define M_OPL_state_t() M_ENUM_OPLIST(state_t, OK)
@@ -192,6 +197,151 @@ static void test_global(void)
   buffer_uint_clear(g_buff);
 }
 
+/********************************************************************************************/
+
+buffer_lf_t g_buff_lf;
+
+static void conso_lf(void *arg)
+{
+  unsigned int j;
+  uintptr_t thread_id = (uintptr_t) arg;
+  assert(thread_id < MAX_TEST_THREAD);
+  for(int i = 0; i < MAX_COUNT;i++) {
+    buffer_lf_pop(&j, g_buff_lf);
+    assert (j < MAX_COUNT);
+    g_count[thread_id][j] ++;
+  }
+}
+
+static void prod_lf(void *arg)
+{
+  assert (arg == NULL);
+  for(unsigned int i = 0; i < MAX_COUNT;i++)
+    buffer_lf_push(g_buff_lf, i);
+}
+
+static void test_global_lf(void)
+{
+  m_thread_t idx_p[MAX_TEST_THREAD];
+  m_thread_t idx_c[MAX_TEST_THREAD];
+
+  memset(g_count, 0, sizeof g_count);
+  buffer_lf_init(g_buff_lf, 10);
+  assert (buffer_lf_capacity(g_buff_lf) == 10);
+  assert (buffer_lf_empty_p(g_buff_lf));
+
+  // Run multiple producer & consummer threads in parallel
+  // (most of them are parked as the buffer is small)
+  for(int i = 0; i < MAX_TEST_THREAD; i++) {
+    m_thread_create (idx_p[i], conso_lf, (void*)(uintptr_t) i);
+    m_thread_create (idx_c[i], prod_lf, NULL);
+  }
+  for(int i = 0; i < MAX_TEST_THREAD;i++) {
+    m_thread_join(idx_p[i]);
+    m_thread_join(idx_c[i]);
+  }
+  for(int i = 1 ; i < MAX_TEST_THREAD; i++) {
+    for(int j = 0 ; j < MAX_COUNT; j++) {
+      g_count[0][j] += g_count[i][j];
+    }
+  }
+  for(int j = 0 ; j < MAX_COUNT; j++) {
+    assert(g_count[0][j] == MAX_TEST_THREAD);
+  }
+  assert (buffer_lf_empty_p(g_buff_lf));
+  assert (buffer_lf_size(g_buff_lf) == 0);
+
+  // Wrap the tickets around the buffer many times
+  unsigned int j;
+  for(unsigned int k = 0; k < 100; k++) {
+    for(unsigned int i = 0; i < 7; i++) {
+      assert (buffer_lf_push_blocking(g_buff_lf, k + i, false));
+    }
+    assert (buffer_lf_size(g_buff_lf) == 7);
+    for(unsigned int i = 0; i < 7; i++) {
+      assert (buffer_lf_pop_blocking(&j, g_buff_lf, false));
+      assert (j == k + i);
+    }
+  }
+  assert (buffer_lf_pop_blocking(&j, g_buff_lf, false) == false);
+  for(unsigned int i = 0; i < 10; i++) {
+    assert (!buffer_lf_full_p(g_buff_lf));
+    buffer_lf_push(g_buff_lf, i);
+  }
+  assert (buffer_lf_full_p(g_buff_lf));
+  assert (buffer_lf_push_blocking(g_buff_lf, 10, false) == false);
+
+  buffer_lf_t b;
+  buffer_lf_init_set(b, g_buff_lf);
+  assert (buffer_lf_full_p(b));
+  for(unsigned int i = 0; i < 10; i++) {
+    buffer_lf_pop(&j, b);
+    assert (j == i);
+  }
+  assert (buffer_lf_empty_p(b));
+  buffer_lf_reset(g_buff_lf);
+  assert (buffer_lf_empty_p(g_buff_lf));
+  buffer_lf_push(g_buff_lf, 42);
+  buffer_lf_set(b, g_buff_lf);
+  assert (buffer_lf_size(b) == 1);
+  buffer_lf_pop(&j, b);
+  assert (j == 42);
+  buffer_lf_clear(b);
+  buffer_lf_clear(g_buff_lf);
+
+  // Full & empty boundaries of the smallest buffers over several laps
+  for(unsigned int n = 1; n <= 2; n++) {
+    buffer_lfn_t s;
+    buffer_lfn_init(s, n);
+    for(unsigned int k = 0; k < 5; k++) {
+      assert (buffer_lfn_empty_p(s));
+      assert (buffer_lfn_pop(&j, s) == false);
+      for(unsigned int i = 0; i < n; i++) {
+        assert (buffer_lfn_push(s, 10*k + i));
+      }
+      assert (buffer_lfn_full_p(s));
+      assert (buffer_lfn_size(s) == n);
+      assert (buffer_lfn_push(s, 100) == false);
+      assert (buffer_lfn_size(s) == n);
+      for(unsigned int i = 0; i < n; i++) {
+        assert (buffer_lfn_pop(&j, s));
+        assert (j == 10*k + i);
+      }
+      assert (buffer_lfn_pop(&j, s) == false);
+      assert (buffer_lfn_push(s, 7));
+      assert (buffer_lfn_pop(&j, s));
+      assert (j == 7);
+    }
+    buffer_lfn_clear(s);
+  }
+
+  // Objects are initialized by push and moved by pop
+  buffer_lfz_t z1, z2;
+  testobj_t z;
+  buffer_lfz_init(z1, 5);
+  testobj_init(z);
+  for(unsigned int i = 0; i < 5; i++) {
+    testobj_set_ui(z, i);
+    assert (buffer_lfz_push(z1, z));
+  }
+  assert (buffer_lfz_push(z1, z) == false);
+  testobj_clear(z);
+  buffer_lfz_init_set(z2, z1);
+  for(unsigned int i = 0; i < 3; i++) {
+    assert (buffer_lfz_pop(&z, z1));
+    assert (testobj_cmp_ui(z, i) == 0);
+    testobj_clear(z);
+  }
+  assert (buffer_lfz_size(z1) == 2);
+  buffer_lfz_reset(z2);
+  assert (buffer_lfz_empty_p(z2));
+  assert (buffer_lfz_pop(&z, z2) == false);
+  buffer_lfz_set(z2, z1);
+  assert (buffer_lfz_size(z2) == 2);
+  buffer_lfz_clear(z1);
+  buffer_lfz_clear(z2);
+}
+
 static void test_stack(void)
 {
   buffer_floats_t buff;
@@ -470,6 +620,153 @@ static void test_queue(size_t n, int cpu_count, unsigned long long ref)
   queue_uint_clear(g_buff2);
 }
 
+#define BULK_SIZE 16
+
+static void conso2_bulk(void *arg)
+{
+  unsigned int tab[BULK_SIZE];
+  size_t *p_n = M_ASSIGN_CAST(size_t *, arg);
+  size_t n = *p_n;
+  unsigned long long s = 0;
+  for(unsigned int i = 0; i < n; i += BULK_SIZE) {
+    unsigned k = 0;
+    while (k != BULK_SIZE) {
+      k += queue_uint_pop_bulk(BULK_SIZE-k, tab+k, g_buff2);
+    }
+    for(k = 0; k < BULK_SIZE; k++)
+      s += tab[k];
+  }
+  while (!queue_ull_push(g_final2, s));
+}
+
+static void prod2_bulk(void *arg)
+{
+  unsigned int tab[BULK_SIZE];
+  size_t *p_n = M_ASSIGN_CAST(size_t *, arg);
+  size_t n = *p_n;
+  size_t r = n;
+  assert (n % BULK_SIZE == 0);
+  for(unsigned int i = 0; i < n; i += BULK_SIZE) {
+    for(unsigned k = 0; k < BULK_SIZE; k++) {
+      tab[k] = (unsigned int) r;
+      r = r * 31421U + 6927U;
+    }
+    unsigned k = 0;
+    while (k != BULK_SIZE) {
+      k += queue_uint_push_bulk(g_buff2, BULK_SIZE-k, tab+k);
+    }
+  }
+}
+
+static void test_queue_bulk(size_t n, int cpu_count, unsigned long long ref)
+{
+  cpu_count = M_MIN(cpu_count, 64);
+  const int prod_count  = cpu_count / 2;
+  const int conso_count = cpu_count - prod_count;
+
+  queue_uint_init(g_buff2, 64*2);
+  queue_ull_init (g_final2, 64*2);
+
+  m_thread_t idx_p[64];
+  m_thread_t idx_c[64];
+  m_thread_t idx_final;
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_create (idx_p[i], prod2_bulk, &n);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_create (idx_c[i], conso2_bulk, &n);
+  }
+  size_t n2 = (size_t) conso_count;
+  m_thread_create(idx_final, final2, &n2);
+
+  for(int i = 0; i < prod_count; i++) {
+    m_thread_join(idx_p[i]);
+  }
+  for(int i = 0; i < conso_count; i++) {
+    m_thread_join(idx_c[i]);
+  }
+  m_thread_join(idx_final);
+
+  // The sum doesn't depend on the order of the elements
+  assert(g_result == ref);
+  
+  queue_ull_clear(g_final2);
+  queue_uint_clear(g_buff2);
+}
+
+static void test_mpmc_bulk(void)
+{
+  queue_uint_t q;
+  unsigned tab[16];
+  unsigned j;
+  bool b;
+
+  queue_uint_init(q, 64);
+  for(unsigned i = 0; i < 16; i++)
+    tab[i] = i * i;
+  j = queue_uint_push_bulk(q, 0, tab);
+  assert(j == 0);
+  for(unsigned i = 0; i < 3; i++) {
+    j = queue_uint_push_bulk(q, 16, tab);
+    assert(j == 16);
+  }
+  b = queue_uint_push(q, 1024);
+  assert(b);
+  assert(queue_uint_size(q) == 49);
+  // Only the free elements are pushed
+  j = queue_uint_push_bulk(q, 16, tab);
+  assert(j == 15);
+  assert(queue_uint_full_p(q));
+  j = queue_uint_push_bulk(q, 16, tab);
+  assert(j == 0);
+
+  for(unsigned i = 0; i < 16; i++)
+    tab[i] = 0;
+  j = queue_uint_pop_bulk(16, tab, q);
+  assert(j == 16);
+  for(unsigned i = 0; i < 16; i++)
+    assert(tab[i] == i * i);
+  // Mix bulk & single operations through the wrapping of the queue
+  for(unsigned i = 0; i < 32; i++) {
+    b = queue_uint_pop(&j, q);
+    assert(b);
+    assert(j == (i % 16) * (i % 16));
+  }
+  b = queue_uint_pop(&j, q);
+  assert(b);
+  assert(j == 1024);
+  j = queue_uint_pop_bulk(16, tab, q);
+  assert(j == 15);
+  for(unsigned i = 0; i < 15; i++)
+    assert(tab[i] == i * i);
+  assert(queue_uint_empty_p(q));
+  j = queue_uint_pop_bulk(16, tab, q);
+  assert(j == 0);
+  queue_uint_clear(q);
+
+  // Bulk operations on objects with a non trivial oplist
+  queue_z_t qz;
+  testobj_t z[8];
+  queue_z_init(qz, 8);
+  for(unsigned i = 0; i < 8; i++) {
+    testobj_init(z[i]);
+    testobj_set_ui(z[i], i + 1);
+  }
+  j = queue_z_push_bulk(qz, 5, M_CONST_CAST(testobj_t, z));
+  assert(j == 5);
+  j = queue_z_push_bulk(qz, 8, M_CONST_CAST(testobj_t, z));
+  assert(j == 3);
+  for(unsigned i = 0; i < 8; i++)
+    testobj_set_ui(z[i], 0);
+  j = queue_z_pop_bulk(8, z, qz);
+  assert(j == 8);
+  for(unsigned i = 0; i < 8; i++)
+    assert(testobj_cmp_ui(z[i], (i % 5) + 1) == 0);
+  for(unsigned i = 0; i < 8; i++)
+    testobj_clear(z[i]);
+  queue_z_clear(qz);
+}
+
 /********************************************************************************************/
 
 static void test_spsc(void)
@@ -639,11 +936,14 @@ int main(void)
 {
   test_uint();
   test_global();
+  test_global_lf();
   test_stack();
   test_stack2();
   test_no_thread();
   test_global_ishared();
   test_queue(1000000, 2, 2148371710223136ULL);
+  test_queue_bulk(100000, 2, 214249840719440ULL);
+  test_mpmc_bulk();
   test_spsc();
   test_double1();
   test_double2();
@@ -0,0 +1,231 @@
+/*
+ * M*LIB - Test for Concurrent B+TREE
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "test-obj.h"
+#include "m-c-bptree.h"
+#include "m-bptree.h"
+#include "m-mutex.h"
+
+C_BPTREE_DEF2(ctree, 5, int, M_BASIC_OPLIST, int, M_BASIC_OPLIST)
+BPTREE_DEF2(rtree, 5, int, M_BASIC_OPLIST, int, M_BASIC_OPLIST)
+
+#define MAX_THREAD 4
+#define MAX_KEY    2000
+
+static m_gc_t gc;
+static ctree_t tree;
+
+/* Compare the concurrent tree with a reference tree */
+static void check_equal(ctree_t c, rtree_t r, m_gc_tid_t id)
+{
+  assert(ctree_size(c) == rtree_size(r));
+  ctree_it_t it;
+  rtree_it_t it2;
+  for(ctree_it(it, c, id), rtree_it(it2, r);
+      !ctree_end_p(it);
+      ctree_next(it), rtree_next(it2)) {
+    assert(!rtree_end_p(it2));
+    const ctree_itref_t *ref = ctree_cref(it);
+    const rtree_itref_t *ref2 = rtree_cref(it2);
+    assert(*ref->key_ptr == *ref2->key_ptr);
+    assert(*ref->value_ptr == *ref2->value_ptr);
+  }
+  assert(rtree_end_p(it2));
+}
+
+static void test_single(void)
+{
+  m_gc_init(gc, 1);
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  ctree_init(tree, gc);
+  rtree_t ref;
+  rtree_init(ref);
+
+  assert(ctree_empty_p(tree));
+  ctree_it_t it;
+  ctree_it(it, tree, id);
+  assert(ctree_end_p(it));
+  ctree_it_from(it, tree, 10, id);
+  assert(ctree_end_p(it));
+  int v = -1;
+  assert(!ctree_get_copy(&v, tree, 10, id));
+  assert(v == -1);
+  assert(!ctree_erase(tree, 10, id));
+
+  for(int i = 0; i < 1000; i++) {
+    int k = rand() % 500 - 250;
+    int r = rand() % 3;
+    if (r != 0) {
+      ctree_set_at(tree, k, i, id);
+      rtree_set_at(ref, k, i);
+    } else {
+      bool b = ctree_erase(tree, k, id);
+      assert(b == rtree_erase(ref, k));
+    }
+    if ((i % 100) == 0) {
+      /* Let the GC reclaim the removed nodes */
+      m_gc_sleep(gc, id);
+      m_gc_awake(gc, id);
+    }
+  }
+  check_equal(tree, ref, id);
+  for(int k = -260; k < 260; k++) {
+    int *p = rtree_get(ref, k);
+    assert(ctree_get_copy(&v, tree, k, id) == (p != NULL));
+    if (p != NULL) assert(v == *p);
+    /* Range iteration */
+    rtree_it_t it2;
+    ctree_it_from(it, tree, k, id);
+    rtree_it_from(it2, ref, k);
+    int n = 0;
+    while (!ctree_it_until_p(it, k+50)) {
+      assert(!rtree_it_until_p(it2, k+50));
+      assert(*ctree_cref(it)->key_ptr == *rtree_cref(it2)->key_ptr);
+      assert(ctree_it_while_p(it, k+49));
+      ctree_next(it);
+      rtree_next(it2);
+      n++;
+    }
+    assert(rtree_it_until_p(it2, k+50));
+  }
+
+  /* Remove everything then fill again */
+  for(int k = -250; k < 250; k++) {
+    ctree_erase(tree, k, id);
+    rtree_erase(ref, k);
+  }
+  assert(ctree_empty_p(tree));
+  check_equal(tree, ref, id);
+  for(int k = 0; k < 300; k++) {
+    ctree_set_at(tree, k, 2*k, id);
+    rtree_set_at(ref, k, 2*k);
+  }
+  /* Make some leaves empty */
+  for(int k = 0; k < 300; k++) {
+    if ((k % 40) < 30) {
+      ctree_erase(tree, k, id);
+      rtree_erase(ref, k);
+    }
+  }
+  check_equal(tree, ref, id);
+
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+  rtree_clear(ref);
+  ctree_clear(tree);
+  m_gc_clear(gc);
+}
+
+/* Each writer owns the keys k such that k % MAX_THREAD == its number.
+   The value associated to a key k is always 2*k. */
+static void writer(void *arg)
+{
+  const int num = *(const int *)arg;
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  for(int n = 0; n < 200; n++) {
+    m_gc_awake(gc, id);
+    for(int k = num; k < MAX_KEY; k += MAX_THREAD) {
+      if (((k / MAX_THREAD + n) % 3) != 0) {
+        ctree_set_at(tree, k, 2*k, id);
+      } else {
+        ctree_erase(tree, k, id);
+      }
+    }
+    m_gc_sleep(gc, id);
+  }
+  /* Final state: all owned keys are present */
+  m_gc_awake(gc, id);
+  for(int k = num; k < MAX_KEY; k += MAX_THREAD) {
+    ctree_set_at(tree, k, 2*k, id);
+  }
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+}
+
+static void reader(void *arg)
+{
+  (void) arg;
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  for(int n = 0; n < 500; n++) {
+    m_gc_awake(gc, id);
+    /* Keys are seen in increasing order with their proper value */
+    int prev = -1;
+    ctree_it_t it;
+    for(ctree_it_from(it, tree, n % MAX_KEY, id); !ctree_end_p(it); ctree_next(it)) {
+      const ctree_itref_t *ref = ctree_cref(it);
+      assert(*ref->key_ptr > prev);
+      assert(*ref->value_ptr == 2 * *ref->key_ptr);
+      prev = *ref->key_ptr;
+    }
+    for(int k = 0; k < MAX_KEY; k += 7) {
+      int v;
+      if (ctree_get_copy(&v, tree, k, id))
+        assert(v == 2*k);
+    }
+    m_gc_sleep(gc, id);
+  }
+  m_gc_detach_thread(gc, id);
+}
+
+static void test_mt(void)
+{
+  m_gc_init(gc, 2*MAX_THREAD+1);
+  ctree_init(tree, gc);
+
+  int num[MAX_THREAD];
+  m_thread_t idw[MAX_THREAD], idr[MAX_THREAD];
+  for(int i = 0; i < MAX_THREAD; i++) {
+    num[i] = i;
+    m_thread_create(idw[i], writer, &num[i]);
+    m_thread_create(idr[i], reader, NULL);
+  }
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_join(idw[i]);
+    m_thread_join(idr[i]);
+  }
+
+  assert(ctree_size(tree) == MAX_KEY);
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  int k = 0;
+  ctree_it_t it;
+  for(ctree_it(it, tree, id); !ctree_end_p(it); ctree_next(it)) {
+    assert(*ctree_cref(it)->key_ptr == k);
+    k++;
+  }
+  assert(k == MAX_KEY);
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+
+  ctree_clear(tree);
+  m_gc_clear(gc);
+}
+
+int main(void)
+{
+  test_single();
+  test_mt();
+  exit(0);
+}
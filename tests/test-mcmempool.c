@@ -199,10 +199,367 @@ static void test2(void)
   m_gc_clear(gc);
 }
 
+static void test_trim(void)
+{
+  m_gc_init (gc, MAX_THREAD);
+  lf_mempool_init(g, gc, 256, MAX_THREAD);
+  m_mempool_stats_t s = lf_mempool_stats(g);
+  assert (s.in_use == 0);
+  assert (s.allocated > 0 && s.allocated == s.peak && s.free == s.allocated);
+  const size_t initial = s.allocated;
+
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  static int *tab[10000];
+  for(int i = 0; i < 10000; i++) {
+    tab[i] = lf_mempool_new(g, id);
+    *tab[i] = i;
+  }
+  s = lf_mempool_stats(g);
+  assert (s.in_use == 10000 * sizeof (int));
+  assert (s.allocated > initial && s.peak == s.allocated);
+  const size_t peak = s.peak;
+  for(int i = 0; i < 10000; i++) {
+    assert (*tab[i] == i);
+    lf_mempool_del(g, tab[i], id);
+  }
+  assert (lf_mempool_stats(g).in_use == 0);
+  /* The deleted nodes are reclaimed on sleep */
+  m_gc_sleep(gc, id);
+  m_gc_awake(gc, id);
+  size_t r = lf_mempool_trim(g, id);
+  assert (r > 0);
+  s = lf_mempool_stats(g);
+  assert (s.allocated == peak - r && s.peak == peak);
+  /* The mempool is still usable */
+  for(int i = 0; i < 10000; i++) {
+    tab[i] = lf_mempool_new(g, id);
+    *tab[i] = i;
+  }
+  for(int i = 0; i < 10000; i++) {
+    assert (*tab[i] == i);
+    lf_mempool_del(g, tab[i], id);
+  }
+  m_gc_sleep(gc, id);
+
+  /* Automatic trim on sleep above the high-water mark.
+     NOTE: The last reclaimed group remains as the dummy node of the queue */
+  lf_mempool_set_trim_threshold(g, sizeof (int));
+  for(int k = 0; k < 3; k++) {
+    m_gc_awake(gc, id);
+    for(int i = 0; i < 10000; i++) {
+      tab[i] = lf_mempool_new(g, id);
+    }
+    for(int i = 0; i < 10000; i++) {
+      lf_mempool_del(g, tab[i], id);
+    }
+    m_gc_sleep(gc, id);
+  }
+  s = lf_mempool_stats(g);
+  assert (s.allocated < s.peak && s.in_use == 0);
+  m_gc_detach_thread(gc, id);
+
+  lf_mempool_clear(g);
+  m_gc_clear (gc);
+}
+
+/* Exchange of VLA objects between the threads (cross-thread free) */
+#define MAX_EXCHANGE 256
+
+static m_vlapool_t g_vla;
+static m_mutex_t   g_vla_lock;
+static void       *g_vla_exchange[MAX_EXCHANGE];
+static int         g_vla_count;
+
+static void *vla_new(m_gc_tid_t id, size_t size)
+{
+  unsigned char *p = (unsigned char *) m_vlapool_new(g_vla, id, size);
+  assert (p != NULL);
+  // The object shall be aligned for any standard type
+  assert (((uintptr_t) p % sizeof (void*)) == 0);
+  assert (size >= sizeof (size_t));
+  memcpy(p, &size, sizeof (size_t));
+  memset(p + sizeof (size_t), (int) (size & 0xFF), size - sizeof (size_t));
+  return p;
+}
+
+static void vla_del(m_gc_tid_t id, void *ptr)
+{
+  unsigned char *p = (unsigned char *) ptr;
+  size_t size;
+  memcpy(&size, p, sizeof (size_t));
+  for(size_t i = sizeof (size_t); i < size; i++) {
+    assert (p[i] == (size & 0xFF));
+  }
+  m_vlapool_del(g_vla, ptr, id);
+}
+
+static void thread_vla(void *arg)
+{
+  unsigned seed = (unsigned) (uintptr_t) arg;
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  for(int n = 0; n < 1000; n ++) {
+    m_gc_awake(gc, id);
+    for(int i = 0; i < 100; i++) {
+      seed = seed * 1103515245U + 12345U;
+      void *p = vla_new(id, sizeof (size_t) + (seed >> 8) % 5000);
+      void *q = NULL;
+      m_mutex_lock(g_vla_lock);
+      if (g_vla_count < MAX_EXCHANGE) {
+        g_vla_exchange[g_vla_count++] = p;
+        p = NULL;
+      }
+      if ((seed & 0x100) != 0 && g_vla_count > 0) {
+        q = g_vla_exchange[--g_vla_count];
+      }
+      m_mutex_unlock(g_vla_lock);
+      if (p != NULL) vla_del(id, p);
+      if (q != NULL) vla_del(id, q);
+    }
+    m_gc_sleep(gc, id);
+  }
+  m_gc_detach_thread(gc, id);
+}
+
+static void test_vla(void)
+{
+  m_gc_init (gc, MAX_THREAD);
+  m_vlapool_init(g_vla, gc);
+  m_mutex_init(g_vla_lock);
+  g_vla_count = 0;
+
+  /* Single thread: the deleted objects are reused after the GC */
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  void *tab[100];
+  for(int i = 0; i < 100; i++) {
+    tab[i] = vla_new(id, 100);
+  }
+  for(int i = 0; i < 100; i++) {
+    vla_del(id, tab[i]);
+  }
+  m_gc_sleep(gc, id);
+  // The last group of deleted objects remains in the queue of the groups
+  // to be reclaimed until another group is pushed in it.
+  m_gc_awake(gc, id);
+  vla_del(id, vla_new(id, 16));
+  m_gc_sleep(gc, id);
+  m_gc_awake(gc, id);
+  // Same size class than 100
+  void *p = vla_new(id, 110);
+  bool found = false;
+  for(int i = 0; i < 100; i++) {
+    found |= (p == tab[i]);
+  }
+  assert (found);
+  vla_del(id, p);
+  /* Big objects and empty objects are supported too */
+  p = vla_new(id, 100000);
+  vla_del(id, p);
+  p = m_vlapool_new(g_vla, id, 0);
+  assert (p != NULL);
+  m_vlapool_del(g_vla, p, id);
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+
+  m_thread_t idx[MAX_THREAD];
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_create(idx[i], thread_vla, (void *) (uintptr_t) (i + 1));
+  }
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_join(idx[i]);
+  }
+  /* Delete the remaining exchanged objects */
+  id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  while (g_vla_count > 0) {
+    vla_del(id, g_vla_exchange[--g_vla_count]);
+  }
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+
+  m_mutex_clear(g_vla_lock);
+  m_vlapool_clear(g_vla);
+  m_gc_clear (gc);
+}
+
+/* A lock free stack (Treiber) whose popped nodes are reclaimed
+   either by the EBR or by the hazard pointers */
+typedef struct node_s {
+  struct node_s *next;
+  int            value;
+} node_t;
+
+M_ATTR_EXTENSION static _Atomic(node_t *) g_stack;
+static atomic_int g_destroyed;
+static m_ebr_t    g_ebr;
+static m_hazard_t g_hazard;
+
+static void node_destroy(void *p)
+{
+  node_t *n = (node_t *) p;
+  assert (n->value >= 0);
+  // Poison the node to detect a use after reclamation
+  n->value = -1;
+  free(n);
+  atomic_fetch_add(&g_destroyed, 1);
+}
+
+static void stack_push(int v)
+{
+  node_t *n = (node_t *) malloc(sizeof *n);
+  assert (n != NULL);
+  n->value = v;
+  n->next = atomic_load(&g_stack);
+  while (!atomic_compare_exchange_weak(&g_stack, &n->next, n)) {}
+}
+
+static node_t *stack_pop_ebr(void)
+{
+  node_t *n = atomic_load(&g_stack);
+  // The node cannot be reclaimed while the thread is awake
+  while (n != NULL && !atomic_compare_exchange_weak(&g_stack, &n, n->next)) {}
+  return n;
+}
+
+static node_t *stack_pop_hazard(m_gc_tid_t id)
+{
+  while (true) {
+    node_t *n = atomic_load(&g_stack);
+    if (n == NULL) return NULL;
+    m_hazard_set(g_hazard, id, 0, n);
+    // Check that the node is still reachable once protected
+    if (n != atomic_load(&g_stack)) continue;
+    node_t *next = n->next;
+    assert (n->value >= 0);
+    if (atomic_compare_exchange_strong(&g_stack, &n, next)) {
+      m_hazard_reset(g_hazard, id, 0);
+      return n;
+    }
+  }
+}
+
+static void thread_ebr(void *arg)
+{
+  (void)arg;
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  for(int n = 0; n < 1000; n ++) {
+    m_gc_awake(gc, id);
+    for(int i = 0; i < 100; i++) {
+      stack_push(i);
+      node_t *p = stack_pop_ebr();
+      if (p != NULL) {
+        assert (p->value >= 0);
+        m_ebr_retire(g_ebr, id, p, node_destroy);
+      }
+    }
+    m_gc_sleep(gc, id);
+  }
+  m_gc_detach_thread(gc, id);
+}
+
+static void test_ebr(void)
+{
+  m_gc_init (gc, MAX_THREAD);
+  m_ebr_init(g_ebr, gc);
+  atomic_init(&g_stack, (node_t *) 0);
+  atomic_init(&g_destroyed, 0);
+
+  /* Single thread: the objects are reclaimed on sleep */
+  m_gc_tid_t id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  for(int i = 0; i < 100; i++) {
+    stack_push(i);
+  }
+  for(int i = 0; i < 50; i++) {
+    m_ebr_retire(g_ebr, id, stack_pop_ebr(), node_destroy);
+  }
+  assert (atomic_load(&g_destroyed) == 0);
+  m_gc_sleep(gc, id);
+  assert (atomic_load(&g_destroyed) == 50);
+  m_gc_detach_thread(gc, id);
+
+  m_thread_t idx[MAX_THREAD];
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_create(idx[i], thread_ebr, NULL);
+  }
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_join(idx[i]);
+  }
+  /* The remaining retired objects are reclaimed on clear */
+  m_ebr_clear(g_ebr);
+  int count = atomic_load(&g_destroyed);
+  while (atomic_load(&g_stack) != NULL) {
+    node_destroy(stack_pop_ebr());
+  }
+  assert (atomic_load(&g_destroyed) == count + 50);
+  assert (atomic_load(&g_destroyed) == 100 + MAX_THREAD * 1000 * 100);
+  /* The GC is still usable without the EBR */
+  id = m_gc_attach_thread(gc);
+  m_gc_awake(gc, id);
+  m_gc_sleep(gc, id);
+  m_gc_detach_thread(gc, id);
+  m_gc_clear (gc);
+}
+
+static void thread_hazard(void *arg)
+{
+  (void)arg;
+  m_gc_tid_t id = m_hazard_attach_thread(g_hazard);
+  for(int i = 0; i < 100000; i++) {
+    stack_push(i);
+    node_t *p = stack_pop_hazard(id);
+    if (p != NULL) {
+      m_hazard_retire(g_hazard, id, p, node_destroy);
+    }
+  }
+  m_hazard_detach_thread(g_hazard, id);
+}
+
+static void test_hazard(void)
+{
+  m_hazard_init(g_hazard, MAX_THREAD, 1);
+  atomic_init(&g_stack, (node_t *) 0);
+  atomic_init(&g_destroyed, 0);
+
+  /* A protected object is not reclaimed */
+  m_gc_tid_t id = m_hazard_attach_thread(g_hazard);
+  stack_push(1);
+  stack_push(2);
+  node_t *p = atomic_load(&g_stack);
+  m_hazard_set(g_hazard, id, 0, p);
+  m_hazard_retire(g_hazard, id, stack_pop_ebr(), node_destroy);
+  m_hazard_retire(g_hazard, id, stack_pop_ebr(), node_destroy);
+  m_hazard_scan(g_hazard, id);
+  assert (atomic_load(&g_destroyed) == 1);
+  assert (p->value == 2);
+  m_hazard_reset(g_hazard, id, 0);
+  m_hazard_scan(g_hazard, id);
+  assert (atomic_load(&g_destroyed) == 2);
+  m_hazard_detach_thread(g_hazard, id);
+
+  m_thread_t idx[MAX_THREAD];
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_create(idx[i], thread_hazard, NULL);
+  }
+  for(int i = 0; i < MAX_THREAD; i++) {
+    m_thread_join(idx[i]);
+  }
+  m_hazard_clear(g_hazard);
+  while (atomic_load(&g_stack) != NULL) {
+    node_destroy(stack_pop_ebr());
+  }
+  assert (atomic_load(&g_destroyed) == 2 + MAX_THREAD * 100000);
+}
+
 int main(void)
 {
   test();
   test2();
+  test_trim();
+  test_vla();
+  test_ebr();
+  test_hazard();
   exit(0);
 }
 
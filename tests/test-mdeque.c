@@ -50,6 +50,8 @@ DEQUE_DEF_AS(DequeDouble, DequeDouble, DequeDoubleIt, double)
 
 ARRAY_DEF(array, int)
 
+DEQUE_DEF(deque_actx, int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())))
+
 static void test_ti1(int n)
 {
   deque_t d;
@@ -532,6 +534,45 @@ static void test_remove(void)
   array_clear(a);
 }
 
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  deque_actx_t d1, d2, d3;
+  deque_actx_init_allocator(d1, &alloc->interface);
+  deque_actx_init(d2);
+  assert(deque_actx_allocator(d1) == &alloc->interface);
+  assert(deque_actx_allocator(d2) == m_core_allocator_default());
+  assert(alloc->blocks == 1);
+  for(int i = 0; i < 1000; i++) {
+    deque_actx_push_back(d1, i);
+    deque_actx_push_front(d1, -i);
+  }
+  assert(alloc->blocks > 2);
+  /* Remove elements in the middle of the nodes (reducing their size) */
+  deque_actx_it_t it;
+  deque_actx_it(it, d1);
+  for(int i = 0; i < 100; i++) {
+    deque_actx_next(it);
+    deque_actx_remove(d1, it);
+  }
+  assert(deque_actx_size(d1) == 1900);
+  size_t blocks = alloc->blocks;
+  deque_actx_init_set(d3, d1);
+  assert(deque_actx_allocator(d3) == &alloc->interface);
+  assert(alloc->blocks == blocks + 1);
+  deque_actx_set(d2, d1);
+  assert(deque_actx_allocator(d2) == m_core_allocator_default());
+  assert(alloc->blocks == blocks + 1);
+  assert(deque_actx_equal_p(d2, d3));
+  deque_actx_swap(d2, d3);
+  assert(deque_actx_allocator(d2) == &alloc->interface);
+  deque_actx_clear(d3);
+  deque_actx_move(d1, d2);
+  deque_actx_clear(d1);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
 int main(void)
 {
   test1();
@@ -548,5 +589,6 @@ int main(void)
   test_backward();
   test_double();
   test_remove();
+  test_allocator();
   exit(0);
 }
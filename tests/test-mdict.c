@@ -55,6 +55,9 @@ DICT_SET_DEF_AS(dictas_setstr, DictStr, DictStrIt, string_t, STRING_OPLIST)
 DICT_OA_DEF2_AS(dictas_oa_bstr, DictOAStr, DictOAStrIt, DictOAStrItRef, string_t, STRING_OPLIST, int, M_BASIC_OPLIST)
 DICT_OASET_DEF_AS(dictas_oa_setstr, DictOASStr, DictOASStrIt, string_t, STRING_OPLIST)
 
+DICT_DEF2(dict_actx, int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())), int, M_BASIC_OPLIST)
+DICT_OA_DEF2(dict_oa_actx, int, M_OPEXTEND(M_BASIC_OPLIST, OOR_EQUAL(oor_equal_p), OOR_SET(oor_set M_IPTR), ALLOCATOR(m_core_allocator_default())), int, M_BASIC_OPLIST)
+
 
 /* Helper structure */
 ARRAY_DEF(array_string, string_t, STRING_OPLIST)
@@ -533,6 +536,77 @@ test_oa_str2(void)
   dict_oa_bstr_clear(dict);
 }
 
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  dict_actx_t d1, d2, d3;
+  dict_actx_init_allocator(d1, &alloc->interface);
+  dict_actx_init(d2);
+  assert(dict_actx_allocator(d1) == &alloc->interface);
+  assert(dict_actx_allocator(d2) == m_core_allocator_default());
+  assert(alloc->blocks == 1);
+  for(int i = 0; i < 100; i++)
+    dict_actx_set_at(d1, i, i*i);
+  /* The table and one node per item */
+  assert(alloc->blocks == 101);
+  dict_actx_init_set(d3, d1);
+  assert(dict_actx_allocator(d3) == &alloc->interface);
+  assert(alloc->blocks == 202);
+  assert(dict_actx_equal_p(d1, d3));
+  dict_actx_set_at(d2, 1000, 1);
+  dict_actx_set(d2, d1);
+  assert(dict_actx_allocator(d2) == m_core_allocator_default());
+  assert(alloc->blocks == 202);
+  assert(dict_actx_equal_p(d1, d2));
+  assert(dict_actx_erase(d1, 10));
+  assert(alloc->blocks == 201);
+  dict_actx_reset(d3);
+  assert(alloc->blocks == 101);
+  dict_actx_set_at(d3, 10, 100);
+  assert(alloc->blocks == 102);
+  dict_actx_swap(d2, d3);
+  assert(dict_actx_allocator(d2) == &alloc->interface);
+  assert(dict_actx_allocator(d3) == m_core_allocator_default());
+  dict_actx_clear(d3);
+  dict_actx_move(d2, d1);
+  dict_actx_clear(d2);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+
+  dict_oa_actx_t o1, o2, o3;
+  dict_oa_actx_init_allocator(o1, &alloc->interface);
+  dict_oa_actx_init(o2);
+  assert(dict_oa_actx_allocator(o1) == &alloc->interface);
+  assert(dict_oa_actx_allocator(o2) == m_core_allocator_default());
+  assert(alloc->blocks == 1);
+  for(int i = 0; i < 1000; i++)
+    dict_oa_actx_set_at(o1, i, i*i);
+  assert(alloc->blocks == 1);
+  assert(alloc->bytes > 1000 * sizeof (dict_oa_actx_pair_ct));
+  for(int i = 0; i < 990; i++)
+    assert(dict_oa_actx_erase(o1, i));
+  dict_oa_actx_init_set(o3, o1);
+  assert(dict_oa_actx_allocator(o3) == &alloc->interface);
+  assert(alloc->blocks == 2);
+  assert(dict_oa_actx_equal_p(o1, o3));
+  dict_oa_actx_set_at(o2, 1000, 1);
+  dict_oa_actx_set(o2, o1);
+  assert(dict_oa_actx_allocator(o2) == m_core_allocator_default());
+  assert(alloc->blocks == 2);
+  assert(dict_oa_actx_equal_p(o1, o2));
+  dict_oa_actx_reset(o1);
+  dict_oa_actx_reset(o3);
+  assert(alloc->blocks == 2);
+  assert(alloc->bytes == 2 * M_D1CT_INITIAL_SIZE * sizeof (dict_oa_actx_pair_ct));
+  dict_oa_actx_swap(o2, o3);
+  assert(dict_oa_actx_allocator(o2) == &alloc->interface);
+  assert(dict_oa_actx_allocator(o3) == m_core_allocator_default());
+  dict_oa_actx_clear(o3);
+  dict_oa_actx_move(o2, o1);
+  dict_oa_actx_clear(o2);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
 int main(void)
 {
   test1();
@@ -544,5 +618,6 @@ int main(void)
   test_it_oa();
   test_oa_str1();
   test_oa_str2();
+  test_allocator();
   exit(0);
 }
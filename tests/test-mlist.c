@@ -48,6 +48,10 @@ LIST_DEF_AS(list_double, ListDouble, ListDoubleIt, double)
 LIST_DUAL_PUSH_DEF_AS(list_doubleDP, ListDoubleDP, ListDoubleDPIt, double)
 #define M_OPL_ListDoubleDP() LIST_OPLIST(list_doubleDP, M_BASIC_OPLIST)
 
+// Lists allocating their nodes through a stateful allocator
+LIST_DEF(list_actx, unsigned int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())))
+LIST_DUAL_PUSH_DEF(list2_actx, testobj_t, M_OPEXTEND(TESTOBJ_OPLIST, ALLOCATOR(m_core_allocator_default())))
+
 ListDouble   g_array1 = LIST_INIT_VALUE();
 ListDoubleDP g_array2 = LIST_DUAL_PUSH_INIT_VALUE();
 
@@ -742,6 +746,62 @@ static void test_let_string(void)
     }
 }
 
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  list_actx_t l1, l2, l3;
+  list_actx_init_allocator(l1, &alloc->interface);
+  list_actx_init(l2);
+  assert(list_actx_allocator(l1) == &alloc->interface);
+  assert(list_actx_allocator(l2) == m_core_allocator_default());
+  for(unsigned i = 0; i < 100; i++)
+    list_actx_push_back(l1, i);
+  assert(alloc->blocks == 100);
+  assert(alloc->bytes == 100 * sizeof (struct list_actx_s));
+  list_actx_init_set(l3, l1);
+  assert(list_actx_allocator(l3) == &alloc->interface);
+  assert(alloc->blocks == 200);
+  assert(list_actx_equal_p(l1, l3));
+  list_actx_push_back(l2, 17);
+  list_actx_set(l2, l1);
+  assert(list_actx_allocator(l2) == m_core_allocator_default());
+  assert(alloc->blocks == 200);
+  list_actx_splice(l1, l3);
+  assert(list_actx_size(l1) == 200 && alloc->blocks == 200);
+  list_actx_pop_back(NULL, l1);
+  assert(alloc->blocks == 199);
+  list_actx_swap(l2, l3);
+  assert(list_actx_allocator(l2) == &alloc->interface);
+  assert(list_actx_allocator(l3) == m_core_allocator_default());
+  list_actx_clear(l3);
+  list_actx_move(l2, l1);
+  list_actx_clear(l2);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+
+  list2_actx_t d1, d2;
+  testobj_t z;
+  testobj_init(z);
+  list2_actx_init_allocator(d1, &alloc->interface);
+  for(unsigned i = 0; i < 10; i++) {
+    testobj_set_ui(z, i);
+    list2_actx_push_back(d1, z);
+    list2_actx_push_front(d1, z);
+  }
+  assert(alloc->blocks == 20);
+  list2_actx_init_set(d2, d1);
+  assert(list2_actx_allocator(d2) == &alloc->interface);
+  assert(alloc->blocks == 40);
+  list2_actx_splice(d1, d2);
+  assert(alloc->blocks == 40 && list2_actx_size(d1) == 40);
+  list2_actx_pop_back(&z, d1);
+  assert(alloc->blocks == 39);
+  list2_actx_clear(d2);
+  list2_actx_clear(d1);
+  testobj_clear(z);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
 int main(void)
 {
   test_uint();
@@ -751,6 +811,7 @@ int main(void)
   test_out_default_oplist();
   test_double();
   test_let_string();
+  test_allocator();
   exit(0);
 }
 
@@ -25,14 +25,22 @@
 #include <stdlib.h>
 
 #include "m-mempool.h"
+#include "m-list.h"
 
 #include "coverage.h"
 START_COVERAGE
 MEMPOOL_DEF(mempool_uint, unsigned int)
+MEMPOOL_SIZED_DEF(mempool_sized)
 END_COVERAGE
 
 MEMPOOL_DEF_AS(MempoolDouble, MempoolDouble, unsigned int)
 
+MEMPOOL_SIZED_DEF_AS(MempoolSized, MempoolSized)
+
+// The sized pool used by the ALLOCATOR method of a container
+mempool_sized_t gpool;
+LIST_DEF(list_sized, unsigned int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(mempool_sized_allocator(gpool))))
+
 static void test(void)
 {
   mempool_uint_t m;
@@ -101,9 +109,243 @@ static void test_double(void)
   MempoolDouble_clear(m);
 }
 
+static void test_trim(void)
+{
+  mempool_uint_t m;
+  mempool_uint_init(m);
+  m_mempool_stats_t s = mempool_uint_stats(m);
+  assert (s.in_use == 0);
+  assert (s.allocated > 0 && s.allocated == s.free && s.allocated == s.peak);
+  const size_t segment_size = s.allocated;
+  assert (mempool_uint_trim(m) == 0);
+
+  static unsigned int *tab[100000];
+  for(unsigned int i = 0; i < 100000; i++) {
+    tab[i] = mempool_uint_alloc(m);
+    *tab[i] = i;
+  }
+  s = mempool_uint_stats(m);
+  assert (s.in_use == 100000 * sizeof (unsigned int));
+  assert (s.allocated >= s.in_use && s.allocated == s.peak);
+  assert (s.free == s.allocated - s.in_use);
+  const size_t peak = s.peak;
+
+  // Free one object every two: no segment is fully free
+  for(unsigned int i = 0; i < 100000; i+=2) {
+    mempool_uint_free(m, tab[i]);
+  }
+  assert (mempool_uint_trim(m) == 0);
+  assert (mempool_uint_stats(m).allocated == peak);
+  for(unsigned int i = 1; i < 100000; i+=2) {
+    assert (*tab[i] == i);
+  }
+
+  // Free the first half: the segments of this half are fully free
+  for(unsigned int i = 1; i < 50000; i+=2) {
+    mempool_uint_free(m, tab[i]);
+  }
+  size_t r = mempool_uint_trim(m);
+  assert (r > 0 && r % segment_size == 0);
+  s = mempool_uint_stats(m);
+  assert (s.allocated == peak - r && s.peak == peak);
+  assert (s.in_use == 25000 * sizeof (unsigned int));
+  for(unsigned int i = 50001; i < 100000; i+=2) {
+    assert (*tab[i] == i);
+  }
+  // The remaining free objects are still usable
+  for(unsigned int i = 0; i < 100000; i+=2) {
+    tab[i] = mempool_uint_alloc(m);
+    *tab[i] = i;
+  }
+  for(unsigned int i = 0; i < 100000; i+=2) {
+    assert (*tab[i] == i);
+  }
+  for(unsigned int i = 50001; i < 100000; i+=2) {
+    assert (*tab[i] == i);
+  }
+  // Free everything: only the current segment remains
+  for(unsigned int i = 0; i < 100000; i+=2) {
+    mempool_uint_free(m, tab[i]);
+  }
+  for(unsigned int i = 50001; i < 100000; i+=2) {
+    mempool_uint_free(m, tab[i]);
+  }
+  mempool_uint_trim(m);
+  s = mempool_uint_stats(m);
+  assert (s.allocated == segment_size && s.in_use == 0);
+  // The pool is still usable after a full trim
+  for(unsigned int i = 0; i < 1000; i++) {
+    tab[i] = mempool_uint_alloc(m);
+    *tab[i] = i;
+  }
+  for(unsigned int i = 0; i < 1000; i++) {
+    assert (*tab[i] == i);
+    mempool_uint_free(m, tab[i]);
+  }
+  mempool_uint_clear(m);
+
+  // Automatic trim above the high-water mark
+  mempool_uint_init(m);
+  mempool_uint_set_trim_threshold(m, 4 * segment_size);
+  for(unsigned int i = 0; i < 100000; i++) {
+    tab[i] = mempool_uint_alloc(m);
+  }
+  for(unsigned int i = 0; i < 100000; i++) {
+    mempool_uint_free(m, tab[i]);
+  }
+  s = mempool_uint_stats(m);
+  assert (s.free <= 8 * segment_size);
+  assert (s.peak > 8 * segment_size);
+  mempool_uint_clear(m);
+}
+
+static void test_sized(void)
+{
+  mempool_sized_t m;
+  mempool_sized_init(m);
+
+  // Allocate objects of all sizes, including the ones not handled by the pool
+  char *tab[2000];
+  for(unsigned int i = 0; i < 2000; i++) {
+    tab[i] = (char *) mempool_sized_alloc(m, i + 1);
+    assert (tab[i] != NULL);
+    assert ( ((uintptr_t) tab[i] % 16) == 0);
+    memset(tab[i], (int) (i & 0xFF), i + 1);
+  }
+  for(unsigned int i = 0; i < 2000; i++) {
+    for(unsigned int j = 0; j <= i; j++) {
+      assert (tab[i][j] == (char) (i & 0xFF));
+    }
+  }
+  for(unsigned int i = 0; i < 2000; i+=2) {
+    mempool_sized_free(m, tab[i], i + 1);
+    tab[i] = NULL;
+  }
+  for(unsigned int i = 1; i < 2000; i+=2) {
+    assert (tab[i][i] == (char) (i & 0xFF));
+  }
+  // Reallocate in the same size class & in another one
+  tab[1] = (char *) mempool_sized_realloc(m, tab[1], 2, 15);
+  assert (tab[1][0] == 1 && tab[1][1] == 1);
+  tab[3] = (char *) mempool_sized_realloc(m, tab[3], 4, 1500);
+  assert (tab[3][0] == 3 && tab[3][3] == 3);
+  tab[3] = (char *) mempool_sized_realloc(m, tab[3], 1500, 300);
+  assert (tab[3][0] == 3 && tab[3][3] == 3);
+  tab[5] = (char *) mempool_sized_realloc(m, tab[5], 6, 0);
+  mempool_sized_free(m, tab[5], 0);
+  tab[5] = NULL;
+  tab[1] = (char *) mempool_sized_realloc(m, tab[1], 15, 2);
+  tab[3] = (char *) mempool_sized_realloc(m, tab[3], 300, 4);
+  for(unsigned int i = 0; i < 2000; i++) {
+    mempool_sized_free(m, tab[i], i + 1);
+  }
+  mempool_sized_free(m, NULL, 10);
+  // Give back the cache & reuse it
+  mempool_sized_flush(m);
+  mempool_sized_flush(m);
+  for(unsigned int i = 0; i < 2000; i++) {
+    tab[i] = (char *) mempool_sized_alloc(m, 24);
+    memset(tab[i], 1, 24);
+  }
+  for(unsigned int i = 0; i < 2000; i++) {
+    mempool_sized_free(m, tab[i], 24);
+  }
+  mempool_sized_clear(m);
+
+  MempoolSized m2, m3;
+  MempoolSized_init(m2);
+  MempoolSized_init(m3);
+  // Both instances of the same definition have their own cache
+  void *p = MempoolSized_alloc(m2, 17);
+  void *q = MempoolSized_alloc(m3, 17);
+  assert (p != q);
+  MempoolSized_free(m2, p, 17);
+  MempoolSized_free(m3, q, 17);
+  assert (MempoolSized_alloc(m3, 17) == q);
+  assert (MempoolSized_alloc(m2, 17) == p);
+  // Emulate another translation unit (with its own list of caches):
+  // the cache of the thread shall be found back through the pool
+  m_m3mpool_sized_cache_ct *cache = m_m3mpool_sized_last;
+  void *list = m_thread_key_get(m_m3mpool_sized_key);
+  m_thread_key_set(m_m3mpool_sized_key, NULL);
+  m_m3mpool_sized_last = NULL;
+  MempoolSized_free(m2, p, 17);
+  assert (m_m3mpool_sized_last == cache);
+  assert (m_thread_key_get(m_m3mpool_sized_key) == NULL);
+  m_thread_key_set(m_m3mpool_sized_key, list);
+  MempoolSized_free(m3, q, 17);
+  MempoolSized_clear(m2);
+  MempoolSized_clear(m3);
+}
+
+static void test_sized_allocator(void)
+{
+  mempool_sized_init(gpool);
+  list_sized_t l1, l2;
+  list_sized_init(l1);
+  for(unsigned int i = 0; i < 1000; i++) {
+    list_sized_push_back(l1, i);
+  }
+  list_sized_init_set(l2, l1);
+  assert (list_sized_equal_p(l1, l2));
+  assert (list_sized_allocator(l1) == mempool_sized_allocator(gpool));
+  const m_allocator_t *a = mempool_sized_allocator(gpool);
+  void *p = a->allocate(a->state, 100);
+  p = a->reallocate(a->state, p, 100, 200);
+  a->deallocate(a->state, p, 200);
+  list_sized_clear(l1);
+  list_sized_clear(l2);
+  mempool_sized_clear(gpool);
+}
+
+#define NUM_THREAD 4
+MempoolSized gspool;
+
+static void test_sized_thread_func(void *arg)
+{
+  const bool flush = arg != NULL;
+  void *tab[1000];
+  for(unsigned int k = 0; k < 20; k++) {
+    for(unsigned int i = 0; i < 1000; i++) {
+      const size_t size = 1 + (i * 7 + k) % 600;
+      tab[i] = MempoolSized_alloc(gspool, size);
+      memset(tab[i], (int) i, size);
+    }
+    for(unsigned int i = 0; i < 1000; i++) {
+      const size_t size = 1 + (i * 7 + k) % 600;
+      assert (*(unsigned char *) tab[i] == (unsigned char) i);
+      MempoolSized_free(gspool, tab[i], size);
+    }
+  }
+  // Give back the cache of the thread before its end
+  // (otherwise it is done when the thread terminates)
+  if (flush) {
+    MempoolSized_flush(gspool);
+  }
+}
+
+static void test_sized_thread(void)
+{
+  m_thread_t idx[NUM_THREAD];
+  MempoolSized_init(gspool);
+  for(int i = 0; i < NUM_THREAD; i++) {
+    m_thread_create(idx[i], test_sized_thread_func, (i % 2) ? gspool : NULL);
+  }
+  for(int i = 0; i < NUM_THREAD; i++) {
+    m_thread_join(idx[i]);
+  }
+  // The caches of the terminated threads have been given back to the depot
+  assert (gspool->caches == NULL);
+  MempoolSized_clear(gspool);
+}
+
 int main(void)
 {
   test();
   test_double();
+  test_trim();
+  test_sized();
+  test_sized_allocator();
+  test_sized_thread();
   exit(0);
 }
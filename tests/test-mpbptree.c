@@ -0,0 +1,271 @@
+/*
+ * M*LIB - Test for Persistent B+TREE
+ *
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "test-obj.h"
+#include "m-p-bptree.h"
+#include "m-bptree.h"
+#include "m-string.h"
+#include "m-mutex.h"
+
+P_BPTREE_DEF2(ptree, 5, int, M_BASIC_OPLIST, int, M_BASIC_OPLIST)
+BPTREE_DEF2(rtree, 5, int, M_BASIC_OPLIST, int, M_BASIC_OPLIST)
+
+P_BPTREE_DEF2(pstr, 4, string_t, STRING_OPLIST, string_t, STRING_OPLIST)
+#define M_OPL_pstr_t() P_BPTREE_OPLIST2(pstr, STRING_OPLIST, STRING_OPLIST)
+
+/* Compare the persistent tree with a reference tree */
+static void check_equal(ptree_t p, rtree_t r)
+{
+  assert(ptree_size(p) == rtree_size(r));
+  ptree_it_t it;
+  rtree_it_t it2;
+  for(ptree_it(it, p), rtree_it(it2, r);
+      !ptree_end_p(it);
+      ptree_next(it), rtree_next(it2)) {
+    assert(!rtree_end_p(it2));
+    const ptree_itref_t *ref = ptree_cref(it);
+    const rtree_itref_t *ref2 = rtree_cref(it2);
+    assert(*ref->key_ptr == *ref2->key_ptr);
+    assert(*ref->value_ptr == *ref2->value_ptr);
+  }
+  assert(rtree_end_p(it2));
+}
+
+static void test_basic(void)
+{
+  ptree_t tree;
+  rtree_t ref;
+  ptree_init(tree);
+  rtree_init(ref);
+
+  assert(ptree_empty_p(tree));
+  ptree_it_t it;
+  ptree_it(it, tree);
+  assert(ptree_end_p(it));
+  ptree_it_from(it, tree, 10);
+  assert(ptree_end_p(it));
+  assert(ptree_cget(tree, 10) == NULL);
+  assert(ptree_get(tree, 10) == NULL);
+  assert(!ptree_erase(tree, 10));
+
+  for(int i = 0; i < 5000; i++) {
+    int k = rand() % 500 - 250;
+    int r = rand() % 3;
+    if (r != 0) {
+      ptree_set_at(tree, k, i);
+      rtree_set_at(ref, k, i);
+    } else {
+      bool b = ptree_erase(tree, k);
+      assert(b == rtree_erase(ref, k));
+    }
+  }
+  check_equal(tree, ref);
+  for(int k = -260; k < 260; k++) {
+    int *p = rtree_get(ref, k);
+    const int *q = ptree_cget(tree, k);
+    assert((p == NULL) == (q == NULL));
+    if (p != NULL) assert(*p == *q);
+    /* Range iteration */
+    rtree_it_t it2;
+    ptree_it_from(it, tree, k);
+    rtree_it_from(it2, ref, k);
+    while (!ptree_it_until_p(it, k+50)) {
+      assert(!rtree_it_until_p(it2, k+50));
+      assert(*ptree_cref(it)->key_ptr == *rtree_cref(it2)->key_ptr);
+      assert(ptree_it_while_p(it, k+49));
+      ptree_next(it);
+      rtree_next(it2);
+    }
+    assert(rtree_it_until_p(it2, k+50));
+  }
+
+  /* Sequential filling and removal */
+  ptree_reset(tree);
+  rtree_reset(ref);
+  for(int k = 0; k < 1000; k++) {
+    ptree_set_at(tree, k, k);
+    rtree_set_at(ref, k, k);
+  }
+  check_equal(tree, ref);
+  ptree_it_t it1;
+  ptree_it(it, tree);
+  ptree_it_set(it1, it);
+  assert(ptree_it_equal_p(it, it1));
+  ptree_next(it1);
+  assert(!ptree_it_equal_p(it, it1));
+  ptree_it_end(it1, tree);
+  assert(!ptree_it_equal_p(it, it1));
+  for(int k = 999; k >= 0; k -= 2) {
+    assert(ptree_erase(tree, k));
+    rtree_erase(ref, k);
+  }
+  check_equal(tree, ref);
+  for(int k = 0; k < 1000; k += 2) {
+    assert(ptree_erase(tree, k));
+  }
+  assert(ptree_empty_p(tree));
+
+  rtree_clear(ref);
+  ptree_clear(tree);
+}
+
+static void test_snapshot(void)
+{
+  ptree_t tree, snap[10];
+  rtree_t ref, rsnap[10];
+  ptree_init(tree);
+  rtree_init(ref);
+
+  for(int i = 0; i < 10; i++) {
+    for(int j = 0; j < 500; j++) {
+      int k = rand() % 1000;
+      if (rand() % 4 != 0) {
+        ptree_set_at(tree, k, i*1000+j);
+        rtree_set_at(ref, k, i*1000+j);
+      } else {
+        ptree_erase(tree, k);
+        rtree_erase(ref, k);
+      }
+    }
+    /* Modify the values in place */
+    for(int k = 0; k < 1000; k += 13) {
+      int *p = ptree_get(tree, k);
+      int *q = rtree_get(ref, k);
+      assert((p == NULL) == (q == NULL));
+      if (p != NULL) { (*p)++; (*q)++; }
+    }
+    ptree_snapshot(snap[i], tree);
+    rtree_init_set(rsnap[i], ref);
+    assert(ptree_equal_p(snap[i], tree));
+  }
+  /* All the snapshots have kept their version */
+  for(int i = 0; i < 10; i++) {
+    check_equal(snap[i], rsnap[i]);
+    if (i > 0) assert(!ptree_equal_p(snap[i], snap[i-1]));
+  }
+  check_equal(tree, ref);
+
+  /* Clearing the snapshots in any order keeps the other versions */
+  for(int i = 0; i < 10; i += 2) {
+    ptree_clear(snap[i]);
+    rtree_clear(rsnap[i]);
+  }
+  ptree_clear(tree);
+  for(int i = 1; i < 10; i += 2) {
+    check_equal(snap[i], rsnap[i]);
+  }
+  /* Writing in a snapshot doesn't modify the others */
+  ptree_set(tree, snap[9]);
+  ptree_erase(snap[9], 0);
+  ptree_set_at(snap[9], 5000, 5000);
+  check_equal(tree, rsnap[9]);
+  ptree_swap(tree, snap[9]);
+  ptree_move(snap[9], tree);
+  ptree_init_move(tree, snap[9]);
+  assert(ptree_cget(tree, 5000) != NULL);
+  ptree_clear(tree);
+  for(int i = 1; i < 10; i += 2) {
+    ptree_clear(snap[i]);
+    rtree_clear(rsnap[i]);
+  }
+  rtree_clear(ref);
+}
+
+static void test_string(void)
+{
+  M_LET(key, value, STRING_OPLIST)
+    M_LET(tree, snap, pstr_t) {
+    for(int i = 0; i < 200; i++) {
+      string_printf(key, "%d", i);
+      string_printf(value, "value %d", i);
+      pstr_set_at(tree, key, value);
+    }
+    pstr_snapshot(snap, tree);
+    for(int i = 0; i < 200; i += 3) {
+      string_printf(key, "%d", i);
+      assert(pstr_erase(tree, key));
+    }
+    string_set_str(key, "43");
+    string_t *p = pstr_get(tree, key);
+    assert(p != NULL);
+    string_set_str(*p, "changed");
+    assert(pstr_size(snap) == 200);
+    assert(string_equal_str_p(*pstr_cget(snap, key), "value 43"));
+    assert(string_equal_str_p(*pstr_cget(tree, key), "changed"));
+    string_set_str(key, "0");
+    assert(pstr_cget(tree, key) == NULL);
+    assert(pstr_cget(snap, key) != NULL);
+    assert(!pstr_equal_p(tree, snap));
+  }
+}
+
+/* A reporting thread reads a snapshot while the main thread modifies the tree */
+static ptree_t snapshot_mt;
+
+static void reader(void *arg)
+{
+  (void) arg;
+  for(int n = 0; n < 20; n++) {
+    int k = 0;
+    ptree_it_t it;
+    for(ptree_it(it, snapshot_mt); !ptree_end_p(it); ptree_next(it)) {
+      const ptree_itref_t *ref = ptree_cref(it);
+      assert(*ref->key_ptr == k);
+      assert(*ref->value_ptr == 2*k);
+      k++;
+    }
+    assert(k == 1000);
+  }
+  ptree_clear(snapshot_mt);
+}
+
+static void test_mt(void)
+{
+  ptree_t tree;
+  ptree_init(tree);
+  for(int k = 0; k < 1000; k++)
+    ptree_set_at(tree, k, 2*k);
+  ptree_snapshot(snapshot_mt, tree);
+  m_thread_t id;
+  m_thread_create(id, reader, NULL);
+  for(int n = 0; n < 20; n++) {
+    for(int k = 0; k < 1000; k++) {
+      if ((k + n) % 3 == 0)
+        ptree_erase(tree, k);
+      else
+        ptree_set_at(tree, k, k);
+    }
+  }
+  m_thread_join(id);
+  ptree_clear(tree);
+}
+
+int main(void)
+{
+  test_basic();
+  test_snapshot();
+  test_string();
+  test_mt();
+  exit(0);
+}
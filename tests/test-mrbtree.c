@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include "test-obj.h"
 #include "m-string.h"
+#include "m-worker.h"
 #include "m-rbtree.h"
 
 static bool uint_in_str(unsigned int *u, FILE *f)
@@ -61,8 +62,13 @@ RBTREE_DEF(rbtree_mpz, testobj_t, TESTOBJ_CMP_OPLIST)
 #define FLOAT_OP RBTREE_OPLIST(rbtree_float)
 
 RBTREE_DEF_AS(TreeDouble, TreeDouble, TreeDoubleIt, double, M_BASIC_OPLIST)
+
+RBTREE_RANK_DEF(rbtree_rank, int)
+RBTREE_DEF(rbtree_int, int)
 #define M_OPL_TreeDouble() RBTREE_OPLIST(TreeDouble, M_BASIC_OPLIST)
 
+RBTREE_DEF(rbtree_actx, int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())))
+
 static void test_uint(void)
 {
   rbtree_uint_t tree, tree2, tree3;
@@ -521,6 +527,272 @@ static void test_z(void)
   rbtree_mpz_clear(v);
 }
 
+static void test_rank(void)
+{
+  rbtree_rank_t t;
+  bool present[1000] = { false };
+  rbtree_rank_init(t);
+  rbtree_rank_it_t it;
+  assert (rbtree_rank_rank(t, 10) == 0);
+  rbtree_rank_select(it, t, 0);
+  assert (rbtree_rank_end_p(it));
+  unsigned int r = 41;
+  for(int i = 0; i < 20000; i++) {
+    int k = (int) (r % 1000);
+    r = r * 31421U + 6927U;
+    if ((r & 0x3000) != 0) {
+      rbtree_rank_push(t, k);
+      present[k] = true;
+    } else {
+      assert (rbtree_rank_pop_at(NULL, t, k) == present[k]);
+      present[k] = false;
+    }
+    if ((i % 1000) != 0) continue;
+    /* Check the order statistics against the reference */
+    size_t rank = 0;
+    for(int j = 0; j < 1000; j++) {
+      assert (rbtree_rank_rank(t, j) == rank);
+      if (present[j]) {
+        rbtree_rank_select(it, t, rank);
+        assert (!rbtree_rank_end_p(it));
+        assert (*rbtree_rank_cref(it) == j);
+        rank++;
+      }
+    }
+    assert (rank == rbtree_rank_size(t));
+    rbtree_rank_select(it, t, rank);
+    assert (rbtree_rank_end_p(it));
+    size_t count = 0;
+    for(int j = 100; j < 900; j++) count += present[j];
+    assert (rbtree_rank_count_range(t, 100, 900) == count);
+    assert (rbtree_rank_count_range(t, 900, 100) == 0);
+  }
+  /* The counts are also copied */
+  rbtree_rank_t t2;
+  rbtree_rank_init_set(t2, t);
+  size_t half = rbtree_rank_size(t2) / 2;
+  rbtree_rank_select(it, t2, half);
+  int k = *rbtree_rank_cref(it);
+  assert (rbtree_rank_rank(t2, k) == half);
+  /* Iterate in both directions from a selected element */
+  rbtree_rank_previous(it);
+  assert (rbtree_rank_rank(t2, *rbtree_rank_cref(it)) == half - 1);
+  rbtree_rank_next(it);
+  size_t n = 0;
+  for( ; !rbtree_rank_end_p(it); rbtree_rank_next(it)) n++;
+  assert (n == rbtree_rank_size(t2) - half);
+  rbtree_rank_clear(t2);
+  for(k = 0; k < 1000; k++) {
+    rbtree_rank_pop_at(NULL, t, k);
+    assert (rbtree_rank_count_range(t, 0, 1000) == rbtree_rank_size(t));
+  }
+  assert (rbtree_rank_empty_p(t));
+  rbtree_rank_clear(t);
+}
+
+/* Check the Red/Black properties of a sub-tree and return its black height */
+static unsigned int check_rank_node(const struct rbtree_rank_node_s *n, size_t *count)
+{
+  if (n == NULL) {
+    *count = 0;
+    return 0;
+  }
+  size_t c0, c1;
+  unsigned int h0 = check_rank_node(n->child[0], &c0);
+  unsigned int h1 = check_rank_node(n->child[1], &c1);
+  assert (h0 == h1);
+  if (n->color == M_RBTR33_RED) {
+    assert (n->child[0] == NULL || n->child[0]->color == M_RBTR33_BLACK);
+    assert (n->child[1] == NULL || n->child[1]->color == M_RBTR33_BLACK);
+  }
+  assert (n->count == c0 + c1 + 1);
+  *count = n->count;
+  return h0 + (n->color == M_RBTR33_BLACK);
+}
+
+static void check_rank(const rbtree_rank_t t, const bool present[], int n)
+{
+  size_t count;
+  check_rank_node(t->node, &count);
+  assert (count == rbtree_rank_size(t));
+  rbtree_rank_it_t it;
+  rbtree_rank_it(it, t);
+  for(int k = 0; k < n; k++) {
+    if (present[k]) {
+      assert (!rbtree_rank_end_p(it));
+      assert (*rbtree_rank_cref(it) == k);
+      rbtree_rank_next(it);
+    }
+  }
+  assert (rbtree_rank_end_p(it));
+}
+
+static void fill_rank(rbtree_rank_t t, bool present[], int n, unsigned int *r, unsigned int mask)
+{
+  rbtree_rank_reset(t);
+  for(int k = 0; k < n; k++) {
+    *r = *r * 31421U + 6927U;
+    present[k] = (*r & mask) == 0;
+    if (present[k]) rbtree_rank_push(t, k);
+  }
+}
+
+static void test_bulk(void)
+{
+  enum { N = 20000 };
+  static bool p1[N], p2[N];
+  rbtree_rank_t t1, t2, t3;
+  unsigned int r = 17;
+  rbtree_rank_init(t1);
+  rbtree_rank_init(t2);
+  rbtree_rank_init(t3);
+
+  /* Split & join */
+  fill_rank(t1, p1, N, &r, 0x100);
+  for(int key = -1; key <= N; key += 997) {
+    size_t size = rbtree_rank_size(t1);
+    size_t rank = rbtree_rank_rank(t1, key);
+    rbtree_rank_split(t1, key, t2, t3);
+    assert (rbtree_rank_empty_p(t1));
+    assert (rbtree_rank_size(t2) == rank);
+    assert (rbtree_rank_size(t3) == size - rank);
+    assert (rank == 0 || *rbtree_rank_max(t2) < key);
+    assert (rank == size || *rbtree_rank_min(t3) >= key);
+    if (key >= 0 && key < N && !p1[key]) {
+      /* Join back with a new element */
+      rbtree_rank_join(t2, key, t3);
+      p1[key] = true;
+      assert (rbtree_rank_empty_p(t3));
+      rbtree_rank_move(t1, t2);
+      rbtree_rank_init(t2);
+    } else {
+      rbtree_rank_swap(t1, t3);
+      rbtree_rank_union(t1, t2);
+    }
+    check_rank(t1, p1, N);
+  }
+  /* Split without order statistics */
+  rbtree_int_t i1, i2, i3;
+  rbtree_int_init(i1);
+  rbtree_int_init(i2);
+  rbtree_int_init(i3);
+  for(int k = 0; k < 1000; k += 3)
+    rbtree_int_push(i1, k);
+  rbtree_int_split(i1, 900, i2, i3);
+  assert (rbtree_int_size(i2) == 300 && rbtree_int_size(i3) == 34);
+  rbtree_int_split(i3, 1000, i1, i2);
+  assert (rbtree_int_size(i1) == 34 && rbtree_int_empty_p(i2));
+  rbtree_int_clear(i1);
+  rbtree_int_clear(i2);
+  rbtree_int_clear(i3);
+
+  /* Union, intersection and difference with various densities */
+  m_worker_t workers;
+  m_worker_init(workers, 0, 0, NULL, NULL);
+  for(int i = 0; i < 24; i++) {
+    const unsigned int m1 = (i % 3 == 0) ? 0x1 : (i % 3 == 1) ? 0x3000 : 0x700;
+    const unsigned int m2 = (i % 4 == 0) ? 0x700 : (i % 4 == 1) ? 0x1 : 0x3000;
+    const bool parallel = (i >= 12);
+    int op = i % 3;
+    fill_rank(t1, p1, N, &r, m1);
+    fill_rank(t2, p2, N, &r, m2);
+    if (op == 0) {
+      if (parallel) rbtree_rank_parallel_union(t1, t2, workers);
+      else rbtree_rank_union(t1, t2);
+      for(int k = 0; k < N; k++) p1[k] = p1[k] || p2[k];
+    } else if (op == 1) {
+      if (parallel) rbtree_rank_parallel_intersect(t1, t2, workers);
+      else rbtree_rank_intersect(t1, t2);
+      for(int k = 0; k < N; k++) p1[k] = p1[k] && p2[k];
+    } else {
+      if (parallel) rbtree_rank_parallel_difference(t1, t2, workers);
+      else rbtree_rank_difference(t1, t2);
+      for(int k = 0; k < N; k++) p1[k] = p1[k] && !p2[k];
+    }
+    assert (rbtree_rank_empty_p(t2));
+    check_rank(t1, p1, N);
+  }
+  m_worker_clear(workers);
+
+  /* The nodes are moved and the elements properly cleared */
+  rbtree_mpz_t z1, z2;
+  testobj_t z;
+  rbtree_mpz_init(z1);
+  rbtree_mpz_init(z2);
+  testobj_init(z);
+  for(unsigned int k = 0; k < 100; k++) {
+    testobj_set_ui(z, k);
+    rbtree_mpz_push(z1, z);
+    testobj_set_ui(z, k + 50);
+    rbtree_mpz_push(z2, z);
+  }
+  rbtree_mpz_union(z1, z2);
+  assert (rbtree_mpz_size(z1) == 150);
+  for(unsigned int k = 25; k < 75; k++) {
+    testobj_set_ui(z, k);
+    rbtree_mpz_push(z2, z);
+  }
+  rbtree_mpz_intersect(z2, z1);
+  assert (rbtree_mpz_size(z2) == 50 && rbtree_mpz_empty_p(z1));
+  testobj_set_ui(z, 30);
+  rbtree_mpz_push(z1, z);
+  testobj_set_ui(z, 200);
+  rbtree_mpz_push(z1, z);
+  rbtree_mpz_difference(z1, z2);
+  assert (rbtree_mpz_size(z1) == 1);
+  testobj_clear(z);
+  rbtree_mpz_clear(z1);
+  rbtree_mpz_clear(z2);
+
+  rbtree_rank_clear(t1);
+  rbtree_rank_clear(t2);
+  rbtree_rank_clear(t3);
+}
+
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  rbtree_actx_t t1, t2, t3;
+  rbtree_actx_init_allocator(t1, &alloc->interface);
+  rbtree_actx_init_allocator(t2, &alloc->interface);
+  rbtree_actx_init(t3);
+  assert(rbtree_actx_allocator(t1) == &alloc->interface);
+  assert(rbtree_actx_allocator(t3) == m_core_allocator_default());
+  for(int i = 0; i < 100; i++) {
+    rbtree_actx_push(t1, i);
+    rbtree_actx_push(t2, 2*i);
+  }
+  assert(alloc->blocks == 200);
+  rbtree_actx_pop_at(NULL, t1, 50);
+  assert(alloc->blocks == 199);
+  /* The common elements are freed */
+  rbtree_actx_union(t1, t2);
+  assert(rbtree_actx_size(t1) == 150 && alloc->blocks == 150);
+  assert(rbtree_actx_empty_p(t2));
+  rbtree_actx_set(t3, t1);
+  assert(rbtree_actx_allocator(t3) == m_core_allocator_default());
+  assert(alloc->blocks == 150);
+  rbtree_actx_t t4;
+  rbtree_actx_init_allocator(t4, &alloc->interface);
+  rbtree_actx_split(t1, 75, t2, t4);
+  assert(alloc->blocks == 150);
+  rbtree_actx_pop_at(NULL, t4, 75);
+  rbtree_actx_join(t2, 75, t4);
+  assert(rbtree_actx_size(t2) == 150 && alloc->blocks == 150);
+  rbtree_actx_clear(t4);
+  rbtree_actx_init_set(t1, t2);
+  assert(rbtree_actx_allocator(t1) == &alloc->interface);
+  assert(alloc->blocks == 300);
+  rbtree_actx_swap(t1, t3);
+  assert(rbtree_actx_allocator(t3) == &alloc->interface);
+  rbtree_actx_clear(t1);
+  rbtree_actx_move(t1, t2);
+  rbtree_actx_clear(t1);
+  rbtree_actx_clear(t3);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
 int main(void)
 {
   test_uint();
@@ -530,5 +802,8 @@ int main(void)
   test_double();
   test_from();
   test_z();
+  test_rank();
+  test_bulk();
+  test_allocator();
   exit(0);
 }
@@ -22,7 +22,9 @@
 */
 
 #define M_USE_ADDITIONAL_CHECKS 1
+#define M_USE_STRING_ALLOCATOR 1
 #include "m-string.h"
+#include "test-obj.h"
 
 BOUNDED_STRING_DEF(string16, 16)
 
@@ -872,6 +874,45 @@ static void test_parse_standard_c_type(void)
   }
 }
 
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  string_t s1, s2, s3;
+  string_init_allocator(s1, &alloc->interface);
+  string_init(s2);
+  assert(string_allocator(s1) == &alloc->interface);
+  assert(string_allocator(s2) == m_core_allocator_default());
+  /* Short strings don't allocate */
+  string_set_str(s1, "Hello");
+  assert(alloc->blocks == 0);
+  for(int i = 0; i < 100; i++)
+    string_cat_str(s1, " world");
+  assert(alloc->blocks == 1 && alloc->bytes == string_capacity(s1));
+  string_init_set(s3, s1);
+  assert(string_allocator(s3) == &alloc->interface);
+  assert(alloc->blocks == 2);
+  assert(string_equal_p(s1, s3));
+  string_set(s2, s1);
+  assert(string_allocator(s2) == m_core_allocator_default());
+  assert(alloc->blocks == 2);
+  string_reserve(s3, 0);
+  assert(alloc->blocks == 2 && alloc->bytes == string_capacity(s1) + string_capacity(s3));
+  string_swap(s2, s3);
+  assert(string_allocator(s2) == &alloc->interface);
+  assert(string_allocator(s3) == m_core_allocator_default());
+  string_clear(s3);
+  string_set_str(s2, "Hi");
+  string_reserve(s2, 0);
+  assert(alloc->blocks == 1);
+  char *p = string_clear_get_str(s1);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+  assert(strncmp(p, "Hello world", 11) == 0);
+  M_MEMORY_FREE(p);
+  string_clear(s2);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
 int main(void)
 {
   test0();
@@ -883,5 +924,6 @@ int main(void)
   test_bounded1();
   test_bounded_io();
   test_bounded_M_LET();
+  test_allocator();
   exit(0);
 }
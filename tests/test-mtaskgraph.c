@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <assert.h>
+#include "m-taskgraph.h"
+
+/* Each task checks that all its predecessors have been executed
+   in the same run, and records its own execution */
+#define MAX_TASK 10000
+#define MAX_PRED 3
+
+static struct task_s {
+  size_t index;
+  size_t num_pred;
+  size_t pred[MAX_PRED];
+} task[MAX_TASK];
+static atomic_uint done[MAX_TASK];
+static atomic_uint num_exec;
+static unsigned run_id;
+
+static void task_func(void *arg)
+{
+  const struct task_s *t = (const struct task_s *) arg;
+  for(size_t i = 0; i < t->num_pred; i++) {
+    assert (atomic_load(&done[t->pred[i]]) == run_id);
+  }
+  assert (atomic_load(&done[t->index]) + 1 == run_id);
+  atomic_store(&done[t->index], run_id);
+  atomic_fetch_add(&num_exec, 1);
+}
+
+static void check_runs(taskgraph_t g, worker_t w, size_t n, unsigned num_run)
+{
+  for(size_t i = 0; i < n; i++) {
+    atomic_init(&done[i], 0);
+  }
+  for(run_id = 1; run_id <= num_run; run_id++) {
+    atomic_init(&num_exec, 0);
+    taskgraph_run(g, w);
+    assert (atomic_load(&num_exec) == n);
+  }
+}
+
+/* Random DAG: each task depends on up to MAX_PRED previous tasks */
+static void build_random(taskgraph_t g, size_t n)
+{
+  unsigned x = 17;
+  taskgraph_reset(g);
+  for(size_t i = 0; i < n; i++) {
+    task[i].index = i;
+    task[i].num_pred = 0;
+    size_t k = taskgraph_add(g, task_func, &task[i]);
+    assert (k == i);
+    for(size_t j = 0; j < MAX_PRED && i > 0; j++) {
+      x = x * 1103515245U + 12345U;
+      // Mostly local dependencies to get a wide and deep graph
+      size_t p = i - 1 - (x >> 8) % (i < 64 ? i : 64);
+      if ((x >> 4) % 4 == 0) continue;
+      task[i].pred[task[i].num_pred++] = p;
+      taskgraph_add_edge(g, p, i);
+    }
+  }
+  assert (taskgraph_size(g) == n);
+}
+
+/* Chain of tasks */
+static void build_chain(taskgraph_t g, size_t n)
+{
+  taskgraph_reset(g);
+  for(size_t i = 0; i < n; i++) {
+    task[i].index = i;
+    task[i].num_pred = 0;
+    size_t k = taskgraph_add(g, task_func, &task[i]);
+    assert (k == i);
+  }
+  for(size_t i = 1; i < n; i++) {
+    task[i].pred[task[i].num_pred++] = i - 1;
+    taskgraph_add_edge(g, i - 1, i);
+  }
+}
+
+static void test_graph(int num_worker)
+{
+  worker_t w;
+  taskgraph_t g;
+  worker_init(w, num_worker, 0, NULL);
+  taskgraph_init(g);
+
+  // Empty graph
+  taskgraph_run(g, w);
+  assert (taskgraph_size(g) == 0);
+
+  // Diamond with independent tasks
+  for(size_t i = 0; i < 6; i++) {
+    task[i].index = i;
+    task[i].num_pred = 0;
+    taskgraph_add(g, task_func, &task[i]);
+  }
+  taskgraph_add_edge(g, 3, 1);
+  taskgraph_add_edge(g, 3, 2);
+  taskgraph_add_edge(g, 1, 0);
+  taskgraph_add_edge(g, 2, 0);
+  task[1].pred[task[1].num_pred++] = 3;
+  task[2].pred[task[2].num_pred++] = 3;
+  task[0].pred[task[0].num_pred++] = 1;
+  task[0].pred[task[0].num_pred++] = 2;
+  check_runs(g, w, 6, 10);
+  // Add a new edge after a run
+  taskgraph_add_edge(g, 0, 5);
+  task[5].pred[task[5].num_pred++] = 0;
+  check_runs(g, w, 6, 10);
+
+  build_random(g, MAX_TASK);
+  check_runs(g, w, MAX_TASK, 20);
+
+  build_chain(g, MAX_TASK);
+  check_runs(g, w, MAX_TASK, 5);
+
+  taskgraph_clear(g);
+  worker_clear(w);
+}
+
+int main(void)
+{
+  test_graph(0);
+  test_graph(1);
+  test_graph(3);
+  exit(0);
+}
@@ -22,6 +22,7 @@
 */
 #include <stdio.h>
 
+#include "m-worker.h"
 #include "m-tree.h"
 
 #include "test-obj.h"
@@ -37,6 +38,7 @@ START_COVERAGE
 TREE_DEF(tree, int, M_OPEXTEND(M_DEFAULT_OPLIST, GET_STR(M_GET_STRING_INT),PARSE_STR(m_core_parse_sint M_IPTR),IN_STR(m_core_fscan_sint M_IPTR), OUT_STR(M_OUT_STR_INT)))
 END_COVERAGE
 TREE_DEF(tree_mpz, testobj_t, TESTOBJ_OPLIST)
+TREE_DEF(tree_actx, int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())))
 
 #define numberof(x) (int)(sizeof (x) / sizeof((x)[0]))
 
@@ -477,10 +479,190 @@ static void test_io(void)
   tree_clear(t2);
 }
 
+/* Walk the sub-tree of 'ref' in pre-order, storing the values in 'tab' */
+static int walk_subpre(int tab[], tree_it_t ref)
+{
+  int n = 0;
+  for(tree_it_t it = tree_it_subpre(ref); !tree_end_p(it); tree_next_subpre(&it, ref)) {
+    tab[n++] = *tree_cref(it);
+  }
+  return n;
+}
+
+static void test_compact(void)
+{
+  static int before[MAX_NODE_INSERT+1], after[MAX_NODE_INSERT+1];
+  static tree_it_t its[MAX_NODE_INSERT+1];
+  tree_t t, t0;
+  tree_init(t);
+  tree_compact_preorder(t);
+  assert(tree_compact_p(t));
+
+  /* Random tree (with removed nodes) whose nodes are scattered in the array */
+  its[0] = tree_set_root(t, 0);
+  int num = 1;
+  for(int i = 1; i < MAX_NODE_INSERT / 4; i++) {
+    tree_it_t ref = its[rand_get() % (unsigned) num];
+    if (rand_get() % 2 == 0 || tree_root_p(ref)) {
+      its[num++] = tree_insert_child(ref, i);
+    } else {
+      its[num++] = tree_insert_right(ref, i);
+    }
+  }
+  for(int i = 1; i < num; i += 7) {
+    tree_remove(its[i]);
+  }
+  assert(!tree_compact_p(t));
+  tree_init_set(t0, t);
+
+  int n = 0;
+  for(tree_it_t it = tree_it(t); !tree_end_p(it); tree_next(&it)) {
+    before[n++] = *tree_cref(it);
+  }
+  assert(n == (int) tree_size(t));
+
+  tree_compact_preorder(t);
+  assert(tree_compact_p(t));
+  assert(tree_equal_p(t, t0));
+  /* The pre-order walk is the array order */
+  int i = 0;
+  for(tree_it_t it = tree_it(t); !tree_end_p(it); tree_next(&it)) {
+    assert(it.index == i);
+    assert(*tree_cref(it) == before[i]);
+    i++;
+  }
+  assert(i == n);
+
+  /* Walking a sub-tree (or skipping it) gives the same result with both layouts */
+  tree_it_t it0 = tree_it(t0);
+  for(tree_it_t it = tree_it(t); !tree_end_p(it); tree_next(&it), tree_next(&it0)) {
+    if (it.index % 16 != 0) continue;
+    int m = walk_subpre(after, it);
+    assert(m == walk_subpre(before, it0));
+    for(int k = 0; k < m; k++)
+      assert(after[k] == before[k]);
+    tree_it_t s = it, s0 = it0;
+    tree_next_skip(&s);
+    tree_next_skip(&s0);
+    assert(tree_end_p(s) == tree_end_p(s0));
+    if (!tree_end_p(s)) {
+      assert(*tree_cref(s) == *tree_cref(s0));
+      assert(s.index == it.index + m);
+    }
+  }
+
+  /* Any modification goes back to the generic layout */
+  tree_it_t it = tree_it(t);
+  tree_next(&it);
+  tree_insert_child(it, -1);
+  assert(!tree_compact_p(t));
+  assert(!tree_equal_p(t, t0));
+  it = tree_it(t0);
+  tree_next(&it);
+  tree_insert_child(it, -1);
+  assert(tree_equal_p(t, t0));
+  tree_compact_preorder(t0);
+  assert(tree_equal_p(t, t0));
+
+  tree_clear(t);
+  tree_clear(t0);
+}
+
+static void leaf_mod(int *p) { *p %= 17; }
+static void combine_sum(int *p, const int *c) { *p += *c; }
+static void visit_depth(int *p, const int *parent)
+{
+  *p = parent == NULL ? 0 : *parent + 1;
+}
+
+static void test_parallel(void)
+{
+  static tree_it_t its[MAX_NODE_INSERT*4];
+  m_worker_t workers;
+  m_worker_init(workers, 2, 0, NULL, NULL);
+  tree_t t, t0;
+  tree_init(t);
+  tree_parallel_reduce_postorder(t, workers, leaf_mod, combine_sum);
+  tree_parallel_visit_preorder(t, workers, visit_depth);
+  assert(tree_empty_p(t));
+
+  /* Random tree, compacted random tree, wide tree and chain */
+  for(int pass = 0; pass < 4; pass++) {
+    const int n = numberof(its);
+    int sum = 0;
+    its[0] = tree_set_root(t, 0);
+    for(int i = 1; i < n; i++) {
+      if (pass == 2) {
+        its[i] = tree_insert_child(its[0], i);
+      } else if (pass == 3) {
+        its[i] = tree_insert_child(its[i-1], i);
+      } else {
+        its[i] = tree_insert_child(its[rand_get() % (unsigned) i], i);
+      }
+      sum += i % 17;
+    }
+    if (pass == 1) {
+      tree_compact_preorder(t);
+    }
+    tree_init_set(t0, t);
+    tree_reduce_postorder(t0, leaf_mod, combine_sum);
+    tree_parallel_reduce_postorder(t, workers, leaf_mod, combine_sum);
+    assert(*tree_cref(tree_it(t)) == sum);
+    assert(tree_equal_p(t, t0));
+
+    tree_visit_preorder(t0, visit_depth);
+    tree_parallel_visit_preorder(t, workers, visit_depth);
+    assert(tree_equal_p(t, t0));
+    for(tree_it_t it = tree_it(t); !tree_end_p(it); tree_next(&it)) {
+      assert(*tree_cref(it) == tree_depth(it));
+    }
+    tree_reset(t);
+    tree_clear(t0);
+  }
+  tree_clear(t);
+  m_worker_clear(workers);
+}
+
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  tree_actx_t t1, t2, t3;
+  tree_actx_init_allocator(t1, &alloc->interface);
+  tree_actx_init(t2);
+  assert(tree_actx_allocator(t1) == &alloc->interface);
+  assert(tree_actx_allocator(t2) == m_core_allocator_default());
+  tree_actx_it_t it = tree_actx_set_root(t1, 0);
+  for(int i = 1; i < 1000; i++) {
+    tree_actx_it_t c = tree_actx_insert_child(it, i);
+    if (i % 3 == 0) it = c;
+  }
+  assert(alloc->blocks == 1);
+  assert(alloc->bytes == (tree_actx_capacity(t1) + 1) * sizeof (struct tree_actx_node_s));
+  tree_actx_compact_preorder(t1);
+  assert(alloc->blocks == 1);
+  tree_actx_set(t2, t1);
+  assert(tree_actx_allocator(t2) == m_core_allocator_default());
+  assert(alloc->blocks == 1);
+  tree_actx_init_set(t3, t1);
+  assert(tree_actx_allocator(t3) == &alloc->interface);
+  assert(alloc->blocks == 2);
+  assert(tree_actx_equal_p(t2, t3));
+  tree_actx_swap(t2, t3);
+  assert(tree_actx_allocator(t2) == &alloc->interface);
+  tree_actx_clear(t3);
+  tree_actx_move(t1, t2);
+  tree_actx_clear(t1);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
 int main(void)
 {
     test_basic();
     test_gen();
     test_io();
+    test_compact();
+    test_parallel();
+    test_allocator();
     return 0;
 }
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2017-2022, Patrick Pelissier
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * + Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * + Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+
+/* Use small nodes to stress the split & merge of the nodes */
+#define M_USE_ULIST_NODE_SIZE 32
+
+#include "test-obj.h"
+#include "m-string.h"
+#include "m-array.h"
+#include "m-ulist.h"
+#include "m-algo.h"
+
+#include "coverage.h"
+
+START_COVERAGE
+ULIST_DEF(ulist_int, int)
+END_COVERAGE
+#define M_OPL_ulist_int_t() ULIST_OPLIST(ulist_int)
+
+ULIST_DEF(ulist_mpz, testobj_t, TESTOBJ_OPLIST)
+#define M_OPL_ulist_mpz_t() ULIST_OPLIST(ulist_mpz, TESTOBJ_OPLIST)
+
+ULIST_DEF(ulist_string, string_t)
+#define M_OPL_ulist_string_t() ULIST_OPLIST(ulist_string, STRING_OPLIST)
+
+ULIST_DEF(ulist_actx, int, M_OPEXTEND(M_BASIC_OPLIST, ALLOCATOR(m_core_allocator_default())))
+
+/* Reference model: the array is in the order of iteration of the list */
+ARRAY_DEF(array_int, int)
+
+ALGO_DEF(algo_ulist, ulist_int_t)
+
+static void check_equal(const ulist_int_t l, const array_int_t a)
+{
+  assert(ulist_int_size(l) == array_int_size(a));
+  assert(ulist_int_empty_p(l) == (array_int_size(a) == 0));
+  size_t i = 0;
+  ulist_int_it_t it;
+  for(ulist_int_it(it, l); !ulist_int_end_p(it); ulist_int_next(it)) {
+    assert(i < array_int_size(a));
+    assert(*ulist_int_cref(it) == *array_int_cget(a, i));
+    assert(ulist_int_last_p(it) == (i + 1 == array_int_size(a)));
+    i++;
+  }
+  assert(i == array_int_size(a));
+  if (i > 0) {
+    assert(*ulist_int_back(l) == *array_int_cget(a, 0));
+    assert(*ulist_int_front(l) == *array_int_cget(a, i-1));
+  }
+}
+
+static void test_random(void)
+{
+  ulist_int_t l;
+  array_int_t a;
+  ulist_int_init(l);
+  array_int_init(a);
+  ulist_int_it_t it;
+  size_t pos = 0; /* Position of the iterator in the array */
+  ulist_int_it(it, l);
+  for(int n = 0; n < 20000; n++) {
+    int x;
+    switch (rand() % 10) {
+    case 0:
+    case 1:
+      ulist_int_push_back(l, n);
+      array_int_push_at(a, 0, n);
+      ulist_int_it(it, l);
+      pos = 0;
+      break;
+    case 2:
+      ulist_int_push_front(l, n);
+      array_int_push_back(a, n);
+      break;
+    case 3:
+      if (array_int_size(a) > 0) {
+        ulist_int_pop_back(&x, l);
+        assert(x == *array_int_cget(a, 0));
+        array_int_pop_at(NULL, a, 0);
+        ulist_int_it(it, l);
+        pos = 0;
+      }
+      break;
+    case 4:
+      if (array_int_size(a) > 0) {
+        ulist_int_pop_front(&x, l);
+        int y;
+        array_int_pop_back(&y, a);
+        assert(x == y);
+        ulist_int_it(it, l);
+        pos = 0;
+      }
+      break;
+    case 5:
+    case 6:
+      /* Insert after the iterator (at the back if end) */
+      ulist_int_insert(l, it, n);
+      pos = pos == array_int_size(a) ? 0 : pos + 1;
+      array_int_push_at(a, pos, n);
+      assert(*ulist_int_cref(it) == n);
+      break;
+    case 7:
+    case 8:
+      if (pos < array_int_size(a)) {
+        assert(*ulist_int_cref(it) == *array_int_cget(a, pos));
+        ulist_int_remove(l, it);
+        array_int_pop_at(NULL, a, pos);
+        assert(ulist_int_end_p(it) == (pos == array_int_size(a)));
+        if (pos < array_int_size(a))
+          assert(*ulist_int_cref(it) == *array_int_cget(a, pos));
+      }
+      break;
+    default:
+      /* Move forward */
+      for(int k = rand() % 8; k > 0 && !ulist_int_end_p(it); k--) {
+        ulist_int_next(it);
+        pos++;
+      }
+      if (ulist_int_end_p(it)) {
+        ulist_int_it(it, l);
+        pos = 0;
+      }
+      break;
+    }
+    if (n % 128 == 0) {
+      check_equal(l, a);
+    }
+  }
+  check_equal(l, a);
+
+  /* Removal of all the elements through the iterator */
+  while (!ulist_int_empty_p(l)) {
+    ulist_int_it(it, l);
+    for(int k = rand() % 16; k > 0 && !ulist_int_last_p(it); k--)
+      ulist_int_next(it);
+    ulist_int_remove(l, it);
+  }
+  ulist_int_it(it, l);
+  assert(ulist_int_end_p(it));
+  ulist_int_clear(l);
+  array_int_clear(a);
+}
+
+static void test_splice(void)
+{
+  M_LET(l1, l2, l3, ulist_int_t) {
+    for(int i = 0; i < 100; i++) {
+      ulist_int_push_front(l1, i);
+      ulist_int_push_front(l2, 100+i);
+    }
+    ulist_int_splice(l1, l2);
+    assert(ulist_int_empty_p(l2));
+    assert(ulist_int_size(l1) == 200);
+    int i = 0;
+    for M_EACH(x, l1, ulist_int_t) {
+      assert(*x == i++);
+    }
+    ulist_int_splice(l2, l1);
+    assert(ulist_int_size(l2) == 200 && ulist_int_empty_p(l1));
+
+    /* Move the even elements in l1 */
+    ulist_int_it_t it;
+    ulist_int_it(it, l2);
+    while (!ulist_int_end_p(it)) {
+      if (*ulist_int_cref(it) % 2 == 0)
+        ulist_int_splice_back(l1, l2, it);
+      else
+        ulist_int_next(it);
+    }
+    assert(ulist_int_size(l1) == 100 && ulist_int_size(l2) == 100);
+    assert(*ulist_int_back(l1) == 198);
+    ulist_int_reverse(l1);
+    i = 0;
+    for M_EACH(x, l1, ulist_int_t) {
+      assert(*x == i);
+      i += 2;
+    }
+    /* Move back l2 at the end of l1 */
+    ulist_int_it_t it3;
+    ulist_int_it(it, l1);
+    while (!ulist_int_last_p(it)) ulist_int_next(it);
+    ulist_int_it(it3, l2);
+    while (!ulist_int_end_p(it3)) {
+      ulist_int_splice_at(l1, it, l2, it3);
+      assert(*ulist_int_cref(it) % 2 == 1);
+    }
+    assert(ulist_int_empty_p(l2) && ulist_int_size(l1) == 200);
+
+    ulist_int_set(l3, l1);
+    assert(ulist_int_equal_p(l3, l1));
+    ulist_int_pop_front(NULL, l3);
+    assert(!ulist_int_equal_p(l3, l1));
+    ulist_int_swap(l3, l2);
+    assert(ulist_int_size(l2) == 199 && ulist_int_empty_p(l3));
+    ulist_int_move(l3, l2);
+    assert(ulist_int_size(l3) == 199);
+  }
+}
+
+static void test_algo(void)
+{
+  M_LET(l1, l2, ulist_int_t) {
+    for(int i = 0; i < 1000; i++) {
+      ulist_int_push_back(l1, rand() % 500);
+      ulist_int_push_back(l2, rand() % 500);
+    }
+    algo_ulist_sort(l1);
+    algo_ulist_sort(l2);
+    assert(algo_ulist_sort_p(l1));
+    assert(algo_ulist_sort_p(l2));
+    assert(ulist_int_size(l1) == 1000);
+    algo_ulist_uniq(l1);
+    algo_ulist_uniq(l2);
+    size_t s1 = ulist_int_size(l1);
+    algo_ulist_sort_union(l1, l2);
+    assert(algo_ulist_sort_p(l1));
+    assert(ulist_int_size(l1) >= s1);
+    algo_ulist_sort_intersect(l1, l2);
+    assert(ulist_int_equal_p(l1, l2));
+    assert(algo_ulist_count(l1, *ulist_int_back(l1)) == 1);
+  }
+}
+
+static void test_obj(void)
+{
+  ulist_mpz_t l, l2;
+  testobj_t z;
+  ulist_mpz_init(l);
+  testobj_init(z);
+  for(unsigned i = 0; i < 100; i++) {
+    testobj_set_ui(z, i);
+    if (i % 2)
+      ulist_mpz_push_back(l, z);
+    else
+      ulist_mpz_push_front(l, z);
+  }
+  ulist_mpz_init_set(l2, l);
+  assert(ulist_mpz_equal_p(l, l2));
+  ulist_mpz_it_t it;
+  ulist_mpz_it(it, l);
+  while (!ulist_mpz_end_p(it)) {
+    ulist_mpz_insert(l, it, z);
+    ulist_mpz_next(it);
+    if (!ulist_mpz_end_p(it))
+      ulist_mpz_remove(l, it);
+  }
+  ulist_mpz_pop_back(&z, l);
+  testobj_t z2;
+  ulist_mpz_pop_move(&z2, l2);
+  assert(testobj_equal_p(z, z2));
+  testobj_clear(z2);
+  ulist_mpz_emplace_back_ui(l2, 17);
+  ulist_mpz_emplace_front_ui(l2, 18);
+  testobj_clear(z);
+  ulist_mpz_clear(l2);
+  ulist_mpz_clear(l);
+}
+
+static void test_io(void)
+{
+  M_LET(str, string_t)
+    M_LET( (l, ("Hello"), ("%d World", 2), ("!")), l2, ulist_string_t) {
+    ulist_string_get_str(str, l, false);
+    assert(string_equal_str_p(str, "[\"Hello\",\"2 World\",\"!\"]"));
+    const char *end;
+    assert(ulist_string_parse_str(l2, string_get_cstr(str), &end));
+    assert(ulist_string_equal_p(l, l2));
+    FILE *f = m_core_fopen ("a-mulist.dat", "wt");
+    if (!f) abort();
+    ulist_string_out_str(f, l);
+    fclose(f);
+    f = m_core_fopen ("a-mulist.dat", "rt");
+    if (!f) abort();
+    assert(ulist_string_in_str(l2, f));
+    fclose(f);
+    assert(ulist_string_equal_p(l, l2));
+    assert(ulist_string_hash(l) == ulist_string_hash(l2));
+  }
+}
+
+static void test_allocator(void)
+{
+  testalloc_t alloc;
+  testalloc_init(alloc);
+  ulist_actx_t l1, l2;
+  ulist_actx_init_allocator(l1, &alloc->interface);
+  assert(ulist_actx_allocator(l1) == &alloc->interface);
+  for(int i = 0; i < 1000; i++)
+    ulist_actx_push_back(l1, i);
+  assert(alloc->blocks > 0);
+  assert(alloc->bytes == alloc->blocks * sizeof (struct ulist_actx_s));
+  ulist_actx_init_set(l2, l1);
+  assert(ulist_actx_allocator(l2) == &alloc->interface);
+  ulist_actx_splice(l1, l2);
+  assert(ulist_actx_size(l1) == 2000);
+  while (!ulist_actx_empty_p(l1))
+    ulist_actx_pop_front(NULL, l1);
+  assert(alloc->blocks == 0);
+  ulist_actx_push_back(l1, 1);
+  ulist_actx_init_move(l2, l1);
+  ulist_actx_clear(l1);
+  ulist_actx_clear(l2);
+  assert(alloc->blocks == 0 && alloc->bytes == 0);
+}
+
+int main(void)
+{
+  test_random();
+  test_splice();
+  test_algo();
+  test_obj();
+  test_io();
+  test_allocator();
+  exit(0);
+}
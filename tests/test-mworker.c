@@ -20,9 +20,19 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+// Needed for the binding of the workers to the CPU on Linux
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+// Fake topology of the system with 2 NUMA nodes (See test7)
+#define M_USE_WORKER_NODE_CPULIST "a-mworker-node%u.dat"
+// Statistics of the workers (See test10)
+#define M_USE_WORKER_STATS 1
+
 #include <stdio.h>
 #include <assert.h>
 #include "m-worker.h"
+#include "m-string.h"
 
 /* Compute Fibonacci number using thread systems. */
 static worker_t w_g;
@@ -76,6 +86,508 @@ static void test1bis(void)
   assert (atomic_load(&resetFunc_called) == true || m_work3r_get_cpu_count() == 1);
 }
 
+/* Use more workers than CPU so that work orders are stolen between them */
+static void test3(void)
+{
+  atomic_store(&resetFunc_called, false);
+  worker_init(w_g, 4, 0, resetFunc);
+  assert (worker_count(w_g) == 5);
+  int result = fib(30);
+  assert (result == 832040);
+  worker_clear(w_g);
+  assert (atomic_load(&resetFunc_called) == true);
+}
+
+/* Each work order spawns more work orders than the size of a deque
+   before waiting for them */
+#define NUM_LEAF (3 * M_USE_WORKER_DEQUE_SIZE)
+static atomic_int leaf_count;
+static void leaf(void *data)
+{
+  int *p = M_ASSIGN_CAST(int *, data);
+  *p += 1;
+  atomic_fetch_add(&leaf_count, 1);
+}
+static void node(void *data)
+{
+  int *tab = M_ASSIGN_CAST(int *, data);
+  worker_sync_t b;
+  worker_start(b, w_g);
+  for(int i = 0; i < NUM_LEAF; i++) {
+    worker_spawn(b, leaf, &tab[i]);
+  }
+  worker_sync(b);
+  for(int i = 0; i < NUM_LEAF; i++) {
+    assert (tab[i] == 1);
+  }
+}
+
+static void test4(void)
+{
+  static int tab[8][NUM_LEAF];
+  atomic_init(&leaf_count, 0);
+  worker_init(w_g, 3, 2);
+  worker_sync_t b;
+  worker_start(b, w_g);
+  for(int i = 0; i < 8; i++) {
+    worker_spawn(b, node, tab[i]);
+  }
+  worker_sync(b);
+  assert (worker_sync_p(b));
+  assert (atomic_load(&leaf_count) == 8 * NUM_LEAF);
+  worker_flush(w_g);
+  worker_clear(w_g);
+}
+
+/* Recursive parallel quicksort: nested fork / join with deep recursion */
+struct qsort_s {
+  unsigned *tab;
+  size_t n;
+};
+static void qsort_task(void *data)
+{
+  struct qsort_s *q = M_ASSIGN_CAST(struct qsort_s *, data);
+  unsigned *tab = q->tab;
+  size_t n = q->n;
+  if (n < 2) return;
+  // Lomuto partition around the middle element
+  unsigned t = tab[n / 2];
+  tab[n / 2] = tab[n - 1];
+  tab[n - 1] = t;
+  const unsigned pivot = t;
+  size_t p = 0;
+  for(size_t i = 0; i < n - 1; i++) {
+    if (tab[i] < pivot) {
+      t = tab[i];
+      tab[i] = tab[p];
+      tab[p] = t;
+      p++;
+    }
+  }
+  tab[n - 1] = tab[p];
+  tab[p] = pivot;
+  struct qsort_s left = { tab, p };
+  struct qsort_s right = { tab + p + 1, n - p - 1 };
+  worker_sync_t b;
+  worker_start(b, w_g);
+  worker_spawn(b, qsort_task, &left);
+  qsort_task(&right);
+  worker_sync(b);
+}
+
+#define QSORT_SIZE 100000
+static void test5(void)
+{
+  static unsigned tab[QSORT_SIZE];
+  unsigned x = 1;
+  for(size_t i = 0; i < QSORT_SIZE; i++) {
+    x = x * 1103515245U + 12345U;
+    tab[i] = x >> 8;
+  }
+  // Small shared queue: the calling thread has to help the workers
+  worker_init(w_g, 3, 0);
+  struct qsort_s q = { tab, QSORT_SIZE };
+  qsort_task(&q);
+  for(size_t i = 1; i < QSORT_SIZE; i++) {
+    assert (tab[i-1] <= tab[i]);
+  }
+  worker_clear(w_g);
+}
+
+#define PFOR_SIZE 100000
+static unsigned long long pfor_tab[PFOR_SIZE];
+
+static void pfor_square(void *data, size_t begin, size_t end)
+{
+  assert (data == pfor_tab);
+  assert (begin < end && end <= PFOR_SIZE);
+  for(size_t i = begin; i < end; i++) {
+    assert (pfor_tab[i] == 0);
+    pfor_tab[i] = (unsigned long long) i * i;
+  }
+}
+
+static void psum_map(size_t *dest, void *data, size_t begin, size_t end)
+{
+  assert (data == NULL);
+  *dest = 0;
+  for(size_t i = begin; i < end; i++) {
+    *dest += i;
+  }
+}
+
+static void psum_reduce(size_t *dest, size_t const src)
+{
+  *dest += src;
+}
+
+static void pmax_map(unsigned long long *dest, void *data, size_t begin, size_t end)
+{
+  const unsigned long long *tab = (const unsigned long long *) data;
+  *dest = tab[begin];
+  for(size_t i = begin + 1; i < end; i++) {
+    *dest = M_MAX(*dest, tab[i]);
+  }
+}
+
+static void pmax_reduce(unsigned long long *dest, unsigned long long const src)
+{
+  *dest = M_MAX(*dest, src);
+}
+
+WORKER_PARALLEL_REDUCE_DEF(psum, size_t)
+typedef unsigned long long ull_t;
+WORKER_PARALLEL_REDUCE_DEF(pmax, ull_t, M_BASIC_OPLIST)
+
+static void test6(void)
+{
+  worker_init(w_g, 3, 0, NULL);
+  // Each element is executed only once
+  worker_parallel_for(w_g, 0, PFOR_SIZE, 16, pfor_square, pfor_tab);
+  for(size_t i = 0; i < PFOR_SIZE; i++) {
+    assert (pfor_tab[i] == (unsigned long long) i * i);
+  }
+  // Empty range
+  worker_parallel_for(w_g, 10, 10, 0, pfor_square, pfor_tab);
+
+  size_t s = 17;
+  psum(&s, w_g, 0, PFOR_SIZE, 0, psum_map, psum_reduce, NULL);
+  assert (s == (size_t) PFOR_SIZE * (PFOR_SIZE - 1) / 2);
+  psum(&s, w_g, 100, 201, 1, psum_map, psum_reduce, NULL);
+  assert (s == 15150);
+  s = 17;
+  psum(&s, w_g, 5, 5, 0, psum_map, psum_reduce, NULL);
+  assert (s == 17);
+
+  unsigned long long m = 0;
+  pmax(&m, w_g, 0, PFOR_SIZE, 100, pmax_map, pmax_reduce, pfor_tab);
+  assert (m == (unsigned long long) (PFOR_SIZE - 1) * (PFOR_SIZE - 1));
+  worker_clear(w_g);
+}
+
+static atomic_int node_count;
+
+static void node_task(void *arg)
+{
+  const int *node = (const int *) arg;
+  assert (m_worker_current_node(w_g) == *node);
+  atomic_fetch_add(&node_count, 1);
+}
+
+static void any_task(void *arg)
+{
+  (void) arg;
+  atomic_fetch_add(&node_count, 1);
+}
+
+/* Spawn work orders targeting each node & check they are executed
+   by the workers of the node */
+static void check_node(const worker_affinity_t *affinity, int num_worker, unsigned num_node)
+{
+  static int node[2] = { 0, 1 };
+  worker_init(w_g, num_worker, 100, NULL, NULL, affinity);
+  assert (worker_node_count(w_g) == num_node);
+  assert (worker_current_node(w_g) == -1);
+  atomic_init(&node_count, 0);
+  worker_sync_t b;
+  worker_start(b, w_g);
+  for(int i = 0; i < 50; i++) {
+    worker_spawn_node(b, (unsigned) (i % 2), node_task, &node[i % 2]);
+  }
+  // Invalid node: any thread
+  worker_spawn_node(b, 2, any_task, NULL);
+  worker_sync(b);
+  assert (atomic_load(&node_count) == 51);
+  worker_clear(w_g);
+}
+
+static void test7(void)
+{
+  // Write the topology
+  FILE *f = fopen("a-mworker-node0.dat", "wt");
+  assert (f != NULL);
+  fprintf(f, "0-1\n");
+  fclose(f);
+  f = fopen("a-mworker-node1.dat", "wt");
+  assert (f != NULL);
+  fprintf(f, "2-3,5\n");
+  fclose(f);
+
+  worker_affinity_t affinity = { M_WORKER_AFFINITY_NONE, 0, NULL };
+  worker_init(w_g, 2, 0, NULL, NULL, &affinity);
+  assert (worker_node_count(w_g) == 1);
+  worker_clear(w_g);
+
+  // Workers on nodes 0, 0, 1
+  affinity.policy = M_WORKER_AFFINITY_COMPACT;
+  check_node(&affinity, 3, 2);
+  // Workers on nodes 0, 1, 0, 1
+  affinity.policy = M_WORKER_AFFINITY_SCATTER;
+  check_node(&affinity, 4, 2);
+  // Workers on nodes 1, 0, 1
+  static const unsigned cpu[2] = { 5, 1 };
+  affinity.policy = M_WORKER_AFFINITY_CPU_LIST;
+  affinity.num_cpu = 2;
+  affinity.cpu = cpu;
+  check_node(&affinity, 3, 2);
+  // Workers on nodes 0, 0, 1, 1
+  affinity.policy = M_WORKER_AFFINITY_NODE;
+  check_node(&affinity, 4, 2);
+  // Work orders spawned by the workers
+  worker_init(w_g, 4, 0, NULL, NULL, &affinity);
+  int r = fib(25);
+  assert (r == 75025);
+  worker_clear(w_g);
+}
+
+WORKER_FUTURE_DEF(fut, size_t)
+WORKER_FUTURE_DEF(sfut, string_t)
+
+static void fut_compute(size_t *out, void *data)
+{
+  *out = (size_t) (uintptr_t) data;
+}
+
+static void fut_inc(size_t *out, size_t const in, void *data)
+{
+  assert (data == NULL);
+  *out = in + 1;
+}
+
+static void fut_add(size_t *dest, size_t const src)
+{
+  *dest += src;
+}
+
+static void sfut_compute(string_t *out, void *data)
+{
+  string_set_str(*out, (const char *) data);
+}
+
+static void sfut_cat(string_t *out, string_t const in, void *data)
+{
+  string_set(*out, in);
+  string_cat_str(*out, (const char *) data);
+}
+
+static void test8(int num_worker)
+{
+  worker_init(w_g, num_worker, 0, NULL);
+  fut_t f, g, h, tab[100];
+  fut_init(f);
+  fut_init(g);
+  // Pipeline of continuations registered before the value is computed
+  fut_spawn_async(f, w_g, fut_compute, (void *) (uintptr_t) 10);
+  for(int i = 0; i < 1000; i++) {
+    fut_then(f, f, fut_inc, NULL);
+  }
+  assert (*fut_get(f) == 1010);
+  assert (fut_ready_p(f));
+  // Continuation of a ready future
+  fut_then(g, f, fut_inc, NULL);
+  fut_wait(g);
+  assert (*fut_get(g) == 1011);
+
+  // Fan-out & fan-in
+  for(size_t i = 0; i < 100; i++) {
+    fut_init(tab[i]);
+    fut_spawn_async(tab[i], w_g, fut_compute, (void *) (uintptr_t) i);
+    fut_then(tab[i], tab[i], fut_inc, NULL);
+  }
+  fut_when_all(f, 100, tab, fut_add);
+  fut_when_any(g, 100, tab);
+  fut_init_set(h, f);
+  fut_then(h, h, fut_inc, NULL);
+  assert (*fut_get(h) == 5051);
+  assert (*fut_get(f) == 5050);
+  assert (*fut_get(g) >= 1 && *fut_get(g) <= 100);
+  // Only wait for all the sources
+  fut_when_all(g, 100, tab, NULL);
+  assert (*fut_get(g) == 0);
+  fut_set(f, g);
+  assert (f[0] == g[0]);
+  for(size_t i = 0; i < 100; i++) {
+    fut_clear(tab[i]);
+  }
+  fut_clear(f);
+  fut_clear(g);
+  fut_clear(h);
+
+  // Futures of an object: continuations not waited for
+  static char hello[] = "Hello", world[] = " world", bang[] = "!";
+  sfut_t s;
+  sfut_init(s);
+  sfut_spawn_async(s, w_g, sfut_compute, hello);
+  sfut_then(s, s, sfut_cat, world);
+  for(int i = 0; i < 10; i++) {
+    sfut_t t;
+    sfut_init(t);
+    sfut_then(t, s, sfut_cat, bang);
+    sfut_clear(t);
+  }
+  assert (string_equal_str_p(*sfut_get(s), "Hello world"));
+  sfut_clear(s);
+  worker_clear(w_g);
+}
+
+static atomic_int prio_gate, prio_count;
+static int prio_order[8];
+
+static void prio_gate_task(void *arg)
+{
+  (void) arg;
+  atomic_store(&prio_gate, 1);
+  while (atomic_load(&prio_gate) != 2) {
+    m_thread_yield();
+  }
+}
+
+static void prio_task(void *arg)
+{
+  const int id = (int) (intptr_t) arg;
+  prio_order[atomic_fetch_add(&prio_count, 1)] = id;
+  if (id == 6) {
+    // Release the worker blocked by the gate
+    atomic_store(&prio_gate, 2);
+  }
+}
+
+static worker_sync_t prio_block;
+static atomic_bool prio_low_done;
+static atomic_int prio_high_count;
+
+static void prio_low_task(void *arg)
+{
+  (void) arg;
+  atomic_store(&prio_low_done, true);
+}
+
+static void prio_high_task(void *arg)
+{
+  (void) arg;
+  // Endless flow of HIGH priority work orders until the LOW one is done
+  if (!atomic_load(&prio_low_done) && atomic_fetch_add(&prio_high_count, 1) < 1000000) {
+    worker_spawn_priority(prio_block, WORKER_PRIORITY_HIGH, prio_high_task, NULL);
+  }
+}
+
+static void test9(void)
+{
+  worker_init(w_g, 1, 0, NULL);
+  assert (worker_queue_depth(w_g, WORKER_PRIORITY_HIGH) == 0);
+  assert (worker_queue_depth(w_g, WORKER_PRIORITY_NORMAL) == 0);
+  assert (worker_queue_depth(w_g, WORKER_PRIORITY_LOW) == 0);
+  // Block the worker
+  atomic_init(&prio_gate, 0);
+  atomic_init(&prio_count, 0);
+  worker_sync_t b;
+  worker_start(b, w_g);
+  worker_spawn(b, prio_gate_task, NULL);
+  while (atomic_load(&prio_gate) != 1) {
+    m_thread_yield();
+  }
+  worker_spawn_priority(b, WORKER_PRIORITY_LOW, prio_task, (void *) 6);
+  worker_spawn_priority(b, WORKER_PRIORITY_LOW, prio_task, (void *) 7);
+  worker_spawn_priority(b, WORKER_PRIORITY_NORMAL, prio_task, (void *) 5);
+  worker_spawn_priority(b, WORKER_PRIORITY_HIGH, prio_task, (void *) 4);
+  worker_spawn_priority(b, WORKER_PRIORITY_HIGH, prio_task, (void *) 2, 50);
+  worker_spawn_priority(b, WORKER_PRIORITY_HIGH, prio_task, (void *) 1, 10);
+  worker_spawn_priority(b, WORKER_PRIORITY_HIGH, prio_task, (void *) 3, 90);
+  assert (worker_queue_depth(w_g, WORKER_PRIORITY_HIGH) == 4);
+  assert (worker_queue_depth(w_g, WORKER_PRIORITY_NORMAL) == 1);
+  assert (worker_queue_depth(w_g, WORKER_PRIORITY_LOW) == 2);
+  // Only this thread can execute the work orders until the gate is open:
+  // the HIGH ones by deadline, then the NORMAL one, then the LOW ones.
+  worker_sync(b);
+  assert (atomic_load(&prio_count) == 7);
+  for(int i = 0; i < 6; i++) {
+    assert (prio_order[i] == i + 1);
+  }
+  assert (worker_queue_depth(w_g, WORKER_PRIORITY_HIGH) == 0);
+  assert (worker_queue_depth(w_g, WORKER_PRIORITY_LOW) == 0);
+
+  // The LOW priority class is not starved by the HIGH one
+  atomic_init(&prio_low_done, false);
+  atomic_init(&prio_high_count, 0);
+  worker_start(prio_block, w_g);
+  worker_spawn_priority(prio_block, WORKER_PRIORITY_HIGH, prio_high_task, NULL);
+  worker_spawn_priority(prio_block, WORKER_PRIORITY_LOW, prio_low_task, NULL);
+  worker_sync(prio_block);
+  assert (atomic_load(&prio_low_done));
+  assert (atomic_load(&prio_high_count) < 1000000);
+  worker_clear(w_g);
+}
+
+static void check_stats(unsigned long long num_spawn)
+{
+  worker_stats_t s;
+  worker_stats(&s, w_g);
+  assert (s.spawned == s.executed);
+  assert (s.spawned + s.inlined == num_spawn);
+  unsigned long long nq = 0, nr = 0;
+  for(int i = 0; i < M_WORKER_STATS_BUCKETS; i++) {
+    nq += s.queue_wait[i];
+    nr += s.run_time[i];
+  }
+  assert (nq == s.executed && nr == s.executed);
+  unsigned long long executed = 0, stolen = 0;
+  for(size_t i = 0; i < worker_count(w_g); i++) {
+    worker_thread_stats_t t;
+    worker_stats_thread(&t, w_g, i);
+    assert (t.executed == 0 || t.busy > 0);
+    executed += t.executed;
+    stolen += t.stolen;
+  }
+  assert (executed == s.executed && stolen == s.stolen);
+}
+
+static void test10(int num_worker)
+{
+  worker_init(w_g, num_worker, 0, NULL);
+  check_stats(0);
+  // fib(n) spawns fib(n+1)-1 work orders
+  int r = fib(20);
+  assert (r == 6765);
+  check_stats(10946 - 1);
+  worker_clear(w_g);
+}
+
+static atomic_int lookup_count;
+
+/* Emulate a translation unit where the worker context is not set:
+   the worker shall be found back in the table of the pool */
+static void lookup_task(void *arg)
+{
+  (void) arg;
+  m_work3r_thread_ct *self = m_work3r_self;
+  m_work3r_self = NULL;
+  if (self != NULL) {
+    assert (m_worker_current_node(w_g) == (int) self->node);
+    assert (m_work3r_self == self);
+    atomic_fetch_add(&lookup_count, 1);
+  } else {
+    // Executed by the main thread while waiting
+    assert (m_worker_current_node(w_g) == -1);
+  }
+}
+
+static void test11(void)
+{
+  worker_init(w_g, 2, 0, NULL);
+  atomic_init(&lookup_count, 0);
+  for(int n = 0; n < 1000 && atomic_load(&lookup_count) == 0; n++) {
+    worker_sync_t b;
+    worker_start(b, w_g);
+    for(int i = 0; i < 10; i++) {
+      worker_spawn(b, lookup_task, NULL);
+    }
+    worker_sync(b);
+  }
+  assert (atomic_load(&lookup_count) > 0);
+  assert (worker_current_node(w_g) == -1);
+  worker_clear(w_g);
+}
+
 #if defined(__GNUC__) && (!defined(__clang__) || (defined(WORKER_USE_CLANG_BLOCK) && WORKER_USE_CLANG_BLOCK) || (defined(WORKER_USE_CPP_FUNCTION) && WORKER_USE_CPP_FUNCTION))
 
 /* The macro version will generate warnings about shadow variables.
@@ -115,5 +627,16 @@ int main(void)
   test1();
   test1bis();
   test2();
+  test3();
+  test4();
+  test5();
+  test6();
+  test7();
+  test8(0);
+  test8(3);
+  test9();
+  test10(0);
+  test10(3);
+  test11();
   exit(0);
 }
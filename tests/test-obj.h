@@ -196,6 +196,53 @@ static inline void testobj_str(string_t str, const testobj_t z, bool append)
    EMPLACE_TYPE( LIST( (_ui, testobj_init_set_ui, unsigned int), (_str, testobj_init_set_str, const char *), ( /*empty*/, testobj_init_set, testobj_t) ) ) \
    )
 
+/* This is a stateful allocator counting the allocated blocks & bytes
+   (for the containers using the ALLOCATOR method).
+   Used for test purpose only.*/
+typedef struct testalloc_s {
+  m_allocator_t interface;
+  size_t        blocks;
+  size_t        bytes;
+} testalloc_t[1];
+
+static inline void *testalloc_allocate(void *state, size_t size)
+{
+  struct testalloc_s *a = (struct testalloc_s *) state;
+  a->blocks ++;
+  a->bytes += size;
+  return malloc(size);
+}
+
+static inline void *testalloc_reallocate(void *state, void *ptr, size_t old_size, size_t new_size)
+{
+  struct testalloc_s *a = (struct testalloc_s *) state;
+  void *p = realloc(ptr, new_size);
+  if (p == NULL) return NULL;
+  a->blocks += (ptr == NULL);
+  a->bytes += new_size - old_size;
+  return p;
+}
+
+static inline void testalloc_deallocate(void *state, void *ptr, size_t size)
+{
+  struct testalloc_s *a = (struct testalloc_s *) state;
+  if (ptr == NULL) return;
+  assert (a->blocks > 0 && a->bytes >= size);
+  a->blocks --;
+  a->bytes -= size;
+  free(ptr);
+}
+
+static inline void testalloc_init(testalloc_t a)
+{
+  a->interface.allocate   = testalloc_allocate;
+  a->interface.reallocate = testalloc_reallocate;
+  a->interface.deallocate = testalloc_deallocate;
+  a->interface.state      = a;
+  a->blocks = 0;
+  a->bytes  = 0;
+}
+
 M_END_PROTECTED_CODE
 
 #endif